@@ -0,0 +1,983 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#include <time.h>
+#include <sys/time.h>
+#endif /* _WIN32 */
+
+#include "opj_apps_config.h"
+#include "openjpeg.h"
+#include "opj_getopt.h"
+#include "convert.h"
+
+#include "format_defs.h"
+
+/* -------------------------------------------------------------------------- */
+
+/** Benchmark the compression */
+#define BENCH_ENCODE	1
+/** Benchmark the decompression */
+#define BENCH_DECODE	2
+
+/** Names of the stages, indexed by OPJ_PROFILE_STAGE */
+static const char * const stage_names[OPJ_PROFILE_NB_STAGES] = {
+	"t2", "t1", "dwt", "mct", "dc_shift", "io", "rate"
+};
+
+typedef struct bench_parameters {
+	/** input file, empty to generate a synthetic image */
+	char infile[OPJ_PATH_LEN];
+	/** format of the input file */
+	int decod_format;
+	/** file where the JSON report is written, "-" for stdout */
+	char jsonfile[OPJ_PATH_LEN];
+	/** BENCH_ENCODE, BENCH_DECODE or both */
+	int mode;
+	/** J2K_CFMT or JP2_CFMT */
+	int cod_format;
+	/** number of timed runs */
+	int runs;
+	/** number of untimed runs done before the timed ones */
+	int warmup;
+	/** synthetic image: width, height, number of components and precision */
+	OPJ_UINT32 width;
+	OPJ_UINT32 height;
+	OPJ_UINT32 numcomps;
+	OPJ_UINT32 prec;
+	/** synthetic image: signed samples */
+	int sgnd;
+	/** decoder: number of highest resolution levels to discard */
+	OPJ_UINT32 reduce;
+	/** encoder parameters */
+	opj_cparameters_t cparameters;
+} bench_parameters_t;
+
+/** Result of the runs of one operation */
+typedef struct bench_result {
+	/** number of timed runs */
+	int runs;
+	/** wall time of the runs, in seconds */
+	OPJ_FLOAT64 time_min;
+	OPJ_FLOAT64 time_max;
+	OPJ_FLOAT64 time_sum;
+	/** highest memory peak of the codec over the runs */
+	OPJ_SIZE_T mem_peak;
+	/** size of the codestream written or read */
+	OPJ_SIZE_T codestream_size;
+	/** sum of the profiles of the timed runs */
+	opj_profile_stats_t stats;
+} bench_result_t;
+
+/** Growable memory buffer used as the stream of the codecs */
+typedef struct bench_buffer {
+	OPJ_BYTE * data;
+	OPJ_SIZE_T size;
+	OPJ_SIZE_T capacity;
+	OPJ_SIZE_T offset;
+} bench_buffer_t;
+
+/* -------------------------------------------------------------------------- */
+
+static void bench_help_display(void) {
+	fprintf(stdout,"\nThis is the opj_bench utility from the OpenJPEG project.\n"
+	               "It measures the compression and decompression throughput of the library\n"
+	               "on a synthetic or a real image.\n"
+	               "It has been compiled against openjp2 library v%s.\n\n",opj_version());
+
+	fprintf(stdout,"Parameters:\n");
+	fprintf(stdout,"-----------\n");
+	fprintf(stdout,"\n");
+	fprintf(stdout,"  -i <file>\n");
+	fprintf(stdout,"    Input image. Accepts PGX, PNM, BMP, TGA");
+#ifdef OPJ_HAVE_LIBTIFF
+	fprintf(stdout,", TIF");
+#endif
+#ifdef OPJ_HAVE_LIBPNG
+	fprintf(stdout,", PNG");
+#endif
+	fprintf(stdout,",\n");
+	fprintf(stdout,"    J2K and JP2 files. A compressed file is decoded as is by the\n");
+	fprintf(stdout,"    decompression benchmark.\n");
+	fprintf(stdout,"    Default: a synthetic image is generated (see -g).\n");
+	fprintf(stdout,"  -g <width>,<height>[,<components>[,<precision>[,s]]]\n");
+	fprintf(stdout,"    Geometry of the synthetic image, \",s\" for signed samples.\n");
+	fprintf(stdout,"    Default: 2048,2048,3,8\n");
+	fprintf(stdout,"  -m <encode|decode|both>\n");
+	fprintf(stdout,"    Operations to benchmark. Default: both\n");
+	fprintf(stdout,"  -N <runs>\n");
+	fprintf(stdout,"    Number of timed runs of each operation. Default: 5\n");
+	fprintf(stdout,"  -W <runs>\n");
+	fprintf(stdout,"    Number of untimed warmup runs. Default: 1\n");
+	fprintf(stdout,"  -F <j2k|jp2>\n");
+	fprintf(stdout,"    Format of the compressed stream. Default: j2k\n");
+	fprintf(stdout,"  -t <width>,<height>\n");
+	fprintf(stdout,"    Tile size. Default: one tile\n");
+	fprintf(stdout,"  -b <width>,<height>\n");
+	fprintf(stdout,"    Code-block size. Default: 64,64\n");
+	fprintf(stdout,"  -n <number>\n");
+	fprintf(stdout,"    Number of resolutions. Default: 6\n");
+	fprintf(stdout,"  -r <rate>,<rate>,...\n");
+	fprintf(stdout,"    Compression ratio of each quality layer (0 for lossless).\n");
+	fprintf(stdout,"    Default: one lossless layer\n");
+	fprintf(stdout,"  -I\n");
+	fprintf(stdout,"    Use the irreversible 9/7 wavelet instead of the reversible 5/3.\n");
+	fprintf(stdout,"  -R <number>\n");
+	fprintf(stdout,"    Number of resolutions discarded by the decoder. Default: 0\n");
+	fprintf(stdout,"  -j <file>\n");
+	fprintf(stdout,"    Write the results as JSON into <file>, \"-\" for stdout.\n");
+	fprintf(stdout,"\n");
+	fprintf(stdout,"Example:\n");
+	fprintf(stdout,"  opj_bench -g 4096,2160,3,12 -t 1024,1024 -r 20,10,1 -I -N 10 -j rc.json\n");
+	fprintf(stdout,"\n");
+}
+
+/* -------------------------------------------------------------------------- */
+
+static OPJ_FLOAT64 bench_clock(void) {
+#ifdef _WIN32
+	LARGE_INTEGER freq , t ;
+	QueryPerformanceFrequency(&freq) ;
+	QueryPerformanceCounter ( & t ) ;
+	return freq.QuadPart ? ( t.QuadPart /(OPJ_FLOAT64) freq.QuadPart ) : 0 ;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (OPJ_FLOAT64)t.tv_sec + (OPJ_FLOAT64)t.tv_nsec * 1e-9;
+#else
+	struct timeval t;
+	gettimeofday(&t, NULL);
+	return (OPJ_FLOAT64)t.tv_sec + (OPJ_FLOAT64)t.tv_usec * 1e-6;
+#endif
+}
+
+static void error_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stderr, "[ERROR] %s", msg);
+}
+
+static void warning_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	(void)msg;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Memory stream                                                              */
+
+static OPJ_SIZE_T bench_buffer_read(void * p_buffer, OPJ_SIZE_T p_nb_bytes, void * p_user_data)
+{
+	bench_buffer_t * l_buf = (bench_buffer_t *) p_user_data;
+	OPJ_SIZE_T l_nb_bytes;
+
+	if (l_buf->offset >= l_buf->size) {
+		return (OPJ_SIZE_T)-1;
+	}
+	l_nb_bytes = l_buf->size - l_buf->offset;
+	if (l_nb_bytes > p_nb_bytes) {
+		l_nb_bytes = p_nb_bytes;
+	}
+	memcpy(p_buffer, l_buf->data + l_buf->offset, l_nb_bytes);
+	l_buf->offset += l_nb_bytes;
+	return l_nb_bytes;
+}
+
+static OPJ_SIZE_T bench_buffer_write(void * p_buffer, OPJ_SIZE_T p_nb_bytes, void * p_user_data)
+{
+	bench_buffer_t * l_buf = (bench_buffer_t *) p_user_data;
+
+	if (l_buf->offset + p_nb_bytes > l_buf->capacity) {
+		OPJ_SIZE_T l_capacity = l_buf->capacity ? l_buf->capacity : 65536;
+		OPJ_BYTE * l_data;
+
+		while (l_capacity < l_buf->offset + p_nb_bytes) {
+			l_capacity *= 2;
+		}
+		l_data = (OPJ_BYTE *) realloc(l_buf->data, l_capacity);
+		if (! l_data) {
+			return (OPJ_SIZE_T)-1;
+		}
+		l_buf->data = l_data;
+		l_buf->capacity = l_capacity;
+	}
+	memcpy(l_buf->data + l_buf->offset, p_buffer, p_nb_bytes);
+	l_buf->offset += p_nb_bytes;
+	if (l_buf->offset > l_buf->size) {
+		l_buf->size = l_buf->offset;
+	}
+	return p_nb_bytes;
+}
+
+static OPJ_OFF_T bench_buffer_skip(OPJ_OFF_T p_nb_bytes, void * p_user_data)
+{
+	bench_buffer_t * l_buf = (bench_buffer_t *) p_user_data;
+
+	if (p_nb_bytes < 0 && (OPJ_SIZE_T)(-p_nb_bytes) > l_buf->offset) {
+		return -1;
+	}
+	l_buf->offset = (OPJ_SIZE_T)((OPJ_OFF_T)l_buf->offset + p_nb_bytes);
+	return p_nb_bytes;
+}
+
+static OPJ_BOOL bench_buffer_seek(OPJ_OFF_T p_nb_bytes, void * p_user_data)
+{
+	bench_buffer_t * l_buf = (bench_buffer_t *) p_user_data;
+
+	if (p_nb_bytes < 0) {
+		return OPJ_FALSE;
+	}
+	l_buf->offset = (OPJ_SIZE_T)p_nb_bytes;
+	return OPJ_TRUE;
+}
+
+static opj_stream_t * bench_stream_create(bench_buffer_t * p_buffer, OPJ_BOOL p_is_input)
+{
+	opj_stream_t * l_stream = opj_stream_create(OPJ_J2K_STREAM_CHUNK_SIZE, p_is_input);
+
+	if (! l_stream) {
+		return NULL;
+	}
+	p_buffer->offset = 0;
+	if (p_is_input) {
+		opj_stream_set_read_function(l_stream, bench_buffer_read);
+		opj_stream_set_user_data_length(l_stream, p_buffer->size);
+	}
+	else {
+		p_buffer->size = 0;
+		opj_stream_set_write_function(l_stream, bench_buffer_write);
+	}
+	opj_stream_set_skip_function(l_stream, bench_buffer_skip);
+	opj_stream_set_seek_function(l_stream, bench_buffer_seek);
+	opj_stream_set_user_data(l_stream, p_buffer, NULL);
+	return l_stream;
+}
+
+static OPJ_BOOL bench_buffer_load(bench_buffer_t * p_buffer, const char * p_filename)
+{
+	FILE * l_file = fopen(p_filename, "rb");
+	long l_size;
+
+	if (! l_file) {
+		return OPJ_FALSE;
+	}
+	fseek(l_file, 0, SEEK_END);
+	l_size = ftell(l_file);
+	fseek(l_file, 0, SEEK_SET);
+	if (l_size <= 0) {
+		fclose(l_file);
+		return OPJ_FALSE;
+	}
+	p_buffer->data = (OPJ_BYTE *) malloc((size_t)l_size);
+	if (! p_buffer->data) {
+		fclose(l_file);
+		return OPJ_FALSE;
+	}
+	p_buffer->size = p_buffer->capacity = (OPJ_SIZE_T)l_size;
+	if (fread(p_buffer->data, 1, (size_t)l_size, l_file) != (size_t)l_size) {
+		fclose(l_file);
+		return OPJ_FALSE;
+	}
+	fclose(l_file);
+	return OPJ_TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int get_file_format(const char *filename) {
+	unsigned int i;
+	static const char *extension[] = {
+		"pgx", "pnm", "pgm", "ppm", "pbm", "pam", "bmp", "tif", "tga", "png", "j2k", "jp2", "j2c", "jpc"
+	};
+	static const int format[] = {
+		PGX_DFMT, PXM_DFMT, PXM_DFMT, PXM_DFMT, PXM_DFMT, PXM_DFMT, BMP_DFMT, TIF_DFMT, TGA_DFMT, PNG_DFMT, J2K_CFMT, JP2_CFMT, J2K_CFMT, J2K_CFMT
+	};
+	const char * ext = strrchr(filename, '.');
+	if (ext == NULL)
+		return -1;
+	ext++;
+	for(i = 0; i < sizeof(format)/sizeof(*format); i++) {
+		if(strcasecmp(ext, extension[i]) == 0) {
+			return format[i];
+		}
+	}
+	return -1;
+}
+
+static int parse_cmdline_bench(int argc, char **argv, bench_parameters_t *parameters)
+{
+	opj_cparameters_t * cp = &parameters->cparameters;
+	const char optlist[] = "i:g:m:N:W:F:t:b:n:r:IR:j:h";
+	int c;
+
+	while ((c = opj_getopt(argc, argv, optlist)) != -1) {
+		switch (c) {
+		case 'i':
+			strncpy(parameters->infile, opj_optarg, OPJ_PATH_LEN - 1);
+			parameters->decod_format = get_file_format(opj_optarg);
+			if (parameters->decod_format == -1
+#ifndef OPJ_HAVE_LIBTIFF
+				|| parameters->decod_format == TIF_DFMT
+#endif
+#ifndef OPJ_HAVE_LIBPNG
+				|| parameters->decod_format == PNG_DFMT
+#endif
+				) {
+				fprintf(stderr, "[ERROR] Unknown input file format: %s\n", opj_optarg);
+				return 1;
+			}
+			break;
+		case 'g': {
+			unsigned int w = 0, h = 0, n = 3, p = 8;
+			char s = 0;
+			if (sscanf(opj_optarg, "%u,%u,%u,%u,%c", &w, &h, &n, &p, &s) < 2
+				|| w == 0 || h == 0 || n == 0 || n > 16384 || p == 0 || p > 16) {
+				fprintf(stderr, "[ERROR] Invalid geometry: %s\n", opj_optarg);
+				return 1;
+			}
+			parameters->width = w;
+			parameters->height = h;
+			parameters->numcomps = n;
+			parameters->prec = p;
+			parameters->sgnd = (s == 's');
+			break;
+		}
+		case 'm':
+			if (strcmp(opj_optarg, "encode") == 0) {
+				parameters->mode = BENCH_ENCODE;
+			}
+			else if (strcmp(opj_optarg, "decode") == 0) {
+				parameters->mode = BENCH_DECODE;
+			}
+			else if (strcmp(opj_optarg, "both") == 0) {
+				parameters->mode = BENCH_ENCODE | BENCH_DECODE;
+			}
+			else {
+				fprintf(stderr, "[ERROR] Unknown mode: %s\n", opj_optarg);
+				return 1;
+			}
+			break;
+		case 'N':
+			parameters->runs = atoi(opj_optarg);
+			if (parameters->runs <= 0) {
+				fprintf(stderr, "[ERROR] The number of runs must be positive\n");
+				return 1;
+			}
+			break;
+		case 'W':
+			parameters->warmup = atoi(opj_optarg);
+			if (parameters->warmup < 0) {
+				fprintf(stderr, "[ERROR] The number of warmup runs must not be negative\n");
+				return 1;
+			}
+			break;
+		case 'F':
+			if (strcasecmp(opj_optarg, "j2k") == 0) {
+				parameters->cod_format = J2K_CFMT;
+			}
+			else if (strcasecmp(opj_optarg, "jp2") == 0) {
+				parameters->cod_format = JP2_CFMT;
+			}
+			else {
+				fprintf(stderr, "[ERROR] Unknown output format: %s\n", opj_optarg);
+				return 1;
+			}
+			break;
+		case 't':
+			if (sscanf(opj_optarg, "%d,%d", &cp->cp_tdx, &cp->cp_tdy) != 2
+				|| cp->cp_tdx <= 0 || cp->cp_tdy <= 0) {
+				fprintf(stderr, "[ERROR] Invalid tile size: %s\n", opj_optarg);
+				return 1;
+			}
+			cp->tile_size_on = OPJ_TRUE;
+			break;
+		case 'b':
+			if (sscanf(opj_optarg, "%d,%d", &cp->cblockw_init, &cp->cblockh_init) != 2
+				|| cp->cblockw_init > 1024 || cp->cblockw_init < 4
+				|| cp->cblockh_init > 1024 || cp->cblockh_init < 4
+				|| cp->cblockw_init * cp->cblockh_init > 4096) {
+				fprintf(stderr, "[ERROR] Invalid code-block size: %s\n", opj_optarg);
+				return 1;
+			}
+			break;
+		case 'n':
+			cp->numresolution = atoi(opj_optarg);
+			if (cp->numresolution <= 0 || cp->numresolution > OPJ_J2K_MAXRLVLS) {
+				fprintf(stderr, "[ERROR] Invalid number of resolutions: %s\n", opj_optarg);
+				return 1;
+			}
+			break;
+		case 'r': {
+			char *s = opj_optarg;
+			cp->tcp_numlayers = 0;
+			while (sscanf(s, "%f", &cp->tcp_rates[cp->tcp_numlayers]) == 1) {
+				cp->tcp_numlayers++;
+				while (*s && *s != ',') {
+					s++;
+				}
+				if (!*s || cp->tcp_numlayers == 100) {
+					break;
+				}
+				s++;
+			}
+			if (cp->tcp_numlayers == 0) {
+				fprintf(stderr, "[ERROR] Invalid rates: %s\n", opj_optarg);
+				return 1;
+			}
+			cp->cp_disto_alloc = 1;
+			break;
+		}
+		case 'I':
+			cp->irreversible = 1;
+			break;
+		case 'R':
+			parameters->reduce = (OPJ_UINT32)atoi(opj_optarg);
+			break;
+		case 'j':
+			strncpy(parameters->jsonfile, opj_optarg, OPJ_PATH_LEN - 1);
+			break;
+		case 'h':
+			bench_help_display();
+			return 1;
+		default:
+			fprintf(stderr, "[WARNING] An invalid option has been ignored\n");
+			break;
+		}
+	}
+
+	if (cp->tcp_numlayers == 0) {
+		cp->tcp_rates[0] = 0;
+		cp->tcp_numlayers = 1;
+		cp->cp_disto_alloc = 1;
+	}
+	return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Generates a deterministic image: a diagonal ramp different for each
+ * component overlaid with pseudo-random noise, so that the coder has both
+ * smooth areas and texture to work on.
+ */
+static opj_image_t * bench_generate_image(const bench_parameters_t * parameters)
+{
+	opj_image_cmptparm_t * l_params;
+	opj_image_t * l_image;
+	OPJ_UINT32 compno, x, y;
+	OPJ_UINT32 l_seed = 0x12345678U;
+	OPJ_COLOR_SPACE l_color_space = parameters->numcomps >= 3 ? OPJ_CLRSPC_SRGB : OPJ_CLRSPC_GRAY;
+
+	l_params = (opj_image_cmptparm_t *) calloc(parameters->numcomps, sizeof(opj_image_cmptparm_t));
+	if (! l_params) {
+		return NULL;
+	}
+	for (compno = 0; compno < parameters->numcomps; ++compno) {
+		l_params[compno].dx = 1;
+		l_params[compno].dy = 1;
+		l_params[compno].w = parameters->width;
+		l_params[compno].h = parameters->height;
+		l_params[compno].prec = parameters->prec;
+		l_params[compno].bpp = parameters->prec;
+		l_params[compno].sgnd = (OPJ_UINT32)parameters->sgnd;
+	}
+	l_image = opj_image_create(parameters->numcomps, l_params, l_color_space);
+	free(l_params);
+	if (! l_image) {
+		return NULL;
+	}
+	l_image->x1 = parameters->width;
+	l_image->y1 = parameters->height;
+
+	for (compno = 0; compno < parameters->numcomps; ++compno) {
+		OPJ_INT32 * l_data = l_image->comps[compno].data;
+		OPJ_INT32 l_max = (OPJ_INT32)((1U << parameters->prec) - 1);
+		OPJ_INT32 l_offset = parameters->sgnd ? (OPJ_INT32)(1U << (parameters->prec - 1)) : 0;
+		OPJ_UINT32 l_noise_bits = parameters->prec > 4 ? parameters->prec - 4 : 1;
+
+		for (y = 0; y < parameters->height; ++y) {
+			for (x = 0; x < parameters->width; ++x) {
+				OPJ_INT32 l_value;
+
+				l_seed = l_seed * 1664525U + 1013904223U;
+				l_value = (OPJ_INT32)(((OPJ_UINT64)(x + y + compno * 97U) << parameters->prec)
+				                      / (parameters->width + parameters->height));
+				l_value += (OPJ_INT32)(l_seed >> (32 - l_noise_bits));
+				if (l_value > l_max) {
+					l_value = l_max;
+				}
+				*l_data++ = l_value - l_offset;
+			}
+		}
+	}
+
+	return l_image;
+}
+
+static opj_image_t * bench_load_image(bench_parameters_t * parameters, bench_buffer_t * p_codestream)
+{
+	opj_cparameters_t * cp = &parameters->cparameters;
+
+	switch (parameters->decod_format) {
+	case PGX_DFMT:
+		return pgxtoimage(parameters->infile, cp);
+	case PXM_DFMT:
+		return pnmtoimage(parameters->infile, cp);
+	case BMP_DFMT:
+		return bmptoimage(parameters->infile, cp);
+	case TGA_DFMT:
+		return tgatoimage(parameters->infile, cp);
+#ifdef OPJ_HAVE_LIBTIFF
+	case TIF_DFMT:
+		return tiftoimage(parameters->infile, cp);
+#endif /* OPJ_HAVE_LIBTIFF */
+#ifdef OPJ_HAVE_LIBPNG
+	case PNG_DFMT:
+		return pngtoimage(parameters->infile, cp);
+#endif /* OPJ_HAVE_LIBPNG */
+	case J2K_CFMT:
+	case JP2_CFMT: {
+		opj_dparameters_t l_dparameters;
+		opj_codec_t * l_codec;
+		opj_stream_t * l_stream;
+		opj_image_t * l_image = NULL;
+		OPJ_BOOL l_success;
+
+		if (! bench_buffer_load(p_codestream, parameters->infile)) {
+			return NULL;
+		}
+		l_codec = opj_create_decompress(parameters->decod_format == J2K_CFMT ? OPJ_CODEC_J2K : OPJ_CODEC_JP2);
+		l_stream = bench_stream_create(p_codestream, OPJ_TRUE);
+		opj_set_default_decoder_parameters(&l_dparameters);
+		opj_set_error_handler(l_codec, error_callback, NULL);
+		l_success = opj_setup_decoder(l_codec, &l_dparameters)
+			&& opj_read_header(l_stream, l_codec, &l_image)
+			&& opj_decode(l_codec, l_stream, l_image)
+			&& opj_end_decompress(l_codec, l_stream);
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		if (! l_success) {
+			opj_image_destroy(l_image);
+			return NULL;
+		}
+		return l_image;
+	}
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * Duplicates the image: the compressor takes over the samples of the image
+ * it encodes, each run works on its own copy.
+ */
+static opj_image_t * bench_image_copy(const opj_image_t * p_image)
+{
+	opj_image_cmptparm_t * l_params;
+	opj_image_t * l_copy;
+	OPJ_UINT32 compno;
+
+	l_params = (opj_image_cmptparm_t *) calloc(p_image->numcomps, sizeof(opj_image_cmptparm_t));
+	if (! l_params) {
+		return NULL;
+	}
+	for (compno = 0; compno < p_image->numcomps; ++compno) {
+		const opj_image_comp_t * l_comp = &p_image->comps[compno];
+		l_params[compno].dx = l_comp->dx;
+		l_params[compno].dy = l_comp->dy;
+		l_params[compno].w = l_comp->w;
+		l_params[compno].h = l_comp->h;
+		l_params[compno].x0 = l_comp->x0;
+		l_params[compno].y0 = l_comp->y0;
+		l_params[compno].prec = l_comp->prec;
+		l_params[compno].bpp = l_comp->bpp;
+		l_params[compno].sgnd = l_comp->sgnd;
+	}
+	l_copy = opj_image_create(p_image->numcomps, l_params, p_image->color_space);
+	free(l_params);
+	if (! l_copy) {
+		return NULL;
+	}
+	l_copy->x0 = p_image->x0;
+	l_copy->y0 = p_image->y0;
+	l_copy->x1 = p_image->x1;
+	l_copy->y1 = p_image->y1;
+	for (compno = 0; compno < p_image->numcomps; ++compno) {
+		l_copy->comps[compno].alpha = p_image->comps[compno].alpha;
+		memcpy(l_copy->comps[compno].data, p_image->comps[compno].data,
+		       (size_t)p_image->comps[compno].w * p_image->comps[compno].h * sizeof(OPJ_INT32));
+	}
+	return l_copy;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void bench_result_add(bench_result_t * p_result, OPJ_FLOAT64 p_time,
+                             opj_codec_t * p_codec)
+{
+	const opj_profile_t * l_profile = opj_get_profile(p_codec);
+	OPJ_SIZE_T l_peak = 0;
+	OPJ_UINT32 i;
+
+	if (p_result->runs == 0 || p_time < p_result->time_min) {
+		p_result->time_min = p_time;
+	}
+	if (p_time > p_result->time_max) {
+		p_result->time_max = p_time;
+	}
+	p_result->time_sum += p_time;
+	++p_result->runs;
+
+	opj_get_memory_usage(p_codec, NULL, &l_peak);
+	if (l_peak > p_result->mem_peak) {
+		p_result->mem_peak = l_peak;
+	}
+
+	if (l_profile) {
+		for (i = 0; i < OPJ_PROFILE_NB_STAGES; ++i) {
+			p_result->stats.times[i] += l_profile->total.times[i];
+		}
+		p_result->stats.nb_code_blocks += l_profile->total.nb_code_blocks;
+		p_result->stats.nb_passes += l_profile->total.nb_passes;
+		p_result->stats.nb_mq_symbols += l_profile->total.nb_mq_symbols;
+		p_result->stats.nb_bytes_read += l_profile->total.nb_bytes_read;
+		p_result->stats.nb_bytes_copied += l_profile->total.nb_bytes_copied;
+	}
+}
+
+static OPJ_BOOL bench_encode(bench_parameters_t * parameters, opj_image_t * p_image,
+                             bench_buffer_t * p_output, bench_result_t * p_result)
+{
+	int run;
+
+	for (run = 0; run < parameters->warmup + parameters->runs; ++run) {
+		opj_codec_t * l_codec;
+		opj_stream_t * l_stream;
+		OPJ_BOOL l_success;
+		OPJ_FLOAT64 l_time;
+		opj_image_t * l_image = bench_image_copy(p_image);
+
+		if (! l_image) {
+			return OPJ_FALSE;
+		}
+		l_time = bench_clock();
+		l_codec = opj_create_compress(parameters->cod_format == J2K_CFMT ? OPJ_CODEC_J2K : OPJ_CODEC_JP2);
+		if (! l_codec) {
+			opj_image_destroy(l_image);
+			return OPJ_FALSE;
+		}
+		opj_set_error_handler(l_codec, error_callback, NULL);
+		opj_set_warning_handler(l_codec, warning_callback, NULL);
+		opj_set_profiling(l_codec, run >= parameters->warmup);
+		l_stream = bench_stream_create(p_output, OPJ_FALSE);
+		l_success = l_stream
+			&& opj_setup_encoder(l_codec, &parameters->cparameters, l_image)
+			&& opj_start_compress(l_codec, l_image, l_stream)
+			&& opj_encode(l_codec, l_stream)
+			&& opj_end_compress(l_codec, l_stream);
+		opj_stream_destroy(l_stream);
+		l_time = bench_clock() - l_time;
+
+		if (l_success && run >= parameters->warmup) {
+			bench_result_add(p_result, l_time, l_codec);
+			p_result->codestream_size = p_output->size;
+		}
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		if (! l_success) {
+			fprintf(stderr, "[ERROR] Failed to encode the image\n");
+			return OPJ_FALSE;
+		}
+	}
+	return OPJ_TRUE;
+}
+
+static OPJ_BOOL bench_decode(bench_parameters_t * parameters, OPJ_CODEC_FORMAT p_format,
+                             bench_buffer_t * p_input, bench_result_t * p_result)
+{
+	int run;
+
+	for (run = 0; run < parameters->warmup + parameters->runs; ++run) {
+		opj_dparameters_t l_dparameters;
+		opj_codec_t * l_codec;
+		opj_stream_t * l_stream;
+		opj_image_t * l_image = NULL;
+		OPJ_BOOL l_success;
+		OPJ_FLOAT64 l_time = bench_clock();
+
+		l_codec = opj_create_decompress(p_format);
+		if (! l_codec) {
+			return OPJ_FALSE;
+		}
+		opj_set_default_decoder_parameters(&l_dparameters);
+		l_dparameters.cp_reduce = parameters->reduce;
+		opj_set_error_handler(l_codec, error_callback, NULL);
+		opj_set_warning_handler(l_codec, warning_callback, NULL);
+		opj_set_profiling(l_codec, run >= parameters->warmup);
+		l_stream = bench_stream_create(p_input, OPJ_TRUE);
+		l_success = l_stream
+			&& opj_setup_decoder(l_codec, &l_dparameters)
+			&& opj_read_header(l_stream, l_codec, &l_image)
+			&& opj_decode(l_codec, l_stream, l_image)
+			&& opj_end_decompress(l_codec, l_stream);
+		opj_stream_destroy(l_stream);
+		l_time = bench_clock() - l_time;
+
+		if (l_success && run >= parameters->warmup) {
+			bench_result_add(p_result, l_time, l_codec);
+			p_result->codestream_size = p_input->size;
+		}
+		opj_image_destroy(l_image);
+		opj_destroy_codec(l_codec);
+		if (! l_success) {
+			fprintf(stderr, "[ERROR] Failed to decode the codestream\n");
+			return OPJ_FALSE;
+		}
+	}
+	return OPJ_TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void bench_print_table(FILE * p_out, const char * p_name, const bench_result_t * p_result,
+                              OPJ_FLOAT64 p_mpixels)
+{
+	OPJ_FLOAT64 l_mean = p_result->time_sum / p_result->runs;
+	OPJ_FLOAT64 l_stages = 0;
+	OPJ_UINT32 i;
+
+	for (i = 0; i < OPJ_PROFILE_NB_STAGES; ++i) {
+		l_stages += p_result->stats.times[i];
+	}
+
+	fprintf(p_out, "%s (%d runs)\n", p_name, p_result->runs);
+	fprintf(p_out, "  time (s)        min %10.4f  mean %10.4f  max %10.4f\n",
+	        p_result->time_min, l_mean, p_result->time_max);
+	fprintf(p_out, "  MPixels/s       best %9.2f  mean %10.2f\n",
+	        p_mpixels / p_result->time_min, p_mpixels / l_mean);
+	fprintf(p_out, "  peak memory     %.2f MB\n", (OPJ_FLOAT64)p_result->mem_peak / (1024. * 1024.));
+	fprintf(p_out, "  codestream      %lu bytes\n", (unsigned long)p_result->codestream_size);
+	fprintf(p_out, "  stage           mean (s)    %%\n");
+	for (i = 0; i < OPJ_PROFILE_NB_STAGES; ++i) {
+		fprintf(p_out, "    %-12s  %10.4f  %5.1f\n", stage_names[i],
+		        p_result->stats.times[i] / p_result->runs,
+		        l_stages > 0 ? 100. * p_result->stats.times[i] / l_stages : 0.);
+	}
+	fprintf(p_out, "  code-blocks %.0f, passes %.0f, MQ symbols %.0f (per run)\n",
+	        (OPJ_FLOAT64)p_result->stats.nb_code_blocks / p_result->runs,
+	        (OPJ_FLOAT64)p_result->stats.nb_passes / p_result->runs,
+	        (OPJ_FLOAT64)p_result->stats.nb_mq_symbols / p_result->runs);
+	fprintf(p_out, "\n");
+}
+
+static void bench_print_json_result(FILE * p_out, const char * p_name, const bench_result_t * p_result,
+                                    OPJ_FLOAT64 p_mpixels)
+{
+	OPJ_FLOAT64 l_mean = p_result->time_sum / p_result->runs;
+	OPJ_UINT32 i;
+
+	fprintf(p_out, "    \"%s\": {\n", p_name);
+	fprintf(p_out, "      \"runs\": %d,\n", p_result->runs);
+	fprintf(p_out, "      \"time_min\": %.6f,\n", p_result->time_min);
+	fprintf(p_out, "      \"time_mean\": %.6f,\n", l_mean);
+	fprintf(p_out, "      \"time_max\": %.6f,\n", p_result->time_max);
+	fprintf(p_out, "      \"mpixels_per_s_best\": %.4f,\n", p_mpixels / p_result->time_min);
+	fprintf(p_out, "      \"mpixels_per_s_mean\": %.4f,\n", p_mpixels / l_mean);
+	fprintf(p_out, "      \"peak_memory\": %lu,\n", (unsigned long)p_result->mem_peak);
+	fprintf(p_out, "      \"codestream_size\": %lu,\n", (unsigned long)p_result->codestream_size);
+	fprintf(p_out, "      \"stages\": {");
+	for (i = 0; i < OPJ_PROFILE_NB_STAGES; ++i) {
+		fprintf(p_out, "%s\"%s\": %.6f", i ? ", " : " ", stage_names[i],
+		        p_result->stats.times[i] / p_result->runs);
+	}
+	fprintf(p_out, " },\n");
+	fprintf(p_out, "      \"code_blocks\": %.0f,\n", (OPJ_FLOAT64)p_result->stats.nb_code_blocks / p_result->runs);
+	fprintf(p_out, "      \"passes\": %.0f,\n", (OPJ_FLOAT64)p_result->stats.nb_passes / p_result->runs);
+	fprintf(p_out, "      \"mq_symbols\": %.0f\n", (OPJ_FLOAT64)p_result->stats.nb_mq_symbols / p_result->runs);
+	fprintf(p_out, "    }");
+}
+
+static void bench_print_json(FILE * p_out, const bench_parameters_t * parameters,
+                             const opj_image_t * p_image, const bench_result_t * p_encode,
+                             const bench_result_t * p_decode, OPJ_FLOAT64 p_mpixels)
+{
+	const opj_cparameters_t * cp = &parameters->cparameters;
+	int i;
+
+	fprintf(p_out, "{\n");
+	fprintf(p_out, "  \"version\": \"%s\",\n", opj_version());
+	fprintf(p_out, "  \"input\": \"%s\",\n", parameters->infile[0] ? parameters->infile : "synthetic");
+	fprintf(p_out, "  \"image\": { \"width\": %u, \"height\": %u, \"components\": %u, \"precision\": %u, \"signed\": %s },\n",
+	        p_image->x1 - p_image->x0, p_image->y1 - p_image->y0, p_image->numcomps,
+	        p_image->comps[0].prec, p_image->comps[0].sgnd ? "true" : "false");
+	fprintf(p_out, "  \"parameters\": { \"format\": \"%s\", \"tile_width\": %d, \"tile_height\": %d, "
+	        "\"cblk_width\": %d, \"cblk_height\": %d, \"resolutions\": %d, \"wavelet\": \"%s\", \"reduce\": %u, \"rates\": [",
+	        parameters->cod_format == J2K_CFMT ? "j2k" : "jp2",
+	        cp->tile_size_on ? cp->cp_tdx : 0, cp->tile_size_on ? cp->cp_tdy : 0,
+	        cp->cblockw_init, cp->cblockh_init, cp->numresolution,
+	        cp->irreversible ? "9/7" : "5/3", parameters->reduce);
+	for (i = 0; i < cp->tcp_numlayers; ++i) {
+		fprintf(p_out, "%s%g", i ? ", " : "", cp->tcp_rates[i]);
+	}
+	fprintf(p_out, "] },\n");
+	fprintf(p_out, "  \"mpixels\": %.6f,\n", p_mpixels);
+	fprintf(p_out, "  \"results\": {\n");
+	if (p_encode->runs) {
+		bench_print_json_result(p_out, "encode", p_encode, p_mpixels);
+	}
+	if (p_decode->runs) {
+		fprintf(p_out, "%s", p_encode->runs ? ",\n" : "");
+		bench_print_json_result(p_out, "decode", p_decode, p_mpixels);
+	}
+	fprintf(p_out, "\n  }\n");
+	fprintf(p_out, "}\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/**
+ * OPJ_BENCH MAIN
+ */
+/* -------------------------------------------------------------------------- */
+int main(int argc, char **argv)
+{
+	bench_parameters_t parameters;
+	bench_buffer_t l_codestream;
+	bench_result_t l_encode, l_decode;
+	opj_image_t * l_image;
+	OPJ_CODEC_FORMAT l_decode_format;
+	OPJ_FLOAT64 l_mpixels;
+	OPJ_BOOL l_success = OPJ_TRUE;
+	OPJ_BOOL l_compressed_input;
+
+	memset(&parameters, 0, sizeof(parameters));
+	memset(&l_codestream, 0, sizeof(l_codestream));
+	memset(&l_encode, 0, sizeof(l_encode));
+	memset(&l_decode, 0, sizeof(l_decode));
+	opj_set_default_encoder_parameters(&parameters.cparameters);
+	parameters.decod_format = -1;
+	parameters.mode = BENCH_ENCODE | BENCH_DECODE;
+	parameters.cod_format = J2K_CFMT;
+	parameters.runs = 5;
+	parameters.warmup = 1;
+	parameters.width = 2048;
+	parameters.height = 2048;
+	parameters.numcomps = 3;
+	parameters.prec = 8;
+
+	if (parse_cmdline_bench(argc, argv, &parameters)) {
+		return 1;
+	}
+
+	l_compressed_input = parameters.decod_format == J2K_CFMT || parameters.decod_format == JP2_CFMT;
+	if (parameters.infile[0]) {
+		l_image = bench_load_image(&parameters, &l_codestream);
+	}
+	else {
+		l_image = bench_generate_image(&parameters);
+	}
+	if (! l_image) {
+		fprintf(stderr, "[ERROR] Unable to %s the input image\n", parameters.infile[0] ? "load" : "generate");
+		free(l_codestream.data);
+		return 1;
+	}
+	/* Decide if MCT should be used */
+	parameters.cparameters.tcp_mct = (char)(l_image->numcomps >= 3 ? 1 : 0);
+	l_mpixels = (OPJ_FLOAT64)(l_image->x1 - l_image->x0) * (OPJ_FLOAT64)(l_image->y1 - l_image->y0) * 1e-6;
+
+	if ((parameters.mode & BENCH_ENCODE) || ! l_compressed_input) {
+		bench_result_t l_unused;
+		memset(&l_unused, 0, sizeof(l_unused));
+		/* when only the decoder is benchmarked, encode once to get a codestream */
+		if (! (parameters.mode & BENCH_ENCODE)) {
+			bench_parameters_t l_once = parameters;
+			l_once.warmup = 0;
+			l_once.runs = 1;
+			l_success = bench_encode(&l_once, l_image, &l_codestream, &l_unused);
+		}
+		else if (l_compressed_input) {
+			/* keep the input codestream for the decoder */
+			bench_buffer_t l_output;
+			memset(&l_output, 0, sizeof(l_output));
+			l_success = bench_encode(&parameters, l_image, &l_output, &l_encode);
+			free(l_output.data);
+		}
+		else {
+			l_success = bench_encode(&parameters, l_image, &l_codestream, &l_encode);
+		}
+	}
+
+	if (l_compressed_input) {
+		l_decode_format = parameters.decod_format == J2K_CFMT ? OPJ_CODEC_J2K : OPJ_CODEC_JP2;
+	}
+	else {
+		l_decode_format = parameters.cod_format == J2K_CFMT ? OPJ_CODEC_J2K : OPJ_CODEC_JP2;
+	}
+	if (l_success && (parameters.mode & BENCH_DECODE)) {
+		l_success = bench_decode(&parameters, l_decode_format, &l_codestream, &l_decode);
+	}
+
+	if (l_success) {
+		fprintf(stdout, "opj_bench: %s, %ux%u, %u component(s), %u bit(s)%s, %.2f MPixels\n\n",
+		        parameters.infile[0] ? parameters.infile : "synthetic image",
+		        l_image->x1 - l_image->x0, l_image->y1 - l_image->y0, l_image->numcomps,
+		        l_image->comps[0].prec, l_image->comps[0].sgnd ? " signed" : "", l_mpixels);
+		if (l_encode.runs) {
+			bench_print_table(stdout, "encode", &l_encode, l_mpixels);
+		}
+		if (l_decode.runs) {
+			bench_print_table(stdout, "decode", &l_decode, l_mpixels);
+		}
+
+		if (parameters.jsonfile[0]) {
+			FILE * l_json = strcmp(parameters.jsonfile, "-") == 0 ? stdout : fopen(parameters.jsonfile, "w");
+			if (! l_json) {
+				fprintf(stderr, "[ERROR] Unable to open %s for writing\n", parameters.jsonfile);
+				l_success = OPJ_FALSE;
+			}
+			else {
+				bench_print_json(l_json, &parameters, l_image, &l_encode, &l_decode, l_mpixels);
+				if (l_json != stdout) {
+					fclose(l_json);
+				}
+			}
+		}
+	}
+
+	opj_image_destroy(l_image);
+	free(l_codestream.data);
+
+	return l_success ? 0 : 1;
+}
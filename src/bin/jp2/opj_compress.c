@@ -217,6 +217,10 @@ static void encode_help_display(void) {
     fprintf(stdout,"    Divide packets of every tile into tile-parts.\n");
     fprintf(stdout,"    Division is made by grouping Resolutions (R), Layers (L)\n");
     fprintf(stdout,"    or Components (C).\n");
+    fprintf(stdout,"-TLM\n");
+    fprintf(stdout,"    Write TLM markers giving the length of every tile-part in the main header.\n");
+    fprintf(stdout,"-PLT\n");
+    fprintf(stdout,"    Write PLT markers giving the length of every packet in the tile-part headers.\n");
     #ifdef FIXME_INDEX
     fprintf(stdout,"-x  <index file>\n");
     fprintf(stdout,"    Create an index file.\n");
@@ -254,6 +258,8 @@ static void encode_help_display(void) {
     fprintf(stdout,"-jpip\n");
     fprintf(stdout,"    Write jpip codestream index box in JP2 output file.\n");
     fprintf(stdout,"    Currently supports only RPCL order.\n");
+    fprintf(stdout,"-profile\n");
+    fprintf(stdout,"    Print the time spent in each encoding stage and the work done, for each tile.\n");
     fprintf(stdout,"-C <comment>\n");
     fprintf(stdout,"    Add <comment> in the comment marker segment.\n");
     /* UniPG>> */
@@ -472,7 +478,8 @@ static char get_next_file(int imageno,dircnt_t *dirptr,img_fol_t *img_fol, opj_c
 /* ------------------------------------------------------------------------------------ */
 
 static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *parameters,
-                                 img_fol_t *img_fol, raw_cparameters_t *raw_cp, char *indexfilename) {
+                                 img_fol_t *img_fol, raw_cparameters_t *raw_cp, char *indexfilename,
+                                 int *profile) {
     OPJ_UINT32 i, j;
     int totlen, c;
     opj_option_t long_option[]={
@@ -486,7 +493,10 @@ static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *param
         {"POC",REQ_ARG, NULL ,'P'},
         {"ROI",REQ_ARG, NULL ,'R'},
         {"jpip",NO_ARG, NULL, 'J'},
-        {"mct",REQ_ARG, NULL, 'Y'}
+        {"mct",REQ_ARG, NULL, 'Y'},
+        {"profile",NO_ARG, NULL, 1},
+        {"TLM",NO_ARG, NULL, 'A'},
+        {"PLT",NO_ARG, NULL, 'B'}
     };
 
     /* parse the command line */
@@ -496,6 +506,7 @@ static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *param
         #endif /* USE_JPWL */
             "h";
 
+    long_option[11].flag = profile;
     totlen=sizeof(long_option);
     img_fol->set_out_format=0;
     raw_cp->rawWidth = 0;
@@ -505,6 +516,8 @@ static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *param
         if (c == -1)
             break;
         switch (c) {
+        case 0: /* long opt with flag */
+            break;
         case 'i':			/* input file */
         {
             char *infile = opj_optarg;
@@ -977,6 +990,22 @@ static int parse_cmdline_encoder(int argc, char **argv, opj_cparameters_t *param
 
             /* ------------------------------------------------------ */
 
+        case 'A':			/* TLM markers */
+        {
+            parameters->tlm_on = OPJ_TRUE;
+        }
+            break;
+
+            /* ------------------------------------------------------ */
+
+        case 'B':			/* PLT markers */
+        {
+            parameters->plt_on = OPJ_TRUE;
+        }
+            break;
+
+            /* ------------------------------------------------------ */
+
         case 'z':			/* Image Directory path */
         {
             img_fol->imgdirpath = (char*)malloc(strlen(opj_optarg) + 1);
@@ -1585,6 +1614,7 @@ int main(int argc, char **argv) {
     dircnt_t *dirptr = NULL;
 
     OPJ_BOOL bSuccess;
+    int profile = 0;
     OPJ_BOOL bUseTiles = OPJ_FALSE; /* OPJ_TRUE */
     OPJ_UINT32 l_nb_tiles = 4;
     OPJ_FLOAT64 t = opj_clock();
@@ -1606,7 +1636,7 @@ int main(int argc, char **argv) {
 
     /* parse input and get user encoding parameters */
     parameters.tcp_mct = (char) 255; /* This will be set later according to the input image or the provided option */
-    if(parse_cmdline_encoder(argc, argv, &parameters,&img_fol, &raw_cp, indexfilename) == 1) {
+    if(parse_cmdline_encoder(argc, argv, &parameters,&img_fol, &raw_cp, indexfilename, &profile) == 1) {
         return 1;
     }
 
@@ -1791,6 +1821,10 @@ int main(int argc, char **argv) {
         opj_set_warning_handler(l_codec, warning_callback,00);
         opj_set_error_handler(l_codec, error_callback,00);
 
+        if (profile) {
+            opj_set_profiling(l_codec, OPJ_TRUE);
+        }
+
         if( bUseTiles ) {
             parameters.cp_tx0 = 0;
             parameters.cp_ty0 = 0;
@@ -1854,6 +1888,9 @@ int main(int argc, char **argv) {
 
 		num_compressed_files++;
         fprintf(stdout,"[INFO] Generated outfile %s\n",parameters.outfile);
+        if (profile) {
+            opj_dump_profile(l_codec, stdout);
+        }
         /* close and free the byte stream */
         opj_stream_destroy(l_stream);
 
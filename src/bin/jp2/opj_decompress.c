@@ -147,6 +147,8 @@ typedef struct opj_decompress_params
 	int upsample;
 	/* split output components to different files */
 	int split_pnm;
+	/* print the time spent in each decoding stage */
+	int profile;
 }opj_decompress_parameters;
 
 /* -------------------------------------------------------------------------- */
@@ -222,6 +224,8 @@ static void decode_help_display(void) {
 	               "    Downsampled components will be upsampled to image size\n"
 	               "  -split-pnm\n"
 	               "    Split output components to different files when writing to PNM\n"
+	               "  -profile\n"
+	               "    Print the time spent in each decoding stage and the work done, for each tile\n"
 	               "\n");
 /* UniPG>> */
 #ifdef USE_JPWL
@@ -511,7 +515,8 @@ int parse_cmdline_decoder(int argc, char **argv, opj_decompress_parameters *para
 		{"OutFor",    REQ_ARG, NULL,'O'},
 		{"force-rgb", NO_ARG,  NULL, 1},
 		{"upsample",  NO_ARG,  NULL, 1},
-		{"split-pnm", NO_ARG,  NULL, 1}
+		{"split-pnm", NO_ARG,  NULL, 1},
+		{"profile",   NO_ARG,  NULL, 1}
 	};
 
 	const char optlist[] = "i:o:r:l:x:d:t:p:"
@@ -526,6 +531,7 @@ int parse_cmdline_decoder(int argc, char **argv, opj_decompress_parameters *para
 	long_option[2].flag = &(parameters->force_rgb);
 	long_option[3].flag = &(parameters->upsample);
 	long_option[4].flag = &(parameters->split_pnm);
+	long_option[5].flag = &(parameters->profile);
 	totlen=sizeof(long_option);
 	opj_reset_options_reading();
 	img_fol->set_out_format = 0;
@@ -1277,6 +1283,10 @@ int main(int argc, char **argv)
 		opj_set_warning_handler(l_codec, warning_callback,00);
 		opj_set_error_handler(l_codec, error_callback,00);
 
+		if (parameters.profile) {
+			opj_set_profiling(l_codec, OPJ_TRUE);
+		}
+
 		t = opj_clock();
 
 		/* Setup the decoder decoding parameters using user parameters */
@@ -1346,6 +1356,10 @@ int main(int argc, char **argv)
 		tCumulative += opj_clock() - t;
 		numDecompressedImages++;
 
+		if (parameters.profile) {
+			opj_dump_profile(l_codec, stdout);
+		}
+
 		/* Close the byte stream */
 		opj_stream_destroy(l_stream);
 
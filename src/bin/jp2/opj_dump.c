@@ -52,6 +52,7 @@
 #endif /* _WIN32 */
 
 #include "openjpeg.h"
+#include "opj_inttypes.h"
 #include "opj_getopt.h"
 #include "convert.h"
 #include "index.h"
@@ -77,6 +78,8 @@ typedef struct img_folder{
 	char set_out_format;
 
   int flag;
+	/** File receiving the byte ranges of the packets, if not NULL */
+	char *packet_map_file;
 }img_fol_t;
 
 /* -------------------------------------------------------------------------- */
@@ -88,6 +91,7 @@ static char get_next_file(int imageno,dircnt_t *dirptr,img_fol_t *img_fol, opj_d
 static int infile_format(const char *fname);
 
 static int parse_cmdline_decoder(int argc, char **argv, opj_dparameters_t *parameters,img_fol_t *img_fol);
+static int write_packet_map(const char *filename, const opj_packet_map_t *packet_map);
 
 /* -------------------------------------------------------------------------- */
 static void decode_help_display(void) {
@@ -108,6 +112,11 @@ static void decode_help_display(void) {
 	fprintf(stdout,"    OPTIONAL\n");
 	fprintf(stdout,"    Output file where file info will be dump.\n");
 	fprintf(stdout,"    By default it will be in the stdout.\n");
+	fprintf(stdout,"  -p <packet map file>\n");
+	fprintf(stdout,"    OPTIONAL\n");
+	fprintf(stdout,"    JSON file where the position and length in the input file of every\n");
+	fprintf(stdout,"    packet will be written, with its tile, component, resolution,\n");
+	fprintf(stdout,"    precinct and layer. Only the packet headers are read.\n");
     fprintf(stdout,"  -v "); /* FIXME WIP_MSD */
 	fprintf(stdout,"    OPTIONAL\n");
     fprintf(stdout,"    Enable informative messages\n");
@@ -274,7 +283,7 @@ static int parse_cmdline_decoder(int argc, char **argv, opj_dparameters_t *param
 	opj_option_t long_option[]={
         {"ImgDir",REQ_ARG, NULL ,'y'}
 	};
-    const char optlist[] = "i:o:f:hv";
+    const char optlist[] = "i:o:f:p:hv";
 
 	totlen=sizeof(long_option);
 	img_fol->set_out_format = 0;
@@ -315,6 +324,15 @@ static int parse_cmdline_decoder(int argc, char **argv, opj_dparameters_t *param
 			break;
 				
 				/* ----------------------------------------------------- */
+
+			case 'p':     /* packet map file */
+			{
+				img_fol->packet_map_file = (char*)malloc(strlen(opj_optarg) + 1);
+				strcpy(img_fol->packet_map_file,opj_optarg);
+			}
+			break;
+
+				/* ----------------------------------------------------- */
       case 'f': 			/* flag */
         img_fol->flag = atoi(opj_optarg);
         break;
@@ -365,6 +383,10 @@ static int parse_cmdline_decoder(int argc, char **argv, opj_dparameters_t *param
             fprintf(stderr, "[ERROR] options -ImgDir and -o cannot be used together\n");
 			return 1;
 		}
+		if(img_fol->packet_map_file){
+            fprintf(stderr, "[ERROR] options -ImgDir and -p cannot be used together\n");
+			return 1;
+		}
 	}else{
 		if(parameters->infile[0] == 0) {
             fprintf(stderr, "[ERROR] Required parameter is missing\n");
@@ -377,6 +399,39 @@ static int parse_cmdline_decoder(int argc, char **argv, opj_dparameters_t *param
 	return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+/**
+ * Write the byte ranges of the packets as JSON, one packet per line
+ */
+/* -------------------------------------------------------------------------- */
+static int write_packet_map(const char *filename, const opj_packet_map_t *packet_map) {
+	FILE *fmap;
+	OPJ_UINT32 i;
+
+	fmap = fopen(filename,"w");
+	if (!fmap){
+		fprintf(stderr, "ERROR -> failed to open %s for writing\n", filename);
+		return 1;
+	}
+
+	fprintf(fmap, "{\n  \"fields\": [\"tile\", \"component\", \"resolution\", \"precinct\", \"layer\", \"offset\", \"length\"],\n");
+	fprintf(fmap, "  \"packets\": [");
+	for (i = 0; i < packet_map->nb_packets; ++i) {
+		const opj_packet_range_t *range = &packet_map->packets[i];
+
+		fprintf(fmap, "%s\n    [%u, %u, %u, %u, %u, %" PRIi64 ", %u]", i ? "," : "",
+				range->tileno, range->compno, range->resno, range->precno, range->layno,
+				(OPJ_INT64)range->start_pos, range->length);
+	}
+	fprintf(fmap, "\n  ]\n}\n");
+
+	if (fclose(fmap) != 0){
+		fprintf(stderr, "ERROR -> failed to write %s\n", filename);
+		return 1;
+	}
+	return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 
 /**
@@ -559,6 +614,26 @@ int main(int argc, char *argv[])
 
 		cstr_index = opj_get_cstr_index(l_codec);
 
+		/* the packets are mapped last: their tile-parts are read */
+		if (img_fol.packet_map_file) {
+			opj_packet_map_t* packet_map = NULL;
+
+			if (! opj_get_packet_map(l_codec, l_stream, &packet_map) ||
+				write_packet_map(img_fol.packet_map_file, packet_map)) {
+				fprintf(stderr, "ERROR -> opj_dump: failed to map the packets\n");
+				opj_destroy_packet_map(&packet_map);
+				opj_destroy_cstr_index(&cstr_index);
+				opj_destroy_cstr_info(&cstr_info);
+				opj_stream_destroy(l_stream);
+				opj_destroy_codec(l_codec);
+				opj_image_destroy(image);
+				fclose(fout);
+				free(img_fol.packet_map_file);
+				return EXIT_FAILURE;
+			}
+			opj_destroy_packet_map(&packet_map);
+		}
+
 		/* close the byte stream */
 		opj_stream_destroy(l_stream);
 
@@ -580,6 +655,7 @@ int main(int argc, char *argv[])
 
 	/* Close the output file */
 	fclose(fout);
+	free(img_fol.packet_map_file);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,296 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif /* _WIN32 */
+
+#include "opj_apps_config.h"
+#include "openjpeg.h"
+#include "opj_getopt.h"
+
+#include "format_defs.h"
+
+/* -------------------------------------------------------------------------- */
+
+#define JP2_RFC3745_MAGIC "\x00\x00\x00\x0c\x6a\x50\x20\x20\x0d\x0a\x87\x0a"
+#define JP2_MAGIC "\x0d\x0a\x87\x0a"
+#define J2K_CODESTREAM_MAGIC "\xff\x4f\xff\x51"
+
+typedef struct transcode_parameters {
+	/** input file, a J2K codestream or a JP2 file */
+	char infile[OPJ_PATH_LEN];
+	/** J2K_CFMT or JP2_CFMT */
+	int decod_format;
+	/** output codestream */
+	char outfile[OPJ_PATH_LEN];
+	/** what to change in the codestream */
+	opj_transcode_parameters_t parameters;
+	/** print the informative messages */
+	int verbose;
+} transcode_parameters_t;
+
+/* -------------------------------------------------------------------------- */
+
+static void transcode_help_display(void)
+{
+	fprintf(stdout,"\nThis is the opj_transcode utility from the OpenJPEG project.\n"
+	        "It rewrites a JPEG 2000 codestream with another progression order, fewer\n"
+	        "quality layers, fewer resolutions or other tile-parts, without decoding it.\n"
+	        "It has been compiled against openjp2 library v%s.\n\n", opj_version());
+
+	fprintf(stdout,"Parameters:\n");
+	fprintf(stdout,"-----------\n");
+	fprintf(stdout,"\n");
+	fprintf(stdout,"  -i <compressed file>\n");
+	fprintf(stdout,"    REQUIRED\n");
+	fprintf(stdout,"    J2K codestream or JP2 file to transcode.\n");
+	fprintf(stdout,"  -o <output file>\n");
+	fprintf(stdout,"    REQUIRED\n");
+	fprintf(stdout,"    Transcoded codestream, always written as a J2K codestream.\n");
+	fprintf(stdout,"  -p <LRCP|RLCP|RPCL|PCRL|CPRL>\n");
+	fprintf(stdout,"    OPTIONAL\n");
+	fprintf(stdout,"    Progression order of the output. By default each tile keeps its own.\n");
+	fprintf(stdout,"  -l <number of quality layers>\n");
+	fprintf(stdout,"    OPTIONAL\n");
+	fprintf(stdout,"    Keep only the first layers. By default all of them are kept.\n");
+	fprintf(stdout,"  -r <reduce factor>\n");
+	fprintf(stdout,"    OPTIONAL\n");
+	fprintf(stdout,"    Remove the highest resolution levels: the image is divided by 2^r.\n");
+	fprintf(stdout,"  -TP <R|L|C>\n");
+	fprintf(stdout,"    OPTIONAL\n");
+	fprintf(stdout,"    Start a new tile-part when the resolution (R), the layer (L) or the\n");
+	fprintf(stdout,"    component (C) of the packets changes. By default one tile-part per tile.\n");
+	fprintf(stdout,"  -v\n");
+	fprintf(stdout,"    OPTIONAL\n");
+	fprintf(stdout,"    Enable informative messages.\n");
+	fprintf(stdout,"\n");
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int infile_format(const char *fname)
+{
+	FILE *reader;
+	unsigned char buf[12];
+	size_t l_nb_read;
+
+	reader = fopen(fname, "rb");
+	if (reader == NULL)
+		return -1;
+
+	memset(buf, 0, 12);
+	l_nb_read = fread(buf, 1, 12, reader);
+	fclose(reader);
+	if (l_nb_read != 12)
+		return -1;
+
+	if (memcmp(buf, JP2_RFC3745_MAGIC, 12) == 0 || memcmp(buf, JP2_MAGIC, 4) == 0)
+		return JP2_CFMT;
+	if (memcmp(buf, J2K_CODESTREAM_MAGIC, 4) == 0)
+		return J2K_CFMT;
+	return -1;
+}
+
+static OPJ_PROG_ORDER give_progression(const char *progression)
+{
+	if (strcasecmp(progression, "LRCP") == 0)
+		return OPJ_LRCP;
+	if (strcasecmp(progression, "RLCP") == 0)
+		return OPJ_RLCP;
+	if (strcasecmp(progression, "RPCL") == 0)
+		return OPJ_RPCL;
+	if (strcasecmp(progression, "PCRL") == 0)
+		return OPJ_PCRL;
+	if (strcasecmp(progression, "CPRL") == 0)
+		return OPJ_CPRL;
+	return OPJ_PROG_UNKNOWN;
+}
+
+static int parse_cmdline_transcode(int argc, char **argv, transcode_parameters_t *parameters)
+{
+	opj_option_t long_option[] = {
+		{"TP", REQ_ARG, NULL, 'u'}
+	};
+	const char optlist[] = "i:o:p:l:r:hv";
+	int totlen = sizeof(long_option);
+	int c;
+
+	while ((c = opj_getopt_long(argc, argv, optlist, long_option, totlen)) != -1) {
+		switch (c) {
+		case 'i':
+			parameters->decod_format = infile_format(opj_optarg);
+			if (parameters->decod_format == -1) {
+				fprintf(stderr, "[ERROR] Unknown input file format: %s\n"
+				        "        Known file formats are *.j2k, *.jp2, *.jpc or *.j2c\n", opj_optarg);
+				return 1;
+			}
+			strncpy(parameters->infile, opj_optarg, OPJ_PATH_LEN - 1);
+			break;
+		case 'o':
+			strncpy(parameters->outfile, opj_optarg, OPJ_PATH_LEN - 1);
+			break;
+		case 'p':
+			parameters->parameters.prog_order = give_progression(opj_optarg);
+			if (parameters->parameters.prog_order == OPJ_PROG_UNKNOWN) {
+				fprintf(stderr, "[ERROR] Unrecognized progression order %s [LRCP, RLCP, RPCL, PCRL, CPRL]\n", opj_optarg);
+				return 1;
+			}
+			break;
+		case 'l':
+			if (atoi(opj_optarg) <= 0) {
+				fprintf(stderr, "[ERROR] The number of quality layers must be positive\n");
+				return 1;
+			}
+			parameters->parameters.max_layers = (OPJ_UINT32)atoi(opj_optarg);
+			break;
+		case 'r':
+			if (atoi(opj_optarg) < 0) {
+				fprintf(stderr, "[ERROR] The reduce factor must not be negative\n");
+				return 1;
+			}
+			parameters->parameters.reduce = (OPJ_UINT32)atoi(opj_optarg);
+			break;
+		case 'u':
+			if (strlen(opj_optarg) != 1 || strchr("RLC", opj_optarg[0]) == NULL) {
+				fprintf(stderr, "[ERROR] Unrecognized tile-part flag %s [R, L, C]\n", opj_optarg);
+				return 1;
+			}
+			parameters->parameters.tp_flag = opj_optarg[0];
+			break;
+		case 'v':
+			parameters->verbose = 1;
+			break;
+		case 'h':
+			transcode_help_display();
+			return 1;
+		default:
+			fprintf(stderr, "[WARNING] An invalid option has been ignored.\n");
+			break;
+		}
+	}
+
+	if (parameters->infile[0] == 0 || parameters->outfile[0] == 0) {
+		fprintf(stderr, "[ERROR] Required parameter is missing\n");
+		fprintf(stderr, "Example: %s -i image.jp2 -o image.j2k -p RPCL -l 2\n", argv[0]);
+		fprintf(stderr, "   Help: %s -h\n", argv[0]);
+		return 1;
+	}
+	return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void error_callback(const char *msg, void *client_data)
+{
+	(void)client_data;
+	fprintf(stderr, "[ERROR] %s", msg);
+}
+
+static void warning_callback(const char *msg, void *client_data)
+{
+	(void)client_data;
+	fprintf(stderr, "[WARNING] %s", msg);
+}
+
+static void info_callback(const char *msg, void *client_data)
+{
+	(void)client_data;
+	fprintf(stdout, "[INFO] %s", msg);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+	transcode_parameters_t parameters;
+	opj_dparameters_t dparameters;
+	opj_codec_t * l_codec = NULL;
+	opj_stream_t * l_input = NULL;
+	opj_stream_t * l_output = NULL;
+	opj_image_t * l_image = NULL;
+	int l_result = EXIT_FAILURE;
+
+	memset(&parameters, 0, sizeof(parameters));
+	opj_set_default_transcode_parameters(&parameters.parameters);
+	if (parse_cmdline_transcode(argc, argv, &parameters) == 1) {
+		return EXIT_FAILURE;
+	}
+
+	l_input = opj_stream_create_default_file_stream(parameters.infile, OPJ_STREAM_READ);
+	if (! l_input) {
+		fprintf(stderr, "[ERROR] Failed to create the stream from the file %s\n", parameters.infile);
+		return EXIT_FAILURE;
+	}
+
+	l_codec = opj_create_decompress(parameters.decod_format == JP2_CFMT ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K);
+	if (parameters.verbose) {
+		opj_set_info_handler(l_codec, info_callback, 00);
+	}
+	opj_set_warning_handler(l_codec, warning_callback, 00);
+	opj_set_error_handler(l_codec, error_callback, 00);
+
+	opj_set_default_decoder_parameters(&dparameters);
+	if (! opj_setup_decoder(l_codec, &dparameters)) {
+		fprintf(stderr, "[ERROR] Failed to set up the decoder\n");
+	}
+	else if (! opj_read_header(l_input, l_codec, &l_image)) {
+		fprintf(stderr, "[ERROR] Failed to read the header of %s\n", parameters.infile);
+	}
+	else {
+		l_output = opj_stream_create_default_file_stream(parameters.outfile, OPJ_STREAM_WRITE);
+		if (! l_output) {
+			fprintf(stderr, "[ERROR] Failed to open %s for writing\n", parameters.outfile);
+		}
+		else if (! opj_transcode(l_codec, l_input, l_output, &parameters.parameters)) {
+			fprintf(stderr, "[ERROR] Failed to transcode %s\n", parameters.infile);
+		}
+		else {
+			l_result = EXIT_SUCCESS;
+		}
+	}
+
+	if (l_output) {
+		opj_stream_destroy(l_output);
+	}
+	opj_stream_destroy(l_input);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+
+	if (l_result == EXIT_SUCCESS && parameters.verbose) {
+		fprintf(stdout, "[INFO] Generated outfile %s\n", parameters.outfile);
+	}
+	return l_result;
+}
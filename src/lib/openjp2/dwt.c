@@ -78,6 +78,9 @@ static const OPJ_FLOAT32 opj_dwt_delta = -0.443506852f; /*  -3633 */
 static const OPJ_FLOAT32 opj_K      = 1.230174105f; /*  10078 */
 static const OPJ_FLOAT32 opj_c13318 = 1.625732422f;
 
+/** Rows synthesized above and below the rows wanted at each resolution level by opj_dwt_decode_rows */
+#define OPJ_DWT_ROWS_MARGIN 4
+
 /*@}*/
 
 /**
@@ -95,7 +98,7 @@ static void opj_dwt_deinterleave_h(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ
 /**
 Forward lazy transform (vertical)
 */
-static void opj_dwt_deinterleave_v(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 x, OPJ_INT32 cas);
+static void opj_dwt_deinterleave_v(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_SIZE_T x, OPJ_INT32 cas);
 /**
 Inverse lazy transform (horizontal)
 */
@@ -103,7 +106,7 @@ static void opj_dwt_interleave_h(opj_dwt_t* h, OPJ_INT32 *a);
 /**
 Inverse lazy transform (vertical)
 */
-static void opj_dwt_interleave_v(opj_dwt_t* v, OPJ_INT32 *a, OPJ_INT32 x);
+static void opj_dwt_interleave_v(opj_dwt_t* v, OPJ_INT32 *a, OPJ_SIZE_T x);
 /**
 Forward 5-3 wavelet transform in 1-D
 */
@@ -125,6 +128,10 @@ static void opj_dwt_encode_stepsize(OPJ_INT32 stepsize, OPJ_INT32 numbps, opj_st
 Inverse wavelet transform in 2-D.
 */
 static OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 i, DWT1DFN fn);
+/**
+Inverse wavelet transform in 2-D of one resolution level, stored with a line stride of w.
+*/
+static void opj_dwt_decode_level(opj_dwt_t* h, opj_dwt_t* v, OPJ_INT32* restrict tiledp, OPJ_SIZE_T w, OPJ_UINT32 rw, OPJ_UINT32 rh, DWT1DFN dwt_1D);
 
 static OPJ_BOOL opj_dwt_encode_procedure(	opj_tcd_tilecomp_t * tilec,
 										    void (*p_function)(OPJ_INT32 *, OPJ_INT32,OPJ_INT32,OPJ_INT32) );
@@ -136,9 +143,11 @@ static OPJ_UINT32 opj_dwt_max_resolution(opj_tcd_resolution_t* restrict r, OPJ_U
 /* </summary>                            */
 static void opj_v4dwt_decode(opj_v4dwt_t* restrict dwt);
 
-static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restrict a, OPJ_INT32 x, OPJ_INT32 size);
+static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restrict a, OPJ_SIZE_T x, OPJ_SIZE_T size);
 
-static void opj_v4dwt_interleave_v(opj_v4dwt_t* restrict v , OPJ_FLOAT32* restrict a , OPJ_INT32 x, OPJ_INT32 nb_elts_read);
+static void opj_v4dwt_interleave_v(opj_v4dwt_t* restrict v , OPJ_FLOAT32* restrict a , OPJ_SIZE_T x, OPJ_INT32 nb_elts_read);
+
+static void opj_v4dwt_decode_level(opj_v4dwt_t* h, opj_v4dwt_t* v, OPJ_FLOAT32* restrict data, OPJ_SIZE_T w, OPJ_SIZE_T bufsize, OPJ_UINT32 rw, OPJ_UINT32 rh);
 
 #ifdef __SSE__
 static void opj_v4dwt_decode_step1_sse(opj_v4_t* w, OPJ_INT32 count, const __m128 c);
@@ -215,7 +224,7 @@ static void opj_dwt_deinterleave_h(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ
 /* <summary>                             */  
 /* Forward lazy transform (vertical).    */
 /* </summary>                            */ 
-static void opj_dwt_deinterleave_v(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_INT32 x, OPJ_INT32 cas) {
+static void opj_dwt_deinterleave_v(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ_INT32 sn, OPJ_SIZE_T x, OPJ_INT32 cas) {
     OPJ_INT32 i = sn;
 	OPJ_INT32 * l_dest = b;
 	OPJ_INT32 * l_src = a+cas;
@@ -226,7 +235,7 @@ static void opj_dwt_deinterleave_v(OPJ_INT32 *a, OPJ_INT32 *b, OPJ_INT32 dn, OPJ
 		l_src += 2;
 		} /* b[i*x]=a[2*i+cas]; */
 
-	l_dest = b + sn * x;
+	l_dest = b + (OPJ_SIZE_T)sn * x;
 	l_src = a + 1 - cas;
 	
 	i = dn;
@@ -260,7 +269,7 @@ static void opj_dwt_interleave_h(opj_dwt_t* h, OPJ_INT32 *a) {
 /* <summary>                             */  
 /* Inverse lazy transform (vertical).    */
 /* </summary>                            */ 
-static void opj_dwt_interleave_v(opj_dwt_t* v, OPJ_INT32 *a, OPJ_INT32 x) {
+static void opj_dwt_interleave_v(opj_dwt_t* v, OPJ_INT32 *a, OPJ_SIZE_T x) {
     OPJ_INT32 *ai = a;
     OPJ_INT32 *bi = v->mem + v->cas;
     OPJ_INT32  i = v->sn;
@@ -269,7 +278,7 @@ static void opj_dwt_interleave_v(opj_dwt_t* v, OPJ_INT32 *a, OPJ_INT32 x) {
 	  bi += 2;
 	  ai += x;
     }
-    ai = a + (v->sn * x);
+    ai = a + ((OPJ_SIZE_T)v->sn * x);
     bi = v->mem + 1 - v->cas;
     i = v->dn ;
     while( i-- ) {
@@ -391,7 +400,8 @@ static INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void
 	OPJ_INT32 *a = 00;
 	OPJ_INT32 *aj = 00;
 	OPJ_INT32 *bj = 00;
-	OPJ_INT32 w, l;
+	OPJ_SIZE_T w;
+	OPJ_INT32 l;
 
 	OPJ_INT32 rw;			/* width of the resolution level computed   */
 	OPJ_INT32 rh;			/* height of the resolution level computed  */
@@ -400,7 +410,7 @@ static INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void
 	opj_tcd_resolution_t * l_cur_res = 0;
 	opj_tcd_resolution_t * l_last_res = 0;
 
-	w = tilec->x1-tilec->x0;
+	w = (OPJ_SIZE_T)(tilec->x1-tilec->x0);
 	l = (OPJ_INT32)tilec->numresolutions-1;
 	a = tilec->data;
 
@@ -434,7 +444,7 @@ static INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void
 		for (j = 0; j < rw; ++j) {
 			aj = a + j;
 			for (k = 0; k < rh; ++k) {
-				bj[k] = aj[k*w];
+				bj[k] = aj[(OPJ_SIZE_T)k*w];
 			}
 
 			(*p_function) (bj, dn, sn, cas_col);
@@ -446,7 +456,7 @@ static INLINE OPJ_BOOL opj_dwt_encode_procedure(opj_tcd_tilecomp_t * tilec,void
 		dn = rw - rw1;
 
 		for (j = 0; j < rh; j++) {
-			aj = a + j * w;
+			aj = a + (OPJ_SIZE_T)j * w;
 			for (k = 0; k < rw; k++)  bj[k] = aj[k];
 			(*p_function) (bj, dn, sn, cas_row);
 			opj_dwt_deinterleave_h(bj, aj, dn, sn, cas_row);
@@ -566,7 +576,7 @@ static OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres
 	OPJ_UINT32 rw = (OPJ_UINT32)(tr->x1 - tr->x0);	/* width of the resolution level computed */
 	OPJ_UINT32 rh = (OPJ_UINT32)(tr->y1 - tr->y0);	/* height of the resolution level computed */
 
-	OPJ_UINT32 w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+	OPJ_SIZE_T w = (OPJ_SIZE_T)(tilec->x1 - tilec->x0);
 
 	h.mem = (OPJ_INT32*)
 	opj_aligned_malloc(opj_dwt_max_resolution(tr, numres) * sizeof(OPJ_INT32));
@@ -578,9 +588,6 @@ static OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres
 	v.mem = h.mem;
 
 	while( --numres) {
-		OPJ_INT32 * restrict tiledp = tilec->data;
-		OPJ_UINT32 j;
-
 		++tr;
 		h.sn = (OPJ_INT32)rw;
 		v.sn = (OPJ_INT32)rh;
@@ -591,38 +598,47 @@ static OPJ_BOOL opj_dwt_decode_tile(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres
 		h.dn = (OPJ_INT32)(rw - (OPJ_UINT32)h.sn);
 		h.cas = tr->x0 % 2;
 
-		for(j = 0; j < rh; ++j) {
-			opj_dwt_interleave_h(&h, &tiledp[j*w]);
-			(dwt_1D)(&h);
-			memcpy(&tiledp[j*w], h.mem, rw * sizeof(OPJ_INT32));
-		}
-
 		v.dn = (OPJ_INT32)(rh - (OPJ_UINT32)v.sn);
 		v.cas = tr->y0 % 2;
 
-		for(j = 0; j < rw; ++j){
-			OPJ_UINT32 k;
-			opj_dwt_interleave_v(&v, &tiledp[j], (OPJ_INT32)w);
-			(dwt_1D)(&v);
-			for(k = 0; k < rh; ++k) {
-				tiledp[k * w + j] = v.mem[k];
-			}
-		}
+		opj_dwt_decode_level(&h, &v, tilec->data, w, rw, rh, dwt_1D);
 	}
 	opj_aligned_free(h.mem);
 	return OPJ_TRUE;
 }
 
-static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restrict a, OPJ_INT32 x, OPJ_INT32 size){
+/* <summary>                                             */
+/* Inverse wavelet transform in 2-D of a resolution level. */
+/* </summary>                                            */
+static void opj_dwt_decode_level(opj_dwt_t* h, opj_dwt_t* v, OPJ_INT32* restrict tiledp, OPJ_SIZE_T w, OPJ_UINT32 rw, OPJ_UINT32 rh, DWT1DFN dwt_1D) {
+	OPJ_UINT32 j;
+
+	for(j = 0; j < rh; ++j) {
+		opj_dwt_interleave_h(h, &tiledp[(OPJ_SIZE_T)j*w]);
+		(dwt_1D)(h);
+		memcpy(&tiledp[(OPJ_SIZE_T)j*w], h->mem, rw * sizeof(OPJ_INT32));
+	}
+
+	for(j = 0; j < rw; ++j){
+		OPJ_UINT32 k;
+		opj_dwt_interleave_v(v, &tiledp[j], w);
+		(dwt_1D)(v);
+		for(k = 0; k < rh; ++k) {
+			tiledp[(OPJ_SIZE_T)k * w + j] = v->mem[k];
+		}
+	}
+}
+
+static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restrict a, OPJ_SIZE_T x, OPJ_SIZE_T size){
 	OPJ_FLOAT32* restrict bi = (OPJ_FLOAT32*) (w->wavelet + w->cas);
 	OPJ_INT32 count = w->sn;
 	OPJ_INT32 i, k;
 
 	for(k = 0; k < 2; ++k){
-		if ( count + 3 * x < size && ((size_t) a & 0x0f) == 0 && ((size_t) bi & 0x0f) == 0 && (x & 0x0f) == 0 ) {
+		if ( (OPJ_SIZE_T)count + 3 * x < size && ((size_t) a & 0x0f) == 0 && ((size_t) bi & 0x0f) == 0 && (x & 0x0f) == 0 ) {
 			/* Fast code path */
 			for(i = 0; i < count; ++i){
-				OPJ_INT32 j = i;
+				OPJ_SIZE_T j = (OPJ_SIZE_T)i;
 				bi[i*8    ] = a[j];
 				j += x;
 				bi[i*8 + 1] = a[j];
@@ -635,7 +651,7 @@ static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restric
 		else {
 			/* Slow code path */
 			for(i = 0; i < count; ++i){
-				OPJ_INT32 j = i;
+				OPJ_SIZE_T j = (OPJ_SIZE_T)i;
 				bi[i*8    ] = a[j];
 				j += x;
 				if(j >= size) continue;
@@ -651,24 +667,24 @@ static void opj_v4dwt_interleave_h(opj_v4dwt_t* restrict w, OPJ_FLOAT32* restric
 
 		bi = (OPJ_FLOAT32*) (w->wavelet + 1 - w->cas);
 		a += w->sn;
-		size -= w->sn;
+		size -= (OPJ_SIZE_T)w->sn;
 		count = w->dn;
 	}
 }
 
-static void opj_v4dwt_interleave_v(opj_v4dwt_t* restrict v , OPJ_FLOAT32* restrict a , OPJ_INT32 x, OPJ_INT32 nb_elts_read){
+static void opj_v4dwt_interleave_v(opj_v4dwt_t* restrict v , OPJ_FLOAT32* restrict a , OPJ_SIZE_T x, OPJ_INT32 nb_elts_read){
 	opj_v4_t* restrict bi = v->wavelet + v->cas;
 	OPJ_INT32 i;
 
 	for(i = 0; i < v->sn; ++i){
-		memcpy(&bi[i*2], &a[i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
+		memcpy(&bi[i*2], &a[(OPJ_SIZE_T)i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
 	}
 
-	a += v->sn * x;
+	a += (OPJ_SIZE_T)v->sn * x;
 	bi = v->wavelet + 1 - v->cas;
 
 	for(i = 0; i < v->dn; ++i){
-		memcpy(&bi[i*2], &a[i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
+		memcpy(&bi[i*2], &a[(OPJ_SIZE_T)i*x], (size_t)nb_elts_read * sizeof(OPJ_FLOAT32));
 	}
 }
 
@@ -840,7 +856,7 @@ OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numr
 	OPJ_UINT32 rw = (OPJ_UINT32)(res->x1 - res->x0);	/* width of the resolution level computed */
 	OPJ_UINT32 rh = (OPJ_UINT32)(res->y1 - res->y0);	/* height of the resolution level computed */
 
-	OPJ_UINT32 w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+	OPJ_SIZE_T w = (OPJ_SIZE_T)(tilec->x1 - tilec->x0);
 
 	h.wavelet = (opj_v4_t*) opj_aligned_malloc((opj_dwt_max_resolution(res, numres)+5) * sizeof(opj_v4_t));
 	if (!h.wavelet) {
@@ -850,9 +866,7 @@ OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numr
 	v.wavelet = h.wavelet;
 
 	while( --numres) {
-		OPJ_FLOAT32 * restrict aj = (OPJ_FLOAT32*) tilec->data;
-		OPJ_UINT32 bufsize = (OPJ_UINT32)((tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0));
-		OPJ_INT32 j;
+		OPJ_SIZE_T bufsize = (OPJ_SIZE_T)(tilec->x1 - tilec->x0) * (OPJ_SIZE_T)(tilec->y1 - tilec->y0);
 
 		h.sn = (OPJ_INT32)rw;
 		v.sn = (OPJ_INT32)rh;
@@ -865,66 +879,251 @@ OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numr
 		h.dn = (OPJ_INT32)(rw - (OPJ_UINT32)h.sn);
 		h.cas = res->x0 % 2;
 
-		for(j = (OPJ_INT32)rh; j > 3; j -= 4) {
-			OPJ_INT32 k;
-			opj_v4dwt_interleave_h(&h, aj, (OPJ_INT32)w, (OPJ_INT32)bufsize);
-			opj_v4dwt_decode(&h);
+		v.dn = (OPJ_INT32)(rh - (OPJ_UINT32)v.sn);
+		v.cas = res->y0 % 2;
 
-			for(k = (OPJ_INT32)rw; --k >= 0;){
-				aj[k               ] = h.wavelet[k].f[0];
-				aj[k+(OPJ_INT32)w  ] = h.wavelet[k].f[1];
-				aj[k+(OPJ_INT32)w*2] = h.wavelet[k].f[2];
-				aj[k+(OPJ_INT32)w*3] = h.wavelet[k].f[3];
-			}
+		opj_v4dwt_decode_level(&h, &v, (OPJ_FLOAT32*) tilec->data, w, bufsize, rw, rh);
+	}
+
+	opj_aligned_free(h.wavelet);
+	return OPJ_TRUE;
+}
 
-			aj += w*4;
-			bufsize -= w*4;
+/* <summary>                                                   */
+/* Inverse 9-7 wavelet transform in 2-D of a resolution level. */
+/* </summary>                                                  */
+static void opj_v4dwt_decode_level(opj_v4dwt_t* h, opj_v4dwt_t* v, OPJ_FLOAT32* restrict data, OPJ_SIZE_T w, OPJ_SIZE_T bufsize, OPJ_UINT32 rw, OPJ_UINT32 rh)
+{
+	OPJ_FLOAT32 * restrict aj = data;
+	OPJ_INT32 j;
+
+	for(j = (OPJ_INT32)rh; j > 3; j -= 4) {
+		OPJ_INT32 k;
+		opj_v4dwt_interleave_h(h, aj, w, bufsize);
+		opj_v4dwt_decode(h);
+
+		for(k = (OPJ_INT32)rw; --k >= 0;){
+			aj[k                  ] = h->wavelet[k].f[0];
+			aj[(OPJ_SIZE_T)k+w    ] = h->wavelet[k].f[1];
+			aj[(OPJ_SIZE_T)k+w*2  ] = h->wavelet[k].f[2];
+			aj[(OPJ_SIZE_T)k+w*3  ] = h->wavelet[k].f[3];
 		}
 
-		if (rh & 0x03) {
-			OPJ_INT32 k;
-			j = rh & 0x03;
-			opj_v4dwt_interleave_h(&h, aj, (OPJ_INT32)w, (OPJ_INT32)bufsize);
-			opj_v4dwt_decode(&h);
-			for(k = (OPJ_INT32)rw; --k >= 0;){
-				switch(j) {
-					case 3: aj[k+(OPJ_INT32)w*2] = h.wavelet[k].f[2];
-					case 2: aj[k+(OPJ_INT32)w  ] = h.wavelet[k].f[1];
-					case 1: aj[k               ] = h.wavelet[k].f[0];
-				}
+		aj += w*4;
+		bufsize -= w*4;
+	}
+
+	if (rh & 0x03) {
+		OPJ_INT32 k;
+		j = rh & 0x03;
+		opj_v4dwt_interleave_h(h, aj, w, bufsize);
+		opj_v4dwt_decode(h);
+		for(k = (OPJ_INT32)rw; --k >= 0;){
+			switch(j) {
+				case 3: aj[(OPJ_SIZE_T)k+w*2  ] = h->wavelet[k].f[2];
+				case 2: aj[(OPJ_SIZE_T)k+w    ] = h->wavelet[k].f[1];
+				case 1: aj[k                  ] = h->wavelet[k].f[0];
 			}
 		}
+	}
 
-		v.dn = (OPJ_INT32)(rh - (OPJ_UINT32)v.sn);
-		v.cas = res->y0 % 2;
+	aj = data;
+	for(j = (OPJ_INT32)rw; j > 3; j -= 4){
+		OPJ_UINT32 k;
 
-		aj = (OPJ_FLOAT32*) tilec->data;
-		for(j = (OPJ_INT32)rw; j > 3; j -= 4){
-			OPJ_UINT32 k;
+		opj_v4dwt_interleave_v(v, aj, w, 4);
+		opj_v4dwt_decode(v);
 
-			opj_v4dwt_interleave_v(&v, aj, (OPJ_INT32)w, 4);
-			opj_v4dwt_decode(&v);
+		for(k = 0; k < rh; ++k){
+			memcpy(&aj[(OPJ_SIZE_T)k*w], &v->wavelet[k], 4 * sizeof(OPJ_FLOAT32));
+		}
+		aj += 4;
+	}
 
-			for(k = 0; k < rh; ++k){
-				memcpy(&aj[k*w], &v.wavelet[k], 4 * sizeof(OPJ_FLOAT32));
-			}
-			aj += 4;
+	if (rw & 0x03){
+		OPJ_UINT32 k;
+
+		j = rw & 0x03;
+
+		opj_v4dwt_interleave_v(v, aj, w, j);
+		opj_v4dwt_decode(v);
+
+		for(k = 0; k < rh; ++k){
+			memcpy(&aj[(OPJ_SIZE_T)k*w], &v->wavelet[k], (size_t)j * sizeof(OPJ_FLOAT32));
 		}
+	}
+}
 
-		if (rw & 0x03){
-			OPJ_UINT32 k;
+/* <summary>                                          */
+/* Inverse wavelet transform in 2-D of some rows.     */
+/* </summary>                                         */
+OPJ_BOOL opj_dwt_decode_rows(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, OPJ_BOOL p_real,
+                             OPJ_UINT32 p_y0, OPJ_UINT32 p_y1, OPJ_INT32 * p_dest,
+                             opj_dwt_band_rows_fn p_band_rows, void * p_user_data)
+{
+	/* rows of each resolution level needed by the level above, relative to the top of the level */
+	OPJ_UINT32 l_tgt_y0[OPJ_J2K_MAXRLVLS], l_tgt_y1[OPJ_J2K_MAXRLVLS];
+	/* rows of each resolution level synthesized, relative to the top of the level */
+	OPJ_UINT32 l_win_y0[OPJ_J2K_MAXRLVLS];
+	opj_tcd_resolution_t * l_res = tilec->resolutions;
+	OPJ_UINT32 l_top = numres - 1;
+	OPJ_UINT32 l_rw = (OPJ_UINT32)(l_res[0].x1 - l_res[0].x0);
+	OPJ_UINT32 l_nb_rows, r, i;
+	OPJ_INT32 * l_low = 00;
+	OPJ_INT32 * l_win = 00;
+	const OPJ_INT32 * l_band;
+	opj_dwt_t h, v;
+	opj_v4dwt_t h4, v4;
+
+	if (numres == 0 || numres > OPJ_J2K_MAXRLVLS) {
+		return OPJ_FALSE;
+	}
 
-			j = rw & 0x03;
+	/* the rows of a resolution level are synthesized from the rows of the level below */
+	/* plus a margin, so that the lifting steps see the same neighbours as for the whole tile */
+	l_tgt_y0[l_top] = p_y0;
+	l_tgt_y1[l_top] = p_y1;
+	for (r = l_top; r > 0; --r) {
+		OPJ_UINT32 l_rh = (OPJ_UINT32)(l_res[r].y1 - l_res[r].y0);
+		OPJ_UINT32 l_a0, l_a1;
+
+		l_win_y0[r] = (l_tgt_y0[r] > OPJ_DWT_ROWS_MARGIN) ? l_tgt_y0[r] - OPJ_DWT_ROWS_MARGIN : 0;
+		l_a0 = (OPJ_UINT32)l_res[r].y0 + l_win_y0[r];
+		l_a1 = (OPJ_UINT32)l_res[r].y0 + opj_uint_min(l_tgt_y1[r] + OPJ_DWT_ROWS_MARGIN, l_rh);
+		l_tgt_y0[r-1] = (l_a0 + 1) / 2 - (OPJ_UINT32)l_res[r-1].y0;
+		l_tgt_y1[r-1] = (l_a1 + 1) / 2 - (OPJ_UINT32)l_res[r-1].y0;
+	}
 
-			opj_v4dwt_interleave_v(&v, aj, (OPJ_INT32)w, j);
-			opj_v4dwt_decode(&v);
+	h.mem = 00;
+	h4.wavelet = 00;
+	if (l_top > 0) {
+		if (p_real) {
+			h4.wavelet = (opj_v4_t*) opj_aligned_malloc((opj_dwt_max_resolution(l_res, numres)+5) * sizeof(opj_v4_t));
+			if (! h4.wavelet) {
+				return OPJ_FALSE;
+			}
+			v4.wavelet = h4.wavelet;
+		}
+		else {
+			h.mem = (OPJ_INT32*) opj_aligned_malloc(opj_dwt_max_resolution(l_res, numres) * sizeof(OPJ_INT32));
+			if (! h.mem) {
+				return OPJ_FALSE;
+			}
+			v.mem = h.mem;
+		}
+	}
 
-			for(k = 0; k < rh; ++k){
-				memcpy(&aj[k*w], &v.wavelet[k], (size_t)j * sizeof(OPJ_FLOAT32));
+	/* lowest resolution level : rows of the LL band */
+	l_nb_rows = l_tgt_y1[0] - l_tgt_y0[0];
+	l_low = (OPJ_INT32*) opj_aligned_malloc(opj_size_max((OPJ_SIZE_T)l_rw * l_nb_rows, 1) * sizeof(OPJ_INT32));
+	if (! l_low) {
+		opj_aligned_free(h.mem);
+		opj_aligned_free(h4.wavelet);
+		return OPJ_FALSE;
+	}
+	if (l_rw && l_nb_rows) {
+		l_band = p_band_rows(p_user_data, 0, 0, l_tgt_y0[0], l_tgt_y1[0]);
+		if (! l_band) {
+			opj_aligned_free(l_low);
+			opj_aligned_free(h.mem);
+			opj_aligned_free(h4.wavelet);
+			return OPJ_FALSE;
+		}
+		memcpy(l_low, l_band, (OPJ_SIZE_T)l_rw * l_nb_rows * sizeof(OPJ_INT32));
+	}
+	l_win_y0[0] = l_tgt_y0[0];
+
+	for (r = 1; r <= l_top; ++r) {
+		OPJ_UINT32 l_rw_low = l_rw;
+		OPJ_UINT32 l_rh = (OPJ_UINT32)(l_res[r].y1 - l_res[r].y0);
+		OPJ_UINT32 l_a0 = (OPJ_UINT32)l_res[r].y0 + l_win_y0[r];
+		OPJ_UINT32 l_a1 = (OPJ_UINT32)l_res[r].y0 + opj_uint_min(l_tgt_y1[r] + OPJ_DWT_ROWS_MARGIN, l_rh);
+		OPJ_UINT32 l_sn = l_tgt_y1[r-1] - l_tgt_y0[r-1];
+		OPJ_UINT32 l_dn = l_a1 / 2 - l_a0 / 2;
+		OPJ_UINT32 l_high_y0 = l_a0 / 2 - (OPJ_UINT32)l_res[r].y0 / 2;
+		const OPJ_INT32 * l_low_rows = l_low + (OPJ_SIZE_T)(l_tgt_y0[r-1] - l_win_y0[r-1]) * l_rw_low;
+
+		l_rw = (OPJ_UINT32)(l_res[r].x1 - l_res[r].x0);
+
+		l_win = (OPJ_INT32*) opj_aligned_malloc(opj_size_max((OPJ_SIZE_T)l_rw * (l_sn + l_dn), 1) * sizeof(OPJ_INT32));
+		if (! l_win) {
+			opj_aligned_free(l_low);
+			opj_aligned_free(h.mem);
+			opj_aligned_free(h4.wavelet);
+			return OPJ_FALSE;
+		}
+
+		/* same layout as the tile : the low rows [L | HL] followed by the high rows [LH | HH] */
+		if (l_sn) {
+			l_band = 00;
+			if (l_rw > l_rw_low) {
+				l_band = p_band_rows(p_user_data, r, 0, l_tgt_y0[r-1], l_tgt_y1[r-1]);
+				if (! l_band) {
+					break;
+				}
 			}
+			for (i = 0; i < l_sn; ++i) {
+				memcpy(l_win + (OPJ_SIZE_T)i * l_rw, l_low_rows + (OPJ_SIZE_T)i * l_rw_low, l_rw_low * sizeof(OPJ_INT32));
+				if (l_band) {
+					memcpy(l_win + (OPJ_SIZE_T)i * l_rw + l_rw_low, l_band + (OPJ_SIZE_T)i * (l_rw - l_rw_low), (l_rw - l_rw_low) * sizeof(OPJ_INT32));
+				}
+			}
+		}
+		if (l_dn) {
+			if (l_rw_low) {
+				l_band = p_band_rows(p_user_data, r, 1, l_high_y0, l_high_y0 + l_dn);
+				if (! l_band) {
+					break;
+				}
+				for (i = 0; i < l_dn; ++i) {
+					memcpy(l_win + (OPJ_SIZE_T)(l_sn + i) * l_rw, l_band + (OPJ_SIZE_T)i * l_rw_low, l_rw_low * sizeof(OPJ_INT32));
+				}
+			}
+			if (l_rw > l_rw_low) {
+				l_band = p_band_rows(p_user_data, r, 2, l_high_y0, l_high_y0 + l_dn);
+				if (! l_band) {
+					break;
+				}
+				for (i = 0; i < l_dn; ++i) {
+					memcpy(l_win + (OPJ_SIZE_T)(l_sn + i) * l_rw + l_rw_low, l_band + (OPJ_SIZE_T)i * (l_rw - l_rw_low), (l_rw - l_rw_low) * sizeof(OPJ_INT32));
+				}
+			}
+		}
+
+		if (p_real) {
+			h4.sn = (OPJ_INT32)l_rw_low;
+			h4.dn = (OPJ_INT32)(l_rw - l_rw_low);
+			h4.cas = l_res[r].x0 % 2;
+			v4.sn = (OPJ_INT32)l_sn;
+			v4.dn = (OPJ_INT32)l_dn;
+			v4.cas = (OPJ_INT32)(l_a0 % 2);
+			opj_v4dwt_decode_level(&h4, &v4, (OPJ_FLOAT32*) l_win, l_rw, (OPJ_SIZE_T)l_rw * (l_sn + l_dn), l_rw, l_sn + l_dn);
+		}
+		else {
+			h.sn = (OPJ_INT32)l_rw_low;
+			h.dn = (OPJ_INT32)(l_rw - l_rw_low);
+			h.cas = l_res[r].x0 % 2;
+			v.sn = (OPJ_INT32)l_sn;
+			v.dn = (OPJ_INT32)l_dn;
+			v.cas = (OPJ_INT32)(l_a0 % 2);
+			opj_dwt_decode_level(&h, &v, l_win, l_rw, l_rw, l_sn + l_dn, &opj_dwt_decode_1);
 		}
+
+		opj_aligned_free(l_low);
+		l_low = l_win;
+		l_win = 00;
 	}
 
-	opj_aligned_free(h.wavelet);
+	opj_aligned_free(h.mem);
+	opj_aligned_free(h4.wavelet);
+	if (l_win) {
+		/* a band could not be read */
+		opj_aligned_free(l_win);
+		opj_aligned_free(l_low);
+		return OPJ_FALSE;
+	}
+
+	memcpy(p_dest, l_low + (OPJ_SIZE_T)(p_y0 - l_win_y0[l_top]) * l_rw, (OPJ_SIZE_T)l_rw * (p_y1 - p_y0) * sizeof(OPJ_INT32));
+	opj_aligned_free(l_low);
 	return OPJ_TRUE;
 }
@@ -95,6 +95,39 @@ Apply an irreversible inverse DWT transform to a component of an image.
 */
 OPJ_BOOL opj_dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, OPJ_UINT32 numres);
 
+/**
+Give some rows of a band of a tile component to opj_dwt_decode_rows.
+@param p_user_data User data given to opj_dwt_decode_rows
+@param p_resno Resolution level of the band
+@param p_bandno Index of the band in the resolution level (the LL band for the lowest level, 0 for HL, 1 for LH, 2 for HH otherwise)
+@param p_y0 First row wanted, relative to the top of the band
+@param p_y1 Row following the last row wanted, relative to the top of the band
+@return Returns the coefficients of the row p_y0, followed by the next rows with a stride of the band width, NULL if they cannot be decoded
+*/
+typedef const OPJ_INT32 * (* opj_dwt_band_rows_fn) (void * p_user_data,
+                                                     OPJ_UINT32 p_resno,
+                                                     OPJ_UINT32 p_bandno,
+                                                     OPJ_UINT32 p_y0,
+                                                     OPJ_UINT32 p_y1);
+
+/**
+Inverse wavelet transform in 2-D of some rows of a tile component.
+Only the rows of the bands the wanted rows depend on are asked to p_band_rows, so that the
+whole tile component never needs to be decoded at once. The result is the same as the one of
+opj_dwt_decode or opj_dwt_decode_real.
+@param tilec Tile component information (current tile), its data is not used
+@param numres Number of resolution levels to decode
+@param p_real OPJ_TRUE for the irreversible 9-7 DWT, OPJ_FALSE for the reversible 5-3 DWT
+@param p_y0 First row to decode, relative to the top of the resolution level numres - 1
+@param p_y1 Row following the last row to decode
+@param p_dest Decoded rows, with a stride of the width of the resolution level
+@param p_band_rows Function giving the rows of the bands
+@param p_user_data User data given to p_band_rows
+*/
+OPJ_BOOL opj_dwt_decode_rows(opj_tcd_tilecomp_t* tilec, OPJ_UINT32 numres, OPJ_BOOL p_real,
+                             OPJ_UINT32 p_y0, OPJ_UINT32 p_y1, OPJ_INT32 * p_dest,
+                             opj_dwt_band_rows_fn p_band_rows, void * p_user_data);
+
 /**
 Get the gain of a subband for the irreversible 9-7 DWT.
 @param orient Number that identifies the subband (0->LL, 1->HL, 2->LH, 3->HH)
@@ -36,7 +36,7 @@ opj_image_t* opj_image_create0(void) {
 	return image;
 }
 
-opj_image_t* OPJ_CALLCONV opj_image_create(OPJ_UINT32 numcmpts, opj_image_cmptparm_t *cmptparms, OPJ_COLOR_SPACE clrspc) {
+static opj_image_t* opj_image_create_ex(OPJ_UINT32 numcmpts, opj_image_cmptparm_t *cmptparms, OPJ_COLOR_SPACE clrspc, OPJ_BOOL p_native) {
 	OPJ_UINT32 compno;
 	opj_image_t *image = NULL;
 
@@ -64,8 +64,16 @@ opj_image_t* OPJ_CALLCONV opj_image_create(OPJ_UINT32 numcmpts, opj_image_cmptpa
 			comp->prec = cmptparms[compno].prec;
 			comp->bpp = cmptparms[compno].bpp;
 			comp->sgnd = cmptparms[compno].sgnd;
-			comp->data = (OPJ_INT32*) opj_calloc(comp->w * comp->h, sizeof(OPJ_INT32));
-			if(!comp->data) {
+			if (p_native) {
+				comp->native_size = opj_image_native_size(comp->prec);
+			}
+			if (comp->native_size) {
+				comp->native_data = opj_image_data_calloc((OPJ_SIZE_T)comp->w * comp->h, comp->native_size);
+			}
+			else {
+				comp->data = (OPJ_INT32*) opj_image_data_calloc((OPJ_SIZE_T)comp->w * comp->h, sizeof(OPJ_INT32));
+			}
+			if(!comp->data && !comp->native_data) {
 				/* TODO replace with event manager, breaks API */
 				/* fprintf(stderr,"Unable to allocate memory for image.\n"); */
 				opj_image_destroy(image);
@@ -77,6 +85,27 @@ opj_image_t* OPJ_CALLCONV opj_image_create(OPJ_UINT32 numcmpts, opj_image_cmptpa
 	return image;
 }
 
+opj_image_t* OPJ_CALLCONV opj_image_create(OPJ_UINT32 numcmpts, opj_image_cmptparm_t *cmptparms, OPJ_COLOR_SPACE clrspc) {
+	return opj_image_create_ex(numcmpts, cmptparms, clrspc, OPJ_FALSE);
+}
+
+opj_image_t* OPJ_CALLCONV opj_image_create_native(OPJ_UINT32 numcmpts, opj_image_cmptparm_t *cmptparms, OPJ_COLOR_SPACE clrspc) {
+	return opj_image_create_ex(numcmpts, cmptparms, clrspc, OPJ_TRUE);
+}
+
+OPJ_UINT32 opj_image_native_size(OPJ_UINT32 p_prec) {
+	if (p_prec == 0) {
+		return 0;
+	}
+	if (p_prec <= 8) {
+		return 1;
+	}
+	if (p_prec <= 16) {
+		return 2;
+	}
+	return 0;
+}
+
 void OPJ_CALLCONV opj_image_destroy(opj_image_t *image) {
 	if(image) {
 		if(image->comps) {
@@ -86,14 +115,17 @@ void OPJ_CALLCONV opj_image_destroy(opj_image_t *image) {
 			for(compno = 0; compno < image->numcomps; compno++) {
 				opj_image_comp_t *image_comp = &(image->comps[compno]);
 				if(image_comp->data) {
-					opj_free(image_comp->data);
+					opj_image_data_free(image_comp->data);
+				}
+				if(image_comp->native_data) {
+					opj_image_data_free(image_comp->native_data);
 				}
 			}
 			opj_free(image->comps);
 		}
 
 		if(image->icc_profile_buf) {
-			opj_free(image->icc_profile_buf);
+			opj_image_data_free(image->icc_profile_buf);
 		}
 
 		opj_free(image);
@@ -162,7 +194,10 @@ void opj_copy_image_header(const opj_image_t* p_image_src, opj_image_t* p_image_
 		for(compno = 0; compno < p_image_dest->numcomps; compno++) {
 			opj_image_comp_t *image_comp = &(p_image_dest->comps[compno]);
 			if(image_comp->data) {
-				opj_free(image_comp->data);
+				opj_image_data_free(image_comp->data);
+			}
+			if(image_comp->native_data) {
+				opj_image_data_free(image_comp->native_data);
 			}
 		}
 		opj_free(p_image_dest->comps);
@@ -183,13 +218,14 @@ void opj_copy_image_header(const opj_image_t* p_image_src, opj_image_t* p_image_
 				&(p_image_src->comps[compno]),
 				sizeof(opj_image_comp_t));
 		p_image_dest->comps[compno].data = NULL;
+		p_image_dest->comps[compno].native_data = NULL;
 	}
 
 	p_image_dest->color_space = p_image_src->color_space;
 	p_image_dest->icc_profile_len = p_image_src->icc_profile_len;
 
 	if (p_image_dest->icc_profile_len) {
-		p_image_dest->icc_profile_buf = (OPJ_BYTE*)opj_malloc(p_image_dest->icc_profile_len);
+		p_image_dest->icc_profile_buf = (OPJ_BYTE*)opj_image_data_alloc(p_image_dest->icc_profile_len);
 		if (!p_image_dest->icc_profile_buf){
 			p_image_dest->icc_profile_buf = NULL;
 			p_image_dest->icc_profile_len = 0;
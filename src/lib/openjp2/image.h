@@ -62,6 +62,15 @@ void opj_image_comp_header_update(opj_image_t * p_image, const struct opj_cp* p_
 
 void opj_copy_image_header(const opj_image_t* p_image_src, opj_image_t* p_image_dest);
 
+/**
+ * Gets the size in bytes of one sample stored at the native width of a component.
+ *
+ * @param p_prec	the precision of the component.
+ *
+ * @return 1 or 2 if the samples of the component can be stored at their native width, 0 otherwise.
+ */
+OPJ_UINT32 opj_image_native_size(OPJ_UINT32 p_prec);
+
 /*@}*/
 
 #endif /* __IMAGE_H */
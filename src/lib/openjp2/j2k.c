@@ -168,19 +168,21 @@ static OPJ_BOOL opj_j2k_update_rates(   opj_j2k_t *p_j2k,
                                                                             opj_event_mgr_t * p_manager );
 
 /**
- * Copies the decoding tile parameters onto all the tile parameters.
- * Creates also the tile decoder.
+ * Creates the tile decoder. The tile coding parameters are copied from the default
+ * ones by opj_j2k_materialize_tcp, when a tile-part of their tile is read.
+ * The stream is not used and may be 00.
  */
-static OPJ_BOOL opj_j2k_copy_default_tcp_and_create_tcd (       opj_j2k_t * p_j2k,
-                                                            opj_stream_private_t *p_stream,
-                                                            opj_event_mgr_t * p_manager );
+static OPJ_BOOL opj_j2k_create_tile_decoder (   opj_j2k_t * p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager );
 
 /**
- * Destroys the memory associated with the decoding of headers.
+ * Gets the parameters of the codestream which the tile decoder depends on.
+ *
+ * @param       p_j2k           the jpeg2000 codec, with the main header read.
+ * @param       p_layout        the parameters to fill.
  */
-static OPJ_BOOL opj_j2k_destroy_header_memory ( opj_j2k_t * p_j2k,
-                                                opj_stream_private_t *p_stream,
-                                                opj_event_mgr_t * p_manager );
+static void opj_j2k_get_tcd_layout (opj_j2k_t * p_j2k, opj_tcd_layout_t * p_layout);
 
 /**
  * Reads the lookup table containing all the marker, status and action, and returns the handler associated
@@ -205,6 +207,28 @@ static void opj_j2k_tcp_destroy (opj_tcp_t *p_tcp);
  */
 static void opj_j2k_tcp_data_destroy (opj_tcp_t *p_tcp);
 
+/**
+ * Copies the default coding parameters of a decompressor into the ones of a tile,
+ * unless they have been copied already (their tccps are not 00).
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_tile_no       the index of the tile.
+ * @param       p_manager       the user event manager.
+ *
+ * @return true if the tile has its own coding parameters.
+ */
+static OPJ_BOOL opj_j2k_materialize_tcp (       opj_j2k_t * p_j2k,
+                                                OPJ_UINT32 p_tile_no,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Destroys the coding parameters of a decoded tile: they are copied again from
+ * the default ones if the tile is read again.
+ *
+ * @param       p_tcp           the tile coding parameters to release.
+ */
+static void opj_j2k_release_tcp (opj_tcp_t *p_tcp);
+
 /**
  * Destroys a coding parameter structure.
  *
@@ -212,6 +236,37 @@ static void opj_j2k_tcp_data_destroy (opj_tcp_t *p_tcp);
  */
 static void opj_j2k_cp_destroy (opj_cp_t *p_cp);
 
+/**
+ * Destroys the tile coding parameters kept by opj_j2k_decoder_reset.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ */
+static void opj_j2k_free_reusable_tcps (opj_j2k_t *p_j2k);
+
+/**
+ * Copies the main header coding parameters of a decompressor into the ones of its clone,
+ * or into the ones of a tile.
+ *
+ * @param       p_dest          the coding parameters to fill.
+ * @param       p_src           the default coding parameters read from the main header.
+ * @param       p_numcomps      the number of components of the image.
+ *
+ * @return true if the coding parameters could be copied.
+ */
+static OPJ_BOOL opj_j2k_copy_default_tcp (      opj_tcp_t * p_dest,
+                                                const opj_tcp_t * p_src,
+                                                OPJ_UINT32 p_numcomps );
+
+/**
+ * Copies the codestream index of a decompressor, keeping the allocated sizes of its arrays
+ * so that the copy can be extended by the decoding.
+ *
+ * @param       p_cstr_index    the codestream index to copy.
+ *
+ * @return the copy of the codestream index, 00 if not enough memory.
+ */
+static opj_codestream_index_t* opj_j2k_copy_cstr_index (const opj_codestream_index_t * p_cstr_index);
+
 /**
  * Writes a SPCod or SPCoc element, i.e. the coding style of a given component of a tile.
  *
@@ -336,7 +391,430 @@ static OPJ_BOOL opj_j2k_pre_write_tile ( opj_j2k_t * p_j2k,
                                                                              opj_stream_private_t *p_stream,
                                                                              opj_event_mgr_t * p_manager );
 
-static OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data, opj_image_t* p_output_image);
+/**
+ * Selects, for each component of the output image, whether its samples are stored at their native width.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_output_image  the output image to update.
+ */
+static void opj_j2k_set_native_samples(opj_j2k_t *p_j2k, opj_image_t* p_output_image);
+
+/**
+ * Releases the data of a decoded tile and reads the marker following it.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_tcp           the coding parameters of the decoded tile.
+ * @param       p_stream        the stream to read data from.
+ * @param       p_manager       the user event manager.
+ */
+static OPJ_BOOL opj_j2k_end_tile_decoding (     opj_j2k_t * p_j2k,
+                                                opj_tcp_t * p_tcp,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager );
+
+static OPJ_BOOL opj_j2k_update_image_data (const opj_image_t * p_image_src, const opj_tile_cache_comp_t * p_comps, const OPJ_BOOL * p_used_comps, OPJ_BYTE * p_data, opj_image_t* p_output_image);
+
+/**
+ * Removes from the decoded image the components which are not selected by opj_j2k_set_decoded_components.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_image         the decoded image.
+ */
+static void opj_j2k_keep_used_comps (opj_j2k_t * p_j2k, opj_image_t * p_image);
+
+/**
+ * Checks that the image to decode has all the components of the codestream when only some of them are decoded.
+ *
+ * @param       p_j2k           the jpeg2000 codec.
+ * @param       p_image         the image to decode.
+ * @param       p_manager       the user event manager.
+ */
+static OPJ_BOOL opj_j2k_check_used_comps (opj_j2k_t * p_j2k, const opj_image_t * p_image, opj_event_mgr_t * p_manager);
+
+/**
+ * Gets the parameters the tiles are decoded with, as known by the cache of decoded tiles.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_tile_index	index of the tile.
+ * @param	p_key		parameters of the tile.
+ */
+static void opj_j2k_get_tile_cache_key (opj_j2k_t * p_j2k, OPJ_UINT32 p_tile_index, opj_tile_cache_key_t * p_key);
+
+/**
+ * Gives a decoded tile to the decoded tile function, and copies it into the output image unless this one is not built.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_tile_index	index of the tile.
+ * @param	p_x0		left position of the tile on the reference grid.
+ * @param	p_y0		top position of the tile on the reference grid.
+ * @param	p_x1		right position of the tile on the reference grid.
+ * @param	p_y1		bottom position of the tile on the reference grid.
+ * @param	p_comps		decoded resolution of each component.
+ * @param	p_tile_comps	samples given to the decoded tile function, 00 if there is no such function.
+ * @param	p_data		decoded samples of the tile, as filled by opj_tcd_update_tile_data.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_deliver_tile (  opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 p_tile_index,
+                                        OPJ_INT32 p_x0, OPJ_INT32 p_y0, OPJ_INT32 p_x1, OPJ_INT32 p_y1,
+                                        const opj_tile_cache_comp_t * p_comps,
+                                        const opj_decoded_tile_comp_t * p_tile_comps,
+                                        OPJ_BYTE * p_data,
+                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Outputs the tile which has just been decoded, and keeps it in the cache of decoded tiles if any.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_tile_index	index of the decoded tile.
+ * @param	p_data		decoded samples of the tile, as filled by opj_j2k_decode_tile, 00 if they are left in the tile decoder.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_output_tile (   opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 p_tile_index,
+                                        OPJ_BYTE * p_data,
+                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Outputs a tile taken from the cache of decoded tiles.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_entry		the decoded tile.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_output_cached_tile (    opj_j2k_t * p_j2k,
+                                                opj_tile_cache_entry_t * p_entry,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Finds the end of the tile-part header starting at p_data, without reading its marker segments.
+ *
+ * @param	p_data		the bytes from the SOT marker of the tile-part.
+ * @param	p_size		number of bytes in p_data.
+ * @param	p_tot_len	set to the length of the tile-part (Psot), 0 if it ends with the codestream.
+ * @param	p_header_size	set to the size of the tile-part header, up to and including its SOD marker, 0 if p_data does not hold it entirely.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_scan_tile_part_header ( OPJ_BYTE * p_data,
+                                                OPJ_SIZE_T p_size,
+                                                OPJ_UINT32 * p_tot_len,
+                                                OPJ_SIZE_T * p_header_size,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Reads the marker segments of a tile-part header found by opj_j2k_scan_tile_part_header, then gets ready to read the next one.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_data		the tile-part header, from its SOT marker.
+ * @param	p_header_size	size of the tile-part header.
+ * @param	p_all_tiles	true to read the header of the tiles outside the decoded area too.
+ * @param	p_skip		set to true if the data of the tile-part is not decoded.
+ * @param	p_last		set to true if the tile-part is the last one of its tile.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_read_tile_part_markers (opj_j2k_t * p_j2k,
+                                                OPJ_BYTE * p_data,
+                                                OPJ_SIZE_T p_header_size,
+                                                OPJ_BOOL p_all_tiles,
+                                                OPJ_BOOL * p_skip,
+                                                OPJ_BOOL * p_last,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Reads the tile-part header starting at p_data, if it has been received entirely, for opj_j2k_decode_incremental.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_data		the bytes received from the SOT marker of the tile-part.
+ * @param	p_size		number of bytes in p_data.
+ * @param	p_header_size	set to the size of the tile-part header, up to and including its SOD marker, 0 if it is not complete.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_incr_read_tile_part_header (    opj_j2k_t * p_j2k,
+                                                        OPJ_BYTE * p_data,
+                                                        OPJ_SIZE_T p_size,
+                                                        OPJ_SIZE_T * p_header_size,
+                                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Reads the tile-part headers in p_data and gives the data of the tile-parts to the tile decoder, for opj_j2k_decode_incremental.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_data		the bytes received from the position opj_j2k_decode_incremental resumes at.
+ * @param	p_size		number of bytes in p_data.
+ * @param	p_read		set to the number of bytes read, the following ones being the beginning of a tile-part header.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_incr_read_data (opj_j2k_t * p_j2k,
+                                        OPJ_BYTE * p_data,
+                                        OPJ_SIZE_T p_size,
+                                        OPJ_SIZE_T * p_read,
+                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Decodes the tiles which received data, and copies the ones whose samples changed into the image, for opj_j2k_decode_incremental.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_image		the image to update.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_incr_decode_tiles ( opj_j2k_t * p_j2k,
+                                            opj_image_t * p_image,
+                                            opj_event_mgr_t * p_manager );
+
+/**
+ * Tile-part of the codestream read by opj_j2k_transcode.
+ */
+typedef struct opj_j2k_tile_part
+{
+        /** index of its tile */
+        OPJ_UINT32 tileno;
+        /** rank of the tile-part in the codestream */
+        OPJ_UINT32 rank;
+        /** marker segments of its header, between its SOT and SOD markers */
+        OPJ_BYTE * header;
+        /** size of header */
+        OPJ_UINT32 header_size;
+        /** position of its data in the input stream */
+        OPJ_OFF_T data_pos;
+        /** size of its data */
+        OPJ_UINT32 data_size;
+}
+opj_j2k_tile_part_t;
+
+/**
+ * Reads the header of all the tile-parts of the codestream, and finds their data, for opj_j2k_transcode
+ * and opj_j2k_get_packet_map.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_stream	the stream to read data from.
+ * @param	p_tile_parts	set to the tile-parts read, sorted by tile. To free with opj_j2k_free_tile_parts.
+ * @param	p_nb_tile_parts	set to the number of tile-parts read.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_read_tile_parts (       opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_stream,
+                                                opj_j2k_tile_part_t ** p_tile_parts,
+                                                OPJ_UINT32 * p_nb_tile_parts,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Frees the tile-parts read by opj_j2k_read_tile_parts.
+ */
+static void opj_j2k_free_tile_parts (opj_j2k_tile_part_t * p_tile_parts, OPJ_UINT32 p_nb_tile_parts);
+
+/**
+ * Sorts the tile-parts by tile, keeping their order in the codestream.
+ */
+static int opj_j2k_compare_tile_parts (const void * p_tp1, const void * p_tp2);
+
+/**
+ * Rewrites marker segments for opj_j2k_transcode: the SIZ, COD, COC, QCD and QCC markers are updated,
+ * the POC, TLM, PLM and PLT markers are removed and the others are copied.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_data		the marker segments, from the marker of the first one.
+ * @param	p_size		size of p_data.
+ * @param	p_parameters	the transcoding parameters.
+ * @param	p_dest		receives the rewritten marker segments, at most p_size bytes.
+ * @param	p_written	set to the number of bytes written to p_dest.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_transcode_markers (     opj_j2k_t * p_j2k,
+                                                const OPJ_BYTE * p_data,
+                                                OPJ_UINT32 p_size,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                OPJ_BYTE * p_dest,
+                                                OPJ_UINT32 * p_written,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Removes the highest resolution levels from the coordinates of one axis of the SIZ marker.
+ *
+ * @param	p_size		image size (Xsiz or Ysiz).
+ * @param	p_offset	image offset (XOsiz or YOsiz).
+ * @param	p_tile_size	tile size (XTsiz or YTsiz).
+ * @param	p_tile_offset	tile offset (XTOsiz or YTOsiz).
+ * @param	p_nb_tiles	number of tiles along the axis.
+ * @param	p_reduce	number of resolution levels removed.
+ * @return	false if the tiles of the reduced image would not match the original ones.
+ */
+static OPJ_BOOL opj_j2k_transcode_siz_axis (    OPJ_UINT32 * p_size,
+                                                OPJ_UINT32 * p_offset,
+                                                OPJ_UINT32 * p_tile_size,
+                                                OPJ_UINT32 * p_tile_offset,
+                                                OPJ_UINT32 p_nb_tiles,
+                                                OPJ_UINT32 p_reduce );
+
+/**
+ * Removes the highest resolution levels from the SPcod or SPcoc parameters of a COD or COC marker.
+ *
+ * @param	p_data		the SPcod or SPcoc parameters.
+ * @param	p_size		their size.
+ * @param	p_precincts	true if they give the size of the precincts.
+ * @param	p_reduce	number of resolution levels removed.
+ * @param	p_size_kept	set to the size of the rewritten parameters.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_transcode_spcod (       OPJ_BYTE * p_data,
+                                                OPJ_UINT32 p_size,
+                                                OPJ_BOOL p_precincts,
+                                                OPJ_UINT32 p_reduce,
+                                                OPJ_UINT32 * p_size_kept,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Removes the highest resolution levels from the Sqcd and SPqcd parameters of a QCD or QCC marker.
+ *
+ * @param	p_data		the Sqcd and SPqcd (or Sqcc and SPqcc) parameters.
+ * @param	p_size		their size.
+ * @param	p_reduce	number of resolution levels removed.
+ * @param	p_size_kept	set to the size of the rewritten parameters.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_transcode_sqcd (        OPJ_BYTE * p_data,
+                                                OPJ_UINT32 p_size,
+                                                OPJ_UINT32 p_reduce,
+                                                OPJ_UINT32 * p_size_kept,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Reads the data of the tile-parts of a tile, and rewrites the marker segments of their headers, for opj_j2k_transcode
+ * and opj_j2k_get_packet_map.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_input		the stream to read the tile-parts from.
+ * @param	p_tile_no	index of the tile.
+ * @param	p_tile_parts	the tile-parts of the tile, in the order of the codestream.
+ * @param	p_nb_tile_parts	number of tile-parts of the tile.
+ * @param	p_parameters	the transcoding parameters.
+ * @param	p_header	set to the rewritten marker segments of all the tile-part headers. To free with opj_free.
+ * @param	p_header_size	set to the size of p_header.
+ * @param	p_data		set to the data of the tile-parts, put end to end. To free with opj_free.
+ * @param	p_data_size	set to the size of p_data.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_read_tile_part_data (   opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_input,
+                                                OPJ_UINT32 p_tile_no,
+                                                const opj_j2k_tile_part_t * p_tile_parts,
+                                                OPJ_UINT32 p_nb_tile_parts,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                OPJ_BYTE ** p_header,
+                                                OPJ_UINT32 * p_header_size,
+                                                OPJ_BYTE ** p_data,
+                                                OPJ_UINT32 * p_data_size,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Lists the packets kept by opj_j2k_transcode, in their new progression order.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_tile_no	index of the tile.
+ * @param	p_packets	the packets found in the tile, see opj_tcd_locate_packets.
+ * @param	p_nb_packets	number of packets found.
+ * @param	p_parameters	the transcoding parameters.
+ * @param	p_sequence	set to the packets to write, a length of 0 telling a packet missing from a truncated codestream. To free with opj_free.
+ * @param	p_nb_sequence	set to the number of packets to write.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_order_packets ( opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 p_tile_no,
+                                        const opj_t2_packet_t * p_packets,
+                                        OPJ_UINT32 p_nb_packets,
+                                        const opj_transcode_parameters_t * p_parameters,
+                                        opj_t2_packet_t ** p_sequence,
+                                        OPJ_UINT32 * p_nb_sequence,
+                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Writes the tile-parts of a transcoded tile.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_output	the stream to write the tile to.
+ * @param	p_tile_no	index of the tile.
+ * @param	p_header	the marker segments of the first tile-part header.
+ * @param	p_header_size	size of p_header.
+ * @param	p_data		the data of the tile, the packets are copied from.
+ * @param	p_sequence	the packets to write, see opj_j2k_order_packets.
+ * @param	p_nb_sequence	number of packets to write.
+ * @param	p_parameters	the transcoding parameters.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_write_transcoded_tile ( opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_output,
+                                                OPJ_UINT32 p_tile_no,
+                                                const OPJ_BYTE * p_header,
+                                                OPJ_UINT32 p_header_size,
+                                                const OPJ_BYTE * p_data,
+                                                const opj_t2_packet_t * p_sequence,
+                                                OPJ_UINT32 p_nb_sequence,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Writes a tile in its new progression order, for opj_j2k_transcode.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_input		the stream to read the tile-parts from.
+ * @param	p_output	the stream to write the tile to.
+ * @param	p_tile_no	index of the tile.
+ * @param	p_tile_parts	the tile-parts of the tile, in the order of the codestream.
+ * @param	p_nb_tile_parts	number of tile-parts of the tile, 0 if the codestream is truncated before them.
+ * @param	p_parameters	the transcoding parameters.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_transcode_tile (        opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_input,
+                                                opj_stream_private_t * p_output,
+                                                OPJ_UINT32 p_tile_no,
+                                                const opj_j2k_tile_part_t * p_tile_parts,
+                                                OPJ_UINT32 p_nb_tile_parts,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Adds the byte ranges of the packets of a tile to a packet map, for opj_j2k_get_packet_map.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_stream	the stream to read the tile-parts from.
+ * @param	p_tile_no	index of the tile.
+ * @param	p_tile_parts	the tile-parts of the tile, in the order of the codestream.
+ * @param	p_nb_tile_parts	number of tile-parts of the tile, 0 if the codestream is truncated before them.
+ * @param	p_packet_map	the packet map receiving the packets of the tile.
+ * @param	p_max_packets	number of packets p_packet_map has room for, updated when it grows.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_map_tile_packets (      opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_stream,
+                                                OPJ_UINT32 p_tile_no,
+                                                const opj_j2k_tile_part_t * p_tile_parts,
+                                                OPJ_UINT32 p_nb_tile_parts,
+                                                opj_packet_map_t * p_packet_map,
+                                                OPJ_UINT32 * p_max_packets,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Moves back to the first tile-part of the codestream if a previous decoding went further.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_stream	the stream to read data from.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_rewind_tiles (  opj_j2k_t * p_j2k,
+                                        opj_stream_private_t *p_stream,
+                                        opj_event_mgr_t * p_manager );
+
+/**
+ * Outputs the tiles of the decoded area kept by the cache of decoded tiles, and marks them
+ * so that their tile-parts are skipped.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_all_cached	set to true if all the tiles of the area were in the cache.
+ * @param	p_manager	the user event manager.
+ */
+static OPJ_BOOL opj_j2k_output_cached_tiles (   opj_j2k_t *p_j2k,
+                                                OPJ_BOOL * p_all_cached,
+                                                opj_event_mgr_t * p_manager);
 
 static void opj_get_tile_dimensions(opj_image_t * l_image,
 																		opj_tcd_tilecomp_t * l_tilec,
@@ -348,7 +826,7 @@ static void opj_get_tile_dimensions(opj_image_t * l_image,
 																		OPJ_UINT32* l_offset_y,
 																		OPJ_UINT32* l_image_width,
 																		OPJ_UINT32* l_stride,
-																		OPJ_UINT32* l_tile_offset);
+																		OPJ_SIZE_T* l_tile_offset);
 
 static void opj_j2k_get_tile_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data);
 
@@ -765,7 +1243,7 @@ static OPJ_BOOL opj_j2k_merge_ppt (  opj_tcp_t *p_tcp,
 
 
 /**
- * Writes the TLM marker (Tile Length Marker)
+ * Writes the TLM markers (Tile Length Marker), with room for the length of every tile-part
  *
  * @param       p_stream                                the stream to write data to.
  * @param       p_j2k                           J2K codec.
@@ -775,6 +1253,20 @@ static OPJ_BOOL opj_j2k_write_tlm(      opj_j2k_t *p_j2k,
                                                                         opj_stream_private_t *p_stream,
                                                                         opj_event_mgr_t * p_manager );
 
+/**
+ * Gets the size of the tile index in the TLM markers: 1 byte up to 256 tiles, 2 bytes otherwise.
+ *
+ * @param       p_j2k                   J2K codec.
+*/
+static OPJ_UINT32 opj_j2k_get_tlm_ttlm_size(opj_j2k_t *p_j2k);
+
+/**
+ * Gets the number of tile-parts described by each TLM marker, all of them but the last one being full.
+ *
+ * @param       p_j2k                   J2K codec.
+*/
+static OPJ_UINT32 opj_j2k_get_tlm_nb_tile_parts(opj_j2k_t *p_j2k);
+
 /**
  * Writes the SOT marker (Start of tile-part)
  *
@@ -823,7 +1315,30 @@ static OPJ_BOOL opj_j2k_read_sot (  opj_j2k_t *p_j2k,
                                     OPJ_UINT32 p_header_size,
                                     opj_event_mgr_t * p_manager );
 /**
- * Writes the SOD marker (Start of data)
+ * Gets the largest size of the PLT markers giving the lengths of packets spread over tile-parts.
+ *
+ * @param       p_nb_packets            the number of packets.
+ * @param       p_nb_tile_parts         the number of tile-parts.
+*/
+static OPJ_UINT32 opj_j2k_get_max_plt_size(OPJ_UINT32 p_nb_packets, OPJ_UINT32 p_nb_tile_parts);
+
+/**
+ * Writes the PLT markers (Packet length, tile-part header) of the packets of a tile-part.
+ *
+ * @param       p_tile              the tile, with the lengths of its packets.
+ * @param       p_first_packet      the number of the first packet of the tile-part, the last one being before p_tile->packno.
+ * @param       p_data              the data to write the markers to, 00 to only compute their size.
+ * @param       p_data_written      the size of the markers.
+ * @param       p_manager           the user event manager.
+*/
+static OPJ_BOOL opj_j2k_write_plt_in_memory(    opj_tcd_tile_t * p_tile,
+                                                OPJ_UINT32 p_first_packet,
+                                                OPJ_BYTE * p_data,
+                                                OPJ_UINT32 * p_data_written,
+                                                opj_event_mgr_t * p_manager );
+
+/**
+ * Writes the SOD marker (Start of data), preceded by the PLT markers if they are enabled
  *
  * @param       p_j2k               J2K codec.
  * @param       p_tile_coder        FIXME DOC
@@ -854,8 +1369,10 @@ static OPJ_BOOL opj_j2k_read_sod(   opj_j2k_t *p_j2k,
 
 static void opj_j2k_update_tlm (opj_j2k_t * p_j2k, OPJ_UINT32 p_tile_part_size )
 {
-        opj_write_bytes(p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current,p_j2k->m_current_tile_number,1);            /* PSOT */
-        ++p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current;
+        OPJ_UINT32 l_ttlm_size = opj_j2k_get_tlm_ttlm_size(p_j2k);
+
+        opj_write_bytes(p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current,p_j2k->m_current_tile_number,l_ttlm_size);  /* TTLM */
+        p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current += l_ttlm_size;
 
         opj_write_bytes(p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current,p_tile_part_size,4);                                        /* PSOT */
         p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current += 4;
@@ -1064,7 +1581,83 @@ static void  opj_j2k_write_float_to_float (const void * p_src_data, void * p_des
 static void  opj_j2k_write_float_to_float64 (const void * p_src_data, void * p_dest_data, OPJ_UINT32 p_nb_elem);
 
 /**
- * Ends the encoding, i.e. frees memory.
+ * Frees the private image, the tile coder and the encoding buffers of the previous frame.
+ *
+ * @param       p_j2k                   J2K codec.
+*/
+static void opj_j2k_release_frame(opj_j2k_t *p_j2k);
+
+/**
+ * Frees the tile coder and the encoding buffers of the previous frame.
+ *
+ * @param       p_j2k                   J2K codec.
+*/
+static void opj_j2k_release_frame_buffers(opj_j2k_t *p_j2k);
+
+/**
+ * Moves the samples of the image given by the user to the private image.
+ *
+ * @param       p_j2k                   J2K codec.
+ * @param       p_image                 the image given by the user.
+ * @param       p_manager               the user event manager.
+*/
+static OPJ_BOOL opj_j2k_take_image_data(opj_j2k_t *p_j2k,
+                                        opj_image_t * p_image,
+                                        opj_event_mgr_t * p_manager);
+
+/**
+ * Gets the size in bytes of a sample of a component given by the user: 1, 2 or 4 bytes
+ * depending on its precision.
+ *
+ * @param       p_comp                  the image component.
+*/
+static OPJ_UINT32 opj_j2k_get_user_sample_size(const opj_image_comp_t * p_comp);
+
+/**
+ * Gets the number of rows of a component that fall within the given rows of the reference grid.
+ *
+ * @param       p_comp                  the image component.
+ * @param       p_y0                    the first row of the reference grid.
+ * @param       p_y1                    the row of the reference grid after the last one.
+*/
+static OPJ_UINT32 opj_j2k_get_strip_comp_rows(const opj_image_comp_t * p_comp,
+                                              OPJ_UINT32 p_y0,
+                                              OPJ_UINT32 p_y1);
+
+/**
+ * Gets the size of the strip data taken by a component, for the given rows of the reference grid.
+ *
+ * @param       p_image                 the image.
+ * @param       p_comp                  the image component.
+ * @param       p_y0                    the first row of the reference grid.
+ * @param       p_y1                    the row of the reference grid after the last one.
+*/
+static OPJ_SIZE_T opj_j2k_get_strip_comp_size(const opj_image_t * p_image,
+                                              const opj_image_comp_t * p_comp,
+                                              OPJ_UINT32 p_y0,
+                                              OPJ_UINT32 p_y1);
+
+/**
+ * Writes all the tiles of a row of tiles, once opj_j2k_write_strip has gathered their samples.
+ *
+ * @param       p_j2k                   J2K codec.
+ * @param       p_tile_row              the index of the row of tiles.
+ * @param       p_y0                    the first row of the reference grid covered by the tiles.
+ * @param       p_y1                    the row of the reference grid after the last one covered by the tiles.
+ * @param       p_stream                the stream to write data to.
+ * @param       p_manager               the user event manager.
+*/
+static OPJ_BOOL opj_j2k_write_strip_tiles(opj_j2k_t *p_j2k,
+                                          OPJ_UINT32 p_tile_row,
+                                          OPJ_UINT32 p_y0,
+                                          OPJ_UINT32 p_y1,
+                                          opj_stream_private_t *p_stream,
+                                          opj_event_mgr_t * p_manager);
+
+/**
+ * Ends the encoding, i.e. frees the tile coder and the encoding buffers, unless
+ * the frames of a sequence are compressed with opj_j2k_encoder_next_frame: they
+ * are then kept for the next frame and freed with the codec.
  *
  * @param       p_stream                the stream to write data to.
  * @param       p_j2k                   J2K codec.
@@ -1966,7 +2559,6 @@ static OPJ_BOOL opj_j2k_read_siz(opj_j2k_t *p_j2k,
         opj_image_t *l_image = 00;
         opj_cp_t *l_cp = 00;
         opj_image_comp_t * l_img_comp = 00;
-        opj_tcp_t * l_current_tile_param = 00;
 
         /* preconditions */
         assert(p_j2k != 00);
@@ -2030,13 +2622,14 @@ static OPJ_BOOL opj_j2k_read_siz(opj_j2k_t *p_j2k,
                 return OPJ_FALSE;
         }
         /* testcase 2539.pdf.SIGFPE.706.1712 (also 3622.pdf.SIGFPE.706.2916 and 4008.pdf.SIGFPE.706.3345 and maybe more) */
-        if (!(l_cp->tdx * l_cp->tdy)) {
+        if ((l_cp->tdx == 0U) || (l_cp->tdy == 0U)) {
                 opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker: invalid tile size (tdx: %d, tdy: %d)\n", l_cp->tdx, l_cp->tdy);
                 return OPJ_FALSE;
         }
 
         /* testcase 1610.pdf.SIGSEGV.59c.681 */
-        if (((OPJ_UINT64)l_image->x1) * ((OPJ_UINT64)l_image->y1) != (l_image->x1 * l_image->y1)) {
+        /* sample buffers are indexed with OPJ_SIZE_T */
+        if (((OPJ_SIZE_T)-1) / l_image->x1 < l_image->y1) {
                 opj_event_msg(p_manager, EVT_ERROR, "Prevent buffer overflow (x1: %d, y1: %d)\n", l_image->x1, l_image->y1);
                 return OPJ_FALSE;
         }
@@ -2221,8 +2814,19 @@ static OPJ_BOOL opj_j2k_read_siz(opj_j2k_t *p_j2k,
         }
 #endif /* USE_JPWL */
 
-        /* memory allocations */
-        l_cp->tcps = (opj_tcp_t*) opj_calloc(l_nb_tiles, sizeof(opj_tcp_t));
+        /* memory allocations: the coding parameters of a tile are filled (see
+           opj_j2k_materialize_tcp) only if one of its tile-parts is read */
+        if (p_j2k->m_specific_param.m_decoder.m_reusable_tcps != 00
+                && p_j2k->m_specific_param.m_decoder.m_nb_reusable_tcps == l_nb_tiles) {
+                /* same tiling as the previous codestream: take back its tile coding parameters */
+                l_cp->tcps = p_j2k->m_specific_param.m_decoder.m_reusable_tcps;
+                p_j2k->m_specific_param.m_decoder.m_reusable_tcps = 00;
+                p_j2k->m_specific_param.m_decoder.m_nb_reusable_tcps = 0;
+        }
+        else {
+                opj_j2k_free_reusable_tcps(p_j2k);
+                l_cp->tcps = (opj_tcp_t*) opj_calloc(l_nb_tiles, sizeof(opj_tcp_t));
+        }
         if (l_cp->tcps == 00) {
                 opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to take in charge SIZ marker\n");
                 return OPJ_FALSE;
@@ -2274,17 +2878,6 @@ static OPJ_BOOL opj_j2k_read_siz(opj_j2k_t *p_j2k,
                 }
         }
 
-        l_current_tile_param = l_cp->tcps;
-        for     (i = 0; i < l_nb_tiles; ++i) {
-                l_current_tile_param->tccps = (opj_tccp_t*) opj_calloc(l_image->numcomps, sizeof(opj_tccp_t));
-                if (l_current_tile_param->tccps == 00) {
-                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to take in charge SIZ marker\n");
-                        return OPJ_FALSE;
-                }
-
-                ++l_current_tile_param;
-        }
-
         p_j2k->m_specific_param.m_decoder.m_state =  J2K_STATE_MH; /* FIXME J2K_DEC_STATE_MH; */
         opj_image_comp_header_update(l_image,l_cp);
 
@@ -3458,6 +4051,7 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
                                     )
 {
         OPJ_UINT32 l_Zplt, l_tmp, l_packet_len = 0, i;
+        opj_tcp_t * l_tcp = 00;
 
         /* preconditions */
         assert(p_header_data != 00);
@@ -3469,26 +4063,62 @@ static OPJ_BOOL opj_j2k_read_plt (  opj_j2k_t *p_j2k,
                 return OPJ_FALSE;
         }
 
+        l_tcp = &(p_j2k->m_cp.tcps[p_j2k->m_current_tile_number]);
+
         opj_read_bytes(p_header_data,&l_Zplt,1);                /* Zplt */
         ++p_header_data;
         --p_header_size;
 
+        /* the lengths are kept in the order of the packets: each tile-part header starts
+           again from Zplt 0 and its markers must follow each other */
+        if (l_Zplt != (l_tcp->plt_read ? l_tcp->m_last_Zplt + 1 : 0)) {
+                if (! l_tcp->plt_ignored) {
+                        opj_event_msg(p_manager, EVT_WARNING, "PLT marker %d of tile %d repeated or out of order, "
+                                      "the packet lengths of the tile are not used\n", l_Zplt, p_j2k->m_current_tile_number + 1);
+                }
+                l_tcp->plt_ignored = 1;
+        }
+        l_tcp->m_last_Zplt = l_Zplt;
+        l_tcp->plt_read = 1;
+
         for (i = 0; i < p_header_size; ++i) {
                 opj_read_bytes(p_header_data,&l_tmp,1);         /* Iplt_ij */
                 ++p_header_data;
                 /* take only the last seven bytes */
                 l_packet_len |= (l_tmp & 0x7f);
                 if (l_tmp & 0x80) {
+                        /* a length of more than 32 bits cannot be used */
+                        if (l_packet_len > 0x1FFFFFFU) {
+                                l_tcp->plt_ignored = 1;
+                                l_packet_len = 0;
+                        }
                         l_packet_len <<= 7;
                 }
                 else {
             /* store packet length and proceed to next packet */
-                        l_packet_len = 0;
-                }
-        }
+                        if (! l_tcp->plt_ignored) {
+                                if (l_tcp->m_nb_packet_lengths == l_tcp->m_max_packet_lengths) {
+                                        OPJ_UINT32 l_max_packet_lengths = l_tcp->m_max_packet_lengths ? 2 * l_tcp->m_max_packet_lengths : 1024;
+                                        OPJ_UINT32 * l_new_packet_lengths = 00;
 
-        if (l_packet_len != 0) {
-                opj_event_msg(p_manager, EVT_ERROR, "Error reading PLT marker\n");
+                                        if (l_max_packet_lengths <= 0xFFFFFFFFU / sizeof(OPJ_UINT32)) {
+                                                l_new_packet_lengths = (OPJ_UINT32 *) opj_realloc(l_tcp->m_packet_lengths, l_max_packet_lengths * sizeof(OPJ_UINT32));
+                                        }
+                                        if (! l_new_packet_lengths) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read PLT marker\n");
+                                                return OPJ_FALSE;
+                                        }
+                                        l_tcp->m_packet_lengths = l_new_packet_lengths;
+                                        l_tcp->m_max_packet_lengths = l_max_packet_lengths;
+                                }
+                                l_tcp->m_packet_lengths[l_tcp->m_nb_packet_lengths++] = l_packet_len;
+                        }
+                        l_packet_len = 0;
+                }
+        }
+
+        if (l_packet_len != 0) {
+                opj_event_msg(p_manager, EVT_ERROR, "Error reading PLT marker\n");
                 return OPJ_FALSE;
         }
 
@@ -3845,6 +4475,17 @@ static OPJ_BOOL opj_j2k_merge_ppt(opj_tcp_t *p_tcp, opj_event_mgr_t * p_manager)
 	return OPJ_TRUE;
 }
 
+static OPJ_UINT32 opj_j2k_get_tlm_ttlm_size(opj_j2k_t *p_j2k)
+{
+        return (p_j2k->m_cp.tw * p_j2k->m_cp.th <= 256) ? 1 : 2;
+}
+
+static OPJ_UINT32 opj_j2k_get_tlm_nb_tile_parts(opj_j2k_t *p_j2k)
+{
+        /* Ltlm, Ztlm and Stlm, then Ttlm and a 32 bits Ptlm for each tile-part */
+        return (0xffff - 4) / (opj_j2k_get_tlm_ttlm_size(p_j2k) + 4);
+}
+
 static OPJ_BOOL opj_j2k_write_tlm(     opj_j2k_t *p_j2k,
                                                         opj_stream_private_t *p_stream,
                                                         opj_event_mgr_t * p_manager
@@ -3852,13 +4493,22 @@ static OPJ_BOOL opj_j2k_write_tlm(     opj_j2k_t *p_j2k,
 {
         OPJ_BYTE * l_current_data = 00;
         OPJ_UINT32 l_tlm_size;
+        OPJ_UINT32 l_entry_size, l_nb_tile_parts, l_nb_markers, l_remaining_tile_parts, i;
 
         /* preconditions */
         assert(p_j2k != 00);
         assert(p_manager != 00);
         assert(p_stream != 00);
 
-        l_tlm_size = 6 + (5*p_j2k->m_specific_param.m_encoder.m_total_tile_parts);
+        l_entry_size = opj_j2k_get_tlm_ttlm_size(p_j2k) + 4;
+        l_nb_tile_parts = opj_j2k_get_tlm_nb_tile_parts(p_j2k);
+        l_nb_markers = (p_j2k->m_specific_param.m_encoder.m_total_tile_parts + l_nb_tile_parts - 1) / l_nb_tile_parts;
+        if (l_nb_markers > 256) {
+                opj_event_msg(p_manager, EVT_ERROR, "Too many tile-parts (%d) to write their lengths in TLM markers\n", p_j2k->m_specific_param.m_encoder.m_total_tile_parts);
+                return OPJ_FALSE;
+        }
+
+        l_tlm_size = 6 * l_nb_markers + l_entry_size * p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
 
         if (l_tlm_size > p_j2k->m_specific_param.m_encoder.m_header_tile_data_size) {
                 OPJ_BYTE *new_header_tile_data = (OPJ_BYTE *) opj_realloc(p_j2k->m_specific_param.m_encoder.m_header_tile_data, l_tlm_size);
@@ -3875,23 +4525,30 @@ static OPJ_BOOL opj_j2k_write_tlm(     opj_j2k_t *p_j2k,
 
         l_current_data = p_j2k->m_specific_param.m_encoder.m_header_tile_data;
 
-        /* change the way data is written to avoid seeking if possible */
-        /* TODO */
+        /* the lengths of the tile-parts are written by opj_j2k_write_updated_tlm, once they are all known */
         p_j2k->m_specific_param.m_encoder.m_tlm_start = opj_stream_tell(p_stream);
 
-        opj_write_bytes(l_current_data,J2K_MS_TLM,2);                                   /* TLM */
-        l_current_data += 2;
+        l_remaining_tile_parts = p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
+        for (i = 0; i < l_nb_markers; ++i) {
+                OPJ_UINT32 l_marker_tile_parts = opj_uint_min(l_remaining_tile_parts, l_nb_tile_parts);
 
-        opj_write_bytes(l_current_data,l_tlm_size-2,2);                                 /* Lpoc */
-        l_current_data += 2;
+                opj_write_bytes(l_current_data,J2K_MS_TLM,2);                                   /* TLM */
+                l_current_data += 2;
 
-        opj_write_bytes(l_current_data,0,1);                                                    /* Ztlm=0*/
-        ++l_current_data;
+                opj_write_bytes(l_current_data,4 + l_entry_size * l_marker_tile_parts,2);       /* Ltlm */
+                l_current_data += 2;
 
-        opj_write_bytes(l_current_data,0x50,1);                                                 /* Stlm ST=1(8bits-255 tiles max),SP=1(Ptlm=32bits) */
-        ++l_current_data;
+                opj_write_bytes(l_current_data,i,1);                                            /* Ztlm */
+                ++l_current_data;
+
+                opj_write_bytes(l_current_data,((l_entry_size - 4) << 4) | 0x40,1);             /* Stlm ST=1 or 2 (8 or 16 bits tile index),SP=1(Ptlm=32bits) */
+                ++l_current_data;
+
+                memset(l_current_data,0,l_entry_size * l_marker_tile_parts);
+                l_current_data += l_entry_size * l_marker_tile_parts;
+                l_remaining_tile_parts -= l_marker_tile_parts;
+        }
 
-        /* do nothing on the 5 * l_j2k->m_specific_param.m_encoder.m_total_tile_parts remaining data */
         if (opj_stream_write_data(p_stream,p_j2k->m_specific_param.m_encoder.m_header_tile_data,l_tlm_size,p_manager) != l_tlm_size) {
                 return OPJ_FALSE;
         }
@@ -4078,6 +4735,15 @@ static OPJ_BOOL opj_j2k_read_sot ( opj_j2k_t *p_j2k,
                         p_j2k->m_specific_param.m_decoder.m_last_tile_part = 1;
                 }
 
+                /* The first tile-part of a tile read again (the tiles were rewound before the tile
+                 * was decoded) starts the tile over: its data, packet lengths and number of
+                 * tile-parts would otherwise be counted twice */
+                if (l_current_part == 0 && (l_tcp->tccps != 00 || l_tcp->m_nb_tile_parts != 0)) {
+                        opj_j2k_release_tcp(l_tcp);
+                }
+                /* the PLT markers of each tile-part header are indexed from 0 */
+                l_tcp->plt_read = 0;
+
                 if (l_num_parts != 0) { /* Number of tile-part header is provided by this tile-part header */
                         l_num_parts += p_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction;
                         /* Useful to manage the case of textGBR.jp2 file because two values of TNSot are allowed: the correct numbers of
@@ -4124,7 +4790,8 @@ static OPJ_BOOL opj_j2k_read_sot ( opj_j2k_t *p_j2k,
                                 (l_tile_x < p_j2k->m_specific_param.m_decoder.m_start_tile_x)
                                 ||      (l_tile_x >= p_j2k->m_specific_param.m_decoder.m_end_tile_x)
                                 ||  (l_tile_y < p_j2k->m_specific_param.m_decoder.m_start_tile_y)
-                                ||      (l_tile_y >= p_j2k->m_specific_param.m_decoder.m_end_tile_y);
+                                ||      (l_tile_y >= p_j2k->m_specific_param.m_decoder.m_end_tile_y)
+                                ||  (p_j2k->m_specific_param.m_decoder.m_cached_tiles && p_j2k->m_specific_param.m_decoder.m_cached_tiles[p_j2k->m_current_tile_number]);
                 }
                 else {
                         assert( p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec >= 0 );
@@ -4132,6 +4799,12 @@ static OPJ_BOOL opj_j2k_read_sot ( opj_j2k_t *p_j2k,
                                 (p_j2k->m_current_tile_number != (OPJ_UINT32)p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec);
                 }
 
+                /* the rest of the header of a skipped tile-part is not read */
+                if (! p_j2k->m_specific_param.m_decoder.m_skip_data &&
+                    ! opj_j2k_materialize_tcp(p_j2k, p_j2k->m_current_tile_number, p_manager)) {
+                        return OPJ_FALSE;
+                }
+
                 /* Index */
                 if (p_j2k->cstr_index)
                 {
@@ -4240,6 +4913,11 @@ static OPJ_BOOL opj_j2k_write_sod(     opj_j2k_t *p_j2k,
 {
         opj_codestream_info_t *l_cstr_info = 00;
         OPJ_UINT32 l_remaining_data;
+        opj_tcd_tile_t * l_tile = p_tile_coder->tcd_image->tiles;
+        OPJ_BOOL l_plt = p_j2k->m_cp.m_specific_param.m_enc.m_plt;
+        OPJ_UINT32 l_first_packet = 0;
+        OPJ_UINT32 l_plt_size = 0;
+        OPJ_BYTE * l_begin_data = p_data;
 
         /* preconditions */
         assert(p_j2k != 00);
@@ -4291,6 +4969,17 @@ static OPJ_BOOL opj_j2k_write_sod(     opj_j2k_t *p_j2k,
                 }
         }
 
+        /* keep room for the PLT markers of the packets still to write: they are only known once written */
+        if (l_plt) {
+                l_first_packet = l_tile->packno;
+                l_plt_size = opj_j2k_get_max_plt_size(l_tile->nb_packets - l_first_packet, 1);
+                if (l_plt_size > l_remaining_data) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough space for the PLT markers of tile %d\n", p_j2k->m_current_tile_number);
+                        return OPJ_FALSE;
+                }
+                l_remaining_data -= l_plt_size;
+        }
+
         *p_data_written = 0;
 
         if (! opj_tcd_encode_tile(p_tile_coder, p_j2k->m_current_tile_number, p_data, p_data_written, l_remaining_data , l_cstr_info)) {
@@ -4300,6 +4989,77 @@ static OPJ_BOOL opj_j2k_write_sod(     opj_j2k_t *p_j2k,
 
         *p_data_written += 2;
 
+        /* the PLT markers go before SOD: move the SOD marker and the packets after them */
+        if (l_plt) {
+                if (! opj_j2k_write_plt_in_memory(l_tile, l_first_packet, 00, &l_plt_size, p_manager)) {
+                        return OPJ_FALSE;
+                }
+                memmove(l_begin_data + l_plt_size, l_begin_data, *p_data_written);
+                if (! opj_j2k_write_plt_in_memory(l_tile, l_first_packet, l_begin_data, &l_plt_size, p_manager)) {
+                        return OPJ_FALSE;
+                }
+                *p_data_written += l_plt_size;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_UINT32 opj_j2k_get_max_plt_size(OPJ_UINT32 p_nb_packets, OPJ_UINT32 p_nb_tile_parts)
+{
+        /* up to 5 bytes per length, and a new 4 bytes header every 65532 bytes of lengths or tile-part */
+        return 5 * p_nb_packets + 4 * (5 * p_nb_packets / 65532 + p_nb_tile_parts);
+}
+
+static OPJ_BOOL opj_j2k_write_plt_in_memory(   opj_tcd_tile_t * p_tile,
+                                                OPJ_UINT32 p_first_packet,
+                                                OPJ_BYTE * p_data,
+                                                OPJ_UINT32 * p_data_written,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_nb_markers = 0;
+        OPJ_UINT32 l_marker_size = 0;
+        OPJ_UINT32 l_size = 0;
+        OPJ_BYTE * l_marker_data = 00;
+        OPJ_UINT32 i, j;
+
+        for (i = p_first_packet; i < p_tile->packno; ++i) {
+                OPJ_UINT32 l_length = p_tile->packet_lengths[i];
+                OPJ_UINT32 l_nb_bytes = opj_t2_get_plt_length_size(l_length);
+
+                /* Lplt is at most 0xffff: Lplt, Zplt, then the lengths */
+                if (l_nb_markers == 0 || l_marker_size + l_nb_bytes > 0xffff - 3) {
+                        if (l_nb_markers == 256) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Too many packets in a tile-part to write their lengths in PLT markers\n");
+                                return OPJ_FALSE;
+                        }
+                        if (p_data) {
+                                if (l_marker_data) {
+                                        opj_write_bytes(l_marker_data,3 + l_marker_size,2);     /* Lplt */
+                                }
+                                opj_write_bytes(p_data + l_size,J2K_MS_PLT,2);                  /* PLT */
+                                l_marker_data = p_data + l_size + 2;
+                                opj_write_bytes(l_marker_data + 2,l_nb_markers,1);              /* Zplt */
+                        }
+                        l_size += 5;
+                        l_marker_size = 0;
+                        ++l_nb_markers;
+                }
+
+                if (p_data) {
+                        /* 7 bits per byte, the most significant first, the high bit set on all the bytes but the last one */
+                        for (j = l_nb_bytes; j > 0; --j) {
+                                opj_write_bytes(p_data + l_size + l_nb_bytes - j,((l_length >> (7 * (j - 1))) & 0x7f) | (j > 1 ? 0x80 : 0),1);   /* Iplt */
+                        }
+                }
+                l_size += l_nb_bytes;
+                l_marker_size += l_nb_bytes;
+        }
+
+        if (p_data && l_marker_data) {
+                opj_write_bytes(l_marker_data,3 + l_marker_size,2);                             /* Lplt */
+        }
+
+        *p_data_written = l_size;
         return OPJ_TRUE;
 }
 
@@ -4312,8 +5072,10 @@ static OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
         opj_codestream_index_t * l_cstr_index = 00;
         OPJ_BYTE ** l_current_data = 00;
         opj_tcp_t * l_tcp = 00;
-        OPJ_UINT32 * l_tile_len = 00;
+        OPJ_SIZE_T * l_tile_len = 00;
         OPJ_BOOL l_sot_length_pb_detected = OPJ_FALSE;
+        opj_profile_stats_t * l_stats = 00;
+        OPJ_FLOAT64 l_start;
 
         /* preconditions */
         assert(p_j2k != 00);
@@ -4356,7 +5118,12 @@ static OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
                 *l_current_data = (OPJ_BYTE*) opj_malloc(p_j2k->m_specific_param.m_decoder.m_sot_length);
             }
             else {
-                OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(*l_current_data, *l_tile_len + p_j2k->m_specific_param.m_decoder.m_sot_length);
+                OPJ_BYTE *l_new_current_data;
+                if (*l_tile_len > (OPJ_SIZE_T)-1 - p_j2k->m_specific_param.m_decoder.m_sot_length) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile\n");
+                        return OPJ_FALSE;
+                }
+                l_new_current_data = (OPJ_BYTE *) opj_realloc(*l_current_data, *l_tile_len + p_j2k->m_specific_param.m_decoder.m_sot_length);
                 if (! l_new_current_data) {
                         opj_free(*l_current_data);
                         /*nothing more is done as l_current_data will be set to null, and just
@@ -4399,6 +5166,9 @@ static OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
                 /*l_cstr_index->packno = 0;*/
         }
 
+        l_stats = opj_profile_get_tile(p_j2k->m_profile, p_j2k->m_current_tile_number);
+        l_start = opj_profile_start(l_stats);
+
         /* Patch to support new PHR data */
         if (!l_sot_length_pb_detected) {
             l_current_read_size = opj_stream_read_data(
@@ -4412,6 +5182,11 @@ static OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
             l_current_read_size = 0;
         }
 
+        opj_profile_stop(l_stats, OPJ_PROFILE_IO, l_start);
+        if (l_stats) {
+                l_stats->nb_bytes_read += l_current_read_size;
+        }
+
         if (l_current_read_size != p_j2k->m_specific_param.m_decoder.m_sot_length) {
                 p_j2k->m_specific_param.m_decoder.m_state = J2K_STATE_NEOC;
         }
@@ -4419,7 +5194,7 @@ static OPJ_BOOL opj_j2k_read_sod (opj_j2k_t *p_j2k,
                 p_j2k->m_specific_param.m_decoder.m_state = J2K_STATE_TPHSOT;
         }
 
-        *l_tile_len += (OPJ_UINT32)l_current_read_size;
+        *l_tile_len += l_current_read_size;
 
         return OPJ_TRUE;
 }
@@ -4617,7 +5392,10 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
         OPJ_FLOAT32 l_sot_remove;
         OPJ_UINT32 l_bits_empty, l_size_pixel;
         OPJ_UINT32 l_tile_size = 0;
+        OPJ_FLOAT64 l_tile_bits = 0;
         OPJ_UINT32 l_last_res;
+        OPJ_UINT32 l_nb_rates;
+        OPJ_FLOAT32 * l_frame_rates = 00;
         OPJ_FLOAT32 (* l_tp_stride_func)(opj_tcp_t *) = 00;
 
         /* preconditions */
@@ -4629,6 +5407,33 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
         l_image = p_j2k->m_private_image;
         l_tcp = l_cp->tcps;
 
+        /* the rates are updated in place: keep the user ones so that the next frame starts from them */
+        l_frame_rates = p_j2k->m_specific_param.m_encoder.m_frame_rates;
+        if (! l_frame_rates) {
+                l_nb_rates = 0;
+                for (i = 0; i < l_cp->th * l_cp->tw; ++i) {
+                        l_nb_rates += l_cp->tcps[i].numlayers;
+                }
+
+                l_frame_rates = (OPJ_FLOAT32 *) opj_malloc((l_nb_rates + 1) * sizeof(OPJ_FLOAT32));
+                if (! l_frame_rates) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to update the rates\n");
+                        return OPJ_FALSE;
+                }
+                p_j2k->m_specific_param.m_encoder.m_frame_rates = l_frame_rates;
+
+                for (i = 0; i < l_cp->th * l_cp->tw; ++i) {
+                        memcpy(l_frame_rates, l_cp->tcps[i].rates, l_cp->tcps[i].numlayers * sizeof(OPJ_FLOAT32));
+                        l_frame_rates += l_cp->tcps[i].numlayers;
+                }
+        }
+        else {
+                for (i = 0; i < l_cp->th * l_cp->tw; ++i) {
+                        memcpy(l_cp->tcps[i].rates, l_frame_rates, l_cp->tcps[i].numlayers * sizeof(OPJ_FLOAT32));
+                        l_frame_rates += l_cp->tcps[i].numlayers;
+                }
+        }
+
         l_bits_empty = 8 * l_image->comps->dx * l_image->comps->dy;
         l_size_pixel = l_image->numcomps * l_image->comps->prec;
         l_sot_remove = (OPJ_FLOAT32) opj_stream_tell(p_stream) / (OPJ_FLOAT32)(l_cp->th * l_cp->tw);
@@ -4644,6 +5449,11 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
                 for (j=0;j<l_cp->tw;++j) {
                         OPJ_FLOAT32 l_offset = (OPJ_FLOAT32)(*l_tp_stride_func)(l_tcp) / (OPJ_FLOAT32)l_tcp->numlayers;
 
+                        /* the lengths of the packets count in their rate, the headers of the PLT markers here */
+                        if (l_cp->m_specific_param.m_enc.m_plt) {
+                                l_offset += (OPJ_FLOAT32)(5 * l_tcp->m_nb_tile_parts) / (OPJ_FLOAT32)l_tcp->numlayers;
+                        }
+
                         /* 4 borders of the tile rescale on the image if necessary */
                         l_x0 = opj_int_max((OPJ_INT32)(l_cp->tx0 + j * l_cp->tdx), (OPJ_INT32)l_image->x0);
                         l_y0 = opj_int_max((OPJ_INT32)(l_cp->ty0 + i * l_cp->tdy), (OPJ_INT32)l_image->y0);
@@ -4654,7 +5464,7 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
 
                         /* Modification of the RATE >> */
                         if (*l_rates) {
-                                *l_rates =              (( (OPJ_FLOAT32) (l_size_pixel * (OPJ_UINT32)(l_x1 - l_x0) * (OPJ_UINT32)(l_y1 - l_y0)))
+                                *l_rates =              (( (OPJ_FLOAT32) ((OPJ_UINT64)l_size_pixel * (OPJ_UINT32)(l_x1 - l_x0) * (OPJ_UINT32)(l_y1 - l_y0)))
                                                                 /
                                                                 ((*l_rates) * (OPJ_FLOAT32)l_bits_empty)
                                                                 )
@@ -4666,7 +5476,7 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
 
                         for (k = 1; k < l_tcp->numlayers; ++k) {
                                 if (*l_rates) {
-                                        *l_rates =              (( (OPJ_FLOAT32) (l_size_pixel * (OPJ_UINT32)(l_x1 - l_x0) * (OPJ_UINT32)(l_y1 - l_y0)))
+                                        *l_rates =              (( (OPJ_FLOAT32) ((OPJ_UINT64)l_size_pixel * (OPJ_UINT32)(l_x1 - l_x0) * (OPJ_UINT32)(l_y1 - l_y0)))
                                                                         /
                                                                                 ((*l_rates) * (OPJ_FLOAT32)l_bits_empty)
                                                                         )
@@ -4726,12 +5536,11 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
         }
 
         l_img_comp = l_image->comps;
-        l_tile_size = 0;
 
         for (i=0;i<l_image->numcomps;++i) {
-                l_tile_size += (        opj_uint_ceildiv(l_cp->tdx,l_img_comp->dx)
+                l_tile_bits += (        (OPJ_FLOAT64)opj_uint_ceildiv(l_cp->tdx,l_img_comp->dx)
                                                         *
-                                                        opj_uint_ceildiv(l_cp->tdy,l_img_comp->dy)
+                                                        (OPJ_FLOAT64)opj_uint_ceildiv(l_cp->tdy,l_img_comp->dy)
                                                         *
                                                         l_img_comp->prec
                                                 );
@@ -4739,22 +5548,30 @@ static OPJ_BOOL opj_j2k_update_rates(  opj_j2k_t *p_j2k,
                 ++l_img_comp;
         }
 
-        l_tile_size = (OPJ_UINT32) (l_tile_size * 0.1625); /* 1.3/8 = 0.1625 */
+        /* the code-stream of a tile is gathered in a buffer whose size is kept on 32 bits like Psot */
+        l_tile_bits *= 0.1625; /* 1.3/8 = 0.1625 */
+        l_tile_size = (l_tile_bits < (OPJ_FLOAT64)0xFFFFFFFFU) ? (OPJ_UINT32)l_tile_bits : 0xFFFFFFFFU;
 
-        l_tile_size += opj_j2k_get_specific_header_sizes(p_j2k);
+        l_tile_size = opj_uint_adds(l_tile_size, opj_j2k_get_specific_header_sizes(p_j2k));
 
+        /* the buffers of the previous frame have the right size: the coding parameters did not change */
         p_j2k->m_specific_param.m_encoder.m_encoded_tile_size = l_tile_size;
-        p_j2k->m_specific_param.m_encoder.m_encoded_tile_data =
-                        (OPJ_BYTE *) opj_malloc(p_j2k->m_specific_param.m_encoder.m_encoded_tile_size);
-        if (p_j2k->m_specific_param.m_encoder.m_encoded_tile_data == 00) {
-                return OPJ_FALSE;
+        if (! p_j2k->m_specific_param.m_encoder.m_encoded_tile_data) {
+                p_j2k->m_specific_param.m_encoder.m_encoded_tile_data =
+                                (OPJ_BYTE *) opj_malloc(p_j2k->m_specific_param.m_encoder.m_encoded_tile_size);
+                if (p_j2k->m_specific_param.m_encoder.m_encoded_tile_data == 00) {
+                        return OPJ_FALSE;
+                }
+                p_j2k->m_specific_param.m_encoder.m_encoded_tile_data_size = l_tile_size;
         }
 
-        if (OPJ_IS_CINEMA(l_cp->rsiz)) {
-                p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer =
-                                (OPJ_BYTE *) opj_malloc(5*p_j2k->m_specific_param.m_encoder.m_total_tile_parts);
+        if (l_cp->m_specific_param.m_enc.m_tlm) {
                 if (! p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
-                        return OPJ_FALSE;
+                        p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer =
+                                        (OPJ_BYTE *) opj_malloc((opj_j2k_get_tlm_ttlm_size(p_j2k) + 4) * p_j2k->m_specific_param.m_encoder.m_total_tile_parts);
+                        if (! p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
+                                return OPJ_FALSE;
+                        }
                 }
 
                 p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current =
@@ -5871,6 +6688,7 @@ void opj_j2k_setup_decoder(opj_j2k_t *j2k, opj_dparameters_t *parameters)
         if(j2k && parameters) {
                 j2k->m_cp.m_specific_param.m_dec.m_layer = parameters->cp_layer;
                 j2k->m_cp.m_specific_param.m_dec.m_reduce = parameters->cp_reduce;
+                j2k->m_cp.m_specific_param.m_dec.m_native_samples = (parameters->flags & OPJ_DPARAMETERS_NATIVE_SAMPLES_FLAG) ? 1 : 0;
 
 #ifdef USE_JPWL
                 j2k->m_cp.correct = parameters->jpwl_correct;
@@ -6070,7 +6888,7 @@ static void opj_j2k_set_cinema_parameters(opj_cparameters_t *parameters, opj_ima
         parameters->max_comp_size = OPJ_CINEMA_24_COMP;
     }
 
-    parameters->tcp_rates[0] = (OPJ_FLOAT32) (image->numcomps * image->comps[0].w * image->comps[0].h * image->comps[0].prec)/
+    parameters->tcp_rates[0] = (OPJ_FLOAT32) ((OPJ_UINT64)image->numcomps * image->comps[0].w * image->comps[0].h * image->comps[0].prec)/
             (OPJ_FLOAT32)(((OPJ_UINT32)parameters->max_cs_size) * 8 * image->comps[0].dx * image->comps[0].dy);
 
 }
@@ -6215,7 +7033,7 @@ OPJ_BOOL opj_j2k_setup_encoder(     opj_j2k_t *p_j2k,
         if (parameters->max_cs_size <= 0) {
             if (parameters->tcp_rates[parameters->tcp_numlayers-1] > 0) {
                 OPJ_FLOAT32 temp_size;
-                temp_size =(OPJ_FLOAT32)(image->numcomps * image->comps[0].w * image->comps[0].h * image->comps[0].prec)/
+                temp_size =(OPJ_FLOAT32)((OPJ_UINT64)image->numcomps * image->comps[0].w * image->comps[0].h * image->comps[0].prec)/
                         (parameters->tcp_rates[parameters->tcp_numlayers-1] * 8 * (OPJ_FLOAT32)image->comps[0].dx * (OPJ_FLOAT32)image->comps[0].dy);
                 parameters->max_cs_size = (int) floor(temp_size);
             } else {
@@ -6224,7 +7042,7 @@ OPJ_BOOL opj_j2k_setup_encoder(     opj_j2k_t *p_j2k,
         } else {
             OPJ_FLOAT32 temp_rate;
             OPJ_BOOL cap = OPJ_FALSE;
-            temp_rate = (OPJ_FLOAT32) (image->numcomps * image->comps[0].w * image->comps[0].h * image->comps[0].prec)/
+            temp_rate = (OPJ_FLOAT32) ((OPJ_UINT64)image->numcomps * image->comps[0].w * image->comps[0].h * image->comps[0].prec)/
                     (OPJ_FLOAT32)(((OPJ_UINT32)parameters->max_cs_size) * 8 * image->comps[0].dx * image->comps[0].dy);
             for (i = 0; i < (OPJ_UINT32) parameters->tcp_numlayers; i++) {
                 if (parameters->tcp_rates[i] < temp_rate) {
@@ -6358,6 +7176,10 @@ OPJ_BOOL opj_j2k_setup_encoder(     opj_j2k_t *p_j2k,
                 cp->m_specific_param.m_enc.m_tp_on = 1;
         }
 
+        /* the Digital Cinema profiles require a TLM marker */
+        cp->m_specific_param.m_enc.m_tlm = (parameters->tlm_on || OPJ_IS_CINEMA(cp->rsiz)) ? 1 : 0;
+        cp->m_specific_param.m_enc.m_plt = parameters->plt_on ? 1 : 0;
+
 #ifdef USE_JPWL
         /*
         calculate JPWL encoding parameters
@@ -6633,7 +7455,7 @@ OPJ_BOOL opj_j2k_setup_encoder(     opj_j2k_t *p_j2k,
         }
 
         if (parameters->mct_data) {
-                opj_free(parameters->mct_data);
+                opj_image_data_free(parameters->mct_data);
                 parameters->mct_data = 00;
         }
         return OPJ_TRUE;
@@ -6794,7 +7616,7 @@ static OPJ_BOOL opj_j2k_setup_header_reading (opj_j2k_t *p_j2k, opj_event_mgr_t
         }
 
         /* DEVELOPER CORNER, add your custom procedures */
-        if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_copy_default_tcp_and_create_tcd, p_manager))  {
+        if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_create_tile_decoder, p_manager))  {
                 return OPJ_FALSE;
         }
 	
@@ -7293,127 +8115,35 @@ static OPJ_BOOL opj_j2k_exec ( opj_j2k_t * p_j2k,
 }
 
 /* FIXME DOC*/
-static OPJ_BOOL opj_j2k_copy_default_tcp_and_create_tcd (       opj_j2k_t * p_j2k,
-                                                            opj_stream_private_t *p_stream,
-                                                            opj_event_mgr_t * p_manager
-                                                            )
+static OPJ_BOOL opj_j2k_create_tile_decoder (   opj_j2k_t * p_j2k,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager )
 {
-        opj_tcp_t * l_tcp = 00;
-        opj_tcp_t * l_default_tcp = 00;
-        OPJ_UINT32 l_nb_tiles;
-        OPJ_UINT32 i,j;
-        opj_tccp_t *l_current_tccp = 00;
-        OPJ_UINT32 l_tccp_size;
-        OPJ_UINT32 l_mct_size;
         opj_image_t * l_image;
-        OPJ_UINT32 l_mcc_records_size,l_mct_records_size;
-        opj_mct_data_t * l_src_mct_rec, *l_dest_mct_rec;
-        opj_simple_mcc_decorrelation_data_t * l_src_mcc_rec, *l_dest_mcc_rec;
-        OPJ_UINT32 l_offset;
+        opj_tcd_layout_t l_layout;
 
         /* preconditions */
         assert(p_j2k != 00);
-        assert(p_stream != 00);
         assert(p_manager != 00);
 
-        l_image = p_j2k->m_private_image;
-        l_nb_tiles = p_j2k->m_cp.th * p_j2k->m_cp.tw;
-        l_tcp = p_j2k->m_cp.tcps;
-        l_tccp_size = l_image->numcomps * (OPJ_UINT32)sizeof(opj_tccp_t);
-        l_default_tcp = p_j2k->m_specific_param.m_decoder.m_default_tcp;
-        l_mct_size = l_image->numcomps * l_image->numcomps * (OPJ_UINT32)sizeof(OPJ_FLOAT32);
-
-        /* For each tile */
-        for (i=0; i<l_nb_tiles; ++i) {
-                /* keep the tile-compo coding parameters pointer of the current tile coding parameters*/
-                l_current_tccp = l_tcp->tccps;
-                /*Copy default coding parameters into the current tile coding parameters*/
-                memcpy(l_tcp, l_default_tcp, sizeof(opj_tcp_t));
-                /* Initialize some values of the current tile coding parameters*/
-                l_tcp->cod = 0;
-                l_tcp->ppt = 0;
-                l_tcp->ppt_data = 00;
-                /* Remove memory not owned by this tile in case of early error return. */
-                l_tcp->m_mct_decoding_matrix = 00;
-                l_tcp->m_nb_max_mct_records = 0;
-                l_tcp->m_mct_records = 00;
-                l_tcp->m_nb_max_mcc_records = 0;
-                l_tcp->m_mcc_records = 00;
-                /* Reconnect the tile-compo coding parameters pointer to the current tile coding parameters*/
-                l_tcp->tccps = l_current_tccp;
-
-                /* Get the mct_decoding_matrix of the dflt_tile_cp and copy them into the current tile cp*/
-                if (l_default_tcp->m_mct_decoding_matrix) {
-                        l_tcp->m_mct_decoding_matrix = (OPJ_FLOAT32*)opj_malloc(l_mct_size);
-                        if (! l_tcp->m_mct_decoding_matrix ) {
-                                return OPJ_FALSE;
-                        }
-                        memcpy(l_tcp->m_mct_decoding_matrix,l_default_tcp->m_mct_decoding_matrix,l_mct_size);
-                }
-
-                /* Get the mct_record of the dflt_tile_cp and copy them into the current tile cp*/
-                l_mct_records_size = l_default_tcp->m_nb_max_mct_records * (OPJ_UINT32)sizeof(opj_mct_data_t);
-                l_tcp->m_mct_records = (opj_mct_data_t*)opj_malloc(l_mct_records_size);
-                if (! l_tcp->m_mct_records) {
-                        return OPJ_FALSE;
-                }
-                memcpy(l_tcp->m_mct_records, l_default_tcp->m_mct_records,l_mct_records_size);
-
-                /* Copy the mct record data from dflt_tile_cp to the current tile*/
-                l_src_mct_rec = l_default_tcp->m_mct_records;
-                l_dest_mct_rec = l_tcp->m_mct_records;
-
-                for (j=0;j<l_default_tcp->m_nb_mct_records;++j) {
-
-                        if (l_src_mct_rec->m_data) {
-
-                                l_dest_mct_rec->m_data = (OPJ_BYTE*) opj_malloc(l_src_mct_rec->m_data_size);
-                                if(! l_dest_mct_rec->m_data) {
-                                        return OPJ_FALSE;
-                                }
-                                memcpy(l_dest_mct_rec->m_data,l_src_mct_rec->m_data,l_src_mct_rec->m_data_size);
-                        }
-
-                        ++l_src_mct_rec;
-                        ++l_dest_mct_rec;
-                        /* Update with each pass to free exactly what has been allocated on early return. */
-                        l_tcp->m_nb_max_mct_records += 1;
-                }
-
-                /* Get the mcc_record of the dflt_tile_cp and copy them into the current tile cp*/
-                l_mcc_records_size = l_default_tcp->m_nb_max_mcc_records * (OPJ_UINT32)sizeof(opj_simple_mcc_decorrelation_data_t);
-                l_tcp->m_mcc_records = (opj_simple_mcc_decorrelation_data_t*) opj_malloc(l_mcc_records_size);
-                if (! l_tcp->m_mcc_records) {
-                        return OPJ_FALSE;
-                }
-                memcpy(l_tcp->m_mcc_records,l_default_tcp->m_mcc_records,l_mcc_records_size);
-                l_tcp->m_nb_max_mcc_records = l_default_tcp->m_nb_max_mcc_records;
-
-                /* Copy the mcc record data from dflt_tile_cp to the current tile*/
-                l_src_mcc_rec = l_default_tcp->m_mcc_records;
-                l_dest_mcc_rec = l_tcp->m_mcc_records;
+        (void)p_stream;
 
-                for (j=0;j<l_default_tcp->m_nb_max_mcc_records;++j) {
-
-                        if (l_src_mcc_rec->m_decorrelation_array) {
-                                l_offset = (OPJ_UINT32)(l_src_mcc_rec->m_decorrelation_array - l_default_tcp->m_mct_records);
-                                l_dest_mcc_rec->m_decorrelation_array = l_tcp->m_mct_records + l_offset;
-                        }
+        l_image = p_j2k->m_private_image;
 
-                        if (l_src_mcc_rec->m_offset_array) {
-                                l_offset = (OPJ_UINT32)(l_src_mcc_rec->m_offset_array - l_default_tcp->m_mct_records);
-                                l_dest_mcc_rec->m_offset_array = l_tcp->m_mct_records + l_offset;
-                        }
+        opj_j2k_get_tcd_layout(p_j2k, &l_layout);
 
-                        ++l_src_mcc_rec;
-                        ++l_dest_mcc_rec;
+        /* Keep the tile decoder of the previous codestream if it has the same
+           image area, tiling, components and coding style. opj_tcd_init_decode_tile
+           sets up every tile again, the slabs and the T1 handle grow on demand. */
+        if (p_j2k->m_tcd) {
+                if (p_j2k->m_tcd->tcd_image->tiles != 00
+                        && memcmp(&(p_j2k->m_tcd->m_layout), &l_layout, sizeof(opj_tcd_layout_t)) == 0) {
+                        p_j2k->m_tcd->image = l_image;
+                        p_j2k->m_tcd->cp = &(p_j2k->m_cp);
+                        return OPJ_TRUE;
                 }
-
-                /* Copy all the dflt_tile_compo_cp to the current tile cp */
-                memcpy(l_current_tccp,l_default_tcp->tccps,l_tccp_size);
-
-                /* Move to next tile cp*/
-                ++l_tcp;
+                opj_tcd_destroy(p_j2k->m_tcd);
+                p_j2k->m_tcd = 00;
         }
 
         /* Create the current tile decoder*/
@@ -7428,10 +8158,40 @@ static OPJ_BOOL opj_j2k_copy_default_tcp_and_create_tcd (       opj_j2k_t * p_j2
                 opj_event_msg(p_manager, EVT_ERROR, "Cannot decode tile, memory error\n");
                 return OPJ_FALSE;
         }
+        p_j2k->m_tcd->m_profile = p_j2k->m_profile;
+        p_j2k->m_tcd->m_layout = l_layout;
 
         return OPJ_TRUE;
 }
 
+static void opj_j2k_get_tcd_layout (opj_j2k_t * p_j2k, opj_tcd_layout_t * p_layout)
+{
+        opj_image_t * l_image = p_j2k->m_private_image;
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_tcp_t * l_default_tcp = p_j2k->m_specific_param.m_decoder.m_default_tcp;
+        OPJ_UINT32 compno;
+
+        memset(p_layout, 0, sizeof(opj_tcd_layout_t));
+        p_layout->x0 = l_image->x0;
+        p_layout->y0 = l_image->y0;
+        p_layout->x1 = l_image->x1;
+        p_layout->y1 = l_image->y1;
+        p_layout->tx0 = l_cp->tx0;
+        p_layout->ty0 = l_cp->ty0;
+        p_layout->tdx = l_cp->tdx;
+        p_layout->tdy = l_cp->tdy;
+        p_layout->numcomps = l_image->numcomps;
+        p_layout->csty = l_default_tcp->csty;
+
+        for (compno = 0; compno < l_image->numcomps; ++compno) {
+                const opj_tccp_t * l_tccp = &(l_default_tcp->tccps[compno]);
+
+                p_layout->numresolutions = opj_uint_max(p_layout->numresolutions, l_tccp->numresolutions);
+                p_layout->cblkw = opj_uint_max(p_layout->cblkw, l_tccp->cblkw);
+                p_layout->cblkh = opj_uint_max(p_layout->cblkh, l_tccp->cblkh);
+        }
+}
+
 static const opj_dec_memory_marker_handler_t * opj_j2k_get_marker_handler (OPJ_UINT32 p_id)
 {
         const opj_dec_memory_marker_handler_t *e;
@@ -7462,6 +8222,16 @@ void opj_j2k_destroy (opj_j2k_t *p_j2k)
                         p_j2k->m_specific_param.m_decoder.m_header_data = 00;
                         p_j2k->m_specific_param.m_decoder.m_header_data_size = 0;
                 }
+
+                opj_j2k_free_reusable_tcps(p_j2k);
+
+                opj_tile_cache_destroy(p_j2k->m_specific_param.m_decoder.m_tile_cache);
+                p_j2k->m_specific_param.m_decoder.m_tile_cache = 00;
+                opj_free(p_j2k->m_specific_param.m_decoder.m_cached_tiles);
+                p_j2k->m_specific_param.m_decoder.m_cached_tiles = 00;
+
+                opj_free(p_j2k->m_specific_param.m_decoder.m_used_comps);
+                p_j2k->m_specific_param.m_decoder.m_used_comps = 00;
         }
         else {
 
@@ -7481,6 +8251,21 @@ void opj_j2k_destroy (opj_j2k_t *p_j2k)
                         p_j2k->m_specific_param.m_encoder.m_header_tile_data = 00;
                         p_j2k->m_specific_param.m_encoder.m_header_tile_data_size = 0;
                 }
+
+                if (p_j2k->m_specific_param.m_encoder.m_frame_rates) {
+                        opj_free(p_j2k->m_specific_param.m_encoder.m_frame_rates);
+                        p_j2k->m_specific_param.m_encoder.m_frame_rates = 00;
+                }
+
+                if (p_j2k->m_specific_param.m_encoder.m_strip_data) {
+                        opj_free(p_j2k->m_specific_param.m_encoder.m_strip_data);
+                        p_j2k->m_specific_param.m_encoder.m_strip_data = 00;
+                }
+
+                if (p_j2k->m_specific_param.m_encoder.m_strip_tile_data) {
+                        opj_free(p_j2k->m_specific_param.m_encoder.m_strip_tile_data);
+                        p_j2k->m_specific_param.m_encoder.m_strip_tile_data = 00;
+                }
         }
 
         opj_tcd_destroy(p_j2k->m_tcd);
@@ -7506,67 +8291,502 @@ void opj_j2k_destroy (opj_j2k_t *p_j2k)
         opj_free(p_j2k);
 }
 
-void j2k_destroy_cstr_index (opj_codestream_index_t *p_cstr_ind)
+static void opj_j2k_free_reusable_tcps (opj_j2k_t *p_j2k)
 {
-        if (p_cstr_ind) {
+        opj_free(p_j2k->m_specific_param.m_decoder.m_reusable_tcps);
+        p_j2k->m_specific_param.m_decoder.m_reusable_tcps = 00;
+        p_j2k->m_specific_param.m_decoder.m_nb_reusable_tcps = 0;
+}
 
-                if (p_cstr_ind->marker) {
-                        opj_free(p_cstr_ind->marker);
-                        p_cstr_ind->marker = NULL;
+OPJ_BOOL opj_j2k_decoder_reset (opj_j2k_t *p_j2k, opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t l_decoder;
+        opj_cp_t l_cp;
+        opj_tcp_t * l_tcp;
+        OPJ_UINT32 l_nb_tiles, i;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_manager != 00);
+
+        if (! p_j2k->m_is_decoder) {
+                opj_event_msg(p_manager, EVT_ERROR, "Only a decompressor can be reset\n");
+                return OPJ_FALSE;
+        }
+
+        /* the tiles decoded incrementally belong to the current codestream */
+        if (p_j2k->m_tcd) {
+                opj_tcd_free_incremental_tiles(p_j2k->m_tcd);
+        }
+
+        /* Keep the array of the tile coding parameters, emptied: only the tiles
+           whose tile-parts were read have something to release */
+        opj_j2k_free_reusable_tcps(p_j2k);
+        l_nb_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
+        if (p_j2k->m_cp.tcps != 00) {
+                l_tcp = p_j2k->m_cp.tcps;
+                for (i = 0; i < l_nb_tiles; ++i) {
+                        if (l_tcp->tccps != 00 || l_tcp->m_nb_tile_parts != 0) {
+                                opj_j2k_release_tcp(l_tcp);
+                        }
+                        ++l_tcp;
                 }
+                p_j2k->m_specific_param.m_decoder.m_reusable_tcps = p_j2k->m_cp.tcps;
+                p_j2k->m_specific_param.m_decoder.m_nb_reusable_tcps = l_nb_tiles;
+                p_j2k->m_cp.tcps = 00;
+        }
 
-                if (p_cstr_ind->tile_index) {
-                        OPJ_UINT32 it_tile = 0;
+        /* Coding parameters: keep the user decoding parameters only */
+        l_cp = p_j2k->m_cp;
+        opj_j2k_cp_destroy(&(p_j2k->m_cp));
+        memset(&(p_j2k->m_cp), 0, sizeof(opj_cp_t));
+        p_j2k->m_cp.m_is_decoder = 1;
+        p_j2k->m_cp.m_specific_param.m_dec = l_cp.m_specific_param.m_dec;
+#ifdef USE_JPWL
+        p_j2k->m_cp.correct = l_cp.correct;
+        p_j2k->m_cp.exp_comps = l_cp.exp_comps;
+        p_j2k->m_cp.max_tiles = l_cp.max_tiles;
+#endif /* USE_JPWL */
 
-                        for (it_tile=0; it_tile < p_cstr_ind->nb_of_tiles; it_tile++) {
+        opj_j2k_tcp_destroy(p_j2k->m_specific_param.m_decoder.m_default_tcp);
+        memset(p_j2k->m_specific_param.m_decoder.m_default_tcp, 0, sizeof(opj_tcp_t));
+
+        /* Decoder state: keep the buffers */
+        l_decoder = p_j2k->m_specific_param.m_decoder;
+        memset(&(p_j2k->m_specific_param.m_decoder), 0, sizeof(opj_j2k_dec_t));
+        p_j2k->m_specific_param.m_decoder.m_default_tcp = l_decoder.m_default_tcp;
+        p_j2k->m_specific_param.m_decoder.m_header_data = l_decoder.m_header_data;
+        p_j2k->m_specific_param.m_decoder.m_header_data_size = l_decoder.m_header_data_size;
+        p_j2k->m_specific_param.m_decoder.m_reusable_tcps = l_decoder.m_reusable_tcps;
+        p_j2k->m_specific_param.m_decoder.m_nb_reusable_tcps = l_decoder.m_nb_reusable_tcps;
+        p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = -1;
+        /* the tiles of the previous codestream are of no use for the next one */
+        p_j2k->m_specific_param.m_decoder.m_tile_cache = l_decoder.m_tile_cache;
+        opj_tile_cache_clear(p_j2k->m_specific_param.m_decoder.m_tile_cache);
+        opj_free(l_decoder.m_cached_tiles);
+        /* the components of the next codestream are not known yet */
+        opj_free(l_decoder.m_used_comps);
+        if (p_j2k->m_tcd) {
+                p_j2k->m_tcd->m_used_comps = 00;
+        }
+#ifdef OPJ_DISABLE_TPSOT_FIX
+        p_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction_checked = 1;
+#endif
 
-                                if(p_cstr_ind->tile_index[it_tile].packet_index) {
-                                        opj_free(p_cstr_ind->tile_index[it_tile].packet_index);
-                                        p_cstr_ind->tile_index[it_tile].packet_index = NULL;
-                                }
+        opj_procedure_list_clear(p_j2k->m_procedure_list);
+        opj_procedure_list_clear(p_j2k->m_validation_list);
 
-                                if(p_cstr_ind->tile_index[it_tile].tp_index){
-                                        opj_free(p_cstr_ind->tile_index[it_tile].tp_index);
-                                        p_cstr_ind->tile_index[it_tile].tp_index = NULL;
-                                }
+        j2k_destroy_cstr_index(p_j2k->cstr_index);
+        p_j2k->cstr_index = opj_j2k_create_cstr_index();
+        if (! p_j2k->cstr_index) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to reset the decoder\n");
+                return OPJ_FALSE;
+        }
 
-                                if(p_cstr_ind->tile_index[it_tile].marker){
-                                        opj_free(p_cstr_ind->tile_index[it_tile].marker);
-                                        p_cstr_ind->tile_index[it_tile].marker = NULL;
+        opj_image_destroy(p_j2k->m_private_image);
+        p_j2k->m_private_image = NULL;
+
+        opj_image_destroy(p_j2k->m_output_image);
+        p_j2k->m_output_image = NULL;
+
+        p_j2k->m_current_tile_number = 0;
+
+        /* the tile decoder (m_tcd) is kept: opj_j2k_create_tile_decoder
+           takes it back if the next codestream has the same layout */
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_copy_default_tcp (      opj_tcp_t * p_dest,
+                                                const opj_tcp_t * p_src,
+                                                OPJ_UINT32 p_numcomps )
+{
+        OPJ_UINT32 l_mct_size = p_numcomps * p_numcomps * (OPJ_UINT32)sizeof(OPJ_FLOAT32);
+        OPJ_UINT32 l_offset;
+        OPJ_UINT32 i;
+
+        memcpy(p_dest, p_src, sizeof(opj_tcp_t));
+
+        /* the main header has no packet headers nor tile data, and the encoding
+           parameters are not used by a decompressor */
+        p_dest->ppt_markers_count = 0;
+        p_dest->ppt_markers = 00;
+        p_dest->ppt_data = 00;
+        p_dest->ppt_buffer = 00;
+        p_dest->ppt_data_size = 0;
+        p_dest->ppt_len = 0;
+        p_dest->m_packet_lengths = 00;
+        p_dest->m_nb_packet_lengths = 0;
+        p_dest->m_max_packet_lengths = 0;
+        p_dest->m_last_Zplt = 0;
+        p_dest->plt_ignored = 0;
+        p_dest->plt_read = 0;
+        p_dest->m_data = 00;
+        p_dest->m_data_size = 0;
+        p_dest->mct_norms = 00;
+        p_dest->m_mct_coding_matrix = 00;
+        p_dest->m_mct_decoding_matrix = 00;
+        p_dest->m_mct_records = 00;
+        p_dest->m_nb_mct_records = 0;
+        p_dest->m_nb_max_mct_records = 0;
+        p_dest->m_mcc_records = 00;
+        p_dest->m_nb_mcc_records = 0;
+        p_dest->m_nb_max_mcc_records = 0;
+
+        p_dest->tccps = (opj_tccp_t*) opj_malloc(p_numcomps * sizeof(opj_tccp_t));
+        if (! p_dest->tccps) {
+                return OPJ_FALSE;
+        }
+        memcpy(p_dest->tccps, p_src->tccps, p_numcomps * sizeof(opj_tccp_t));
+
+        if (p_src->m_mct_decoding_matrix) {
+                p_dest->m_mct_decoding_matrix = (OPJ_FLOAT32*) opj_malloc(l_mct_size);
+                if (! p_dest->m_mct_decoding_matrix) {
+                        return OPJ_FALSE;
+                }
+                memcpy(p_dest->m_mct_decoding_matrix, p_src->m_mct_decoding_matrix, l_mct_size);
+        }
+
+        if (p_src->m_mct_records) {
+                p_dest->m_mct_records = (opj_mct_data_t*) opj_malloc(p_src->m_nb_max_mct_records * sizeof(opj_mct_data_t));
+                if (! p_dest->m_mct_records) {
+                        return OPJ_FALSE;
+                }
+                memcpy(p_dest->m_mct_records, p_src->m_mct_records, p_src->m_nb_max_mct_records * sizeof(opj_mct_data_t));
+                p_dest->m_nb_max_mct_records = p_src->m_nb_max_mct_records;
+
+                /* no shared data if the copy stops on a memory error */
+                for (i = 0; i < p_src->m_nb_mct_records; ++i) {
+                        p_dest->m_mct_records[i].m_data = 00;
+                }
+                p_dest->m_nb_mct_records = p_src->m_nb_mct_records;
 
+                for (i = 0; i < p_src->m_nb_mct_records; ++i) {
+                        if (p_src->m_mct_records[i].m_data) {
+                                p_dest->m_mct_records[i].m_data = (OPJ_BYTE*) opj_malloc(p_src->m_mct_records[i].m_data_size);
+                                if (! p_dest->m_mct_records[i].m_data) {
+                                        return OPJ_FALSE;
                                 }
+                                memcpy(p_dest->m_mct_records[i].m_data, p_src->m_mct_records[i].m_data, p_src->m_mct_records[i].m_data_size);
                         }
+                }
+        }
 
-                        opj_free( p_cstr_ind->tile_index);
-                        p_cstr_ind->tile_index = NULL;
+        if (p_src->m_mcc_records) {
+                p_dest->m_mcc_records = (opj_simple_mcc_decorrelation_data_t*)
+                                opj_malloc(p_src->m_nb_max_mcc_records * sizeof(opj_simple_mcc_decorrelation_data_t));
+                if (! p_dest->m_mcc_records) {
+                        return OPJ_FALSE;
                 }
+                memcpy(p_dest->m_mcc_records, p_src->m_mcc_records, p_src->m_nb_max_mcc_records * sizeof(opj_simple_mcc_decorrelation_data_t));
+                p_dest->m_nb_max_mcc_records = p_src->m_nb_max_mcc_records;
+                p_dest->m_nb_mcc_records = p_src->m_nb_mcc_records;
 
-                opj_free(p_cstr_ind);
+                /* the records point to the mct records of their own tile coding parameters */
+                for (i = 0; i < p_src->m_nb_max_mcc_records; ++i) {
+                        if (p_src->m_mcc_records[i].m_decorrelation_array) {
+                                l_offset = (OPJ_UINT32)(p_src->m_mcc_records[i].m_decorrelation_array - p_src->m_mct_records);
+                                p_dest->m_mcc_records[i].m_decorrelation_array = p_dest->m_mct_records + l_offset;
+                        }
+
+                        if (p_src->m_mcc_records[i].m_offset_array) {
+                                l_offset = (OPJ_UINT32)(p_src->m_mcc_records[i].m_offset_array - p_src->m_mct_records);
+                                p_dest->m_mcc_records[i].m_offset_array = p_dest->m_mct_records + l_offset;
+                        }
+                }
         }
+
+        return OPJ_TRUE;
 }
 
-static void opj_j2k_tcp_destroy (opj_tcp_t *p_tcp)
+static opj_codestream_index_t* opj_j2k_copy_cstr_index (const opj_codestream_index_t * p_cstr_index)
 {
-	if (p_tcp == 00) {
-		return;
-	}
-	
-	if (p_tcp->ppt_markers != 00) {
-		OPJ_UINT32 i;
-		for (i = 0U; i < p_tcp->ppt_markers_count; ++i) {
-			if (p_tcp->ppt_markers[i].m_data != NULL) {
-				opj_free(p_tcp->ppt_markers[i].m_data);
-			}
-		}
-		p_tcp->ppt_markers_count = 0U;
-		opj_free(p_tcp->ppt_markers);
-		p_tcp->ppt_markers = NULL;
-	}
-	
-	if (p_tcp->ppt_buffer != 00) {
+        opj_codestream_index_t * l_cstr_index;
+        OPJ_UINT32 it_tile;
+
+        l_cstr_index = (opj_codestream_index_t*) opj_calloc(1, sizeof(opj_codestream_index_t));
+        if (! l_cstr_index) {
+                return 00;
+        }
+
+        l_cstr_index->main_head_start = p_cstr_index->main_head_start;
+        l_cstr_index->main_head_end = p_cstr_index->main_head_end;
+        l_cstr_index->codestream_size = p_cstr_index->codestream_size;
+
+        if (p_cstr_index->marker) {
+                l_cstr_index->marker = (opj_marker_info_t*) opj_calloc(p_cstr_index->maxmarknum, sizeof(opj_marker_info_t));
+                if (! l_cstr_index->marker) {
+                        j2k_destroy_cstr_index(l_cstr_index);
+                        return 00;
+                }
+                memcpy(l_cstr_index->marker, p_cstr_index->marker, p_cstr_index->marknum * sizeof(opj_marker_info_t));
+                l_cstr_index->marknum = p_cstr_index->marknum;
+                l_cstr_index->maxmarknum = p_cstr_index->maxmarknum;
+        }
+
+        if (! p_cstr_index->tile_index) {
+                return l_cstr_index;
+        }
+
+        l_cstr_index->tile_index = (opj_tile_index_t*) opj_calloc(p_cstr_index->nb_of_tiles, sizeof(opj_tile_index_t));
+        if (! l_cstr_index->tile_index) {
+                j2k_destroy_cstr_index(l_cstr_index);
+                return 00;
+        }
+        l_cstr_index->nb_of_tiles = p_cstr_index->nb_of_tiles;
+
+        for (it_tile = 0; it_tile < p_cstr_index->nb_of_tiles; ++it_tile) {
+                const opj_tile_index_t * l_src = &(p_cstr_index->tile_index[it_tile]);
+                opj_tile_index_t * l_dest = &(l_cstr_index->tile_index[it_tile]);
+
+                l_dest->tileno = l_src->tileno;
+
+                if (l_src->marker) {
+                        l_dest->marker = (opj_marker_info_t*) opj_calloc(l_src->maxmarknum, sizeof(opj_marker_info_t));
+                        if (! l_dest->marker) {
+                                j2k_destroy_cstr_index(l_cstr_index);
+                                return 00;
+                        }
+                        memcpy(l_dest->marker, l_src->marker, l_src->marknum * sizeof(opj_marker_info_t));
+                        l_dest->marknum = l_src->marknum;
+                        l_dest->maxmarknum = l_src->maxmarknum;
+                }
+
+                if (l_src->tp_index) {
+                        l_dest->tp_index = (opj_tp_index_t*) opj_calloc(l_src->current_nb_tps, sizeof(opj_tp_index_t));
+                        if (! l_dest->tp_index) {
+                                j2k_destroy_cstr_index(l_cstr_index);
+                                return 00;
+                        }
+                        memcpy(l_dest->tp_index, l_src->tp_index, l_src->current_nb_tps * sizeof(opj_tp_index_t));
+                        l_dest->nb_tps = l_src->nb_tps;
+                        l_dest->current_nb_tps = l_src->current_nb_tps;
+                        l_dest->current_tpsno = l_src->current_tpsno;
+                }
+
+                if (l_src->packet_index) {
+                        l_dest->packet_index = (opj_packet_info_t*) opj_calloc(l_src->nb_packet, sizeof(opj_packet_info_t));
+                        if (! l_dest->packet_index) {
+                                j2k_destroy_cstr_index(l_cstr_index);
+                                return 00;
+                        }
+                        memcpy(l_dest->packet_index, l_src->packet_index, l_src->nb_packet * sizeof(opj_packet_info_t));
+                        l_dest->nb_packet = l_src->nb_packet;
+                }
+        }
+
+        return l_cstr_index;
+}
+
+opj_j2k_t* opj_j2k_clone_decompress (  opj_j2k_t *p_j2k,
+                                        opj_image_t ** p_image,
+                                        opj_event_mgr_t * p_manager)
+{
+        opj_j2k_t * l_j2k;
+        opj_j2k_dec_t * l_decoder;
+        opj_cp_t * l_cp;
+        OPJ_UINT32 l_nb_tiles;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_manager != 00);
+
+        if (! p_j2k->m_is_decoder || ! p_j2k->m_private_image || ! p_j2k->m_cp.tcps ||
+            ! (p_j2k->m_specific_param.m_decoder.m_state & (J2K_STATE_TPHSOT | J2K_STATE_TPH | J2K_STATE_EOC | J2K_STATE_NEOC))) {
+                opj_event_msg(p_manager, EVT_ERROR, "Only a decompressor whose main header has been read can be cloned\n");
+                return 00;
+        }
+
+        l_j2k = opj_j2k_create_decompress();
+        if (! l_j2k) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                return 00;
+        }
+        l_decoder = &(l_j2k->m_specific_param.m_decoder);
+        l_cp = &(l_j2k->m_cp);
+        l_nb_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
+
+        /* image header */
+        l_j2k->m_private_image = opj_image_create0();
+        if (! l_j2k->m_private_image) {
+                opj_j2k_destroy(l_j2k);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                return 00;
+        }
+        opj_copy_image_header(p_j2k->m_private_image, l_j2k->m_private_image);
+        if (! l_j2k->m_private_image->comps) {
+                opj_j2k_destroy(l_j2k);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                return 00;
+        }
+
+        /* coding parameters: the values, then what they own */
+        memcpy(l_cp, &(p_j2k->m_cp), sizeof(opj_cp_t));
+        l_cp->comment = 00;
+        l_cp->ppm_markers_count = 0;
+        l_cp->ppm_markers = 00;
+        l_cp->ppm_data = 00;
+        l_cp->ppm_len = 0;
+        l_cp->ppm_data_read = 0;
+        l_cp->ppm_data_current = 00;
+        l_cp->ppm_buffer = 00;
+        l_cp->ppm_data_first = 00;
+        l_cp->tcps = 00;
+
+        /* the packet headers of the PPM markers are read again from their start */
+        if (p_j2k->m_cp.ppm_buffer) {
+                l_cp->ppm_buffer = (OPJ_BYTE*) opj_malloc(p_j2k->m_cp.ppm_data_size);
+                if (! l_cp->ppm_buffer) {
+                        opj_j2k_destroy(l_j2k);
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                        return 00;
+                }
+                memcpy(l_cp->ppm_buffer, p_j2k->m_cp.ppm_buffer, p_j2k->m_cp.ppm_data_size);
+                l_cp->ppm_data = l_cp->ppm_buffer;
+                l_cp->ppm_len = p_j2k->m_cp.ppm_data_size;
+        }
+
+        if (! opj_j2k_copy_default_tcp(l_decoder->m_default_tcp,
+                                       p_j2k->m_specific_param.m_decoder.m_default_tcp,
+                                       l_j2k->m_private_image->numcomps)) {
+                opj_j2k_destroy(l_j2k);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                return 00;
+        }
+
+        l_cp->tcps = (opj_tcp_t*) opj_calloc(l_nb_tiles, sizeof(opj_tcp_t));
+        if (! l_cp->tcps) {
+                opj_j2k_destroy(l_j2k);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                return 00;
+        }
+
+        /* the tile coding parameters are those of the main header, until the
+           tile-part headers are read by the clone */
+        if (! opj_j2k_create_tile_decoder(l_j2k, 00, p_manager)) {
+                opj_j2k_destroy(l_j2k);
+                return 00;
+        }
+
+        j2k_destroy_cstr_index(l_j2k->cstr_index);
+        l_j2k->cstr_index = opj_j2k_copy_cstr_index(p_j2k->cstr_index);
+        if (! l_j2k->cstr_index) {
+                opj_j2k_destroy(l_j2k);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                return 00;
+        }
+
+        /* decoder state: the decoded area and what is known of the tile-parts */
+        l_decoder->m_state = J2K_STATE_TPHSOT;
+        l_decoder->m_start_tile_x = p_j2k->m_specific_param.m_decoder.m_start_tile_x;
+        l_decoder->m_start_tile_y = p_j2k->m_specific_param.m_decoder.m_start_tile_y;
+        l_decoder->m_end_tile_x = p_j2k->m_specific_param.m_decoder.m_end_tile_x;
+        l_decoder->m_end_tile_y = p_j2k->m_specific_param.m_decoder.m_end_tile_y;
+        l_decoder->m_DA_x0 = p_j2k->m_specific_param.m_decoder.m_DA_x0;
+        l_decoder->m_DA_y0 = p_j2k->m_specific_param.m_decoder.m_DA_y0;
+        l_decoder->m_DA_x1 = p_j2k->m_specific_param.m_decoder.m_DA_x1;
+        l_decoder->m_DA_y1 = p_j2k->m_specific_param.m_decoder.m_DA_y1;
+        l_decoder->m_discard_tiles = p_j2k->m_specific_param.m_decoder.m_discard_tiles;
+        l_decoder->m_last_sot_read_pos = p_j2k->m_specific_param.m_decoder.m_last_sot_read_pos;
+        l_decoder->m_nb_tile_parts_correction_checked = p_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction_checked;
+        l_decoder->m_nb_tile_parts_correction = p_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction;
+
+        /* and the components to decode */
+        if (p_j2k->m_specific_param.m_decoder.m_used_comps) {
+                l_decoder->m_used_comps = (OPJ_BOOL *) opj_malloc(l_j2k->m_private_image->numcomps * sizeof(OPJ_BOOL));
+                if (! l_decoder->m_used_comps) {
+                        opj_j2k_destroy(l_j2k);
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                        return 00;
+                }
+                memcpy(l_decoder->m_used_comps, p_j2k->m_specific_param.m_decoder.m_used_comps, l_j2k->m_private_image->numcomps * sizeof(OPJ_BOOL));
+                l_decoder->m_nb_used_comps = p_j2k->m_specific_param.m_decoder.m_nb_used_comps;
+        }
+
+        if (p_image) {
+                *p_image = opj_image_create0();
+                if (*p_image) {
+                        opj_copy_image_header(l_j2k->m_private_image, *p_image);
+                }
+                if (! (*p_image) || ! (*p_image)->comps) {
+                        opj_image_destroy(*p_image);
+                        *p_image = 00;
+                        opj_j2k_destroy(l_j2k);
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+                        return 00;
+                }
+        }
+
+        return l_j2k;
+}
+
+void j2k_destroy_cstr_index (opj_codestream_index_t *p_cstr_ind)
+{
+        if (p_cstr_ind) {
+
+                if (p_cstr_ind->marker) {
+                        opj_free(p_cstr_ind->marker);
+                        p_cstr_ind->marker = NULL;
+                }
+
+                if (p_cstr_ind->tile_index) {
+                        OPJ_UINT32 it_tile = 0;
+
+                        for (it_tile=0; it_tile < p_cstr_ind->nb_of_tiles; it_tile++) {
+
+                                if(p_cstr_ind->tile_index[it_tile].packet_index) {
+                                        opj_free(p_cstr_ind->tile_index[it_tile].packet_index);
+                                        p_cstr_ind->tile_index[it_tile].packet_index = NULL;
+                                }
+
+                                if(p_cstr_ind->tile_index[it_tile].tp_index){
+                                        opj_free(p_cstr_ind->tile_index[it_tile].tp_index);
+                                        p_cstr_ind->tile_index[it_tile].tp_index = NULL;
+                                }
+
+                                if(p_cstr_ind->tile_index[it_tile].marker){
+                                        opj_free(p_cstr_ind->tile_index[it_tile].marker);
+                                        p_cstr_ind->tile_index[it_tile].marker = NULL;
+
+                                }
+                        }
+
+                        opj_free( p_cstr_ind->tile_index);
+                        p_cstr_ind->tile_index = NULL;
+                }
+
+                opj_free(p_cstr_ind);
+        }
+}
+
+static void opj_j2k_tcp_destroy (opj_tcp_t *p_tcp)
+{
+	if (p_tcp == 00) {
+		return;
+	}
+	
+	if (p_tcp->ppt_markers != 00) {
+		OPJ_UINT32 i;
+		for (i = 0U; i < p_tcp->ppt_markers_count; ++i) {
+			if (p_tcp->ppt_markers[i].m_data != NULL) {
+				opj_free(p_tcp->ppt_markers[i].m_data);
+			}
+		}
+		p_tcp->ppt_markers_count = 0U;
+		opj_free(p_tcp->ppt_markers);
+		p_tcp->ppt_markers = NULL;
+	}
+	
+	if (p_tcp->ppt_buffer != 00) {
 		opj_free(p_tcp->ppt_buffer);
 		p_tcp->ppt_buffer = 00;
 	}
+
+	if (p_tcp->m_packet_lengths != 00) {
+		opj_free(p_tcp->m_packet_lengths);
+		p_tcp->m_packet_lengths = 00;
+		p_tcp->m_nb_packet_lengths = 0;
+		p_tcp->m_max_packet_lengths = 0;
+	}
 	
 	if (p_tcp->tccps != 00) {
 		opj_free(p_tcp->tccps);
@@ -7625,6 +8845,40 @@ static void opj_j2k_tcp_data_destroy (opj_tcp_t *p_tcp)
         }
 }
 
+static OPJ_BOOL opj_j2k_materialize_tcp (       opj_j2k_t * p_j2k,
+                                                OPJ_UINT32 p_tile_no,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_tcp_t * l_tcp = &(p_j2k->m_cp.tcps[p_tile_no]);
+        /* counted by the SOT markers of the tile-parts skipped before */
+        OPJ_UINT32 l_nb_tile_parts = l_tcp->m_nb_tile_parts;
+
+        if (l_tcp->tccps != 00) {
+                return OPJ_TRUE;
+        }
+
+        if (! opj_j2k_copy_default_tcp(l_tcp, p_j2k->m_specific_param.m_decoder.m_default_tcp,
+                                       p_j2k->m_private_image->numcomps)) {
+                opj_j2k_release_tcp(l_tcp);
+                l_tcp->m_nb_tile_parts = l_nb_tile_parts;
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the header of tile %d\n", p_tile_no + 1);
+                return OPJ_FALSE;
+        }
+
+        /* the tile-part headers of the tile are still to be read */
+        l_tcp->cod = 0;
+        l_tcp->ppt = 0;
+        l_tcp->m_nb_tile_parts = l_nb_tile_parts;
+
+        return OPJ_TRUE;
+}
+
+static void opj_j2k_release_tcp (opj_tcp_t *p_tcp)
+{
+        opj_j2k_tcp_destroy(p_tcp);
+        memset(p_tcp, 0, sizeof(opj_tcp_t));
+}
+
 static void opj_j2k_cp_destroy (opj_cp_t *p_cp)
 {
 	OPJ_UINT32 l_nb_tiles;
@@ -7771,7 +9025,7 @@ static OPJ_BOOL opj_j2k_need_nb_tile_parts_correction(opj_stream_private_t *p_st
 
 OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
                                                                     OPJ_UINT32 * p_tile_index,
-                                                                    OPJ_UINT32 * p_data_size,
+                                                                    OPJ_SIZE_T * p_data_size,
                                                                     OPJ_INT32 * p_tile_x0, OPJ_INT32 * p_tile_y0,
                                                                     OPJ_INT32 * p_tile_x1, OPJ_INT32 * p_tile_y1,
                                                                     OPJ_UINT32 * p_nb_comps,
@@ -7797,6 +9051,12 @@ OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
         else if (p_j2k->m_specific_param.m_decoder.m_state != J2K_STATE_TPHSOT){
                 return OPJ_FALSE;
         }
+        /* The stream of a cloned decompressor is not yet on the first tile-part */
+        else if (opj_stream_tell(p_stream) < (OPJ_OFF_T)p_j2k->cstr_index->main_head_end + 2) {
+                if (! opj_j2k_rewind_tiles(p_j2k, p_stream, p_manager)) {
+                        return OPJ_FALSE;
+                }
+        }
 
         /* Read into the codestream until reach the EOC or ! can_decode ??? FIXME */
         while ( (!p_j2k->m_specific_param.m_decoder.m_can_decode) && (l_current_marker != J2K_MS_EOC) ) {
@@ -8013,6 +9273,7 @@ OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
                 return OPJ_FALSE;
         }
         /*FIXME ???*/
+        p_j2k->m_tcd->m_used_comps = p_j2k->m_specific_param.m_decoder.m_used_comps;
         if (! opj_tcd_init_decode_tile(p_j2k->m_tcd, p_j2k->m_current_tile_number, p_manager)) {
                 opj_event_msg(p_manager, EVT_ERROR, "Cannot decode tile, memory error\n");
                 return OPJ_FALSE;
@@ -8038,12 +9299,10 @@ OPJ_BOOL opj_j2k_read_tile_header(      opj_j2k_t * p_j2k,
 OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
                                                         OPJ_UINT32 p_tile_index,
                                                         OPJ_BYTE * p_data,
-                                                        OPJ_UINT32 p_data_size,
+                                                        OPJ_SIZE_T p_data_size,
                                                         opj_stream_private_t *p_stream,
                                                         opj_event_mgr_t * p_manager )
 {
-        OPJ_UINT32 l_current_marker;
-        OPJ_BYTE l_data [2];
         opj_tcp_t * l_tcp;
 
         /* preconditions */
@@ -8073,15 +9332,24 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
                 return OPJ_FALSE;
         }
 
-        if (! opj_tcd_update_tile_data(p_j2k->m_tcd,p_data,p_data_size)) {
+        if (p_data && ! opj_tcd_update_tile_data(p_j2k->m_tcd,p_data,p_data_size)) {
                 return OPJ_FALSE;
         }
 
-        /* To avoid to destroy the tcp which can be useful when we try to decode a tile decoded before (cf j2k_random_tile_access)
-         * we destroy just the data which will be re-read in read_tile_header*/
-        /*opj_j2k_tcp_destroy(l_tcp);
-        p_j2k->m_tcd->tcp = 0;*/
-        opj_j2k_tcp_data_destroy(l_tcp);
+        return opj_j2k_end_tile_decoding(p_j2k, l_tcp, p_stream, p_manager);
+}
+
+static OPJ_BOOL opj_j2k_end_tile_decoding (     opj_j2k_t * p_j2k,
+                                                opj_tcp_t * p_tcp,
+                                                opj_stream_private_t *p_stream,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_current_marker;
+        OPJ_BYTE l_data [2];
+
+        /* The coding parameters of the tile are copied again from the default ones if the tile is
+         * decoded again (cf j2k_random_tile_access): its tile-part headers are then read again */
+        opj_j2k_release_tcp(p_tcp);
 
         p_j2k->m_specific_param.m_decoder.m_can_decode = 0;
         p_j2k->m_specific_param.m_decoder.m_state &= (~ (0x0080u));/* FIXME J2K_DEC_STATE_DATA);*/
@@ -8118,7 +9386,240 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
         return OPJ_TRUE;
 }
 
-static OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data, opj_image_t* p_output_image)
+static void opj_j2k_set_native_samples(opj_j2k_t *p_j2k, opj_image_t* p_output_image)
+{
+        OPJ_UINT32 compno;
+
+        for (compno = 0; compno < p_output_image->numcomps; ++compno) {
+                opj_image_comp_t * l_img_comp = p_output_image->comps + compno;
+
+                if (p_j2k->m_cp.m_specific_param.m_dec.m_native_samples) {
+                        l_img_comp->native_size = opj_image_native_size(l_img_comp->prec);
+                }
+                else {
+                        l_img_comp->native_size = 0;
+                }
+        }
+}
+
+static void opj_j2k_get_tile_cache_key (opj_j2k_t * p_j2k, OPJ_UINT32 p_tile_index, opj_tile_cache_key_t * p_key)
+{
+        p_key->tileno = p_tile_index;
+        p_key->reduce = p_j2k->m_cp.m_specific_param.m_dec.m_reduce;
+        p_key->layer = p_j2k->m_cp.m_specific_param.m_dec.m_layer;
+        p_key->native_samples = p_j2k->m_cp.m_specific_param.m_dec.m_native_samples;
+}
+
+static OPJ_BOOL opj_j2k_deliver_tile (  opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 p_tile_index,
+                                        OPJ_INT32 p_x0, OPJ_INT32 p_y0, OPJ_INT32 p_x1, OPJ_INT32 p_y1,
+                                        const opj_tile_cache_comp_t * p_comps,
+                                        const opj_decoded_tile_comp_t * p_tile_comps,
+                                        OPJ_BYTE * p_data,
+                                        opj_event_mgr_t * p_manager )
+{
+        opj_decoding_param_t * l_dec = &(p_j2k->m_cp.m_specific_param.m_dec);
+        opj_image_t * l_image = p_j2k->m_tcd->image;
+        const OPJ_BOOL * l_used = p_j2k->m_specific_param.m_decoder.m_used_comps;
+        OPJ_UINT32 compno;
+
+        if (l_dec->m_tile_fn) {
+                if (! l_dec->m_tile_fn(p_tile_index,
+                                       (OPJ_UINT32)p_x0, (OPJ_UINT32)p_y0,
+                                       (OPJ_UINT32)p_x1, (OPJ_UINT32)p_y1,
+                                       l_used ? p_j2k->m_specific_param.m_decoder.m_nb_used_comps : l_image->numcomps,
+                                       p_tile_comps,
+                                       l_dec->m_tile_user_data)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "The decoded tile function failed on tile %d\n", p_tile_index);
+                        return OPJ_FALSE;
+                }
+        }
+
+        if (l_dec->m_skip_image) {
+                for (compno = 0; compno < l_image->numcomps; ++compno) {
+                        p_j2k->m_output_image->comps[compno].resno_decoded = p_comps[compno].resno_decoded;
+                }
+                return OPJ_TRUE;
+        }
+
+        if (! opj_j2k_update_image_data(l_image, p_comps, l_used, p_data, p_j2k->m_output_image)) {
+                return OPJ_FALSE;
+        }
+        opj_event_msg(p_manager, EVT_INFO, "Image data has been updated with tile %d.\n\n", p_tile_index + 1);
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_output_tile (   opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 p_tile_index,
+                                        OPJ_BYTE * p_data,
+                                        opj_event_mgr_t * p_manager )
+{
+        opj_tcd_tile_t * l_tile = p_j2k->m_tcd->tcd_image->tiles;
+        opj_image_t * l_image = p_j2k->m_tcd->image;
+        opj_tile_cache_t * l_cache = p_j2k->m_specific_param.m_decoder.m_tile_cache;
+        const OPJ_BOOL * l_used = p_j2k->m_specific_param.m_decoder.m_used_comps;
+        opj_tile_cache_comp_t * l_comps;
+        opj_decoded_tile_comp_t * l_tile_comps = 00;
+        opj_decoded_tile_comp_t * l_tile_comp;
+        OPJ_UINT32 compno;
+        OPJ_BOOL l_result;
+
+        l_comps = (opj_tile_cache_comp_t *) opj_malloc(l_image->numcomps * sizeof(opj_tile_cache_comp_t));
+        if (l_comps && p_j2k->m_cp.m_specific_param.m_dec.m_tile_fn) {
+                l_tile_comps = (opj_decoded_tile_comp_t *) opj_malloc(l_image->numcomps * sizeof(opj_decoded_tile_comp_t));
+                if (! l_tile_comps) {
+                        opj_free(l_comps);
+                        l_comps = 00;
+                }
+        }
+        if (! l_comps) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to output the decoded tile %d\n", p_tile_index);
+                return OPJ_FALSE;
+        }
+
+        l_tile_comp = l_tile_comps;
+        for (compno = 0; compno < l_image->numcomps; ++compno) {
+                opj_tcd_tilecomp_t * l_tilec = l_tile->comps + compno;
+                opj_tcd_resolution_t * l_res = l_tilec->resolutions + l_image->comps[compno].resno_decoded;
+
+                l_comps[compno].x0 = l_res->x0;
+                l_comps[compno].y0 = l_res->y0;
+                l_comps[compno].x1 = l_res->x1;
+                l_comps[compno].y1 = l_res->y1;
+                l_comps[compno].resno_decoded = l_image->comps[compno].resno_decoded;
+
+                /* the decoded tile function is only given the selected components */
+                if (l_tile_comp && (! l_used || l_used[compno])) {
+                        /* the decoded resolution lies at the beginning of the tile component */
+                        l_tile_comp->x0 = (OPJ_UINT32)l_res->x0;
+                        l_tile_comp->y0 = (OPJ_UINT32)l_res->y0;
+                        l_tile_comp->w = (OPJ_UINT32)(l_res->x1 - l_res->x0);
+                        l_tile_comp->h = (OPJ_UINT32)(l_res->y1 - l_res->y0);
+                        l_tile_comp->stride = (OPJ_UINT32)(l_tilec->x1 - l_tilec->x0);
+                        l_tile_comp->resno_decoded = l_image->comps[compno].resno_decoded;
+                        l_tile_comp->data = l_tilec->data;
+                        ++l_tile_comp;
+                }
+        }
+
+        /* keep the tile for the next decodings: failing to do so only costs decoding it again */
+        if (l_cache && p_data) {
+                opj_tile_cache_key_t l_key;
+
+                opj_j2k_get_tile_cache_key(p_j2k, p_tile_index, &l_key);
+                opj_tile_cache_add(l_cache, &l_key,
+                                   l_tile->x0, l_tile->y0, l_tile->x1, l_tile->y1,
+                                   l_image->numcomps, l_comps,
+                                   p_data, opj_tcd_get_decoded_tile_size(p_j2k->m_tcd));
+        }
+
+        l_result = opj_j2k_deliver_tile(p_j2k, p_tile_index,
+                                        l_tile->x0, l_tile->y0, l_tile->x1, l_tile->y1,
+                                        l_comps, l_tile_comps, p_data, p_manager);
+
+        opj_free(l_comps);
+        opj_free(l_tile_comps);
+
+        return l_result;
+}
+
+static OPJ_BOOL opj_j2k_output_cached_tile (    opj_j2k_t * p_j2k,
+                                                opj_tile_cache_entry_t * p_entry,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_image_t * l_image = p_j2k->m_tcd->image;
+        const OPJ_BOOL * l_used = p_j2k->m_specific_param.m_decoder.m_used_comps;
+        opj_decoded_tile_comp_t * l_tile_comps = 00;
+        OPJ_INT32 * l_samples = 00;
+        OPJ_BOOL l_result;
+
+        /* the decoded tile function is given the samples unpacked */
+        if (p_j2k->m_cp.m_specific_param.m_dec.m_tile_fn) {
+                const OPJ_BYTE * l_src = p_entry->data;
+                OPJ_SIZE_T l_nb_samples = 0;
+                opj_decoded_tile_comp_t * l_tile_comp;
+                OPJ_INT32 * l_dest;
+                OPJ_UINT32 compno;
+                OPJ_SIZE_T i;
+
+                for (compno = 0; compno < p_entry->numcomps; ++compno) {
+                        const opj_tile_cache_comp_t * l_comp = p_entry->comps + compno;
+                        if (l_used && ! l_used[compno]) {
+                                continue;
+                        }
+                        l_nb_samples += (OPJ_SIZE_T)(l_comp->x1 - l_comp->x0) * (OPJ_SIZE_T)(l_comp->y1 - l_comp->y0);
+                }
+
+                l_tile_comps = (opj_decoded_tile_comp_t *) opj_malloc(p_entry->numcomps * sizeof(opj_decoded_tile_comp_t));
+                l_samples = (OPJ_INT32 *) opj_malloc((l_nb_samples ? l_nb_samples : 1) * sizeof(OPJ_INT32));
+                if (! l_tile_comps || ! l_samples) {
+                        opj_free(l_tile_comps);
+                        opj_free(l_samples);
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to output the decoded tile %d\n", p_entry->key.tileno);
+                        return OPJ_FALSE;
+                }
+
+                l_dest = l_samples;
+                l_tile_comp = l_tile_comps;
+                for (compno = 0; compno < p_entry->numcomps; ++compno) {
+                        const opj_tile_cache_comp_t * l_comp = p_entry->comps + compno;
+                        const opj_image_comp_t * l_img_comp = l_image->comps + compno;
+                        OPJ_UINT32 l_width = (OPJ_UINT32)(l_comp->x1 - l_comp->x0);
+                        OPJ_UINT32 l_height = (OPJ_UINT32)(l_comp->y1 - l_comp->y0);
+                        OPJ_SIZE_T l_nb = (OPJ_SIZE_T)l_width * l_height;
+                        OPJ_UINT32 l_size_comp = (l_img_comp->prec + 7) >> 3;
+
+                        /* the samples of the components which are not selected are not kept */
+                        if (l_used && ! l_used[compno]) {
+                                continue;
+                        }
+
+                        if (l_size_comp == 3) {
+                                l_size_comp = 4;
+                        }
+
+                        l_tile_comp->x0 = (OPJ_UINT32)l_comp->x0;
+                        l_tile_comp->y0 = (OPJ_UINT32)l_comp->y0;
+                        l_tile_comp->w = l_width;
+                        l_tile_comp->h = l_height;
+                        l_tile_comp->stride = l_width;
+                        l_tile_comp->resno_decoded = l_comp->resno_decoded;
+                        l_tile_comp->data = l_dest;
+                        ++l_tile_comp;
+
+                        switch (l_size_comp) {
+                                case 1:
+                                        for (i = 0; i < l_nb; ++i) {
+                                                l_dest[i] = l_img_comp->sgnd ? (OPJ_INT32)((const OPJ_INT8 *)l_src)[i] : (OPJ_INT32)l_src[i];
+                                        }
+                                        break;
+                                case 2:
+                                        for (i = 0; i < l_nb; ++i) {
+                                                l_dest[i] = l_img_comp->sgnd ? (OPJ_INT32)((const OPJ_INT16 *)l_src)[i] : (OPJ_INT32)((const OPJ_UINT16 *)l_src)[i];
+                                        }
+                                        break;
+                                default:
+                                        memcpy(l_dest, l_src, l_nb * sizeof(OPJ_INT32));
+                                        break;
+                        }
+
+                        l_src += l_nb * l_size_comp;
+                        l_dest += l_nb;
+                }
+        }
+
+        l_result = opj_j2k_deliver_tile(p_j2k, p_entry->key.tileno,
+                                        p_entry->x0, p_entry->y0, p_entry->x1, p_entry->y1,
+                                        p_entry->comps, l_tile_comps, p_entry->data, p_manager);
+
+        opj_free(l_tile_comps);
+        opj_free(l_samples);
+
+        return l_result;
+}
+
+static OPJ_BOOL opj_j2k_update_image_data (const opj_image_t * p_image_src, const opj_tile_cache_comp_t * p_comps, const OPJ_BOOL * p_used_comps, OPJ_BYTE * p_data, opj_image_t* p_output_image)
 {
         OPJ_UINT32 i,j,k = 0;
         OPJ_UINT32 l_width_src,l_height_src;
@@ -8129,40 +9630,52 @@ static OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data,
         OPJ_UINT32 l_x0_dest, l_y0_dest, l_x1_dest, l_y1_dest;
         OPJ_SIZE_T l_start_offset_dest, l_line_offset_dest;
 
-        opj_image_comp_t * l_img_comp_src = 00;
+        const opj_image_comp_t * l_img_comp_src = 00;
         opj_image_comp_t * l_img_comp_dest = 00;
 
-        opj_tcd_tilecomp_t * l_tilec = 00;
-        opj_image_t * l_image_src = 00;
         OPJ_UINT32 l_size_comp, l_remaining;
         OPJ_INT32 * l_dest_ptr;
-        opj_tcd_resolution_t* l_res= 00;
+        const opj_tile_cache_comp_t * l_res = 00;
 
-        l_tilec = p_tcd->tcd_image->tiles->comps;
-        l_image_src = p_tcd->image;
-        l_img_comp_src = l_image_src->comps;
+        l_img_comp_src = p_image_src->comps;
 
         l_img_comp_dest = p_output_image->comps;
 
-        for (i=0; i<l_image_src->numcomps; i++) {
+        for (i=0; i<p_image_src->numcomps; i++) {
+                /* the components which are not selected have no samples in p_data */
+                if (p_used_comps && ! p_used_comps[i]) {
+                        ++l_img_comp_dest;
+                        ++l_img_comp_src;
+                        continue;
+                }
+
+                /* Decoded resolution of the tile component */
+                l_res = p_comps + i;
 
                 /* Allocate output component buffer if necessary */
-                if (!l_img_comp_dest->data) {
+                if (l_img_comp_dest->native_size) {
+                        if (!l_img_comp_dest->native_data) {
+                                l_img_comp_dest->native_data = opj_image_data_calloc((OPJ_SIZE_T)l_img_comp_dest->w * (OPJ_SIZE_T)l_img_comp_dest->h, l_img_comp_dest->native_size);
+                                if (! l_img_comp_dest->native_data) {
+                                        return OPJ_FALSE;
+                                }
+                        }
+                }
+                else if (!l_img_comp_dest->data) {
 
-                        l_img_comp_dest->data = (OPJ_INT32*) opj_calloc((OPJ_SIZE_T)l_img_comp_dest->w * (OPJ_SIZE_T)l_img_comp_dest->h, sizeof(OPJ_INT32));
+                        l_img_comp_dest->data = (OPJ_INT32*) opj_image_data_calloc((OPJ_SIZE_T)l_img_comp_dest->w * (OPJ_SIZE_T)l_img_comp_dest->h, sizeof(OPJ_INT32));
                         if (! l_img_comp_dest->data) {
                                 return OPJ_FALSE;
                         }
                 }
 
                 /* Copy info from decoded comp image to output image */
-                l_img_comp_dest->resno_decoded = l_img_comp_src->resno_decoded;
+                l_img_comp_dest->resno_decoded = l_res->resno_decoded;
 
                 /*-----*/
                 /* Compute the precision of the output buffer */
                 l_size_comp = l_img_comp_src->prec >> 3; /*(/ 8)*/
                 l_remaining = l_img_comp_src->prec & 7;  /* (%8) */
-                l_res = l_tilec->resolutions + l_img_comp_src->resno_decoded;
 
                 if (l_remaining) {
                         ++l_size_comp;
@@ -8274,8 +9787,28 @@ static OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data,
                 l_start_offset_dest = (OPJ_SIZE_T)l_start_x_dest + (OPJ_SIZE_T)l_start_y_dest * (OPJ_SIZE_T)l_img_comp_dest->w;
                 l_line_offset_dest  = (OPJ_SIZE_T)l_img_comp_dest->w - (OPJ_SIZE_T)l_width_dest;
 
-                /* Move the output buffer to the first place where we will write*/
-                l_dest_ptr = l_img_comp_dest->data + l_start_offset_dest;
+                if (l_img_comp_dest->native_size) {
+                        /* the decoded tile is already packed at the native width of the component */
+                        OPJ_BYTE * l_src_native = p_data + l_start_offset_src * l_size_comp;
+                        OPJ_BYTE * l_dest_native = (OPJ_BYTE *) l_img_comp_dest->native_data + l_start_offset_dest * l_size_comp;
+
+                        assert(l_img_comp_dest->native_size == l_size_comp);
+
+                        for (j = 0; j < l_height_dest; ++j) {
+                                memcpy(l_dest_native, l_src_native, (OPJ_SIZE_T)l_width_dest * l_size_comp);
+                                l_dest_native += (OPJ_SIZE_T)l_img_comp_dest->w * l_size_comp;
+                                l_src_native += (OPJ_SIZE_T)l_width_src * l_size_comp;
+                        }
+
+                        p_data += (OPJ_SIZE_T)l_width_src * (OPJ_SIZE_T)l_height_src * l_size_comp;
+
+                        ++l_img_comp_dest;
+                        ++l_img_comp_src;
+                        continue;
+                }
+
+                /* Move the output buffer to the first place where we will write*/
+                l_dest_ptr = l_img_comp_dest->data + l_start_offset_dest;
 
                 /*if (i == 0) {
                         fprintf(stdout, "COMPO[%d]:\n",i);
@@ -8374,7 +9907,6 @@ static OPJ_BOOL opj_j2k_update_image_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data,
 
                 ++l_img_comp_dest;
                 ++l_img_comp_src;
-                ++l_tilec;
         }
 
         return OPJ_TRUE;
@@ -8393,13 +9925,15 @@ OPJ_BOOL opj_j2k_set_decode_area(       opj_j2k_t *p_j2k,
         OPJ_INT32 l_comp_x1, l_comp_y1;
         opj_image_comp_t* l_img_comp = NULL;
 
-        /* Check if we are read the main header */
-        if (p_j2k->m_specific_param.m_decoder.m_state != J2K_STATE_TPHSOT) { /* FIXME J2K_DEC_STATE_TPHSOT)*/
+        /* Check if we are read the main header (the tiles may have been decoded already) */
+        if (! (p_j2k->m_specific_param.m_decoder.m_state & (J2K_STATE_TPHSOT | J2K_STATE_EOC | J2K_STATE_NEOC))) { /* FIXME J2K_DEC_STATE_TPHSOT)*/
                 opj_event_msg(p_manager, EVT_ERROR, "Need to decode the main header before begin to decode the remaining codestream");
                 return OPJ_FALSE;
         }
 
-        if ( !p_start_x && !p_start_y && !p_end_x && !p_end_y){
+        if ( !p_start_x && !p_start_y && !p_end_x && !p_end_y &&
+             p_image->x0 == l_image->x0 && p_image->y0 == l_image->y0 &&
+             p_image->x1 == l_image->x1 && p_image->y1 == l_image->y1){
                 opj_event_msg(p_manager, EVT_INFO, "No decoded area parameters, set the decoded area to the whole image\n");
 
                 p_j2k->m_specific_param.m_decoder.m_start_tile_x = 0;
@@ -8410,6 +9944,14 @@ OPJ_BOOL opj_j2k_set_decode_area(       opj_j2k_t *p_j2k,
                 return OPJ_TRUE;
         }
 
+        /* Back to the whole image after the decoding of an area */
+        if ( !p_start_x && !p_start_y && !p_end_x && !p_end_y){
+                p_start_x = (OPJ_INT32)l_image->x0;
+                p_start_y = (OPJ_INT32)l_image->y0;
+                p_end_x = (OPJ_INT32)l_image->x1;
+                p_end_y = (OPJ_INT32)l_image->y1;
+        }
+
         /* ----- */
         /* Check if the positions provided by the user are correct */
 
@@ -9186,7 +10728,13 @@ void j2k_dump (opj_j2k_t* p_j2k, OPJ_INT32 flag, FILE* out_stream)
           OPJ_UINT32 i;
           opj_tcp_t * l_tcp = p_j2k->m_cp.tcps;
           for (i=0;i<l_nb_tiles;++i) {
-            opj_j2k_dump_tile_info( l_tcp,(OPJ_INT32)p_j2k->m_private_image->numcomps, out_stream);
+            /* a tile whose tile-parts were not read has the default coding parameters */
+            if (p_j2k->m_is_decoder && ! l_tcp->tccps) {
+              opj_j2k_dump_tile_info(p_j2k->m_specific_param.m_decoder.m_default_tcp,(OPJ_INT32)p_j2k->m_private_image->numcomps, out_stream);
+            }
+            else {
+              opj_j2k_dump_tile_info( l_tcp,(OPJ_INT32)p_j2k->m_private_image->numcomps, out_stream);
+            }
             ++l_tcp;
           }
         }
@@ -9408,6 +10956,14 @@ opj_codestream_info_v2_t* j2k_get_cstr_info(opj_j2k_t* p_j2k)
         return cstr_info;
 }
 
+void opj_j2k_set_profile(opj_j2k_t* p_j2k, opj_profile_t * p_profile)
+{
+        p_j2k->m_profile = p_profile;
+        if (p_j2k->m_tcd) {
+                p_j2k->m_tcd->m_profile = p_profile;
+        }
+}
+
 opj_codestream_index_t* j2k_get_cstr_index(opj_j2k_t* p_j2k)
 {
         opj_codestream_index_t* l_cstr_index = (opj_codestream_index_t*)
@@ -9519,20 +11075,50 @@ opj_codestream_index_t* j2k_get_cstr_index(opj_j2k_t* p_j2k)
 
 static OPJ_BOOL opj_j2k_allocate_tile_element_cstr_index(opj_j2k_t *p_j2k)
 {
-        OPJ_UINT32 it_tile=0;
-
         p_j2k->cstr_index->nb_of_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
         p_j2k->cstr_index->tile_index = (opj_tile_index_t*)opj_calloc(p_j2k->cstr_index->nb_of_tiles, sizeof(opj_tile_index_t));
         if (!p_j2k->cstr_index->tile_index)
                 return OPJ_FALSE;
 
-        for (it_tile=0; it_tile < p_j2k->cstr_index->nb_of_tiles; it_tile++){
-                p_j2k->cstr_index->tile_index[it_tile].maxmarknum = 100;
-                p_j2k->cstr_index->tile_index[it_tile].marknum = 0;
-                p_j2k->cstr_index->tile_index[it_tile].marker = (opj_marker_info_t*)
-                                opj_calloc(p_j2k->cstr_index->tile_index[it_tile].maxmarknum, sizeof(opj_marker_info_t));
-                if (!p_j2k->cstr_index->tile_index[it_tile].marker)
-                        return OPJ_FALSE;
+        /* the markers of a tile are allocated by opj_j2k_add_tlmarker, if its tile-parts are read */
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_output_cached_tiles (   opj_j2k_t *p_j2k,
+                                                OPJ_BOOL * p_all_cached,
+                                                opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        OPJ_UINT32 l_tile_x, l_tile_y;
+
+        *p_all_cached = OPJ_TRUE;
+
+        l_decoder->m_cached_tiles = (OPJ_BYTE *) opj_calloc(p_j2k->m_cp.tw * p_j2k->m_cp.th, sizeof(OPJ_BYTE));
+        if (! l_decoder->m_cached_tiles) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tiles\n");
+                return OPJ_FALSE;
+        }
+
+        for (l_tile_y = l_decoder->m_start_tile_y; l_tile_y < l_decoder->m_end_tile_y; ++l_tile_y) {
+                for (l_tile_x = l_decoder->m_start_tile_x; l_tile_x < l_decoder->m_end_tile_x; ++l_tile_x) {
+                        opj_tile_cache_key_t l_key;
+                        opj_tile_cache_entry_t * l_entry;
+
+                        opj_j2k_get_tile_cache_key(p_j2k, l_tile_y * p_j2k->m_cp.tw + l_tile_x, &l_key);
+                        l_entry = opj_tile_cache_get(l_decoder->m_tile_cache, &l_key);
+                        if (! l_entry) {
+                                *p_all_cached = OPJ_FALSE;
+                                continue;
+                        }
+
+                        if (! opj_j2k_output_cached_tile(p_j2k, l_entry, p_manager)) {
+                                return OPJ_FALSE;
+                        }
+                        opj_event_msg(p_manager, EVT_INFO, "Tile %d/%d has been taken from the cache.\n", l_key.tileno + 1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
+
+                        /* the tile-parts of the tile will be skipped */
+                        l_decoder->m_cached_tiles[l_key.tileno] = 1;
+                }
         }
 
         return OPJ_TRUE;
@@ -9544,11 +11130,25 @@ static OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
 {
         OPJ_BOOL l_go_on = OPJ_TRUE;
         OPJ_UINT32 l_current_tile_no;
-        OPJ_UINT32 l_data_size,l_max_data_size;
+        OPJ_SIZE_T l_data_size,l_max_data_size;
         OPJ_INT32 l_tile_x0,l_tile_y0,l_tile_x1,l_tile_y1;
         OPJ_UINT32 l_nb_comps;
         OPJ_BYTE * l_current_data;
         OPJ_UINT32 nr_tiles = 0;
+        /* the tiles are packed for the cache even if the image is not built */
+        OPJ_BOOL l_skip_image = p_j2k->m_cp.m_specific_param.m_dec.m_skip_image && ! p_j2k->m_specific_param.m_decoder.m_tile_cache;
+
+        if (p_j2k->m_specific_param.m_decoder.m_tile_cache) {
+                OPJ_BOOL l_all_cached;
+
+                if (! opj_j2k_output_cached_tiles(p_j2k, &l_all_cached, p_manager)) {
+                        return OPJ_FALSE;
+                }
+                if (l_all_cached) {
+                        /* no need to read the codestream */
+                        return OPJ_TRUE;
+                }
+        }
 
         l_current_data = (OPJ_BYTE*)opj_malloc(1000);
         if (! l_current_data) {
@@ -9575,7 +11175,11 @@ static OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
                         break;
                 }
 
-                if (l_data_size > l_max_data_size) {
+                /* without output image, the samples are only read from the tile decoder */
+                if (l_skip_image) {
+                        l_data_size = 0;
+                }
+                else if (l_data_size > l_max_data_size) {
                         OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(l_current_data, l_data_size);
                         if (! l_new_current_data) {
                                 opj_free(l_current_data);
@@ -9586,24 +11190,31 @@ static OPJ_BOOL opj_j2k_decode_tiles ( opj_j2k_t *p_j2k,
                         l_max_data_size = l_data_size;
                 }
 
-                if (! opj_j2k_decode_tile(p_j2k,l_current_tile_no,l_current_data,l_data_size,p_stream,p_manager)) {
+                if (! opj_j2k_decode_tile(p_j2k,l_current_tile_no,l_skip_image ? 00 : l_current_data,l_data_size,p_stream,p_manager)) {
                         opj_free(l_current_data);
                         opj_event_msg(p_manager, EVT_ERROR, "Failed to decode tile %d/%d\n", l_current_tile_no +1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
                         return OPJ_FALSE;
                 }
                 opj_event_msg(p_manager, EVT_INFO, "Tile %d/%d has been decoded.\n", l_current_tile_no +1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
 
-                if (! opj_j2k_update_image_data(p_j2k->m_tcd,l_current_data, p_j2k->m_output_image)) {
+                if (! opj_j2k_output_tile(p_j2k, l_current_tile_no, l_current_data, p_manager)) {
                         opj_free(l_current_data);
                         return OPJ_FALSE;
                 }
-                opj_event_msg(p_manager, EVT_INFO, "Image data has been updated with tile %d.\n\n", l_current_tile_no + 1);
                 
                 if(opj_stream_get_number_byte_left(p_stream) == 0  
                     && p_j2k->m_specific_param.m_decoder.m_state == J2K_STATE_NEOC)
                     break;
                 if(++nr_tiles ==  p_j2k->m_cp.th * p_j2k->m_cp.tw) 
                     break;
+
+                if (p_j2k->m_specific_param.m_decoder.m_deadline > 0 &&
+                    opj_clock() > p_j2k->m_specific_param.m_decoder.m_deadline) {
+                        opj_free(l_current_data);
+                        p_j2k->m_specific_param.m_decoder.m_deadline_reached = 1;
+                        opj_event_msg(p_manager, EVT_INFO, "Decoding given up after %d/%d tiles, out of time\n", nr_tiles, p_j2k->m_cp.th * p_j2k->m_cp.tw);
+                        return OPJ_FALSE;
+                }
         }
 
         opj_free(l_current_data);
@@ -9638,10 +11249,23 @@ static OPJ_BOOL opj_j2k_decode_one_tile (       opj_j2k_t *p_j2k,
         OPJ_BOOL l_go_on = OPJ_TRUE;
         OPJ_UINT32 l_current_tile_no;
         OPJ_UINT32 l_tile_no_to_dec;
-        OPJ_UINT32 l_data_size,l_max_data_size;
+        OPJ_SIZE_T l_data_size,l_max_data_size;
         OPJ_INT32 l_tile_x0,l_tile_y0,l_tile_x1,l_tile_y1;
         OPJ_UINT32 l_nb_comps;
         OPJ_BYTE * l_current_data;
+        /* the tiles are packed for the cache even if the image is not built */
+        OPJ_BOOL l_skip_image = p_j2k->m_cp.m_specific_param.m_dec.m_skip_image && ! p_j2k->m_specific_param.m_decoder.m_tile_cache;
+
+        if (p_j2k->m_specific_param.m_decoder.m_tile_cache) {
+                opj_tile_cache_key_t l_key;
+                opj_tile_cache_entry_t * l_entry;
+
+                opj_j2k_get_tile_cache_key(p_j2k, (OPJ_UINT32)p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec, &l_key);
+                l_entry = opj_tile_cache_get(p_j2k->m_specific_param.m_decoder.m_tile_cache, &l_key);
+                if (l_entry) {
+                        return opj_j2k_output_cached_tile(p_j2k, l_entry, p_manager);
+                }
+        }
 
         l_current_data = (OPJ_BYTE*)opj_malloc(1000);
         if (! l_current_data) {
@@ -9702,7 +11326,10 @@ static OPJ_BOOL opj_j2k_decode_one_tile (       opj_j2k_t *p_j2k,
                         break;
                 }
 
-                if (l_data_size > l_max_data_size) {
+                if (l_skip_image) {
+                        l_data_size = 0;
+                }
+                else if (l_data_size > l_max_data_size) {
                         OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(l_current_data, l_data_size);
                         if (! l_new_current_data) {
                                 opj_free(l_current_data);
@@ -9716,17 +11343,16 @@ static OPJ_BOOL opj_j2k_decode_one_tile (       opj_j2k_t *p_j2k,
                         l_max_data_size = l_data_size;
                 }
 
-                if (! opj_j2k_decode_tile(p_j2k,l_current_tile_no,l_current_data,l_data_size,p_stream,p_manager)) {
+                if (! opj_j2k_decode_tile(p_j2k,l_current_tile_no,l_skip_image ? 00 : l_current_data,l_data_size,p_stream,p_manager)) {
                         opj_free(l_current_data);
                         return OPJ_FALSE;
                 }
                 opj_event_msg(p_manager, EVT_INFO, "Tile %d/%d has been decoded.\n", l_current_tile_no, (p_j2k->m_cp.th * p_j2k->m_cp.tw) - 1);
 
-                if (! opj_j2k_update_image_data(p_j2k->m_tcd,l_current_data, p_j2k->m_output_image)) {
+                if (! opj_j2k_output_tile(p_j2k, l_current_tile_no, l_current_data, p_manager)) {
                         opj_free(l_current_data);
                         return OPJ_FALSE;
                 }
-                opj_event_msg(p_manager, EVT_INFO, "Image data has been updated with tile %d.\n\n", l_current_tile_no);
 
                 if(l_current_tile_no == l_tile_no_to_dec)
                 {
@@ -9772,29 +11398,60 @@ OPJ_BOOL opj_j2k_decode(opj_j2k_t * p_j2k,
 {
         OPJ_UINT32 compno;
 
+        OPJ_BOOL l_result;
+
         if (!p_image)
                 return OPJ_FALSE;
-	
+
+        if (! opj_j2k_check_used_comps(p_j2k, p_image, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* a previous decoding may have read further than the first tile-part */
+        if (! opj_j2k_rewind_tiles(p_j2k, p_stream, p_manager)) {
+                return OPJ_FALSE;
+        }
+        p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = -1;
+
+        if (p_j2k->m_output_image) {
+                opj_image_destroy(p_j2k->m_output_image);
+        }
         p_j2k->m_output_image = opj_image_create0();
         if (! (p_j2k->m_output_image)) {
                 return OPJ_FALSE;
         }
         opj_copy_image_header(p_image, p_j2k->m_output_image);
+        opj_j2k_set_native_samples(p_j2k, p_j2k->m_output_image);
 
         /* customization of the decoding */
         opj_j2k_setup_decoding(p_j2k, p_manager);
 
         /* Decode the codestream */
-        if (! opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager)) {
-                opj_image_destroy(p_j2k->m_private_image);
-                p_j2k->m_private_image = NULL;
+        l_result = opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager);
+        opj_free(p_j2k->m_specific_param.m_decoder.m_cached_tiles);
+        p_j2k->m_specific_param.m_decoder.m_cached_tiles = 00;
+        if (! l_result) {
+                /* a decoding given up for lack of time leaves the codestream usable */
+                if (! p_j2k->m_specific_param.m_decoder.m_deadline_reached) {
+                        opj_image_destroy(p_j2k->m_private_image);
+                        p_j2k->m_private_image = NULL;
+                }
                 return OPJ_FALSE;
         }
 
         /* Move data and copy one information from codec to output image*/
         for (compno = 0; compno < p_image->numcomps; compno++) {
                 p_image->comps[compno].resno_decoded = p_j2k->m_output_image->comps[compno].resno_decoded;
+
+                /* samples of a previous decoding of the image */
+                if (p_image->comps[compno].data)
+                        opj_image_data_free(p_image->comps[compno].data);
+                if (p_image->comps[compno].native_data)
+                        opj_image_data_free(p_image->comps[compno].native_data);
+
                 p_image->comps[compno].data = p_j2k->m_output_image->comps[compno].data;
+                p_image->comps[compno].native_size = p_j2k->m_output_image->comps[compno].native_size;
+                p_image->comps[compno].native_data = p_j2k->m_output_image->comps[compno].native_data;
 #if 0
                 char fn[256];
                 sprintf( fn, "/tmp/%d.raw", compno );
@@ -9803,165 +11460,2020 @@ OPJ_BOOL opj_j2k_decode(opj_j2k_t * p_j2k,
                 fclose( debug );
 #endif
                 p_j2k->m_output_image->comps[compno].data = NULL;
+                p_j2k->m_output_image->comps[compno].native_data = NULL;
         }
 
+        opj_j2k_keep_used_comps(p_j2k, p_image);
+
         return OPJ_TRUE;
 }
 
-OPJ_BOOL opj_j2k_get_tile(      opj_j2k_t *p_j2k,
-                                                    opj_stream_private_t *p_stream,
-                                                    opj_image_t* p_image,
-                                                    opj_event_mgr_t * p_manager,
-                                                    OPJ_UINT32 tile_index )
+OPJ_BOOL opj_j2k_decode_strips( opj_j2k_t * p_j2k,
+                                opj_stream_private_t * p_stream,
+                                opj_image_t * p_image,
+                                OPJ_UINT32 p_strip_height,
+                                opj_decoded_strip_fn p_strip_fn,
+                                void * p_user_data,
+                                opj_event_mgr_t * p_manager)
 {
+        OPJ_BOOL l_go_on = OPJ_TRUE;
+        OPJ_UINT32 l_current_tile_no;
+        OPJ_SIZE_T l_data_size;
+        OPJ_INT32 l_tile_x0,l_tile_y0,l_tile_x1,l_tile_y1;
+        OPJ_UINT32 l_nb_comps;
         OPJ_UINT32 compno;
-        OPJ_UINT32 l_tile_x, l_tile_y;
-        opj_image_comp_t* l_img_comp;
+        opj_image_t * l_image = p_j2k->m_private_image;
+        opj_tcp_t * l_tcp;
+        OPJ_BOOL l_result;
 
-        if (!p_image) {
-                opj_event_msg(p_manager, EVT_ERROR, "We need an image previously created.\n");
+        /* preconditions */
+        assert(p_stream != 00);
+        assert(p_j2k != 00);
+        assert(p_manager != 00);
+
+        if (! p_image || ! l_image || ! p_strip_fn || p_strip_height == 0) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_decode_strips needs the image read by opj_read_header, a strip function and a strip height\n");
                 return OPJ_FALSE;
         }
 
-        if ( /*(tile_index < 0) &&*/ (tile_index >= p_j2k->m_cp.tw * p_j2k->m_cp.th) ){
-                opj_event_msg(p_manager, EVT_ERROR, "Tile index provided by the user is incorrect %d (max = %d) \n", tile_index, (p_j2k->m_cp.tw * p_j2k->m_cp.th) - 1);
+        if (p_j2k->m_cp.tw * p_j2k->m_cp.th != 1) {
+                opj_event_msg(p_manager, EVT_ERROR, "Only single-tile codestreams can be decoded by strips (%d tiles)\n", p_j2k->m_cp.tw * p_j2k->m_cp.th);
                 return OPJ_FALSE;
         }
 
-        /* Compute the dimension of the desired tile*/
-        l_tile_x = tile_index % p_j2k->m_cp.tw;
-        l_tile_y = tile_index / p_j2k->m_cp.tw;
+        if (p_image->x0 != l_image->x0 || p_image->y0 != l_image->y0 ||
+            p_image->x1 != l_image->x1 || p_image->y1 != l_image->y1) {
+                opj_event_msg(p_manager, EVT_ERROR, "Decoding areas are not supported when decoding by strips\n");
+                return OPJ_FALSE;
+        }
 
-        p_image->x0 = l_tile_x * p_j2k->m_cp.tdx + p_j2k->m_cp.tx0;
-        if (p_image->x0 < p_j2k->m_private_image->x0)
-                p_image->x0 = p_j2k->m_private_image->x0;
-        p_image->x1 = (l_tile_x + 1) * p_j2k->m_cp.tdx + p_j2k->m_cp.tx0;
-        if (p_image->x1 > p_j2k->m_private_image->x1)
-                p_image->x1 = p_j2k->m_private_image->x1;
+        /* the tile components are decoded strip after strip, do not allocate their data */
+        p_j2k->m_tcd->m_strip_decode = 1;
+        l_result = opj_j2k_read_tile_header(    p_j2k,
+                                                &l_current_tile_no,
+                                                &l_data_size,
+                                                &l_tile_x0, &l_tile_y0,
+                                                &l_tile_x1, &l_tile_y1,
+                                                &l_nb_comps,
+                                                &l_go_on,
+                                                p_stream,
+                                                p_manager);
+        p_j2k->m_tcd->m_strip_decode = 0;
+        if (! l_result) {
+                return OPJ_FALSE;
+        }
+        if (! l_go_on) {
+                opj_event_msg(p_manager, EVT_ERROR, "No tile to decode\n");
+                return OPJ_FALSE;
+        }
 
-        p_image->y0 = l_tile_y * p_j2k->m_cp.tdy + p_j2k->m_cp.ty0;
-        if (p_image->y0 < p_j2k->m_private_image->y0)
-                p_image->y0 = p_j2k->m_private_image->y0;
-        p_image->y1 = (l_tile_y + 1) * p_j2k->m_cp.tdy + p_j2k->m_cp.ty0;
-        if (p_image->y1 > p_j2k->m_private_image->y1)
-                p_image->y1 = p_j2k->m_private_image->y1;
+        l_tcp = &(p_j2k->m_cp.tcps[l_current_tile_no]);
+        if (! l_tcp->m_data) {
+                opj_j2k_tcp_destroy(l_tcp);
+                return OPJ_FALSE;
+        }
 
-        l_img_comp = p_image->comps;
-        for (compno=0; compno < p_image->numcomps; ++compno)
-        {
-                OPJ_INT32 l_comp_x1, l_comp_y1;
+        if (! opj_tcd_decode_tile_strips(       p_j2k->m_tcd,
+                                                l_tcp->m_data,
+                                                l_tcp->m_data_size,
+                                                l_current_tile_no,
+                                                p_strip_height,
+                                                p_strip_fn,
+                                                p_user_data,
+                                                p_j2k->cstr_index, p_manager) ) {
+                opj_j2k_tcp_destroy(l_tcp);
+                p_j2k->m_specific_param.m_decoder.m_state |= 0x8000;/*FIXME J2K_DEC_STATE_ERR;*/
+                opj_event_msg(p_manager, EVT_ERROR, "Failed to decode.\n");
+                return OPJ_FALSE;
+        }
 
-                l_img_comp->factor = p_j2k->m_private_image->comps[compno].factor;
+        for (compno = 0; compno < p_image->numcomps; compno++) {
+                p_image->comps[compno].resno_decoded = l_image->comps[compno].resno_decoded;
+        }
 
-                l_img_comp->x0 = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)p_image->x0, (OPJ_INT32)l_img_comp->dx);
-                l_img_comp->y0 = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)p_image->y0, (OPJ_INT32)l_img_comp->dy);
-                l_comp_x1 = opj_int_ceildiv((OPJ_INT32)p_image->x1, (OPJ_INT32)l_img_comp->dx);
-                l_comp_y1 = opj_int_ceildiv((OPJ_INT32)p_image->y1, (OPJ_INT32)l_img_comp->dy);
+        return opj_j2k_end_tile_decoding(p_j2k, l_tcp, p_stream, p_manager);
+}
 
-                l_img_comp->w = (OPJ_UINT32)(opj_int_ceildivpow2(l_comp_x1, (OPJ_INT32)l_img_comp->factor) - opj_int_ceildivpow2((OPJ_INT32)l_img_comp->x0, (OPJ_INT32)l_img_comp->factor));
-                l_img_comp->h = (OPJ_UINT32)(opj_int_ceildivpow2(l_comp_y1, (OPJ_INT32)l_img_comp->factor) - opj_int_ceildivpow2((OPJ_INT32)l_img_comp->y0, (OPJ_INT32)l_img_comp->factor));
+OPJ_BOOL opj_j2k_decode_within_budget( opj_j2k_t * p_j2k,
+                                       opj_stream_private_t * p_stream,
+                                       opj_image_t * p_image,
+                                       OPJ_FLOAT64 p_max_time,
+                                       opj_decode_report_t * p_report,
+                                       opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        opj_tcp_t * l_default_tcp = l_decoder->m_default_tcp;
+        OPJ_UINT32 l_reduce = p_j2k->m_cp.m_specific_param.m_dec.m_reduce;
+        OPJ_UINT32 l_max_reduce = (OPJ_UINT32)-1;
+        OPJ_UINT32 l_factor, l_best_factor = 0, l_nb_steps = 0;
+        OPJ_UINT32 compno;
+        OPJ_FLOAT64 l_start, l_step_start, l_step_time = 0;
+        opj_image_t * l_best = 00;
+        OPJ_BOOL l_result = OPJ_TRUE;
 
-                l_img_comp++;
+        if (! p_image || ! p_j2k->m_private_image || ! l_default_tcp || ! l_default_tcp->tccps) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_decode_within_budget needs the image read by opj_read_header\n");
+                return OPJ_FALSE;
         }
 
-        /* Destroy the previous output image*/
-        if (p_j2k->m_output_image)
-                opj_image_destroy(p_j2k->m_output_image);
-
-        /* Create the ouput image from the information previously computed*/
-        p_j2k->m_output_image = opj_image_create0();
-        if (! (p_j2k->m_output_image)) {
-                return OPJ_FALSE;
+        /* coarsest resolution factor common to all the components */
+        for (compno = 0; compno < p_j2k->m_private_image->numcomps; compno++) {
+                l_max_reduce = opj_uint_min(l_max_reduce, l_default_tcp->tccps[compno].numresolutions - 1);
         }
-        opj_copy_image_header(p_image, p_j2k->m_output_image);
+        l_max_reduce = opj_uint_max(l_max_reduce, l_reduce);
 
-        p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = (OPJ_INT32)tile_index;
+        l_start = opj_clock();
+        for (l_factor = l_max_reduce + 1; l_factor-- > l_reduce; ) {
+                opj_image_t * l_step;
 
-        /* customization of the decoding */
-        opj_j2k_setup_decoding_tile(p_j2k, p_manager);
+                if (l_nb_steps) {
+                        /* each resolution has about four times the samples of the previous one */
+                        if (opj_clock() - l_start + 4 * l_step_time > p_max_time) {
+                                break;
+                        }
+                        l_decoder->m_deadline = l_start + p_max_time;
+                }
 
-        /* Decode the codestream */
-        if (! opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager)) {
-                opj_image_destroy(p_j2k->m_private_image);
-                p_j2k->m_private_image = NULL;
-                return OPJ_FALSE;
+                if (! opj_j2k_set_decoded_resolution_factor(p_j2k, l_factor, p_manager)) {
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+
+                l_step = opj_image_create0();
+                if (! l_step) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the image\n");
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+                opj_copy_image_header(p_image, l_step);
+                for (compno = 0; compno < l_step->numcomps; compno++) {
+                        opj_image_comp_t * l_comp = &(l_step->comps[compno]);
+
+                        l_comp->factor = l_factor;
+                        l_comp->x0 = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)l_step->x0, (OPJ_INT32)l_comp->dx);
+                        l_comp->y0 = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)l_step->y0, (OPJ_INT32)l_comp->dy);
+                        l_comp->w = (OPJ_UINT32)(opj_int_ceildivpow2(opj_int_ceildiv((OPJ_INT32)l_step->x1, (OPJ_INT32)l_comp->dx), (OPJ_INT32)l_factor)
+                                                 - opj_int_ceildivpow2((OPJ_INT32)l_comp->x0, (OPJ_INT32)l_factor));
+                        l_comp->h = (OPJ_UINT32)(opj_int_ceildivpow2(opj_int_ceildiv((OPJ_INT32)l_step->y1, (OPJ_INT32)l_comp->dy), (OPJ_INT32)l_factor)
+                                                 - opj_int_ceildivpow2((OPJ_INT32)l_comp->y0, (OPJ_INT32)l_factor));
+                }
+
+                l_step_start = opj_clock();
+                l_result = opj_j2k_decode(p_j2k, p_stream, l_step, p_manager);
+                l_step_time = opj_clock() - l_step_start;
+                l_decoder->m_deadline = 0;
+
+                if (! l_result) {
+                        opj_image_destroy(l_step);
+                        if (l_decoder->m_deadline_reached) {
+                                /* keep the previous decoding */
+                                l_decoder->m_deadline_reached = 0;
+                                l_result = OPJ_TRUE;
+                        }
+                        break;
+                }
+
+                opj_image_destroy(l_best);
+                l_best = l_step;
+                l_best_factor = l_factor;
+                ++l_nb_steps;
         }
 
-        /* Move data and copy one information from codec to output image*/
-        for (compno = 0; compno < p_image->numcomps; compno++) {
-                p_image->comps[compno].resno_decoded = p_j2k->m_output_image->comps[compno].resno_decoded;
+        if (! l_result || ! p_j2k->m_private_image) {
+                opj_image_destroy(l_best);
+                return OPJ_FALSE;
+        }
+        if (! opj_j2k_set_decoded_resolution_factor(p_j2k, l_reduce, p_manager)) {
+                opj_image_destroy(l_best);
+                return OPJ_FALSE;
+        }
 
-                if (p_image->comps[compno].data)
-                        opj_free(p_image->comps[compno].data);
+        /* give the components of the best decoding to the caller */
+        if (p_image->comps) {
+                for (compno = 0; compno < p_image->numcomps; compno++) {
+                        if (p_image->comps[compno].data)
+                                opj_image_data_free(p_image->comps[compno].data);
+                        if (p_image->comps[compno].native_data)
+                                opj_image_data_free(p_image->comps[compno].native_data);
+                }
+                opj_free(p_image->comps);
+        }
+        p_image->numcomps = l_best->numcomps;
+        p_image->comps = l_best->comps;
+        l_best->numcomps = 0;
+        l_best->comps = 00;
+        opj_image_destroy(l_best);
 
-                p_image->comps[compno].data = p_j2k->m_output_image->comps[compno].data;
+        if (p_report) {
+                OPJ_UINT32 l_layers = l_default_tcp->numlayers;
 
-                p_j2k->m_output_image->comps[compno].data = NULL;
+                if (p_j2k->m_cp.m_specific_param.m_dec.m_layer) {
+                        l_layers = opj_uint_min(l_layers, p_j2k->m_cp.m_specific_param.m_dec.m_layer);
+                }
+                p_report->reduce = l_best_factor;
+                p_report->layers = l_layers;
+                p_report->nb_steps = l_nb_steps;
+                p_report->complete = (l_best_factor == l_reduce);
+                p_report->time = opj_clock() - l_start;
         }
 
         return OPJ_TRUE;
 }
 
-OPJ_BOOL opj_j2k_set_decoded_resolution_factor(opj_j2k_t *p_j2k,
-                                               OPJ_UINT32 res_factor,
-                                               opj_event_mgr_t * p_manager)
+static OPJ_BOOL opj_j2k_scan_tile_part_header ( OPJ_BYTE * p_data,
+                                                OPJ_SIZE_T p_size,
+                                                OPJ_UINT32 * p_tot_len,
+                                                OPJ_SIZE_T * p_header_size,
+                                                opj_event_mgr_t * p_manager )
 {
-        OPJ_UINT32 it_comp;
+        OPJ_UINT32 l_marker_id, l_marker_size;
+        OPJ_UINT32 l_tileno, l_current_part, l_num_parts;
+        OPJ_SIZE_T l_pos, l_end;
 
-        p_j2k->m_cp.m_specific_param.m_dec.m_reduce = res_factor;
+        *p_header_size = 0;
 
-        if (p_j2k->m_private_image) {
-                if (p_j2k->m_private_image->comps) {
-                        if (p_j2k->m_specific_param.m_decoder.m_default_tcp) {
-                                if (p_j2k->m_specific_param.m_decoder.m_default_tcp->tccps) {
-                                        for (it_comp = 0 ; it_comp < p_j2k->m_private_image->numcomps; it_comp++) {
-                                                OPJ_UINT32 max_res = p_j2k->m_specific_param.m_decoder.m_default_tcp->tccps[it_comp].numresolutions;
-                                                if ( res_factor >= max_res){
-                                                        opj_event_msg(p_manager, EVT_ERROR, "Resolution factor is greater than the maximum resolution in the component.\n");
-                                                        return OPJ_FALSE;
-                                                }
-                                                p_j2k->m_private_image->comps[it_comp].factor = res_factor;
-                                        }
-                                        return OPJ_TRUE;
-                                }
-                        }
+        /* SOT marker segment */
+        if (p_size < 12) {
+                return OPJ_TRUE;
+        }
+        opj_read_bytes(p_data + 2, &l_marker_size, 2);
+        if (l_marker_size != 10 ||
+            ! opj_j2k_get_sot_values(p_data + 4, 8, &l_tileno, p_tot_len, &l_current_part, &l_num_parts, p_manager)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Error reading SOT marker\n");
+                return OPJ_FALSE;
+        }
+        /* Psot = 0: the tile-part ends with the codestream */
+        l_end = *p_tot_len ? *p_tot_len : p_size;
+
+        /* the other marker segments, up to the SOD marker */
+        l_pos = 12;
+        while (l_pos < l_end) {
+                if (p_size < l_pos + 2) {
+                        return OPJ_TRUE;
+                }
+                opj_read_bytes(p_data + l_pos, &l_marker_id, 2);
+                if (l_marker_id == J2K_MS_SOD) {
+                        l_pos += 2;
+                        break;
+                }
+                if (p_size < l_pos + 4) {
+                        return OPJ_TRUE;
+                }
+                opj_read_bytes(p_data + l_pos + 2, &l_marker_size, 2);
+                if (l_marker_size < 2) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Inconsistent marker size\n");
+                        return OPJ_FALSE;
+                }
+                if (p_size < l_pos + 2 + l_marker_size) {
+                        return OPJ_TRUE;
                 }
+                l_pos += 2 + l_marker_size;
+        }
+        if (l_pos > l_end) {
+                opj_event_msg(p_manager, EVT_ERROR, "Tile-part header larger than its tile-part (Psot = %d)\n", *p_tot_len);
+                return OPJ_FALSE;
         }
 
-        return OPJ_FALSE;
+        *p_header_size = l_pos;
+        return OPJ_TRUE;
 }
 
-OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
-                        opj_stream_private_t *p_stream,
-                        opj_event_mgr_t * p_manager )
+static OPJ_BOOL opj_j2k_read_tile_part_markers (opj_j2k_t * p_j2k,
+                                                OPJ_BYTE * p_data,
+                                                OPJ_SIZE_T p_header_size,
+                                                OPJ_BOOL p_all_tiles,
+                                                OPJ_BOOL * p_skip,
+                                                OPJ_BOOL * p_last,
+                                                opj_event_mgr_t * p_manager )
 {
-        OPJ_UINT32 i, j;
-        OPJ_UINT32 l_nb_tiles;
-        OPJ_UINT32 l_max_tile_size = 0, l_current_tile_size;
-        OPJ_BYTE * l_current_data = 00;
-        opj_tcd_t* p_tcd = 00;
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        OPJ_UINT32 l_marker_id, l_marker_size;
+        OPJ_BOOL l_result = OPJ_TRUE;
 
-        /* preconditions */
-        assert(p_j2k != 00);
-        assert(p_stream != 00);
-        assert(p_manager != 00);
-	
-        p_tcd = p_j2k->m_tcd;
+        if (! opj_j2k_read_sot(p_j2k, p_data + 4, 8, p_manager)) {
+                l_result = OPJ_FALSE;
+        }
+        else if (p_all_tiles || ! l_decoder->m_skip_data) {
+                OPJ_SIZE_T l_marker_pos = 12;
 
-        l_nb_tiles = p_j2k->m_cp.th * p_j2k->m_cp.tw;
-        for (i=0;i<l_nb_tiles;++i) {
-                if (! opj_j2k_pre_write_tile(p_j2k,i,p_stream,p_manager)) {
-                        if (l_current_data) {
-                                opj_free(l_current_data);
-                        }
-                        return OPJ_FALSE;
-                }
+                l_result = opj_j2k_materialize_tcp(p_j2k, p_j2k->m_current_tile_number, p_manager);
+
+                while (l_result && l_marker_pos + 2 < p_header_size) {
+                        const opj_dec_memory_marker_handler_t * l_marker_handler;
+
+                        opj_read_bytes(p_data + l_marker_pos, &l_marker_id, 2);
+                        opj_read_bytes(p_data + l_marker_pos + 2, &l_marker_size, 2);
+
+                        l_marker_handler = opj_j2k_get_marker_handler(l_marker_id);
+                        if (! (l_decoder->m_state & l_marker_handler->states)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Marker is not compliant with its position\n");
+                                l_result = OPJ_FALSE;
+                        }
+                        else if (! l_marker_handler->handler) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Unknown marker %#x in the header of tile %d\n", l_marker_id, p_j2k->m_current_tile_number + 1);
+                                l_result = OPJ_FALSE;
+                        }
+                        else if (! (*(l_marker_handler->handler))(p_j2k, p_data + l_marker_pos + 4, l_marker_size - 2, p_manager)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Fail to read the current marker segment (%#x)\n", l_marker_id);
+                                l_result = OPJ_FALSE;
+                        }
+                        l_marker_pos += 2 + l_marker_size;
+                }
+
+                if (l_result && p_j2k->m_cp.tcps[p_j2k->m_current_tile_number].ppt) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Packed packet headers (PPT) are not supported here\n");
+                        l_result = OPJ_FALSE;
+                }
+        }
+
+        *p_skip = l_decoder->m_skip_data && ! p_all_tiles;
+        *p_last = l_decoder->m_can_decode;
+
+        /* the next tile-part header is read the same way, or by opj_j2k_read_tile_header */
+        l_decoder->m_state = J2K_STATE_TPHSOT;
+        l_decoder->m_can_decode = 0;
+        l_decoder->m_skip_data = 0;
+        l_decoder->m_last_tile_part = 0;
+
+        return l_result;
+}
+
+static OPJ_BOOL opj_j2k_incr_read_tile_part_header (    opj_j2k_t * p_j2k,
+                                                        OPJ_BYTE * p_data,
+                                                        OPJ_SIZE_T p_size,
+                                                        OPJ_SIZE_T * p_header_size,
+                                                        opj_event_mgr_t * p_manager )
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        OPJ_UINT32 l_tot_len;
+        OPJ_SIZE_T l_header_size;
+        OPJ_BOOL l_skip, l_last;
+
+        *p_header_size = 0;
+
+        if (! opj_j2k_scan_tile_part_header(p_data, p_size, &l_tot_len, &l_header_size, p_manager)) {
+                return OPJ_FALSE;
+        }
+        if (! l_header_size) {
+                return OPJ_TRUE;
+        }
+        if (! l_tot_len) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_decode_incremental needs the length of each tile-part (Psot)\n");
+                return OPJ_FALSE;
+        }
+
+        /* the header is complete: read it */
+        if (! opj_j2k_read_tile_part_markers(p_j2k, p_data, l_header_size, OPJ_FALSE, &l_skip, &l_last, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        l_decoder->m_incr_tile = p_j2k->m_current_tile_number;
+        l_decoder->m_incr_tp_left = l_tot_len - (OPJ_UINT32)l_header_size;
+        l_decoder->m_incr_skip = (l_skip != 0);
+        l_decoder->m_incr_last_tp = (l_last != 0);
+        *p_header_size = l_header_size;
+
+        /* a last tile-part without data */
+        if (! l_decoder->m_incr_tp_left && l_last && ! l_skip) {
+                return opj_tcd_feed_tile(p_j2k->m_tcd, l_decoder->m_incr_tile, 00, 0, OPJ_TRUE, p_manager);
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_incr_read_data (opj_j2k_t * p_j2k,
+                                        OPJ_BYTE * p_data,
+                                        OPJ_SIZE_T p_size,
+                                        OPJ_SIZE_T * p_read,
+                                        opj_event_mgr_t * p_manager )
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        opj_tcd_t * l_tcd = p_j2k->m_tcd;
+        OPJ_SIZE_T l_pos = 0;
+        OPJ_UINT32 l_marker_id;
+
+        *p_read = 0;
+
+        while (! l_decoder->m_incr_complete) {
+                /* data of the current tile-part */
+                if (l_decoder->m_incr_tp_left) {
+                        OPJ_UINT32 l_len = l_decoder->m_incr_tp_left;
+
+                        if ((OPJ_SIZE_T)l_len > p_size - l_pos) {
+                                l_len = (OPJ_UINT32)(p_size - l_pos);
+                        }
+
+                        if (! l_len) {
+                                break;
+                        }
+                        l_decoder->m_incr_tp_left -= l_len;
+                        if (! l_decoder->m_incr_skip &&
+                            ! opj_tcd_feed_tile(l_tcd, l_decoder->m_incr_tile, p_data + l_pos, l_len,
+                                                ! l_decoder->m_incr_tp_left && l_decoder->m_incr_last_tp, p_manager)) {
+                                return OPJ_FALSE;
+                        }
+                        l_pos += l_len;
+                        *p_read = l_pos;
+                        continue;
+                }
+
+                if (p_size - l_pos < 2) {
+                        break;
+                }
+                opj_read_bytes(p_data + l_pos, &l_marker_id, 2);
+
+                if (l_marker_id == J2K_MS_EOC) {
+                        /* the tiles whose number of tile-parts was not known have all their data */
+                        if (l_tcd->m_incr_tiles) {
+                                OPJ_UINT32 tileno;
+
+                                for (tileno = 0; tileno < p_j2k->m_cp.tw * p_j2k->m_cp.th; ++tileno) {
+                                        opj_tcd_incr_tile_t * l_incr = l_tcd->m_incr_tiles + tileno;
+
+                                        if ((l_incr->tile || l_incr->data) && ! l_incr->final &&
+                                            ! opj_tcd_feed_tile(l_tcd, tileno, 00, 0, OPJ_TRUE, p_manager)) {
+                                                return OPJ_FALSE;
+                                        }
+                                }
+                        }
+                        l_decoder->m_incr_complete = 1;
+                        l_pos += 2;
+                        *p_read = l_pos;
+                }
+                else if (l_marker_id == J2K_MS_SOT) {
+                        OPJ_SIZE_T l_header_size;
+
+                        if (! opj_j2k_incr_read_tile_part_header(p_j2k, p_data + l_pos, p_size - l_pos, &l_header_size, p_manager)) {
+                                return OPJ_FALSE;
+                        }
+                        if (! l_header_size) {
+                                break;
+                        }
+                        l_pos += l_header_size;
+                        *p_read = l_pos;
+                }
+                else {
+                        opj_event_msg(p_manager, EVT_ERROR, "Expected a SOT or EOC marker, found %#x\n", l_marker_id);
+                        return OPJ_FALSE;
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_incr_decode_tiles ( opj_j2k_t * p_j2k,
+                                            opj_image_t * p_image,
+                                            opj_event_mgr_t * p_manager )
+{
+        opj_tcd_t * l_tcd = p_j2k->m_tcd;
+        opj_image_t * l_image = l_tcd->image;
+        const OPJ_BOOL * l_used = p_j2k->m_specific_param.m_decoder.m_used_comps;
+        opj_tile_cache_comp_t * l_comps;
+        OPJ_BYTE * l_data = 00;
+        OPJ_SIZE_T l_data_max_size = 0;
+        OPJ_UINT32 tileno, compno;
+        OPJ_BOOL l_result = OPJ_TRUE;
+
+        if (! l_tcd->m_incr_tiles) {
+                return OPJ_TRUE;
+        }
+
+        l_comps = (opj_tile_cache_comp_t *) opj_malloc(l_image->numcomps * sizeof(opj_tile_cache_comp_t));
+        if (! l_comps) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the tiles\n");
+                return OPJ_FALSE;
+        }
+
+        for (tileno = 0; l_result && tileno < p_j2k->m_cp.tw * p_j2k->m_cp.th; ++tileno) {
+                opj_tcd_tile_t * l_tile;
+                OPJ_SIZE_T l_data_size;
+                OPJ_BOOL l_modified;
+
+                if (! l_tcd->m_incr_tiles[tileno].fed) {
+                        continue;
+                }
+
+                l_result = opj_tcd_decode_tile_incremental(l_tcd, tileno, &l_modified, p_manager);
+                if (! l_result || ! l_modified) {
+                        opj_tcd_end_tile_incremental(l_tcd, tileno);
+                        continue;
+                }
+
+                /* copy the samples of the tile into the image */
+                l_tile = l_tcd->tcd_image->tiles;
+                for (compno = 0; compno < l_image->numcomps; ++compno) {
+                        opj_tcd_resolution_t * l_res = l_tile->comps[compno].resolutions + l_image->comps[compno].resno_decoded;
+
+                        l_comps[compno].x0 = l_res->x0;
+                        l_comps[compno].y0 = l_res->y0;
+                        l_comps[compno].x1 = l_res->x1;
+                        l_comps[compno].y1 = l_res->y1;
+                        l_comps[compno].resno_decoded = l_image->comps[compno].resno_decoded;
+                }
+
+                l_data_size = opj_tcd_get_decoded_tile_size(l_tcd);
+                if (l_data_size > l_data_max_size) {
+                        OPJ_BYTE * l_new_data = (OPJ_BYTE *) opj_realloc(l_data, l_data_size);
+                        if (! l_new_data) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile %d\n", tileno + 1);
+                                l_result = OPJ_FALSE;
+                        }
+                        else {
+                                l_data = l_new_data;
+                                l_data_max_size = l_data_size;
+                        }
+                }
+
+                l_result = l_result &&
+                           opj_tcd_update_tile_data(l_tcd, l_data, l_data_size) &&
+                           opj_j2k_update_image_data(l_image, l_comps, l_used, l_data, p_image);
+
+                opj_tcd_end_tile_incremental(l_tcd, tileno);
+        }
+
+        opj_free(l_comps);
+        opj_free(l_data);
+
+        return l_result;
+}
+
+OPJ_BOOL opj_j2k_decode_incremental( opj_j2k_t * p_j2k,
+                                     opj_stream_private_t * p_stream,
+                                     opj_image_t * p_image,
+                                     OPJ_BOOL * p_complete,
+                                     opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        OPJ_BYTE * l_buffer = 00;
+        OPJ_SIZE_T l_buffer_size = OPJ_J2K_INCR_CHUNK_SIZE;
+        OPJ_SIZE_T l_size = 0;
+        OPJ_BOOL l_end_of_stream = OPJ_FALSE;
+        OPJ_BOOL l_result = OPJ_TRUE;
+        OPJ_UINT32 compno;
+
+        /* preconditions */
+        assert(p_stream != 00);
+        assert(p_j2k != 00);
+        assert(p_manager != 00);
+
+        if (! p_image || ! p_complete || ! p_j2k->m_private_image || ! p_j2k->m_tcd || ! p_j2k->cstr_index) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_decode_incremental needs the image read by opj_read_header\n");
+                return OPJ_FALSE;
+        }
+        if (! opj_j2k_check_used_comps(p_j2k, p_image, p_manager)) {
+                return OPJ_FALSE;
+        }
+        if (p_j2k->m_cp.ppm) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_decode_incremental does not support packed packet headers (PPM)\n");
+                return OPJ_FALSE;
+        }
+
+        *p_complete = OPJ_FALSE;
+        if (l_decoder->m_incr_complete) {
+                *p_complete = OPJ_TRUE;
+                return OPJ_TRUE;
+        }
+
+        /* the first call starts from the first tile-part */
+        if (! l_decoder->m_incr_pos) {
+                l_decoder->m_incr_pos = (OPJ_OFF_T)p_j2k->cstr_index->main_head_end;
+                l_decoder->m_tile_ind_to_dec = -1;
+        }
+        p_j2k->m_tcd->m_used_comps = l_decoder->m_used_comps;
+
+        if (! opj_stream_read_seek(p_stream, l_decoder->m_incr_pos, p_manager)) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_decode_incremental needs a stream able to seek\n");
+                return OPJ_FALSE;
+        }
+
+        l_buffer = (OPJ_BYTE *) opj_malloc(l_buffer_size);
+        if (! l_buffer) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the codestream\n");
+                return OPJ_FALSE;
+        }
+
+        /* read the bytes received since the previous call, a tile-part header being read once complete */
+        while (l_result && ! l_end_of_stream && ! l_decoder->m_incr_complete) {
+                OPJ_SIZE_T l_nb_read;
+                OPJ_SIZE_T l_nb_used;
+
+                if (l_size == l_buffer_size) {
+                        OPJ_BYTE * l_new_buffer = (OPJ_BYTE *) opj_realloc(l_buffer, 2 * l_buffer_size);
+                        if (! l_new_buffer) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the codestream\n");
+                                l_result = OPJ_FALSE;
+                                break;
+                        }
+                        l_buffer = l_new_buffer;
+                        l_buffer_size *= 2;
+                }
+
+                l_nb_read = opj_stream_read_data(p_stream, l_buffer + l_size, l_buffer_size - l_size, p_manager);
+                if (l_nb_read == (OPJ_SIZE_T)-1) {
+                        l_nb_read = 0;
+                }
+                l_end_of_stream = (l_nb_read < l_buffer_size - l_size);
+                l_size += l_nb_read;
+
+                l_result = opj_j2k_incr_read_data(p_j2k, l_buffer, l_size, &l_nb_used, p_manager);
+                memmove(l_buffer, l_buffer + l_nb_used, l_size - l_nb_used);
+                l_size -= l_nb_used;
+                l_decoder->m_incr_pos += (OPJ_OFF_T)l_nb_used;
+        }
+        opj_free(l_buffer);
+
+        l_result = l_result && opj_j2k_incr_decode_tiles(p_j2k, p_image, p_manager);
+
+        if (! l_result) {
+                /* the decoding starts again at the next call */
+                opj_tcd_free_incremental_tiles(p_j2k->m_tcd);
+                l_decoder->m_incr_pos = 0;
+                l_decoder->m_incr_tp_left = 0;
+                l_decoder->m_incr_complete = 0;
+                return OPJ_FALSE;
+        }
+
+        if (l_decoder->m_incr_complete) {
+                for (compno = 0; compno < p_image->numcomps; compno++) {
+                        p_image->comps[compno].resno_decoded = p_j2k->m_private_image->comps[compno].resno_decoded;
+                }
+                opj_j2k_keep_used_comps(p_j2k, p_image);
+                opj_tcd_free_incremental_tiles(p_j2k->m_tcd);
+                *p_complete = OPJ_TRUE;
+        }
+
+        return OPJ_TRUE;
+}
+
+static int opj_j2k_compare_tile_parts (const void * p_tp1, const void * p_tp2)
+{
+        const opj_j2k_tile_part_t * l_tp1 = (const opj_j2k_tile_part_t *) p_tp1;
+        const opj_j2k_tile_part_t * l_tp2 = (const opj_j2k_tile_part_t *) p_tp2;
+
+        if (l_tp1->tileno != l_tp2->tileno) {
+                return (l_tp1->tileno < l_tp2->tileno) ? -1 : 1;
+        }
+        return (l_tp1->rank < l_tp2->rank) ? -1 : (l_tp1->rank > l_tp2->rank);
+}
+
+static void opj_j2k_free_tile_parts (opj_j2k_tile_part_t * p_tile_parts, OPJ_UINT32 p_nb_tile_parts)
+{
+        OPJ_UINT32 i;
+
+        for (i = 0; i < p_nb_tile_parts; ++i) {
+                opj_free(p_tile_parts[i].header);
+        }
+        opj_free(p_tile_parts);
+}
+
+static OPJ_BOOL opj_j2k_read_tile_parts (       opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_stream,
+                                                opj_j2k_tile_part_t ** p_tile_parts,
+                                                OPJ_UINT32 * p_nb_tile_parts,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_j2k_tile_part_t * l_tile_parts = 00;
+        OPJ_UINT32 l_nb_tile_parts = 0;
+        OPJ_UINT32 l_max_tile_parts = 0;
+        OPJ_BYTE * l_buffer = 00;
+        OPJ_SIZE_T l_buffer_size = 0;
+        OPJ_OFF_T l_pos = (OPJ_OFF_T)p_j2k->cstr_index->main_head_end;
+        OPJ_BOOL l_last = OPJ_FALSE;
+        OPJ_BOOL l_result = OPJ_TRUE;
+
+        *p_tile_parts = 00;
+        *p_nb_tile_parts = 0;
+
+        while (l_result && ! l_last) {
+                opj_j2k_tile_part_t * l_tile_part;
+                OPJ_SIZE_T l_size = 0;
+                OPJ_SIZE_T l_header_size = 0;
+                OPJ_UINT32 l_marker_id, l_tot_len;
+                OPJ_OFF_T l_data_size;
+                OPJ_BOOL l_skip, l_last_tp;
+
+                if (! opj_stream_read_seek(p_stream, l_pos, p_manager)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "opj_transcode needs a stream able to seek\n");
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+
+                /* read the tile-part header, the buffer growing until it holds it entirely */
+                while (! l_header_size) {
+                        OPJ_SIZE_T l_nb_read;
+
+                        if (l_size == l_buffer_size) {
+                                OPJ_SIZE_T l_new_size = l_buffer_size ? 2 * l_buffer_size : 1024;
+                                OPJ_BYTE * l_new_buffer = (OPJ_BYTE *) opj_realloc(l_buffer, l_new_size);
+                                if (! l_new_buffer) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read a tile-part header\n");
+                                        l_result = OPJ_FALSE;
+                                        break;
+                                }
+                                l_buffer = l_new_buffer;
+                                l_buffer_size = l_new_size;
+                        }
+
+                        l_nb_read = opj_stream_read_data(p_stream, l_buffer + l_size, l_buffer_size - l_size, p_manager);
+                        if (l_nb_read == (OPJ_SIZE_T)-1) {
+                                l_nb_read = 0;
+                        }
+                        l_size += l_nb_read;
+
+                        if (l_size >= 2) {
+                                opj_read_bytes(l_buffer, &l_marker_id, 2);
+                                if (l_marker_id == J2K_MS_EOC) {
+                                        break;
+                                }
+                                if (l_marker_id != J2K_MS_SOT) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Expected a SOT marker instead of %#x\n", l_marker_id);
+                                        l_result = OPJ_FALSE;
+                                        break;
+                                }
+                        }
+                        if (! opj_j2k_scan_tile_part_header(l_buffer, l_size, &l_tot_len, &l_header_size, p_manager)) {
+                                l_result = OPJ_FALSE;
+                                break;
+                        }
+                        if (! l_header_size && l_size < l_buffer_size) {
+                                /* end of the stream */
+                                if (l_size >= 2) {
+                                        opj_event_msg(p_manager, EVT_WARNING, "Truncated tile-part header, the codestream ends there\n");
+                                }
+                                else {
+                                        opj_event_msg(p_manager, EVT_WARNING, "Stream does not end with EOC\n");
+                                }
+                                break;
+                        }
+                }
+                if (! l_result || ! l_header_size) {
+                        break;
+                }
+
+                /* find the data of the tile-part, the last one of a truncated codestream being cut short */
+                l_data_size = opj_stream_get_number_byte_left(p_stream) + (OPJ_OFF_T)(l_size - l_header_size);
+                if (! l_tot_len) {
+                        /* Psot = 0: the data goes on up to the EOC marker */
+                        l_data_size -= 2;
+                        l_last = OPJ_TRUE;
+                }
+                else if ((OPJ_OFF_T)(l_tot_len - l_header_size) <= l_data_size) {
+                        l_data_size = (OPJ_OFF_T)(l_tot_len - l_header_size);
+                }
+                else {
+                        opj_event_msg(p_manager, EVT_WARNING, "Truncated tile-part, the codestream ends there\n");
+                        l_last = OPJ_TRUE;
+                }
+                if (l_data_size < 0) {
+                        l_data_size = 0;
+                }
+                if (l_data_size > (OPJ_OFF_T)0xFFFFFFFFU) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Tile-part too large\n");
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+
+                /* the markers of the header update the coding parameters of the tile */
+                if (! opj_j2k_read_tile_part_markers(p_j2k, l_buffer, l_header_size, OPJ_TRUE, &l_skip, &l_last_tp, p_manager)) {
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+
+                if (l_nb_tile_parts == l_max_tile_parts) {
+                        opj_j2k_tile_part_t * l_new_tile_parts;
+
+                        l_max_tile_parts = l_max_tile_parts ? 2 * l_max_tile_parts : 64;
+                        l_new_tile_parts = (opj_j2k_tile_part_t *) opj_realloc(l_tile_parts, l_max_tile_parts * sizeof(opj_j2k_tile_part_t));
+                        if (! l_new_tile_parts) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the tile-parts\n");
+                                l_result = OPJ_FALSE;
+                                break;
+                        }
+                        l_tile_parts = l_new_tile_parts;
+                }
+
+                l_tile_part = &l_tile_parts[l_nb_tile_parts];
+                l_tile_part->tileno = p_j2k->m_current_tile_number;
+                l_tile_part->rank = l_nb_tile_parts;
+                l_tile_part->header_size = (OPJ_UINT32)(l_header_size - 14);
+                l_tile_part->header = (OPJ_BYTE *) opj_malloc(l_tile_part->header_size + 1);
+                if (! l_tile_part->header) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the tile-parts\n");
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+                memcpy(l_tile_part->header, l_buffer + 12, l_tile_part->header_size);
+                l_tile_part->data_pos = l_pos + (OPJ_OFF_T)l_header_size;
+                l_tile_part->data_size = (OPJ_UINT32)l_data_size;
+                ++l_nb_tile_parts;
+
+                l_pos = l_tile_part->data_pos + l_data_size;
+        }
+        opj_free(l_buffer);
+
+        if (! l_result) {
+                opj_j2k_free_tile_parts(l_tile_parts, l_nb_tile_parts);
+                return OPJ_FALSE;
+        }
+
+        if (l_nb_tile_parts) {
+                qsort(l_tile_parts, l_nb_tile_parts, sizeof(opj_j2k_tile_part_t), opj_j2k_compare_tile_parts);
+        }
+        *p_tile_parts = l_tile_parts;
+        *p_nb_tile_parts = l_nb_tile_parts;
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_transcode_siz_axis (    OPJ_UINT32 * p_size,
+                                                OPJ_UINT32 * p_offset,
+                                                OPJ_UINT32 * p_tile_size,
+                                                OPJ_UINT32 * p_tile_offset,
+                                                OPJ_UINT32 p_nb_tiles,
+                                                OPJ_UINT32 p_reduce )
+{
+        OPJ_UINT32 l_mask = (1U << p_reduce) - 1U;
+        OPJ_UINT64 l_nb_tiles;
+
+        /* the tiles of the reduced image are the reduced tiles if they are aligned on the removed levels */
+        if (p_nb_tiles > 1 && ((*p_tile_size & l_mask) || (*p_tile_offset & l_mask))) {
+                return OPJ_FALSE;
+        }
+
+        *p_size = opj_uint_ceildivpow2(*p_size, p_reduce);
+        *p_offset = opj_uint_ceildivpow2(*p_offset, p_reduce);
+        *p_tile_size = opj_uint_ceildivpow2(*p_tile_size, p_reduce);
+        *p_tile_offset = opj_uint_ceildivpow2(*p_tile_offset, p_reduce);
+
+        l_nb_tiles = ((OPJ_UINT64)*p_size - *p_tile_offset + *p_tile_size - 1U) / *p_tile_size;
+        return (l_nb_tiles == p_nb_tiles) && (*p_offset - *p_tile_offset < *p_tile_size);
+}
+
+static OPJ_BOOL opj_j2k_transcode_spcod (       OPJ_BYTE * p_data,
+                                                OPJ_UINT32 p_size,
+                                                OPJ_BOOL p_precincts,
+                                                OPJ_UINT32 p_reduce,
+                                                OPJ_UINT32 * p_size_kept,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_nb_levels;
+
+        *p_size_kept = p_size;
+        if (p_size < 5) {
+                opj_event_msg(p_manager, EVT_ERROR, "Error reading SPCod SPCoc element\n");
+                return OPJ_FALSE;
+        }
+
+        l_nb_levels = p_data[0];
+        if (l_nb_levels < p_reduce) {
+                opj_event_msg(p_manager, EVT_ERROR, "Cannot remove %d resolution levels from a component with %d decomposition levels\n", p_reduce, l_nb_levels);
+                return OPJ_FALSE;
+        }
+        p_data[0] = (OPJ_BYTE)(l_nb_levels - p_reduce);
+
+        /* the precinct sizes of the removed levels come last */
+        if (p_precincts) {
+                if (p_size != 5 + l_nb_levels + 1) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Error reading SPCod SPCoc element\n");
+                        return OPJ_FALSE;
+                }
+                *p_size_kept = p_size - p_reduce;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_transcode_sqcd (        OPJ_BYTE * p_data,
+                                                OPJ_UINT32 p_size,
+                                                OPJ_UINT32 p_reduce,
+                                                OPJ_UINT32 * p_size_kept,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_style, l_band_size, l_nb_bands;
+
+        *p_size_kept = p_size;
+        if (p_size < 2) {
+                opj_event_msg(p_manager, EVT_ERROR, "Error reading SQcd or SQcc element\n");
+                return OPJ_FALSE;
+        }
+
+        /* the derived quantization does not depend on the number of decomposition levels */
+        l_style = p_data[0] & 0x1f;
+        if (l_style == J2K_CCP_QNTSTY_SIQNT) {
+                return OPJ_TRUE;
+        }
+
+        /* the step sizes of the bands of the removed levels come last */
+        l_band_size = (l_style == J2K_CCP_QNTSTY_NOQNT) ? 1 : 2;
+        l_nb_bands = (p_size - 1) / l_band_size;
+        if (l_nb_bands <= 3 * p_reduce) {
+                opj_event_msg(p_manager, EVT_ERROR, "Cannot remove %d resolution levels from %d quantized bands\n", p_reduce, l_nb_bands);
+                return OPJ_FALSE;
+        }
+        *p_size_kept = 1 + (l_nb_bands - 3 * p_reduce) * l_band_size;
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_transcode_markers (     opj_j2k_t * p_j2k,
+                                                const OPJ_BYTE * p_data,
+                                                OPJ_UINT32 p_size,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                OPJ_BYTE * p_dest,
+                                                OPJ_UINT32 * p_written,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 l_reduce = p_parameters->reduce;
+        OPJ_UINT32 l_comp_room = (p_j2k->m_private_image->numcomps <= 256) ? 1 : 2;
+        OPJ_UINT32 l_pos = 0;
+
+        *p_written = 0;
+
+        while (l_pos < p_size) {
+                OPJ_UINT32 l_marker_id, l_marker_size, l_kept, l_value;
+                OPJ_BYTE * l_segment = p_dest + *p_written + 4;
+                OPJ_UINT32 l_segment_size;
+
+                if (p_size - l_pos < 4) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Inconsistent marker size\n");
+                        return OPJ_FALSE;
+                }
+                opj_read_bytes(p_data + l_pos, &l_marker_id, 2);
+                opj_read_bytes(p_data + l_pos + 2, &l_marker_size, 2);
+                if (l_marker_size < 2 || l_marker_size > p_size - l_pos - 2) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Inconsistent marker size\n");
+                        return OPJ_FALSE;
+                }
+                l_segment_size = l_marker_size - 2;
+                memcpy(l_segment, p_data + l_pos + 4, l_segment_size);
+                l_pos += 2 + l_marker_size;
+
+                switch (l_marker_id) {
+                        case J2K_MS_POC:
+                        case J2K_MS_TLM:
+                        case J2K_MS_PLM:
+                        case J2K_MS_PLT:
+                                /* the packets move, and their lengths are not written */
+                                continue;
+
+                        case J2K_MS_PPM:
+                        case J2K_MS_PPT:
+                                opj_event_msg(p_manager, EVT_ERROR, "opj_transcode does not support packed packet headers (PPM or PPT)\n");
+                                return OPJ_FALSE;
+
+                        case J2K_MS_SIZ:
+                                if (l_reduce) {
+                                        OPJ_UINT32 l_siz[8];
+                                        OPJ_UINT32 i;
+
+                                        if (l_segment_size < 36) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker size\n");
+                                                return OPJ_FALSE;
+                                        }
+                                        /* Xsiz, Ysiz, XOsiz, YOsiz, XTsiz, YTsiz, XTOsiz and YTOsiz */
+                                        for (i = 0; i < 8; ++i) {
+                                                opj_read_bytes(l_segment + 2 + 4 * i, &l_siz[i], 4);
+                                        }
+                                        if (! opj_j2k_transcode_siz_axis(&l_siz[0], &l_siz[2], &l_siz[4], &l_siz[6], p_j2k->m_cp.tw, l_reduce) ||
+                                            ! opj_j2k_transcode_siz_axis(&l_siz[1], &l_siz[3], &l_siz[5], &l_siz[7], p_j2k->m_cp.th, l_reduce)) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Cannot remove %d resolution levels: the tiles are not aligned on them\n", l_reduce);
+                                                return OPJ_FALSE;
+                                        }
+                                        for (i = 0; i < 8; ++i) {
+                                                opj_write_bytes(l_segment + 2 + 4 * i, l_siz[i], 4);
+                                        }
+                                }
+                                break;
+
+                        case J2K_MS_COD:
+                                if (l_segment_size < 5) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Error reading COD marker\n");
+                                        return OPJ_FALSE;
+                                }
+                                if (p_parameters->prog_order != OPJ_PROG_UNKNOWN) {
+                                        l_segment[1] = (OPJ_BYTE) p_parameters->prog_order;
+                                }
+                                opj_read_bytes(l_segment + 2, &l_value, 2);
+                                if (p_parameters->max_layers && p_parameters->max_layers < l_value) {
+                                        opj_write_bytes(l_segment + 2, p_parameters->max_layers, 2);
+                                }
+                                if (! opj_j2k_transcode_spcod(l_segment + 5, l_segment_size - 5, l_segment[0] & J2K_CP_CSTY_PRT, l_reduce, &l_kept, p_manager)) {
+                                        return OPJ_FALSE;
+                                }
+                                l_segment_size = 5 + l_kept;
+                                break;
+
+                        case J2K_MS_COC:
+                                if (l_segment_size < l_comp_room + 1) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Error reading COC marker\n");
+                                        return OPJ_FALSE;
+                                }
+                                if (! opj_j2k_transcode_spcod(l_segment + l_comp_room + 1, l_segment_size - l_comp_room - 1, l_segment[l_comp_room] & J2K_CCP_CSTY_PRT, l_reduce, &l_kept, p_manager)) {
+                                        return OPJ_FALSE;
+                                }
+                                l_segment_size = l_comp_room + 1 + l_kept;
+                                break;
+
+                        case J2K_MS_QCD:
+                                if (! opj_j2k_transcode_sqcd(l_segment, l_segment_size, l_reduce, &l_kept, p_manager)) {
+                                        return OPJ_FALSE;
+                                }
+                                l_segment_size = l_kept;
+                                break;
+
+                        case J2K_MS_QCC:
+                                if (l_segment_size < l_comp_room) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Error reading QCC marker\n");
+                                        return OPJ_FALSE;
+                                }
+                                if (! opj_j2k_transcode_sqcd(l_segment + l_comp_room, l_segment_size - l_comp_room, l_reduce, &l_kept, p_manager)) {
+                                        return OPJ_FALSE;
+                                }
+                                l_segment_size = l_comp_room + l_kept;
+                                break;
+
+                        default:
+                                break;
+                }
+
+                opj_write_bytes(p_dest + *p_written, l_marker_id, 2);
+                opj_write_bytes(p_dest + *p_written + 2, l_segment_size + 2, 2);
+                *p_written += 4 + l_segment_size;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_read_tile_part_data (   opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_input,
+                                                OPJ_UINT32 p_tile_no,
+                                                const opj_j2k_tile_part_t * p_tile_parts,
+                                                OPJ_UINT32 p_nb_tile_parts,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                OPJ_BYTE ** p_header,
+                                                OPJ_UINT32 * p_header_size,
+                                                OPJ_BYTE ** p_data,
+                                                OPJ_UINT32 * p_data_size,
+                                                opj_event_mgr_t * p_manager )
+{
+        OPJ_BYTE * l_header = 00;
+        OPJ_BYTE * l_data = 00;
+        OPJ_UINT32 l_header_size = 0;
+        OPJ_UINT32 l_data_size = 0;
+        OPJ_UINT32 i;
+
+        *p_header = 00;
+        *p_data = 00;
+
+        for (i = 0; i < p_nb_tile_parts; ++i) {
+                if (p_tile_parts[i].data_size > 0xFFFFFFFFU - l_data_size ||
+                    p_tile_parts[i].header_size > 0xFFFFFFFFU - l_header_size) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Tile %d is too large\n", p_tile_no);
+                        return OPJ_FALSE;
+                }
+                l_data_size += p_tile_parts[i].data_size;
+                l_header_size += p_tile_parts[i].header_size;
+        }
+
+        l_header = (OPJ_BYTE *) opj_malloc(l_header_size + 1);
+        l_data = (OPJ_BYTE *) opj_malloc(l_data_size + 1);
+        if (! l_header || ! l_data) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read tile %d\n", p_tile_no);
+                opj_free(l_header);
+                opj_free(l_data);
+                return OPJ_FALSE;
+        }
+
+        l_header_size = 0;
+        l_data_size = 0;
+        for (i = 0; i < p_nb_tile_parts; ++i) {
+                OPJ_UINT32 l_written;
+
+                /* the rewritten markers of all the tile-parts go to the first one */
+                if (! opj_j2k_transcode_markers(p_j2k, p_tile_parts[i].header, p_tile_parts[i].header_size, p_parameters, l_header + l_header_size, &l_written, p_manager)) {
+                        opj_free(l_header);
+                        opj_free(l_data);
+                        return OPJ_FALSE;
+                }
+                l_header_size += l_written;
+
+                if (! p_tile_parts[i].data_size) {
+                        continue;
+                }
+                if (! opj_stream_read_seek(p_input, p_tile_parts[i].data_pos, p_manager) ||
+                    opj_stream_read_data(p_input, l_data + l_data_size, p_tile_parts[i].data_size, p_manager) != p_tile_parts[i].data_size) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Stream too short to read the data of tile %d\n", p_tile_no);
+                        opj_free(l_header);
+                        opj_free(l_data);
+                        return OPJ_FALSE;
+                }
+                l_data_size += p_tile_parts[i].data_size;
+        }
+
+        *p_header = l_header;
+        *p_header_size = l_header_size;
+        *p_data = l_data;
+        *p_data_size = l_data_size;
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_order_packets ( opj_j2k_t * p_j2k,
+                                        OPJ_UINT32 p_tile_no,
+                                        const opj_t2_packet_t * p_packets,
+                                        OPJ_UINT32 p_nb_packets,
+                                        const opj_transcode_parameters_t * p_parameters,
+                                        opj_t2_packet_t ** p_sequence,
+                                        OPJ_UINT32 * p_nb_sequence,
+                                        opj_event_mgr_t * p_manager )
+{
+        opj_tcp_t * l_tcp = &(p_j2k->m_cp.tcps[p_tile_no]);
+        opj_tcd_tile_t * l_tile = p_j2k->m_tcd->tcd_image->tiles;
+        opj_pi_iterator_t * l_pi;
+        opj_t2_packet_t * l_sequence;
+        OPJ_UINT32 * l_first_packet;
+        OPJ_UINT32 * l_located;
+        OPJ_UINT32 l_nb_layers = l_tcp->numlayers;
+        OPJ_UINT32 l_max_packets = 0;
+        OPJ_UINT32 l_nb_sequence = 0;
+        OPJ_UINT32 l_has_poc = l_tcp->POC;
+        OPJ_UINT32 l_nb_pocs = l_tcp->numpocs;
+        OPJ_PROG_ORDER l_prg = l_tcp->prg;
+        OPJ_UINT32 i, compno, resno;
+
+        *p_sequence = 00;
+        *p_nb_sequence = 0;
+
+        if (p_parameters->max_layers && p_parameters->max_layers < l_nb_layers) {
+                l_nb_layers = p_parameters->max_layers;
+        }
+
+        /* the packets of the tile are numbered by component, resolution, precinct and layer */
+        l_first_packet = (OPJ_UINT32 *) opj_malloc(l_tile->numcomps * OPJ_J2K_MAXRLVLS * sizeof(OPJ_UINT32));
+        if (! l_first_packet) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to transcode tile %d\n", p_tile_no);
+                return OPJ_FALSE;
+        }
+        for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                opj_tcd_tilecomp_t * l_tilec = &(l_tile->comps[compno]);
+
+                for (resno = 0; resno < l_tilec->numresolutions; ++resno) {
+                        l_first_packet[compno * OPJ_J2K_MAXRLVLS + resno] = l_max_packets;
+                        l_max_packets += l_tilec->resolutions[resno].pw * l_tilec->resolutions[resno].ph * l_tcp->numlayers;
+                }
+        }
+
+        l_located = (OPJ_UINT32 *) opj_malloc((l_max_packets + 1) * sizeof(OPJ_UINT32));
+        l_sequence = (opj_t2_packet_t *) opj_malloc((l_max_packets + 1) * sizeof(opj_t2_packet_t));
+        if (! l_located || ! l_sequence) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to transcode tile %d\n", p_tile_no);
+                opj_free(l_first_packet);
+                opj_free(l_located);
+                opj_free(l_sequence);
+                return OPJ_FALSE;
+        }
+        memset(l_located, 0xff, l_max_packets * sizeof(OPJ_UINT32));
+        for (i = 0; i < p_nb_packets; ++i) {
+                const opj_t2_packet_t * l_packet = &p_packets[i];
+
+                l_located[l_first_packet[l_packet->compno * OPJ_J2K_MAXRLVLS + l_packet->resno] + l_packet->precno * l_tcp->numlayers + l_packet->layno] = i;
+        }
+
+        /* iterate over the packets in the new progression order, without the progression order changes */
+        l_tcp->POC = 0;
+        l_tcp->numpocs = 0;
+        if (p_parameters->prog_order != OPJ_PROG_UNKNOWN) {
+                l_tcp->prg = p_parameters->prog_order;
+        }
+        l_pi = opj_pi_create_decode(p_j2k->m_private_image, &(p_j2k->m_cp), p_tile_no);
+        l_tcp->POC = (l_has_poc != 0);
+        l_tcp->numpocs = l_nb_pocs;
+        l_tcp->prg = l_prg;
+        if (! l_pi) {
+                opj_event_msg(p_manager, EVT_ERROR, "Failed to create the packet iterator of tile %d\n", p_tile_no);
+                opj_free(l_first_packet);
+                opj_free(l_located);
+                opj_free(l_sequence);
+                return OPJ_FALSE;
+        }
+
+        /* a precinct still gets its layers in order: the headers of the packets kept stay valid */
+        while (opj_pi_next(l_pi) && l_nb_sequence < l_max_packets) {
+                opj_t2_packet_t * l_packet;
+                OPJ_UINT32 l_packet_no;
+
+                if (l_pi->layno >= l_nb_layers ||
+                    l_pi->resno + p_parameters->reduce >= l_tile->comps[l_pi->compno].numresolutions) {
+                        continue;
+                }
+
+                l_packet = &l_sequence[l_nb_sequence++];
+                l_packet->compno = l_pi->compno;
+                l_packet->resno = l_pi->resno;
+                l_packet->precno = l_pi->precno;
+                l_packet->layno = l_pi->layno;
+                l_packet_no = l_located[l_first_packet[l_pi->compno * OPJ_J2K_MAXRLVLS + l_pi->resno] + l_pi->precno * l_tcp->numlayers + l_pi->layno];
+                if (l_packet_no == (OPJ_UINT32)-1) {
+                        /* missing from a truncated codestream: written empty */
+                        l_packet->offset = 0;
+                        l_packet->length = 0;
+                }
+                else {
+                        l_packet->offset = p_packets[l_packet_no].offset;
+                        l_packet->length = p_packets[l_packet_no].length;
+                }
+        }
+        opj_pi_destroy(l_pi, 1);
+        opj_free(l_first_packet);
+        opj_free(l_located);
+
+        *p_sequence = l_sequence;
+        *p_nb_sequence = l_nb_sequence;
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_write_transcoded_tile ( opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_output,
+                                                OPJ_UINT32 p_tile_no,
+                                                const OPJ_BYTE * p_header,
+                                                OPJ_UINT32 p_header_size,
+                                                const OPJ_BYTE * p_data,
+                                                const opj_t2_packet_t * p_sequence,
+                                                OPJ_UINT32 p_nb_sequence,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_tcp_t * l_tcp = &(p_j2k->m_cp.tcps[p_tile_no]);
+        OPJ_UINT32 l_empty_size = 1;
+        OPJ_UINT32 l_nb_tile_parts = 1;
+        OPJ_UINT32 l_tile_part_no = 0;
+        OPJ_UINT64 l_tile_part_size = 14 + (OPJ_UINT64)p_header_size;
+        OPJ_UINT64 l_tile_size = 0;
+        OPJ_BYTE * l_buffer;
+        OPJ_BYTE * l_current;
+        OPJ_BYTE * l_psot = 00;
+        OPJ_UINT32 i;
+        OPJ_BOOL l_result;
+
+        if (l_tcp->csty & J2K_CP_CSTY_SOP) {
+                l_empty_size += 6;
+        }
+        if (l_tcp->csty & J2K_CP_CSTY_EPH) {
+                l_empty_size += 2;
+        }
+
+        /* cut the tile into tile-parts, and check their size */
+        for (i = 0; i <= p_nb_sequence; ++i) {
+                if (i == p_nb_sequence || (i > 0 &&
+                    ((p_parameters->tp_flag == 'R' && p_sequence[i].resno != p_sequence[i - 1].resno) ||
+                     (p_parameters->tp_flag == 'L' && p_sequence[i].layno != p_sequence[i - 1].layno) ||
+                     (p_parameters->tp_flag == 'C' && p_sequence[i].compno != p_sequence[i - 1].compno)))) {
+                        if (l_tile_part_size > 0xFFFFFFFFU) {
+                                opj_event_msg(p_manager, EVT_ERROR, "A tile-part of tile %d is too large\n", p_tile_no);
+                                return OPJ_FALSE;
+                        }
+                        l_tile_size += l_tile_part_size;
+                        l_tile_part_size = 14;
+                        if (i == p_nb_sequence) {
+                                break;
+                        }
+                        ++l_nb_tile_parts;
+                }
+                l_tile_part_size += p_sequence[i].length ? p_sequence[i].length : l_empty_size;
+        }
+        if (l_nb_tile_parts > 255) {
+                opj_event_msg(p_manager, EVT_ERROR, "Tile %d would have %d tile-parts, more than 255\n", p_tile_no, l_nb_tile_parts);
+                return OPJ_FALSE;
+        }
+        if (l_tile_size != (OPJ_SIZE_T)l_tile_size) {
+                opj_event_msg(p_manager, EVT_ERROR, "Tile %d is too large\n", p_tile_no);
+                return OPJ_FALSE;
+        }
+
+        l_buffer = (OPJ_BYTE *) opj_malloc((OPJ_SIZE_T)l_tile_size);
+        if (! l_buffer) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to write tile %d\n", p_tile_no);
+                return OPJ_FALSE;
+        }
+
+        l_current = l_buffer;
+        for (i = 0; i <= p_nb_sequence; ++i) {
+                if (i == 0 || i == p_nb_sequence ||
+                    (p_parameters->tp_flag == 'R' && p_sequence[i].resno != p_sequence[i - 1].resno) ||
+                    (p_parameters->tp_flag == 'L' && p_sequence[i].layno != p_sequence[i - 1].layno) ||
+                    (p_parameters->tp_flag == 'C' && p_sequence[i].compno != p_sequence[i - 1].compno)) {
+                        /* end the previous tile-part */
+                        if (l_psot) {
+                                opj_write_bytes(l_psot, (OPJ_UINT32)(l_current - l_psot + 6), 4);
+                        }
+                        if (i == p_nb_sequence && i > 0) {
+                                break;
+                        }
+
+                        /* SOT marker segment */
+                        opj_write_bytes(l_current, J2K_MS_SOT, 2);
+                        opj_write_bytes(l_current + 2, 10, 2);
+                        opj_write_bytes(l_current + 4, p_tile_no, 2);
+                        l_psot = l_current + 6;
+                        opj_write_bytes(l_current + 10, l_tile_part_no, 1);
+                        opj_write_bytes(l_current + 11, l_nb_tile_parts, 1);
+                        l_current += 12;
+                        if (! l_tile_part_no) {
+                                memcpy(l_current, p_header, p_header_size);
+                                l_current += p_header_size;
+                        }
+                        opj_write_bytes(l_current, J2K_MS_SOD, 2);
+                        l_current += 2;
+                        ++l_tile_part_no;
+
+                        if (i == p_nb_sequence) {
+                                /* a tile without packets */
+                                opj_write_bytes(l_psot, (OPJ_UINT32)(l_current - l_psot + 6), 4);
+                                break;
+                        }
+                }
+
+                if (p_sequence[i].length) {
+                        memcpy(l_current, p_data + p_sequence[i].offset, p_sequence[i].length);
+                        /* the packets are numbered again in the new order */
+                        if ((l_tcp->csty & J2K_CP_CSTY_SOP) && p_sequence[i].length >= 6 && l_current[0] == 0xff && l_current[1] == 0x91) {
+                                opj_write_bytes(l_current + 4, i & 0xffff, 2);
+                        }
+                        l_current += p_sequence[i].length;
+                }
+                else {
+                        if (l_tcp->csty & J2K_CP_CSTY_SOP) {
+                                opj_write_bytes(l_current, J2K_MS_SOP, 2);
+                                opj_write_bytes(l_current + 2, 4, 2);
+                                opj_write_bytes(l_current + 4, i & 0xffff, 2);
+                                l_current += 6;
+                        }
+                        /* no code-block included */
+                        *(l_current++) = 0;
+                        if (l_tcp->csty & J2K_CP_CSTY_EPH) {
+                                opj_write_bytes(l_current, J2K_MS_EPH, 2);
+                                l_current += 2;
+                        }
+                }
+        }
+        assert(l_current == l_buffer + l_tile_size);
+
+        l_result = (opj_stream_write_data(p_output, l_buffer, (OPJ_SIZE_T)l_tile_size, p_manager) == (OPJ_SIZE_T)l_tile_size);
+        opj_free(l_buffer);
+        return l_result;
+}
+
+static OPJ_BOOL opj_j2k_transcode_tile (        opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_input,
+                                                opj_stream_private_t * p_output,
+                                                OPJ_UINT32 p_tile_no,
+                                                const opj_j2k_tile_part_t * p_tile_parts,
+                                                OPJ_UINT32 p_nb_tile_parts,
+                                                const opj_transcode_parameters_t * p_parameters,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_tccp_t * l_tccp;
+        OPJ_BYTE * l_header = 00;
+        OPJ_BYTE * l_data = 00;
+        OPJ_UINT32 l_header_size, l_data_size;
+        opj_t2_packet_t * l_packets = 00;
+        opj_t2_packet_t * l_sequence = 00;
+        OPJ_UINT32 l_nb_packets = 0;
+        OPJ_UINT32 l_nb_sequence = 0;
+        OPJ_UINT32 compno;
+        OPJ_BOOL l_result;
+
+        /* a tile without tile-part has the default coding parameters */
+        if (! opj_j2k_materialize_tcp(p_j2k, p_tile_no, p_manager)) {
+                return OPJ_FALSE;
+        }
+        l_tccp = p_j2k->m_cp.tcps[p_tile_no].tccps;
+
+        if (! opj_j2k_read_tile_part_data(p_j2k, p_input, p_tile_no, p_tile_parts, p_nb_tile_parts, p_parameters,
+                                          &l_header, &l_header_size, &l_data, &l_data_size, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* the coding parameters of the tile are complete once the headers of its tile-parts are read */
+        l_result = OPJ_TRUE;
+        for (compno = 0; compno < p_j2k->m_private_image->numcomps; ++compno) {
+                if (p_parameters->reduce >= l_tccp[compno].numresolutions) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Cannot remove %d resolution levels from component %d of tile %d, which has %d\n",
+                                      p_parameters->reduce, compno, p_tile_no, l_tccp[compno].numresolutions);
+                        l_result = OPJ_FALSE;
+                        break;
+                }
+        }
+
+        if (l_result && ! opj_tcd_locate_packets(p_j2k->m_tcd, p_tile_no, l_data, l_data_size, &l_packets, &l_nb_packets, p_manager)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Failed to read the packets of tile %d\n", p_tile_no);
+                l_result = OPJ_FALSE;
+        }
+        l_result = l_result && opj_j2k_order_packets(p_j2k, p_tile_no, l_packets, l_nb_packets, p_parameters, &l_sequence, &l_nb_sequence, p_manager);
+        l_result = l_result && opj_j2k_write_transcoded_tile(p_j2k, p_output, p_tile_no, l_header, l_header_size, l_data,
+                                                             l_sequence, l_nb_sequence, p_parameters, p_manager);
+
+        opj_free(l_sequence);
+        opj_free(l_packets);
+        opj_free(l_data);
+        opj_free(l_header);
+        return l_result;
+}
+
+OPJ_BOOL opj_j2k_transcode(     opj_j2k_t * p_j2k,
+                                opj_stream_private_t * p_input,
+                                opj_stream_private_t * p_output,
+                                const opj_transcode_parameters_t * p_parameters,
+                                opj_event_mgr_t * p_manager )
+{
+        opj_codestream_index_t * l_cstr_index = p_j2k->cstr_index;
+        opj_j2k_tile_part_t * l_tile_parts = 00;
+        OPJ_UINT32 l_nb_tile_parts = 0;
+        OPJ_BYTE * l_main_header = 00;
+        OPJ_BYTE * l_rewritten = 00;
+        OPJ_UINT32 l_main_header_size, l_written;
+        OPJ_UINT32 l_marker_id;
+        OPJ_UINT32 l_nb_tiles, tileno, i;
+        OPJ_BYTE l_eoc[2];
+        OPJ_BOOL l_result = OPJ_TRUE;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_input != 00);
+        assert(p_output != 00);
+        assert(p_parameters != 00);
+        assert(p_manager != 00);
+
+        if (! p_j2k->m_private_image || ! l_cstr_index || ! p_j2k->m_tcd ||
+            p_j2k->m_specific_param.m_decoder.m_state != J2K_STATE_TPHSOT ||
+            l_cstr_index->main_head_end <= l_cstr_index->main_head_start + 2) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_transcode needs the header read by opj_read_header, before any decoding\n");
+                return OPJ_FALSE;
+        }
+        if (p_j2k->m_cp.ppm) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_transcode does not support packed packet headers (PPM or PPT)\n");
+                return OPJ_FALSE;
+        }
+        if (p_parameters->prog_order != OPJ_PROG_UNKNOWN && (p_parameters->prog_order < OPJ_LRCP || p_parameters->prog_order > OPJ_CPRL)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Invalid progression order %d\n", p_parameters->prog_order);
+                return OPJ_FALSE;
+        }
+        if (p_parameters->tp_flag != 0 && p_parameters->tp_flag != 'R' && p_parameters->tp_flag != 'L' && p_parameters->tp_flag != 'C') {
+                opj_event_msg(p_manager, EVT_ERROR, "Invalid tile-part flag %c: R, L or C expected\n", p_parameters->tp_flag);
+                return OPJ_FALSE;
+        }
+        if (p_parameters->reduce >= OPJ_J2K_MAXRLVLS - 1) {
+                opj_event_msg(p_manager, EVT_ERROR, "Cannot remove %d resolution levels\n", p_parameters->reduce);
+                return OPJ_FALSE;
+        }
+
+        /* the main header, rewritten */
+        l_main_header_size = (OPJ_UINT32)(l_cstr_index->main_head_end - l_cstr_index->main_head_start);
+        l_main_header = (OPJ_BYTE *) opj_malloc(l_main_header_size);
+        l_rewritten = (OPJ_BYTE *) opj_malloc(l_main_header_size);
+        if (! l_main_header || ! l_rewritten) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to read the main header\n");
+                opj_free(l_main_header);
+                opj_free(l_rewritten);
+                return OPJ_FALSE;
+        }
+        if (! opj_stream_read_seek(p_input, (OPJ_OFF_T)l_cstr_index->main_head_start, p_manager) ||
+            opj_stream_read_data(p_input, l_main_header, l_main_header_size, p_manager) != l_main_header_size) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_transcode needs a stream able to seek\n");
+                l_result = OPJ_FALSE;
+        }
+        if (l_result) {
+                opj_read_bytes(l_main_header, &l_marker_id, 2);
+                if (l_marker_id != J2K_MS_SOC) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Expected a SOC marker\n");
+                        l_result = OPJ_FALSE;
+                }
+        }
+        l_result = l_result && opj_j2k_transcode_markers(p_j2k, l_main_header + 2, l_main_header_size - 2, p_parameters, l_rewritten + 2, &l_written, p_manager);
+
+        /* the tile-parts, whose headers update the coding parameters of their tiles */
+        l_result = l_result && opj_j2k_read_tile_parts(p_j2k, p_input, &l_tile_parts, &l_nb_tile_parts, p_manager);
+
+        if (l_result) {
+                memcpy(l_rewritten, l_main_header, 2);
+                l_written += 2;
+                l_result = (opj_stream_write_data(p_output, l_rewritten, l_written, p_manager) == l_written);
+        }
+        opj_free(l_main_header);
+        opj_free(l_rewritten);
+
+        /* the tiles, one after the other */
+        l_nb_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
+        i = 0;
+        for (tileno = 0; l_result && tileno < l_nb_tiles; ++tileno) {
+                OPJ_UINT32 l_first = i;
+
+                while (i < l_nb_tile_parts && l_tile_parts[i].tileno == tileno) {
+                        ++i;
+                }
+                l_result = opj_j2k_transcode_tile(p_j2k, p_input, p_output, tileno, l_tile_parts + l_first, i - l_first, p_parameters, p_manager);
+        }
+        opj_j2k_free_tile_parts(l_tile_parts, l_nb_tile_parts);
+
+        if (l_result) {
+                opj_write_bytes(l_eoc, J2K_MS_EOC, 2);
+                l_result = (opj_stream_write_data(p_output, l_eoc, 2, p_manager) == 2) &&
+                           opj_stream_flush(p_output, p_manager);
+        }
+
+        return l_result;
+}
+
+static OPJ_BOOL opj_j2k_map_tile_packets (      opj_j2k_t * p_j2k,
+                                                opj_stream_private_t * p_stream,
+                                                OPJ_UINT32 p_tile_no,
+                                                const opj_j2k_tile_part_t * p_tile_parts,
+                                                OPJ_UINT32 p_nb_tile_parts,
+                                                opj_packet_map_t * p_packet_map,
+                                                OPJ_UINT32 * p_max_packets,
+                                                opj_event_mgr_t * p_manager )
+{
+        opj_transcode_parameters_t l_parameters;
+        OPJ_BYTE * l_header = 00;
+        OPJ_BYTE * l_data = 00;
+        OPJ_UINT32 l_header_size, l_data_size;
+        opj_t2_packet_t * l_packets = 00;
+        OPJ_UINT32 l_nb_packets = 0;
+        OPJ_UINT32 l_tile_part = 0;
+        OPJ_UINT32 l_tile_part_offset = 0;
+        OPJ_UINT32 i;
+
+        /* no packet from a codestream truncated before the tile */
+        if (! p_nb_tile_parts) {
+                return OPJ_TRUE;
+        }
+
+        /* the marker segments of the tile-part headers are copied as they are */
+        memset(&l_parameters, 0, sizeof(opj_transcode_parameters_t));
+        l_parameters.prog_order = OPJ_PROG_UNKNOWN;
+        if (! opj_j2k_read_tile_part_data(p_j2k, p_stream, p_tile_no, p_tile_parts, p_nb_tile_parts, &l_parameters,
+                                          &l_header, &l_header_size, &l_data, &l_data_size, p_manager)) {
+                return OPJ_FALSE;
+        }
+        opj_free(l_header);
+
+        if (! opj_tcd_locate_packets(p_j2k->m_tcd, p_tile_no, l_data, l_data_size, &l_packets, &l_nb_packets, p_manager)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Failed to read the packets of tile %d\n", p_tile_no);
+                opj_free(l_data);
+                return OPJ_FALSE;
+        }
+        opj_free(l_data);
+
+        if (l_nb_packets > *p_max_packets - p_packet_map->nb_packets) {
+                OPJ_UINT32 l_max_packets = p_packet_map->nb_packets + l_nb_packets;
+                opj_packet_range_t * l_new_packets;
+
+                if (l_max_packets < p_packet_map->nb_packets || l_max_packets > (OPJ_UINT32)-1 / sizeof(opj_packet_range_t)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Too many packets in the codestream\n");
+                        opj_free(l_packets);
+                        return OPJ_FALSE;
+                }
+                /* grow by half at least, the tiles being mapped one after the other */
+                if (l_max_packets - *p_max_packets < *p_max_packets / 2 &&
+                    *p_max_packets + *p_max_packets / 2 <= (OPJ_UINT32)-1 / sizeof(opj_packet_range_t)) {
+                        l_max_packets = *p_max_packets + *p_max_packets / 2;
+                }
+                l_new_packets = (opj_packet_range_t *) opj_realloc(p_packet_map->packets, l_max_packets * sizeof(opj_packet_range_t));
+                if (! l_new_packets) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to map the packets of tile %d\n", p_tile_no);
+                        opj_free(l_packets);
+                        return OPJ_FALSE;
+                }
+                p_packet_map->packets = l_new_packets;
+                *p_max_packets = l_max_packets;
+        }
+
+        /* the offsets of the packets run over the data of the tile-parts put end to end */
+        for (i = 0; i < l_nb_packets; ++i) {
+                const opj_t2_packet_t * l_packet = &l_packets[i];
+                opj_packet_range_t * l_range = &p_packet_map->packets[p_packet_map->nb_packets++];
+
+                while (l_tile_part + 1 < p_nb_tile_parts &&
+                       l_packet->offset >= l_tile_part_offset + p_tile_parts[l_tile_part].data_size) {
+                        l_tile_part_offset += p_tile_parts[l_tile_part].data_size;
+                        ++l_tile_part;
+                }
+                l_range->tileno = p_tile_no;
+                l_range->compno = l_packet->compno;
+                l_range->resno = l_packet->resno;
+                l_range->precno = l_packet->precno;
+                l_range->layno = l_packet->layno;
+                l_range->start_pos = p_tile_parts[l_tile_part].data_pos + (OPJ_OFF_T)(l_packet->offset - l_tile_part_offset);
+                l_range->length = l_packet->length;
+        }
+
+        opj_free(l_packets);
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_get_packet_map(        opj_j2k_t * p_j2k,
+                                        opj_stream_private_t * p_stream,
+                                        opj_packet_map_t ** p_packet_map,
+                                        opj_event_mgr_t * p_manager )
+{
+        opj_codestream_index_t * l_cstr_index = p_j2k->cstr_index;
+        opj_j2k_tile_part_t * l_tile_parts = 00;
+        opj_packet_map_t * l_packet_map;
+        OPJ_UINT32 l_nb_tile_parts = 0;
+        OPJ_UINT32 l_max_packets = 0;
+        OPJ_UINT32 l_nb_tiles, tileno, i;
+        OPJ_BOOL l_result;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_stream != 00);
+        assert(p_packet_map != 00);
+        assert(p_manager != 00);
+
+        *p_packet_map = 00;
+
+        if (! p_j2k->m_private_image || ! l_cstr_index || ! p_j2k->m_tcd ||
+            p_j2k->m_specific_param.m_decoder.m_state != J2K_STATE_TPHSOT) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_get_packet_map needs the header read by opj_read_header, before any decoding\n");
+                return OPJ_FALSE;
+        }
+        if (p_j2k->m_cp.ppm) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_get_packet_map does not support packed packet headers (PPM or PPT)\n");
+                return OPJ_FALSE;
+        }
+
+        l_packet_map = (opj_packet_map_t *) opj_calloc(1, sizeof(opj_packet_map_t));
+        if (! l_packet_map) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to map the packets\n");
+                return OPJ_FALSE;
+        }
+
+        /* the tile-parts, whose headers update the coding parameters of their tiles */
+        l_result = opj_j2k_read_tile_parts(p_j2k, p_stream, &l_tile_parts, &l_nb_tile_parts, p_manager);
+
+        l_nb_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
+        i = 0;
+        for (tileno = 0; l_result && tileno < l_nb_tiles; ++tileno) {
+                OPJ_UINT32 l_first = i;
+
+                while (i < l_nb_tile_parts && l_tile_parts[i].tileno == tileno) {
+                        ++i;
+                }
+                l_result = opj_j2k_map_tile_packets(p_j2k, p_stream, tileno, l_tile_parts + l_first, i - l_first,
+                                                    l_packet_map, &l_max_packets, p_manager);
+        }
+        opj_j2k_free_tile_parts(l_tile_parts, l_nb_tile_parts);
+
+        if (! l_result) {
+                opj_free(l_packet_map->packets);
+                opj_free(l_packet_map);
+                return OPJ_FALSE;
+        }
+
+        *p_packet_map = l_packet_map;
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_get_tile(      opj_j2k_t *p_j2k,
+                                                    opj_stream_private_t *p_stream,
+                                                    opj_image_t* p_image,
+                                                    opj_event_mgr_t * p_manager,
+                                                    OPJ_UINT32 tile_index )
+{
+        OPJ_UINT32 compno;
+        OPJ_UINT32 l_tile_x, l_tile_y;
+        opj_image_comp_t* l_img_comp;
+
+        if (!p_image) {
+                opj_event_msg(p_manager, EVT_ERROR, "We need an image previously created.\n");
+                return OPJ_FALSE;
+        }
+
+        if ( /*(tile_index < 0) &&*/ (tile_index >= p_j2k->m_cp.tw * p_j2k->m_cp.th) ){
+                opj_event_msg(p_manager, EVT_ERROR, "Tile index provided by the user is incorrect %d (max = %d) \n", tile_index, (p_j2k->m_cp.tw * p_j2k->m_cp.th) - 1);
+                return OPJ_FALSE;
+        }
+
+        if (! opj_j2k_check_used_comps(p_j2k, p_image, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* Compute the dimension of the desired tile*/
+        l_tile_x = tile_index % p_j2k->m_cp.tw;
+        l_tile_y = tile_index / p_j2k->m_cp.tw;
+
+        p_image->x0 = l_tile_x * p_j2k->m_cp.tdx + p_j2k->m_cp.tx0;
+        if (p_image->x0 < p_j2k->m_private_image->x0)
+                p_image->x0 = p_j2k->m_private_image->x0;
+        p_image->x1 = (l_tile_x + 1) * p_j2k->m_cp.tdx + p_j2k->m_cp.tx0;
+        if (p_image->x1 > p_j2k->m_private_image->x1)
+                p_image->x1 = p_j2k->m_private_image->x1;
+
+        p_image->y0 = l_tile_y * p_j2k->m_cp.tdy + p_j2k->m_cp.ty0;
+        if (p_image->y0 < p_j2k->m_private_image->y0)
+                p_image->y0 = p_j2k->m_private_image->y0;
+        p_image->y1 = (l_tile_y + 1) * p_j2k->m_cp.tdy + p_j2k->m_cp.ty0;
+        if (p_image->y1 > p_j2k->m_private_image->y1)
+                p_image->y1 = p_j2k->m_private_image->y1;
+
+        l_img_comp = p_image->comps;
+        for (compno=0; compno < p_image->numcomps; ++compno)
+        {
+                OPJ_INT32 l_comp_x1, l_comp_y1;
+
+                l_img_comp->factor = p_j2k->m_private_image->comps[compno].factor;
+
+                l_img_comp->x0 = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)p_image->x0, (OPJ_INT32)l_img_comp->dx);
+                l_img_comp->y0 = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)p_image->y0, (OPJ_INT32)l_img_comp->dy);
+                l_comp_x1 = opj_int_ceildiv((OPJ_INT32)p_image->x1, (OPJ_INT32)l_img_comp->dx);
+                l_comp_y1 = opj_int_ceildiv((OPJ_INT32)p_image->y1, (OPJ_INT32)l_img_comp->dy);
+
+                l_img_comp->w = (OPJ_UINT32)(opj_int_ceildivpow2(l_comp_x1, (OPJ_INT32)l_img_comp->factor) - opj_int_ceildivpow2((OPJ_INT32)l_img_comp->x0, (OPJ_INT32)l_img_comp->factor));
+                l_img_comp->h = (OPJ_UINT32)(opj_int_ceildivpow2(l_comp_y1, (OPJ_INT32)l_img_comp->factor) - opj_int_ceildivpow2((OPJ_INT32)l_img_comp->y0, (OPJ_INT32)l_img_comp->factor));
+
+                l_img_comp++;
+        }
+
+        /* Destroy the previous output image*/
+        if (p_j2k->m_output_image)
+                opj_image_destroy(p_j2k->m_output_image);
+
+        /* Create the ouput image from the information previously computed*/
+        p_j2k->m_output_image = opj_image_create0();
+        if (! (p_j2k->m_output_image)) {
+                return OPJ_FALSE;
+        }
+        opj_copy_image_header(p_image, p_j2k->m_output_image);
+        opj_j2k_set_native_samples(p_j2k, p_j2k->m_output_image);
+
+        p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = (OPJ_INT32)tile_index;
+
+        /* customization of the decoding */
+        opj_j2k_setup_decoding_tile(p_j2k, p_manager);
+
+        /* Decode the codestream */
+        if (! opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager)) {
+                opj_image_destroy(p_j2k->m_private_image);
+                p_j2k->m_private_image = NULL;
+                return OPJ_FALSE;
+        }
+
+        /* Move data and copy one information from codec to output image*/
+        for (compno = 0; compno < p_image->numcomps; compno++) {
+                p_image->comps[compno].resno_decoded = p_j2k->m_output_image->comps[compno].resno_decoded;
+
+                if (p_image->comps[compno].data)
+                        opj_image_data_free(p_image->comps[compno].data);
+                if (p_image->comps[compno].native_data)
+                        opj_image_data_free(p_image->comps[compno].native_data);
+
+                p_image->comps[compno].data = p_j2k->m_output_image->comps[compno].data;
+                p_image->comps[compno].native_size = p_j2k->m_output_image->comps[compno].native_size;
+                p_image->comps[compno].native_data = p_j2k->m_output_image->comps[compno].native_data;
+
+                p_j2k->m_output_image->comps[compno].data = NULL;
+                p_j2k->m_output_image->comps[compno].native_data = NULL;
+        }
+
+        opj_j2k_keep_used_comps(p_j2k, p_image);
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_j2k_check_used_comps (opj_j2k_t * p_j2k, const opj_image_t * p_image, opj_event_mgr_t * p_manager)
+{
+        if (p_j2k->m_specific_param.m_decoder.m_used_comps &&
+            p_image->numcomps != p_j2k->m_private_image->numcomps) {
+                opj_event_msg(p_manager, EVT_ERROR, "The image has %d components instead of the %d of the codestream, it should be read again by opj_read_header\n",
+                              p_image->numcomps, p_j2k->m_private_image->numcomps);
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+static void opj_j2k_keep_used_comps (opj_j2k_t * p_j2k, opj_image_t * p_image)
+{
+        const OPJ_BOOL * l_used = p_j2k->m_specific_param.m_decoder.m_used_comps;
+        OPJ_UINT32 compno, l_nb_comps = 0;
+
+        if (! l_used) {
+                return;
+        }
+
+        for (compno = 0; compno < p_image->numcomps; ++compno) {
+                opj_image_comp_t * l_img_comp = p_image->comps + compno;
+
+                if (! l_used[compno]) {
+                        opj_image_data_free(l_img_comp->data);
+                        opj_image_data_free(l_img_comp->native_data);
+                        continue;
+                }
+
+                if (l_nb_comps != compno) {
+                        p_image->comps[l_nb_comps] = *l_img_comp;
+                }
+                ++l_nb_comps;
+        }
+        p_image->numcomps = l_nb_comps;
+}
+
+OPJ_BOOL opj_j2k_set_decoded_components(opj_j2k_t *p_j2k,
+                                        OPJ_UINT32 p_numcomps,
+                                        const OPJ_UINT32 * p_comps_indices,
+                                        opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+        OPJ_BOOL * l_used;
+        OPJ_UINT32 i;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_manager != 00);
+
+        if (! p_j2k->m_private_image) {
+                opj_event_msg(p_manager, EVT_ERROR, "The header must be read before selecting the components to decode\n");
+                return OPJ_FALSE;
+        }
+
+        if (p_numcomps == 0) {
+                l_used = 00;
+        }
+        else {
+                if (! p_comps_indices) {
+                        opj_event_msg(p_manager, EVT_ERROR, "No indices given for the %d components to decode\n", p_numcomps);
+                        return OPJ_FALSE;
+                }
+
+                l_used = (OPJ_BOOL *) opj_calloc(p_j2k->m_private_image->numcomps, sizeof(OPJ_BOOL));
+                if (! l_used) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to select the components to decode\n");
+                        return OPJ_FALSE;
+                }
+
+                for (i = 0; i < p_numcomps; ++i) {
+                        OPJ_UINT32 l_compno = p_comps_indices[i];
+
+                        if (l_compno >= p_j2k->m_private_image->numcomps) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Invalid component index %d (number of components: %d)\n", l_compno, p_j2k->m_private_image->numcomps);
+                                opj_free(l_used);
+                                return OPJ_FALSE;
+                        }
+                        if (l_used[l_compno]) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Component index %d is selected twice\n", l_compno);
+                                opj_free(l_used);
+                                return OPJ_FALSE;
+                        }
+                        l_used[l_compno] = OPJ_TRUE;
+                }
+        }
+
+        opj_free(l_decoder->m_used_comps);
+        l_decoder->m_used_comps = l_used;
+        l_decoder->m_nb_used_comps = p_numcomps;
+        if (p_j2k->m_tcd) {
+                p_j2k->m_tcd->m_used_comps = l_used;
+        }
+
+        /* the cached tiles only hold the samples of the previous selection */
+        opj_tile_cache_clear(l_decoder->m_tile_cache);
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_set_decoded_resolution_factor(opj_j2k_t *p_j2k,
+                                               OPJ_UINT32 res_factor,
+                                               opj_event_mgr_t * p_manager)
+{
+        OPJ_UINT32 it_comp;
+
+        p_j2k->m_cp.m_specific_param.m_dec.m_reduce = res_factor;
+
+        if (p_j2k->m_private_image) {
+                if (p_j2k->m_private_image->comps) {
+                        if (p_j2k->m_specific_param.m_decoder.m_default_tcp) {
+                                if (p_j2k->m_specific_param.m_decoder.m_default_tcp->tccps) {
+                                        for (it_comp = 0 ; it_comp < p_j2k->m_private_image->numcomps; it_comp++) {
+                                                OPJ_UINT32 max_res = p_j2k->m_specific_param.m_decoder.m_default_tcp->tccps[it_comp].numresolutions;
+                                                if ( res_factor >= max_res){
+                                                        opj_event_msg(p_manager, EVT_ERROR, "Resolution factor is greater than the maximum resolution in the component.\n");
+                                                        return OPJ_FALSE;
+                                                }
+                                                p_j2k->m_private_image->comps[it_comp].factor = res_factor;
+                                        }
+                                        return OPJ_TRUE;
+                                }
+                        }
+                }
+        }
+
+        return OPJ_FALSE;
+}
+
+static OPJ_BOOL opj_j2k_rewind_tiles (  opj_j2k_t * p_j2k,
+                                        opj_stream_private_t *p_stream,
+                                        opj_event_mgr_t * p_manager )
+{
+        OPJ_OFF_T l_first_sot = (OPJ_OFF_T)p_j2k->cstr_index->main_head_end + 2;
+
+        if (p_j2k->m_specific_param.m_decoder.m_state == J2K_STATE_TPHSOT &&
+            opj_stream_tell(p_stream) == l_first_sot) {
+                return OPJ_TRUE;
+        }
+
+        if (! (p_j2k->m_specific_param.m_decoder.m_state & (J2K_STATE_TPHSOT | J2K_STATE_EOC | J2K_STATE_NEOC))) {
+                opj_event_msg(p_manager, EVT_ERROR, "Need to decode the main header before decoding the tiles\n");
+                return OPJ_FALSE;
+        }
+
+        if (! opj_stream_read_seek(p_stream, l_first_sot, p_manager)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Problem with seek function\n");
+                return OPJ_FALSE;
+        }
+        p_j2k->m_specific_param.m_decoder.m_state = J2K_STATE_TPHSOT;
+        p_j2k->m_specific_param.m_decoder.m_can_decode = 0;
+        p_j2k->m_current_tile_number = 0;
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_set_tile_cache(opj_j2k_t *p_j2k,
+                                OPJ_SIZE_T p_max_size,
+                                opj_event_mgr_t * p_manager)
+{
+        opj_j2k_dec_t * l_decoder = &(p_j2k->m_specific_param.m_decoder);
+
+        if (! p_max_size) {
+                opj_tile_cache_destroy(l_decoder->m_tile_cache);
+                l_decoder->m_tile_cache = 00;
+                return OPJ_TRUE;
+        }
+
+        if (l_decoder->m_tile_cache) {
+                opj_tile_cache_set_max_size(l_decoder->m_tile_cache, p_max_size);
+                return OPJ_TRUE;
+        }
+
+        l_decoder->m_tile_cache = opj_tile_cache_create(p_max_size);
+        if (! l_decoder->m_tile_cache) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to create the cache of decoded tiles\n");
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+void opj_j2k_set_decoded_tile_handler(  opj_j2k_t *p_j2k,
+                                        opj_decoded_tile_fn p_tile_fn,
+                                        void * p_user_data,
+                                        OPJ_BOOL p_skip_image)
+{
+        p_j2k->m_cp.m_specific_param.m_dec.m_tile_fn = p_tile_fn;
+        p_j2k->m_cp.m_specific_param.m_dec.m_tile_user_data = p_user_data;
+        p_j2k->m_cp.m_specific_param.m_dec.m_skip_image = p_skip_image ? 1 : 0;
+}
+
+OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
+                        opj_stream_private_t *p_stream,
+                        opj_event_mgr_t * p_manager )
+{
+        OPJ_UINT32 i, j;
+        OPJ_UINT32 l_nb_tiles;
+        OPJ_SIZE_T l_max_tile_size = 0, l_current_tile_size;
+        OPJ_BYTE * l_current_data = 00;
+        OPJ_BOOL l_reuse_data = OPJ_FALSE;
+        opj_tcd_t* p_tcd = 00;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_stream != 00);
+        assert(p_manager != 00);
+	
+        p_tcd = p_j2k->m_tcd;
+
+        l_nb_tiles = p_j2k->m_cp.th * p_j2k->m_cp.tw;
+        if (l_nb_tiles == 1) {
+                /* the image data can only be used in place if it is stored as OPJ_INT32 */
+                l_reuse_data = OPJ_TRUE;
+                for (j=0;j<p_tcd->image->numcomps;++j) {
+                        if (p_tcd->image->comps[j].native_size) {
+                                l_reuse_data = OPJ_FALSE;
+                                break;
+                        }
+                }
+        }
+
+        for (i=0;i<l_nb_tiles;++i) {
+                if (! opj_j2k_pre_write_tile(p_j2k,i,p_stream,p_manager)) {
+                        if (l_current_data) {
+                                opj_free(l_current_data);
+                        }
+                        return OPJ_FALSE;
+                }
 
                 /* if we only have one tile, then simply set tile component data equal to image component data */
                 /* otherwise, allocate the data */
                 for (j=0;j<p_j2k->m_tcd->image->numcomps;++j) {
                         opj_tcd_tilecomp_t* l_tilec = p_tcd->tcd_image->tiles->comps + j;
-                        if (l_nb_tiles == 1) {
+                        if (l_reuse_data) {
 												        opj_image_comp_t * l_img_comp = p_tcd->image->comps + j;
 												        l_tilec->data  =  l_img_comp->data;
 												        l_tilec->ownsData = OPJ_FALSE;
@@ -9976,7 +13488,7 @@ OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
                         }
                 }
                 l_current_tile_size = opj_tcd_get_encoded_tile_size(p_j2k->m_tcd);
-                if (l_nb_tiles > 1) {
+                if (!l_reuse_data) {
                         if (l_current_tile_size > l_max_tile_size) {
 												        OPJ_BYTE *l_new_current_data = (OPJ_BYTE *) opj_realloc(l_current_data, l_current_tile_size);
 												        if (! l_new_current_data) {
@@ -10007,78 +13519,222 @@ OPJ_BOOL opj_j2k_encode(opj_j2k_t * p_j2k,
                 }
         }
 
-        if (l_current_data) {
-                opj_free(l_current_data);
+        if (l_current_data) {
+                opj_free(l_current_data);
+        }
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_end_compress(  opj_j2k_t *p_j2k,
+                                                        opj_stream_private_t *p_stream,
+                                                        opj_event_mgr_t * p_manager)
+{
+        /* customization of the encoding */
+        if (! opj_j2k_setup_end_compress(p_j2k, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        if (! opj_j2k_exec (p_j2k, p_j2k->m_procedure_list, p_stream, p_manager))
+        {
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_start_compress(opj_j2k_t *p_j2k,
+                                                            opj_stream_private_t *p_stream,
+                                                            opj_image_t * p_image,
+                                                            opj_event_mgr_t * p_manager)
+{
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_stream != 00);
+        assert(p_manager != 00);
+
+        /* a new compression does not reuse the tile coder of a previous frame */
+        opj_j2k_release_frame(p_j2k);
+        p_j2k->m_specific_param.m_encoder.m_keep_frame = OPJ_FALSE;
+
+        p_j2k->m_private_image = opj_image_create0();
+        if (! p_j2k->m_private_image) {
+                opj_event_msg(p_manager, EVT_ERROR, "Failed to allocate image header." );
+                return OPJ_FALSE;
+        }
+        opj_copy_image_header(p_image, p_j2k->m_private_image);
+
+        if (! opj_j2k_take_image_data(p_j2k, p_image, p_manager)) {
+                return OPJ_FALSE;
+        }
+        p_j2k->m_specific_param.m_encoder.m_strip_y = p_image->y0;
+
+        /* customization of the validation */
+        if (! opj_j2k_setup_encoding_validation (p_j2k, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* validation of the parameters codec */
+        if (! opj_j2k_exec(p_j2k,p_j2k->m_validation_list,p_stream,p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* customization of the encoding */
+        if (! opj_j2k_setup_header_writing(p_j2k, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* write header */
+        if (! opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_encoder_next_frame(opj_j2k_t *p_j2k,
+                                    opj_stream_private_t *p_stream,
+                                    opj_image_t * p_image,
+                                    opj_event_mgr_t * p_manager)
+{
+        OPJ_UINT32 it_comp;
+        opj_image_t * l_image = 00;
+
+        /* preconditions */
+        assert(p_j2k != 00);
+        assert(p_stream != 00);
+        assert(p_manager != 00);
+
+        l_image = p_j2k->m_private_image;
+
+        /* first frame of the sequence */
+        if (! l_image || ! p_j2k->m_tcd) {
+                if (! opj_j2k_start_compress(p_j2k, p_stream, p_image, p_manager)) {
+                        return OPJ_FALSE;
+                }
+                p_j2k->m_specific_param.m_encoder.m_keep_frame = OPJ_TRUE;
+                return OPJ_TRUE;
+        }
+
+        if ((p_image->x0 != l_image->x0) || (p_image->y0 != l_image->y0) ||
+                (p_image->x1 != l_image->x1) || (p_image->y1 != l_image->y1) ||
+                (p_image->numcomps != l_image->numcomps) || (! p_image->comps)) {
+                opj_event_msg(p_manager, EVT_ERROR, "The size of the frame differs from the previous one.\n");
+                return OPJ_FALSE;
+        }
+
+        for (it_comp = 0; it_comp < l_image->numcomps; ++it_comp) {
+                opj_image_comp_t * l_new = p_image->comps + it_comp;
+                opj_image_comp_t * l_old = l_image->comps + it_comp;
+
+                if ((l_new->dx != l_old->dx) || (l_new->dy != l_old->dy) ||
+                        (l_new->w != l_old->w) || (l_new->h != l_old->h) ||
+                        (l_new->x0 != l_old->x0) || (l_new->y0 != l_old->y0) ||
+                        (l_new->prec != l_old->prec) || (l_new->sgnd != l_old->sgnd)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Component %d of the frame differs from the previous one.\n", it_comp);
+                        return OPJ_FALSE;
+                }
+
+                /* samples of the previous frame */
+                if (l_old->data) {
+                        opj_image_data_free(l_old->data);
+                        l_old->data = 00;
+                }
+                if (l_old->native_data) {
+                        opj_image_data_free(l_old->native_data);
+                        l_old->native_data = 00;
+                }
+                l_old->native_size = l_new->native_size;
+                l_old->alpha = l_new->alpha;
+        }
+
+        if (! opj_j2k_take_image_data(p_j2k, p_image, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        p_j2k->m_current_tile_number = 0;
+        p_j2k->m_specific_param.m_encoder.m_strip_y = l_image->y0;
+
+        /* the parameters were validated with the first frame: only write the header */
+        if (! opj_j2k_setup_header_writing(p_j2k, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        if (! opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+static void opj_j2k_release_frame(opj_j2k_t *p_j2k)
+{
+        opj_j2k_release_frame_buffers(p_j2k);
+
+        if (p_j2k->m_private_image) {
+                opj_image_destroy(p_j2k->m_private_image);
+                p_j2k->m_private_image = 00;
+        }
+}
+
+static void opj_j2k_release_frame_buffers(opj_j2k_t *p_j2k)
+{
+        opj_tcd_destroy(p_j2k->m_tcd);
+        p_j2k->m_tcd = 00;
+
+        if (p_j2k->m_specific_param.m_encoder.m_encoded_tile_data) {
+                opj_free(p_j2k->m_specific_param.m_encoder.m_encoded_tile_data);
+                p_j2k->m_specific_param.m_encoder.m_encoded_tile_data = 00;
+        }
+        p_j2k->m_specific_param.m_encoder.m_encoded_tile_size = 0;
+        p_j2k->m_specific_param.m_encoder.m_encoded_tile_data_size = 0;
+
+        if (p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
+                opj_free(p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer);
+                p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer = 00;
+                p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current = 00;
         }
-        return OPJ_TRUE;
-}
 
-OPJ_BOOL opj_j2k_end_compress(  opj_j2k_t *p_j2k,
-                                                        opj_stream_private_t *p_stream,
-                                                        opj_event_mgr_t * p_manager)
-{
-        /* customization of the encoding */
-        if (! opj_j2k_setup_end_compress(p_j2k, p_manager)) {
-                return OPJ_FALSE;
+        if (p_j2k->m_specific_param.m_encoder.m_strip_data) {
+                opj_free(p_j2k->m_specific_param.m_encoder.m_strip_data);
+                p_j2k->m_specific_param.m_encoder.m_strip_data = 00;
         }
+        p_j2k->m_specific_param.m_encoder.m_strip_data_size = 0;
 
-        if (! opj_j2k_exec (p_j2k, p_j2k->m_procedure_list, p_stream, p_manager))
-        {
-                return OPJ_FALSE;
+        if (p_j2k->m_specific_param.m_encoder.m_strip_tile_data) {
+                opj_free(p_j2k->m_specific_param.m_encoder.m_strip_tile_data);
+                p_j2k->m_specific_param.m_encoder.m_strip_tile_data = 00;
         }
+        p_j2k->m_specific_param.m_encoder.m_strip_tile_data_size = 0;
+        p_j2k->m_specific_param.m_encoder.m_strip_y = 0;
 
-        return OPJ_TRUE;
+        p_j2k->m_current_tile_number = 0;
 }
 
-OPJ_BOOL opj_j2k_start_compress(opj_j2k_t *p_j2k,
-                                                            opj_stream_private_t *p_stream,
-                                                            opj_image_t * p_image,
-                                                            opj_event_mgr_t * p_manager)
+static OPJ_BOOL opj_j2k_take_image_data(opj_j2k_t *p_j2k,
+                                        opj_image_t * p_image,
+                                        opj_event_mgr_t * p_manager)
 {
-        /* preconditions */
-        assert(p_j2k != 00);
-        assert(p_stream != 00);
-        assert(p_manager != 00);
-
-        p_j2k->m_private_image = opj_image_create0();
-        if (! p_j2k->m_private_image) {
-                opj_event_msg(p_manager, EVT_ERROR, "Failed to allocate image header." );
-                return OPJ_FALSE;
-        }
-        opj_copy_image_header(p_image, p_j2k->m_private_image);
-
         /* TODO_MSD: Find a better way */
         if (p_image->comps) {
                 OPJ_UINT32 it_comp;
                 for (it_comp = 0 ; it_comp < p_image->numcomps; it_comp++) {
+                        if (p_image->comps[it_comp].native_size &&
+                                p_image->comps[it_comp].native_size != opj_image_native_size(p_image->comps[it_comp].prec)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Native sample size of component %d does not match its precision.\n", it_comp);
+                                return OPJ_FALSE;
+                        }
                         if (p_image->comps[it_comp].data) {
                                 p_j2k->m_private_image->comps[it_comp].data =p_image->comps[it_comp].data;
                                 p_image->comps[it_comp].data = NULL;
 
                         }
+                        if (p_image->comps[it_comp].native_data) {
+                                p_j2k->m_private_image->comps[it_comp].native_data = p_image->comps[it_comp].native_data;
+                                p_image->comps[it_comp].native_data = NULL;
+                        }
                 }
         }
 
-        /* customization of the validation */
-        if (! opj_j2k_setup_encoding_validation (p_j2k, p_manager)) {
-                return OPJ_FALSE;
-        }
-
-        /* validation of the parameters codec */
-        if (! opj_j2k_exec(p_j2k,p_j2k->m_validation_list,p_stream,p_manager)) {
-                return OPJ_FALSE;
-        }
-
-        /* customization of the encoding */
-        if (! opj_j2k_setup_header_writing(p_j2k, p_manager)) {
-                return OPJ_FALSE;
-        }
-
-        /* write header */
-        if (! opj_j2k_exec (p_j2k,p_j2k->m_procedure_list,p_stream,p_manager)) {
-                return OPJ_FALSE;
-        }
-
         return OPJ_TRUE;
 }
 
@@ -10117,7 +13773,7 @@ static void opj_get_tile_dimensions(opj_image_t * l_image,
                              OPJ_UINT32* l_offset_y,
                              OPJ_UINT32* l_image_width,
                              OPJ_UINT32* l_stride,
-                             OPJ_UINT32* l_tile_offset) {
+                             OPJ_SIZE_T* l_tile_offset) {
 	OPJ_UINT32 l_remaining;
 	*l_size_comp = l_img_comp->prec >> 3; /* (/8) */
 	l_remaining = l_img_comp->prec & 7;  /* (%8) */
@@ -10135,7 +13791,7 @@ static void opj_get_tile_dimensions(opj_image_t * l_image,
 	*l_offset_y = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)l_image->y0, (OPJ_INT32)l_img_comp->dy);
 	*l_image_width = (OPJ_UINT32)opj_int_ceildiv((OPJ_INT32)l_image->x1 - (OPJ_INT32)l_image->x0, (OPJ_INT32)l_img_comp->dx);
 	*l_stride = *l_image_width - *l_width;
-	*l_tile_offset = ((OPJ_UINT32)l_tilec->x0 - *l_offset_x) + ((OPJ_UINT32)l_tilec->y0 - *l_offset_y) * *l_image_width;
+	*l_tile_offset = ((OPJ_UINT32)l_tilec->x0 - *l_offset_x) + (OPJ_SIZE_T)((OPJ_UINT32)l_tilec->y0 - *l_offset_y) * *l_image_width;
 }
 
 static void opj_j2k_get_tile_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data)
@@ -10147,7 +13803,8 @@ static void opj_j2k_get_tile_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data)
                 OPJ_INT32 * l_src_ptr;
                 opj_tcd_tilecomp_t * l_tilec = p_tcd->tcd_image->tiles->comps + i;
                 opj_image_comp_t * l_img_comp = l_image->comps + i;
-                OPJ_UINT32 l_size_comp,l_width,l_height,l_offset_x,l_offset_y, l_image_width,l_stride,l_tile_offset;
+                OPJ_UINT32 l_size_comp,l_width,l_height,l_offset_x,l_offset_y, l_image_width,l_stride;
+                OPJ_SIZE_T l_tile_offset;
 
                 opj_get_tile_dimensions(l_image,
                                         l_tilec,
@@ -10161,6 +13818,18 @@ static void opj_j2k_get_tile_data (opj_tcd_t * p_tcd, OPJ_BYTE * p_data)
                                         &l_stride,
                                         &l_tile_offset);
 
+                if (l_img_comp->native_size) {
+                        /* samples stored at their native width are copied row by row */
+                        const OPJ_BYTE * l_src_native = (const OPJ_BYTE *) l_img_comp->native_data + l_tile_offset * l_size_comp;
+
+                        for (j=0;j<l_height;++j) {
+                                memcpy(p_data, l_src_native, (OPJ_SIZE_T)l_width * l_size_comp);
+                                p_data += (OPJ_SIZE_T)l_width * l_size_comp;
+                                l_src_native += (OPJ_SIZE_T)l_image_width * l_size_comp;
+                        }
+                        continue;
+                }
+
                 l_src_ptr = l_img_comp->data + l_tile_offset;
 
                 switch (l_size_comp) {
@@ -10239,11 +13908,32 @@ static OPJ_BOOL opj_j2k_post_write_tile (      opj_j2k_t * p_j2k,
         OPJ_BYTE * l_current_data = 00;
         OPJ_UINT32 l_tile_size = 0;
         OPJ_UINT32 l_available_data;
+        opj_profile_stats_t * l_stats = 00;
+        OPJ_FLOAT64 l_start;
 
         /* preconditions */
         assert(p_j2k->m_specific_param.m_encoder.m_encoded_tile_data);
 
         l_tile_size = p_j2k->m_specific_param.m_encoder.m_encoded_tile_size;
+
+        /* the PLT markers need the length of each packet, and room in the tile-part headers */
+        if (p_j2k->m_cp.m_specific_param.m_enc.m_plt) {
+                opj_tcd_tile_t * l_tile = p_j2k->m_tcd->tcd_image->tiles;
+
+                if (! opj_tcd_record_packet_lengths(p_j2k->m_tcd, p_j2k->m_current_tile_number, p_manager)) {
+                        return OPJ_FALSE;
+                }
+                l_tile_size = opj_uint_adds(l_tile_size, opj_j2k_get_max_plt_size(l_tile->nb_packets, p_j2k->m_cp.tcps[p_j2k->m_current_tile_number].m_nb_tile_parts));
+                if (l_tile_size > p_j2k->m_specific_param.m_encoder.m_encoded_tile_data_size) {
+                        OPJ_BYTE * l_new_data = (OPJ_BYTE *) opj_realloc(p_j2k->m_specific_param.m_encoder.m_encoded_tile_data, l_tile_size);
+                        if (! l_new_data) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to encode tile %d\n", p_j2k->m_current_tile_number);
+                                return OPJ_FALSE;
+                        }
+                        p_j2k->m_specific_param.m_encoder.m_encoded_tile_data = l_new_data;
+                        p_j2k->m_specific_param.m_encoder.m_encoded_tile_data_size = l_tile_size;
+                }
+        }
         l_available_data = l_tile_size;
         l_current_data = p_j2k->m_specific_param.m_encoder.m_encoded_tile_data;
 
@@ -10262,11 +13952,14 @@ static OPJ_BOOL opj_j2k_post_write_tile (      opj_j2k_t * p_j2k,
         l_available_data -= l_nb_bytes_written;
         l_nb_bytes_written = l_tile_size - l_available_data;
 
+        l_stats = opj_profile_get_tile(p_j2k->m_profile, p_j2k->m_current_tile_number);
+        l_start = opj_profile_start(l_stats);
         if ( opj_stream_write_data(     p_stream,
                                                                 p_j2k->m_specific_param.m_encoder.m_encoded_tile_data,
                                                                 l_nb_bytes_written,p_manager) != l_nb_bytes_written) {
                 return OPJ_FALSE;
         }
+        opj_profile_stop(l_stats, OPJ_PROFILE_IO, l_start);
 
         ++p_j2k->m_current_tile_number;
 
@@ -10284,7 +13977,7 @@ static OPJ_BOOL opj_j2k_setup_end_compress (opj_j2k_t *p_j2k, opj_event_mgr_t *
                 return OPJ_FALSE;
         }
 
-        if (OPJ_IS_CINEMA(p_j2k->m_cp.rsiz)) {
+        if (p_j2k->m_cp.m_specific_param.m_enc.m_tlm) {
                 if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_write_updated_tlm, p_manager)) {
                         return OPJ_FALSE;
                 }
@@ -10296,9 +13989,6 @@ static OPJ_BOOL opj_j2k_setup_end_compress (opj_j2k_t *p_j2k, opj_event_mgr_t *
         if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_end_encoding, p_manager)) {
                 return OPJ_FALSE;
         }
-        if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_destroy_header_memory, p_manager)) {
-                return OPJ_FALSE;
-        }
         return OPJ_TRUE;
 }
 
@@ -10345,6 +14035,12 @@ static OPJ_BOOL opj_j2k_setup_header_writing (opj_j2k_t *p_j2k, opj_event_mgr_t
                 return OPJ_FALSE;
         }
 
+        if (p_j2k->m_cp.m_specific_param.m_enc.m_tlm) {
+                if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_write_tlm, p_manager)) {
+                        return OPJ_FALSE;
+                }
+        }
+
         if (OPJ_IS_CINEMA(p_j2k->m_cp.rsiz)) {
                 /* No need for COC or QCC, QCD and COD are used
                 if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_write_all_coc, p_manager)) {
@@ -10354,10 +14050,6 @@ static OPJ_BOOL opj_j2k_setup_header_writing (opj_j2k_t *p_j2k, opj_event_mgr_t
                         return OPJ_FALSE;
                 }
                 */
-                if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_write_tlm, p_manager)) {
-                        return OPJ_FALSE;
-                }
-
                 if (p_j2k->m_cp.rsiz == OPJ_PROFILE_CINEMA_4K) {
                         if (! opj_procedure_list_add_procedure(p_j2k->m_procedure_list,(opj_procedure)opj_j2k_write_poc, p_manager)) {
                                 return OPJ_FALSE;
@@ -10472,7 +14164,7 @@ static OPJ_BOOL opj_j2k_write_first_tile_part (opj_j2k_t *p_j2k,
         /* Writing Psot in SOT marker */
         opj_write_bytes(l_begin_data + 6,l_nb_bytes_written,4);                                 /* PSOT */
 
-        if (OPJ_IS_CINEMA(l_cp->rsiz)){
+        if (l_cp->m_specific_param.m_enc.m_tlm) {
                 opj_j2k_update_tlm(p_j2k,l_nb_bytes_written);
         }
 
@@ -10536,7 +14228,7 @@ static OPJ_BOOL opj_j2k_write_all_tile_parts(  opj_j2k_t *p_j2k,
                 /* Writing Psot in SOT marker */
                 opj_write_bytes(l_begin_data + 6,l_part_tile_size,4);                                   /* PSOT */
 
-                if (OPJ_IS_CINEMA(l_cp->rsiz)) {
+                if (l_cp->m_specific_param.m_enc.m_tlm) {
                         opj_j2k_update_tlm(p_j2k,l_part_tile_size);
                 }
 
@@ -10577,7 +14269,7 @@ static OPJ_BOOL opj_j2k_write_all_tile_parts(  opj_j2k_t *p_j2k,
                         /* Writing Psot in SOT marker */
                         opj_write_bytes(l_begin_data + 6,l_part_tile_size,4);                                   /* PSOT */
 
-                        if (OPJ_IS_CINEMA(l_cp->rsiz)) {
+                        if (l_cp->m_specific_param.m_enc.m_tlm) {
                                 opj_j2k_update_tlm(p_j2k,l_part_tile_size);
                         }
 
@@ -10594,24 +14286,38 @@ static OPJ_BOOL opj_j2k_write_updated_tlm( opj_j2k_t *p_j2k,
                                                                     struct opj_stream_private *p_stream,
                                                                     struct opj_event_mgr * p_manager )
 {
-        OPJ_UINT32 l_tlm_size;
+        OPJ_UINT32 l_entry_size, l_nb_tile_parts, l_marker_tile_parts, l_remaining_tile_parts, l_tlm_size;
         OPJ_OFF_T l_tlm_position, l_current_position;
+        OPJ_BYTE * l_tlm_data;
 
         /* preconditions */
         assert(p_j2k != 00);
         assert(p_manager != 00);
         assert(p_stream != 00);
 
-        l_tlm_size = 5 * p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
-        l_tlm_position = 6 + p_j2k->m_specific_param.m_encoder.m_tlm_start;
+        l_entry_size = opj_j2k_get_tlm_ttlm_size(p_j2k) + 4;
+        l_nb_tile_parts = opj_j2k_get_tlm_nb_tile_parts(p_j2k);
+        l_remaining_tile_parts = p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
+        l_tlm_data = p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer;
+        l_tlm_position = p_j2k->m_specific_param.m_encoder.m_tlm_start;
         l_current_position = opj_stream_tell(p_stream);
 
-        if (! opj_stream_seek(p_stream,l_tlm_position,p_manager)) {
-                return OPJ_FALSE;
-        }
+        /* the lengths of each TLM marker follow its 6 bytes header */
+        while (l_remaining_tile_parts) {
+                l_marker_tile_parts = opj_uint_min(l_remaining_tile_parts, l_nb_tile_parts);
+                l_tlm_size = l_entry_size * l_marker_tile_parts;
 
-        if (opj_stream_write_data(p_stream,p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer,l_tlm_size,p_manager) != l_tlm_size) {
-                return OPJ_FALSE;
+                if (! opj_stream_seek(p_stream,l_tlm_position + 6,p_manager)) {
+                        return OPJ_FALSE;
+                }
+
+                if (opj_stream_write_data(p_stream,l_tlm_data,l_tlm_size,p_manager) != l_tlm_size) {
+                        return OPJ_FALSE;
+                }
+
+                l_tlm_data += l_tlm_size;
+                l_tlm_position += 6 + l_tlm_size;
+                l_remaining_tile_parts -= l_marker_tile_parts;
         }
 
         if (! opj_stream_seek(p_stream,l_current_position,p_manager)) {
@@ -10630,44 +14336,13 @@ static OPJ_BOOL opj_j2k_end_encoding(  opj_j2k_t *p_j2k,
         assert(p_manager != 00);
         assert(p_stream != 00);
 
-        opj_tcd_destroy(p_j2k->m_tcd);
-        p_j2k->m_tcd = 00;
-
-        if (p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
-                opj_free(p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer);
-                p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer = 0;
-                p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current = 0;
-        }
-
-        if (p_j2k->m_specific_param.m_encoder.m_encoded_tile_data) {
-                opj_free(p_j2k->m_specific_param.m_encoder.m_encoded_tile_data);
-                p_j2k->m_specific_param.m_encoder.m_encoded_tile_data = 0;
-        }
-
-        p_j2k->m_specific_param.m_encoder.m_encoded_tile_size = 0;
-
-        return OPJ_TRUE;
-}
-
-/**
- * Destroys the memory associated with the decoding of headers.
- */
-static OPJ_BOOL opj_j2k_destroy_header_memory ( opj_j2k_t * p_j2k,
-                                                opj_stream_private_t *p_stream,
-                                                opj_event_mgr_t * p_manager
-                                                )
-{
-        /* preconditions */
-        assert(p_j2k != 00);
-        assert(p_stream != 00);
-        assert(p_manager != 00);
-
-        if (p_j2k->m_specific_param.m_encoder.m_header_tile_data) {
-                opj_free(p_j2k->m_specific_param.m_encoder.m_header_tile_data);
-                p_j2k->m_specific_param.m_encoder.m_header_tile_data = 0;
+        if (! p_j2k->m_specific_param.m_encoder.m_keep_frame) {
+                opj_j2k_release_frame_buffers(p_j2k);
+                return OPJ_TRUE;
         }
 
-        p_j2k->m_specific_param.m_encoder.m_header_tile_data_size = 0;
+        p_j2k->m_current_tile_number = 0;
+        p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current = p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer;
 
         return OPJ_TRUE;
 }
@@ -10743,6 +14418,11 @@ static OPJ_BOOL opj_j2k_create_tcd(     opj_j2k_t *p_j2k,
         assert(p_manager != 00);
         assert(p_stream != 00);
 
+        /* the tile coder of the previous frame is kept with its private image */
+        if (p_j2k->m_tcd) {
+                return OPJ_TRUE;
+        }
+
         p_j2k->m_tcd = opj_tcd_create(OPJ_FALSE);
 
         if (! p_j2k->m_tcd) {
@@ -10755,6 +14435,7 @@ static OPJ_BOOL opj_j2k_create_tcd(     opj_j2k_t *p_j2k,
                 p_j2k->m_tcd = 00;
                 return OPJ_FALSE;
         }
+        p_j2k->m_tcd->m_profile = p_j2k->m_profile;
 
         return OPJ_TRUE;
 }
@@ -10762,7 +14443,7 @@ static OPJ_BOOL opj_j2k_create_tcd(     opj_j2k_t *p_j2k,
 OPJ_BOOL opj_j2k_write_tile (opj_j2k_t * p_j2k,
                                                  OPJ_UINT32 p_tile_index,
                                                  OPJ_BYTE * p_data,
-                                                 OPJ_UINT32 p_data_size,
+                                                 OPJ_SIZE_T p_data_size,
                                                  opj_stream_private_t *p_stream,
                                                  opj_event_mgr_t * p_manager )
 {
@@ -10795,3 +14476,334 @@ OPJ_BOOL opj_j2k_write_tile (opj_j2k_t * p_j2k,
 
         return OPJ_TRUE;
 }
+
+static OPJ_UINT32 opj_j2k_get_user_sample_size(const opj_image_comp_t * p_comp)
+{
+        OPJ_UINT32 l_size_comp = p_comp->prec >> 3; /* (/8) */
+
+        if (p_comp->prec & 7) {
+                ++l_size_comp;
+        }
+        if (l_size_comp == 3) {
+                l_size_comp = 4;
+        }
+
+        return l_size_comp;
+}
+
+static OPJ_UINT32 opj_j2k_get_strip_comp_rows(const opj_image_comp_t * p_comp,
+                                              OPJ_UINT32 p_y0,
+                                              OPJ_UINT32 p_y1)
+{
+        return opj_uint_ceildiv(p_y1, p_comp->dy) - opj_uint_ceildiv(p_y0, p_comp->dy);
+}
+
+static OPJ_SIZE_T opj_j2k_get_strip_comp_size(const opj_image_t * p_image,
+                                              const opj_image_comp_t * p_comp,
+                                              OPJ_UINT32 p_y0,
+                                              OPJ_UINT32 p_y1)
+{
+        OPJ_UINT32 l_width = opj_uint_ceildiv(p_image->x1, p_comp->dx) - opj_uint_ceildiv(p_image->x0, p_comp->dx);
+
+        return (OPJ_SIZE_T)l_width * opj_j2k_get_strip_comp_rows(p_comp, p_y0, p_y1) * opj_j2k_get_user_sample_size(p_comp);
+}
+
+static OPJ_BOOL opj_j2k_write_strip_tiles(opj_j2k_t *p_j2k,
+                                          OPJ_UINT32 p_tile_row,
+                                          OPJ_UINT32 p_y0,
+                                          OPJ_UINT32 p_y1,
+                                          opj_stream_private_t *p_stream,
+                                          opj_event_mgr_t * p_manager)
+{
+        opj_image_t * l_image = p_j2k->m_private_image;
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_j2k_enc_t * l_enc = &(p_j2k->m_specific_param.m_encoder);
+        OPJ_UINT32 l_tile_col, compno, j;
+
+        for (l_tile_col = 0; l_tile_col < l_cp->tw; ++l_tile_col) {
+                OPJ_UINT32 l_x0 = opj_uint_max(l_cp->tx0 + l_tile_col * l_cp->tdx, l_image->x0);
+                OPJ_UINT32 l_x1 = opj_uint_min(l_cp->tx0 + (l_tile_col + 1) * l_cp->tdx, l_image->x1);
+                OPJ_SIZE_T l_tile_size = 0;
+                OPJ_SIZE_T l_src_offset = 0;
+                OPJ_BYTE * l_dest_ptr = 00;
+
+                for (compno = 0; compno < l_image->numcomps; ++compno) {
+                        opj_image_comp_t * l_img_comp = l_image->comps + compno;
+                        OPJ_UINT32 l_tile_width = opj_uint_ceildiv(l_x1, l_img_comp->dx) - opj_uint_ceildiv(l_x0, l_img_comp->dx);
+
+                        l_tile_size += (OPJ_SIZE_T)l_tile_width * opj_j2k_get_strip_comp_rows(l_img_comp, p_y0, p_y1) * opj_j2k_get_user_sample_size(l_img_comp);
+                }
+
+                if (l_tile_size > l_enc->m_strip_tile_data_size) {
+                        if (l_enc->m_strip_tile_data) {
+                                opj_free(l_enc->m_strip_tile_data);
+                        }
+                        l_enc->m_strip_tile_data_size = 0;
+                        l_enc->m_strip_tile_data = (OPJ_BYTE *) opj_malloc(l_tile_size);
+                        if (! l_enc->m_strip_tile_data) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to gather the tile data\n");
+                                return OPJ_FALSE;
+                        }
+                        l_enc->m_strip_tile_data_size = l_tile_size;
+                }
+
+                l_dest_ptr = l_enc->m_strip_tile_data;
+                for (compno = 0; compno < l_image->numcomps; ++compno) {
+                        opj_image_comp_t * l_img_comp = l_image->comps + compno;
+                        OPJ_SIZE_T l_size_comp = opj_j2k_get_user_sample_size(l_img_comp);
+                        OPJ_SIZE_T l_row_size = (opj_uint_ceildiv(l_image->x1, l_img_comp->dx) - opj_uint_ceildiv(l_image->x0, l_img_comp->dx)) * l_size_comp;
+                        OPJ_SIZE_T l_offset_x = (opj_uint_ceildiv(l_x0, l_img_comp->dx) - opj_uint_ceildiv(l_image->x0, l_img_comp->dx)) * l_size_comp;
+                        OPJ_SIZE_T l_tile_row_size = (opj_uint_ceildiv(l_x1, l_img_comp->dx) - opj_uint_ceildiv(l_x0, l_img_comp->dx)) * l_size_comp;
+                        OPJ_UINT32 l_nb_rows = opj_j2k_get_strip_comp_rows(l_img_comp, p_y0, p_y1);
+                        const OPJ_BYTE * l_src_ptr = l_enc->m_strip_data + l_src_offset + l_offset_x;
+
+                        for (j = 0; j < l_nb_rows; ++j) {
+                                memcpy(l_dest_ptr, l_src_ptr, l_tile_row_size);
+                                l_dest_ptr += l_tile_row_size;
+                                l_src_ptr += l_row_size;
+                        }
+                        l_src_offset += l_row_size * l_nb_rows;
+                }
+
+                if (! opj_j2k_write_tile(p_j2k, p_tile_row * l_cp->tw + l_tile_col, l_enc->m_strip_tile_data, l_tile_size, p_stream, p_manager)) {
+                        return OPJ_FALSE;
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_write_strip (opj_j2k_t * p_j2k,
+                                                  OPJ_BYTE * p_data,
+                                                  OPJ_UINT32 p_data_size,
+                                                  OPJ_UINT32 p_nb_rows,
+                                                  opj_stream_private_t *p_stream,
+                                                  opj_event_mgr_t * p_manager )
+{
+        opj_image_t * l_image = p_j2k->m_private_image;
+        opj_cp_t * l_cp = &(p_j2k->m_cp);
+        opj_j2k_enc_t * l_enc = &(p_j2k->m_specific_param.m_encoder);
+        OPJ_UINT32 compno, l_y0, l_y1;
+        OPJ_SIZE_T l_data_size = 0;
+
+        if (! l_image || ! p_j2k->m_tcd) {
+                opj_event_msg(p_manager, EVT_ERROR, "opj_start_compress must be called before writing strips\n");
+                return OPJ_FALSE;
+        }
+
+        if ((p_nb_rows == 0) || (p_nb_rows > l_image->y1 - l_enc->m_strip_y)) {
+                opj_event_msg(p_manager, EVT_ERROR, "The strip of %d rows starting at row %d does not fit in the image\n", p_nb_rows, l_enc->m_strip_y);
+                return OPJ_FALSE;
+        }
+
+        l_y0 = l_enc->m_strip_y;
+        l_y1 = l_y0 + p_nb_rows;
+        for (compno = 0; compno < l_image->numcomps; ++compno) {
+                l_data_size += opj_j2k_get_strip_comp_size(l_image, l_image->comps + compno, l_y0, l_y1);
+        }
+        if (l_data_size != p_data_size) {
+                opj_event_msg(p_manager, EVT_ERROR, "Size mismatch between strip data and sent data.\n");
+                return OPJ_FALSE;
+        }
+
+        /* the strip may complete several rows of tiles, or only part of one */
+        while (l_enc->m_strip_y < l_y1) {
+                OPJ_UINT32 l_tile_row = (l_enc->m_strip_y - l_cp->ty0) / l_cp->tdy;
+                OPJ_UINT32 l_tile_y0 = opj_uint_max(l_cp->ty0 + l_tile_row * l_cp->tdy, l_image->y0);
+                OPJ_UINT32 l_tile_y1 = opj_uint_min(l_cp->ty0 + (l_tile_row + 1) * l_cp->tdy, l_image->y1);
+                OPJ_UINT32 l_chunk_y1 = opj_uint_min(l_tile_y1, l_y1);
+                OPJ_SIZE_T l_src_offset = 0;
+                OPJ_SIZE_T l_dest_offset = 0;
+
+                if (l_enc->m_strip_y == l_tile_y0) {
+                        OPJ_SIZE_T l_tile_row_size = 0;
+
+                        for (compno = 0; compno < l_image->numcomps; ++compno) {
+                                l_tile_row_size += opj_j2k_get_strip_comp_size(l_image, l_image->comps + compno, l_tile_y0, l_tile_y1);
+                        }
+
+                        if (l_tile_row_size > l_enc->m_strip_data_size) {
+                                if (l_enc->m_strip_data) {
+                                        opj_free(l_enc->m_strip_data);
+                                }
+                                l_enc->m_strip_data_size = 0;
+                                l_enc->m_strip_data = (OPJ_BYTE *) opj_malloc(l_tile_row_size);
+                                if (! l_enc->m_strip_data) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to store a row of tiles\n");
+                                        return OPJ_FALSE;
+                                }
+                                l_enc->m_strip_data_size = l_tile_row_size;
+                        }
+                }
+
+                for (compno = 0; compno < l_image->numcomps; ++compno) {
+                        opj_image_comp_t * l_img_comp = l_image->comps + compno;
+
+                        memcpy(l_enc->m_strip_data + l_dest_offset + opj_j2k_get_strip_comp_size(l_image, l_img_comp, l_tile_y0, l_enc->m_strip_y),
+                               p_data + l_src_offset + opj_j2k_get_strip_comp_size(l_image, l_img_comp, l_y0, l_enc->m_strip_y),
+                               opj_j2k_get_strip_comp_size(l_image, l_img_comp, l_enc->m_strip_y, l_chunk_y1));
+
+                        l_src_offset += opj_j2k_get_strip_comp_size(l_image, l_img_comp, l_y0, l_y1);
+                        l_dest_offset += opj_j2k_get_strip_comp_size(l_image, l_img_comp, l_tile_y0, l_tile_y1);
+                }
+                l_enc->m_strip_y = l_chunk_y1;
+
+                if (l_enc->m_strip_y == l_tile_y1) {
+                        if (! opj_j2k_write_strip_tiles(p_j2k, l_tile_row, l_tile_y0, l_tile_y1, p_stream, p_manager)) {
+                                return OPJ_FALSE;
+                        }
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_j2k_probe( opj_stream_private_t * p_stream,
+                        opj_probe_info_t * p_info,
+                        opj_event_mgr_t * p_manager )
+{
+        OPJ_BYTE l_data[36];
+        OPJ_UINT32 l_marker, l_marker_size, l_tmp, i;
+        OPJ_UINT32 l_nb_comps, l_x1, l_y1, l_tx1, l_ty1;
+        OPJ_BOOL l_siz_read = OPJ_FALSE;
+
+        /* preconditions */
+        assert(p_stream != 00);
+        assert(p_info != 00);
+        assert(p_manager != 00);
+
+        for (;;) {
+                if (opj_stream_read_data(p_stream, l_data, 4, p_manager) != 4) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Stream too short, expected SIZ and COD marker segments\n");
+                        return OPJ_FALSE;
+                }
+                opj_read_bytes(l_data, &l_marker, 2);
+                opj_read_bytes(l_data + 2, &l_marker_size, 2);
+                if (l_marker < 0xff00 || l_marker_size < 2) {
+                        opj_event_msg(p_manager, EVT_ERROR, "A marker ID was expected (0xff--) instead of %.8x\n", l_marker);
+                        return OPJ_FALSE;
+                }
+                if (l_marker == J2K_MS_SOT || l_marker == J2K_MS_SOD || l_marker == J2K_MS_EOC) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Main header without SIZ or COD marker segment\n");
+                        return OPJ_FALSE;
+                }
+                l_marker_size -= 2;
+
+                if (! l_siz_read) {
+                        if (l_marker != J2K_MS_SIZ) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Expected a SIZ marker after SOC\n");
+                                return OPJ_FALSE;
+                        }
+                        if (l_marker_size < 39 || (l_marker_size - 36) % 3 != 0) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker size\n");
+                                return OPJ_FALSE;
+                        }
+                        if (opj_stream_read_data(p_stream, l_data, 36, p_manager) != 36) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+                                return OPJ_FALSE;
+                        }
+                        opj_read_bytes(l_data, &l_tmp, 2);                      /* Rsiz */
+                        p_info->rsiz = (OPJ_UINT16) l_tmp;
+                        opj_read_bytes(l_data + 2, &l_x1, 4);                   /* Xsiz */
+                        opj_read_bytes(l_data + 6, &l_y1, 4);                   /* Ysiz */
+                        opj_read_bytes(l_data + 10, &p_info->x0, 4);            /* X0siz */
+                        opj_read_bytes(l_data + 14, &p_info->y0, 4);            /* Y0siz */
+                        opj_read_bytes(l_data + 18, &p_info->tdx, 4);           /* XTsiz */
+                        opj_read_bytes(l_data + 22, &p_info->tdy, 4);           /* YTsiz */
+                        opj_read_bytes(l_data + 26, &p_info->tx0, 4);           /* XT0siz */
+                        opj_read_bytes(l_data + 30, &p_info->ty0, 4);           /* YT0siz */
+                        opj_read_bytes(l_data + 34, &l_nb_comps, 2);            /* Csiz */
+
+                        if (l_nb_comps == 0 || l_nb_comps > 16384 || l_nb_comps != (l_marker_size - 36) / 3) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker: number of component is illegal -> %d\n", l_nb_comps);
+                                return OPJ_FALSE;
+                        }
+                        if (p_info->x0 >= l_x1 || p_info->y0 >= l_y1) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker: negative or zero image size\n");
+                                return OPJ_FALSE;
+                        }
+                        if (! p_info->tdx || ! p_info->tdy) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker: invalid tile size (tdx: %d, tdy: %d)\n", p_info->tdx, p_info->tdy);
+                                return OPJ_FALSE;
+                        }
+                        l_tx1 = opj_uint_adds(p_info->tx0, p_info->tdx);
+                        l_ty1 = opj_uint_adds(p_info->ty0, p_info->tdy);
+                        if (p_info->tx0 > p_info->x0 || p_info->ty0 > p_info->y0 || l_tx1 <= p_info->x0 || l_ty1 <= p_info->y0) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Error with SIZ marker: illegal tile offset\n");
+                                return OPJ_FALSE;
+                        }
+                        p_info->width = l_x1 - p_info->x0;
+                        p_info->height = l_y1 - p_info->y0;
+                        p_info->numcomps = l_nb_comps;
+                        p_info->tw = (OPJ_UINT32)(((OPJ_UINT64)l_x1 - p_info->tx0 + p_info->tdx - 1) / p_info->tdx);
+                        p_info->th = (OPJ_UINT32)(((OPJ_UINT64)l_y1 - p_info->ty0 + p_info->tdy - 1) / p_info->tdy);
+
+                        /* the component parameters, by chunks of the buffer on the stack */
+                        for (i = 0; i < l_nb_comps; ) {
+                                OPJ_UINT32 l_chunk = opj_uint_min(l_nb_comps - i, (OPJ_UINT32)(sizeof(l_data) / 3));
+                                OPJ_UINT32 j;
+
+                                if (opj_stream_read_data(p_stream, l_data, l_chunk * 3, p_manager) != l_chunk * 3) {
+                                        opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+                                        return OPJ_FALSE;
+                                }
+                                for (j = 0; j < l_chunk; ++j, ++i) {
+                                        OPJ_UINT32 l_ssiz = l_data[3 * j];
+                                        OPJ_UINT32 l_dx = l_data[3 * j + 1];
+                                        OPJ_UINT32 l_dy = l_data[3 * j + 2];
+
+                                        if (l_dx == 0 || l_dy == 0) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Invalid values for comp = %d : dx=%u dy=%u\n", i, l_dx, l_dy);
+                                                return OPJ_FALSE;
+                                        }
+                                        if (i == 0) {
+                                                p_info->prec = (l_ssiz & 0x7f) + 1;
+                                                p_info->sgnd = l_ssiz >> 7;
+                                                p_info->dx = l_dx;
+                                                p_info->dy = l_dy;
+                                        }
+                                        else if (p_info->prec != (l_ssiz & 0x7f) + 1 || p_info->sgnd != l_ssiz >> 7 ||
+                                                 p_info->dx != l_dx || p_info->dy != l_dy) {
+                                                p_info->mixed_comps = 1;
+                                        }
+                                }
+                        }
+                        l_siz_read = OPJ_TRUE;
+                }
+                else if (l_marker == J2K_MS_COD) {
+                        if (l_marker_size < 10) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Error reading COD marker\n");
+                                return OPJ_FALSE;
+                        }
+                        /* Scod, SGcod (progression, layers, mct) and the first bytes of SPcod */
+                        if (opj_stream_read_data(p_stream, l_data, 10, p_manager) != 10) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+                                return OPJ_FALSE;
+                        }
+                        if (l_data[1] > 4) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Unknown progression order in COD marker\n");
+                                return OPJ_FALSE;
+                        }
+                        if (l_data[5] > 32) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Invalid number of decomposition levels in COD marker\n");
+                                return OPJ_FALSE;
+                        }
+                        p_info->prog_order = (OPJ_PROG_ORDER) l_data[1];
+                        opj_read_bytes(l_data + 2, &p_info->numlayers, 2);
+                        p_info->numresolutions = (OPJ_UINT32) l_data[5] + 1;
+                        p_info->irreversible = (l_data[9] == 0);
+
+                        /* the precinct sizes are not needed */
+                        l_marker_size -= 10;
+                        if (opj_stream_skip(p_stream, (OPJ_OFF_T) l_marker_size, p_manager) != (OPJ_OFF_T) l_marker_size) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+                                return OPJ_FALSE;
+                        }
+                        return OPJ_TRUE;
+                }
+                else if (opj_stream_skip(p_stream, (OPJ_OFF_T) l_marker_size, p_manager) != (OPJ_OFF_T) l_marker_size) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+                        return OPJ_FALSE;
+                }
+        }
+}
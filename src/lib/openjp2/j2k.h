@@ -66,6 +66,7 @@ The functions in J2K.C have for goal to read/write the several parts of the code
 #define J2K_CCP_QNTSTY_SEQNT 2
 
 #define OPJ_J2K_DEFAULT_CBLK_DATA_SIZE 8192
+#define OPJ_J2K_INCR_CHUNK_SIZE 65536	/**< Size of the reads of opj_j2k_decode_incremental */
 
 /* ----------------------------------------------------------------------- */
 
@@ -274,6 +275,14 @@ typedef struct opj_tcp
 	OPJ_UINT32 ppt_data_size;
 	/** size of ppt_data*/
 	OPJ_UINT32 ppt_len;
+	/** lengths of the packets of the tile read in its PLT markers, in the order of the packets */
+	OPJ_UINT32 * m_packet_lengths;
+	/** number of lengths in m_packet_lengths */
+	OPJ_UINT32 m_nb_packet_lengths;
+	/** number of lengths m_packet_lengths can hold */
+	OPJ_UINT32 m_max_packet_lengths;
+	/** index (Zplt) of the last PLT marker read in the header of the current tile-part */
+	OPJ_UINT32 m_last_Zplt;
 	/** add fixed_quality */
 	OPJ_FLOAT32 distoratio[100];
 	/** tile-component coding parameters */
@@ -283,7 +292,7 @@ typedef struct opj_tcp
 	/** data for the tile */
 	OPJ_BYTE *		m_data;
 	/** size of data */
-	OPJ_UINT32		m_data_size;
+	OPJ_SIZE_T		m_data_size;
 	/** encoding norms */
 	OPJ_FLOAT64 *	mct_norms;
 	/** the mct decoding matrix */
@@ -309,6 +318,10 @@ typedef struct opj_tcp
 	OPJ_UINT32 cod : 1;
 	/** If ppt == 1 --> there was a PPT marker for the present tile */
 	OPJ_UINT32 ppt : 1;
+	/** If plt_ignored == 1 --> the PLT markers of the present tile were inconsistent, their lengths are not used */
+	OPJ_UINT32 plt_ignored : 1;
+	/** If plt_read == 1 --> a PLT marker was read in the header of the current tile-part */
+	OPJ_UINT32 plt_read : 1;
 	/** indicates if a POC marker has been used O:NO, 1:YES */
 	OPJ_UINT32 POC : 1;
 } opj_tcp_t;
@@ -334,6 +347,10 @@ typedef struct opj_encoding_param
 	OPJ_UINT32 m_fixed_quality : 1;
 	/** Enabling Tile part generation*/
 	OPJ_UINT32 m_tp_on : 1;
+	/** write a TLM marker with the length of every tile-part */
+	OPJ_UINT32 m_tlm : 1;
+	/** write PLT markers with the length of every packet in the tile-part headers */
+	OPJ_UINT32 m_plt : 1;
 }
 opj_encoding_param_t;
 
@@ -343,6 +360,14 @@ typedef struct opj_decoding_param
 	OPJ_UINT32 m_reduce;
 	/** if != 0, then only the first "layer" layers are decoded; if == 0 or not used, all the quality layers are decoded */
 	OPJ_UINT32 m_layer;
+	/** if != 0, components with a precision up to 16 bits are output at their native width (see OPJ_DPARAMETERS_NATIVE_SAMPLES_FLAG) */
+	OPJ_UINT32 m_native_samples;
+	/** function called with the samples of each decoded tile, 00 if none */
+	opj_decoded_tile_fn m_tile_fn;
+	/** client object passed to m_tile_fn */
+	void * m_tile_user_data;
+	/** if != 0, the decoded tiles are only given to m_tile_fn and the output image is not built */
+	OPJ_UINT32 m_skip_image;
 }
 opj_decoding_param_t;
 
@@ -396,7 +421,7 @@ typedef struct opj_cp
 	/** use in case of multiple marker PPM (case on non-finished previous info) */
 	OPJ_INT32 ppm_previous;
 
-	/** tile coding parameters */
+	/** tile coding parameters (for a decompressor, those of a tile whose tccps are 00 are the default ones) */
 	opj_tcp_t *tcps;
 
 	union
@@ -504,6 +529,39 @@ typedef struct opj_j2k_dec
 	OPJ_UINT32 m_nb_tile_parts_correction_checked : 1;
 	OPJ_UINT32 m_nb_tile_parts_correction : 1;
 
+	/** empty tile coding parameters kept by opj_j2k_decoder_reset for the next codestream */
+	opj_tcp_t *m_reusable_tcps;
+	/** number of tile coding parameters in m_reusable_tcps */
+	OPJ_UINT32 m_nb_reusable_tcps;
+
+	/** decoded tiles kept for the next decodings, 00 if disabled */
+	opj_tile_cache_t * m_tile_cache;
+	/** tiles of the current decoding taken from m_tile_cache, whose data is skipped */
+	OPJ_BYTE * m_cached_tiles;
+
+	/** components selected by opj_j2k_set_decoded_components, 00 to decode all of them */
+	OPJ_BOOL * m_used_comps;
+	/** number of components selected in m_used_comps */
+	OPJ_UINT32 m_nb_used_comps;
+
+	/** time (see opj_clock) after which opj_j2k_decode_tiles gives up, 0 if none */
+	OPJ_FLOAT64 m_deadline;
+	/** to tell that the last decoding was given up because m_deadline was reached */
+	OPJ_UINT32 m_deadline_reached : 1;
+
+	/** position in the stream where opj_j2k_decode_incremental resumes, 0 before its first call */
+	OPJ_OFF_T m_incr_pos;
+	/** tile of the tile-part whose data opj_j2k_decode_incremental is reading */
+	OPJ_UINT32 m_incr_tile;
+	/** bytes of the tile-part data left to read by opj_j2k_decode_incremental */
+	OPJ_UINT32 m_incr_tp_left;
+	/** to tell that the data of the current tile-part is not decoded */
+	OPJ_UINT32 m_incr_skip : 1;
+	/** to tell that the current tile-part is the last one of its tile */
+	OPJ_UINT32 m_incr_last_tp : 1;
+	/** to tell that opj_j2k_decode_incremental has read the whole codestream */
+	OPJ_UINT32 m_incr_complete : 1;
+
 } opj_j2k_dec_t;
 
 typedef struct opj_j2k_enc
@@ -538,12 +596,35 @@ typedef struct opj_j2k_enc
 	/* size of the encoded_data */
 	OPJ_UINT32 m_encoded_tile_size;
 
+	/* size of the buffer of the encoded data, more than m_encoded_tile_size when PLT markers are written */
+	OPJ_UINT32 m_encoded_tile_data_size;
+
 	/* encoded data for a tile */
 	OPJ_BYTE * m_header_tile_data;
 
 	/* size of the encoded_data */
 	OPJ_UINT32 m_header_tile_data_size;
 
+	/* rates given by the user for each tile and layer, before they are turned into byte budgets */
+	OPJ_FLOAT32 * m_frame_rates;
+
+	/* next row of the reference grid expected by opj_j2k_write_strip */
+	OPJ_UINT32 m_strip_y;
+
+	/* samples of the row of tiles being filled by opj_j2k_write_strip, component after component */
+	OPJ_BYTE * m_strip_data;
+
+	/* size of m_strip_data */
+	OPJ_SIZE_T m_strip_data_size;
+
+	/* samples of one tile of the row, as given to opj_j2k_write_tile */
+	OPJ_BYTE * m_strip_tile_data;
+
+	/* size of m_strip_tile_data */
+	OPJ_SIZE_T m_strip_tile_data_size;
+
+	/* set by opj_j2k_encoder_next_frame: the end of a frame keeps the tile coder and the buffers for the next one */
+	OPJ_BOOL m_keep_frame;
 
 } opj_j2k_enc_t;
 
@@ -589,6 +670,9 @@ typedef struct opj_j2k
 
 	/** the current tile coder/decoder **/
 	struct opj_tcd *	m_tcd;
+
+	/** profile of the codec, NULL when the profiling is disabled */
+	opj_profile_t * m_profile;
 }
 opj_j2k_t;
 
@@ -607,6 +691,36 @@ Decoding parameters are returned in j2k->cp.
 */
 void opj_j2k_setup_decoder(opj_j2k_t *j2k, opj_dparameters_t *parameters);
 
+/**
+ * Prepares a J2K decompressor to read a new codestream. The allocations that
+ * do not depend on the content of the codestream (tile coder/decoder, code-block
+ * buffers, header buffer) are kept, as are the tile coding parameters, which are
+ * reused if the SIZ marker of the next codestream describes the same tiling.
+ *
+ * @param p_j2k         the jpeg2000 codec.
+ * @param p_manager     the user event manager.
+ *
+ * @return true if the decompressor was reset.
+ */
+OPJ_BOOL opj_j2k_decoder_reset (opj_j2k_t *p_j2k, opj_event_mgr_t * p_manager);
+
+/**
+ * Creates a J2K decompressor from another one whose main header has been read.
+ * The image header, the coding parameters of the main header, the codestream
+ * index and the decoding parameters are copied, so that the clone decodes the
+ * same codestream, from its own stream, without reading the main header again.
+ * The tile coder/decoder and the cache of decoded tiles are not shared.
+ *
+ * @param p_j2k         the jpeg2000 codec to clone.
+ * @param p_image       if not 00, receives a copy of the image header for the clone.
+ * @param p_manager     the user event manager.
+ *
+ * @return the new decompressor, 00 if it could not be created.
+ */
+opj_j2k_t* opj_j2k_clone_decompress (  opj_j2k_t *p_j2k,
+                                        opj_image_t ** p_image,
+                                        opj_event_mgr_t * p_manager);
+
 /**
  * Creates a J2K compression structure
  *
@@ -672,7 +786,7 @@ void j2k_destroy_cstr_index (opj_codestream_index_t *p_cstr_ind);
  * Decode tile data.
  * @param	p_j2k		the jpeg2000 codec.
  * @param	p_tile_index
- * @param p_data       FIXME DOC
+ * @param p_data       buffer receiving the decoded samples, or 00 to leave them in the tile decoder only.
  * @param p_data_size  FIXME DOC
  * @param	p_stream			the stream to write data to.
  * @param	p_manager	the user event manager.
@@ -680,7 +794,7 @@ void j2k_destroy_cstr_index (opj_codestream_index_t *p_cstr_ind);
 OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
                                 OPJ_UINT32 p_tile_index,
                                 OPJ_BYTE * p_data,
-                                OPJ_UINT32 p_data_size,
+                                OPJ_SIZE_T p_data_size,
                                 opj_stream_private_t *p_stream,
                                 opj_event_mgr_t * p_manager );
 
@@ -700,7 +814,7 @@ OPJ_BOOL opj_j2k_decode_tile (  opj_j2k_t * p_j2k,
  */
 OPJ_BOOL opj_j2k_read_tile_header ( opj_j2k_t * p_j2k,
                                     OPJ_UINT32 * p_tile_index,
-                                    OPJ_UINT32 * p_data_size,
+                                    OPJ_SIZE_T * p_data_size,
                                     OPJ_INT32 * p_tile_x0,
                                     OPJ_INT32 * p_tile_y0,
                                     OPJ_INT32 * p_tile_x1,
@@ -786,6 +900,14 @@ opj_codestream_info_v2_t* j2k_get_cstr_info(opj_j2k_t* p_j2k);
  */
 opj_codestream_index_t* j2k_get_cstr_index(opj_j2k_t* p_j2k);
 
+/**
+ * Sets the profile the tile coder accumulates its statistics into.
+ *
+ *@param	p_j2k				the jpeg2000 codec.
+ *@param	p_profile			the profile, NULL to disable the profiling.
+ */
+void opj_j2k_set_profile(opj_j2k_t* p_j2k, opj_profile_t * p_profile);
+
 /**
  * Decode an image from a JPEG-2000 codestream
  * @param j2k J2K decompressor handle
@@ -799,6 +921,96 @@ OPJ_BOOL opj_j2k_decode(opj_j2k_t *j2k,
                         opj_image_t *p_image,
                         opj_event_mgr_t *p_manager);
 
+/**
+ * Decode a single-tile image strip after strip, see opj_decode_strips
+ * @param p_j2k J2K decompressor handle
+ * @param p_stream  the stream to decode.
+ * @param p_image   the image read by opj_j2k_read_header.
+ * @param p_strip_height number of rows of the reference grid of each strip.
+ * @param p_strip_fn function receiving the decoded rows.
+ * @param p_user_data user data given to p_strip_fn.
+ * @param p_manager the user event manager.
+ * @return true if the image could be decoded.
+*/
+OPJ_BOOL opj_j2k_decode_strips( opj_j2k_t *p_j2k,
+                                opj_stream_private_t *p_stream,
+                                opj_image_t *p_image,
+                                OPJ_UINT32 p_strip_height,
+                                opj_decoded_strip_fn p_strip_fn,
+                                void * p_user_data,
+                                opj_event_mgr_t *p_manager);
+
+/**
+ * Decode an image within a time budget, from the coarsest resolution to the requested one,
+ * see opj_decode_within_budget
+ * @param p_j2k J2K decompressor handle
+ * @param p_stream  the stream to decode.
+ * @param p_image   the image read by opj_j2k_read_header.
+ * @param p_max_time the time budget, in seconds.
+ * @param p_report  if not 00, filled with what was decoded.
+ * @param p_manager the user event manager.
+ * @return true if an image could be decoded.
+*/
+OPJ_BOOL opj_j2k_decode_within_budget( opj_j2k_t *p_j2k,
+                                       opj_stream_private_t *p_stream,
+                                       opj_image_t *p_image,
+                                       OPJ_FLOAT64 p_max_time,
+                                       opj_decode_report_t * p_report,
+                                       opj_event_mgr_t *p_manager);
+
+/**
+ * Decode the part of a codestream received so far, see opj_decode_incremental
+ * @param p_j2k J2K decompressor handle
+ * @param p_stream  the stream holding the bytes received so far.
+ * @param p_image   the image read by opj_j2k_read_header, updated with the new data.
+ * @param p_complete set to true once the whole codestream is decoded.
+ * @param p_manager the user event manager.
+ * @return true if the data received so far could be decoded.
+*/
+OPJ_BOOL opj_j2k_decode_incremental( opj_j2k_t *p_j2k,
+                                     opj_stream_private_t *p_stream,
+                                     opj_image_t *p_image,
+                                     OPJ_BOOL *p_complete,
+                                     opj_event_mgr_t *p_manager);
+
+/**
+ * Transcode the codestream without decoding it, see opj_transcode
+ * @param p_j2k J2K decompressor handle
+ * @param p_input   the stream of the codestream, read by opj_j2k_read_header.
+ * @param p_output  the stream receiving the transcoded codestream.
+ * @param p_parameters the transcoding parameters.
+ * @param p_manager the user event manager.
+ * @return true if the codestream could be transcoded.
+*/
+OPJ_BOOL opj_j2k_transcode(     opj_j2k_t *p_j2k,
+                                opj_stream_private_t *p_input,
+                                opj_stream_private_t *p_output,
+                                const opj_transcode_parameters_t *p_parameters,
+                                opj_event_mgr_t *p_manager);
+
+/**
+ * Get the byte ranges of the packets of the codestream, see opj_get_packet_map
+ * @param p_j2k J2K decompressor handle
+ * @param p_stream  the stream of the codestream, read by opj_j2k_read_header.
+ * @param p_packet_map set to the packet map.
+ * @param p_manager the user event manager.
+ * @return true if the packets could be mapped.
+*/
+OPJ_BOOL opj_j2k_get_packet_map(        opj_j2k_t *p_j2k,
+                                        opj_stream_private_t *p_stream,
+                                        opj_packet_map_t **p_packet_map,
+                                        opj_event_mgr_t *p_manager);
+
+/**
+ * Reads the SIZ and COD marker segments of a main header, see opj_probe
+ * @param p_stream  the stream, after the SOC marker of the codestream.
+ * @param p_info the characteristics of the image, the ones given by the codestream are set.
+ * @param p_manager the user event manager.
+ * @return true if the SIZ and COD marker segments are read before the first tile-part.
+*/
+OPJ_BOOL opj_j2k_probe( opj_stream_private_t *p_stream,
+                        opj_probe_info_t *p_info,
+                        opj_event_mgr_t *p_manager);
 
 OPJ_BOOL opj_j2k_get_tile(	opj_j2k_t *p_j2k,
 			    			opj_stream_private_t *p_stream,
@@ -810,6 +1022,47 @@ OPJ_BOOL opj_j2k_set_decoded_resolution_factor(opj_j2k_t *p_j2k,
                                                OPJ_UINT32 res_factor,
                                                opj_event_mgr_t * p_manager);
 
+/**
+ * Sets the function called with the samples of each decoded tile.
+ *
+ * @param	p_j2k			the jpeg2000 codec.
+ * @param	p_tile_fn		function called for each decoded tile, 00 to remove it.
+ * @param	p_user_data		client object passed to p_tile_fn.
+ * @param	p_skip_image	if true, the output image is not built.
+ */
+void opj_j2k_set_decoded_tile_handler(  opj_j2k_t *p_j2k,
+                                        opj_decoded_tile_fn p_tile_fn,
+                                        void * p_user_data,
+                                        OPJ_BOOL p_skip_image);
+
+/**
+ * Sets the budget of the cache of decoded tiles.
+ *
+ * @param	p_j2k			the jpeg2000 codec.
+ * @param	p_max_size		maximum number of bytes kept by the cache, 0 to disable it.
+ * @param	p_manager		the user event manager.
+ *
+ * @return	true if the cache could be set up.
+ */
+OPJ_BOOL opj_j2k_set_tile_cache(opj_j2k_t *p_j2k,
+                                OPJ_SIZE_T p_max_size,
+                                opj_event_mgr_t * p_manager);
+
+/**
+ * Sets the components to decode, once the main header has been read.
+ *
+ * @param	p_j2k			the jpeg2000 codec.
+ * @param	p_numcomps		number of components to decode, 0 to decode all of them.
+ * @param	p_comps_indices	indices of the components to decode.
+ * @param	p_manager		the user event manager.
+ *
+ * @return	true if the components could be selected.
+ */
+OPJ_BOOL opj_j2k_set_decoded_components(opj_j2k_t *p_j2k,
+                                        OPJ_UINT32 p_numcomps,
+                                        const OPJ_UINT32 * p_comps_indices,
+                                        opj_event_mgr_t * p_manager);
+
 
 /**
  * Writes a tile.
@@ -822,8 +1075,24 @@ OPJ_BOOL opj_j2k_set_decoded_resolution_factor(opj_j2k_t *p_j2k,
  */
 OPJ_BOOL opj_j2k_write_tile (	opj_j2k_t * p_j2k,
 							    OPJ_UINT32 p_tile_index,
+							    OPJ_BYTE * p_data,
+							    OPJ_SIZE_T p_data_size,
+							    opj_stream_private_t *p_stream,
+							    opj_event_mgr_t * p_manager );
+
+/**
+ * Writes the next strip of the image, and the rows of tiles it completes.
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_data		the samples of the strip, component after component.
+ * @param	p_data_size	the size of p_data.
+ * @param	p_nb_rows	the number of rows of the reference grid covered by the strip.
+ * @param	p_stream	the stream to write data to.
+ * @param	p_manager	the user event manager.
+ */
+OPJ_BOOL opj_j2k_write_strip (	opj_j2k_t * p_j2k,
 							    OPJ_BYTE * p_data,
 							    OPJ_UINT32 p_data_size,
+							    OPJ_UINT32 p_nb_rows,
 							    opj_stream_private_t *p_stream,
 							    opj_event_mgr_t * p_manager );
 
@@ -849,6 +1118,22 @@ OPJ_BOOL opj_j2k_start_compress(opj_j2k_t *p_j2k,
 							    opj_image_t * p_image,
 							    opj_event_mgr_t * p_manager);
 
+/**
+ * Starts the compression of the next frame of a sequence, i.e. writes the header
+ * with the coding parameters, tile coder and buffers of the previous frame.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	p_stream	the stream object.
+ * @param	p_image		the next frame, with the same geometry as the previous one.
+ * @param	p_manager	the user event manager.
+ *
+ * @return true if the header of the frame was written.
+ */
+OPJ_BOOL opj_j2k_encoder_next_frame(opj_j2k_t *p_j2k,
+							    opj_stream_private_t *p_stream,
+							    opj_image_t * p_image,
+							    opj_event_mgr_t * p_manager);
+
 /**
  * Ends the compression procedures and possibiliy add data to be read after the
  * codestream.
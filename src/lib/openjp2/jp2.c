@@ -108,6 +108,28 @@ static OPJ_BOOL opj_jp2_read_cdef(	opj_jp2_t * jp2,
 
 static void opj_jp2_apply_cdef(opj_image_t *image, opj_jp2_color_t *color, opj_event_mgr_t *);
 
+/**
+ * Applies the colour boxes of the JP2 file to an image decoded from its codestream.
+ *
+ * @param jp2		the jpeg2000 file codec.
+ * @param p_image	the decoded image.
+ * @param p_manager	the user event manager.
+ *
+ * @return true if the colour boxes are consistent with the image.
+ */
+static OPJ_BOOL opj_jp2_apply_color_boxes(opj_jp2_t *jp2, opj_image_t *p_image, opj_event_mgr_t * p_manager);
+
+/**
+ * Decodes the samples as OPJ_INT32 for the current decoding if a palette is applied on them,
+ * whatever the native samples parameter of the decoder.
+ *
+ * @param jp2		the jpeg2000 file codec.
+ * @param p_use_pclr	true if the palette is applied on the decoded samples.
+ *
+ * @return the native samples parameter, to restore once the samples are decoded.
+ */
+static OPJ_UINT32 opj_jp2_override_native_samples(opj_jp2_t *jp2, OPJ_BOOL p_use_pclr);
+
 /**
  * Writes the Channel Definition box.
  *
@@ -272,6 +294,16 @@ static void opj_jp2_apply_pclr(opj_image_t *image, opj_jp2_color_t *color);
 
 static void opj_jp2_free_pclr(opj_jp2_color_t *color);
 
+/**
+ * Copies the colour information read from the boxes of a JP2 file.
+ *
+ * @param p_dest   the colour information to fill, without any allocation.
+ * @param p_src    the colour information to copy.
+ *
+ * @return true if the colour information could be copied.
+ */
+static OPJ_BOOL opj_jp2_copy_color(opj_jp2_color_t *p_dest, const opj_jp2_color_t *p_src);
+
 /**
  * Collect palette data
  *
@@ -954,7 +986,7 @@ static void opj_jp2_apply_pclr(opj_image_t *image, opj_jp2_color_t *color)
 	OPJ_UINT32 *entries;
 	opj_jp2_cmap_comp_t *cmap;
 	OPJ_INT32 *src, *dst;
-	OPJ_UINT32 j, max;
+	OPJ_SIZE_T j, max;
 	OPJ_UINT16 i, nr_channels, cmp, pcol;
 	OPJ_INT32 k, top_k;
 
@@ -986,7 +1018,7 @@ static void opj_jp2_apply_pclr(opj_image_t *image, opj_jp2_color_t *color)
 
 		/* Palette mapping: */
 		new_comps[i].data = (OPJ_INT32*)
-				opj_malloc(old_comps[cmp].w * old_comps[cmp].h * sizeof(OPJ_INT32));
+				opj_image_data_alloc((OPJ_SIZE_T)old_comps[cmp].w * old_comps[cmp].h * sizeof(OPJ_INT32));
 		if (!new_comps[i].data) {
 			opj_free(new_comps);
 			new_comps = NULL;
@@ -1005,7 +1037,7 @@ static void opj_jp2_apply_pclr(opj_image_t *image, opj_jp2_color_t *color)
 		cmp = cmap[i].cmp; pcol = cmap[i].pcol;
 		src = old_comps[cmp].data;
     assert( src );
-		max = new_comps[pcol].w * new_comps[pcol].h;
+		max = (OPJ_SIZE_T)new_comps[pcol].w * new_comps[pcol].h;
 
 		/* Direct use: */
     if(cmap[i].mtyp == 0) {
@@ -1032,7 +1064,7 @@ static void opj_jp2_apply_pclr(opj_image_t *image, opj_jp2_color_t *color)
 
 	max = image->numcomps;
 	for(i = 0; i < max; ++i) {
-		if(old_comps[i].data) opj_free(old_comps[i].data);
+		if(old_comps[i].data) opj_image_data_free(old_comps[i].data);
 	}
 
 	opj_free(old_comps);
@@ -1398,7 +1430,7 @@ static OPJ_BOOL opj_jp2_read_colr( opj_jp2_t *jp2,
 		OPJ_INT32 icc_len = (OPJ_INT32)p_colr_header_size - 3;
 
 		jp2->color.icc_profile_len = (OPJ_UINT32)icc_len;
-		jp2->color.icc_profile_buf = (OPJ_BYTE*) opj_calloc(1,(size_t)icc_len);
+		jp2->color.icc_profile_buf = (OPJ_BYTE*) opj_image_data_calloc(1,(size_t)icc_len);
         if (!jp2->color.icc_profile_buf)
         {
             jp2->color.icc_profile_len = 0;
@@ -1429,15 +1461,42 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
                         opj_image_t* p_image,
                         opj_event_mgr_t * p_manager)
 {
+	OPJ_UINT32 l_native_samples;
+	OPJ_BOOL l_result;
+
 	if (!p_image)
 		return OPJ_FALSE;
 
 	/* J2K decoding */
-	if( ! opj_j2k_decode(jp2->j2k, p_stream, p_image, p_manager) ) {
+	l_native_samples = opj_jp2_override_native_samples(jp2, jp2->color.jp2_pclr && !jp2->ignore_pclr_cmap_cdef);
+	l_result = opj_j2k_decode(jp2->j2k, p_stream, p_image, p_manager);
+	jp2->j2k->m_cp.m_specific_param.m_dec.m_native_samples = l_native_samples;
+	if( ! l_result ) {
 		opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the codestream in the JP2 file\n");
 		return OPJ_FALSE;
 	}
 
+	return opj_jp2_apply_color_boxes(jp2, p_image, p_manager);
+}
+
+static OPJ_UINT32 opj_jp2_override_native_samples(opj_jp2_t *jp2, OPJ_BOOL p_use_pclr)
+{
+	OPJ_UINT32 l_native_samples = jp2->j2k->m_cp.m_specific_param.m_dec.m_native_samples;
+
+	if (p_use_pclr) {
+		/* the palette is applied on OPJ_INT32 samples */
+		jp2->j2k->m_cp.m_specific_param.m_dec.m_native_samples = 0;
+	}
+	return l_native_samples;
+}
+
+static OPJ_BOOL opj_jp2_apply_color_boxes(opj_jp2_t *jp2, opj_image_t *p_image, opj_event_mgr_t * p_manager)
+{
+	/* the colour boxes describe all the components, not a selection of them */
+	if (jp2->j2k->m_specific_param.m_decoder.m_used_comps) {
+		return OPJ_TRUE;
+	}
+
     if (!jp2->ignore_pclr_cmap_cdef){
 	    if (!opj_jp2_check_color(p_image, &(jp2->color), p_manager)) {
 		    return OPJ_FALSE;
@@ -1455,17 +1514,20 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
 	    else
 		    p_image->color_space = OPJ_CLRSPC_UNKNOWN;
 
-	    if(jp2->color.jp2_pclr) {
-		    /* Part 1, I.5.3.4: Either both or none : */
-		    if( !jp2->color.jp2_pclr->cmap)
-			    opj_jp2_free_pclr(&(jp2->color));
-		    else
-			    opj_jp2_apply_pclr(p_image, &(jp2->color));
-	    }
-
-	    /* Apply the color space if needed */
-	    if(jp2->color.jp2_cdef) {
-		    opj_jp2_apply_cdef(p_image, &(jp2->color), p_manager);
+	    /* the palette and the channel definitions need the samples of the image */
+	    if (! jp2->j2k->m_cp.m_specific_param.m_dec.m_skip_image) {
+		    if(jp2->color.jp2_pclr) {
+			    /* Part 1, I.5.3.4: Either both or none : */
+			    if( !jp2->color.jp2_pclr->cmap)
+				    opj_jp2_free_pclr(&(jp2->color));
+			    else
+				    opj_jp2_apply_pclr(p_image, &(jp2->color));
+		    }
+
+		    /* Apply the color space if needed */
+		    if(jp2->color.jp2_cdef) {
+			    opj_jp2_apply_cdef(p_image, &(jp2->color), p_manager);
+		    }
 	    }
 
 	    if(jp2->color.icc_profile_buf) {
@@ -1478,6 +1540,194 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
 	return OPJ_TRUE;
 }
 
+OPJ_BOOL opj_jp2_decode_within_budget(  opj_jp2_t *jp2,
+                                        opj_stream_private_t *p_stream,
+                                        opj_image_t* p_image,
+                                        OPJ_FLOAT64 p_max_time,
+                                        opj_decode_report_t * p_report,
+                                        opj_event_mgr_t * p_manager)
+{
+	OPJ_UINT32 l_native_samples;
+	OPJ_BOOL l_result;
+
+	if (!p_image)
+		return OPJ_FALSE;
+
+	/* J2K decoding */
+	l_native_samples = opj_jp2_override_native_samples(jp2, jp2->color.jp2_pclr && !jp2->ignore_pclr_cmap_cdef);
+	l_result = opj_j2k_decode_within_budget(jp2->j2k, p_stream, p_image, p_max_time, p_report, p_manager);
+	jp2->j2k->m_cp.m_specific_param.m_dec.m_native_samples = l_native_samples;
+	if( ! l_result ) {
+		opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the codestream in the JP2 file\n");
+		return OPJ_FALSE;
+	}
+
+	return opj_jp2_apply_color_boxes(jp2, p_image, p_manager);
+}
+
+OPJ_BOOL opj_jp2_decode_incremental(    opj_jp2_t *jp2,
+                                        opj_stream_private_t *p_stream,
+                                        opj_image_t* p_image,
+                                        OPJ_BOOL * p_complete,
+                                        opj_event_mgr_t * p_manager)
+{
+	OPJ_BOOL l_was_complete;
+	OPJ_UINT32 l_native_samples;
+	OPJ_BOOL l_result;
+
+	if (!p_image || !p_complete)
+		return OPJ_FALSE;
+
+	l_was_complete = jp2->j2k->m_specific_param.m_decoder.m_incr_complete;
+
+	/* J2K decoding */
+	l_native_samples = opj_jp2_override_native_samples(jp2, jp2->color.jp2_pclr && !jp2->ignore_pclr_cmap_cdef);
+	l_result = opj_j2k_decode_incremental(jp2->j2k, p_stream, p_image, p_complete, p_manager);
+	jp2->j2k->m_cp.m_specific_param.m_dec.m_native_samples = l_native_samples;
+	if( ! l_result ) {
+		opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the codestream in the JP2 file\n");
+		return OPJ_FALSE;
+	}
+
+	/* the colour boxes apply to the whole image, once decoded */
+	if (! *p_complete || l_was_complete) {
+		return OPJ_TRUE;
+	}
+	return opj_jp2_apply_color_boxes(jp2, p_image, p_manager);
+}
+
+OPJ_BOOL opj_jp2_transcode(     opj_jp2_t *jp2,
+                                opj_stream_private_t *p_input,
+                                opj_stream_private_t *p_output,
+                                const opj_transcode_parameters_t *p_parameters,
+                                opj_event_mgr_t * p_manager)
+{
+	/* the boxes are not written: the output is the transcoded codestream */
+	return opj_j2k_transcode(jp2->j2k, p_input, p_output, p_parameters, p_manager);
+}
+
+OPJ_BOOL opj_jp2_get_packet_map(        opj_jp2_t *jp2,
+                                        opj_stream_private_t *p_stream,
+                                        opj_packet_map_t **p_packet_map,
+                                        opj_event_mgr_t * p_manager)
+{
+	/* the positions are the ones in the stream of the whole file */
+	return opj_j2k_get_packet_map(jp2->j2k, p_stream, p_packet_map, p_manager);
+}
+
+OPJ_BOOL opj_jp2_probe( opj_stream_private_t *p_stream,
+                        opj_probe_info_t *p_info,
+                        opj_event_mgr_t * p_manager)
+{
+	static const OPJ_BYTE l_signature [10] = {0x00, 0x0c, 0x6a, 0x50, 0x20, 0x20, 0x0d, 0x0a, 0x87, 0x0a};
+	OPJ_BYTE l_data [10];
+	opj_jp2_box_t box;
+	OPJ_UINT32 l_nb_bytes_read;
+	OPJ_UINT32 l_remaining = 0;	/* bytes of the jp2h box not read yet */
+	OPJ_BOOL l_colr_read = OPJ_FALSE;
+
+	/* preconditions */
+	assert(p_stream != 00);
+	assert(p_info != 00);
+	assert(p_manager != 00);
+
+	/* the signature box, of which the first two bytes are already read */
+	if (opj_stream_read_data(p_stream,l_data,10,p_manager) != 10 ||
+	    memcmp(l_data,l_signature,10) != 0) {
+		opj_event_msg(p_manager, EVT_ERROR, "Neither a JPEG 2000 codestream nor a JP2 file\n");
+		return OPJ_FALSE;
+	}
+	p_info->format = OPJ_CODEC_JP2;
+
+	while (opj_jp2_read_boxhdr(&box,&l_nb_bytes_read,p_stream,p_manager)) {
+		OPJ_UINT32 l_data_size;
+
+		if (box.type == JP2_JP2C && l_remaining == 0) {
+			if (opj_stream_read_data(p_stream,l_data,2,p_manager) != 2) {
+				opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+				return OPJ_FALSE;
+			}
+			opj_read_bytes(l_data,&l_data_size,2);
+			if (l_data_size != J2K_MS_SOC) {
+				opj_event_msg(p_manager, EVT_ERROR, "Expected a SOC marker at the start of the codestream\n");
+				return OPJ_FALSE;
+			}
+			return opj_j2k_probe(p_stream, p_info, p_manager);
+		}
+		if (box.length < l_nb_bytes_read || (l_remaining && box.length > l_remaining)) {
+			opj_event_msg(p_manager, EVT_ERROR, "invalid box size %d (%x)\n", box.length, box.type);
+			return OPJ_FALSE;
+		}
+		if (l_remaining) {
+			l_remaining -= box.length;
+		}
+		l_data_size = box.length - l_nb_bytes_read;
+
+		if (box.type == JP2_JP2H && l_remaining == 0) {
+			/* the sub-boxes are read one by one */
+			l_remaining = l_data_size;
+			continue;
+		}
+		if (box.type == JP2_COLR && ! l_colr_read && l_data_size >= 3) {
+			OPJ_UINT32 l_meth, l_enumcs;
+			OPJ_UINT32 l_size = opj_uint_min(l_data_size, 7);
+
+			if (opj_stream_read_data(p_stream,l_data,l_size,p_manager) != l_size) {
+				opj_event_msg(p_manager, EVT_ERROR, "Stream too short\n");
+				return OPJ_FALSE;
+			}
+			l_data_size -= l_size;
+			opj_read_bytes(l_data,&l_meth,1);
+			if (l_meth == 1 && l_size == 7) {
+				opj_read_bytes(l_data+3,&l_enumcs,4);
+				if (l_enumcs == 16)
+					p_info->color_space = OPJ_CLRSPC_SRGB;
+				else if (l_enumcs == 17)
+					p_info->color_space = OPJ_CLRSPC_GRAY;
+				else if (l_enumcs == 18)
+					p_info->color_space = OPJ_CLRSPC_SYCC;
+				else if (l_enumcs == 24)
+					p_info->color_space = OPJ_CLRSPC_EYCC;
+				else
+					p_info->color_space = OPJ_CLRSPC_UNKNOWN;
+			}
+			else {
+				p_info->color_space = OPJ_CLRSPC_UNKNOWN;
+				/* the ICC profile follows the first three bytes */
+				p_info->has_icc_profile = (l_meth == 2 && l_size + l_data_size > 3);
+			}
+			l_colr_read = OPJ_TRUE;
+		}
+		if (opj_stream_skip(p_stream,(OPJ_OFF_T)l_data_size,p_manager) != (OPJ_OFF_T)l_data_size) {
+			opj_event_msg(p_manager, EVT_ERROR, "Problem with skipping JPEG2000 box, stream error\n");
+			return OPJ_FALSE;
+		}
+	}
+
+	opj_event_msg(p_manager, EVT_ERROR, "JP2 file without codestream box\n");
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL opj_jp2_decode_strips( opj_jp2_t *jp2,
+                                opj_stream_private_t *p_stream,
+                                opj_image_t* p_image,
+                                OPJ_UINT32 p_strip_height,
+                                opj_decoded_strip_fn p_strip_fn,
+                                void * p_user_data,
+                                opj_event_mgr_t * p_manager)
+{
+	if (!p_image)
+		return OPJ_FALSE;
+
+	/* J2K decoding */
+	if( ! opj_j2k_decode_strips(jp2->j2k, p_stream, p_image, p_strip_height, p_strip_fn, p_user_data, p_manager) ) {
+		opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the codestream in the JP2 file\n");
+		return OPJ_FALSE;
+	}
+
+	return OPJ_TRUE;
+}
+
 static OPJ_BOOL opj_jp2_write_jp2h(opj_jp2_t *jp2,
                             opj_stream_private_t *stream,
                             opj_event_mgr_t * p_manager
@@ -2233,6 +2483,30 @@ OPJ_BOOL opj_jp2_start_compress(opj_jp2_t *jp2,
 	return opj_j2k_start_compress(jp2->j2k,stream,p_image,p_manager);
 }
 
+OPJ_BOOL opj_jp2_encoder_next_frame(opj_jp2_t *jp2,
+                                    opj_stream_private_t *stream,
+                                    opj_image_t * p_image,
+                                    opj_event_mgr_t * p_manager
+                                    )
+{
+	/* preconditions */
+	assert(jp2 != 00);
+	assert(stream != 00);
+	assert(p_manager != 00);
+
+	/* the boxes describe the same image: the validation of the first frame holds */
+	if (! opj_jp2_setup_header_writing(jp2, p_manager)) {
+		return OPJ_FALSE;
+	}
+
+	/* write header */
+	if (! opj_jp2_exec (jp2,jp2->m_procedure_list,stream,p_manager)) {
+		return OPJ_FALSE;
+	}
+
+	return opj_j2k_encoder_next_frame(jp2->j2k,stream,p_image,p_manager);
+}
+
 static const opj_jp2_header_handler_t * opj_jp2_find_handler (OPJ_UINT32 p_id)
 {
 	OPJ_UINT32 i, l_handler_size = sizeof(jp2_header) / sizeof(opj_jp2_header_handler_t);
@@ -2673,7 +2947,7 @@ static OPJ_BOOL opj_jp2_setup_header_reading (opj_jp2_t *jp2, opj_event_mgr_t *
 
 OPJ_BOOL opj_jp2_read_tile_header ( opj_jp2_t * p_jp2,
                                     OPJ_UINT32 * p_tile_index,
-                                    OPJ_UINT32 * p_data_size,
+                                    OPJ_SIZE_T * p_data_size,
                                     OPJ_INT32 * p_tile_x0,
                                     OPJ_INT32 * p_tile_y0,
                                     OPJ_INT32 * p_tile_x1,
@@ -2698,7 +2972,7 @@ OPJ_BOOL opj_jp2_read_tile_header ( opj_jp2_t * p_jp2,
 OPJ_BOOL opj_jp2_write_tile (	opj_jp2_t *p_jp2,
 					 	 	    OPJ_UINT32 p_tile_index,
 					 	 	    OPJ_BYTE * p_data,
-					 	 	    OPJ_UINT32 p_data_size,
+					 	 	    OPJ_SIZE_T p_data_size,
 					 	 	    opj_stream_private_t *p_stream,
 					 	 	    opj_event_mgr_t * p_manager
                                 )
@@ -2707,10 +2981,22 @@ OPJ_BOOL opj_jp2_write_tile (	opj_jp2_t *p_jp2,
 	return opj_j2k_write_tile (p_jp2->j2k,p_tile_index,p_data,p_data_size,p_stream,p_manager);
 }
 
+OPJ_BOOL opj_jp2_write_strip (	opj_jp2_t *p_jp2,
+					 	 	    OPJ_BYTE * p_data,
+					 	 	    OPJ_UINT32 p_data_size,
+					 	 	    OPJ_UINT32 p_nb_rows,
+					 	 	    opj_stream_private_t *p_stream,
+					 	 	    opj_event_mgr_t * p_manager
+                                )
+
+{
+	return opj_j2k_write_strip (p_jp2->j2k,p_data,p_data_size,p_nb_rows,p_stream,p_manager);
+}
+
 OPJ_BOOL opj_jp2_decode_tile (  opj_jp2_t * p_jp2,
                                 OPJ_UINT32 p_tile_index,
                                 OPJ_BYTE * p_data,
-                                OPJ_UINT32 p_data_size,
+                                OPJ_SIZE_T p_data_size,
                                 opj_stream_private_t *p_stream,
                                 opj_event_mgr_t * p_manager
                                 )
@@ -2736,7 +3022,7 @@ void opj_jp2_destroy(opj_jp2_t *jp2)
 		}
 
 		if (jp2->color.icc_profile_buf) {
-			opj_free(jp2->color.icc_profile_buf);
+			opj_image_data_free(jp2->color.icc_profile_buf);
 			jp2->color.icc_profile_buf = 00;
 		}
 
@@ -2786,6 +3072,208 @@ void opj_jp2_destroy(opj_jp2_t *jp2)
 	}
 }
 
+OPJ_BOOL opj_jp2_decoder_reset(opj_jp2_t *p_jp2, opj_event_mgr_t * p_manager)
+{
+	/* preconditions */
+	assert(p_jp2 != 00);
+	assert(p_manager != 00);
+
+	/* forget what was read from the boxes of the previous file; the codec,
+	   its procedure lists and the decoding parameters are kept */
+	p_jp2->w = 0;
+	p_jp2->h = 0;
+	p_jp2->numcomps = 0;
+	p_jp2->bpc = 0;
+	p_jp2->C = 0;
+	p_jp2->UnkC = 0;
+	p_jp2->IPR = 0;
+	p_jp2->meth = 0;
+	p_jp2->approx = 0;
+	p_jp2->enumcs = 0;
+	p_jp2->precedence = 0;
+	p_jp2->brand = 0;
+	p_jp2->minversion = 0;
+
+	opj_free(p_jp2->cl);
+	p_jp2->cl = 00;
+	p_jp2->numcl = 0;
+
+	opj_free(p_jp2->comps);
+	p_jp2->comps = 00;
+
+	p_jp2->j2k_codestream_offset = 0;
+	p_jp2->jpip_iptr_offset = 0;
+	p_jp2->jpip_on = OPJ_FALSE;
+	p_jp2->jp2_state = JP2_STATE_NONE;
+	p_jp2->jp2_img_state = JP2_IMG_STATE_NONE;
+
+	/* colour */
+	if (p_jp2->color.icc_profile_buf) {
+		opj_image_data_free(p_jp2->color.icc_profile_buf);
+		p_jp2->color.icc_profile_buf = 00;
+	}
+	p_jp2->color.icc_profile_len = 0;
+
+	if (p_jp2->color.jp2_cdef) {
+		opj_free(p_jp2->color.jp2_cdef->info);
+		opj_free(p_jp2->color.jp2_cdef);
+		p_jp2->color.jp2_cdef = 00;
+	}
+
+	if (p_jp2->color.jp2_pclr) {
+		opj_jp2_free_pclr(&(p_jp2->color));
+	}
+	p_jp2->color.jp2_has_colr = 0;
+
+	opj_procedure_list_clear(p_jp2->m_procedure_list);
+	opj_procedure_list_clear(p_jp2->m_validation_list);
+
+	return opj_j2k_decoder_reset(p_jp2->j2k, p_manager);
+}
+
+static OPJ_BOOL opj_jp2_copy_color(opj_jp2_color_t *p_dest, const opj_jp2_color_t *p_src)
+{
+	p_dest->jp2_has_colr = p_src->jp2_has_colr;
+
+	if (p_src->icc_profile_buf) {
+		p_dest->icc_profile_buf = (OPJ_BYTE*) opj_image_data_alloc(p_src->icc_profile_len);
+		if (! p_dest->icc_profile_buf) {
+			return OPJ_FALSE;
+		}
+		memcpy(p_dest->icc_profile_buf, p_src->icc_profile_buf, p_src->icc_profile_len);
+		p_dest->icc_profile_len = p_src->icc_profile_len;
+	}
+
+	if (p_src->jp2_cdef) {
+		p_dest->jp2_cdef = (opj_jp2_cdef_t*) opj_calloc(1, sizeof(opj_jp2_cdef_t));
+		if (! p_dest->jp2_cdef) {
+			return OPJ_FALSE;
+		}
+		if (p_src->jp2_cdef->info) {
+			p_dest->jp2_cdef->info = (opj_jp2_cdef_info_t*) opj_malloc(p_src->jp2_cdef->n * sizeof(opj_jp2_cdef_info_t));
+			if (! p_dest->jp2_cdef->info) {
+				return OPJ_FALSE;
+			}
+			memcpy(p_dest->jp2_cdef->info, p_src->jp2_cdef->info, p_src->jp2_cdef->n * sizeof(opj_jp2_cdef_info_t));
+		}
+		p_dest->jp2_cdef->n = p_src->jp2_cdef->n;
+	}
+
+	if (p_src->jp2_pclr) {
+		const opj_jp2_pclr_t * l_src = p_src->jp2_pclr;
+		opj_jp2_pclr_t * l_dest;
+
+		l_dest = p_dest->jp2_pclr = (opj_jp2_pclr_t*) opj_calloc(1, sizeof(opj_jp2_pclr_t));
+		if (! l_dest) {
+			return OPJ_FALSE;
+		}
+		l_dest->nr_entries = l_src->nr_entries;
+		l_dest->nr_channels = l_src->nr_channels;
+
+		l_dest->entries = (OPJ_UINT32*) opj_malloc((size_t)l_src->nr_channels * l_src->nr_entries * sizeof(OPJ_UINT32));
+		l_dest->channel_size = (OPJ_BYTE*) opj_malloc(l_src->nr_channels);
+		l_dest->channel_sign = (OPJ_BYTE*) opj_malloc(l_src->nr_channels);
+		if (! l_dest->entries || ! l_dest->channel_size || ! l_dest->channel_sign) {
+			return OPJ_FALSE;
+		}
+		memcpy(l_dest->entries, l_src->entries, (size_t)l_src->nr_channels * l_src->nr_entries * sizeof(OPJ_UINT32));
+		memcpy(l_dest->channel_size, l_src->channel_size, l_src->nr_channels);
+		memcpy(l_dest->channel_sign, l_src->channel_sign, l_src->nr_channels);
+
+		if (l_src->cmap) {
+			l_dest->cmap = (opj_jp2_cmap_comp_t*) opj_malloc(l_src->nr_channels * sizeof(opj_jp2_cmap_comp_t));
+			if (! l_dest->cmap) {
+				return OPJ_FALSE;
+			}
+			memcpy(l_dest->cmap, l_src->cmap, l_src->nr_channels * sizeof(opj_jp2_cmap_comp_t));
+		}
+	}
+
+	return OPJ_TRUE;
+}
+
+opj_jp2_t* opj_jp2_clone_decompress(	opj_jp2_t *p_jp2,
+										opj_image_t ** p_image,
+										opj_event_mgr_t * p_manager)
+{
+	opj_jp2_t * l_jp2;
+
+	/* preconditions */
+	assert(p_jp2 != 00);
+	assert(p_manager != 00);
+
+	l_jp2 = (opj_jp2_t*) opj_calloc(1, sizeof(opj_jp2_t));
+	if (! l_jp2) {
+		opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+		return 00;
+	}
+
+	/* the values read from the boxes, then what they own */
+	memcpy(l_jp2, p_jp2, sizeof(opj_jp2_t));
+	l_jp2->j2k = 00;
+	l_jp2->m_validation_list = 00;
+	l_jp2->m_procedure_list = 00;
+	l_jp2->cl = 00;
+	l_jp2->comps = 00;
+	memset(&(l_jp2->color), 0, sizeof(opj_jp2_color_t));
+
+	l_jp2->j2k = opj_j2k_clone_decompress(p_jp2->j2k, 00, p_manager);
+	if (! l_jp2->j2k) {
+		opj_jp2_destroy(l_jp2);
+		return 00;
+	}
+
+	l_jp2->m_validation_list = opj_procedure_list_create();
+	l_jp2->m_procedure_list = opj_procedure_list_create();
+	if (! l_jp2->m_validation_list || ! l_jp2->m_procedure_list) {
+		opj_jp2_destroy(l_jp2);
+		opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+		return 00;
+	}
+
+	if (p_jp2->cl) {
+		l_jp2->cl = (OPJ_UINT32*) opj_malloc(p_jp2->numcl * sizeof(OPJ_UINT32));
+		if (! l_jp2->cl) {
+			opj_jp2_destroy(l_jp2);
+			opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+			return 00;
+		}
+		memcpy(l_jp2->cl, p_jp2->cl, p_jp2->numcl * sizeof(OPJ_UINT32));
+	}
+
+	if (p_jp2->comps) {
+		l_jp2->comps = (opj_jp2_comps_t*) opj_malloc(p_jp2->numcomps * sizeof(opj_jp2_comps_t));
+		if (! l_jp2->comps) {
+			opj_jp2_destroy(l_jp2);
+			opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+			return 00;
+		}
+		memcpy(l_jp2->comps, p_jp2->comps, p_jp2->numcomps * sizeof(opj_jp2_comps_t));
+	}
+
+	if (! opj_jp2_copy_color(&(l_jp2->color), &(p_jp2->color))) {
+		opj_jp2_destroy(l_jp2);
+		opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+		return 00;
+	}
+
+	if (p_image) {
+		*p_image = opj_image_create0();
+		if (*p_image) {
+			opj_copy_image_header(l_jp2->j2k->m_private_image, *p_image);
+		}
+		if (! (*p_image) || ! (*p_image)->comps) {
+			opj_image_destroy(*p_image);
+			*p_image = 00;
+			opj_jp2_destroy(l_jp2);
+			opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to clone the decompressor\n");
+			return 00;
+		}
+	}
+
+	return l_jp2;
+}
+
 OPJ_BOOL opj_jp2_set_decode_area(	opj_jp2_t *p_jp2,
 								    opj_image_t* p_image,
 								    OPJ_INT32 p_start_x, OPJ_INT32 p_start_y,
@@ -2803,16 +3291,27 @@ OPJ_BOOL opj_jp2_get_tile(	opj_jp2_t *p_jp2,
                             OPJ_UINT32 tile_index
                             )
 {
+	OPJ_UINT32 l_native_samples;
+	OPJ_BOOL l_result;
+
 	if (!p_image)
 		return OPJ_FALSE;
 
 	opj_event_msg(p_manager, EVT_WARNING, "JP2 box which are after the codestream will not be read by this function.\n");
 
-	if (! opj_j2k_get_tile(p_jp2->j2k, p_stream, p_image, p_manager, tile_index) ){
+	l_native_samples = opj_jp2_override_native_samples(p_jp2, p_jp2->color.jp2_pclr != 00);
+	l_result = opj_j2k_get_tile(p_jp2->j2k, p_stream, p_image, p_manager, tile_index);
+	p_jp2->j2k->m_cp.m_specific_param.m_dec.m_native_samples = l_native_samples;
+	if (! l_result ){
 		opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the codestream in the JP2 file\n");
 		return OPJ_FALSE;
 	}
 
+	/* the colour boxes describe all the components, not a selection of them */
+	if (p_jp2->j2k->m_specific_param.m_decoder.m_used_comps) {
+		return OPJ_TRUE;
+	}
+
 	if (!opj_jp2_check_color(p_image, &(p_jp2->color), p_manager)) {
 		return OPJ_FALSE;
 	}
@@ -2911,6 +3410,11 @@ opj_codestream_index_t* jp2_get_cstr_index(opj_jp2_t* p_jp2)
 	return j2k_get_cstr_index(p_jp2->j2k);
 }
 
+void opj_jp2_set_profile(opj_jp2_t* p_jp2, opj_profile_t * p_profile)
+{
+	opj_j2k_set_profile(p_jp2->j2k, p_profile);
+}
+
 opj_codestream_info_v2_t* jp2_get_cstr_info(opj_jp2_t* p_jp2)
 {
 	return j2k_get_cstr_info(p_jp2->j2k);
@@ -2923,6 +3427,29 @@ OPJ_BOOL opj_jp2_set_decoded_resolution_factor(opj_jp2_t *p_jp2,
 	return opj_j2k_set_decoded_resolution_factor(p_jp2->j2k, res_factor, p_manager);
 }
 
+void opj_jp2_set_decoded_tile_handler(  opj_jp2_t *p_jp2,
+                                        opj_decoded_tile_fn p_tile_fn,
+                                        void * p_user_data,
+                                        OPJ_BOOL p_skip_image)
+{
+	opj_j2k_set_decoded_tile_handler(p_jp2->j2k, p_tile_fn, p_user_data, p_skip_image);
+}
+
+OPJ_BOOL opj_jp2_set_tile_cache(opj_jp2_t *p_jp2,
+                                OPJ_SIZE_T p_max_size,
+                                opj_event_mgr_t * p_manager)
+{
+	return opj_j2k_set_tile_cache(p_jp2->j2k, p_max_size, p_manager);
+}
+
+OPJ_BOOL opj_jp2_set_decoded_components(opj_jp2_t *p_jp2,
+                                        OPJ_UINT32 p_numcomps,
+                                        const OPJ_UINT32 * p_comps_indices,
+                                        opj_event_mgr_t * p_manager)
+{
+	return opj_j2k_set_decoded_components(p_jp2->j2k, p_numcomps, p_comps_indices, p_manager);
+}
+
 /* JPIP specific */
 
 #ifdef USE_JPIP
@@ -257,6 +257,97 @@ OPJ_BOOL opj_jp2_decode(opj_jp2_t *jp2,
             opj_image_t* p_image,
             opj_event_mgr_t * p_manager);
 
+/**
+ * Decode a single-tile image of a JP2 file strip after strip, see opj_decode_strips.
+ * The colour boxes of the file are not applied.
+ * @param jp2 JP2 decompressor handle
+ * @param p_stream  the stream to decode.
+ * @param p_image   the image read by opj_jp2_read_header.
+ * @param p_strip_height number of rows of the reference grid of each strip.
+ * @param p_strip_fn function receiving the decoded rows.
+ * @param p_user_data user data given to p_strip_fn.
+ * @param p_manager the user event manager.
+ * @return true if the image could be decoded.
+ */
+OPJ_BOOL opj_jp2_decode_strips( opj_jp2_t *jp2,
+                                opj_stream_private_t *p_stream,
+                                opj_image_t* p_image,
+                                OPJ_UINT32 p_strip_height,
+                                opj_decoded_strip_fn p_strip_fn,
+                                void * p_user_data,
+                                opj_event_mgr_t * p_manager);
+
+/**
+ * Decode a JP2 file within a time budget, see opj_decode_within_budget.
+ * @param jp2 JP2 decompressor handle
+ * @param p_stream  the stream to decode.
+ * @param p_image   the image read by opj_jp2_read_header.
+ * @param p_max_time the time budget, in seconds.
+ * @param p_report  if not 00, filled with what was decoded.
+ * @param p_manager the user event manager.
+ * @return true if an image could be decoded.
+ */
+OPJ_BOOL opj_jp2_decode_within_budget(  opj_jp2_t *jp2,
+                                        opj_stream_private_t *p_stream,
+                                        opj_image_t* p_image,
+                                        OPJ_FLOAT64 p_max_time,
+                                        opj_decode_report_t * p_report,
+                                        opj_event_mgr_t * p_manager);
+
+/**
+ * Decode the part of a JP2 file received so far, see opj_decode_incremental.
+ * @param jp2 JP2 decompressor handle
+ * @param p_stream  the stream holding the bytes received so far.
+ * @param p_image   the image read by opj_jp2_read_header, updated with the new data.
+ * @param p_complete set to true once the whole codestream is decoded.
+ * @param p_manager the user event manager.
+ * @return true if the data received so far could be decoded.
+ */
+OPJ_BOOL opj_jp2_decode_incremental(    opj_jp2_t *jp2,
+                                        opj_stream_private_t *p_stream,
+                                        opj_image_t* p_image,
+                                        OPJ_BOOL * p_complete,
+                                        opj_event_mgr_t * p_manager);
+
+/**
+ * Transcode the codestream of a JP2 file, see opj_transcode.
+ * @param jp2 JP2 decompressor handle
+ * @param p_input   the stream of the JP2 file.
+ * @param p_output  the stream receiving the transcoded codestream.
+ * @param p_parameters the transcoding parameters.
+ * @param p_manager the user event manager.
+ * @return true if the codestream could be transcoded.
+ */
+OPJ_BOOL opj_jp2_transcode(     opj_jp2_t *jp2,
+                                opj_stream_private_t *p_input,
+                                opj_stream_private_t *p_output,
+                                const opj_transcode_parameters_t *p_parameters,
+                                opj_event_mgr_t * p_manager);
+
+/**
+ * Get the byte ranges of the packets of the codestream of a JP2 file, see opj_get_packet_map.
+ * @param jp2 JP2 decompressor handle
+ * @param p_stream  the stream of the JP2 file.
+ * @param p_packet_map set to the packet map, with positions in the JP2 file.
+ * @param p_manager the user event manager.
+ * @return true if the packets could be mapped.
+ */
+OPJ_BOOL opj_jp2_get_packet_map(        opj_jp2_t *jp2,
+                                        opj_stream_private_t *p_stream,
+                                        opj_packet_map_t **p_packet_map,
+                                        opj_event_mgr_t * p_manager);
+
+/**
+ * Reads the colr box and the SIZ and COD marker segments of a JP2 file, see opj_probe.
+ * @param p_stream  the stream, after the first two bytes of the file.
+ * @param p_info the characteristics of the image.
+ * @param p_manager the user event manager.
+ * @return true if the file is a JP2 file with a valid main header.
+ */
+OPJ_BOOL opj_jp2_probe( opj_stream_private_t *p_stream,
+                        opj_probe_info_t *p_info,
+                        opj_event_mgr_t * p_manager);
+
 /**
  * Setup the encoder parameters using the current image and using user parameters. 
  * Coding parameters are returned in jp2->j2k->cp. 
@@ -299,6 +390,22 @@ OPJ_BOOL opj_jp2_start_compress(opj_jp2_t *jp2,
                                 opj_image_t * p_image,
                                 opj_event_mgr_t * p_manager);
 
+/**
+ * Starts the compression of the next frame of a sequence, reusing the coding
+ * parameters and the tile coder of the previous frame.
+ *
+ * @param  jp2       the jpeg2000 file codec.
+ * @param  stream    the stream object.
+ * @param  p_image   the next frame, with the same geometry as the previous one.
+ * @param  p_manager the user event manager.
+ *
+ * @return true if the headers of the frame were written.
+ */
+OPJ_BOOL opj_jp2_encoder_next_frame(opj_jp2_t *jp2,
+                                    opj_stream_private_t *stream,
+                                    opj_image_t * p_image,
+                                    opj_event_mgr_t * p_manager);
+
 
 /**
  * Ends the compression procedures and possibiliy add data to be read after the
@@ -349,7 +456,7 @@ OPJ_BOOL opj_jp2_read_header(  opj_stream_private_t *p_stream,
  */
 OPJ_BOOL opj_jp2_read_tile_header ( opj_jp2_t * p_jp2,
                                     OPJ_UINT32 * p_tile_index,
-                                    OPJ_UINT32 * p_data_size,
+                                    OPJ_SIZE_T * p_data_size,
                                     OPJ_INT32 * p_tile_x0,
                                     OPJ_INT32 * p_tile_y0,
                                     OPJ_INT32 * p_tile_x1,
@@ -371,8 +478,25 @@ OPJ_BOOL opj_jp2_read_tile_header ( opj_jp2_t * p_jp2,
  */
 OPJ_BOOL opj_jp2_write_tile (  opj_jp2_t *p_jp2,
                     OPJ_UINT32 p_tile_index,
+                    OPJ_BYTE * p_data,
+                    OPJ_SIZE_T p_data_size,
+                    opj_stream_private_t *p_stream,
+                    opj_event_mgr_t * p_manager );
+
+/**
+ * Writes the next strip of the image.
+ *
+ * @param  p_jp2        the jpeg2000 codec.
+ * @param  p_data       the samples of the strip, component after component.
+ * @param  p_data_size  the size of p_data.
+ * @param  p_nb_rows    the number of rows of the reference grid covered by the strip.
+ * @param  p_stream     the stream to write data to.
+ * @param  p_manager    the user event manager.
+ */
+OPJ_BOOL opj_jp2_write_strip ( opj_jp2_t *p_jp2,
                     OPJ_BYTE * p_data,
                     OPJ_UINT32 p_data_size,
+                    OPJ_UINT32 p_nb_rows,
                     opj_stream_private_t *p_stream,
                     opj_event_mgr_t * p_manager );
 
@@ -390,7 +514,7 @@ OPJ_BOOL opj_jp2_write_tile (  opj_jp2_t *p_jp2,
 OPJ_BOOL opj_jp2_decode_tile (  opj_jp2_t * p_jp2,
                                 OPJ_UINT32 p_tile_index,
                                 OPJ_BYTE * p_data,
-                                OPJ_UINT32 p_data_size,
+                                OPJ_SIZE_T p_data_size,
                                 opj_stream_private_t *p_stream,
                                 opj_event_mgr_t * p_manager );
 
@@ -407,6 +531,31 @@ Destroy a JP2 decompressor handle
 */
 void opj_jp2_destroy(opj_jp2_t *jp2);
 
+/**
+ * Prepares a JP2 decompressor to read a new file, keeping the allocations
+ * of its J2K decompressor (see opj_j2k_decoder_reset).
+ *
+ * @param  p_jp2      the jpeg2000 codec.
+ * @param  p_manager  the user event manager
+ *
+ * @return  true      if the decompressor was reset.
+ */
+OPJ_BOOL opj_jp2_decoder_reset(opj_jp2_t *p_jp2, opj_event_mgr_t * p_manager);
+
+/**
+ * Creates a JP2 decompressor from another one whose header has been read,
+ * copying what was read from the boxes (see opj_j2k_clone_decompress).
+ *
+ * @param  p_jp2      the jpeg2000 codec to clone.
+ * @param  p_image    if not 00, receives a copy of the image header for the clone.
+ * @param  p_manager  the user event manager
+ *
+ * @return  the new decompressor, 00 if it could not be created.
+ */
+opj_jp2_t* opj_jp2_clone_decompress(	opj_jp2_t *p_jp2,
+										opj_image_t ** p_image,
+										opj_event_mgr_t * p_manager);
+
 
 /**
  * Sets the given area to be decoded. This function should be called right after opj_read_header and before any tile header reading.
@@ -444,6 +593,47 @@ OPJ_BOOL opj_jp2_set_decoded_resolution_factor(opj_jp2_t *p_jp2,
                                                OPJ_UINT32 res_factor, 
                                                opj_event_mgr_t * p_manager);
 
+/**
+ * Sets the function called with the samples of each decoded tile.
+ *
+ * @param	p_jp2			the jpeg2000 codec.
+ * @param	p_tile_fn		function called for each decoded tile, 00 to remove it.
+ * @param	p_user_data		client object passed to p_tile_fn.
+ * @param	p_skip_image	if true, the output image is not built.
+ */
+void opj_jp2_set_decoded_tile_handler(  opj_jp2_t *p_jp2,
+                                        opj_decoded_tile_fn p_tile_fn,
+                                        void * p_user_data,
+                                        OPJ_BOOL p_skip_image);
+
+/**
+ * Sets the budget of the cache of decoded tiles.
+ *
+ * @param	p_jp2			the jpeg2000 codec.
+ * @param	p_max_size		maximum number of bytes kept by the cache, 0 to disable it.
+ * @param	p_manager		the user event manager.
+ *
+ * @return	true if the cache could be set up.
+ */
+OPJ_BOOL opj_jp2_set_tile_cache(opj_jp2_t *p_jp2,
+                                OPJ_SIZE_T p_max_size,
+                                opj_event_mgr_t * p_manager);
+
+/**
+ * Sets the components to decode.
+ *
+ * @param	p_jp2			the jpeg2000 codec.
+ * @param	p_numcomps		number of components to decode, 0 to decode all of them.
+ * @param	p_comps_indices	indices of the components to decode.
+ * @param	p_manager		the user event manager.
+ *
+ * @return	true if the components could be selected.
+ */
+OPJ_BOOL opj_jp2_set_decoded_components(opj_jp2_t *p_jp2,
+                                        OPJ_UINT32 p_numcomps,
+                                        const OPJ_UINT32 * p_comps_indices,
+                                        opj_event_mgr_t * p_manager);
+
 
 /* TODO MSD: clean these 3 functions */
 /**
@@ -474,6 +664,14 @@ opj_codestream_info_v2_t* jp2_get_cstr_info(opj_jp2_t* p_jp2);
  */
 opj_codestream_index_t* jp2_get_cstr_index(opj_jp2_t* p_jp2);
 
+/**
+ * Sets the profile the tile coder accumulates its statistics into.
+ *
+ *@param  p_jp2        jp2 codec.
+ *@param  p_profile    the profile, NULL to disable the profiling.
+ */
+void opj_jp2_set_profile(opj_jp2_t* p_jp2, opj_profile_t * p_profile);
+
 
 /*@}*/
 
@@ -77,7 +77,7 @@ void opj_mct_encode(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
 		OPJ_INT32* restrict c2,
-		OPJ_UINT32 n)
+		OPJ_SIZE_T n)
 {
 	OPJ_SIZE_T i;
 	const OPJ_SIZE_T len = n;
@@ -115,7 +115,7 @@ void opj_mct_encode(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
 		OPJ_INT32* restrict c2,
-		OPJ_UINT32 n)
+		OPJ_SIZE_T n)
 {
 	OPJ_SIZE_T i;
 	const OPJ_SIZE_T len = n;
@@ -142,7 +142,7 @@ void opj_mct_decode(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
 		OPJ_INT32* restrict c2,
-		OPJ_UINT32 n)
+		OPJ_SIZE_T n)
 {
 	OPJ_SIZE_T i;
 	const OPJ_SIZE_T len = n;
@@ -177,9 +177,9 @@ void opj_mct_decode(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1, 
 		OPJ_INT32* restrict c2, 
-		OPJ_UINT32 n)
+		OPJ_SIZE_T n)
 {
-	OPJ_UINT32 i;
+	OPJ_SIZE_T i;
 	for (i = 0; i < n; ++i) {
 		OPJ_INT32 y = c0[i];
 		OPJ_INT32 u = c1[i];
@@ -209,7 +209,7 @@ void opj_mct_encode_real(
 												 OPJ_INT32* restrict c0,
 												 OPJ_INT32* restrict c1,
 												 OPJ_INT32* restrict c2,
-												 OPJ_UINT32 n)
+												 OPJ_SIZE_T n)
 {
 	OPJ_SIZE_T i;
 	const OPJ_SIZE_T len = n;
@@ -350,9 +350,9 @@ void opj_mct_encode_real(
 		OPJ_INT32* restrict c0,
 		OPJ_INT32* restrict c1,
 		OPJ_INT32* restrict c2,
-		OPJ_UINT32 n)
+		OPJ_SIZE_T n)
 {
-	OPJ_UINT32 i;
+	OPJ_SIZE_T i;
 	for(i = 0; i < n; ++i) {
 		OPJ_INT32 r = c0[i];
 		OPJ_INT32 g = c1[i];
@@ -374,9 +374,9 @@ void opj_mct_decode_real(
 		OPJ_FLOAT32* restrict c0,
 		OPJ_FLOAT32* restrict c1,
 		OPJ_FLOAT32* restrict c2,
-		OPJ_UINT32 n)
+		OPJ_SIZE_T n)
 {
-	OPJ_UINT32 i;
+	OPJ_SIZE_T i;
 #ifdef __SSE__
 	__m128 vrv, vgu, vgv, vbu;
 	vrv = _mm_set1_ps(1.402f);
@@ -438,13 +438,13 @@ OPJ_FLOAT64 opj_mct_getnorm_real(OPJ_UINT32 compno) {
 
 OPJ_BOOL opj_mct_encode_custom(
 					   OPJ_BYTE * pCodingdata,
-					   OPJ_UINT32 n,
+					   OPJ_SIZE_T n,
 					   OPJ_BYTE ** pData,
 					   OPJ_UINT32 pNbComp,
 					   OPJ_UINT32 isSigned)
 {
 	OPJ_FLOAT32 * lMct = (OPJ_FLOAT32 *) pCodingdata;
-	OPJ_UINT32 i;
+	OPJ_SIZE_T i;
 	OPJ_UINT32 j;
 	OPJ_UINT32 k;
 	OPJ_UINT32 lNbMatCoeff = pNbComp * pNbComp;
@@ -491,13 +491,13 @@ OPJ_BOOL opj_mct_encode_custom(
 
 OPJ_BOOL opj_mct_decode_custom(
 					   OPJ_BYTE * pDecodingData,
-					   OPJ_UINT32 n,
+					   OPJ_SIZE_T n,
 					   OPJ_BYTE ** pData,
 					   OPJ_UINT32 pNbComp,
 					   OPJ_UINT32 isSigned)
 {
 	OPJ_FLOAT32 * lMct;
-	OPJ_UINT32 i;
+	OPJ_SIZE_T i;
 	OPJ_UINT32 j;
 	OPJ_UINT32 k;
 
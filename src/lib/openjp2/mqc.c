@@ -361,11 +361,14 @@ static INLINE void opj_mqc_renormd(opj_mqc_t *const mqc) {
 
 opj_mqc_t* opj_mqc_create(void) {
 	opj_mqc_t *mqc = (opj_mqc_t*)opj_malloc(sizeof(opj_mqc_t));
-#ifdef MQC_PERF_OPT
 	if (mqc) {
+#ifdef OPJ_PROFILE_MQ_SYMBOLS
+		mqc->nb_symbols = 0;
+#endif
+#ifdef MQC_PERF_OPT
 		mqc->buffer = NULL;
-	}
 #endif
+	}
 	return mqc;
 }
 
@@ -388,6 +391,15 @@ OPJ_UINT32 opj_mqc_numbytes(opj_mqc_t *mqc) {
 	return (OPJ_UINT32)diff;
 }
 
+OPJ_UINT64 opj_mqc_get_nb_symbols(opj_mqc_t *mqc) {
+#ifdef OPJ_PROFILE_MQ_SYMBOLS
+	return mqc->nb_symbols;
+#else
+	(void)mqc;
+	return 0;
+#endif
+}
+
 void opj_mqc_init_enc(opj_mqc_t *mqc, OPJ_BYTE *bp) {
     /* TODO MSD: need to take a look to the v2 version */
 	opj_mqc_setcurctx(mqc, 0);
@@ -402,6 +414,9 @@ void opj_mqc_init_enc(opj_mqc_t *mqc, OPJ_BYTE *bp) {
 }
 
 void opj_mqc_encode(opj_mqc_t *mqc, OPJ_UINT32 d) {
+#ifdef OPJ_PROFILE_MQ_SYMBOLS
+	++mqc->nb_symbols;
+#endif
 	if ((*mqc->curctx)->mps == d) {
 		opj_mqc_codemps(mqc);
 	} else {
@@ -583,6 +598,9 @@ OPJ_BOOL opj_mqc_init_dec(opj_mqc_t *mqc, OPJ_BYTE *bp, OPJ_UINT32 len) {
 
 OPJ_INT32 opj_mqc_decode(opj_mqc_t *const mqc) {
 	OPJ_INT32 d;
+#ifdef OPJ_PROFILE_MQ_SYMBOLS
+	++mqc->nb_symbols;
+#endif
 	mqc->a -= (*mqc->curctx)->qeval;
 	if ((mqc->c >> 16) < (*mqc->curctx)->qeval) {
 		d = opj_mqc_lpsexchange(mqc);
@@ -77,6 +77,10 @@ typedef struct opj_mqc {
 	OPJ_BYTE *end;
 	opj_mqc_state_t *ctxs[MQC_NUMCTXS];
 	opj_mqc_state_t **curctx;
+#ifdef OPJ_PROFILE_MQ_SYMBOLS
+	/** number of symbols coded or decoded since the creation of the coder */
+	OPJ_UINT64 nb_symbols;
+#endif
 #ifdef MQC_PERF_OPT
 	unsigned char *buffer;
 #endif
@@ -102,6 +106,13 @@ Return the number of bytes written/read since initialisation
 */
 OPJ_UINT32 opj_mqc_numbytes(opj_mqc_t *mqc);
 /**
+Return the number of symbols coded or decoded since the creation of the coder,
+counted only when the library is built with OPJ_PROFILE_MQ_SYMBOLS
+@param mqc MQC handle
+@return Returns the number of symbols, 0 if they are not counted
+*/
+OPJ_UINT64 opj_mqc_get_nb_symbols(opj_mqc_t *mqc);
+/**
 Reset the states of all the context of the coder/decoder 
 (each context is set to a state where 0 and 1 are more or less equiprobable)
 @param mqc MQC handle
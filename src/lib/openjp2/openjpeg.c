@@ -158,10 +158,40 @@ const char* OPJ_CALLCONV opj_version(void) {
     return OPJ_PACKAGE_VERSION;
 }
 
+/* ---------------------------------------------------------------------- */
+
+/**
+ * Creates a codec with the given creation function, charging its allocations
+ * to a new memory accounting.
+ */
+static opj_codec_t* opj_create_codec(	opj_codec_t* (*p_create) (OPJ_CODEC_FORMAT),
+										OPJ_CODEC_FORMAT p_format)
+{
+	opj_mem_stats_t * l_stats = opj_mem_stats_create();
+	opj_mem_stats_t * l_previous;
+	opj_codec_private_t * l_codec;
+
+	if (! l_stats) {
+		return 00;
+	}
+
+	l_previous = opj_mem_stats_enter(l_stats);
+	l_codec = (opj_codec_private_t *) p_create(p_format);
+	opj_mem_stats_leave(l_previous);
+
+	if (! l_codec) {
+		opj_mem_stats_release(l_stats);
+		return 00;
+	}
+
+	l_codec->m_mem_stats = l_stats;
+	return (opj_codec_t*) l_codec;
+}
+
 /* ---------------------------------------------------------------------- */
 /* DECOMPRESSION FUNCTIONS*/
 
-opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
+static opj_codec_t* opj_create_decompress_codec(OPJ_CODEC_FORMAT p_format)
 {
 	opj_codec_private_t *l_codec = 00;
 
@@ -180,11 +210,46 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 
 			l_codec->opj_get_codec_index = (opj_codestream_index_t* (*) (void*) ) j2k_get_cstr_index;
 
+			l_codec->opj_set_profile = (void (*) (void*, opj_profile_t*)) opj_j2k_set_profile;
+
 			l_codec->m_codec_data.m_decompression.opj_decode =
 					(OPJ_BOOL (*) (	void *,
 									struct opj_stream_private *,
 									opj_image_t*, struct opj_event_mgr * )) opj_j2k_decode;
 
+			l_codec->m_codec_data.m_decompression.opj_decode_strips =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_UINT32,
+									opj_decoded_strip_fn, void *,
+									struct opj_event_mgr * )) opj_j2k_decode_strips;
+
+			l_codec->m_codec_data.m_decompression.opj_decode_within_budget =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_FLOAT64,
+									opj_decode_report_t *,
+									struct opj_event_mgr * )) opj_j2k_decode_within_budget;
+
+			l_codec->m_codec_data.m_decompression.opj_decode_incremental =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_BOOL *,
+									struct opj_event_mgr * )) opj_j2k_decode_incremental;
+
+			l_codec->m_codec_data.m_decompression.opj_transcode =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									struct opj_stream_private *,
+									const opj_transcode_parameters_t *,
+									struct opj_event_mgr * )) opj_j2k_transcode;
+
+			l_codec->m_codec_data.m_decompression.opj_get_packet_map =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_packet_map_t **,
+									struct opj_event_mgr * )) opj_j2k_get_packet_map;
+
 			l_codec->m_codec_data.m_decompression.opj_end_decompress =
 					(OPJ_BOOL (*) (	void *,
 									struct opj_stream_private *,
@@ -205,7 +270,7 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 			l_codec->m_codec_data.m_decompression.opj_read_tile_header =
 					(OPJ_BOOL (*) (	void *,
 									OPJ_UINT32*,
-									OPJ_UINT32*,
+									OPJ_SIZE_T*,
 									OPJ_INT32*, OPJ_INT32*,
 									OPJ_INT32*, OPJ_INT32*,
 									OPJ_UINT32*,
@@ -217,7 +282,7 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 					(OPJ_BOOL (*) ( void *, 
                                     OPJ_UINT32, 
                                     OPJ_BYTE*, 
-                                    OPJ_UINT32, 
+                                    OPJ_SIZE_T, 
                                     struct opj_stream_private *,
                                     struct opj_event_mgr *)) opj_j2k_decode_tile;
 
@@ -239,6 +304,32 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 									OPJ_UINT32 res_factor,
 									struct opj_event_mgr * p_manager)) opj_j2k_set_decoded_resolution_factor;
 
+			l_codec->m_codec_data.m_decompression.opj_set_decoded_tile_handler =
+					(void (*) (	void *,
+								opj_decoded_tile_fn,
+								void *,
+								OPJ_BOOL)) opj_j2k_set_decoded_tile_handler;
+
+			l_codec->m_codec_data.m_decompression.opj_set_tile_cache =
+					(OPJ_BOOL (*) (	void *,
+									OPJ_SIZE_T,
+									struct opj_event_mgr * )) opj_j2k_set_tile_cache;
+
+			l_codec->m_codec_data.m_decompression.opj_set_decoded_components =
+					(OPJ_BOOL (*) (	void *,
+									OPJ_UINT32,
+									const OPJ_UINT32 *,
+									struct opj_event_mgr * )) opj_j2k_set_decoded_components;
+
+			l_codec->m_codec_data.m_decompression.opj_decoder_reset =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_event_mgr * )) opj_j2k_decoder_reset;
+
+			l_codec->m_codec_data.m_decompression.opj_clone =
+					(void * (*) (	void *,
+									opj_image_t **,
+									struct opj_event_mgr * )) opj_j2k_clone_decompress;
+
 			l_codec->m_codec = opj_j2k_create_decompress();
 
 			if (! l_codec->m_codec) {
@@ -256,12 +347,47 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 
 			l_codec->opj_get_codec_index = (opj_codestream_index_t* (*) (void*) ) jp2_get_cstr_index;
 
+			l_codec->opj_set_profile = (void (*) (void*, opj_profile_t*)) opj_jp2_set_profile;
+
 			l_codec->m_codec_data.m_decompression.opj_decode =
 					(OPJ_BOOL (*) (	void *,
 									struct opj_stream_private *,
 									opj_image_t*,
 									struct opj_event_mgr * )) opj_jp2_decode;
 
+			l_codec->m_codec_data.m_decompression.opj_decode_strips =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_UINT32,
+									opj_decoded_strip_fn, void *,
+									struct opj_event_mgr * )) opj_jp2_decode_strips;
+
+			l_codec->m_codec_data.m_decompression.opj_decode_within_budget =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_FLOAT64,
+									opj_decode_report_t *,
+									struct opj_event_mgr * )) opj_jp2_decode_within_budget;
+
+			l_codec->m_codec_data.m_decompression.opj_decode_incremental =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_image_t*, OPJ_BOOL *,
+									struct opj_event_mgr * )) opj_jp2_decode_incremental;
+
+			l_codec->m_codec_data.m_decompression.opj_transcode =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									struct opj_stream_private *,
+									const opj_transcode_parameters_t *,
+									struct opj_event_mgr * )) opj_jp2_transcode;
+
+			l_codec->m_codec_data.m_decompression.opj_get_packet_map =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_stream_private *,
+									opj_packet_map_t **,
+									struct opj_event_mgr * )) opj_jp2_get_packet_map;
+
 			l_codec->m_codec_data.m_decompression.opj_end_decompress =  
                     (OPJ_BOOL (*) ( void *,
                                     struct opj_stream_private *,
@@ -276,7 +402,7 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 			l_codec->m_codec_data.m_decompression.opj_read_tile_header = 
                     (OPJ_BOOL (*) ( void *,
 					                OPJ_UINT32*,
-					                OPJ_UINT32*,
+					                OPJ_SIZE_T*,
 					                OPJ_INT32*,
 					                OPJ_INT32*,
 					                OPJ_INT32 * ,
@@ -288,7 +414,7 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 
 			l_codec->m_codec_data.m_decompression.opj_decode_tile_data = 
                     (OPJ_BOOL (*) ( void *,
-                                    OPJ_UINT32,OPJ_BYTE*,OPJ_UINT32,
+                                    OPJ_UINT32,OPJ_BYTE*,OPJ_SIZE_T,
                                     struct opj_stream_private *,
                                     struct opj_event_mgr * )) opj_jp2_decode_tile;
 
@@ -315,6 +441,32 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 						    		OPJ_UINT32 res_factor,
 							    	opj_event_mgr_t * p_manager)) opj_jp2_set_decoded_resolution_factor;
 
+			l_codec->m_codec_data.m_decompression.opj_set_decoded_tile_handler =
+					(void (*) (	void *,
+								opj_decoded_tile_fn,
+								void *,
+								OPJ_BOOL)) opj_jp2_set_decoded_tile_handler;
+
+			l_codec->m_codec_data.m_decompression.opj_set_tile_cache =
+					(OPJ_BOOL (*) (	void *,
+									OPJ_SIZE_T,
+									struct opj_event_mgr * )) opj_jp2_set_tile_cache;
+
+			l_codec->m_codec_data.m_decompression.opj_set_decoded_components =
+					(OPJ_BOOL (*) (	void *,
+									OPJ_UINT32,
+									const OPJ_UINT32 *,
+									struct opj_event_mgr * )) opj_jp2_set_decoded_components;
+
+			l_codec->m_codec_data.m_decompression.opj_decoder_reset =
+					(OPJ_BOOL (*) (	void *,
+									struct opj_event_mgr * )) opj_jp2_decoder_reset;
+
+			l_codec->m_codec_data.m_decompression.opj_clone =
+					(void * (*) (	void *,
+									opj_image_t **,
+									struct opj_event_mgr * )) opj_jp2_clone_decompress;
+
 			l_codec->m_codec = opj_jp2_create(OPJ_TRUE);
 
 			if (! l_codec->m_codec) {
@@ -334,6 +486,11 @@ opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
 	return (opj_codec_t*) l_codec;
 }
 
+opj_codec_t* OPJ_CALLCONV opj_create_decompress(OPJ_CODEC_FORMAT p_format)
+{
+	return opj_create_codec(opj_create_decompress_codec, p_format);
+}
+
 void OPJ_CALLCONV opj_set_default_decoder_parameters(opj_dparameters_t *parameters) {
 	if(parameters) {
 		memset(parameters, 0, sizeof(opj_dparameters_t));
@@ -381,6 +538,8 @@ OPJ_BOOL OPJ_CALLCONV opj_read_header (	opj_stream_t *p_stream,
 	if (p_codec && p_stream) {
 		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
 		opj_stream_private_t* l_stream = (opj_stream_private_t*) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if(! l_codec->is_decompressor) {
 			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, 
@@ -388,15 +547,123 @@ OPJ_BOOL OPJ_CALLCONV opj_read_header (	opj_stream_t *p_stream,
 			return OPJ_FALSE;
 		}
 
-		return l_codec->m_codec_data.m_decompression.opj_read_header(	l_stream,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_read_header(	l_stream,
 																		l_codec->m_codec,
 																		p_image,
 																		&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_probe(	opj_stream_t *p_stream,
+									opj_probe_info_t *p_info )
+{
+	if (p_stream && p_info) {
+		opj_stream_private_t* l_stream = (opj_stream_private_t*) p_stream;
+		opj_event_mgr_t l_event_mgr;
+		OPJ_BYTE l_data [2];
+		OPJ_UINT32 l_marker;
+
+		/* no codec, hence no user handlers: the messages are discarded */
+		opj_set_default_event_handler(&l_event_mgr);
+		memset(p_info, 0, sizeof(opj_probe_info_t));
+
+		if (opj_stream_read_data(l_stream, l_data, 2, &l_event_mgr) != 2) {
+			return OPJ_FALSE;
+		}
+		opj_read_bytes(l_data, &l_marker, 2);
+		if (l_marker == J2K_MS_SOC) {
+			p_info->format = OPJ_CODEC_J2K;
+			return opj_j2k_probe(l_stream, p_info, &l_event_mgr);
+		}
+		return opj_jp2_probe(l_stream, p_info, &l_event_mgr);
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_decoder_reset(	opj_codec_t *p_codec,
+											opj_stream_t *p_stream,
+											opj_image_t **p_image )
+{
+	if (p_codec && p_stream && p_image) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+		opj_stream_private_t* l_stream = (opj_stream_private_t*) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if(! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, 
+                "Codec provided to the opj_decoder_reset function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_decoder_reset(	l_codec->m_codec,
+																			&(l_codec->m_event_mgr) )
+				&& l_codec->m_codec_data.m_decompression.opj_read_header(	l_stream,
+																			l_codec->m_codec,
+																			p_image,
+																			&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 
 	return OPJ_FALSE;
 }
 
+opj_codec_t* OPJ_CALLCONV opj_codec_clone(	opj_codec_t *p_codec,
+											opj_image_t **p_image)
+{
+	if (p_codec) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+		opj_codec_private_t* l_clone;
+		opj_mem_stats_t * l_stats;
+		opj_mem_stats_t * l_previous;
+
+		if(! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, 
+                "Codec provided to the opj_codec_clone function is not a decompressor handler.\n");
+			return 00;
+		}
+
+		/* the clone has its own memory accounting, with the same limit */
+		l_stats = opj_mem_stats_create();
+		if (! l_stats) {
+			return 00;
+		}
+		l_stats->m_limit = l_codec->m_mem_stats->m_limit;
+
+		l_previous = opj_mem_stats_enter(l_stats);
+		l_clone = (opj_codec_private_t*) opj_malloc(sizeof(opj_codec_private_t));
+		if (l_clone) {
+			memcpy(l_clone, l_codec, sizeof(opj_codec_private_t));
+			l_clone->m_profile = 00;
+			l_clone->m_codec = l_codec->m_codec_data.m_decompression.opj_clone(	l_codec->m_codec,
+																				p_image,
+																				&(l_codec->m_event_mgr) );
+			if (! l_clone->m_codec) {
+				opj_free(l_clone);
+				l_clone = 00;
+			}
+		}
+		opj_mem_stats_leave(l_previous);
+
+		if (! l_clone) {
+			opj_mem_stats_release(l_stats);
+			return 00;
+		}
+		l_clone->m_mem_stats = l_stats;
+		return (opj_codec_t*) l_clone;
+	}
+
+	return 00;
+}
+
 OPJ_BOOL OPJ_CALLCONV opj_decode(   opj_codec_t *p_codec,
                                     opj_stream_t *p_stream,
                                     opj_image_t* p_image)
@@ -404,15 +671,156 @@ OPJ_BOOL OPJ_CALLCONV opj_decode(   opj_codec_t *p_codec,
 	if (p_codec && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 
-		return l_codec->m_codec_data.m_decompression.opj_decode(l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_decode(l_codec->m_codec,
 																l_stream,
 																p_image,
 																&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_decode_strips(   opj_codec_t *p_codec,
+                                           opj_stream_t *p_stream,
+                                           opj_image_t* p_image,
+                                           OPJ_UINT32 p_strip_height,
+                                           opj_decoded_strip_fn p_strip_fn,
+                                           void * p_user_data)
+{
+	if (p_codec && p_stream) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if (! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR,
+                "Codec provided to the opj_decode_strips function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_decode_strips(l_codec->m_codec,
+																l_stream,
+																p_image,
+																p_strip_height,
+																p_strip_fn,
+																p_user_data,
+																&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_decode_within_budget(   opj_codec_t *p_codec,
+                                                  opj_stream_t *p_stream,
+                                                  opj_image_t* p_image,
+                                                  OPJ_FLOAT64 p_max_time,
+                                                  opj_decode_report_t * p_report)
+{
+	if (p_codec && p_stream) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if (! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR,
+                "Codec provided to the opj_decode_within_budget function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_decode_within_budget(l_codec->m_codec,
+																l_stream,
+																p_image,
+																p_max_time,
+																p_report,
+																&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_decode_incremental(   opj_codec_t *p_codec,
+                                                opj_stream_t *p_stream,
+                                                opj_image_t* p_image,
+                                                OPJ_BOOL * p_complete)
+{
+	if (p_codec && p_stream) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if (! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR,
+                "Codec provided to the opj_decode_incremental function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_decode_incremental(l_codec->m_codec,
+																l_stream,
+																p_image,
+																p_complete,
+																&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+void OPJ_CALLCONV opj_set_default_transcode_parameters(opj_transcode_parameters_t *parameters)
+{
+	if (parameters) {
+		memset(parameters, 0, sizeof(opj_transcode_parameters_t));
+		/* keep the progression order of each tile */
+		parameters->prog_order = OPJ_PROG_UNKNOWN;
+	}
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_transcode(    opj_codec_t *p_codec,
+                                        opj_stream_t *p_input,
+                                        opj_stream_t *p_output,
+                                        const opj_transcode_parameters_t *p_parameters)
+{
+	if (p_codec && p_input && p_output && p_parameters) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_input = (opj_stream_private_t *) p_input;
+		opj_stream_private_t * l_output = (opj_stream_private_t *) p_output;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if (! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR,
+                "Codec provided to the opj_transcode function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_transcode(l_codec->m_codec,
+																l_input,
+																l_output,
+																p_parameters,
+																&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 
 	return OPJ_FALSE;
@@ -426,16 +834,21 @@ OPJ_BOOL OPJ_CALLCONV opj_set_decode_area(	opj_codec_t *p_codec,
 {
 	if (p_codec) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 		
 		if (! l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 
-		return  l_codec->m_codec_data.m_decompression.opj_set_decode_area(	l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_set_decode_area(	l_codec->m_codec,
 																			p_image,
 																			p_start_x, p_start_y,
 																			p_end_x, p_end_y,
 																			&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 	return OPJ_FALSE;
 }
@@ -443,7 +856,7 @@ OPJ_BOOL OPJ_CALLCONV opj_set_decode_area(	opj_codec_t *p_codec,
 OPJ_BOOL OPJ_CALLCONV opj_read_tile_header(	opj_codec_t *p_codec,
 											opj_stream_t * p_stream,
 											OPJ_UINT32 * p_tile_index,
-											OPJ_UINT32 * p_data_size,
+											OPJ_SIZE_T * p_data_size,
 											OPJ_INT32 * p_tile_x0, OPJ_INT32 * p_tile_y0,
 											OPJ_INT32 * p_tile_x1, OPJ_INT32 * p_tile_y1,
 											OPJ_UINT32 * p_nb_comps,
@@ -452,12 +865,15 @@ OPJ_BOOL OPJ_CALLCONV opj_read_tile_header(	opj_codec_t *p_codec,
 	if (p_codec && p_stream && p_data_size && p_tile_index) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 
-		return l_codec->m_codec_data.m_decompression.opj_read_tile_header(	l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_read_tile_header(	l_codec->m_codec,
 																			p_tile_index,
 																			p_data_size,
 																			p_tile_x0, p_tile_y0,
@@ -466,6 +882,8 @@ OPJ_BOOL OPJ_CALLCONV opj_read_tile_header(	opj_codec_t *p_codec,
 																			p_should_go_on,
 																			l_stream,
 																			&(l_codec->m_event_mgr));
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 	return OPJ_FALSE;
 }
@@ -473,24 +891,29 @@ OPJ_BOOL OPJ_CALLCONV opj_read_tile_header(	opj_codec_t *p_codec,
 OPJ_BOOL OPJ_CALLCONV opj_decode_tile_data(	opj_codec_t *p_codec,
 											OPJ_UINT32 p_tile_index,
 											OPJ_BYTE * p_data,
-											OPJ_UINT32 p_data_size,
+											OPJ_SIZE_T p_data_size,
 											opj_stream_t *p_stream
 											)
 {
 	if (p_codec && p_data && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 
-		return l_codec->m_codec_data.m_decompression.opj_decode_tile_data(	l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_decode_tile_data(	l_codec->m_codec,
 																			p_tile_index,
 																			p_data,
 																			p_data_size,
 																			l_stream,
 																			&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 	return OPJ_FALSE;
 }
@@ -503,16 +926,21 @@ OPJ_BOOL OPJ_CALLCONV opj_get_decoded_tile(	opj_codec_t *p_codec,
 	if (p_codec && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 		
-		return l_codec->m_codec_data.m_decompression.opj_get_decoded_tile(	l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_get_decoded_tile(	l_codec->m_codec,
 																			l_stream,
 																			p_image,
 																			&(l_codec->m_event_mgr),
 																			tile_index);
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 
 	return OPJ_FALSE;
@@ -522,20 +950,90 @@ OPJ_BOOL OPJ_CALLCONV opj_set_decoded_resolution_factor(opj_codec_t *p_codec,
 														OPJ_UINT32 res_factor )
 {
 	opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+	opj_mem_stats_t * l_previous;
+	OPJ_BOOL l_result;
 
 	if ( !l_codec ){
 		return OPJ_FALSE;
 	}
 
-	return l_codec->m_codec_data.m_decompression.opj_set_decoded_resolution_factor(l_codec->m_codec,
+	l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+	l_result = l_codec->m_codec_data.m_decompression.opj_set_decoded_resolution_factor(l_codec->m_codec,
 																			res_factor,
 																			&(l_codec->m_event_mgr) );
+	opj_mem_stats_leave(l_previous);
+	return l_result;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_set_decoded_tile_handler(	opj_codec_t *p_codec,
+														opj_decoded_tile_fn p_tile_fn,
+														void * p_user_data,
+														OPJ_BOOL p_skip_image)
+{
+	opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+
+	if (! l_codec) {
+		return OPJ_FALSE;
+	}
+
+	if (! l_codec->is_decompressor) {
+		opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, "Codec provided to the opj_set_decoded_tile_handler function is not a decompressor handler.\n");
+		return OPJ_FALSE;
+	}
+
+	l_codec->m_codec_data.m_decompression.opj_set_decoded_tile_handler(l_codec->m_codec, p_tile_fn, p_user_data, p_skip_image);
+	return OPJ_TRUE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_set_tile_cache(	opj_codec_t *p_codec,
+											OPJ_SIZE_T p_max_size)
+{
+	opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+	opj_mem_stats_t * l_previous;
+	OPJ_BOOL l_result;
+
+	if (! l_codec) {
+		return OPJ_FALSE;
+	}
+
+	if (! l_codec->is_decompressor) {
+		opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, "Codec provided to the opj_set_tile_cache function is not a decompressor handler.\n");
+		return OPJ_FALSE;
+	}
+
+	l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+	l_result = l_codec->m_codec_data.m_decompression.opj_set_tile_cache(l_codec->m_codec, p_max_size, &(l_codec->m_event_mgr));
+	opj_mem_stats_leave(l_previous);
+	return l_result;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_set_decoded_components(	opj_codec_t *p_codec,
+													OPJ_UINT32 numcomps,
+													const OPJ_UINT32 * comps_indices)
+{
+	opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+	opj_mem_stats_t * l_previous;
+	OPJ_BOOL l_result;
+
+	if (! l_codec) {
+		return OPJ_FALSE;
+	}
+
+	if (! l_codec->is_decompressor) {
+		opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR, "Codec provided to the opj_set_decoded_components function is not a decompressor handler.\n");
+		return OPJ_FALSE;
+	}
+
+	l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+	l_result = l_codec->m_codec_data.m_decompression.opj_set_decoded_components(l_codec->m_codec, numcomps, comps_indices, &(l_codec->m_event_mgr));
+	opj_mem_stats_leave(l_previous);
+	return l_result;
 }
 
 /* ---------------------------------------------------------------------- */
 /* COMPRESSION FUNCTIONS*/
 
-opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
+static opj_codec_t* opj_create_compress_codec(OPJ_CODEC_FORMAT p_format)
 {
 	opj_codec_private_t *l_codec = 00;
 
@@ -564,10 +1062,17 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 			l_codec->m_codec_data.m_compression.opj_write_tile = (OPJ_BOOL (*) (void *,
 																				OPJ_UINT32,
 																				OPJ_BYTE*,
-																				OPJ_UINT32,
+																				OPJ_SIZE_T,
 																				struct opj_stream_private *,
 																				struct opj_event_mgr *) ) opj_j2k_write_tile;
 
+			l_codec->m_codec_data.m_compression.opj_write_strip = (OPJ_BOOL (*) (void *,
+																				OPJ_BYTE*,
+																				OPJ_UINT32,
+																				OPJ_UINT32,
+																				struct opj_stream_private *,
+																				struct opj_event_mgr *)) opj_j2k_write_strip;
+
 			l_codec->m_codec_data.m_compression.opj_destroy = (void (*) (void *)) opj_j2k_destroy;
 
 			l_codec->m_codec_data.m_compression.opj_setup_encoder = (OPJ_BOOL (*) (	void *,
@@ -575,6 +1080,13 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 																				struct opj_image *,
 																				struct opj_event_mgr * )) opj_j2k_setup_encoder;
 
+			l_codec->m_codec_data.m_compression.opj_encoder_next_frame = (OPJ_BOOL (*) (void *,
+																					struct opj_stream_private *,
+																					struct opj_image * ,
+																					struct opj_event_mgr *)) opj_j2k_encoder_next_frame;
+
+			l_codec->opj_set_profile = (void (*) (void*, opj_profile_t*)) opj_j2k_set_profile;
+
 			l_codec->m_codec = opj_j2k_create_compress();
 			if (! l_codec->m_codec) {
 				opj_free(l_codec);
@@ -601,10 +1113,17 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 			l_codec->m_codec_data.m_compression.opj_write_tile = (OPJ_BOOL (*) (void *,
 																				OPJ_UINT32,
 																				OPJ_BYTE*,
-																				OPJ_UINT32,
+																				OPJ_SIZE_T,
 																				struct opj_stream_private *,
 																				struct opj_event_mgr *)) opj_jp2_write_tile;
 
+			l_codec->m_codec_data.m_compression.opj_write_strip = (OPJ_BOOL (*) (void *,
+																				OPJ_BYTE*,
+																				OPJ_UINT32,
+																				OPJ_UINT32,
+																				struct opj_stream_private *,
+																				struct opj_event_mgr *)) opj_jp2_write_strip;
+
 			l_codec->m_codec_data.m_compression.opj_destroy = (void (*) (void *)) opj_jp2_destroy;
 
 			l_codec->m_codec_data.m_compression.opj_setup_encoder = (OPJ_BOOL (*) (	void *,
@@ -612,6 +1131,13 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 																				struct opj_image *,
 																				struct opj_event_mgr * )) opj_jp2_setup_encoder;
 
+			l_codec->m_codec_data.m_compression.opj_encoder_next_frame = (OPJ_BOOL (*) (void *,
+																					struct opj_stream_private *,
+																					struct opj_image * ,
+																					struct opj_event_mgr *)) opj_jp2_encoder_next_frame;
+
+			l_codec->opj_set_profile = (void (*) (void*, opj_profile_t*)) opj_jp2_set_profile;
+
 			l_codec->m_codec = opj_jp2_create(OPJ_FALSE);
 			if (! l_codec->m_codec) {
 				opj_free(l_codec);
@@ -631,6 +1157,11 @@ opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
 	return (opj_codec_t*) l_codec;
 }
 
+opj_codec_t* OPJ_CALLCONV opj_create_compress(OPJ_CODEC_FORMAT p_format)
+{
+	return opj_create_codec(opj_create_compress_codec, p_format);
+}
+
 void OPJ_CALLCONV opj_set_default_encoder_parameters(opj_cparameters_t *parameters) {
 	if(parameters) {
 		memset(parameters, 0, sizeof(opj_cparameters_t));
@@ -696,12 +1227,17 @@ OPJ_BOOL OPJ_CALLCONV opj_setup_encoder(opj_codec_t *p_codec,
 {
 	if (p_codec && parameters && p_image) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
-			return l_codec->m_codec_data.m_compression.opj_setup_encoder(	l_codec->m_codec,
+			l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+			l_result = l_codec->m_codec_data.m_compression.opj_setup_encoder(	l_codec->m_codec,
 																	parameters,
 																	p_image,
 																	&(l_codec->m_event_mgr) );
+			opj_mem_stats_leave(l_previous);
+			return l_result;
 		}
 	}
 
@@ -715,12 +1251,41 @@ OPJ_BOOL OPJ_CALLCONV opj_start_compress (	opj_codec_t *p_codec,
 	if (p_codec && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
-			return l_codec->m_codec_data.m_compression.opj_start_compress(	l_codec->m_codec,
+			l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+			l_result = l_codec->m_codec_data.m_compression.opj_start_compress(	l_codec->m_codec,
 																			l_stream,
 																			p_image,
 																			&(l_codec->m_event_mgr));
+			opj_mem_stats_leave(l_previous);
+			return l_result;
+		}
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_encoder_next_frame (	opj_codec_t *p_codec,
+												opj_image_t * p_image,
+												opj_stream_t *p_stream)
+{
+	if (p_codec && p_image && p_stream) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if (! l_codec->is_decompressor) {
+			l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+			l_result = l_codec->m_codec_data.m_compression.opj_encoder_next_frame(	l_codec->m_codec,
+																				l_stream,
+																				p_image,
+																				&(l_codec->m_event_mgr));
+			opj_mem_stats_leave(l_previous);
+			return l_result;
 		}
 	}
 
@@ -732,11 +1297,16 @@ OPJ_BOOL OPJ_CALLCONV opj_encode(opj_codec_t *p_info, opj_stream_t *p_stream)
 	if (p_info && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_info;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
-			return l_codec->m_codec_data.m_compression.opj_encode(	l_codec->m_codec,
+			l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+			l_result = l_codec->m_codec_data.m_compression.opj_encode(	l_codec->m_codec,
 															l_stream,
 															&(l_codec->m_event_mgr));
+			opj_mem_stats_leave(l_previous);
+			return l_result;
 		}
 	}
 
@@ -750,11 +1320,16 @@ OPJ_BOOL OPJ_CALLCONV opj_end_compress (opj_codec_t *p_codec,
 	if (p_codec && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
-			return l_codec->m_codec_data.m_compression.opj_end_compress(l_codec->m_codec,
+			l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+			l_result = l_codec->m_codec_data.m_compression.opj_end_compress(l_codec->m_codec,
 																		l_stream,
 																		&(l_codec->m_event_mgr));
+			opj_mem_stats_leave(l_previous);
+			return l_result;
 		}
 	}
 	return OPJ_FALSE;
@@ -767,14 +1342,19 @@ OPJ_BOOL OPJ_CALLCONV opj_end_decompress (	opj_codec_t *p_codec,
 	if (p_codec && p_stream) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (! l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 		
-		return l_codec->m_codec_data.m_decompression.opj_end_decompress(l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_end_decompress(l_codec->m_codec,
 																		l_stream,
 																		&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 
 	return OPJ_FALSE;
@@ -798,7 +1378,7 @@ OPJ_BOOL OPJ_CALLCONV opj_set_MCT(opj_cparameters_t *parameters,
 
 	/* use array based MCT */
 	parameters->tcp_mct = 2;
-	parameters->mct_data = opj_malloc(l_mct_total_size);
+	parameters->mct_data = opj_image_data_alloc(l_mct_total_size);
 	if (! parameters->mct_data) {
 		return OPJ_FALSE;
 	}
@@ -812,23 +1392,58 @@ OPJ_BOOL OPJ_CALLCONV opj_set_MCT(opj_cparameters_t *parameters,
 OPJ_BOOL OPJ_CALLCONV opj_write_tile (	opj_codec_t *p_codec,
 										OPJ_UINT32 p_tile_index,
 										OPJ_BYTE * p_data,
-										OPJ_UINT32 p_data_size,
+										OPJ_SIZE_T p_data_size,
 										opj_stream_t *p_stream )
 {
 	if (p_codec && p_stream && p_data) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
 		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
 
 		if (l_codec->is_decompressor) {
 			return OPJ_FALSE;
 		}
 
-		return l_codec->m_codec_data.m_compression.opj_write_tile(	l_codec->m_codec,
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_compression.opj_write_tile(	l_codec->m_codec,
 																	p_tile_index,
 																	p_data,
 																	p_data_size,
 																	l_stream,
 																	&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_write_strip (	opj_codec_t *p_codec,
+										OPJ_BYTE * p_data,
+										OPJ_UINT32 p_data_size,
+										OPJ_UINT32 p_nb_rows,
+										opj_stream_t *p_stream )
+{
+	if (p_codec && p_stream && p_data) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		if (l_codec->is_decompressor) {
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_compression.opj_write_strip(	l_codec->m_codec,
+																	p_data,
+																	p_data_size,
+																	p_nb_rows,
+																	l_stream,
+																	&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
 	}
 
 	return OPJ_FALSE;
@@ -840,6 +1455,8 @@ void OPJ_CALLCONV opj_destroy_codec(opj_codec_t *p_codec)
 {
 	if (p_codec) {
 		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_mem_stats_t * l_stats = l_codec->m_mem_stats;
+		opj_mem_stats_t * l_previous = opj_mem_stats_enter(l_stats);
 
 		if (l_codec->is_decompressor) {
 			l_codec->m_codec_data.m_decompression.opj_destroy(l_codec->m_codec);
@@ -849,7 +1466,11 @@ void OPJ_CALLCONV opj_destroy_codec(opj_codec_t *p_codec)
 		}
 
 		l_codec->m_codec = 00;
+		opj_profile_destroy(l_codec->m_profile);
 		opj_free(l_codec);
+
+		opj_mem_stats_leave(l_previous);
+		opj_mem_stats_release(l_stats);
 	}
 }
 
@@ -875,8 +1496,14 @@ opj_codestream_info_v2_t* OPJ_CALLCONV opj_get_cstr_info(opj_codec_t *p_codec)
 {
 	if (p_codec) {
 		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+		opj_codestream_info_v2_t* l_info = l_codec->opj_get_codec_info(l_codec->m_codec);
+
+		if (l_info) {
+			l_info->mem_current = l_codec->m_mem_stats->m_current;
+			l_info->mem_peak = l_codec->m_mem_stats->m_peak;
+		}
 
-		return l_codec->opj_get_codec_info(l_codec->m_codec);
+		return l_info;
 	}
 
 	return NULL;
@@ -917,6 +1544,129 @@ void OPJ_CALLCONV opj_destroy_cstr_index(opj_codestream_index_t **p_cstr_index)
 	}
 }
 
+OPJ_BOOL OPJ_CALLCONV opj_get_packet_map(	opj_codec_t *p_codec,
+											opj_stream_t *p_stream,
+											opj_packet_map_t **p_packet_map)
+{
+	if (p_codec && p_stream && p_packet_map) {
+		opj_codec_private_t * l_codec = (opj_codec_private_t *) p_codec;
+		opj_stream_private_t * l_stream = (opj_stream_private_t *) p_stream;
+		opj_mem_stats_t * l_previous;
+		OPJ_BOOL l_result;
+
+		*p_packet_map = NULL;
+		if (! l_codec->is_decompressor) {
+			opj_event_msg(&(l_codec->m_event_mgr), EVT_ERROR,
+                "Codec provided to the opj_get_packet_map function is not a decompressor handler.\n");
+			return OPJ_FALSE;
+		}
+
+		l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		l_result = l_codec->m_codec_data.m_decompression.opj_get_packet_map(l_codec->m_codec,
+																l_stream,
+																p_packet_map,
+																&(l_codec->m_event_mgr) );
+		opj_mem_stats_leave(l_previous);
+		return l_result;
+	}
+
+	return OPJ_FALSE;
+}
+
+void OPJ_CALLCONV opj_destroy_packet_map(opj_packet_map_t **p_packet_map)
+{
+	if (p_packet_map && *p_packet_map) {
+		opj_free((*p_packet_map)->packets);
+		opj_free(*p_packet_map);
+		(*p_packet_map) = NULL;
+	}
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_get_memory_usage(	opj_codec_t *p_codec,
+											OPJ_SIZE_T * p_current,
+											OPJ_SIZE_T * p_peak)
+{
+	if (p_codec) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+
+		if (p_current) {
+			*p_current = l_codec->m_mem_stats->m_current;
+		}
+		if (p_peak) {
+			*p_peak = l_codec->m_mem_stats->m_peak;
+		}
+		return OPJ_TRUE;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_set_memory_limit(	opj_codec_t *p_codec,
+											OPJ_SIZE_T p_max_bytes)
+{
+	if (p_codec) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+
+		l_codec->m_mem_stats->m_limit = p_max_bytes;
+		return OPJ_TRUE;
+	}
+
+	return OPJ_FALSE;
+}
+
+OPJ_BOOL OPJ_CALLCONV opj_set_profiling(	opj_codec_t *p_codec,
+										OPJ_BOOL p_enable)
+{
+	if (p_codec) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+		opj_mem_stats_t * l_previous = opj_mem_stats_enter(l_codec->m_mem_stats);
+		opj_profile_t * l_profile = 00;
+
+		if (p_enable) {
+			l_profile = opj_profile_create();
+			if (! l_profile) {
+				opj_mem_stats_leave(l_previous);
+				return OPJ_FALSE;
+			}
+		}
+
+		l_codec->opj_set_profile(l_codec->m_codec, l_profile);
+		opj_profile_destroy(l_codec->m_profile);
+		l_codec->m_profile = l_profile;
+
+		opj_mem_stats_leave(l_previous);
+		return OPJ_TRUE;
+	}
+
+	return OPJ_FALSE;
+}
+
+const opj_profile_t * OPJ_CALLCONV opj_get_profile(opj_codec_t *p_codec)
+{
+	if (p_codec) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+
+		if (l_codec->m_profile) {
+			opj_profile_update_total(l_codec->m_profile);
+		}
+		return l_codec->m_profile;
+	}
+
+	return 00;
+}
+
+void OPJ_CALLCONV opj_dump_profile(	opj_codec_t *p_codec,
+									FILE* output_stream)
+{
+	if (p_codec) {
+		opj_codec_private_t* l_codec = (opj_codec_private_t*) p_codec;
+
+		if (l_codec->m_profile) {
+			opj_profile_dump(l_codec->m_profile, output_stream);
+		}
+	}
+}
+
 opj_stream_t* OPJ_CALLCONV opj_stream_create_default_file_stream (const char *fname, OPJ_BOOL p_is_read_stream)
 {
     return opj_stream_create_file_stream(fname, OPJ_J2K_STREAM_CHUNK_SIZE, p_is_read_stream);
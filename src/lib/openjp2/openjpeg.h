@@ -498,9 +498,16 @@ typedef struct opj_cparameters {
     /** RSIZ value
         To be used to combine OPJ_PROFILE_*, OPJ_EXTENSION_* and (sub)levels values. */
     OPJ_UINT16 rsiz;
+    /** if != 0, a TLM marker gives the length of every tile-part in the main header
+        (always written for the Digital Cinema profiles) */
+    OPJ_BOOL tlm_on;
+    /** if != 0, PLT markers give the length of every packet in the header of each tile-part */
+    OPJ_BOOL plt_on;
 } opj_cparameters_t;  
 
 #define OPJ_DPARAMETERS_IGNORE_PCLR_CMAP_CDEF_FLAG	0x0001
+/** Store the decoded samples of components with a precision up to 16 bits in opj_image_comp_t::native_data (1 or 2 bytes per sample) instead of OPJ_INT32 data */
+#define OPJ_DPARAMETERS_NATIVE_SAMPLES_FLAG	0x0002
 
 /**
  * Decompression parameters
@@ -612,11 +619,110 @@ typedef OPJ_BOOL (* opj_stream_seek_fn) (OPJ_OFF_T p_nb_bytes, void * p_user_dat
  */
 typedef void (* opj_stream_free_user_data_fn) (void * p_user_data) ;
 
+/*
+ * Callback function prototype receiving the rows decoded by opj_decode_strips: p_nb_rows rows of p_width samples
+ * of the component p_compno, starting at its row p_row. Returning false stops the decoding.
+ */
+typedef OPJ_BOOL (* opj_decoded_strip_fn) (OPJ_UINT32 p_compno, OPJ_UINT32 p_row, OPJ_UINT32 p_nb_rows, OPJ_UINT32 p_width, const OPJ_INT32 * p_data, void * p_user_data) ;
+
+/**
+ * Samples of a component of a decoded tile, given to an opj_decoded_tile_fn callback
+ * */
+typedef struct opj_decoded_tile_comp {
+	/** horizontal position of the first sample, on the component grid reduced by the resolution factor */
+	OPJ_UINT32 x0;
+	/** vertical position of the first sample, on the component grid reduced by the resolution factor */
+	OPJ_UINT32 y0;
+	/** number of samples of a row */
+	OPJ_UINT32 w;
+	/** number of rows */
+	OPJ_UINT32 h;
+	/** number of samples between the beginnings of two rows */
+	OPJ_UINT32 stride;
+	/** resolution level the samples are decoded at */
+	OPJ_UINT32 resno_decoded;
+	/** samples, only valid during the call */
+	const OPJ_INT32 * data;
+} opj_decoded_tile_comp_t;
+
+/*
+ * Callback function prototype receiving each tile as soon as it is decoded (see opj_set_decoded_tile_handler):
+ * its index, its area on the reference grid and the samples of its p_nb_comps components.
+ * Returning false stops the decoding.
+ */
+typedef OPJ_BOOL (* opj_decoded_tile_fn) (OPJ_UINT32 p_tile_index,
+                                          OPJ_UINT32 p_tile_x0, OPJ_UINT32 p_tile_y0,
+                                          OPJ_UINT32 p_tile_x1, OPJ_UINT32 p_tile_y1,
+                                          OPJ_UINT32 p_nb_comps,
+                                          const opj_decoded_tile_comp_t * p_comps,
+                                          void * p_user_data) ;
+
+/**
+ * Report of a decoding done within a time budget (see opj_decode_within_budget)
+ * */
+typedef struct opj_decode_report {
+	/** resolution factor of the returned image */
+	OPJ_UINT32 reduce;
+	/** number of quality layers decoded */
+	OPJ_UINT32 layers;
+	/** number of decodings done, from the coarsest resolution to the finest one */
+	OPJ_UINT32 nb_steps;
+	/** true if the image was decoded at the requested resolution factor */
+	OPJ_BOOL complete;
+	/** time spent, in seconds */
+	OPJ_FLOAT64 time;
+} opj_decode_report_t;
+
+/**
+ * Transcoding parameters (see opj_transcode)
+ * */
+typedef struct opj_transcode_parameters {
+	/** progression order of the transcoded codestream, OPJ_PROG_UNKNOWN to keep the progression order of each tile */
+	OPJ_PROG_ORDER prog_order;
+	/** number of quality layers kept, 0 to keep them all */
+	OPJ_UINT32 max_layers;
+	/** number of highest resolution levels removed */
+	OPJ_UINT32 reduce;
+	/** 0 for one tile-part per tile, 'R', 'L' or 'C' to start a new tile-part when the resolution, layer or component changes */
+	char tp_flag;
+} opj_transcode_parameters_t;
+
 /*
  * JPEG2000 Stream.
  */
 typedef void * opj_stream_t;
 
+/* 
+==========================================================
+   memory allocator typedef definitions
+==========================================================
+*/
+
+/*
+ * Callback function prototype for the allocation function of a custom allocator
+ */
+typedef void * (* opj_malloc_fn) (OPJ_SIZE_T p_size, void * p_user_data) ;
+
+/*
+ * Callback function prototype for the reallocation function of a custom allocator
+ */
+typedef void * (* opj_realloc_fn) (void * p_ptr, OPJ_SIZE_T p_size, void * p_user_data) ;
+
+/*
+ * Callback function prototype for the deallocation function of a custom allocator
+ */
+typedef void (* opj_free_fn) (void * p_ptr, void * p_user_data) ;
+
+/*
+ * Callback function prototype for the aligned allocation function of a custom allocator
+ */
+typedef void * (* opj_aligned_malloc_fn) (OPJ_SIZE_T p_size, OPJ_SIZE_T p_alignment, void * p_user_data) ;
+
+/*
+ * Callback function prototype for the aligned deallocation function of a custom allocator
+ */
+typedef void (* opj_aligned_free_fn) (void * p_ptr, void * p_user_data) ;
+
 /* 
 ==========================================================
    image typedef definitions
@@ -653,6 +759,10 @@ typedef struct opj_image_comp {
 	OPJ_INT32 *data;
   /** alpha channel */
   OPJ_UINT16 alpha;
+	/** size in bytes of one sample of native_data (1 or 2), 0 if the samples are stored as OPJ_INT32 in data */
+	OPJ_UINT32 native_size;
+	/** image component data stored at its native width (OPJ_UINT8/OPJ_INT8 or OPJ_UINT16/OPJ_INT16 depending on sgnd), used instead of data when native_size != 0 */
+	void *native_data;
 } opj_image_comp_t;
 
 /** 
@@ -936,6 +1046,11 @@ typedef struct opj_codestream_info_v2 {
 	/** information regarding tiles inside image */
 	opj_tile_info_v2_t *tile_info; /* FIXME not used for the moment */
 
+	/** bytes currently allocated by the codec */
+	OPJ_SIZE_T mem_current;
+	/** highest number of bytes allocated by the codec at any time, image samples included */
+	OPJ_SIZE_T mem_peak;
+
 } opj_codestream_info_v2_t;
 
 
@@ -1011,6 +1126,75 @@ typedef struct opj_codestream_index {
 	opj_tile_index_t *tile_index; /* FIXME not used for the moment */
 
 }opj_codestream_index_t;
+
+/**
+ * Byte range of a packet in the file, see opj_get_packet_map
+ */
+typedef struct opj_packet_range {
+	/** tile, component, resolution, precinct and layer of the packet */
+	OPJ_UINT32 tileno;
+	OPJ_UINT32 compno;
+	OPJ_UINT32 resno;
+	OPJ_UINT32 precno;
+	OPJ_UINT32 layno;
+	/** position of the packet in the stream, from its SOP marker if any */
+	OPJ_OFF_T start_pos;
+	/** length of the packet, header and body, up to the next packet */
+	OPJ_UINT32 length;
+} opj_packet_range_t;
+
+/**
+ * Byte ranges of all the packets of a codestream, see opj_get_packet_map
+ */
+typedef struct opj_packet_map {
+	/** number of packets */
+	OPJ_UINT32 nb_packets;
+	/** the packets, by tile then in the order of the codestream */
+	opj_packet_range_t *packets;
+} opj_packet_map_t;
+
+/**
+ * Main characteristics of an image, see opj_probe
+ */
+typedef struct opj_probe_info {
+	/** OPJ_CODEC_J2K for a codestream, OPJ_CODEC_JP2 for a JP2 file */
+	OPJ_CODEC_FORMAT format;
+	/** profile and capabilities of the codestream (Rsiz) */
+	OPJ_UINT16 rsiz;
+	/** origin of the image area on the reference grid */
+	OPJ_UINT32 x0;
+	OPJ_UINT32 y0;
+	/** width and height of the image area on the reference grid */
+	OPJ_UINT32 width;
+	OPJ_UINT32 height;
+	/** number of components of the codestream */
+	OPJ_UINT32 numcomps;
+	/** precision, signedness and subsampling of the first component */
+	OPJ_UINT32 prec;
+	OPJ_UINT32 sgnd;
+	OPJ_UINT32 dx;
+	OPJ_UINT32 dy;
+	/** 1 if the other components do not all have the precision, signedness and subsampling of the first one */
+	OPJ_UINT32 mixed_comps;
+	/** origin of the first tile, size of the tiles and number of tiles in width and height */
+	OPJ_UINT32 tx0;
+	OPJ_UINT32 ty0;
+	OPJ_UINT32 tdx;
+	OPJ_UINT32 tdy;
+	OPJ_UINT32 tw;
+	OPJ_UINT32 th;
+	/** number of resolutions (decomposition levels + 1) of the default coding style */
+	OPJ_UINT32 numresolutions;
+	/** number of quality layers and progression order of the default coding style */
+	OPJ_UINT32 numlayers;
+	OPJ_PROG_ORDER prog_order;
+	/** 1 if the default coding style uses the irreversible 9-7 wavelet */
+	OPJ_UINT32 irreversible;
+	/** colour space given by the colr box of a JP2 file, OPJ_CLRSPC_UNSPECIFIED for a codestream */
+	OPJ_COLOR_SPACE color_space;
+	/** 1 if the colr box of the JP2 file holds an ICC profile */
+	OPJ_UINT32 has_icc_profile;
+} opj_probe_info_t;
 /* -----------------------------------------------------------> */
 
 /*
@@ -1040,6 +1224,57 @@ typedef struct opj_jp2_index {
 } opj_jp2_index_t;
 
 
+/* 
+==========================================================
+   profiling typedef definitions
+==========================================================
+*/
+
+/**
+ * Stages timed by the profiler
+ */
+typedef enum PROFILE_STAGE {
+	OPJ_PROFILE_T2 = 0,		/**< packet coding (tier-2) */
+	OPJ_PROFILE_T1 = 1,		/**< code-block coding (tier-1) */
+	OPJ_PROFILE_DWT = 2,		/**< wavelet transform */
+	OPJ_PROFILE_MCT = 3,		/**< multi-component transform */
+	OPJ_PROFILE_DC_SHIFT = 4,	/**< DC level shift */
+	OPJ_PROFILE_IO = 5,		/**< reading and writing of the tile data on the stream */
+	OPJ_PROFILE_RATE = 6,		/**< rate allocation (encoder only) */
+	OPJ_PROFILE_NB_STAGES = 7	/**< number of stages */
+} OPJ_PROFILE_STAGE;
+
+/**
+ * Time spent in each stage and work counters, for a tile or for a whole codec
+ */
+typedef struct opj_profile_stats {
+	/** seconds spent in each stage, indexed by OPJ_PROFILE_STAGE */
+	OPJ_FLOAT64 times[OPJ_PROFILE_NB_STAGES];
+	/** number of code-blocks coded or decoded */
+	OPJ_UINT64 nb_code_blocks;
+	/** number of coding passes coded or decoded */
+	OPJ_UINT64 nb_passes;
+	/** number of symbols coded or decoded by the MQ coder, 0 unless the library is built with OPJ_PROFILE_MQ_SYMBOLS */
+	OPJ_UINT64 nb_mq_symbols;
+	/** number of bytes of tile data read from the stream (decoder) */
+	OPJ_UINT64 nb_bytes_read;
+	/** number of bytes of code-block data copied from (decoder) or to (encoder) the packets */
+	OPJ_UINT64 nb_bytes_copied;
+} opj_profile_stats_t;
+
+/**
+ * Profile of a codec, accumulated since the profiling was enabled
+ */
+typedef struct opj_profile {
+	/** sum of the statistics of all the tiles */
+	opj_profile_stats_t total;
+	/** number of entries of tiles (highest tile index seen + 1) */
+	OPJ_UINT32 nb_tiles;
+	/** statistics of each tile, indexed by tile number */
+	opj_profile_stats_t * tiles;
+} opj_profile_t;
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -1054,6 +1289,37 @@ extern "C" {
 /* Get the version of the openjpeg library*/
 OPJ_API const char * OPJ_CALLCONV opj_version(void);
 
+/* 
+==========================================================
+   memory allocator functions definitions
+==========================================================
+*/
+
+/**
+ * Installs the functions used by the library to allocate its working memory.
+ * Must be called before any codec, stream or image is created, and not
+ * while one of them is still alive.
+ *
+ * The blocks handed over to the application (image samples, ICC profile,
+ * MCT data of opj_set_MCT) are always allocated with the C runtime, since
+ * the application may release them with free().
+ *
+ * @param p_malloc          allocation function, NULL restores the C runtime allocator
+ * @param p_realloc         reallocation function
+ * @param p_free            deallocation function
+ * @param p_aligned_malloc  aligned allocation function, NULL to align on top of p_malloc
+ * @param p_aligned_free    aligned deallocation function, NULL to use p_free
+ * @param p_user_data       user data given to the functions above
+ *
+ * @return OPJ_TRUE if the allocator was installed, OPJ_FALSE if the functions are inconsistent
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_allocator(opj_malloc_fn p_malloc,
+                                                opj_realloc_fn p_realloc,
+                                                opj_free_fn p_free,
+                                                opj_aligned_malloc_fn p_aligned_malloc,
+                                                opj_aligned_free_fn p_aligned_free,
+                                                void * p_user_data);
+
 /* 
 ==========================================================
    image functions definitions
@@ -1070,6 +1336,18 @@ OPJ_API const char * OPJ_CALLCONV opj_version(void);
  * */
 OPJ_API opj_image_t* OPJ_CALLCONV opj_image_create(OPJ_UINT32 numcmpts, opj_image_cmptparm_t *cmptparms, OPJ_COLOR_SPACE clrspc);
 
+/**
+ * Create an image whose components of precision up to 16 bits store their samples
+ * at their native width (1 or 2 bytes per sample) in opj_image_comp_t::native_data.
+ * Components of higher precision are stored as OPJ_INT32 in opj_image_comp_t::data.
+ *
+ * @param numcmpts      number of components
+ * @param cmptparms     components parameters
+ * @param clrspc        image color space
+ * @return returns      a new image structure if successful, returns NULL otherwise
+ * */
+OPJ_API opj_image_t* OPJ_CALLCONV opj_image_create_native(OPJ_UINT32 numcmpts, opj_image_cmptparm_t *cmptparms, OPJ_COLOR_SPACE clrspc);
+
 /**
  * Deallocate any resources associated with an image
  *
@@ -1275,6 +1553,64 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_read_header (	opj_stream_t *p_stream,
 												opj_codec_t *p_codec,
 												opj_image_t **p_image);
 
+/**
+ * Reads the main characteristics of an image without a decompressor: only the
+ * SIZ and COD marker segments of the main header and, for a JP2 file, the colr
+ * box are read, the other boxes and marker segments are skipped. Nothing is
+ * allocated. The stream is left after the COD marker segment, to be destroyed
+ * or rewound to its start before the image is decoded.
+ *
+ * @param	p_stream		the stream, at the start of a codestream or of a JP2 file.
+ * @param	p_info			the characteristics of the image.
+ *
+ * @return true if the stream starts with a valid codestream or JP2 header.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_probe(	opj_stream_t *p_stream,
+											opj_probe_info_t *p_info);
+
+/**
+ * Reads the main header of the next codestream (or JP2 file) to decode with a
+ * decompressor that already decoded one, as a replacement of opj_read_header.
+ * The per-image state of the codec is cleared, but the tile decoder, its
+ * code-block and scratch buffers and the tile coding parameters are kept and
+ * reused whenever the new codestream allows it (same image area, tiling,
+ * components and coding style), so that decoding a sequence of similar images
+ * (video frames, bursts) does not rebuild the decoder for each of them.
+ *
+ * The decoding parameters (opj_setup_decoder, opj_set_decoded_resolution_factor)
+ * stay in effect; a decode area has to be set again for the new image.
+ *
+ * @param	p_codec			the jpeg2000 codec to reset.
+ * @param	p_stream		the jpeg2000 stream holding the next codestream.
+ * @param	p_image			the image header of the next codestream, to destroy with opj_image_destroy.
+ *
+ * @return true if the main header of the codestream is correctly read.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decoder_reset(	opj_codec_t *p_codec,
+													opj_stream_t *p_stream,
+													opj_image_t **p_image);
+
+/**
+ * Creates a decompressor from another one whose header has been read by opj_read_header,
+ * without reading the header again. The clone copies the coding parameters, the codestream
+ * index, the decoding parameters, the decoded area and the event handlers of p_codec, and
+ * has its own tile decoder, so that several clones can decode different areas of the same
+ * file at the same time, one per thread.
+ *
+ * Each clone is given its own stream on the same file, which must be seekable: the
+ * decoding functions move it to the tile-parts they need. Clone p_codec before decoding
+ * with it, as a JP2 decompressor hands its colour information to the first decoded image.
+ * p_codec must not be used by another thread during the call.
+ *
+ * @param	p_codec			the decompressor to clone.
+ * @param	p_image			if not NULL, receives the image header for the clone,
+ *							to destroy with opj_image_destroy.
+ *
+ * @return the new decompressor, to destroy with opj_destroy_codec, NULL if it could not be created.
+ */
+OPJ_API opj_codec_t* OPJ_CALLCONV opj_codec_clone(	opj_codec_t *p_codec,
+													opj_image_t **p_image);
+
 /**
  * Sets the given area to be decoded. This function should be called right after opj_read_header and before any tile header reading.
  *
@@ -1304,6 +1640,103 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode(   opj_codec_t *p_decompressor,
                                             opj_stream_t *p_stream,
                                             opj_image_t *p_image);
 
+/**
+ * Decode a single-tile image from a JPEG-2000 codestream strip after strip, from the top of the image to its bottom.
+ * The rows of each strip are given to p_strip_fn as soon as they are decoded, component after component, and are not
+ * stored in p_image : only the code-blocks the rows of a strip depend on are decoded, and the inverse wavelet transform
+ * only keeps the rows needed by the next strips, so that the whole image never needs to be held in memory.
+ * Decoding areas are not supported, and the colour boxes of a JP2 file (palette, channel definitions) are not applied.
+ *
+ * @param p_decompressor 	decompressor handle
+ * @param p_stream			Input buffer stream
+ * @param p_image 			the image previously set by opj_read_header
+ * @param p_strip_height	the number of rows of the reference grid of each strip. Each component gives the rows that fall
+ *							within them, at the resolution decoded.
+ * @param p_strip_fn		function receiving the decoded rows
+ * @param p_user_data		user data given to p_strip_fn
+ * @return 					true if success, otherwise false
+ * */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode_strips(   opj_codec_t *p_decompressor,
+                                                   opj_stream_t *p_stream,
+                                                   opj_image_t *p_image,
+                                                   OPJ_UINT32 p_strip_height,
+                                                   opj_decoded_strip_fn p_strip_fn,
+                                                   void * p_user_data);
+
+/**
+ * Decode an image within a time budget, returning the best image that could be decoded in it.
+ * The image is decoded at the coarsest resolution of the codestream first, then at finer and finer resolutions
+ * up to the resolution factor set by opj_set_decoded_resolution_factor, with the quality layers set by the
+ * decompression parameters. A finer decoding is only started when it is expected to fit in the remaining time,
+ * and is given up, keeping the previous one, when the time runs out while it decodes; the time is checked after
+ * each tile. The coarsest decoding is always done whatever the budget.
+ * The components of the returned image have the resolution factor given in p_report: to decode the image again
+ * with opj_decode, set this resolution factor with opj_set_decoded_resolution_factor first.
+ *
+ * @param p_decompressor 	decompressor handle
+ * @param p_stream			Input buffer stream
+ * @param p_image 			the image previously set by opj_read_header (and opj_set_decode_area)
+ * @param p_max_time		the time budget, in seconds
+ * @param p_report			if not NULL, filled with what was decoded
+ * @return 					true if success, otherwise false
+ * */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode_within_budget(   opj_codec_t *p_decompressor,
+                                                          opj_stream_t *p_stream,
+                                                          opj_image_t *p_image,
+                                                          OPJ_FLOAT64 p_max_time,
+                                                          opj_decode_report_t * p_report);
+
+/**
+ * Decode the part of a codestream received so far, as its bytes arrive.
+ * Call it each time new bytes are received, with a stream holding all the bytes received since the beginning of
+ * the file: the image read by opj_read_header is updated with the tiles whose samples changed. Only the packets
+ * received since the previous call are read, and only the code-blocks they bring new coding passes to are decoded
+ * again; the other code-blocks keep their coefficients from one call to the next one.
+ * The stream must be able to seek, and the decoding parameters must not change between two calls. The decoded tile
+ * function, the cache of decoded tiles and the native samples are not used, and the codestream must give the length
+ * of its tile-parts and must not use packed packet headers (PPM or PPT markers). The colour boxes of a JP2 file are
+ * applied once the whole codestream is decoded. After a failure, the next call decodes again from the first tile-part.
+ *
+ * @param p_decompressor 	decompressor handle
+ * @param p_stream			Input stream holding the bytes received so far
+ * @param p_image 			the image previously set by opj_read_header (and opj_set_decode_area)
+ * @param p_complete		set to true once the whole codestream has been received and decoded
+ * @return 					true if success, otherwise false
+ * */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode_incremental(   opj_codec_t *p_decompressor,
+                                                        opj_stream_t *p_stream,
+                                                        opj_image_t *p_image,
+                                                        OPJ_BOOL *p_complete);
+
+/**
+ * Set the transcoding parameters to their default values: the codestream is copied with all its
+ * progression orders, quality layers and resolution levels.
+ *
+ * @param parameters Transcoding parameters
+ */
+OPJ_API void OPJ_CALLCONV opj_set_default_transcode_parameters(opj_transcode_parameters_t *parameters);
+
+/**
+ * Write the codestream read by opj_read_header with another progression order, fewer quality layers, fewer
+ * resolution levels or another tile-part layout, without decoding it: only the packet headers are read, and the
+ * packets kept are copied byte for byte in their new order.
+ * The output is a JPEG 2000 codestream (J2K) whatever the input format. Each tile is written in one go, with
+ * its tile-parts in a row. The POC, TLM and PLT/PLM markers are not written: with a kept progression order, each
+ * tile follows the progression order of its COD marker. The codestream must not use packed packet headers (PPM or
+ * PPT markers), and the input stream must be able to seek. The tile-parts are read as opj_decode reads them: to
+ * decode or transcode the codestream afterwards, call opj_decoder_reset and opj_read_header again.
+ *
+ * @param p_decompressor 	decompressor handle
+ * @param p_input			Input stream, the one given to opj_read_header
+ * @param p_output			Output stream receiving the transcoded codestream
+ * @param p_parameters		transcoding parameters
+ * @return 					true if success, otherwise false
+ * */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_transcode(    opj_codec_t *p_decompressor,
+                                                opj_stream_t *p_input,
+                                                opj_stream_t *p_output,
+                                                const opj_transcode_parameters_t *p_parameters);
+
 /**
  * Get the decoded tile from the codec
  *
@@ -1328,6 +1761,61 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_get_decoded_tile(	opj_codec_t *p_codec,
  */
 OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_decoded_resolution_factor(opj_codec_t *p_codec, OPJ_UINT32 res_factor);
 
+/**
+ * Set the function called with the samples of each tile as soon as it is decoded
+ * by opj_decode or opj_get_decoded_tile, before the next tile is read.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_tile_fn		function called for each decoded tile, NULL to remove it.
+ * @param	p_user_data		client object passed to p_tile_fn.
+ * @param	p_skip_image	if true, the tiles are only given to p_tile_fn: the image is
+ *							not built and its components are left without data. The JP2
+ *							palette and channel definitions are not applied either.
+ *
+ * @return					true if success, otherwise false
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_decoded_tile_handler(	opj_codec_t *p_codec,
+															opj_decoded_tile_fn p_tile_fn,
+															void * p_user_data,
+															OPJ_BOOL p_skip_image);
+
+/**
+ * Keep the decoded tiles, up to the given number of bytes, so that the tiles needed again
+ * by a later opj_decode or opj_get_decoded_tile with the same resolution factor and number
+ * of layers are not decoded again. The least recently used tiles are dropped first.
+ *
+ * After a first opj_decode, opj_set_decode_area and opj_decode may be called again with the
+ * same stream, which must be seekable, to decode other areas of the image. The samples of
+ * the previous decoding held by the image are then freed.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_max_size		maximum number of bytes kept, 0 to disable the cache.
+ *
+ * @return					true if success, otherwise false
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_tile_cache(	opj_codec_t *p_codec,
+													OPJ_SIZE_T p_max_size);
+
+/**
+ * Restrict the decoding to some components of the codestream, to be called after opj_read_header.
+ * The packets of the other components are skipped and their code-blocks are not decoded, except
+ * for the components that a multiple component transform needs to rebuild the selected ones.
+ *
+ * The image decoded by opj_decode or opj_get_decoded_tile then only holds the selected components,
+ * in the order of the codestream, and must be read again by opj_read_header to decode other
+ * components. The decoded tiles and strips are only given for the selected components. The JP2
+ * palette, channel definitions and colour space are not applied to such an image.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	numcomps		number of components to decode, 0 to decode all of them.
+ * @param	comps_indices	indices of the components to decode (numcomps values, each at most once).
+ *
+ * @return					true if success, otherwise false
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_decoded_components(	opj_codec_t *p_codec,
+															OPJ_UINT32 numcomps,
+															const OPJ_UINT32 * comps_indices);
+
 /**
  * Writes a tile with the given data.
  *
@@ -1342,8 +1830,30 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_decoded_resolution_factor(opj_codec_t *p_c
  */
 OPJ_API OPJ_BOOL OPJ_CALLCONV opj_write_tile (	opj_codec_t *p_codec,
 												OPJ_UINT32 p_tile_index,
+												OPJ_BYTE * p_data,
+												OPJ_SIZE_T p_data_size,
+												opj_stream_t *p_stream );
+
+/**
+ * Writes the next horizontal strip of the image. Strips must be given from the top of the image to its bottom;
+ * a row of tiles is compressed and written as soon as the strips covering it have been received, so that only
+ * one row of tiles has to be kept in memory. The image given to opj_start_compress does not need to hold any data.
+ *
+ * @param	p_codec		        the jpeg2000 codec.
+ * @param	p_data				pointer to the data to write. Data is arranged in sequence, data_comp0, then data_comp1, then ... NO INTERLEAVING should be set.
+ *                              For each component, the strip holds the full width rows of the component that fall within the p_nb_rows
+ *                              next rows of the reference grid.
+ * @param	p_data_size			this value is used to make sure the data being written is correct. The size must be equal to the sum for each component of
+ *                              component_width * component_rows * component_size. component_size can be 1,2 or 4 bytes, depending on the precision of the given component.
+ * @param	p_nb_rows			the number of rows of the reference grid covered by the strip.
+ * @param	p_stream			the stream to write data to.
+ *
+ * @return	true if the data could be written.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_write_strip (	opj_codec_t *p_codec,
 												OPJ_BYTE * p_data,
 												OPJ_UINT32 p_data_size,
+												OPJ_UINT32 p_nb_rows,
 												opj_stream_t *p_stream );
 
 /**
@@ -1370,7 +1880,7 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_write_tile (	opj_codec_t *p_codec,
 OPJ_API OPJ_BOOL OPJ_CALLCONV opj_read_tile_header(	opj_codec_t *p_codec,
 												opj_stream_t * p_stream,
 												OPJ_UINT32 * p_tile_index,
-												OPJ_UINT32 * p_data_size,
+												OPJ_SIZE_T * p_data_size,
 												OPJ_INT32 * p_tile_x0, OPJ_INT32 * p_tile_y0,
 												OPJ_INT32 * p_tile_x1, OPJ_INT32 * p_tile_y1,
 												OPJ_UINT32 * p_nb_comps,
@@ -1391,7 +1901,7 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_read_tile_header(	opj_codec_t *p_codec,
 OPJ_API OPJ_BOOL OPJ_CALLCONV opj_decode_tile_data(	opj_codec_t *p_codec,
 													OPJ_UINT32 p_tile_index,
 													OPJ_BYTE * p_data,
-													OPJ_UINT32 p_data_size,
+													OPJ_SIZE_T p_data_size,
 													opj_stream_t *p_stream );
 
 /* COMPRESSION FUNCTIONS*/
@@ -1454,6 +1964,28 @@ OPJ_API OPJ_BOOL OPJ_CALLCONV opj_start_compress (	opj_codec_t *p_codec,
 OPJ_API OPJ_BOOL OPJ_CALLCONV opj_end_compress (opj_codec_t *p_codec,
 												opj_stream_t *p_stream);
 
+/**
+ * Starts to compress the next frame of a sequence. The coding parameters, the tile
+ * structures and the encoding buffers of the previous frame are kept, so that
+ * opj_setup_encoder and opj_start_compress are not needed for each frame.
+ * The frame must have the same size, components, precision and signedness as the
+ * previous one. If no frame was compressed yet, this is opj_start_compress.
+ * The frame is then compressed with opj_encode and opj_end_compress.
+ * Once this function is used, opj_end_compress keeps the tile structures and the
+ * buffers for the next frame and they are freed with the codec: start the
+ * sequence with it rather than with opj_start_compress to reuse them from the
+ * first frame on.
+ *
+ * @param p_codec 		Compressor handle
+ * @param p_image 	    Input filled image
+ * @param p_stream 		Output stream of the frame
+ *
+ * @return OPJ_TRUE if the header of the frame was written.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_encoder_next_frame (	opj_codec_t *p_codec,
+														opj_image_t * p_image,
+														opj_stream_t *p_stream);
+
 /**
  * Encode an image into a JPEG-2000 codestream
  * @param p_codec 		compressor handle
@@ -1511,6 +2043,98 @@ OPJ_API opj_codestream_index_t * OPJ_CALLCONV opj_get_cstr_index(opj_codec_t *p_
 
 OPJ_API void OPJ_CALLCONV opj_destroy_cstr_index(opj_codestream_index_t **p_cstr_index);
 
+/**
+ * Get the position and length in the stream of every packet of the codestream read by opj_read_header, with
+ * its tile, component, resolution, precinct and layer, so that the packets needed for an area, a resolution
+ * or a quality can be fetched by byte ranges. Only the packet headers are read, none of the code-blocks is
+ * decoded. The codestream must not use packed packet headers (PPM or PPT markers), and the stream must be
+ * able to seek. The tile-parts are read as opj_decode reads them: to decode the codestream afterwards, call
+ * opj_decoder_reset and opj_read_header again.
+ *
+ * @param	p_decompressor	decompressor handle
+ * @param	p_stream		the stream given to opj_read_header
+ * @param	p_packet_map	set to the packet map, to destroy with opj_destroy_packet_map
+ *
+ * @return					true if success, otherwise false
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_get_packet_map(	opj_codec_t *p_decompressor,
+													opj_stream_t *p_stream,
+													opj_packet_map_t **p_packet_map);
+
+/**
+ * Destroy a packet map got with opj_get_packet_map
+ *
+ * @param	p_packet_map	the packet map, set to NULL
+ */
+OPJ_API void OPJ_CALLCONV opj_destroy_packet_map(opj_packet_map_t **p_packet_map);
+
+/**
+ * Get the memory used by the codec. Every allocation made by the library on
+ * behalf of the codec is accounted, from its creation on. The blocks handed
+ * over to the application (image samples, ICC profile, see opj_set_allocator)
+ * count in the peak of the call that allocates them, but not in the current
+ * size as the application releases them.
+ *
+ * The accounting belongs to the codec and is not synchronized: a codec must
+ * be used by one thread at a time, clones (opj_codec_clone) have their own.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_current		bytes currently allocated by the codec (may be NULL).
+ * @param	p_peak			highest number of bytes allocated by the codec at any time (may be NULL).
+ *
+ * @return					true if the codec is valid.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_get_memory_usage(	opj_codec_t *p_codec,
+													OPJ_SIZE_T * p_current,
+													OPJ_SIZE_T * p_peak);
+
+/**
+ * Limits the memory the codec may allocate. Once the limit is reached the
+ * allocations of the codec fail and the current operation (decoding,
+ * encoding, ...) returns an error. The image samples allocated by the
+ * operation count toward the limit. As the accounting, the limit is per codec.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_max_bytes		maximum number of bytes, 0 to remove the limit.
+ *
+ * @return					true if the codec is valid.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_memory_limit(	opj_codec_t *p_codec,
+													OPJ_SIZE_T p_max_bytes);
+
+/**
+ * Enables or disables the profiling of the codec. When enabled, the time spent
+ * in each stage of the coding of every tile and a few work counters are
+ * accumulated until the profiling is disabled. Enabling it again restarts
+ * the accumulation from zero.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	p_enable		OPJ_TRUE to enable the profiling, OPJ_FALSE to disable it.
+ *
+ * @return					true if the codec is valid and the profile could be allocated.
+ */
+OPJ_API OPJ_BOOL OPJ_CALLCONV opj_set_profiling(	opj_codec_t *p_codec,
+												OPJ_BOOL p_enable);
+
+/**
+ * Get the profile of the codec. The structure belongs to the codec, it stays
+ * valid until the profiling is disabled or the codec is destroyed.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ *
+ * @return					the profile, NULL if the profiling is not enabled.
+ */
+OPJ_API const opj_profile_t * OPJ_CALLCONV opj_get_profile(opj_codec_t *p_codec);
+
+/**
+ * Dump the profile of the codec into the output stream
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	output_stream	output stream where the profile is written.
+ */
+OPJ_API void OPJ_CALLCONV opj_dump_profile(	opj_codec_t *p_codec,
+											FILE* output_stream);
+
 
 /**
  * Get the JP2 file information from the codec FIXME
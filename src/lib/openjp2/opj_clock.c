@@ -35,6 +35,7 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <sys/times.h>
+#include <time.h>
 #endif /* _WIN32 */
 #include "opj_includes.h"
 
@@ -48,6 +49,12 @@ OPJ_FLOAT64 opj_clock(void) {
     /* t is the high resolution performance counter (see MSDN) */
     QueryPerformanceCounter ( & t ) ;
     return ( t.QuadPart /(OPJ_FLOAT64) freq.QuadPart ) ;
+#elif defined(CLOCK_MONOTONIC)
+	/* POSIX: use the monotonic clock, like QueryPerformanceCounter it measures */
+	/* the elapsed time, including the time spent waiting for I/O */
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (OPJ_FLOAT64)t.tv_sec + (OPJ_FLOAT64)t.tv_nsec * 1e-9;
 #else
 	/* Unix or Linux: use resource usage */
     struct rusage t;
@@ -61,10 +61,47 @@ typedef struct opj_codec_private
                                      opj_image_t * p_image,
                                      struct opj_event_mgr * p_manager);
 
+            /** Strip decoding function */
+            OPJ_BOOL (*opj_decode_strips) ( void * p_codec,
+                                            struct opj_stream_private * p_cio,
+                                            opj_image_t * p_image,
+                                            OPJ_UINT32 p_strip_height,
+                                            opj_decoded_strip_fn p_strip_fn,
+                                            void * p_user_data,
+                                            struct opj_event_mgr * p_manager);
+
+            /** Decoding function bounded by a time budget */
+            OPJ_BOOL (*opj_decode_within_budget) ( void * p_codec,
+                                                   struct opj_stream_private * p_cio,
+                                                   opj_image_t * p_image,
+                                                   OPJ_FLOAT64 p_max_time,
+                                                   opj_decode_report_t * p_report,
+                                                   struct opj_event_mgr * p_manager);
+
+            /** Decoding function of the part of a codestream received so far */
+            OPJ_BOOL (*opj_decode_incremental) ( void * p_codec,
+                                                 struct opj_stream_private * p_cio,
+                                                 opj_image_t * p_image,
+                                                 OPJ_BOOL * p_complete,
+                                                 struct opj_event_mgr * p_manager);
+
+            /** Transcoding function of the codestream, without decoding it */
+            OPJ_BOOL (*opj_transcode) ( void * p_codec,
+                                        struct opj_stream_private * p_input,
+                                        struct opj_stream_private * p_output,
+                                        const opj_transcode_parameters_t * p_parameters,
+                                        struct opj_event_mgr * p_manager);
+
+            /** Packet mapping function of the codestream, without decoding it */
+            OPJ_BOOL (*opj_get_packet_map) ( void * p_codec,
+                                             struct opj_stream_private * p_cio,
+                                             opj_packet_map_t ** p_packet_map,
+                                             struct opj_event_mgr * p_manager);
+
             /** FIXME DOC */
             OPJ_BOOL (*opj_read_tile_header)( void * p_codec,
                                               OPJ_UINT32 * p_tile_index,
-                                              OPJ_UINT32 * p_data_size,
+                                              OPJ_SIZE_T * p_data_size,
                                               OPJ_INT32 * p_tile_x0,
                                               OPJ_INT32 * p_tile_y0,
                                               OPJ_INT32 * p_tile_x1,
@@ -78,7 +115,7 @@ typedef struct opj_codec_private
             OPJ_BOOL (*opj_decode_tile_data)( void * p_codec,
                                               OPJ_UINT32 p_tile_index,
                                               OPJ_BYTE * p_data,
-                                              OPJ_UINT32 p_data_size,
+                                              OPJ_SIZE_T p_data_size,
                                               struct opj_stream_private * p_cio,
                                               struct opj_event_mgr * p_manager);
 
@@ -113,6 +150,32 @@ typedef struct opj_codec_private
             OPJ_BOOL (*opj_set_decoded_resolution_factor) ( void * p_codec,
                                                             OPJ_UINT32 res_factor,
                                                             opj_event_mgr_t * p_manager);
+
+            /** Set the decoded tile function */
+            void (*opj_set_decoded_tile_handler) ( void * p_codec,
+                                                   opj_decoded_tile_fn p_tile_fn,
+                                                   void * p_user_data,
+                                                   OPJ_BOOL p_skip_image);
+
+            /** Set the budget of the cache of decoded tiles */
+            OPJ_BOOL (*opj_set_tile_cache) ( void * p_codec,
+                                             OPJ_SIZE_T p_max_size,
+                                             struct opj_event_mgr * p_manager);
+
+            /** Set the components to decode */
+            OPJ_BOOL (*opj_set_decoded_components) ( void * p_codec,
+                                                     OPJ_UINT32 numcomps,
+                                                     const OPJ_UINT32 * comps_indices,
+                                                     struct opj_event_mgr * p_manager);
+
+            /** Reset function handler, to decode another codestream with the same codec */
+            OPJ_BOOL (*opj_decoder_reset) ( void * p_codec,
+                                            struct opj_event_mgr * p_manager);
+
+            /** Clone function handler, to decode the same codestream from another stream */
+            void * (*opj_clone) ( void * p_codec,
+                                  opj_image_t ** p_image,
+                                  struct opj_event_mgr * p_manager);
         } m_decompression;
 
         /**
@@ -132,10 +195,17 @@ typedef struct opj_codec_private
             OPJ_BOOL (* opj_write_tile) ( void * p_codec,
                                           OPJ_UINT32 p_tile_index,
                                           OPJ_BYTE * p_data,
-                                          OPJ_UINT32 p_data_size,
+                                          OPJ_SIZE_T p_data_size,
                                           struct opj_stream_private * p_cio,
                                           struct opj_event_mgr * p_manager);
 
+            OPJ_BOOL (* opj_write_strip) ( void * p_codec,
+                                           OPJ_BYTE * p_data,
+                                           OPJ_UINT32 p_data_size,
+                                           OPJ_UINT32 p_nb_rows,
+                                           struct opj_stream_private * p_cio,
+                                           struct opj_event_mgr * p_manager);
+
             OPJ_BOOL (* opj_end_compress) (	void * p_codec,
                                             struct opj_stream_private * p_cio,
                                             struct opj_event_mgr * p_manager);
@@ -146,6 +216,12 @@ typedef struct opj_codec_private
                                              opj_cparameters_t * p_param,
                                              struct opj_image * p_image,
                                              struct opj_event_mgr * p_manager);
+
+            /** Next frame function handler, to encode another image with the same setup */
+            OPJ_BOOL (* opj_encoder_next_frame) ( void *p_codec,
+                                                  struct opj_stream_private * cio,
+                                                  struct opj_image * p_image,
+                                                  struct opj_event_mgr * p_manager);
         } m_compression;
     } m_codec_data;
     /** FIXME DOC*/
@@ -157,6 +233,11 @@ typedef struct opj_codec_private
     void (*opj_dump_codec) (void * p_codec, OPJ_INT32 info_flag, FILE* output_stream);
     opj_codestream_info_v2_t* (*opj_get_codec_info)(void* p_codec);
     opj_codestream_index_t* (*opj_get_codec_index)(void* p_codec);
+    void (*opj_set_profile)(void * p_codec, opj_profile_t * p_profile);
+    /** Profile of the codec, NULL when the profiling is disabled */
+    opj_profile_t * m_profile;
+    /** Memory accounting of the codec */
+    opj_mem_stats_t * m_mem_stats;
 }
 opj_codec_private_t;
 
@@ -174,6 +174,8 @@ static INLINE long opj_lrintf(float f) {
 
 #include "opj_inttypes.h"
 #include "opj_clock.h"
+#include "opj_profile.h"
+#include "opj_tile_cache.h"
 #include "opj_malloc.h"
 #include "event.h"
 #include "function_list.h"
@@ -90,6 +90,38 @@ static INLINE OPJ_UINT32 opj_uint_adds(OPJ_UINT32 a, OPJ_UINT32 b) {
 	return (OPJ_UINT32)(-(OPJ_INT32)(sum >> 32)) | (OPJ_UINT32)sum;
 }
 
+/**
+Get the minimum of two sizes
+@return Returns a if a < b else b
+*/
+static INLINE OPJ_SIZE_T opj_size_min(OPJ_SIZE_T a, OPJ_SIZE_T b) {
+	return a < b ? a : b;
+}
+
+/**
+Get the maximum of two sizes
+@return Returns a if a > b else b
+*/
+static INLINE OPJ_SIZE_T opj_size_max(OPJ_SIZE_T a, OPJ_SIZE_T b) {
+	return a > b ? a : b;
+}
+
+/**
+ Get the saturated sum of two sizes, a size which does not fit in memory being (OPJ_SIZE_T)-1
+ @return Returns saturated sum of a+b
+ */
+static INLINE OPJ_SIZE_T opj_size_adds(OPJ_SIZE_T a, OPJ_SIZE_T b) {
+	return (a > (OPJ_SIZE_T)-1 - b) ? (OPJ_SIZE_T)-1 : a + b;
+}
+
+/**
+ Get the saturated product of two sizes, a size which does not fit in memory being (OPJ_SIZE_T)-1
+ @return Returns saturated product of a*b
+ */
+static INLINE OPJ_SIZE_T opj_size_muls(OPJ_SIZE_T a, OPJ_SIZE_T b) {
+	return (b != 0 && a > (OPJ_SIZE_T)-1 / b) ? (OPJ_SIZE_T)-1 : a * b;
+}
+
 /**
 Clamp an integer inside an interval
 @return
@@ -184,8 +216,8 @@ Multiply two fixed-precision rational numbers.
 @return Returns a * b
 */
 static INLINE OPJ_INT32 opj_int_fix_mul(OPJ_INT32 a, OPJ_INT32 b) {
-#if defined(_MSC_VER) && (_MSC_VER >= 1400) && !defined(__INTEL_COMPILER) && defined(_M_IX86)
-	OPJ_INT64 temp = __emul(a, b);
+#if defined(_MSC_VER) && (_MSC_VER >= 1400) && !defined(__INTEL_COMPILER) && defined(_M_IX86)
+	OPJ_INT64 temp = __emul(a, b);
 #else
 	OPJ_INT64 temp = (OPJ_INT64) a * (OPJ_INT64) b ;
 #endif
@@ -196,8 +228,8 @@ static INLINE OPJ_INT32 opj_int_fix_mul(OPJ_INT32 a, OPJ_INT32 b) {
 }
 
 static INLINE OPJ_INT32 opj_int_fix_mul_t1(OPJ_INT32 a, OPJ_INT32 b) {
-#if defined(_MSC_VER) && (_MSC_VER >= 1400) && !defined(__INTEL_COMPILER) && defined(_M_IX86)
-	OPJ_INT64 temp = __emul(a, b);
+#if defined(_MSC_VER) && (_MSC_VER >= 1400) && !defined(__INTEL_COMPILER) && defined(_M_IX86)
+	OPJ_INT64 temp = __emul(a, b);
 #else
 	OPJ_INT64 temp = (OPJ_INT64) a * (OPJ_INT64) b ;
 #endif
@@ -0,0 +1,591 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * Copyright (c) 2005, Herve Drolon, FreeImage Team
+ * Copyright (c) 2007, Callum Lerwick <seg@haxxed.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#define OPJ_SKIP_POISON
+#include "opj_includes.h"
+
+/* FIXME: These should be set with cmake tests, but we're currently not requiring use of cmake */
+#ifdef _WIN32
+	/* Someone should tell the mingw people that their malloc.h ought to provide _mm_malloc() */
+	#ifdef __GNUC__
+		#include <mm_malloc.h>
+		#define HAVE_MM_MALLOC
+	#else /* MSVC, Intel C++ */
+		#include <malloc.h>
+		#ifdef _mm_malloc
+			#define HAVE_MM_MALLOC
+		#endif
+	#endif
+#else /* Not _WIN32 */
+	#if defined(__sun)
+		#define HAVE_MEMALIGN
+	#elif defined(__FreeBSD__)
+		#define HAVE_POSIX_MEMALIGN
+	/* Linux x86_64 and OSX always align allocations to 16 bytes */
+	#elif !defined(__amd64__) && !defined(__APPLE__) && !defined(_AIX)
+		#define HAVE_MEMALIGN
+		#include <malloc.h>
+	#endif
+#endif
+
+#ifdef HAVE_MEMALIGN
+	extern void* memalign(size_t, size_t);
+#endif
+#ifdef HAVE_POSIX_MEMALIGN
+	extern int posix_memalign(void**, size_t, size_t);
+#endif
+
+/* Accounting in use by the calling thread */
+#if defined(_MSC_VER)
+	#define OPJ_MEM_TLS __declspec(thread)
+#elif defined(__GNUC__)
+	#define OPJ_MEM_TLS __thread
+#else
+	#define OPJ_MEM_TLS
+#endif
+
+/**
+ * Header stored in front of every block returned by opj_malloc and friends.
+ */
+typedef struct opj_mem_header
+{
+	/** size requested by the caller */
+	OPJ_SIZE_T m_size;
+	/** accounting the block is charged to, NULL if none */
+	opj_mem_stats_t * m_stats;
+	/** address returned by the underlying allocator */
+	void * m_base;
+}
+opj_mem_header_t;
+
+/** Size of the header, rounded so that the blocks keep the alignment of the underlying allocator */
+#define OPJ_MEM_HEADER_SIZE ((sizeof(opj_mem_header_t) + 15U) & ~(OPJ_SIZE_T)15U)
+
+/** Largest block size the allocator accepts */
+#define OPJ_MEM_MAX_SIZE ((OPJ_SIZE_T)-1 - OPJ_MEM_HEADER_SIZE - 16U)
+
+static opj_malloc_fn opj_mem_malloc_fn = 00;
+static opj_realloc_fn opj_mem_realloc_fn = 00;
+static opj_free_fn opj_mem_free_fn = 00;
+static opj_aligned_malloc_fn opj_mem_aligned_malloc_fn = 00;
+static opj_aligned_free_fn opj_mem_aligned_free_fn = 00;
+static void * opj_mem_user_data = 00;
+
+static OPJ_MEM_TLS opj_mem_stats_t * opj_mem_current_stats = 00;
+
+/* ----------------------------------------------------------------------- */
+
+static void * opj_mem_raw_malloc(OPJ_SIZE_T p_size)
+{
+	if (opj_mem_malloc_fn) {
+		return opj_mem_malloc_fn(p_size, opj_mem_user_data);
+	}
+	return malloc(p_size);
+}
+
+static void * opj_mem_raw_calloc(OPJ_SIZE_T p_size)
+{
+	void * l_ptr;
+
+	if (! opj_mem_malloc_fn) {
+		return calloc(1, p_size);
+	}
+
+	l_ptr = opj_mem_malloc_fn(p_size, opj_mem_user_data);
+	if (l_ptr) {
+		memset(l_ptr, 0, p_size);
+	}
+	return l_ptr;
+}
+
+static void * opj_mem_raw_realloc(void * p_ptr, OPJ_SIZE_T p_size)
+{
+	if (opj_mem_realloc_fn) {
+		return opj_mem_realloc_fn(p_ptr, p_size, opj_mem_user_data);
+	}
+	return realloc(p_ptr, p_size);
+}
+
+static void opj_mem_raw_free(void * p_ptr)
+{
+	if (opj_mem_free_fn) {
+		opj_mem_free_fn(p_ptr, opj_mem_user_data);
+	}
+	else {
+		free(p_ptr);
+	}
+}
+
+static void * opj_mem_default_aligned_malloc(OPJ_SIZE_T p_size)
+{
+#if defined(HAVE_MM_MALLOC)
+	return _mm_malloc(p_size, 16);
+#elif defined(HAVE_MEMALIGN)
+	return memalign(16, p_size);
+#elif defined(HAVE_POSIX_MEMALIGN)
+	void* l_mem = NULL;
+	if (posix_memalign(&l_mem, 16, p_size)) {
+		return NULL;
+	}
+	return l_mem;
+#else
+	return malloc(p_size);
+#endif
+}
+
+static void opj_mem_default_aligned_free(void * p_ptr)
+{
+#if defined(HAVE_MM_MALLOC)
+	_mm_free(p_ptr);
+#else
+	free(p_ptr);
+#endif
+}
+
+/* ----------------------------------------------------------------------- */
+
+static OPJ_BOOL opj_mem_check_limit(const opj_mem_stats_t * p_stats, OPJ_SIZE_T p_size)
+{
+	OPJ_SIZE_T l_used = p_stats->m_current + p_stats->m_image_data;
+
+	return ! p_stats->m_limit || (p_size <= p_stats->m_limit && l_used <= p_stats->m_limit - p_size);
+}
+
+static void opj_mem_update_peak(opj_mem_stats_t * p_stats)
+{
+	OPJ_SIZE_T l_used = p_stats->m_current + p_stats->m_image_data;
+
+	if (l_used > p_stats->m_peak) {
+		p_stats->m_peak = l_used;
+	}
+}
+
+static OPJ_BOOL opj_mem_charge(opj_mem_stats_t * p_stats, OPJ_SIZE_T p_size)
+{
+	if (! p_stats) {
+		return OPJ_TRUE;
+	}
+
+	if (! opj_mem_check_limit(p_stats, p_size)) {
+		return OPJ_FALSE;
+	}
+
+	p_stats->m_current += p_size;
+	opj_mem_update_peak(p_stats);
+	return OPJ_TRUE;
+}
+
+static void opj_mem_credit(opj_mem_stats_t * p_stats, OPJ_SIZE_T p_size)
+{
+	if (p_stats) {
+		p_stats->m_current -= p_size;
+	}
+}
+
+static void opj_mem_stats_destroy(opj_mem_stats_t * p_stats)
+{
+	opj_mem_raw_free(p_stats->m_image_blocks);
+	opj_mem_raw_free(p_stats);
+}
+
+static void opj_mem_stats_remove_block(opj_mem_stats_t * p_stats)
+{
+	if (p_stats) {
+		--p_stats->m_nb_blocks;
+		if (p_stats->m_orphaned && p_stats->m_nb_blocks == 0) {
+			opj_mem_stats_destroy(p_stats);
+		}
+	}
+}
+
+static void * opj_mem_init_block(void * p_base, void * p_ptr, OPJ_SIZE_T p_size, opj_mem_stats_t * p_stats)
+{
+	opj_mem_header_t * l_header = (opj_mem_header_t *) ((OPJ_BYTE *) p_ptr - OPJ_MEM_HEADER_SIZE);
+
+	l_header->m_size = p_size;
+	l_header->m_stats = p_stats;
+	l_header->m_base = p_base;
+	if (p_stats) {
+		++p_stats->m_nb_blocks;
+	}
+	return p_ptr;
+}
+
+static opj_mem_header_t * opj_mem_get_header(void * p_ptr)
+{
+	return (opj_mem_header_t *) ((OPJ_BYTE *) p_ptr - OPJ_MEM_HEADER_SIZE);
+}
+
+/* ----------------------------------------------------------------------- */
+
+void * opj_malloc(size_t size)
+{
+	opj_mem_stats_t * l_stats = opj_mem_current_stats;
+	OPJ_BYTE * l_base;
+
+	if (size > OPJ_MEM_MAX_SIZE || ! opj_mem_charge(l_stats, size)) {
+		return NULL;
+	}
+
+	l_base = (OPJ_BYTE *) opj_mem_raw_malloc(size + OPJ_MEM_HEADER_SIZE);
+	if (! l_base) {
+		opj_mem_credit(l_stats, size);
+		return NULL;
+	}
+
+	return opj_mem_init_block(l_base, l_base + OPJ_MEM_HEADER_SIZE, size, l_stats);
+}
+
+void * opj_calloc(size_t num, size_t size)
+{
+	opj_mem_stats_t * l_stats = opj_mem_current_stats;
+	OPJ_BYTE * l_base;
+	OPJ_SIZE_T l_size;
+
+	if (size != 0 && num > OPJ_MEM_MAX_SIZE / size) {
+		return NULL;
+	}
+	l_size = num * size;
+
+	if (! opj_mem_charge(l_stats, l_size)) {
+		return NULL;
+	}
+
+	l_base = (OPJ_BYTE *) opj_mem_raw_calloc(l_size + OPJ_MEM_HEADER_SIZE);
+	if (! l_base) {
+		opj_mem_credit(l_stats, l_size);
+		return NULL;
+	}
+
+	return opj_mem_init_block(l_base, l_base + OPJ_MEM_HEADER_SIZE, l_size, l_stats);
+}
+
+void * opj_realloc(void * m, size_t s)
+{
+	opj_mem_header_t * l_header;
+	opj_mem_stats_t * l_stats;
+	OPJ_SIZE_T l_old_size;
+	OPJ_BYTE * l_base;
+
+	if (! m) {
+		return opj_malloc(s);
+	}
+	if (s > OPJ_MEM_MAX_SIZE) {
+		return NULL;
+	}
+
+	l_header = opj_mem_get_header(m);
+	l_stats = l_header->m_stats;
+	l_old_size = l_header->m_size;
+
+	if (s > l_old_size && ! opj_mem_charge(l_stats, s - l_old_size)) {
+		return NULL;
+	}
+
+	l_base = (OPJ_BYTE *) opj_mem_raw_realloc(l_header->m_base, s + OPJ_MEM_HEADER_SIZE);
+	if (! l_base) {
+		if (s > l_old_size) {
+			opj_mem_credit(l_stats, s - l_old_size);
+		}
+		return NULL;
+	}
+
+	if (s < l_old_size) {
+		opj_mem_credit(l_stats, l_old_size - s);
+	}
+
+	l_header = (opj_mem_header_t *) l_base;
+	l_header->m_size = s;
+	l_header->m_base = l_base;
+
+	return l_base + OPJ_MEM_HEADER_SIZE;
+}
+
+void opj_free(void * m)
+{
+	opj_mem_header_t * l_header;
+	opj_mem_stats_t * l_stats;
+
+	if (! m) {
+		return;
+	}
+
+	l_header = opj_mem_get_header(m);
+	l_stats = l_header->m_stats;
+	opj_mem_credit(l_stats, l_header->m_size);
+	opj_mem_raw_free(l_header->m_base);
+	opj_mem_stats_remove_block(l_stats);
+}
+
+void * opj_aligned_malloc(size_t size)
+{
+	opj_mem_stats_t * l_stats = opj_mem_current_stats;
+	OPJ_BYTE * l_base;
+	OPJ_BYTE * l_ptr;
+
+	if (size > OPJ_MEM_MAX_SIZE || ! opj_mem_charge(l_stats, size)) {
+		return NULL;
+	}
+
+	if (opj_mem_aligned_malloc_fn) {
+		l_base = (OPJ_BYTE *) opj_mem_aligned_malloc_fn(size + OPJ_MEM_HEADER_SIZE, 16, opj_mem_user_data);
+	}
+	else if (opj_mem_malloc_fn) {
+		/* align on top of the user allocator */
+		l_base = (OPJ_BYTE *) opj_mem_malloc_fn(size + OPJ_MEM_HEADER_SIZE + 15U, opj_mem_user_data);
+	}
+	else {
+		l_base = (OPJ_BYTE *) opj_mem_default_aligned_malloc(size + OPJ_MEM_HEADER_SIZE);
+	}
+
+	if (! l_base) {
+		opj_mem_credit(l_stats, size);
+		return NULL;
+	}
+
+	l_ptr = l_base + OPJ_MEM_HEADER_SIZE;
+	if (! opj_mem_aligned_malloc_fn && opj_mem_malloc_fn) {
+		l_ptr += (16U - ((OPJ_SIZE_T) l_ptr & 15U)) & 15U;
+	}
+
+	return opj_mem_init_block(l_base, l_ptr, size, l_stats);
+}
+
+void opj_aligned_free(void * m)
+{
+	opj_mem_header_t * l_header;
+	opj_mem_stats_t * l_stats;
+
+	if (! m) {
+		return;
+	}
+
+	l_header = opj_mem_get_header(m);
+	l_stats = l_header->m_stats;
+	opj_mem_credit(l_stats, l_header->m_size);
+
+	if (opj_mem_aligned_free_fn) {
+		opj_mem_aligned_free_fn(l_header->m_base, opj_mem_user_data);
+	}
+	else if (opj_mem_malloc_fn) {
+		opj_mem_free_fn(l_header->m_base, opj_mem_user_data);
+	}
+	else {
+		opj_mem_default_aligned_free(l_header->m_base);
+	}
+
+	opj_mem_stats_remove_block(l_stats);
+}
+
+/* ----------------------------------------------------------------------- */
+
+/* the application releases these blocks, possibly with free(): they are counted until the accounting
+   is entered again, or until the library frees them during the call */
+static OPJ_BOOL opj_mem_charge_image_data(OPJ_SIZE_T p_size)
+{
+	opj_mem_stats_t * l_stats = opj_mem_current_stats;
+
+	if (! l_stats) {
+		return OPJ_TRUE;
+	}
+	if (! opj_mem_check_limit(l_stats, p_size)) {
+		return OPJ_FALSE;
+	}
+
+	l_stats->m_image_data += p_size;
+	opj_mem_update_peak(l_stats);
+	return OPJ_TRUE;
+}
+
+static void opj_mem_credit_image_data(OPJ_SIZE_T p_size)
+{
+	if (opj_mem_current_stats) {
+		opj_mem_current_stats->m_image_data -= p_size;
+	}
+}
+
+/* remembers the size of a block charged by opj_mem_charge_image_data, frees it on failure */
+static void * opj_mem_add_image_block(void * p_ptr, OPJ_SIZE_T p_size)
+{
+	opj_mem_stats_t * l_stats = opj_mem_current_stats;
+
+	if (! l_stats || ! p_ptr) {
+		return p_ptr;
+	}
+
+	if (l_stats->m_nb_image_blocks == l_stats->m_max_image_blocks) {
+		OPJ_SIZE_T l_max_blocks = l_stats->m_max_image_blocks ? 2 * l_stats->m_max_image_blocks : 16;
+		opj_mem_image_block_t * l_blocks = 00;
+
+		if (l_max_blocks <= OPJ_MEM_MAX_SIZE / sizeof(opj_mem_image_block_t)) {
+			l_blocks = (opj_mem_image_block_t *) opj_mem_raw_realloc(l_stats->m_image_blocks, l_max_blocks * sizeof(opj_mem_image_block_t));
+		}
+		if (! l_blocks) {
+			free(p_ptr);
+			opj_mem_credit_image_data(p_size);
+			return NULL;
+		}
+		l_stats->m_image_blocks = l_blocks;
+		l_stats->m_max_image_blocks = l_max_blocks;
+	}
+
+	l_stats->m_image_blocks[l_stats->m_nb_image_blocks].m_ptr = p_ptr;
+	l_stats->m_image_blocks[l_stats->m_nb_image_blocks].m_size = p_size;
+	++l_stats->m_nb_image_blocks;
+	return p_ptr;
+}
+
+void * opj_image_data_alloc(size_t size)
+{
+	void * l_ptr;
+
+	if (! opj_mem_charge_image_data(size)) {
+		return NULL;
+	}
+
+	l_ptr = malloc(size);
+	if (! l_ptr) {
+		opj_mem_credit_image_data(size);
+	}
+	return opj_mem_add_image_block(l_ptr, size);
+}
+
+void * opj_image_data_calloc(size_t num, size_t size)
+{
+	void * l_ptr;
+
+	if (size != 0 && num > OPJ_MEM_MAX_SIZE / size) {
+		return NULL;
+	}
+	if (! opj_mem_charge_image_data(num * size)) {
+		return NULL;
+	}
+
+	l_ptr = calloc(num, size);
+	if (! l_ptr) {
+		opj_mem_credit_image_data(num * size);
+	}
+	return opj_mem_add_image_block(l_ptr, num * size);
+}
+
+void opj_image_data_free(void * m)
+{
+	opj_mem_stats_t * l_stats = opj_mem_current_stats;
+	OPJ_SIZE_T i;
+
+	if (! m) {
+		return;
+	}
+
+	/* the blocks allocated during the call are the ones the library frees the most often, latest first */
+	if (l_stats) {
+		for (i = l_stats->m_nb_image_blocks; i-- > 0; ) {
+			if (l_stats->m_image_blocks[i].m_ptr == m) {
+				l_stats->m_image_data -= l_stats->m_image_blocks[i].m_size;
+				l_stats->m_image_blocks[i] = l_stats->m_image_blocks[--l_stats->m_nb_image_blocks];
+				break;
+			}
+		}
+	}
+	free(m);
+}
+
+/* ----------------------------------------------------------------------- */
+
+opj_mem_stats_t * opj_mem_stats_create(void)
+{
+	opj_mem_stats_t * l_stats = (opj_mem_stats_t *) opj_mem_raw_calloc(sizeof(opj_mem_stats_t));
+	return l_stats;
+}
+
+void opj_mem_stats_release(opj_mem_stats_t * p_stats)
+{
+	if (! p_stats) {
+		return;
+	}
+
+	if (p_stats->m_nb_blocks == 0) {
+		opj_mem_stats_destroy(p_stats);
+	}
+	else {
+		p_stats->m_orphaned = OPJ_TRUE;
+	}
+}
+
+opj_mem_stats_t * opj_mem_stats_enter(opj_mem_stats_t * p_stats)
+{
+	opj_mem_stats_t * l_previous = opj_mem_current_stats;
+
+	if (p_stats && p_stats != l_previous) {
+		p_stats->m_image_data = 0;
+		p_stats->m_nb_image_blocks = 0;
+	}
+	opj_mem_current_stats = p_stats;
+	return l_previous;
+}
+
+void opj_mem_stats_leave(opj_mem_stats_t * p_previous)
+{
+	opj_mem_current_stats = p_previous;
+}
+
+/* ----------------------------------------------------------------------- */
+
+OPJ_BOOL OPJ_CALLCONV opj_set_allocator(opj_malloc_fn p_malloc,
+                                        opj_realloc_fn p_realloc,
+                                        opj_free_fn p_free,
+                                        opj_aligned_malloc_fn p_aligned_malloc,
+                                        opj_aligned_free_fn p_aligned_free,
+                                        void * p_user_data)
+{
+	if (! p_malloc) {
+		opj_mem_malloc_fn = 00;
+		opj_mem_realloc_fn = 00;
+		opj_mem_free_fn = 00;
+		opj_mem_aligned_malloc_fn = 00;
+		opj_mem_aligned_free_fn = 00;
+		opj_mem_user_data = 00;
+		return OPJ_TRUE;
+	}
+
+	if (! p_realloc || ! p_free || (p_aligned_free && ! p_aligned_malloc)) {
+		return OPJ_FALSE;
+	}
+
+	opj_mem_malloc_fn = p_malloc;
+	opj_mem_realloc_fn = p_realloc;
+	opj_mem_free_fn = p_free;
+	opj_mem_aligned_malloc_fn = p_aligned_malloc;
+	opj_mem_aligned_free_fn = p_aligned_free;
+	opj_mem_user_data = p_user_data;
+
+	return OPJ_TRUE;
+}
@@ -45,21 +45,63 @@ The functions in opj_malloc.h are internal utilities used for memory management.
 /*@{*/
 /* ----------------------------------------------------------------------- */
 
+#ifdef OPJ_MALLOC_LIBC
+/* Users of the internal headers that mix opj_malloc() with the C runtime
+   (openjpip) keep the plain C runtime mapping. */
+#define opj_malloc(size) malloc(size)
+#define opj_calloc(num, size) calloc(num, size)
+#define opj_realloc(m, s) realloc(m, s)
+#define opj_free(m) free(m)
+#else
+
+/**
+Image data block charged to a memory accounting.
+*/
+typedef struct opj_mem_image_block
+{
+	/** Address of the block */
+	void * m_ptr;
+	/** Size of the block */
+	OPJ_SIZE_T m_size;
+}
+opj_mem_image_block_t;
+
+/**
+Memory accounting of a codec.
+Every block handed out by opj_malloc() and friends remembers the accounting
+it was charged to, so that it is credited back when the block is released.
+The image data blocks may be released by the application with free(): they
+cannot have a header, the accounting keeps their sizes while it is in use.
+*/
+typedef struct opj_mem_stats
+{
+	/** Bytes currently allocated */
+	OPJ_SIZE_T m_current;
+	/** Bytes handed over to the application since the accounting was entered */
+	OPJ_SIZE_T m_image_data;
+	/** Image data blocks allocated since the accounting was entered, credited back if the library frees them */
+	opj_mem_image_block_t * m_image_blocks;
+	/** Number of blocks in m_image_blocks */
+	OPJ_SIZE_T m_nb_image_blocks;
+	/** Number of blocks m_image_blocks can hold */
+	OPJ_SIZE_T m_max_image_blocks;
+	/** Highest value reached by m_current + m_image_data */
+	OPJ_SIZE_T m_peak;
+	/** Maximum number of bytes that may be allocated, 0 if unlimited */
+	OPJ_SIZE_T m_limit;
+	/** Number of live blocks charged to this accounting */
+	OPJ_SIZE_T m_nb_blocks;
+	/** Set once the owner is gone: the structure is freed with its last block */
+	OPJ_BOOL m_orphaned;
+}
+opj_mem_stats_t;
+
 /**
 Allocate an uninitialized memory block
 @param size Bytes to allocate
 @return Returns a void pointer to the allocated space, or NULL if there is insufficient memory available
 */
-#ifdef ALLOC_PERF_OPT
-void * OPJ_CALLCONV opj_malloc(size_t size);
-#else
-/* prevent assertion on overflow for MSVC */
-#ifdef _MSC_VER
-#define opj_malloc(size) ((size_t)(size) >= (size_t)-0x100 ? NULL : malloc(size))
-#else
-#define opj_malloc(size) malloc(size)
-#endif
-#endif
+void * opj_malloc(size_t size);
 
 /**
 Allocate a memory block with elements initialized to 0
@@ -67,83 +109,20 @@ Allocate a memory block with elements initialized to 0
 @param size Bytes per block to allocate
 @return Returns a void pointer to the allocated space, or NULL if there is insufficient memory available
 */
-#ifdef ALLOC_PERF_OPT
-void * OPJ_CALLCONV opj_calloc(size_t _NumOfElements, size_t _SizeOfElements);
-#else
-/* prevent assertion on overflow for MSVC */
-#ifdef _MSC_VER
-#define opj_calloc(num, size) ((size_t)(num) != 0 && (size_t)(num) >= (size_t)-0x100 / (size_t)(size) ? NULL : calloc(num, size))
-#else
-#define opj_calloc(num, size) calloc(num, size)
-#endif
-#endif
+void * opj_calloc(size_t num, size_t size);
 
 /**
 Allocate memory aligned to a 16 byte boundry
 @param size Bytes to allocate
 @return Returns a void pointer to the allocated space, or NULL if there is insufficient memory available
 */
-/* FIXME: These should be set with cmake tests, but we're currently not requiring use of cmake */
-#ifdef _WIN32
-	/* Someone should tell the mingw people that their malloc.h ought to provide _mm_malloc() */
-	#ifdef __GNUC__
-		#include <mm_malloc.h>
-		#define HAVE_MM_MALLOC
-	#else /* MSVC, Intel C++ */
-		#include <malloc.h>
-		#ifdef _mm_malloc
-			#define HAVE_MM_MALLOC
-		#endif
-	#endif
-#else /* Not _WIN32 */
-	#if defined(__sun)
-		#define HAVE_MEMALIGN
-  #elif defined(__FreeBSD__)
-    #define HAVE_POSIX_MEMALIGN
-	/* Linux x86_64 and OSX always align allocations to 16 bytes */
-	#elif !defined(__amd64__) && !defined(__APPLE__) && !defined(_AIX)
-		#define HAVE_MEMALIGN
-		#include <malloc.h>			
-	#endif
-#endif
-
-#define opj_aligned_malloc(size) malloc(size)
-#define opj_aligned_free(m) free(m)
-
-#ifdef HAVE_MM_MALLOC
-	#undef opj_aligned_malloc
-	#define opj_aligned_malloc(size) _mm_malloc(size, 16)
-	#undef opj_aligned_free
-	#define opj_aligned_free(m) _mm_free(m)
-#endif
-
-#ifdef HAVE_MEMALIGN
-	extern void* memalign(size_t, size_t);
-	#undef opj_aligned_malloc
-	#define opj_aligned_malloc(size) memalign(16, (size))
-	#undef opj_aligned_free
-	#define opj_aligned_free(m) free(m)
-#endif
-
-#ifdef HAVE_POSIX_MEMALIGN
-	#undef opj_aligned_malloc
-	extern int posix_memalign(void**, size_t, size_t);
-
-	static INLINE void* __attribute__ ((malloc)) opj_aligned_malloc(size_t size){
-		void* mem = NULL;
-		posix_memalign(&mem, 16, size);
-		return mem;
-	}
-	#undef opj_aligned_free
-	#define opj_aligned_free(m) free(m)
-#endif
+void * opj_aligned_malloc(size_t size);
 
-#ifdef ALLOC_PERF_OPT
-	#undef opj_aligned_malloc
-	#define opj_aligned_malloc(size) opj_malloc(size)
-	#undef opj_aligned_free
-	#define opj_aligned_free(m) opj_free(m)
-#endif
+/**
+Deallocates a memory block allocated with opj_aligned_malloc.
+@param m Previously allocated memory block to be freed
+*/
+void opj_aligned_free(void * m);
 
 /**
 Reallocate memory blocks.
@@ -151,28 +130,72 @@ Reallocate memory blocks.
 @param s New size in bytes
 @return Returns a void pointer to the reallocated (and possibly moved) memory block
 */
-#ifdef ALLOC_PERF_OPT
-void * OPJ_CALLCONV opj_realloc(void * m, size_t s);
-#else
-/* prevent assertion on overflow for MSVC */
-#ifdef _MSC_VER
-#define opj_realloc(m, s) ((size_t)(s) >= (size_t)-0x100 ? NULL : realloc(m, s))
-#else
-#define opj_realloc(m, s) realloc(m, s)
-#endif
-#endif
+void * opj_realloc(void * m, size_t s);
 
 /**
 Deallocates or frees a memory block.
 @param m Previously allocated memory block to be freed
 */
-#ifdef ALLOC_PERF_OPT
-void OPJ_CALLCONV opj_free(void * m);
-#else
-#define opj_free(m) free(m)
-#endif
+void opj_free(void * m);
+
+/**
+Allocate a block that is handed over to the application (image samples,
+ICC profile, MCT data) and that it may release with free(). Such blocks
+bypass the allocator hooks. They are checked against the limit and counted
+in the peak of the accounting in use until it is entered again or until the
+library frees them, but as they outlive the call, they are never part of
+its current size.
+@param size Bytes to allocate
+@return Returns a void pointer to the allocated space, or NULL if there is insufficient memory available
+*/
+void * opj_image_data_alloc(size_t size);
 
-#ifdef __GNUC__
+/**
+Same as opj_image_data_alloc, with elements initialized to 0
+@param num Blocks to allocate
+@param size Bytes per block to allocate
+@return Returns a void pointer to the allocated space, or NULL if there is insufficient memory available
+*/
+void * opj_image_data_calloc(size_t num, size_t size);
+
+/**
+Deallocates a block allocated with opj_image_data_alloc or opj_image_data_calloc.
+A block allocated since the accounting in use was entered is credited back.
+@param m Previously allocated memory block to be freed
+*/
+void opj_image_data_free(void * m);
+
+/**
+Creates a memory accounting structure.
+@return the new accounting, or NULL if there is insufficient memory available
+*/
+opj_mem_stats_t * opj_mem_stats_create(void);
+
+/**
+Releases a memory accounting structure. Blocks still charged to it keep it
+alive until they are freed.
+@param p_stats accounting to release
+*/
+void opj_mem_stats_release(opj_mem_stats_t * p_stats);
+
+/**
+Charges the allocations of the calling thread to the given accounting.
+The accounting is not synchronized: it must not be entered by two threads
+at the same time, each clone of a codec has its own.
+@param p_stats accounting to use, NULL to stop accounting
+@return the accounting that was in use, to be given back to opj_mem_stats_leave
+*/
+opj_mem_stats_t * opj_mem_stats_enter(opj_mem_stats_t * p_stats);
+
+/**
+Restores the accounting that was in use before opj_mem_stats_enter.
+@param p_previous value returned by opj_mem_stats_enter
+*/
+void opj_mem_stats_leave(opj_mem_stats_t * p_previous);
+
+#endif /* OPJ_MALLOC_LIBC */
+
+#if defined(__GNUC__) && !defined(OPJ_SKIP_POISON)
 #pragma GCC poison malloc calloc realloc free
 #endif
 
@@ -182,4 +205,3 @@ void OPJ_CALLCONV opj_free(void * m);
 /*@}*/
 
 #endif /* __OPJ_MALLOC_H */
-
@@ -0,0 +1,142 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses 
+ * BSD License, included below. This software may be subject to other third 
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "opj_includes.h"
+
+static const char * const opj_profile_stage_names[OPJ_PROFILE_NB_STAGES] = {
+	"T2", "T1", "DWT", "MCT", "DC shift", "I/O", "rate"
+};
+
+opj_profile_t * opj_profile_create(void)
+{
+	return (opj_profile_t *) opj_calloc(1, sizeof(opj_profile_t));
+}
+
+void opj_profile_destroy(opj_profile_t * p_profile)
+{
+	if (p_profile) {
+		opj_free(p_profile->tiles);
+		opj_free(p_profile);
+	}
+}
+
+opj_profile_stats_t * opj_profile_get_tile(opj_profile_t * p_profile, OPJ_UINT32 p_tileno)
+{
+	if (! p_profile) {
+		return 00;
+	}
+
+	if (p_tileno >= p_profile->nb_tiles) {
+		OPJ_UINT32 l_nb_tiles = p_tileno + 1;
+		opj_profile_stats_t * l_tiles = (opj_profile_stats_t *) opj_realloc(p_profile->tiles, l_nb_tiles * sizeof(opj_profile_stats_t));
+		if (! l_tiles) {
+			return 00;
+		}
+		memset(l_tiles + p_profile->nb_tiles, 0, (l_nb_tiles - p_profile->nb_tiles) * sizeof(opj_profile_stats_t));
+		p_profile->tiles = l_tiles;
+		p_profile->nb_tiles = l_nb_tiles;
+	}
+
+	return p_profile->tiles + p_tileno;
+}
+
+OPJ_FLOAT64 opj_profile_start(const opj_profile_stats_t * p_stats)
+{
+	return p_stats ? opj_clock() : 0;
+}
+
+void opj_profile_stop(opj_profile_stats_t * p_stats, OPJ_PROFILE_STAGE p_stage, OPJ_FLOAT64 p_start)
+{
+	if (p_stats) {
+		p_stats->times[p_stage] += opj_clock() - p_start;
+	}
+}
+
+void opj_profile_update_total(opj_profile_t * p_profile)
+{
+	OPJ_UINT32 i, j;
+	opj_profile_stats_t * l_total = &(p_profile->total);
+
+	memset(l_total, 0, sizeof(opj_profile_stats_t));
+
+	for (i = 0; i < p_profile->nb_tiles; ++i) {
+		const opj_profile_stats_t * l_tile = p_profile->tiles + i;
+
+		for (j = 0; j < OPJ_PROFILE_NB_STAGES; ++j) {
+			l_total->times[j] += l_tile->times[j];
+		}
+		l_total->nb_code_blocks += l_tile->nb_code_blocks;
+		l_total->nb_passes += l_tile->nb_passes;
+		l_total->nb_mq_symbols += l_tile->nb_mq_symbols;
+		l_total->nb_bytes_read += l_tile->nb_bytes_read;
+		l_total->nb_bytes_copied += l_tile->nb_bytes_copied;
+	}
+}
+
+static void opj_profile_dump_stats(const char * p_name, const opj_profile_stats_t * p_stats, FILE * output_stream)
+{
+	OPJ_UINT32 i;
+	OPJ_FLOAT64 l_sum = 0;
+
+	fprintf(output_stream, "%-8s", p_name);
+	for (i = 0; i < OPJ_PROFILE_NB_STAGES; ++i) {
+		fprintf(output_stream, " %9.4f", p_stats->times[i]);
+		l_sum += p_stats->times[i];
+	}
+	fprintf(output_stream, " %9.4f %10.0f %10.0f %12.0f %12.0f %12.0f\n",
+		l_sum,
+		(OPJ_FLOAT64) p_stats->nb_code_blocks,
+		(OPJ_FLOAT64) p_stats->nb_passes,
+		(OPJ_FLOAT64) p_stats->nb_mq_symbols,
+		(OPJ_FLOAT64) p_stats->nb_bytes_read,
+		(OPJ_FLOAT64) p_stats->nb_bytes_copied);
+}
+
+void opj_profile_dump(opj_profile_t * p_profile, FILE * output_stream)
+{
+	OPJ_UINT32 i;
+	char l_name[16];
+
+	opj_profile_update_total(p_profile);
+
+	fprintf(output_stream, "Profile (times in seconds):\n");
+	fprintf(output_stream, "%-8s", "tile");
+	for (i = 0; i < OPJ_PROFILE_NB_STAGES; ++i) {
+		fprintf(output_stream, " %9s", opj_profile_stage_names[i]);
+	}
+	fprintf(output_stream, " %9s %10s %10s %12s %12s %12s\n",
+		"sum", "cblks", "passes", "mq symbols", "bytes read", "bytes copied");
+
+	for (i = 0; i < p_profile->nb_tiles; ++i) {
+		sprintf(l_name, "%u", i);
+		opj_profile_dump_stats(l_name, p_profile->tiles + i, output_stream);
+	}
+	opj_profile_dump_stats("total", &(p_profile->total), output_stream);
+}
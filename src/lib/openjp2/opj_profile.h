@@ -0,0 +1,102 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses 
+ * BSD License, included below. This software may be subject to other third 
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __OPJ_PROFILE_H
+#define __OPJ_PROFILE_H
+/**
+@file opj_profile.h
+@brief Internal functions for the profiling of a codec
+
+The functions in OPJ_PROFILE.C accumulate the time spent in each stage of the coding
+of a tile and the work counters of the tile in an opj_profile_t. All of them accept
+a NULL profile or NULL statistics, in which case they do nothing, so that the callers
+do not need to check whether the profiling is enabled.
+*/
+
+/** @defgroup MISC MISC - Miscellaneous internal functions */
+/*@{*/
+
+/** @name Exported functions */
+/*@{*/
+/* ----------------------------------------------------------------------- */
+
+/**
+Create an empty profile
+@return Returns a new profile if successful, returns NULL otherwise
+*/
+opj_profile_t * opj_profile_create(void);
+
+/**
+Destroy a profile
+@param p_profile Profile to destroy
+*/
+void opj_profile_destroy(opj_profile_t * p_profile);
+
+/**
+Get the statistics of a tile, growing the array of tiles if needed
+@param p_profile Profile of the codec (may be NULL)
+@param p_tileno Tile number
+@return Returns the statistics of the tile, NULL if p_profile is NULL or on allocation failure
+*/
+opj_profile_stats_t * opj_profile_get_tile(opj_profile_t * p_profile, OPJ_UINT32 p_tileno);
+
+/**
+Start to time a stage
+@param p_stats Statistics the time will be added to (may be NULL)
+@return Returns the current time, 0 if p_stats is NULL
+*/
+OPJ_FLOAT64 opj_profile_start(const opj_profile_stats_t * p_stats);
+
+/**
+Stop to time a stage and add the elapsed time to the statistics
+@param p_stats Statistics the time is added to (may be NULL)
+@param p_stage Stage being timed
+@param p_start Value returned by opj_profile_start
+*/
+void opj_profile_stop(opj_profile_stats_t * p_stats, OPJ_PROFILE_STAGE p_stage, OPJ_FLOAT64 p_start);
+
+/**
+Sum the statistics of all the tiles into the total of the profile
+@param p_profile Profile of the codec
+*/
+void opj_profile_update_total(opj_profile_t * p_profile);
+
+/**
+Write the profile in a human readable form
+@param p_profile Profile of the codec
+@param output_stream Output stream
+*/
+void opj_profile_dump(opj_profile_t * p_profile, FILE * output_stream);
+
+/* ----------------------------------------------------------------------- */
+/*@}*/
+
+/*@}*/
+
+#endif /* __OPJ_PROFILE_H */
@@ -0,0 +1,223 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses 
+ * BSD License, included below. This software may be subject to other third 
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "opj_includes.h"
+
+/** Number of bytes of an entry counted against the budget of the cache */
+static OPJ_SIZE_T opj_tile_cache_entry_size(const opj_tile_cache_entry_t * p_entry)
+{
+	return sizeof(opj_tile_cache_entry_t) + p_entry->numcomps * sizeof(opj_tile_cache_comp_t) + p_entry->data_size;
+}
+
+/** Unlink an entry from the lists of the cache and free it */
+static void opj_tile_cache_remove(opj_tile_cache_t * p_cache, opj_tile_cache_entry_t * p_entry)
+{
+	opj_tile_cache_entry_t ** l_link = p_cache->tiles + p_entry->key.tileno;
+
+	while (*l_link != p_entry) {
+		l_link = &((*l_link)->next_of_tile);
+	}
+	*l_link = p_entry->next_of_tile;
+
+	if (p_entry->prev) {
+		p_entry->prev->next = p_entry->next;
+	}
+	else {
+		p_cache->head = p_entry->next;
+	}
+	if (p_entry->next) {
+		p_entry->next->prev = p_entry->prev;
+	}
+	else {
+		p_cache->tail = p_entry->prev;
+	}
+
+	p_cache->size -= opj_tile_cache_entry_size(p_entry);
+	opj_free(p_entry->comps);
+	opj_free(p_entry->data);
+	opj_free(p_entry);
+}
+
+/** Drop the least recently used entries until p_size more bytes fit in the budget */
+static void opj_tile_cache_make_room(opj_tile_cache_t * p_cache, OPJ_SIZE_T p_size)
+{
+	while (p_cache->tail && p_cache->size + p_size > p_cache->max_size) {
+		opj_tile_cache_remove(p_cache, p_cache->tail);
+	}
+}
+
+opj_tile_cache_t * opj_tile_cache_create(OPJ_SIZE_T p_max_size)
+{
+	opj_tile_cache_t * l_cache = (opj_tile_cache_t *) opj_calloc(1, sizeof(opj_tile_cache_t));
+	if (! l_cache) {
+		return 00;
+	}
+	l_cache->max_size = p_max_size;
+	return l_cache;
+}
+
+void opj_tile_cache_destroy(opj_tile_cache_t * p_cache)
+{
+	if (p_cache) {
+		opj_tile_cache_clear(p_cache);
+		opj_free(p_cache->tiles);
+		opj_free(p_cache);
+	}
+}
+
+void opj_tile_cache_clear(opj_tile_cache_t * p_cache)
+{
+	if (p_cache) {
+		while (p_cache->head) {
+			opj_tile_cache_remove(p_cache, p_cache->head);
+		}
+	}
+}
+
+void opj_tile_cache_set_max_size(opj_tile_cache_t * p_cache, OPJ_SIZE_T p_max_size)
+{
+	p_cache->max_size = p_max_size;
+	opj_tile_cache_make_room(p_cache, 0);
+}
+
+opj_tile_cache_entry_t * opj_tile_cache_get(opj_tile_cache_t * p_cache, const opj_tile_cache_key_t * p_key)
+{
+	opj_tile_cache_entry_t * l_entry;
+
+	if (! p_cache || p_key->tileno >= p_cache->nb_tiles) {
+		return 00;
+	}
+
+	for (l_entry = p_cache->tiles[p_key->tileno]; l_entry; l_entry = l_entry->next_of_tile) {
+		if (l_entry->key.reduce == p_key->reduce &&
+			l_entry->key.layer == p_key->layer &&
+			l_entry->key.native_samples == p_key->native_samples) {
+			break;
+		}
+	}
+	if (! l_entry) {
+		return 00;
+	}
+
+	/* move the entry to the head of the list */
+	if (l_entry->prev) {
+		l_entry->prev->next = l_entry->next;
+		if (l_entry->next) {
+			l_entry->next->prev = l_entry->prev;
+		}
+		else {
+			p_cache->tail = l_entry->prev;
+		}
+		l_entry->prev = 00;
+		l_entry->next = p_cache->head;
+		p_cache->head->prev = l_entry;
+		p_cache->head = l_entry;
+	}
+
+	return l_entry;
+}
+
+OPJ_BOOL opj_tile_cache_add(opj_tile_cache_t * p_cache,
+                            const opj_tile_cache_key_t * p_key,
+                            OPJ_INT32 p_x0, OPJ_INT32 p_y0, OPJ_INT32 p_x1, OPJ_INT32 p_y1,
+                            OPJ_UINT32 p_numcomps,
+                            const opj_tile_cache_comp_t * p_comps,
+                            const OPJ_BYTE * p_data,
+                            OPJ_SIZE_T p_data_size)
+{
+	opj_tile_cache_entry_t * l_entry;
+	opj_tile_cache_entry_t * l_previous;
+	OPJ_SIZE_T l_size;
+
+	if (! p_cache) {
+		return OPJ_FALSE;
+	}
+
+	l_size = sizeof(opj_tile_cache_entry_t) + p_numcomps * sizeof(opj_tile_cache_comp_t) + p_data_size;
+	if (l_size > p_cache->max_size) {
+		return OPJ_FALSE;
+	}
+
+	/* the tile replaces the one decoded with the same parameters */
+	l_previous = opj_tile_cache_get(p_cache, p_key);
+	if (l_previous) {
+		opj_tile_cache_remove(p_cache, l_previous);
+	}
+	opj_tile_cache_make_room(p_cache, l_size);
+
+	if (p_key->tileno >= p_cache->nb_tiles) {
+		OPJ_UINT32 l_nb_tiles = p_key->tileno + 1;
+		opj_tile_cache_entry_t ** l_tiles = (opj_tile_cache_entry_t **) opj_realloc(p_cache->tiles, l_nb_tiles * sizeof(opj_tile_cache_entry_t *));
+		if (! l_tiles) {
+			return OPJ_FALSE;
+		}
+		memset(l_tiles + p_cache->nb_tiles, 0, (l_nb_tiles - p_cache->nb_tiles) * sizeof(opj_tile_cache_entry_t *));
+		p_cache->tiles = l_tiles;
+		p_cache->nb_tiles = l_nb_tiles;
+	}
+
+	l_entry = (opj_tile_cache_entry_t *) opj_calloc(1, sizeof(opj_tile_cache_entry_t));
+	if (! l_entry) {
+		return OPJ_FALSE;
+	}
+	l_entry->comps = (opj_tile_cache_comp_t *) opj_malloc(p_numcomps * sizeof(opj_tile_cache_comp_t));
+	l_entry->data = (OPJ_BYTE *) opj_malloc(p_data_size ? p_data_size : 1);
+	if (! l_entry->comps || ! l_entry->data) {
+		opj_free(l_entry->comps);
+		opj_free(l_entry->data);
+		opj_free(l_entry);
+		return OPJ_FALSE;
+	}
+	memcpy(l_entry->comps, p_comps, p_numcomps * sizeof(opj_tile_cache_comp_t));
+	memcpy(l_entry->data, p_data, p_data_size);
+
+	l_entry->key = *p_key;
+	l_entry->x0 = p_x0;
+	l_entry->y0 = p_y0;
+	l_entry->x1 = p_x1;
+	l_entry->y1 = p_y1;
+	l_entry->numcomps = p_numcomps;
+	l_entry->data_size = p_data_size;
+
+	l_entry->next_of_tile = p_cache->tiles[p_key->tileno];
+	p_cache->tiles[p_key->tileno] = l_entry;
+
+	l_entry->next = p_cache->head;
+	if (p_cache->head) {
+		p_cache->head->prev = l_entry;
+	}
+	else {
+		p_cache->tail = l_entry;
+	}
+	p_cache->head = l_entry;
+	p_cache->size += l_size;
+
+	return OPJ_TRUE;
+}
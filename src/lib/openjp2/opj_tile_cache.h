@@ -0,0 +1,181 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses 
+ * BSD License, included below. This software may be subject to other third 
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __OPJ_TILE_CACHE_H
+#define __OPJ_TILE_CACHE_H
+/**
+@file opj_tile_cache.h
+@brief Internal cache of decoded tiles
+
+The functions in OPJ_TILE_CACHE.C keep the decoded tiles of a decompressor, packed
+as by opj_tcd_update_tile_data, so that a tile needed again by a later decoding is
+copied into the output image instead of being decoded again. The least recently used
+tiles are dropped to keep the cache within its byte budget.
+*/
+
+/** @defgroup MISC MISC - Miscellaneous internal functions */
+/*@{*/
+
+/**
+Parameters a tile has been decoded with
+*/
+typedef struct opj_tile_cache_key
+{
+	/** index of the tile */
+	OPJ_UINT32 tileno;
+	/** number of highest resolution levels discarded */
+	OPJ_UINT32 reduce;
+	/** maximum number of quality layers decoded, 0 for all of them */
+	OPJ_UINT32 layer;
+	/** whether the samples are packed at the native width of the components */
+	OPJ_UINT32 native_samples;
+} opj_tile_cache_key_t;
+
+/**
+Decoded resolution of a tile component
+*/
+typedef struct opj_tile_cache_comp
+{
+	/** area of the decoded resolution, on the component grid reduced by the resolution factor */
+	OPJ_INT32 x0, y0, x1, y1;
+	/** resolution level decoded */
+	OPJ_UINT32 resno_decoded;
+} opj_tile_cache_comp_t;
+
+/**
+Decoded tile kept by the cache
+*/
+typedef struct opj_tile_cache_entry
+{
+	/** parameters the tile has been decoded with */
+	opj_tile_cache_key_t key;
+	/** area of the tile on the reference grid */
+	OPJ_INT32 x0, y0, x1, y1;
+	/** number of components */
+	OPJ_UINT32 numcomps;
+	/** decoded resolution of each component */
+	opj_tile_cache_comp_t * comps;
+	/** samples of the components, one after the other */
+	OPJ_BYTE * data;
+	/** size of data in bytes */
+	OPJ_SIZE_T data_size;
+	/** more recently used entry */
+	struct opj_tile_cache_entry * prev;
+	/** less recently used entry */
+	struct opj_tile_cache_entry * next;
+	/** next entry of the same tile */
+	struct opj_tile_cache_entry * next_of_tile;
+} opj_tile_cache_entry_t;
+
+/**
+Cache of decoded tiles
+*/
+typedef struct opj_tile_cache
+{
+	/** maximum number of bytes kept */
+	OPJ_SIZE_T max_size;
+	/** number of bytes kept */
+	OPJ_SIZE_T size;
+	/** most recently used entry */
+	opj_tile_cache_entry_t * head;
+	/** least recently used entry */
+	opj_tile_cache_entry_t * tail;
+	/** entries of each tile */
+	opj_tile_cache_entry_t ** tiles;
+	/** size of the tiles array */
+	OPJ_UINT32 nb_tiles;
+} opj_tile_cache_t;
+
+/** @name Exported functions */
+/*@{*/
+/* ----------------------------------------------------------------------- */
+
+/**
+Create an empty cache
+@param p_max_size Maximum number of bytes kept by the cache
+@return Returns a new cache if successful, returns NULL otherwise
+*/
+opj_tile_cache_t * opj_tile_cache_create(OPJ_SIZE_T p_max_size);
+
+/**
+Destroy a cache and the tiles it keeps
+@param p_cache Cache to destroy (may be NULL)
+*/
+void opj_tile_cache_destroy(opj_tile_cache_t * p_cache);
+
+/**
+Drop all the tiles of a cache
+@param p_cache Cache to empty (may be NULL)
+*/
+void opj_tile_cache_clear(opj_tile_cache_t * p_cache);
+
+/**
+Change the budget of a cache, dropping the least recently used tiles if needed
+@param p_cache Cache
+@param p_max_size Maximum number of bytes kept by the cache
+*/
+void opj_tile_cache_set_max_size(opj_tile_cache_t * p_cache, OPJ_SIZE_T p_max_size);
+
+/**
+Look for a decoded tile, which becomes the most recently used one
+@param p_cache Cache (may be NULL)
+@param p_key Parameters the tile must have been decoded with
+@return Returns the tile if it is in the cache, NULL otherwise
+*/
+opj_tile_cache_entry_t * opj_tile_cache_get(opj_tile_cache_t * p_cache, const opj_tile_cache_key_t * p_key);
+
+/**
+Add a decoded tile to a cache, dropping the least recently used tiles to make room for it.
+A tile larger than the budget of the cache is not added.
+@param p_cache Cache (may be NULL)
+@param p_key Parameters the tile has been decoded with
+@param p_x0 Left position of the tile on the reference grid
+@param p_y0 Top position of the tile on the reference grid
+@param p_x1 Right position of the tile on the reference grid
+@param p_y1 Bottom position of the tile on the reference grid
+@param p_numcomps Number of components
+@param p_comps Decoded resolution of each component
+@param p_data Samples of the components, copied by the cache
+@param p_data_size Size of p_data in bytes
+@return Returns true if the tile has been added
+*/
+OPJ_BOOL opj_tile_cache_add(opj_tile_cache_t * p_cache,
+                            const opj_tile_cache_key_t * p_key,
+                            OPJ_INT32 p_x0, OPJ_INT32 p_y0, OPJ_INT32 p_x1, OPJ_INT32 p_y1,
+                            OPJ_UINT32 p_numcomps,
+                            const opj_tile_cache_comp_t * p_comps,
+                            const OPJ_BYTE * p_data,
+                            OPJ_SIZE_T p_data_size);
+
+/* ----------------------------------------------------------------------- */
+/*@}*/
+
+/*@}*/
+
+#endif /* __OPJ_TILE_CACHE_H */
@@ -1875,3 +1875,38 @@ OPJ_BOOL opj_pi_next(opj_pi_iterator_t * pi) {
 	
 	return OPJ_FALSE;
 }
+
+OPJ_BOOL opj_pi_list_packets(opj_pi_iterator_t * pi,
+                             OPJ_UINT32 pino,
+                             opj_pi_packet_t ** p_packets,
+                             OPJ_UINT32 * p_nb_packets,
+                             OPJ_UINT32 * p_max_packets)
+{
+	while (opj_pi_next(pi)) {
+		opj_pi_packet_t * l_packet;
+
+		if (*p_nb_packets == *p_max_packets) {
+			OPJ_UINT32 l_max_packets = *p_max_packets ? 2 * *p_max_packets : 64;
+			opj_pi_packet_t * l_new_packets;
+
+			if (l_max_packets > 0xFFFFFFFFU / sizeof(opj_pi_packet_t)) {
+				return OPJ_FALSE;
+			}
+			l_new_packets = (opj_pi_packet_t *) opj_realloc(*p_packets, l_max_packets * sizeof(opj_pi_packet_t));
+			if (! l_new_packets) {
+				return OPJ_FALSE;
+			}
+			*p_packets = l_new_packets;
+			*p_max_packets = l_max_packets;
+		}
+
+		l_packet = *p_packets + (*p_nb_packets)++;
+		l_packet->precno = pi->precno;
+		l_packet->layno = (OPJ_UINT16)pi->layno;
+		l_packet->compno = (OPJ_UINT16)pi->compno;
+		l_packet->resno = (OPJ_BYTE)pi->resno;
+		l_packet->pino = (OPJ_BYTE)pino;
+	}
+
+	return OPJ_TRUE;
+}
@@ -107,6 +107,22 @@ typedef struct opj_pi_iterator {
   OPJ_UINT32 dx, dy;
 } opj_pi_iterator_t;
 
+/**
+Packet of a tile, as listed by opj_pi_list_packets
+*/
+typedef struct opj_pi_packet {
+  /** precinct of the packet */
+  OPJ_UINT32 precno;
+  /** layer of the packet */
+  OPJ_UINT16 layno;
+  /** component of the packet */
+  OPJ_UINT16 compno;
+  /** resolution of the packet */
+  OPJ_BYTE resno;
+  /** progression order change whose packet iterator gave the packet */
+  OPJ_BYTE pino;
+} opj_pi_packet_t;
+
 /** @name Exported functions */
 /*@{*/
 /* ----------------------------------------------------------------------- */
@@ -180,6 +196,22 @@ Modify the packet iterator to point to the next packet
 @return Returns false if pi pointed to the last packet or else returns true
 */
 OPJ_BOOL opj_pi_next(opj_pi_iterator_t * pi);
+
+/**
+Append the packets a packet iterator goes through to a list of packets, so that they
+are iterated once only when they are used several times.
+@param pi Packet iterator, on its first packet
+@param pino Progression order change of the packet iterator
+@param p_packets List of packets, grown if needed
+@param p_nb_packets Number of packets in the list
+@param p_max_packets Number of packets the list can hold
+@return Returns false if the list could not be grown
+*/
+OPJ_BOOL opj_pi_list_packets(opj_pi_iterator_t * pi,
+                             OPJ_UINT32 pino,
+                             opj_pi_packet_t ** p_packets,
+                             OPJ_UINT32 * p_nb_packets,
+                             OPJ_UINT32 * p_max_packets);
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
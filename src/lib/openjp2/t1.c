@@ -299,6 +299,22 @@ static OPJ_BOOL opj_t1_allocate_buffers(   opj_t1_t *t1,
                                     OPJ_UINT32 w,
                                     OPJ_UINT32 h);
 
+/**
+Decode the code-blocks of a tile component into a buffer laid out as the tile component
+@param t1 T1 handle
+@param tilec The tile component to decode
+@param tccp Tile coding parameters
+@param p_dest Destination of the coefficients
+@param p_modified_only true to only decode the code-blocks flagged by opj_tcd_cblk_dec_t::m_modified
+@param p_nb_decoded incremented by the number of code-blocks decoded
+*/
+static OPJ_BOOL opj_t1_decode_cblks_into(   opj_t1_t* t1,
+                                            opj_tcd_tilecomp_t* tilec,
+                                            opj_tccp_t* tccp,
+                                            OPJ_INT32 * p_dest,
+                                            OPJ_BOOL p_modified_only,
+                                            OPJ_UINT32 * p_nb_decoded);
+
 /*@}*/
 
 /*@}*/
@@ -1272,9 +1288,30 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
                             opj_tcd_tilecomp_t* tilec,
                             opj_tccp_t* tccp
                             )
+{
+	OPJ_UINT32 l_nb_decoded = 0;
+
+	return opj_t1_decode_cblks_into(t1, tilec, tccp, tilec->data, OPJ_FALSE, &l_nb_decoded);
+}
+
+OPJ_BOOL opj_t1_decode_modified_cblks(  opj_t1_t* t1,
+                                        opj_tcd_tilecomp_t* tilec,
+                                        opj_tccp_t* tccp,
+                                        OPJ_INT32 * p_dest,
+                                        OPJ_UINT32 * p_nb_decoded)
+{
+	return opj_t1_decode_cblks_into(t1, tilec, tccp, p_dest, OPJ_TRUE, p_nb_decoded);
+}
+
+static OPJ_BOOL opj_t1_decode_cblks_into(   opj_t1_t* t1,
+                                            opj_tcd_tilecomp_t* tilec,
+                                            opj_tccp_t* tccp,
+                                            OPJ_INT32 * p_dest,
+                                            OPJ_BOOL p_modified_only,
+                                            OPJ_UINT32 * p_nb_decoded)
 {
 	OPJ_UINT32 resno, bandno, precno, cblkno;
-	OPJ_UINT32 tile_w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+	OPJ_SIZE_T tile_w = (OPJ_SIZE_T)(tilec->x1 - tilec->x0);
 
 	for (resno = 0; resno < tilec->minimum_num_resolutions; ++resno) {
 		opj_tcd_resolution_t* res = &tilec->resolutions[resno];
@@ -1287,19 +1324,12 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
 
 				for (cblkno = 0; cblkno < precinct->cw * precinct->ch; ++cblkno) {
 					opj_tcd_cblk_dec_t* cblk = &precinct->cblks.dec[cblkno];
-					OPJ_INT32* restrict datap;
-					OPJ_UINT32 cblk_w, cblk_h;
 					OPJ_INT32 x, y;
-					OPJ_UINT32 i, j;
-
-                    if (OPJ_FALSE == opj_t1_decode_cblk(
-                                            t1,
-                                            cblk,
-                                            band->bandno,
-                                            (OPJ_UINT32)tccp->roishift,
-                                            tccp->cblksty)) {
-                            return OPJ_FALSE;
-                    }
+
+					if (p_modified_only && ! cblk->m_modified) {
+						continue;
+					}
+					cblk->m_modified = 0;
 
 					x = cblk->x0 - band->x0;
 					y = cblk->y0 - band->y0;
@@ -1312,44 +1342,12 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
 						y += pres->y1 - pres->y0;
 					}
 
-					datap=t1->data;
-					cblk_w = t1->w;
-					cblk_h = t1->h;
-
-					if (tccp->roishift) {
-						OPJ_INT32 thresh = 1 << tccp->roishift;
-						for (j = 0; j < cblk_h; ++j) {
-							for (i = 0; i < cblk_w; ++i) {
-								OPJ_INT32 val = datap[(j * cblk_w) + i];
-								OPJ_INT32 mag = abs(val);
-								if (mag >= thresh) {
-									mag >>= tccp->roishift;
-									datap[(j * cblk_w) + i] = val < 0 ? -mag : mag;
-								}
-							}
-						}
-					}
-					if (tccp->qmfbid == 1) {
-                        OPJ_INT32* restrict tiledp = &tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
-						for (j = 0; j < cblk_h; ++j) {
-							for (i = 0; i < cblk_w; ++i) {
-								OPJ_INT32 tmp = datap[(j * cblk_w) + i];
-								((OPJ_INT32*)tiledp)[(j * tile_w) + i] = tmp/2;
-							}
-						}
-					} else {		/* if (tccp->qmfbid == 0) */
-                        OPJ_FLOAT32* restrict tiledp = (OPJ_FLOAT32*) &tilec->data[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x];
-						for (j = 0; j < cblk_h; ++j) {
-                            OPJ_FLOAT32* restrict tiledp2 = tiledp;
-							for (i = 0; i < cblk_w; ++i) {
-                                OPJ_FLOAT32 tmp = (OPJ_FLOAT32)*datap * band->stepsize;
-                                *tiledp2 = tmp;
-                                datap++;
-                                tiledp2++;
-							}
-                            tiledp += tile_w;
-						}
+					if (! opj_t1_decode_cblk_into(t1, cblk, band, tccp,
+					                              &p_dest[(OPJ_UINT32)y * tile_w + (OPJ_UINT32)x],
+					                              tile_w)) {
+						return OPJ_FALSE;
 					}
+					++(*p_nb_decoded);
 				} /* cblkno */
 			} /* precno */
 		} /* bandno */
@@ -1357,6 +1355,67 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
         return OPJ_TRUE;
 }
 
+OPJ_BOOL opj_t1_decode_cblk_into(opj_t1_t* t1,
+                                 opj_tcd_cblk_dec_t* cblk,
+                                 opj_tcd_band_t* band,
+                                 opj_tccp_t* tccp,
+                                 OPJ_INT32 * p_dest,
+                                 OPJ_SIZE_T p_stride)
+{
+	OPJ_INT32* restrict datap;
+	OPJ_UINT32 cblk_w, cblk_h;
+	OPJ_UINT32 i, j;
+
+	if (OPJ_FALSE == opj_t1_decode_cblk(
+	                        t1,
+	                        cblk,
+	                        band->bandno,
+	                        (OPJ_UINT32)tccp->roishift,
+	                        tccp->cblksty)) {
+		return OPJ_FALSE;
+	}
+
+	datap=t1->data;
+	cblk_w = t1->w;
+	cblk_h = t1->h;
+
+	if (tccp->roishift) {
+		OPJ_INT32 thresh = 1 << tccp->roishift;
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				OPJ_INT32 val = datap[(j * cblk_w) + i];
+				OPJ_INT32 mag = abs(val);
+				if (mag >= thresh) {
+					mag >>= tccp->roishift;
+					datap[(j * cblk_w) + i] = val < 0 ? -mag : mag;
+				}
+			}
+		}
+	}
+	if (tccp->qmfbid == 1) {
+		OPJ_INT32* restrict tiledp = p_dest;
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				OPJ_INT32 tmp = datap[(j * cblk_w) + i];
+				((OPJ_INT32*)tiledp)[(j * p_stride) + i] = tmp/2;
+			}
+		}
+	} else {		/* if (tccp->qmfbid == 0) */
+		OPJ_FLOAT32* restrict tiledp = (OPJ_FLOAT32*) p_dest;
+		for (j = 0; j < cblk_h; ++j) {
+			OPJ_FLOAT32* restrict tiledp2 = tiledp;
+			for (i = 0; i < cblk_w; ++i) {
+				OPJ_FLOAT32 tmp = (OPJ_FLOAT32)*datap * band->stepsize;
+				*tiledp2 = tmp;
+				datap++;
+				tiledp2++;
+			}
+			tiledp += p_stride;
+		}
+	}
+	return OPJ_TRUE;
+}
+
 
 static OPJ_BOOL opj_t1_decode_cblk(opj_t1_t *t1,
                             opj_tcd_cblk_dec_t* cblk,
@@ -1466,7 +1525,7 @@ OPJ_BOOL opj_t1_encode_cblks(   opj_t1_t *t1,
 	for (compno = 0; compno < tile->numcomps; ++compno) {
 		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
 		opj_tccp_t* tccp = &tcp->tccps[compno];
-		OPJ_UINT32 tile_w = (OPJ_UINT32)(tilec->x1 - tilec->x0);
+		OPJ_SIZE_T tile_w = (OPJ_SIZE_T)(tilec->x1 - tilec->x0);
 
 		for (resno = 0; resno < tilec->numresolutions; ++resno) {
 			opj_tcd_resolution_t *res = &tilec->resolutions[resno];
@@ -1483,7 +1542,8 @@ OPJ_BOOL opj_t1_encode_cblks(   opj_t1_t *t1,
 						OPJ_INT32* restrict tiledp;
 						OPJ_UINT32 cblk_w;
 						OPJ_UINT32 cblk_h;
-						OPJ_UINT32 i, j, tileIndex=0, tileLineAdvance;
+						OPJ_UINT32 i, j;
+						OPJ_SIZE_T tileIndex=0, tileLineAdvance;
 
 						OPJ_INT32 x = cblk->x0 - band->x0;
 						OPJ_INT32 y = cblk->y0 - band->y0;
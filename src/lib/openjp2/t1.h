@@ -110,7 +110,7 @@ typedef struct opj_t1 {
 	OPJ_UINT32 datasize;
 	OPJ_UINT32 flagssize;
 	OPJ_UINT32 flags_stride;
-	OPJ_UINT32 data_stride;
+	OPJ_SIZE_T data_stride;
 	OPJ_BOOL   encoder;
 } opj_t1_t;
 
@@ -144,6 +144,37 @@ OPJ_BOOL opj_t1_decode_cblks(   opj_t1_t* t1,
                                 opj_tcd_tilecomp_t* tilec,
                                 opj_tccp_t* tccp);
 
+/**
+Decode the code-blocks of a tile component which received new passes since they were last
+decoded, see opj_tcd_cblk_dec_t::m_modified
+@param t1 T1 handle
+@param tilec The tile component to decode
+@param tccp Tile coding parameters
+@param p_dest Coefficients of the tile component, laid out as its data
+@param p_nb_decoded incremented by the number of code-blocks decoded
+*/
+OPJ_BOOL opj_t1_decode_modified_cblks(  opj_t1_t* t1,
+                                        opj_tcd_tilecomp_t* tilec,
+                                        opj_tccp_t* tccp,
+                                        OPJ_INT32 * p_dest,
+                                        OPJ_UINT32 * p_nb_decoded);
+
+/**
+Decode a code-block and store its dequantized coefficients
+@param t1 T1 handle
+@param cblk Code-block to decode
+@param band Band of the code-block
+@param tccp Tile coding parameters
+@param p_dest Destination of the first coefficient of the code-block
+@param p_stride Number of coefficients between two rows of p_dest
+*/
+OPJ_BOOL opj_t1_decode_cblk_into(opj_t1_t* t1,
+                                 opj_tcd_cblk_dec_t* cblk,
+                                 opj_tcd_band_t* band,
+                                 opj_tccp_t* tccp,
+                                 OPJ_INT32 * p_dest,
+                                 OPJ_SIZE_T p_stride);
+
 
 
 /**
@@ -58,31 +58,180 @@ static OPJ_UINT32 opj_t2_getnumpasses(opj_bio_t *bio);
 
 /**
 Encode a packet of a tile to a destination buffer
-@param tileno Number of the tile encoded
 @param tile Tile for which to write the packets
 @param tcp Tile coding parameters
-@param pi Packet identity
+@param packet Packet identity
+@param packno Number of the packet in its SOP marker
 @param dest Destination buffer
 @param p_data_written   FIXME DOC
 @param len Length of the destination buffer
-@param cstr_info Codestream information structure
+@param p_header_length Length of the header of the packet, for the index
+@param p_disto Distortion decrease brought by the packet, for the index
+@param p_t2_mode If == THRESH_CALC only the size of the packet is needed: its header is written but the data of its code-blocks is not copied
 @return
 */
-static OPJ_BOOL opj_t2_encode_packet(   OPJ_UINT32 tileno,
-                                        opj_tcd_tile_t *tile,
+static OPJ_BOOL opj_t2_encode_packet(   opj_tcd_tile_t *tile,
                                         opj_tcp_t *tcp,
-                                        opj_pi_iterator_t *pi,
+                                        const opj_pi_packet_t *packet,
+                                        OPJ_UINT32 packno,
                                         OPJ_BYTE *dest,
                                         OPJ_UINT32 * p_data_written,
                                         OPJ_UINT32 len,
-                                        opj_codestream_info_t *cstr_info);
+                                        OPJ_UINT32 * p_header_length,
+                                        OPJ_FLOAT64 * p_disto,
+                                        J2K_T2_MODE p_t2_mode);
+
+/**
+Upper bound of the size of a packet written by opj_t2_encode_packet.
+@param p_tile Tile of the packet
+@param p_tcp Tile coding parameters
+@param p_packet Packet identity
+@param p_data_size Size of the data of the code-blocks in the packet
+@return the maximum size of the header of the packet, with its SOP and EPH markers
+*/
+static OPJ_SIZE_T opj_t2_get_packet_header_max_size(opj_tcd_tile_t *p_tile,
+                                                    opj_tcp_t *p_tcp,
+                                                    const opj_pi_packet_t *p_packet,
+                                                    OPJ_SIZE_T * p_data_size);
+
+/**
+Give the packets to encode or decode to the jobs of their precincts, see opj_t2_precinct_job_t.
+@param p_t2 T2 handle, keeping the jobs
+@param p_tile Tile of the packets
+@param p_packets Packets of the tile, in progression order
+@param p_nb_packets Number of packets
+@param p_maxlayers Number of layers to encode
+@param p_pino Progression order change of the packets to encode, in FINAL_PASS
+@param p_t2_mode THRESH_CALC or FINAL_PASS, THRESH_CALC giving the jobs all the packets of p_maxlayers
+@param p_nb_packet_jobs Number of packets given to the jobs, in p_t2->packet_jobs
+@return false if there is not enough memory
+*/
+static OPJ_BOOL opj_t2_get_packet_jobs( opj_t2_t *p_t2,
+                                        opj_tcd_tile_t *p_tile,
+                                        const opj_pi_packet_t *p_packets,
+                                        OPJ_UINT32 p_nb_packets,
+                                        OPJ_UINT32 p_maxlayers,
+                                        OPJ_UINT32 p_pino,
+                                        J2K_T2_MODE p_t2_mode,
+                                        OPJ_UINT32 * p_nb_packet_jobs);
+
+/**
+Encode the packets of a precinct, one after the other, into the buffer of its job. In THRESH_CALC
+only the lengths of the packets are kept: their headers are all written at the start of the buffer.
+@param p_t2 T2 handle, keeping the jobs
+@param p_jobno Index of the job in p_t2->precinct_jobs
+@param p_tile Tile of the packets
+@param p_tcp Tile coding parameters
+@param p_t2_mode THRESH_CALC or FINAL_PASS
+@return false if there is not enough memory or a packet could not be encoded
+*/
+static OPJ_BOOL opj_t2_encode_precinct_job( opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_jobno,
+                                            opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            J2K_T2_MODE p_t2_mode);
+
+/**
+Encode packets of a tile with the jobs of their precincts. The jobs are run one after the other,
+the packets are then found in progression order in p_t2->packet_jobs.
+@param p_t2 T2 handle, keeping the jobs
+@param p_tile_no Index of the tile
+@param p_tile Tile of the packets
+@param p_packets Packets of the tile, in progression order
+@param p_nb_packets Number of packets
+@param p_maxlayers Number of layers to encode
+@param p_pino Progression order change of the packets to encode, in FINAL_PASS
+@param p_t2_mode THRESH_CALC or FINAL_PASS
+@param p_max_len Length the packets must fit in: the jobs stop once they exceed it
+@param p_nb_packet_jobs Number of packets encoded, in p_t2->packet_jobs
+@return false if the packets could not be encoded or do not fit in p_max_len
+*/
+static OPJ_BOOL opj_t2_encode_packet_jobs(  opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_tile_no,
+                                            opj_tcd_tile_t *p_tile,
+                                            const opj_pi_packet_t *p_packets,
+                                            OPJ_UINT32 p_nb_packets,
+                                            OPJ_UINT32 p_maxlayers,
+                                            OPJ_UINT32 p_pino,
+                                            J2K_T2_MODE p_t2_mode,
+                                            OPJ_UINT32 p_max_len,
+                                            OPJ_UINT32 * p_nb_packet_jobs);
+
+/**
+Check a packet encoded by a job against the length left for the packets of the tile, the way
+opj_t2_encode_packet used to check it while writing: the SOP and EPH markers are taken off the
+length without checking it first.
+@param p_tcp Tile coding parameters
+@param p_packet_job Packet encoded
+@param p_max_len Length left for the packets of the tile
+@return true if the packet would have been written in p_max_len
+*/
+static OPJ_BOOL opj_t2_packet_job_fits(   opj_tcp_t *p_tcp,
+                                        const opj_t2_packet_job_t *p_packet_job,
+                                        OPJ_UINT32 p_max_len);
+
+/**
+Record the header length and distortion of a packet encoded by a job in the codestream information.
+@param cstr_info Codestream information structure
+@param p_tile_no Index of the tile
+@param p_packet_job Packet encoded
+*/
+static void opj_t2_index_packet_job(opj_codestream_info_t *cstr_info,
+                                    OPJ_UINT32 p_tile_no,
+                                    const opj_t2_packet_job_t *p_packet_job);
+
+/**
+Tell if a packet is decoded or only skipped, from the layers, resolutions and components to decode.
+@param p_tile Tile of the packet
+@param p_tcp Tile coding parameters
+@param p_packet Packet identity
+@return true if the packet is decoded
+*/
+static OPJ_BOOL opj_t2_is_packet_decoded(   opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            const opj_pi_packet_t *p_packet);
+
+/**
+Decode the packets of a precinct, one after the other, from their positions in the data of the tile.
+@param p_t2 T2 handle, keeping the jobs
+@param p_jobno Index of the job in p_t2->precinct_jobs
+@param p_tile Tile of the packets
+@param p_tcp Tile coding parameters
+@param p_src Data of the tile
+@param p_manager the user event manager
+@return false if a packet could not be decoded or its length is not the one of the PLT markers
+*/
+static OPJ_BOOL opj_t2_decode_precinct_job( opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_jobno,
+                                            opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            OPJ_BYTE *p_src,
+                                            opj_event_mgr_t *p_manager);
+
+/**
+Decode the packets of a tile with the jobs of their precincts, the packets being located in the
+data of the tile by the lengths of the PLT markers. The jobs are run one after the other.
+@param p_t2 T2 handle, keeping the jobs
+@param p_tile_no Index of the tile
+@param p_tile Tile of the packets, whose packets are listed in p_tile->order
+@param p_src Data of the tile, holding all its packets
+@param p_packet_lengths Length of each packet of p_tile->order
+@param p_manager the user event manager
+@return false if the packets could not be decoded
+*/
+static OPJ_BOOL opj_t2_decode_packet_jobs(  opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_tile_no,
+                                            opj_tcd_tile_t *p_tile,
+                                            OPJ_BYTE *p_src,
+                                            const OPJ_UINT32 *p_packet_lengths,
+                                            opj_event_mgr_t *p_manager);
 
 /**
 Decode a packet of a tile from a source buffer
 @param t2 T2 handle
 @param tile Tile for which to write the packets
 @param tcp Tile coding parameters
-@param pi Packet identity
+@param packet Packet identity
 @param src Source buffer
 @param data_read   FIXME DOC
 @param max_length  FIXME DOC
@@ -93,48 +242,48 @@ Decode a packet of a tile from a source buffer
 static OPJ_BOOL opj_t2_decode_packet(   opj_t2_t* t2,
                                         opj_tcd_tile_t *tile,
                                         opj_tcp_t *tcp,
-                                        opj_pi_iterator_t *pi,
+                                        const opj_pi_packet_t *packet,
                                         OPJ_BYTE *src,
                                         OPJ_UINT32 * data_read,
-                                        OPJ_UINT32 max_length,
+                                        OPJ_SIZE_T max_length,
                                         opj_packet_info_t *pack_info,
                                         opj_event_mgr_t *p_manager);
 
 static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
                                     opj_tcd_tile_t *p_tile,
                                     opj_tcp_t *p_tcp,
-                                    opj_pi_iterator_t *p_pi,
+                                    const opj_pi_packet_t *p_packet,
                                     OPJ_BYTE *p_src,
                                     OPJ_UINT32 * p_data_read,
-                                    OPJ_UINT32 p_max_length,
+                                    OPJ_SIZE_T p_max_length,
                                     opj_packet_info_t *p_pack_info,
                                     opj_event_mgr_t *p_manager);
 
 static OPJ_BOOL opj_t2_read_packet_header(  opj_t2_t* p_t2,
                                             opj_tcd_tile_t *p_tile,
                                             opj_tcp_t *p_tcp,
-                                            opj_pi_iterator_t *p_pi,
+                                            const opj_pi_packet_t *p_packet,
                                             OPJ_BOOL * p_is_data_present,
                                             OPJ_BYTE *p_src_data,
                                             OPJ_UINT32 * p_data_read,
-                                            OPJ_UINT32 p_max_length,
+                                            OPJ_SIZE_T p_max_length,
                                             opj_packet_info_t *p_pack_info,
                                             opj_event_mgr_t *p_manager);
 
 static OPJ_BOOL opj_t2_read_packet_data(opj_t2_t* p_t2,
                                         opj_tcd_tile_t *p_tile,
-                                        opj_pi_iterator_t *p_pi,
+                                        const opj_pi_packet_t *p_packet,
                                         OPJ_BYTE *p_src_data,
                                         OPJ_UINT32 * p_data_read,
-                                        OPJ_UINT32 p_max_length,
+                                        OPJ_SIZE_T p_max_length,
                                         opj_packet_info_t *pack_info,
                                         opj_event_mgr_t *p_manager);
 
 static OPJ_BOOL opj_t2_skip_packet_data(opj_t2_t* p_t2,
                                         opj_tcd_tile_t *p_tile,
-                                        opj_pi_iterator_t *p_pi,
+                                        const opj_pi_packet_t *p_packet,
                                         OPJ_UINT32 * p_data_read,
-                                        OPJ_UINT32 p_max_length,
+                                        OPJ_SIZE_T p_max_length,
                                         opj_packet_info_t *pack_info,
                                         opj_event_mgr_t *p_manager);
 
@@ -149,6 +298,79 @@ static OPJ_BOOL opj_t2_init_seg(    opj_tcd_cblk_dec_t* cblk,
                                     OPJ_UINT32 cblksty,
                                     OPJ_UINT32 first);
 
+/**
+Save the state of the code-blocks and tag trees of the precinct of a packet, so that
+opj_t2_restore_precinct can undo the reading of the packet.
+@param p_tile Tile of the packet
+@param p_packet Packet identity
+@param p_incr State of the tile decoded incrementally, holding the saved state
+@return false if there is not enough memory
+*/
+static OPJ_BOOL opj_t2_save_precinct(   opj_tcd_tile_t *p_tile,
+                                        const opj_pi_packet_t *p_packet,
+                                        opj_tcd_incr_tile_t *p_incr);
+
+/**
+Restore the state of the precinct of a packet saved by opj_t2_save_precinct. The buffers of
+the code-blocks are kept as they are, only the data and segments they had are used again.
+@param p_tile Tile of the packet
+@param p_packet Packet identity
+@param p_incr State of the tile decoded incrementally, holding the saved state
+@return false if a code-block lost its buffers for lack of memory
+*/
+static OPJ_BOOL opj_t2_restore_precinct(opj_tcd_tile_t *p_tile,
+                                        const opj_pi_packet_t *p_packet,
+                                        opj_tcd_incr_tile_t *p_incr);
+
+/**
+List the packets of a tile in their decoding order, once per tile.
+@param p_t2 T2 handle
+@param p_tile_no Index of the tile
+@param p_tile Tile keeping the list of its packets
+@return false if the packets could not be listed
+*/
+static OPJ_BOOL opj_t2_get_decode_order(opj_t2_t *p_t2,
+                                        OPJ_UINT32 p_tile_no,
+                                        opj_tcd_tile_t *p_tile);
+
+/**
+List the packets of a tile in the order the rate allocation encodes them, once per tile.
+@param p_t2 T2 handle
+@param p_tile_no Index of the tile
+@param p_tile Tile keeping the list of its packets
+@param p_tp_pos Position of the tile-part flag in the progression order
+@return false if the packets could not be listed
+*/
+static OPJ_BOOL opj_t2_get_encode_order(opj_t2_t *p_t2,
+                                        OPJ_UINT32 p_tile_no,
+                                        opj_tcd_tile_t *p_tile,
+                                        OPJ_INT32 p_tp_pos);
+
+/**
+Encode a list of packets while calculating the rate allocation threshold.
+@param p_t2 T2 handle
+@param p_tile_no Index of the tile
+@param p_tile Tile for which to write the packets
+@param p_maxlayers Number of layers to encode
+@param p_packets Packets to encode
+@param p_nb_packets Number of packets to encode
+@param p_data_written Increased by the number of bytes written
+@param p_max_len Length of the buffer left, decreased by the bytes written
+@param p_comp_len Increased by the number of bytes written for the component
+@param cstr_info Codestream information structure
+@return false if the packets do not fit
+*/
+static OPJ_BOOL opj_t2_encode_thresh_packets(   opj_t2_t* p_t2,
+                                                OPJ_UINT32 p_tile_no,
+                                                opj_tcd_tile_t *p_tile,
+                                                OPJ_UINT32 p_maxlayers,
+                                                const opj_pi_packet_t *p_packets,
+                                                OPJ_UINT32 p_nb_packets,
+                                                OPJ_UINT32 * p_data_written,
+                                                OPJ_UINT32 * p_max_len,
+                                                OPJ_UINT32 * p_comp_len,
+                                                opj_codestream_info_t *cstr_info);
+
 /*@}*/
 
 /*@}*/
@@ -218,8 +440,14 @@ OPJ_BOOL opj_t2_encode_packets( opj_t2_t* p_t2,
         OPJ_UINT32 l_nb_bytes = 0;
         OPJ_UINT32 compno;
         OPJ_UINT32 poc;
+        OPJ_UINT32 i;
         opj_pi_iterator_t *l_pi = 00;
-        opj_pi_iterator_t *l_current_pi = 00;
+        opj_pi_packet_t *l_packets = 00;
+        OPJ_UINT32 l_nb_packets = 0;
+        OPJ_UINT32 l_max_packets = 0;
+        const opj_pi_packet_t *l_list = 00;
+        OPJ_UINT32 l_list_size = 0;
+        OPJ_UINT32 l_nb_packet_jobs = 0;
         opj_image_t *l_image = p_t2->image;
         opj_cp_t *l_cp = p_t2->cp;
         opj_tcp_t *l_tcp = &l_cp->tcps[p_tile_no];
@@ -227,19 +455,27 @@ OPJ_BOOL opj_t2_encode_packets( opj_t2_t* p_t2,
         OPJ_UINT32 l_max_comp = l_cp->m_specific_param.m_enc.m_max_comp_size > 0 ? l_image->numcomps : 1;
         OPJ_UINT32 l_nb_pocs = l_tcp->numpocs + 1;
 
-        l_pi = opj_pi_initialise_encode(l_image, l_cp, p_tile_no, p_t2_mode);
-        if (!l_pi) {
-                return OPJ_FALSE;
-        }
-
         * p_data_written = 0;
 
         if (p_t2_mode == THRESH_CALC ){ /* Calculating threshold */
-                l_current_pi = l_pi;
+                if (l_max_comp == 1) {
+                        /* the rate allocation encodes the same packets for each threshold it tries */
+                        OPJ_UINT32 l_comp_len = 0;
+
+                        if (! opj_t2_get_encode_order(p_t2, p_tile_no, p_tile, p_tp_pos)) {
+                                return OPJ_FALSE;
+                        }
+                        return opj_t2_encode_thresh_packets(p_t2, p_tile_no, p_tile, p_maxlayers, p_tile->order, p_tile->order_size, p_data_written, &p_max_len, &l_comp_len, cstr_info);
+                }
+
+                /* one tile-part per component: the packets of each one are listed with its own packet iterators */
+                l_pi = opj_pi_initialise_encode(l_image, l_cp, p_tile_no, p_t2_mode);
+                if (!l_pi) {
+                        return OPJ_FALSE;
+                }
 
                 for     (compno = 0; compno < l_max_comp; ++compno) {
                         OPJ_UINT32 l_comp_len = 0;
-                        l_current_pi = l_pi;
 
                         for (poc = 0; poc < pocno ; ++poc) {
                                 OPJ_UINT32 l_tp_num = compno;
@@ -247,90 +483,624 @@ OPJ_BOOL opj_t2_encode_packets( opj_t2_t* p_t2,
                                 /* TODO MSD : check why this function cannot fail (cf. v1) */
                                 opj_pi_create_encode(l_pi, l_cp,p_tile_no,poc,l_tp_num,p_tp_pos,p_t2_mode);
 
-                                if (l_current_pi->poc.prg == OPJ_PROG_UNKNOWN) {
-                                    /* TODO ADE : add an error */
-                                    opj_pi_destroy(l_pi, l_nb_pocs);
-                                    return OPJ_FALSE;
+                                l_nb_packets = 0;
+                                if (l_pi[poc].poc.prg == OPJ_PROG_UNKNOWN
+                                    || ! opj_pi_list_packets(&l_pi[poc], poc, &l_packets, &l_nb_packets, &l_max_packets)
+                                    || ! opj_t2_encode_thresh_packets(p_t2, p_tile_no, p_tile, p_maxlayers, l_packets, l_nb_packets, p_data_written, &p_max_len, &l_comp_len, cstr_info)) {
+                                        /* TODO ADE : add an error */
+                                        opj_pi_destroy(l_pi, l_nb_pocs);
+                                        opj_free(l_packets);
+                                        return OPJ_FALSE;
                                 }
-                                while (opj_pi_next(l_current_pi)) {
-                                        if (l_current_pi->layno < p_maxlayers) {
-                                                l_nb_bytes = 0;
+                        }
+                }
 
-                                                if (! opj_t2_encode_packet(p_tile_no,p_tile, l_tcp, l_current_pi, l_current_data, &l_nb_bytes, p_max_len, cstr_info)) {
-                                                        opj_pi_destroy(l_pi, l_nb_pocs);
-                                                        return OPJ_FALSE;
-                                                }
+                opj_pi_destroy(l_pi, l_nb_pocs);
+                opj_free(l_packets);
+                return OPJ_TRUE;
+        }
 
-                                                l_comp_len += l_nb_bytes;
-                                                l_current_data += l_nb_bytes;
-                                                p_max_len -= l_nb_bytes;
+        /* t2_mode == FINAL_PASS  */
+        if (p_tile->order_valid && ! l_tcp->POC && ! l_cp->m_specific_param.m_enc.m_tp_on) {
+                /* without tile-parts and progression order changes, the rate allocation listed the same packets */
+                l_list = p_tile->order;
+                l_list_size = p_tile->order_size;
+        }
+        else {
+                l_pi = opj_pi_initialise_encode(l_image, l_cp, p_tile_no, p_t2_mode);
+                if (!l_pi) {
+                        return OPJ_FALSE;
+                }
+                opj_pi_create_encode(l_pi, l_cp,p_tile_no,p_pino,p_tp_num,p_tp_pos,p_t2_mode);
 
-                                                * p_data_written += l_nb_bytes;
-                                        }
-                                }
+                if (l_pi[p_pino].poc.prg == OPJ_PROG_UNKNOWN
+                    || ! opj_pi_list_packets(&l_pi[p_pino], p_pino, &l_packets, &l_nb_packets, &l_max_packets)) {
+                        /* TODO ADE : add an error */
+                        opj_pi_destroy(l_pi, l_nb_pocs);
+                        opj_free(l_packets);
+                        return OPJ_FALSE;
+                }
+                opj_pi_destroy(l_pi, l_nb_pocs);
+                l_list = l_packets;
+                l_list_size = l_nb_packets;
+        }
 
-                                if (l_cp->m_specific_param.m_enc.m_max_comp_size) {
-                                        if (l_comp_len > l_cp->m_specific_param.m_enc.m_max_comp_size) {
-                                                opj_pi_destroy(l_pi, l_nb_pocs);
-                                                return OPJ_FALSE;
-                                        }
+        if (! opj_t2_encode_packet_jobs(p_t2, p_tile_no, p_tile, l_list, l_list_size, p_maxlayers, p_pino, FINAL_PASS, p_max_len, &l_nb_packet_jobs)) {
+                opj_free(l_packets);
+                return OPJ_FALSE;
+        }
+        opj_free(l_packets);
+
+        /* the packets are put together in progression order */
+        for (i = 0; i < l_nb_packet_jobs; ++i) {
+                const opj_t2_packet_job_t *l_packet_job = &p_t2->packet_jobs[i];
+
+                l_nb_bytes = l_packet_job->length;
+                if (l_nb_bytes > p_max_len) {
+                        return OPJ_FALSE;
+                }
+                memcpy(l_current_data, p_t2->precinct_jobs[l_packet_job->jobno].data + l_packet_job->offset, l_nb_bytes);
+
+                l_current_data += l_nb_bytes;
+                p_max_len -= l_nb_bytes;
+
+                * p_data_written += l_nb_bytes;
+
+                /* INDEX >> */
+                if(cstr_info) {
+                        if(cstr_info->index_write) {
+                                opj_tile_info_t *info_TL = &cstr_info->tile[p_tile_no];
+                                opj_packet_info_t *info_PK = &info_TL->packet[cstr_info->packno];
+
+                                opj_t2_index_packet_job(cstr_info, p_tile_no, l_packet_job);
+                                if (!cstr_info->packno) {
+                                        info_PK->start_pos = info_TL->end_header + 1;
+                                } else {
+                                        info_PK->start_pos = ((l_cp->m_specific_param.m_enc.m_tp_on | l_tcp->POC)&& info_PK->start_pos) ? info_PK->start_pos : info_TL->packet[cstr_info->packno - 1].end_pos + 1;
                                 }
+                                info_PK->end_pos = info_PK->start_pos + l_nb_bytes - 1;
+                                info_PK->end_ph_pos += info_PK->start_pos - 1;  /* End of packet header which now only represents the distance
+                                                                                                                                                                                                                                   to start of packet is incremented by value of start of packet*/
+                        }
+
+                        cstr_info->packno++;
+                }
+                /* << INDEX */
+                if (p_tile->packet_lengths && p_tile->packno < p_tile->nb_packets) {
+                        p_tile->packet_lengths[p_tile->packno] = l_nb_bytes;
+                }
+                ++p_tile->packno;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_encode_thresh_packets(   opj_t2_t* p_t2,
+                                                OPJ_UINT32 p_tile_no,
+                                                opj_tcd_tile_t *p_tile,
+                                                OPJ_UINT32 p_maxlayers,
+                                                const opj_pi_packet_t *p_packets,
+                                                OPJ_UINT32 p_nb_packets,
+                                                OPJ_UINT32 * p_data_written,
+                                                OPJ_UINT32 * p_max_len,
+                                                OPJ_UINT32 * p_comp_len,
+                                                opj_codestream_info_t *cstr_info)
+{
+        opj_cp_t *l_cp = p_t2->cp;
+        OPJ_UINT32 l_nb_packet_jobs = 0;
+        OPJ_UINT32 i;
+
+        if (! opj_t2_encode_packet_jobs(p_t2, p_tile_no, p_tile, p_packets, p_nb_packets, p_maxlayers, 0, THRESH_CALC, 0xFFFFFFFFU, &l_nb_packet_jobs)) {
+                return OPJ_FALSE;
+        }
+
+        for (i = 0; i < l_nb_packet_jobs; ++i) {
+                const opj_t2_packet_job_t *l_packet_job = &p_t2->packet_jobs[i];
+                OPJ_UINT32 l_nb_bytes = l_packet_job->length;
+
+                if (! opj_t2_packet_job_fits(&l_cp->tcps[p_tile_no], l_packet_job, *p_max_len)) {
+                        return OPJ_FALSE;
+                }
+
+                /* << INDEX */
+                if(cstr_info && cstr_info->index_write) {
+                        opj_t2_index_packet_job(cstr_info, p_tile_no, l_packet_job);
+                }
+                /* INDEX >> */
+
+                *p_comp_len += l_nb_bytes;
+                *p_max_len -= l_nb_bytes;
+
+                * p_data_written += l_nb_bytes;
+
+                /* the length of the packet in the PLT markers counts in the rate too */
+                if (l_cp->m_specific_param.m_enc.m_plt) {
+                        OPJ_UINT32 l_plt_bytes = opj_t2_get_plt_length_size(l_nb_bytes);
 
-                                ++l_current_pi;
+                        if (l_plt_bytes > *p_max_len) {
+                                return OPJ_FALSE;
                         }
+                        *p_max_len -= l_plt_bytes;
                 }
         }
-        else {  /* t2_mode == FINAL_PASS  */
-                opj_pi_create_encode(l_pi, l_cp,p_tile_no,p_pino,p_tp_num,p_tp_pos,p_t2_mode);
 
-                l_current_pi = &l_pi[p_pino];
-                if (l_current_pi->poc.prg == OPJ_PROG_UNKNOWN) {
-                    /* TODO ADE : add an error */
-                    opj_pi_destroy(l_pi, l_nb_pocs);
-                    return OPJ_FALSE;
+        if (l_cp->m_specific_param.m_enc.m_max_comp_size) {
+                if (*p_comp_len > l_cp->m_specific_param.m_enc.m_max_comp_size) {
+                        return OPJ_FALSE;
                 }
-                while (opj_pi_next(l_current_pi)) {
-                        if (l_current_pi->layno < p_maxlayers) {
-                                l_nb_bytes=0;
+        }
 
-                                if (! opj_t2_encode_packet(p_tile_no,p_tile, l_tcp, l_current_pi, l_current_data, &l_nb_bytes, p_max_len, cstr_info)) {
-                                        opj_pi_destroy(l_pi, l_nb_pocs);
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_get_encode_order(opj_t2_t *p_t2,
+                                        OPJ_UINT32 p_tile_no,
+                                        opj_tcd_tile_t *p_tile,
+                                        OPJ_INT32 p_tp_pos)
+{
+        opj_cp_t *l_cp = p_t2->cp;
+        OPJ_UINT32 l_nb_pocs = l_cp->tcps[p_tile_no].numpocs + 1;
+        OPJ_UINT32 pocno = (l_cp->rsiz == OPJ_PROFILE_CINEMA_4K)? 2: 1;
+        opj_pi_iterator_t *l_pi;
+        OPJ_UINT32 poc;
+        OPJ_BOOL l_result = OPJ_TRUE;
+
+        if (p_tile->order_valid) {
+                return OPJ_TRUE;
+        }
+
+        l_pi = opj_pi_initialise_encode(p_t2->image, l_cp, p_tile_no, THRESH_CALC);
+        if (!l_pi) {
+                return OPJ_FALSE;
+        }
+
+        p_tile->order_size = 0;
+        for (poc = 0; l_result && poc < pocno; ++poc) {
+                opj_pi_create_encode(l_pi, l_cp, p_tile_no, poc, 0, p_tp_pos, THRESH_CALC);
+                l_result = l_pi[poc].poc.prg != OPJ_PROG_UNKNOWN
+                        && opj_pi_list_packets(&l_pi[poc], poc, &p_tile->order, &p_tile->order_size, &p_tile->order_max_size);
+        }
+
+        opj_pi_destroy(l_pi, l_nb_pocs);
+        p_tile->order_valid = l_result;
+        return l_result;
+}
+
+static OPJ_SIZE_T opj_t2_get_packet_header_max_size(opj_tcd_tile_t *p_tile,
+                                                    opj_tcp_t *p_tcp,
+                                                    const opj_pi_packet_t *p_packet,
+                                                    OPJ_SIZE_T * p_data_size)
+{
+        opj_tcd_resolution_t *l_res = &p_tile->comps[p_packet->compno].resolutions[p_packet->resno];
+        OPJ_SIZE_T l_nb_bits = 1;   /* empty header bit */
+        OPJ_SIZE_T l_data_size = 0;
+        OPJ_SIZE_T l_size;
+        OPJ_UINT32 bandno, cblkno;
+
+        for (bandno = 0; bandno < l_res->numbands; ++bandno) {
+                opj_tcd_band_t *l_band = &l_res->bands[bandno];
+                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
+                OPJ_UINT32 l_nb_blocks = l_prc->cw * l_prc->ch;
+
+                /* a tag tree writes at most threshold - low + 1 bits per node and packet */
+                if (l_prc->incltree) {
+                        l_nb_bits += (OPJ_SIZE_T)l_prc->incltree->numnodes * (p_packet->layno + 2U);
+                }
+                if (l_prc->imsbtree) {
+                        l_nb_bits += (OPJ_SIZE_T)l_prc->imsbtree->numnodes * ((OPJ_UINT32)opj_int_max(l_band->numbps, 0) + 2U);
+                }
+                for (cblkno = 0; cblkno < l_nb_blocks; ++cblkno) {
+                        opj_tcd_layer_t *l_layer = &l_prc->cblks.enc[cblkno].layers[p_packet->layno];
+
+                        /* inclusion bit, number of passes and length indicator increase, then the length of each segment */
+                        l_nb_bits += 1 + 16 + 33 + 64 * (OPJ_SIZE_T)l_layer->numpasses;
+                        l_data_size += l_layer->len;
+                }
+        }
+
+        /* a byte following 0xff only holds 7 bits, and the BIO component is flushed */
+        l_size = l_nb_bits / 7 + 2;
+        if (p_tcp->csty & J2K_CP_CSTY_SOP) {
+                l_size += 6;
+        }
+        if (p_tcp->csty & J2K_CP_CSTY_EPH) {
+                l_size += 2;
+        }
+
+        *p_data_size = l_data_size;
+        return l_size;
+}
+
+static OPJ_BOOL opj_t2_get_packet_jobs( opj_t2_t *p_t2,
+                                        opj_tcd_tile_t *p_tile,
+                                        const opj_pi_packet_t *p_packets,
+                                        OPJ_UINT32 p_nb_packets,
+                                        OPJ_UINT32 p_maxlayers,
+                                        OPJ_UINT32 p_pino,
+                                        J2K_T2_MODE p_t2_mode,
+                                        OPJ_UINT32 * p_nb_packet_jobs)
+{
+        OPJ_UINT32 l_nb_entries = p_tile->numcomps;
+        OPJ_UINT32 l_resno_index, l_precno_index;
+        OPJ_UINT32 l_nb_packet_jobs = 0;
+        OPJ_UINT32 compno, resno, i;
+
+        /* the job of each precinct is found through the index of the first resolution of its
+           component, then through the index of the first precinct of its resolution */
+        for (compno = 0; compno < p_tile->numcomps; ++compno) {
+                opj_tcd_tilecomp_t *l_tilec = &p_tile->comps[compno];
+
+                l_nb_entries = opj_uint_adds(l_nb_entries, l_tilec->numresolutions);
+                for (resno = 0; resno < l_tilec->numresolutions; ++resno) {
+                        opj_tcd_resolution_t *l_res = &l_tilec->resolutions[resno];
+
+                        if (l_res->ph && l_res->pw > 0xFFFFFFFFU / l_res->ph) {
+                                return OPJ_FALSE;
+                        }
+                        l_nb_entries = opj_uint_adds(l_nb_entries, l_res->pw * l_res->ph);
+                }
+        }
+        if (l_nb_entries == 0xFFFFFFFFU) {
+                return OPJ_FALSE;
+        }
+        if (l_nb_entries > p_t2->nb_precincts_max) {
+                OPJ_UINT32 *l_new_entries = (OPJ_UINT32 *) opj_realloc(p_t2->job_of_precinct, l_nb_entries * sizeof(OPJ_UINT32));
+
+                if (! l_new_entries) {
+                        return OPJ_FALSE;
+                }
+                p_t2->job_of_precinct = l_new_entries;
+                p_t2->nb_precincts_max = l_nb_entries;
+        }
+        l_resno_index = p_tile->numcomps;
+        l_precno_index = l_resno_index;
+        for (compno = 0; compno < p_tile->numcomps; ++compno) {
+                l_precno_index += p_tile->comps[compno].numresolutions;
+        }
+        for (compno = 0; compno < p_tile->numcomps; ++compno) {
+                opj_tcd_tilecomp_t *l_tilec = &p_tile->comps[compno];
+
+                p_t2->job_of_precinct[compno] = l_resno_index;
+                for (resno = 0; resno < l_tilec->numresolutions; ++resno) {
+                        opj_tcd_resolution_t *l_res = &l_tilec->resolutions[resno];
+                        OPJ_UINT32 l_nb_precincts = l_res->pw * l_res->ph;
+
+                        p_t2->job_of_precinct[l_resno_index++] = l_precno_index;
+                        for (i = 0; i < l_nb_precincts; ++i) {
+                                p_t2->job_of_precinct[l_precno_index++] = 0xFFFFFFFFU;
+                        }
+                }
+        }
+
+        p_t2->nb_precinct_jobs = 0;
+        for (i = 0; i < p_nb_packets; ++i) {
+                const opj_pi_packet_t *l_packet = &p_packets[i];
+                opj_t2_packet_job_t *l_packet_job;
+                OPJ_UINT32 *l_jobno;
+
+                if (l_packet->layno >= p_maxlayers || (p_t2_mode == FINAL_PASS && l_packet->pino != p_pino)) {
+                        continue;
+                }
+
+                if (l_nb_packet_jobs == p_t2->nb_packet_jobs_max) {
+                        OPJ_UINT32 l_max_packets = p_t2->nb_packet_jobs_max ? 2 * p_t2->nb_packet_jobs_max : 64;
+                        opj_t2_packet_job_t *l_new_packet_jobs;
+
+                        if (l_max_packets > 0xFFFFFFFFU / sizeof(opj_t2_packet_job_t)) {
+                                return OPJ_FALSE;
+                        }
+                        l_new_packet_jobs = (opj_t2_packet_job_t *) opj_realloc(p_t2->packet_jobs, l_max_packets * sizeof(opj_t2_packet_job_t));
+                        if (! l_new_packet_jobs) {
+                                return OPJ_FALSE;
+                        }
+                        p_t2->packet_jobs = l_new_packet_jobs;
+                        p_t2->nb_packet_jobs_max = l_max_packets;
+                }
+
+                l_jobno = &p_t2->job_of_precinct[p_t2->job_of_precinct[p_t2->job_of_precinct[l_packet->compno] + l_packet->resno] + l_packet->precno];
+                if (*l_jobno == 0xFFFFFFFFU) {
+                        /* first packet of its precinct: a new job, whose buffer is kept from the previous calls */
+                        if (p_t2->nb_precinct_jobs == p_t2->nb_precinct_jobs_max) {
+                                OPJ_UINT32 l_max_jobs = p_t2->nb_precinct_jobs_max ? 2 * p_t2->nb_precinct_jobs_max : 64;
+                                opj_t2_precinct_job_t *l_new_jobs;
+
+                                if (l_max_jobs > 0xFFFFFFFFU / sizeof(opj_t2_precinct_job_t)) {
                                         return OPJ_FALSE;
                                 }
+                                l_new_jobs = (opj_t2_precinct_job_t *) opj_realloc(p_t2->precinct_jobs, l_max_jobs * sizeof(opj_t2_precinct_job_t));
+                                if (! l_new_jobs) {
+                                        return OPJ_FALSE;
+                                }
+                                memset(l_new_jobs + p_t2->nb_precinct_jobs_max, 0, (l_max_jobs - p_t2->nb_precinct_jobs_max) * sizeof(opj_t2_precinct_job_t));
+                                p_t2->precinct_jobs = l_new_jobs;
+                                p_t2->nb_precinct_jobs_max = l_max_jobs;
+                        }
+                        *l_jobno = p_t2->nb_precinct_jobs++;
+                        p_t2->precinct_jobs[*l_jobno].first = l_nb_packet_jobs;
+                }
+                else {
+                        p_t2->packet_jobs[p_t2->precinct_jobs[*l_jobno].last].next = l_nb_packet_jobs;
+                }
+                p_t2->precinct_jobs[*l_jobno].last = l_nb_packet_jobs;
+
+                l_packet_job = &p_t2->packet_jobs[l_nb_packet_jobs];
+                memset(l_packet_job, 0, sizeof(opj_t2_packet_job_t));
+                l_packet_job->packet = l_packet;
+                /* the packets are numbered in the order they are written, not in the rate allocation */
+                l_packet_job->packno = p_t2_mode == FINAL_PASS ? p_tile->packno + l_nb_packet_jobs : p_tile->packno;
+                l_packet_job->jobno = *l_jobno;
+                ++l_nb_packet_jobs;
+        }
 
-                                l_current_data += l_nb_bytes;
-                                p_max_len -= l_nb_bytes;
-
-                                * p_data_written += l_nb_bytes;
-
-                                /* INDEX >> */
-                                if(cstr_info) {
-                                        if(cstr_info->index_write) {
-                                                opj_tile_info_t *info_TL = &cstr_info->tile[p_tile_no];
-                                                opj_packet_info_t *info_PK = &info_TL->packet[cstr_info->packno];
-                                                if (!cstr_info->packno) {
-                                                        info_PK->start_pos = info_TL->end_header + 1;
-                                                } else {
-                                                        info_PK->start_pos = ((l_cp->m_specific_param.m_enc.m_tp_on | l_tcp->POC)&& info_PK->start_pos) ? info_PK->start_pos : info_TL->packet[cstr_info->packno - 1].end_pos + 1;
-                                                }
-                                                info_PK->end_pos = info_PK->start_pos + l_nb_bytes - 1;
-                                                info_PK->end_ph_pos += info_PK->start_pos - 1;  /* End of packet header which now only represents the distance
-                                                                                                                                                                                                                                                   to start of packet is incremented by value of start of packet*/
-                                        }
+        *p_nb_packet_jobs = l_nb_packet_jobs;
+        return OPJ_TRUE;
+}
 
-                                        cstr_info->packno++;
-                                }
-                                /* << INDEX */
-                                ++p_tile->packno;
+static OPJ_BOOL opj_t2_encode_precinct_job( opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_jobno,
+                                            opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            J2K_T2_MODE p_t2_mode)
+{
+        opj_t2_precinct_job_t *l_job = &p_t2->precinct_jobs[p_jobno];
+        OPJ_SIZE_T l_size = 0;
+        OPJ_SIZE_T l_offset = 0;
+        OPJ_UINT32 i;
+
+        /* room for the packets, or for the largest header when only the lengths are needed */
+        i = l_job->first;
+        for (;;) {
+                OPJ_SIZE_T l_data_size;
+                OPJ_SIZE_T l_header_size = opj_t2_get_packet_header_max_size(p_tile, p_tcp, p_t2->packet_jobs[i].packet, &l_data_size);
+
+                if (p_t2_mode == FINAL_PASS) {
+                        l_size = opj_size_adds(l_size, opj_size_adds(l_header_size, l_data_size));
+                }
+                else {
+                        l_size = opj_size_max(l_size, l_header_size);
+                }
+                if (i == l_job->last) {
+                        break;
+                }
+                i = p_t2->packet_jobs[i].next;
+        }
+        if (l_size > l_job->data_size) {
+                OPJ_BYTE *l_new_data = (OPJ_BYTE *) opj_realloc(l_job->data, l_size);
+
+                if (! l_new_data) {
+                        return OPJ_FALSE;
+                }
+                l_job->data = l_new_data;
+                l_job->data_size = l_size;
+        }
+
+        i = l_job->first;
+        for (;;) {
+                opj_t2_packet_job_t *l_packet_job = &p_t2->packet_jobs[i];
+                OPJ_SIZE_T l_data_size;
+                OPJ_SIZE_T l_max_size = opj_t2_get_packet_header_max_size(p_tile, p_tcp, l_packet_job->packet, &l_data_size);
+                OPJ_UINT32 l_nb_bytes = 0;
+
+                /* in THRESH_CALC the data of the code-blocks is not copied, only its length counts */
+                l_max_size = opj_size_adds(l_max_size, l_data_size);
+                if (l_max_size > 0xFFFFFFFFU) {
+                        return OPJ_FALSE;
+                }
+                l_packet_job->offset = l_offset;
+                if (! opj_t2_encode_packet(p_tile, p_tcp, l_packet_job->packet, l_packet_job->packno, l_job->data + l_offset, &l_nb_bytes, (OPJ_UINT32)l_max_size,
+                                           &l_packet_job->header_length, &l_packet_job->disto, p_t2_mode)) {
+                        return OPJ_FALSE;
+                }
+                l_packet_job->length = l_nb_bytes;
+                if (p_t2_mode == FINAL_PASS) {
+                        l_offset += l_nb_bytes;
+                }
+                if (i == l_job->last) {
+                        break;
+                }
+                i = l_packet_job->next;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_encode_packet_jobs(  opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_tile_no,
+                                            opj_tcd_tile_t *p_tile,
+                                            const opj_pi_packet_t *p_packets,
+                                            OPJ_UINT32 p_nb_packets,
+                                            OPJ_UINT32 p_maxlayers,
+                                            OPJ_UINT32 p_pino,
+                                            J2K_T2_MODE p_t2_mode,
+                                            OPJ_UINT32 p_max_len,
+                                            OPJ_UINT32 * p_nb_packet_jobs)
+{
+        opj_tcp_t *l_tcp = &p_t2->cp->tcps[p_tile_no];
+        OPJ_SIZE_T l_total_size = 0;
+        OPJ_UINT32 l_jobno;
+
+        if (! opj_t2_get_packet_jobs(p_t2, p_tile, p_packets, p_nb_packets, p_maxlayers, p_pino, p_t2_mode, p_nb_packet_jobs)) {
+                return OPJ_FALSE;
+        }
+
+        /* the jobs do not share any state: a thread pool could run them */
+        for (l_jobno = 0; l_jobno < p_t2->nb_precinct_jobs; ++l_jobno) {
+                opj_t2_precinct_job_t *l_job = &p_t2->precinct_jobs[l_jobno];
+                OPJ_UINT32 i;
+
+                if (! opj_t2_encode_precinct_job(p_t2, l_jobno, p_tile, l_tcp, p_t2_mode)) {
+                        return OPJ_FALSE;
+                }
+
+                /* the packets cannot fit any more: the rate allocation tries another threshold */
+                i = l_job->first;
+                for (;;) {
+                        l_total_size += p_t2->packet_jobs[i].length;
+                        if (i == l_job->last) {
+                                break;
                         }
+                        i = p_t2->packet_jobs[i].next;
+                }
+                if (l_total_size > p_max_len) {
+                        return OPJ_FALSE;
                 }
         }
 
-        opj_pi_destroy(l_pi, l_nb_pocs);
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_packet_job_fits(   opj_tcp_t *p_tcp,
+                                        const opj_t2_packet_job_t *p_packet_job,
+                                        OPJ_UINT32 p_max_len)
+{
+        OPJ_UINT32 l_header_length = p_packet_job->header_length;
+
+        if (p_tcp->csty & J2K_CP_CSTY_SOP) {
+                l_header_length -= 6;
+                p_max_len -= 6;
+        }
+        if (p_tcp->csty & J2K_CP_CSTY_EPH) {
+                l_header_length -= 2;
+        }
+        if (l_header_length > p_max_len) {
+                return OPJ_FALSE;
+        }
+        p_max_len -= l_header_length;
+        if (p_tcp->csty & J2K_CP_CSTY_EPH) {
+                p_max_len -= 2;
+        }
+        return p_packet_job->length - p_packet_job->header_length <= p_max_len;
+}
+
+static void opj_t2_index_packet_job(opj_codestream_info_t *cstr_info,
+                                    OPJ_UINT32 p_tile_no,
+                                    const opj_t2_packet_job_t *p_packet_job)
+{
+        opj_packet_info_t *info_PK = &cstr_info->tile[p_tile_no].packet[cstr_info->packno];
+
+        info_PK->end_ph_pos = (OPJ_INT32)p_packet_job->header_length;
+        info_PK->disto += p_packet_job->disto;
+        if (cstr_info->D_max < info_PK->disto) {
+                cstr_info->D_max = info_PK->disto;
+        }
+}
+
+static OPJ_BOOL opj_t2_is_packet_decoded(   opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            const opj_pi_packet_t *p_packet)
+{
+        return p_tcp->num_layers_to_decode > p_packet->layno
+                && p_packet->resno < p_tile->comps[p_packet->compno].minimum_num_resolutions
+                && ! p_tile->comps[p_packet->compno].skipped;
+}
+
+static OPJ_BOOL opj_t2_decode_precinct_job( opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_jobno,
+                                            opj_tcd_tile_t *p_tile,
+                                            opj_tcp_t *p_tcp,
+                                            OPJ_BYTE *p_src,
+                                            opj_event_mgr_t *p_manager)
+{
+        const opj_t2_precinct_job_t *l_job = &p_t2->precinct_jobs[p_jobno];
+        OPJ_UINT32 i = l_job->first;
+
+        for (;;) {
+                const opj_t2_packet_job_t *l_packet_job = &p_t2->packet_jobs[i];
+                const opj_pi_packet_t *l_packet = l_packet_job->packet;
+
+                if (opj_t2_is_packet_decoded(p_tile, p_tcp, l_packet)) {
+                        OPJ_UINT32 l_nb_bytes_read = 0;
+
+                        if (! opj_t2_decode_packet(p_t2, p_tile, p_tcp, l_packet, p_src + l_packet_job->offset, &l_nb_bytes_read, l_packet_job->length, 00, p_manager)) {
+                                return OPJ_FALSE;
+                        }
+                        if (l_nb_bytes_read != l_packet_job->length) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Packet of length %d instead of %d given by the PLT markers (p=%d, r=%d, c=%d, l=%d)\n",
+                                              l_nb_bytes_read, l_packet_job->length, l_packet->precno, l_packet->resno, l_packet->compno, l_packet->layno);
+                                return OPJ_FALSE;
+                        }
+                }
+                if (i == l_job->last) {
+                        break;
+                }
+                i = l_packet_job->next;
+        }
 
         return OPJ_TRUE;
 }
 
+static OPJ_BOOL opj_t2_decode_packet_jobs(  opj_t2_t *p_t2,
+                                            OPJ_UINT32 p_tile_no,
+                                            opj_tcd_tile_t *p_tile,
+                                            OPJ_BYTE *p_src,
+                                            const OPJ_UINT32 *p_packet_lengths,
+                                            opj_event_mgr_t *p_manager)
+{
+        opj_tcp_t *l_tcp = &p_t2->cp->tcps[p_tile_no];
+        OPJ_SIZE_T l_offset = 0;
+        OPJ_UINT32 l_nb_packet_jobs = 0;
+        OPJ_UINT32 l_jobno, i;
+
+        /* all the packets of the tile, the job of packet i being packet_jobs[i] */
+        if (! opj_t2_get_packet_jobs(p_t2, p_tile, p_tile->order, p_tile->order_size, 0xFFFFFFFFU, 0, THRESH_CALC, &l_nb_packet_jobs)) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the packets of tile %d\n", p_tile_no + 1);
+                return OPJ_FALSE;
+        }
+        for (i = 0; i < l_nb_packet_jobs; ++i) {
+                p_t2->packet_jobs[i].offset = l_offset;
+                p_t2->packet_jobs[i].length = p_packet_lengths[i];
+                l_offset += p_packet_lengths[i];
+        }
+
+        /* the jobs do not share any state: a thread pool could run them */
+        for (l_jobno = 0; l_jobno < p_t2->nb_precinct_jobs; ++l_jobno) {
+                if (! opj_t2_decode_precinct_job(p_t2, l_jobno, p_tile, l_tcp, p_src, p_manager)) {
+                        return OPJ_FALSE;
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_get_decode_order(opj_t2_t *p_t2,
+                                        OPJ_UINT32 p_tile_no,
+                                        opj_tcd_tile_t *p_tile)
+{
+        OPJ_UINT32 l_nb_pocs = p_t2->cp->tcps[p_tile_no].numpocs + 1;
+        opj_pi_iterator_t *l_pi;
+        OPJ_UINT32 pino;
+        OPJ_BOOL l_result = OPJ_TRUE;
+
+        if (p_tile->order_valid) {
+                return OPJ_TRUE;
+        }
+
+        l_pi = opj_pi_create_decode(p_t2->image, p_t2->cp, p_tile_no);
+        if (!l_pi) {
+                return OPJ_FALSE;
+        }
+
+        p_tile->order_size = 0;
+        for (pino = 0; l_result && pino < l_nb_pocs; ++pino) {
+                l_result = l_pi[pino].poc.prg != OPJ_PROG_UNKNOWN
+                        && opj_pi_list_packets(&l_pi[pino], pino, &p_tile->order, &p_tile->order_size, &p_tile->order_max_size);
+        }
+
+        opj_pi_destroy(l_pi, l_nb_pocs);
+        p_tile->order_valid = l_result;
+        return l_result;
+}
+
+OPJ_UINT32 opj_t2_get_plt_length_size(OPJ_UINT32 p_length)
+{
+        OPJ_UINT32 l_nb_bytes = 1;
+
+        while (l_nb_bytes < 5 && (p_length >> (7 * l_nb_bytes))) {
+                ++l_nb_bytes;
+        }
+        return l_nb_bytes;
+}
+
 /* see issue 80 */
 #if 0
 #define JAS_FPRINTF fprintf
@@ -348,26 +1118,30 @@ OPJ_BOOL opj_t2_decode_packets( opj_t2_t *p_t2,
                                 OPJ_UINT32 p_tile_no,
                                 opj_tcd_tile_t *p_tile,
                                 OPJ_BYTE *p_src,
-                                OPJ_UINT32 * p_data_read,
-                                OPJ_UINT32 p_max_len,
+                                OPJ_SIZE_T * p_data_read,
+                                OPJ_SIZE_T p_max_len,
                                 opj_codestream_index_t *p_cstr_index,
                                 opj_event_mgr_t *p_manager)
 {
         OPJ_BYTE *l_current_data = p_src;
-        opj_pi_iterator_t *l_pi = 00;
-        OPJ_UINT32 pino;
+        OPJ_UINT32 i;
         opj_image_t *l_image = p_t2->image;
-        opj_cp_t *l_cp = p_t2->cp;
         opj_tcp_t *l_tcp = &(p_t2->cp->tcps[p_tile_no]);
         OPJ_UINT32 l_nb_bytes_read;
-        OPJ_UINT32 l_nb_pocs = l_tcp->numpocs + 1;
-        opj_pi_iterator_t *l_current_pi = 00;
+        const OPJ_UINT32 *l_packet_lengths = 00;
+        OPJ_BOOL l_decoded_by_jobs = OPJ_FALSE;
 #ifdef TODO_MSD
         OPJ_UINT32 curtp = 0;
         OPJ_UINT32 tp_start_packno;
 #endif 
         opj_packet_info_t *l_pack_info = 00;
         opj_image_comp_t* l_img_comp = 00;
+        /* if the resolution needed is too low, one dim of the tilec could be equal to zero
+         * and no packets are used to decode this resolution and
+         * l_packet->resno is always >= p_tile->comps[l_packet->compno].minimum_num_resolutions
+         * and no l_img_comp->resno_decoded are computed
+         */
+        OPJ_BOOL* first_pass_failed = NULL;
 
         OPJ_ARG_NOT_USED(p_cstr_index);
 
@@ -377,102 +1151,114 @@ OPJ_BOOL opj_t2_decode_packets( opj_t2_t *p_t2,
         }
 #endif
 
-        /* create a packet iterator */
-        l_pi = opj_pi_create_decode(l_image, l_cp, p_tile_no);
-        if (!l_pi) {
+        /* list the packets of the tile */
+        if (! opj_t2_get_decode_order(p_t2, p_tile_no, p_tile)) {
+                /* TODO ADE : add an error */
                 return OPJ_FALSE;
         }
 
+        /* a packet not decoded is never followed by a decoded packet of the same precinct, which
+           would need the state its header leaves: with the lengths of the PLT markers, it is jumped
+           over without reading its header. The headers of PPM and PPT markers are read in order. */
+        if (l_tcp->m_nb_packet_lengths == p_tile->order_size && ! l_tcp->plt_ignored
+                        && ! p_t2->cp->ppm && ! l_tcp->ppt) {
+                l_packet_lengths = l_tcp->m_packet_lengths;
+        }
 
-        l_current_pi = l_pi;
-
-        for     (pino = 0; pino <= l_tcp->numpocs; ++pino) {
+        /* the lengths also locate the packets to decode: the precincts are decoded separately,
+           unless the tile is truncated and its last packets are read as far as they go */
+        if (l_packet_lengths) {
+                OPJ_SIZE_T l_tile_length = 0;
 
-                /* if the resolution needed is too low, one dim of the tilec could be equal to zero
-                 * and no packets are used to decode this resolution and
-                 * l_current_pi->resno is always >= p_tile->comps[l_current_pi->compno].minimum_num_resolutions
-                 * and no l_img_comp->resno_decoded are computed
-                 */
-                OPJ_BOOL* first_pass_failed = NULL;
-					
-                if (l_current_pi->poc.prg == OPJ_PROG_UNKNOWN) {
-                    /* TODO ADE : add an error */
-                    opj_pi_destroy(l_pi, l_nb_pocs);
-                    return OPJ_FALSE;
+                for (i = 0; i < p_tile->order_size; ++i) {
+                        l_tile_length = opj_size_adds(l_tile_length, l_packet_lengths[i]);
                 }
-					
-                first_pass_failed = (OPJ_BOOL*)opj_malloc(l_image->numcomps * sizeof(OPJ_BOOL));
-                if (!first_pass_failed)
-                {
-                    opj_pi_destroy(l_pi,l_nb_pocs);
-                    return OPJ_FALSE;
+                if (l_tile_length <= p_max_len) {
+                        if (! opj_t2_decode_packet_jobs(p_t2, p_tile_no, p_tile, p_src, l_packet_lengths, p_manager)) {
+                                return OPJ_FALSE;
+                        }
+                        l_decoded_by_jobs = OPJ_TRUE;
                 }
-                memset(first_pass_failed, OPJ_TRUE, l_image->numcomps * sizeof(OPJ_BOOL));
+        }
 
-                while (opj_pi_next(l_current_pi)) {
-                  JAS_FPRINTF( stderr, "packet offset=00000166 prg=%d cmptno=%02d rlvlno=%02d prcno=%03d lyrno=%02d\n\n",
-                    l_current_pi->poc.prg1, l_current_pi->compno, l_current_pi->resno, l_current_pi->precno, l_current_pi->layno );
+        first_pass_failed = (OPJ_BOOL*)opj_malloc(l_image->numcomps * sizeof(OPJ_BOOL));
+        if (!first_pass_failed)
+        {
+            return OPJ_FALSE;
+        }
 
-                        if (l_tcp->num_layers_to_decode > l_current_pi->layno
-                                        && l_current_pi->resno < p_tile->comps[l_current_pi->compno].minimum_num_resolutions) {
-                                l_nb_bytes_read = 0;
+        for (i = 0; i < p_tile->order_size; ++i) {
+                const opj_pi_packet_t *l_packet = &p_tile->order[i];
 
-                                first_pass_failed[l_current_pi->compno] = OPJ_FALSE;
+                /* each progression order change starts again */
+                if (i == 0 || l_packet->pino != p_tile->order[i - 1].pino) {
+                        memset(first_pass_failed, OPJ_TRUE, l_image->numcomps * sizeof(OPJ_BOOL));
+                }
 
-                                if (! opj_t2_decode_packet(p_t2,p_tile,l_tcp,l_current_pi,l_current_data,&l_nb_bytes_read,p_max_len,l_pack_info, p_manager)) {
-                                        opj_pi_destroy(l_pi,l_nb_pocs);
-                                        opj_free(first_pass_failed);
-                                        return OPJ_FALSE;
-                                }
+                JAS_FPRINTF( stderr, "packet offset=00000166 prg=%d cmptno=%02d rlvlno=%02d prcno=%03d lyrno=%02d\n\n",
+                    l_tcp->prg, l_packet->compno, l_packet->resno, l_packet->precno, l_packet->layno );
 
-                                l_img_comp = &(l_image->comps[l_current_pi->compno]);
-                                l_img_comp->resno_decoded = opj_uint_max(l_current_pi->resno, l_img_comp->resno_decoded);
+                if (opj_t2_is_packet_decoded(p_tile, l_tcp, l_packet)) {
+                        l_nb_bytes_read = 0;
+
+                        first_pass_failed[l_packet->compno] = OPJ_FALSE;
+
+                        if (l_decoded_by_jobs) {
+                                l_nb_bytes_read = l_packet_lengths[i];
                         }
-                        else {
-                                l_nb_bytes_read = 0;
-                                if (! opj_t2_skip_packet(p_t2,p_tile,l_tcp,l_current_pi,l_current_data,&l_nb_bytes_read,p_max_len,l_pack_info, p_manager)) {
-                                        opj_pi_destroy(l_pi,l_nb_pocs);
-                                        opj_free(first_pass_failed);
-                                        return OPJ_FALSE;
-                                }
+                        else if (! opj_t2_decode_packet(p_t2,p_tile,l_tcp,l_packet,l_current_data,&l_nb_bytes_read,p_max_len,l_pack_info, p_manager)) {
+                                opj_free(first_pass_failed);
+                                return OPJ_FALSE;
                         }
 
-                        if (first_pass_failed[l_current_pi->compno]) {
-                                l_img_comp = &(l_image->comps[l_current_pi->compno]);
-                                if (l_img_comp->resno_decoded == 0)
-                                        l_img_comp->resno_decoded = p_tile->comps[l_current_pi->compno].minimum_num_resolutions - 1;
+                        l_img_comp = &(l_image->comps[l_packet->compno]);
+                        l_img_comp->resno_decoded = opj_uint_max(l_packet->resno, l_img_comp->resno_decoded);
+                }
+                else if (l_packet_lengths && l_packet_lengths[i] <= p_max_len) {
+                        l_nb_bytes_read = l_packet_lengths[i];
+                }
+                else {
+                        l_nb_bytes_read = 0;
+                        if (! opj_t2_skip_packet(p_t2,p_tile,l_tcp,l_packet,l_current_data,&l_nb_bytes_read,p_max_len,l_pack_info, p_manager)) {
+                                opj_free(first_pass_failed);
+                                return OPJ_FALSE;
                         }
+                }
+
+                if (first_pass_failed[l_packet->compno]) {
+                        l_img_comp = &(l_image->comps[l_packet->compno]);
+                        if (l_img_comp->resno_decoded == 0)
+                                l_img_comp->resno_decoded = p_tile->comps[l_packet->compno].minimum_num_resolutions - 1;
+                }
 
-                        l_current_data += l_nb_bytes_read;
-                        p_max_len -= l_nb_bytes_read;
+                l_current_data += l_nb_bytes_read;
+                p_max_len -= l_nb_bytes_read;
 
-                        /* INDEX >> */
+                /* INDEX >> */
 #ifdef TODO_MSD
-                        if(p_cstr_info) {
-                                opj_tile_info_v2_t *info_TL = &p_cstr_info->tile[p_tile_no];
-                                opj_packet_info_t *info_PK = &info_TL->packet[p_cstr_info->packno];
-                                tp_start_packno = 0;
-                                if (!p_cstr_info->packno) {
-                                        info_PK->start_pos = info_TL->end_header + 1;
-                                } else if (info_TL->packet[p_cstr_info->packno-1].end_pos >= (OPJ_INT32)p_cstr_info->tile[p_tile_no].tp[curtp].tp_end_pos){ /* New tile part */
-                                        info_TL->tp[curtp].tp_numpacks = p_cstr_info->packno - tp_start_packno; /* Number of packets in previous tile-part */
-                                        tp_start_packno = p_cstr_info->packno;
-                                        curtp++;
-                                        info_PK->start_pos = p_cstr_info->tile[p_tile_no].tp[curtp].tp_end_header+1;
-                                } else {
-                                        info_PK->start_pos = (l_cp->m_specific_param.m_enc.m_tp_on && info_PK->start_pos) ? info_PK->start_pos : info_TL->packet[p_cstr_info->packno - 1].end_pos + 1;
-                                }
-                                info_PK->end_pos = info_PK->start_pos + l_nb_bytes_read - 1;
-                                info_PK->end_ph_pos += info_PK->start_pos - 1;  /* End of packet header which now only represents the distance */
-                                ++p_cstr_info->packno;
+                if(p_cstr_info) {
+                        opj_tile_info_v2_t *info_TL = &p_cstr_info->tile[p_tile_no];
+                        opj_packet_info_t *info_PK = &info_TL->packet[p_cstr_info->packno];
+                        tp_start_packno = 0;
+                        if (!p_cstr_info->packno) {
+                                info_PK->start_pos = info_TL->end_header + 1;
+                        } else if (info_TL->packet[p_cstr_info->packno-1].end_pos >= (OPJ_INT32)p_cstr_info->tile[p_tile_no].tp[curtp].tp_end_pos){ /* New tile part */
+                                info_TL->tp[curtp].tp_numpacks = p_cstr_info->packno - tp_start_packno; /* Number of packets in previous tile-part */
+                                tp_start_packno = p_cstr_info->packno;
+                                curtp++;
+                                info_PK->start_pos = p_cstr_info->tile[p_tile_no].tp[curtp].tp_end_header+1;
+                        } else {
+                                info_PK->start_pos = (l_cp->m_specific_param.m_enc.m_tp_on && info_PK->start_pos) ? info_PK->start_pos : info_TL->packet[p_cstr_info->packno - 1].end_pos + 1;
                         }
-#endif
-                        /* << INDEX */
+                        info_PK->end_pos = info_PK->start_pos + l_nb_bytes_read - 1;
+                        info_PK->end_ph_pos += info_PK->start_pos - 1;  /* End of packet header which now only represents the distance */
+                        ++p_cstr_info->packno;
                 }
-                ++l_current_pi;
-
-                opj_free(first_pass_failed);
+#endif
+                /* << INDEX */
         }
+
+        opj_free(first_pass_failed);
         /* INDEX >> */
 #ifdef TODO_MSD
         if
@@ -482,12 +1268,276 @@ OPJ_BOOL opj_t2_decode_packets( opj_t2_t *p_t2,
 #endif
         /* << INDEX */
 
-        /* don't forget to release pi */
-        opj_pi_destroy(l_pi,l_nb_pocs);
-        *p_data_read = (OPJ_UINT32)(l_current_data - p_src);
+        *p_data_read = (OPJ_SIZE_T)(l_current_data - p_src);
         return OPJ_TRUE;
 }
 
+OPJ_BOOL opj_t2_decode_packets_incremental(     opj_t2_t *p_t2,
+                                                OPJ_UINT32 p_tile_no,
+                                                opj_tcd_tile_t *p_tile,
+                                                opj_tcd_incr_tile_t *p_incr,
+                                                OPJ_SIZE_T * p_data_read,
+                                                opj_event_mgr_t *p_manager)
+{
+        OPJ_BYTE *l_current_data = p_incr->data;
+        OPJ_SIZE_T l_max_len = p_incr->data_size;
+        opj_tcp_t *l_tcp = &(p_t2->cp->tcps[p_tile_no]);
+        /* an EPH marker may follow a packet header whose bits all arrived */
+        OPJ_UINT32 l_margin = (l_tcp->csty & J2K_CP_CSTY_EPH) ? 2U : 0U;
+
+        *p_data_read = 0;
+
+        if (! opj_t2_get_decode_order(p_t2, p_tile_no, p_tile)) {
+                return OPJ_FALSE;
+        }
+
+        for (; p_incr->packetno < p_tile->order_size; ++p_incr->packetno) {
+                const opj_pi_packet_t *l_packet = &p_tile->order[p_incr->packetno];
+                OPJ_UINT32 l_nb_bytes_read = 0;
+                OPJ_BOOL l_result;
+
+                if (! opj_t2_save_precinct(p_tile, l_packet, p_incr)) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the tile incrementally\n");
+                        return OPJ_FALSE;
+                }
+
+                /* a missing SOP marker is only known to be missing once it could have arrived */
+                if ((l_tcp->csty & J2K_CP_CSTY_SOP) && l_max_len < 6 && ! p_incr->final) {
+                        l_result = OPJ_FALSE;
+                }
+                /* the packet may be incomplete: read it without complaining about its missing data */
+                else if (l_tcp->num_layers_to_decode > l_packet->layno
+                                && l_packet->resno < p_tile->comps[l_packet->compno].minimum_num_resolutions
+                                && ! p_tile->comps[l_packet->compno].skipped) {
+                        l_result = opj_t2_decode_packet(p_t2,p_tile,l_tcp,l_packet,l_current_data,&l_nb_bytes_read,l_max_len,00,00);
+                }
+                else {
+                        l_result = opj_t2_skip_packet(p_t2,p_tile,l_tcp,l_packet,l_current_data,&l_nb_bytes_read,l_max_len,00,00);
+                }
+
+                /* the bit reader pads a truncated header with zeros: only a packet followed by
+                   some data is known to be complete, unless no more data will arrive */
+                if (l_result && ! p_incr->final && l_nb_bytes_read + l_margin >= l_max_len) {
+                        l_result = OPJ_FALSE;
+                }
+
+                if (! l_result) {
+                        /* the code-block buffers could not be grown */
+                        if (! opj_t2_restore_precinct(p_tile, l_packet, p_incr)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the tile incrementally\n");
+                                return OPJ_FALSE;
+                        }
+
+                        if (p_incr->final) {
+                                opj_event_msg(p_manager, EVT_WARNING, "Tile %d is truncated, its remaining packets are ignored\n", p_tile_no + 1);
+                                p_incr->packetno = p_tile->order_size;
+                                p_incr->done = 1;
+                                *p_data_read = p_incr->data_size;
+                                return OPJ_TRUE;
+                        }
+
+                        /* the packet is read again once more data arrived */
+                        *p_data_read = (OPJ_SIZE_T)(l_current_data - p_incr->data);
+                        return OPJ_TRUE;
+                }
+
+                l_current_data += l_nb_bytes_read;
+                l_max_len -= l_nb_bytes_read;
+        }
+
+        /* all the packets have been read */
+        p_incr->done = 1;
+        *p_data_read = (OPJ_SIZE_T)(l_current_data - p_incr->data);
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_t2_locate_packets( opj_t2_t *p_t2,
+                                OPJ_UINT32 p_tile_no,
+                                opj_tcd_tile_t *p_tile,
+                                OPJ_BYTE *p_src,
+                                OPJ_UINT32 p_max_len,
+                                opj_t2_packet_t *p_packets,
+                                OPJ_UINT32 p_max_packets,
+                                OPJ_UINT32 *p_nb_packets,
+                                opj_event_mgr_t *p_manager)
+{
+        OPJ_BYTE *l_current_data = p_src;
+        opj_tcp_t *l_tcp = &(p_t2->cp->tcps[p_tile_no]);
+        OPJ_UINT32 l_nb_bytes_read;
+        OPJ_UINT32 i;
+
+        *p_nb_packets = 0;
+
+        if (! opj_t2_get_decode_order(p_t2, p_tile_no, p_tile)) {
+                return OPJ_FALSE;
+        }
+
+        for (i = 0; i < p_tile->order_size; ++i) {
+                const opj_pi_packet_t *l_packet = &p_tile->order[i];
+                opj_t2_packet_t * l_position;
+
+                /* a truncated tile: the packets left are missing */
+                if (! p_max_len) {
+                        break;
+                }
+                if (*p_nb_packets == p_max_packets) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Too many packets in tile %d\n", p_tile_no);
+                        return OPJ_FALSE;
+                }
+
+                l_nb_bytes_read = 0;
+                if (! opj_t2_skip_packet(p_t2, p_tile, l_tcp, l_packet, l_current_data, &l_nb_bytes_read, p_max_len, 00, p_manager)) {
+                        return OPJ_FALSE;
+                }
+                if (l_nb_bytes_read > p_max_len) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Packet longer than the data of tile %d\n", p_tile_no);
+                        return OPJ_FALSE;
+                }
+
+                l_position = &p_packets[(*p_nb_packets)++];
+                l_position->compno = l_packet->compno;
+                l_position->resno = l_packet->resno;
+                l_position->precno = l_packet->precno;
+                l_position->layno = l_packet->layno;
+                l_position->offset = (OPJ_UINT32)(l_current_data - p_src);
+                l_position->length = l_nb_bytes_read;
+
+                l_current_data += l_nb_bytes_read;
+                p_max_len -= l_nb_bytes_read;
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_save_precinct(   opj_tcd_tile_t *p_tile,
+                                        const opj_pi_packet_t *p_packet,
+                                        opj_tcd_incr_tile_t *p_incr)
+{
+        opj_tcd_resolution_t* l_res = &p_tile->comps[p_packet->compno].resolutions[p_packet->resno];
+        OPJ_UINT32 bandno, cblkno, l_nb_code_blocks;
+        OPJ_SIZE_T l_size = 0;
+        OPJ_BYTE * l_ptr;
+
+        for (bandno = 0; bandno < l_res->numbands; ++bandno) {
+                opj_tcd_band_t *l_band = l_res->bands + bandno;
+                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
+
+                if ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) {
+                        continue;
+                }
+                l_nb_code_blocks = l_prc->cw * l_prc->ch;
+                l_size += l_nb_code_blocks * (sizeof(opj_tcd_cblk_dec_t) + sizeof(opj_tcd_seg_t));
+                if (l_prc->incltree) {
+                        l_size += l_prc->incltree->numnodes * sizeof(opj_tgt_node_t);
+                }
+                if (l_prc->imsbtree) {
+                        l_size += l_prc->imsbtree->numnodes * sizeof(opj_tgt_node_t);
+                }
+        }
+
+        if (l_size > p_incr->saved_max_size) {
+                OPJ_BYTE * l_new_saved = (OPJ_BYTE *) opj_realloc(p_incr->saved, l_size);
+                if (! l_new_saved) {
+                        return OPJ_FALSE;
+                }
+                p_incr->saved = l_new_saved;
+                p_incr->saved_max_size = (OPJ_UINT32)l_size;
+        }
+
+        l_ptr = p_incr->saved;
+        for (bandno = 0; bandno < l_res->numbands; ++bandno) {
+                opj_tcd_band_t *l_band = l_res->bands + bandno;
+                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
+
+                if ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) {
+                        continue;
+                }
+                l_nb_code_blocks = l_prc->cw * l_prc->ch;
+                memcpy(l_ptr, l_prc->cblks.dec, l_nb_code_blocks * sizeof(opj_tcd_cblk_dec_t));
+                l_ptr += l_nb_code_blocks * sizeof(opj_tcd_cblk_dec_t);
+
+                /* a packet only changes the last segment of a code-block and the following ones */
+                for (cblkno = 0; cblkno < l_nb_code_blocks; ++cblkno) {
+                        opj_tcd_cblk_dec_t * l_cblk = l_prc->cblks.dec + cblkno;
+                        if (l_cblk->numsegs) {
+                                memcpy(l_ptr, l_cblk->segs + l_cblk->numsegs - 1, sizeof(opj_tcd_seg_t));
+                        }
+                        l_ptr += sizeof(opj_tcd_seg_t);
+                }
+
+                if (l_prc->incltree) {
+                        memcpy(l_ptr, l_prc->incltree->nodes, l_prc->incltree->numnodes * sizeof(opj_tgt_node_t));
+                        l_ptr += l_prc->incltree->numnodes * sizeof(opj_tgt_node_t);
+                }
+                if (l_prc->imsbtree) {
+                        memcpy(l_ptr, l_prc->imsbtree->nodes, l_prc->imsbtree->numnodes * sizeof(opj_tgt_node_t));
+                        l_ptr += l_prc->imsbtree->numnodes * sizeof(opj_tgt_node_t);
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+static OPJ_BOOL opj_t2_restore_precinct(opj_tcd_tile_t *p_tile,
+                                        const opj_pi_packet_t *p_packet,
+                                        opj_tcd_incr_tile_t *p_incr)
+{
+        opj_tcd_resolution_t* l_res = &p_tile->comps[p_packet->compno].resolutions[p_packet->resno];
+        OPJ_UINT32 bandno, cblkno, l_nb_code_blocks;
+        const OPJ_BYTE * l_ptr = p_incr->saved;
+        OPJ_BOOL l_result = OPJ_TRUE;
+
+        for (bandno = 0; bandno < l_res->numbands; ++bandno) {
+                opj_tcd_band_t *l_band = l_res->bands + bandno;
+                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
+                const opj_tcd_seg_t * l_segs;
+
+                if ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) {
+                        continue;
+                }
+                l_nb_code_blocks = l_prc->cw * l_prc->ch;
+                l_segs = (const opj_tcd_seg_t *)(l_ptr + l_nb_code_blocks * sizeof(opj_tcd_cblk_dec_t));
+
+                for (cblkno = 0; cblkno < l_nb_code_blocks; ++cblkno) {
+                        opj_tcd_cblk_dec_t * l_cblk = l_prc->cblks.dec + cblkno;
+                        /* the buffers may have been moved or grown while reading the packet */
+                        OPJ_BYTE * l_data = l_cblk->data;
+                        OPJ_UINT32 l_data_max_size = l_cblk->data_max_size;
+                        OPJ_UINT32 l_data_in_slab = l_cblk->m_data_in_slab;
+                        opj_tcd_seg_t * l_cblk_segs = l_cblk->segs;
+                        OPJ_UINT32 l_current_max_segs = l_cblk->m_current_max_segs;
+                        OPJ_UINT32 l_segs_in_slab = l_cblk->m_segs_in_slab;
+
+                        memcpy(l_cblk, l_ptr + cblkno * sizeof(opj_tcd_cblk_dec_t), sizeof(opj_tcd_cblk_dec_t));
+                        l_cblk->data = l_data;
+                        l_cblk->data_max_size = l_data_max_size;
+                        l_cblk->m_data_in_slab = (l_data_in_slab != 0);
+                        l_cblk->segs = l_cblk_segs;
+                        l_cblk->m_current_max_segs = l_current_max_segs;
+                        l_cblk->m_segs_in_slab = (l_segs_in_slab != 0);
+
+                        if (! l_cblk->data || ! l_cblk->segs) {
+                                l_result = OPJ_FALSE;
+                        }
+                        else if (l_cblk->numsegs) {
+                                memcpy(l_cblk->segs + l_cblk->numsegs - 1, l_segs + cblkno, sizeof(opj_tcd_seg_t));
+                        }
+                }
+                l_ptr += l_nb_code_blocks * (sizeof(opj_tcd_cblk_dec_t) + sizeof(opj_tcd_seg_t));
+
+                if (l_prc->incltree) {
+                        memcpy(l_prc->incltree->nodes, l_ptr, l_prc->incltree->numnodes * sizeof(opj_tgt_node_t));
+                        l_ptr += l_prc->incltree->numnodes * sizeof(opj_tgt_node_t);
+                }
+                if (l_prc->imsbtree) {
+                        memcpy(l_prc->imsbtree->nodes, l_ptr, l_prc->imsbtree->numnodes * sizeof(opj_tgt_node_t));
+                        l_ptr += l_prc->imsbtree->numnodes * sizeof(opj_tgt_node_t);
+                }
+        }
+
+        return l_result;
+}
+
 /* ----------------------------------------------------------------------- */
 
 /**
@@ -513,6 +1563,14 @@ opj_t2_t* opj_t2_create(opj_image_t *p_image, opj_cp_t *p_cp)
 
 void opj_t2_destroy(opj_t2_t *t2) {
         if(t2) {
+                OPJ_UINT32 i;
+
+                for (i = 0; i < t2->nb_precinct_jobs_max; ++i) {
+                        opj_free(t2->precinct_jobs[i].data);
+                }
+                opj_free(t2->precinct_jobs);
+                opj_free(t2->packet_jobs);
+                opj_free(t2->job_of_precinct);
                 opj_free(t2);
         }
 }
@@ -520,10 +1578,10 @@ void opj_t2_destroy(opj_t2_t *t2) {
 static OPJ_BOOL opj_t2_decode_packet(  opj_t2_t* p_t2,
                                 opj_tcd_tile_t *p_tile,
                                 opj_tcp_t *p_tcp,
-                                opj_pi_iterator_t *p_pi,
+                                const opj_pi_packet_t *p_packet,
                                 OPJ_BYTE *p_src,
                                 OPJ_UINT32 * p_data_read,
-                                OPJ_UINT32 p_max_length,
+                                OPJ_SIZE_T p_max_length,
                                 opj_packet_info_t *p_pack_info,
                                 opj_event_mgr_t *p_manager)
 {
@@ -533,7 +1591,7 @@ static OPJ_BOOL opj_t2_decode_packet(  opj_t2_t* p_t2,
 
         *p_data_read = 0;
 
-        if (! opj_t2_read_packet_header(p_t2,p_tile,p_tcp,p_pi,&l_read_data,p_src,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
+        if (! opj_t2_read_packet_header(p_t2,p_tile,p_tcp,p_packet,&l_read_data,p_src,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
                 return OPJ_FALSE;
         }
 
@@ -545,7 +1603,7 @@ static OPJ_BOOL opj_t2_decode_packet(  opj_t2_t* p_t2,
         if (l_read_data) {
                 l_nb_bytes_read = 0;
 
-                if (! opj_t2_read_packet_data(p_t2,p_tile,p_pi,p_src,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
+                if (! opj_t2_read_packet_data(p_t2,p_tile,p_packet,p_src,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
                         return OPJ_FALSE;
                 }
 
@@ -557,22 +1615,24 @@ static OPJ_BOOL opj_t2_decode_packet(  opj_t2_t* p_t2,
         return OPJ_TRUE;
 }
 
-static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
-                                opj_tcd_tile_t * tile,
+static OPJ_BOOL opj_t2_encode_packet(  opj_tcd_tile_t * tile,
                                 opj_tcp_t * tcp,
-                                opj_pi_iterator_t *pi,
+                                const opj_pi_packet_t *packet,
+                                OPJ_UINT32 packno,
                                 OPJ_BYTE *dest,
                                 OPJ_UINT32 * p_data_written,
                                 OPJ_UINT32 length,
-                                opj_codestream_info_t *cstr_info)
+                                OPJ_UINT32 * p_header_length,
+                                OPJ_FLOAT64 * p_disto,
+                                J2K_T2_MODE p_t2_mode)
 {
         OPJ_UINT32 bandno, cblkno;
         OPJ_BYTE* c = dest;
         OPJ_UINT32 l_nb_bytes;
-        OPJ_UINT32 compno = pi->compno;     /* component value */
-        OPJ_UINT32 resno  = pi->resno;      /* resolution level value */
-        OPJ_UINT32 precno = pi->precno;     /* precinct value */
-        OPJ_UINT32 layno  = pi->layno;      /* quality layer value */
+        OPJ_UINT32 compno = packet->compno; /* component value */
+        OPJ_UINT32 resno  = packet->resno;  /* resolution level value */
+        OPJ_UINT32 precno = packet->precno; /* precinct value */
+        OPJ_UINT32 layno  = packet->layno;  /* quality layer value */
         OPJ_UINT32 l_nb_blocks;
         opj_tcd_band_t *band = 00;
         opj_tcd_cblk_enc_t* cblk = 00;
@@ -581,7 +1641,9 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
         opj_tcd_tilecomp_t *tilec = &tile->comps[compno];
         opj_tcd_resolution_t *res = &tilec->resolutions[resno];
 
-        opj_bio_t *bio = 00;    /* BIO component */
+        /* the header of a packet is small: no allocation for its BIO component */
+        opj_bio_t l_bio;
+        opj_bio_t *bio = &l_bio;    /* BIO component */
 
         /* <SOP 0xff91> */
         if (tcp->csty & J2K_CP_CSTY_SOP) {
@@ -590,11 +1652,11 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
                 c[2] = 0;
                 c[3] = 4;
 #if 0
-                c[4] = (tile->packno % 65536) / 256;
-                c[5] = (tile->packno % 65536) % 256;
+                c[4] = (packno % 65536) / 256;
+                c[5] = (packno % 65536) % 256;
 #else
-                c[4] = (tile->packno >> 8) & 0xff; /* packno is uint32_t */
-                c[5] = tile->packno & 0xff;
+                c[4] = (packno >> 8) & 0xff; /* packno is uint32_t */
+                c[5] = packno & 0xff;
 #endif
                 c += 6;
                 length -= 6;
@@ -621,11 +1683,6 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
                 }
         }
 
-        bio = opj_bio_create();
-        if (!bio) {
-                /* FIXME event manager error callback */
-                return OPJ_FALSE;
-        }
         opj_bio_init_enc(bio, c, length);
         opj_bio_write(bio, 1, 1);           /* Empty header bit */
 
@@ -719,7 +1776,6 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
         }
 
         if (!opj_bio_flush(bio)) {
-                opj_bio_destroy(bio);
                 return OPJ_FALSE;               /* modified to eliminate longjmp !! */
         }
 
@@ -727,8 +1783,6 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
         c += l_nb_bytes;
         length -= l_nb_bytes;
 
-        opj_bio_destroy(bio);
-
         /* <EPH 0xff92> */
         if (tcp->csty & J2K_CP_CSTY_EPH) {
                 c[0] = 255;
@@ -741,10 +1795,8 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
         /* << INDEX */
         /* End of packet header position. Currently only represents the distance to start of packet
            Will be updated later by incrementing with packet start value*/
-        if(cstr_info && cstr_info->index_write) {
-                opj_packet_info_t *info_PK = &cstr_info->tile[tileno].packet[cstr_info->packno];
-                info_PK->end_ph_pos = (OPJ_INT32)(c - dest);
-        }
+        *p_header_length = (OPJ_UINT32)(c - dest);
+        *p_disto = 0;
         /* INDEX >> */
 
         /* Writing the packet body */
@@ -767,19 +1819,16 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
                                 return OPJ_FALSE;
                         }
 
-                        memcpy(c, layer->data, layer->len);
+                        /* the rate allocation only needs the length of the packet */
+                        if (p_t2_mode == FINAL_PASS) {
+                                memcpy(c, layer->data, layer->len);
+                        }
                         cblk->numpasses += layer->numpasses;
                         c += layer->len;
                         length -= layer->len;
 
                         /* << INDEX */
-                        if(cstr_info && cstr_info->index_write) {
-                                opj_packet_info_t *info_PK = &cstr_info->tile[tileno].packet[cstr_info->packno];
-                                info_PK->disto += layer->disto;
-                                if (cstr_info->D_max < info_PK->disto) {
-                                        cstr_info->D_max = info_PK->disto;
-                                }
-                        }
+                        *p_disto += layer->disto;
 
                         ++cblk;
                         /* INDEX >> */
@@ -796,10 +1845,10 @@ static OPJ_BOOL opj_t2_encode_packet(  OPJ_UINT32 tileno,
 static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
                                     opj_tcd_tile_t *p_tile,
                                     opj_tcp_t *p_tcp,
-                                    opj_pi_iterator_t *p_pi,
+                                    const opj_pi_packet_t *p_packet,
                                     OPJ_BYTE *p_src,
                                     OPJ_UINT32 * p_data_read,
-                                    OPJ_UINT32 p_max_length,
+                                    OPJ_SIZE_T p_max_length,
                                     opj_packet_info_t *p_pack_info,
                                     opj_event_mgr_t *p_manager)
 {
@@ -809,7 +1858,7 @@ static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
 
         *p_data_read = 0;
 
-        if (! opj_t2_read_packet_header(p_t2,p_tile,p_tcp,p_pi,&l_read_data,p_src,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
+        if (! opj_t2_read_packet_header(p_t2,p_tile,p_tcp,p_packet,&l_read_data,p_src,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
                 return OPJ_FALSE;
         }
 
@@ -821,7 +1870,7 @@ static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
         if (l_read_data) {
                 l_nb_bytes_read = 0;
 
-                if (! opj_t2_skip_packet_data(p_t2,p_tile,p_pi,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
+                if (! opj_t2_skip_packet_data(p_t2,p_tile,p_packet,&l_nb_bytes_read,p_max_length,p_pack_info, p_manager)) {
                         return OPJ_FALSE;
                 }
 
@@ -836,11 +1885,11 @@ static OPJ_BOOL opj_t2_skip_packet( opj_t2_t* p_t2,
 static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
                                     opj_tcd_tile_t *p_tile,
                                     opj_tcp_t *p_tcp,
-                                    opj_pi_iterator_t *p_pi,
+                                    const opj_pi_packet_t *p_packet,
                                     OPJ_BOOL * p_is_data_present,
                                     OPJ_BYTE *p_src_data,
                                     OPJ_UINT32 * p_data_read,
-                                    OPJ_UINT32 p_max_length,
+                                    OPJ_SIZE_T p_max_length,
                                     opj_packet_info_t *p_pack_info,
                                     opj_event_mgr_t *p_manager)
 
@@ -853,22 +1902,23 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
         OPJ_UINT32 * l_modified_length_ptr = 00;
         OPJ_BYTE *l_current_data = p_src_data;
         opj_cp_t *l_cp = p_t2->cp;
-        opj_bio_t *l_bio = 00;  /* BIO component */
+        opj_bio_t l_bio_dec;
+        opj_bio_t *l_bio = &l_bio_dec;  /* BIO component */
         opj_tcd_band_t *l_band = 00;
         opj_tcd_cblk_dec_t* l_cblk = 00;
-        opj_tcd_resolution_t* l_res = &p_tile->comps[p_pi->compno].resolutions[p_pi->resno];
+        opj_tcd_resolution_t* l_res = &p_tile->comps[p_packet->compno].resolutions[p_packet->resno];
 
         OPJ_BYTE *l_header_data = 00;
         OPJ_BYTE **l_header_data_start = 00;
 
         OPJ_UINT32 l_present;
 
-        if (p_pi->layno == 0) {
+        if (p_packet->layno == 0) {
                 l_band = l_res->bands;
 
                 /* reset tagtrees */
                 for (bandno = 0; bandno < l_res->numbands; ++bandno) {
-                        opj_tcd_precinct_t *l_prc = &l_band->precincts[p_pi->precno];
+                        opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
 
                         if ( ! ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) ) {
                                 opj_tgt_reset(l_prc->incltree);
@@ -908,11 +1958,6 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
         step 2: Return to codestream for decoding
         */
 
-        l_bio = opj_bio_create();
-        if (! l_bio) {
-                return OPJ_FALSE;
-        }
-
         if (l_cp->ppm == 1) { /* PPM */
                 l_header_data_start = &l_cp->ppm_data;
                 l_header_data = *l_header_data_start;
@@ -927,7 +1972,8 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
         else {  /* Normal Case */
                 l_header_data_start = &(l_current_data);
                 l_header_data = *l_header_data_start;
-                l_remaining_length = (OPJ_UINT32)(p_src_data+p_max_length-l_header_data);
+                /* the header of a packet is far shorter than 4 GB, unlike the data of a tile */
+                l_remaining_length = (OPJ_UINT32)opj_size_min(p_max_length - (OPJ_SIZE_T)(l_header_data - p_src_data), 0xFFFFFFFFU);
                 l_modified_length_ptr = &(l_remaining_length);
         }
 
@@ -939,7 +1985,6 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
             /* TODO MSD: no test to control the output of this function*/
                 opj_bio_inalign(l_bio);
                 l_header_data += opj_bio_numbytes(l_bio);
-                opj_bio_destroy(l_bio);
 
                 /* EPH markers */
                 if (p_tcp->csty & J2K_CP_CSTY_EPH) {
@@ -971,7 +2016,7 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
 
         l_band = l_res->bands;
         for (bandno = 0; bandno < l_res->numbands; ++bandno) {
-                opj_tcd_precinct_t *l_prc = &(l_band->precincts[p_pi->precno]);
+                opj_tcd_precinct_t *l_prc = &(l_band->precincts[p_packet->precno]);
 
                 if ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) {
                         ++l_band;
@@ -986,7 +2031,7 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
 
                         /* if cblk not yet included before --> inclusion tagtree */
                         if (!l_cblk->numsegs) {
-                                l_included = opj_tgt_decode(l_bio, l_prc->incltree, cblkno, (OPJ_INT32)(p_pi->layno + 1));
+                                l_included = opj_tgt_decode(l_bio, l_prc->incltree, cblkno, (OPJ_INT32)(p_packet->layno + 1));
                                 /* else one bit */
                         }
                         else {
@@ -1007,6 +2052,12 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
 
                                 while (!opj_tgt_decode(l_bio, l_prc->imsbtree, cblkno, (OPJ_INT32)i)) {
                                         ++i;
+                                        /* a truncated header reads as zeros, which never end the tag tree:
+                                           there are at most 37 bit-planes (7 guard bits and an exponent of 31) */
+                                        if (i > 38) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Invalid number of zero bit-planes for codeblock %d\n", cblkno);
+                                                return OPJ_FALSE;
+                                        }
                                 }
 
                                 l_cblk->numbps = (OPJ_UINT32)l_band->numbps + 1 - i;
@@ -1022,8 +2073,7 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
                         l_segno = 0;
 
                         if (!l_cblk->numsegs) {
-                                if (! opj_t2_init_seg(l_cblk, l_segno, p_tcp->tccps[p_pi->compno].cblksty, 1)) {
-                                        opj_bio_destroy(l_bio);
+                                if (! opj_t2_init_seg(l_cblk, l_segno, p_tcp->tccps[p_packet->compno].cblksty, 1)) {
                                         return OPJ_FALSE;
                                 }
                         }
@@ -1031,8 +2081,7 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
                                 l_segno = l_cblk->numsegs - 1;
                                 if (l_cblk->segs[l_segno].numpasses == l_cblk->segs[l_segno].maxpasses) {
                                         ++l_segno;
-                                        if (! opj_t2_init_seg(l_cblk, l_segno, p_tcp->tccps[p_pi->compno].cblksty, 0)) {
-                                                opj_bio_destroy(l_bio);
+                                        if (! opj_t2_init_seg(l_cblk, l_segno, p_tcp->tccps[p_packet->compno].cblksty, 0)) {
                                                 return OPJ_FALSE;
                                         }
                                 }
@@ -1048,8 +2097,7 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
                                 if (n > 0) {
                                         ++l_segno;
 
-                                        if (! opj_t2_init_seg(l_cblk, l_segno, p_tcp->tccps[p_pi->compno].cblksty, 0)) {
-                                                opj_bio_destroy(l_bio);
+                                        if (! opj_t2_init_seg(l_cblk, l_segno, p_tcp->tccps[p_packet->compno].cblksty, 0)) {
                                                 return OPJ_FALSE;
                                         }
                                 }
@@ -1062,12 +2110,10 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
         }
 
         if (!opj_bio_inalign(l_bio)) {
-                opj_bio_destroy(l_bio);
                 return OPJ_FALSE;
         }
 
         l_header_data += opj_bio_numbytes(l_bio);
-        opj_bio_destroy(l_bio);
 
         /* EPH markers */
         if (p_tcp->csty & J2K_CP_CSTY_EPH) {
@@ -1102,10 +2148,10 @@ static OPJ_BOOL opj_t2_read_packet_header( opj_t2_t* p_t2,
 
 static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
                                     opj_tcd_tile_t *p_tile,
-                                    opj_pi_iterator_t *p_pi,
+                                    const opj_pi_packet_t *p_packet,
                                     OPJ_BYTE *p_src_data,
                                     OPJ_UINT32 * p_data_read,
-                                    OPJ_UINT32 p_max_length,
+                                    OPJ_SIZE_T p_max_length,
                                     opj_packet_info_t *pack_info,
                                     opj_event_mgr_t* p_manager)
 {
@@ -1114,14 +2160,14 @@ static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
         OPJ_BYTE *l_current_data = p_src_data;
         opj_tcd_band_t *l_band = 00;
         opj_tcd_cblk_dec_t* l_cblk = 00;
-        opj_tcd_resolution_t* l_res = &p_tile->comps[p_pi->compno].resolutions[p_pi->resno];
+        opj_tcd_resolution_t* l_res = &p_tile->comps[p_packet->compno].resolutions[p_packet->resno];
 
         OPJ_ARG_NOT_USED(p_t2);
         OPJ_ARG_NOT_USED(pack_info);
 
         l_band = l_res->bands;
         for (bandno = 0; bandno < l_res->numbands; ++bandno) {
-                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_pi->precno];
+                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
 
                 if ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) {
                         ++l_band;
@@ -1157,8 +2203,8 @@ static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
                         do {
                                 /* Check possible overflow (on l_current_data only, assumes input args already checked) then size */
                                 if ((((OPJ_SIZE_T)l_current_data + (OPJ_SIZE_T)l_seg->newlen) < (OPJ_SIZE_T)l_current_data) || (l_current_data + l_seg->newlen > p_src_data + p_max_length)) {
-                                        opj_event_msg(p_manager, EVT_ERROR, "read: segment too long (%d) with max (%d) for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
-																								l_seg->newlen, p_max_length, cblkno, p_pi->precno, bandno, p_pi->resno, p_pi->compno);
+                                        opj_event_msg(p_manager, EVT_ERROR, "read: segment too long (%d) with max (%" PRIu64 ") for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
+																								l_seg->newlen, (OPJ_UINT64)p_max_length, cblkno, p_packet->precno, bandno, p_packet->resno, p_packet->compno);
                                         return OPJ_FALSE;
                                 }
 
@@ -1170,7 +2216,7 @@ static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
                                 if ((l_cblk->len + l_seg->newlen) > 8192) {
                                         opj_event_msg(p_manager, EVT_WARNING,
                                                 "JPWL: segment too long (%d) for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
-                                                l_seg->newlen, cblkno, p_pi->precno, bandno, p_pi->resno, p_pi->compno);
+                                                l_seg->newlen, cblkno, p_packet->precno, bandno, p_packet->resno, p_packet->compno);
                                         if (!JPWL_ASSUME) {
                                                 opj_event_msg(p_manager, EVT_ERROR, "JPWL: giving up\n");
                                                 return OPJ_FALSE;
@@ -1184,16 +2230,30 @@ static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
                                 /* Check possible overflow on size */
                                 if ((l_cblk->data_current_size + l_seg->newlen) < l_cblk->data_current_size) {
                                         opj_event_msg(p_manager, EVT_ERROR, "read: segment too long (%d) with current size (%d > %d) for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
-                                                l_seg->newlen, l_cblk->data_current_size, 0xFFFFFFFF - l_seg->newlen, cblkno, p_pi->precno, bandno, p_pi->resno, p_pi->compno);
+                                                l_seg->newlen, l_cblk->data_current_size, 0xFFFFFFFF - l_seg->newlen, cblkno, p_packet->precno, bandno, p_packet->resno, p_packet->compno);
                                         return OPJ_FALSE;
                                 }
                                 /* Check if the cblk->data have allocated enough memory */
                                 if ((l_cblk->data_current_size + l_seg->newlen) > l_cblk->data_max_size) {
-                                    OPJ_BYTE* new_cblk_data = (OPJ_BYTE*) opj_realloc(l_cblk->data, l_cblk->data_current_size + l_seg->newlen);
+                                    OPJ_BYTE* new_cblk_data;
+                                    if (l_cblk->m_data_in_slab) {
+                                        /* the initial buffer belongs to a tcd slab: move to the heap */
+                                        new_cblk_data = (OPJ_BYTE*) opj_malloc(l_cblk->data_current_size + l_seg->newlen);
+                                        if (new_cblk_data) {
+                                            memcpy(new_cblk_data, l_cblk->data, l_cblk->data_current_size);
+                                            l_cblk->m_data_in_slab = 0;
+                                        }
+                                    }
+                                    else {
+                                        new_cblk_data = (OPJ_BYTE*) opj_realloc(l_cblk->data, l_cblk->data_current_size + l_seg->newlen);
+                                    }
                                     if(! new_cblk_data) {
-                                        opj_free(l_cblk->data);
+                                        if (! l_cblk->m_data_in_slab) {
+                                            opj_free(l_cblk->data);
+                                        }
                                         l_cblk->data = NULL;
                                         l_cblk->data_max_size = 0;
+                                        l_cblk->m_data_in_slab = 0;
                                         /* opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to realloc code block cata!\n"); */
                                         return OPJ_FALSE;
                                     }
@@ -1202,6 +2262,7 @@ static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
                                 }
                                
                                 memcpy(l_cblk->data + l_cblk->data_current_size, l_current_data, l_seg->newlen);
+                                l_cblk->m_modified = 1;
 
                                 if (l_seg->numpasses == 0) {
                                         l_seg->data = &l_cblk->data;
@@ -1237,9 +2298,9 @@ static OPJ_BOOL opj_t2_read_packet_data(   opj_t2_t* p_t2,
 
 static OPJ_BOOL opj_t2_skip_packet_data(   opj_t2_t* p_t2,
                                     opj_tcd_tile_t *p_tile,
-                                    opj_pi_iterator_t *p_pi,
+                                    const opj_pi_packet_t *p_packet,
                                     OPJ_UINT32 * p_data_read,
-                                    OPJ_UINT32 p_max_length,
+                                    OPJ_SIZE_T p_max_length,
                                     opj_packet_info_t *pack_info,
                                     opj_event_mgr_t *p_manager)
 {
@@ -1247,7 +2308,7 @@ static OPJ_BOOL opj_t2_skip_packet_data(   opj_t2_t* p_t2,
         OPJ_UINT32 l_nb_code_blocks;
         opj_tcd_band_t *l_band = 00;
         opj_tcd_cblk_dec_t* l_cblk = 00;
-        opj_tcd_resolution_t* l_res = &p_tile->comps[p_pi->compno].resolutions[p_pi->resno];
+        opj_tcd_resolution_t* l_res = &p_tile->comps[p_packet->compno].resolutions[p_packet->resno];
 
         OPJ_ARG_NOT_USED(p_t2);
         OPJ_ARG_NOT_USED(pack_info);
@@ -1256,7 +2317,7 @@ static OPJ_BOOL opj_t2_skip_packet_data(   opj_t2_t* p_t2,
         l_band = l_res->bands;
 
         for (bandno = 0; bandno < l_res->numbands; ++bandno) {
-                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_pi->precno];
+                opj_tcd_precinct_t *l_prc = &l_band->precincts[p_packet->precno];
 
                 if ((l_band->x1-l_band->x0 == 0)||(l_band->y1-l_band->y0 == 0)) {
                         ++l_band;
@@ -1292,8 +2353,8 @@ static OPJ_BOOL opj_t2_skip_packet_data(   opj_t2_t* p_t2,
                         do {
                                 /* Check possible overflow then size */
                                 if (((*p_data_read + l_seg->newlen) < (*p_data_read)) || ((*p_data_read + l_seg->newlen) > p_max_length)) {
-                                        opj_event_msg(p_manager, EVT_ERROR, "skip: segment too long (%d) with max (%d) for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
-                                                l_seg->newlen, p_max_length, cblkno, p_pi->precno, bandno, p_pi->resno, p_pi->compno);
+                                        opj_event_msg(p_manager, EVT_ERROR, "skip: segment too long (%d) with max (%" PRIu64 ") for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
+                                                l_seg->newlen, (OPJ_UINT64)p_max_length, cblkno, p_packet->precno, bandno, p_packet->resno, p_packet->compno);
                                         return OPJ_FALSE;
                                 }
 
@@ -1305,7 +2366,7 @@ static OPJ_BOOL opj_t2_skip_packet_data(   opj_t2_t* p_t2,
                                 if ((l_cblk->len + l_seg->newlen) > 8192) {
                                         opj_event_msg(p_manager, EVT_WARNING,
                                                 "JPWL: segment too long (%d) for codeblock %d (p=%d, b=%d, r=%d, c=%d)\n",
-                                                l_seg->newlen, cblkno, p_pi->precno, bandno, p_pi->resno, p_pi->compno);
+                                                l_seg->newlen, cblkno, p_packet->precno, bandno, p_packet->resno, p_packet->compno);
                                         if (!JPWL_ASSUME) {
                                                 opj_event_msg(p_manager, EVT_ERROR, "JPWL: giving up\n");
                                                 return -999;
@@ -1348,13 +2409,27 @@ OPJ_BOOL opj_t2_init_seg(   opj_tcd_cblk_dec_t* cblk,
 
         if (l_nb_segs > cblk->m_current_max_segs) {
                 opj_tcd_seg_t* new_segs;
+                OPJ_UINT32 l_old_max_segs = cblk->m_current_max_segs;
                 cblk->m_current_max_segs += OPJ_J2K_DEFAULT_NB_SEGS;
 
-                new_segs = (opj_tcd_seg_t*) opj_realloc(cblk->segs, cblk->m_current_max_segs * sizeof(opj_tcd_seg_t));
+                if (cblk->m_segs_in_slab) {
+                        /* the initial segments belong to a tcd slab: move to the heap */
+                        new_segs = (opj_tcd_seg_t*) opj_malloc(cblk->m_current_max_segs * sizeof(opj_tcd_seg_t));
+                        if (new_segs) {
+                                memcpy(new_segs, cblk->segs, l_old_max_segs * sizeof(opj_tcd_seg_t));
+                                cblk->m_segs_in_slab = 0;
+                        }
+                }
+                else {
+                        new_segs = (opj_tcd_seg_t*) opj_realloc(cblk->segs, cblk->m_current_max_segs * sizeof(opj_tcd_seg_t));
+                }
                 if(! new_segs) {
-                        opj_free(cblk->segs);
+                        if (! cblk->m_segs_in_slab) {
+                                opj_free(cblk->segs);
+                        }
                         cblk->segs = NULL;
                         cblk->m_current_max_segs = 0;
+                        cblk->m_segs_in_slab = 0;
                         /* opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to initialize segment %d\n", l_nb_segs); */
                         return OPJ_FALSE;
                 }
@@ -47,6 +47,44 @@
 /** @defgroup T2 T2 - Implementation of a tier-2 coding */
 /*@{*/
 
+/**
+Packet encoded or decoded by the job of its precinct, see opj_t2_precinct_job_t
+*/
+typedef struct opj_t2_packet_job {
+	/** packet identity */
+	const opj_pi_packet_t *packet;
+	/** number of the packet in its SOP marker */
+	OPJ_UINT32 packno;
+	/** job of the precinct of the packet, in opj_t2_t::precinct_jobs */
+	OPJ_UINT32 jobno;
+	/** next packet of the same precinct, in progression order */
+	OPJ_UINT32 next;
+	/** offset of the packet in the buffer of its precinct job, or in the data of the tile when decoding */
+	OPJ_SIZE_T offset;
+	/** length of the packet, header and body */
+	OPJ_UINT32 length;
+	/** length of the header of the packet, for the index */
+	OPJ_UINT32 header_length;
+	/** distortion decrease brought by the packet, for the index */
+	OPJ_FLOAT64 disto;
+} opj_t2_packet_job_t;
+
+/**
+Packets of a precinct, encoded one after the other into a buffer of their own, or decoded one
+after the other from the data of the tile. The packets of a precinct depend on the previous ones
+through its tag trees and code-blocks, but not on the packets of the other precincts: the jobs of
+different precincts can run in any order.
+*/
+typedef struct opj_t2_precinct_job {
+	/** first and last packets of the precinct, in opj_t2_t::packet_jobs */
+	OPJ_UINT32 first;
+	OPJ_UINT32 last;
+	/** buffer of the encoded packets, kept from a call to the next */
+	OPJ_BYTE *data;
+	/** size of data */
+	OPJ_SIZE_T data_size;
+} opj_t2_precinct_job_t;
+
 /**
 Tier-2 coding
 */
@@ -56,8 +94,33 @@ typedef struct opj_t2 {
 	opj_image_t *image;
 	/** pointer to the image coding parameters */
 	opj_cp_t *cp;
+	/** packets to encode or decode, in progression order */
+	opj_t2_packet_job_t *packet_jobs;
+	OPJ_UINT32 nb_packet_jobs_max;
+	/** jobs of the precincts of the packets */
+	opj_t2_precinct_job_t *precinct_jobs;
+	OPJ_UINT32 nb_precinct_jobs;
+	OPJ_UINT32 nb_precinct_jobs_max;
+	/** job of each precinct of the tile, by component, resolution and precinct */
+	OPJ_UINT32 *job_of_precinct;
+	OPJ_UINT32 nb_precincts_max;
 } opj_t2_t;
 
+/**
+Position of a packet in the data of a tile, see opj_t2_locate_packets
+*/
+typedef struct opj_t2_packet {
+	/** component, resolution, precinct and layer of the packet */
+	OPJ_UINT32 compno;
+	OPJ_UINT32 resno;
+	OPJ_UINT32 precno;
+	OPJ_UINT32 layno;
+	/** offset of the packet in the data of the tile, from its SOP marker if any */
+	OPJ_UINT32 offset;
+	/** length of the packet, header and body */
+	OPJ_UINT32 length;
+} opj_t2_packet_t;
+
 /** @name Exported functions */
 /*@{*/
 /* ----------------------------------------------------------------------- */
@@ -91,13 +154,14 @@ OPJ_BOOL opj_t2_encode_packets(	opj_t2_t* t2,
 								J2K_T2_MODE t2_mode);
 
 /**
-Decode the packets of a tile from a source buffer
+Decode the packets of a tile from a source buffer. When the PLT markers give the length of every
+packet of a complete tile, the packets of each precinct are decoded on their own from their positions.
 @param t2 T2 handle
 @param tileno number that identifies the tile for which to decode the packets
 @param tile tile for which to decode the packets
 @param src         FIXME DOC
 @param p_data_read the source buffer
-@param len length of the source buffer
+@param len length of the source buffer, the data of a tile may exceed 4 GB
 @param cstr_info   FIXME DOC
 
 @return FIXME DOC
@@ -106,11 +170,62 @@ OPJ_BOOL opj_t2_decode_packets(	opj_t2_t *t2,
                                 OPJ_UINT32 tileno,
                                 opj_tcd_tile_t *tile,
                                 OPJ_BYTE *src,
-                                OPJ_UINT32 * p_data_read,
-                                OPJ_UINT32 len,
+                                OPJ_SIZE_T * p_data_read,
+                                OPJ_SIZE_T len,
                                 opj_codestream_index_t *cstr_info,
                                 opj_event_mgr_t *p_manager);
 
+/**
+Decode the packets of a tile received so far, resuming after the packets read by the previous call.
+A packet is only read once all its data has been received, unless the tile is final: the
+state of its precinct is then restored and the packet is read again by the next call.
+@param t2 T2 handle
+@param tileno number that identifies the tile for which to decode the packets
+@param tile tile for which to decode the packets
+@param incr state of the tile, see opj_tcd_incr_tile_t
+@param p_data_read number of bytes of incr->data read
+@param p_manager the event manager.
+
+@return false if the tile could not be decoded
+ */
+OPJ_BOOL opj_t2_decode_packets_incremental(     opj_t2_t *t2,
+                                                OPJ_UINT32 tileno,
+                                                opj_tcd_tile_t *tile,
+                                                opj_tcd_incr_tile_t *incr,
+                                                OPJ_SIZE_T * p_data_read,
+                                                opj_event_mgr_t *p_manager);
+
+/**
+Number of bytes of the length of a packet in a PLT marker, 7 bits per byte
+@param p_length length of the packet
+@return the number of bytes of its Iplt field
+*/
+OPJ_UINT32 opj_t2_get_plt_length_size(OPJ_UINT32 p_length);
+
+/**
+Find the packets of a tile in a source buffer, reading their headers only
+@param t2 T2 handle
+@param tileno number that identifies the tile
+@param tile tile of the packets, its code-blocks are not decoded
+@param src the data of the tile
+@param len length of the source buffer
+@param packets receives the position of each packet, in the order of the codestream
+@param max_packets number of packets packets can hold
+@param p_nb_packets number of packets found. It is lower than the number of packets of the tile if src is truncated.
+@param p_manager the event manager.
+
+@return false if a packet could not be read
+ */
+OPJ_BOOL opj_t2_locate_packets(	opj_t2_t *t2,
+                                OPJ_UINT32 tileno,
+                                opj_tcd_tile_t *tile,
+                                OPJ_BYTE *src,
+                                OPJ_UINT32 len,
+                                opj_t2_packet_t *packets,
+                                OPJ_UINT32 max_packets,
+                                OPJ_UINT32 *p_nb_packets,
+                                opj_event_mgr_t *p_manager);
+
 /**
  * Creates a Tier 2 handle
  *
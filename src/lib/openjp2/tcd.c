@@ -104,15 +104,36 @@ void tcd_dump(FILE *fd, opj_tcd_t *tcd, opj_tcd_image_t * img) {
 }
 #endif
 
+/** Size of the slabs the code-block buffers are carved from */
+#define OPJ_TCD_SLAB_SIZE (1024U * 1024U)
+/** Size of the slab header, rounded to keep the slab data 16-byte aligned */
+#define OPJ_TCD_SLAB_HEADER_SIZE ((sizeof(opj_tcd_slab_t) + 15U) & ~(OPJ_SIZE_T)15U)
+
 /**
  * Initializes tile coding/decoding
  */
 static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no, OPJ_BOOL isEncoder, OPJ_FLOAT32 fraction, OPJ_SIZE_T sizeof_block, opj_event_mgr_t* manager);
 
+/**
+ * Tells if a tile component has to be decoded: it is one of the components to output
+ * (opj_tcd_t::m_used_comps) or the MCT of the tile needs it to rebuild one of them.
+ */
+static OPJ_BOOL opj_tcd_is_decoded_comp (opj_tcd_t *p_tcd, opj_tcp_t * p_tcp, OPJ_UINT32 p_compno);
+
+/**
+ * Carves a buffer out of the slabs of the tcd.
+ */
+static void * opj_tcd_slab_alloc (opj_tcd_t *p_tcd, OPJ_SIZE_T p_size);
+
+/**
+ * Releases all the slabs of the tcd.
+ */
+static void opj_tcd_slab_free_all (opj_tcd_t *p_tcd);
+
 /**
 * Allocates memory for a decoding code block.
 */
-static OPJ_BOOL opj_tcd_code_block_dec_allocate (opj_tcd_cblk_dec_t * p_code_block);
+static OPJ_BOOL opj_tcd_code_block_dec_allocate (opj_tcd_t *p_tcd, opj_tcd_cblk_dec_t * p_code_block);
 
 /**
  * Deallocates the decoding data of the given precinct.
@@ -122,12 +143,12 @@ static void opj_tcd_code_block_dec_deallocate (opj_tcd_precinct_t * p_precinct);
 /**
  * Allocates memory for an encoding code block (but not data).
  */
-static OPJ_BOOL opj_tcd_code_block_enc_allocate (opj_tcd_cblk_enc_t * p_code_block);
+static OPJ_BOOL opj_tcd_code_block_enc_allocate (opj_tcd_t *p_tcd, opj_tcd_cblk_enc_t * p_code_block);
 
 /**
  * Allocates data for an encoding code block
  */
-static OPJ_BOOL opj_tcd_code_block_enc_allocate_data (opj_tcd_cblk_enc_t * p_code_block);
+static OPJ_BOOL opj_tcd_code_block_enc_allocate_data (opj_tcd_t *p_tcd, opj_tcd_cblk_enc_t * p_code_block);
 
 /**
  * Deallocates the encoding data of the given precinct.
@@ -142,21 +163,35 @@ Free the memory allocated for encoding
 static void opj_tcd_free_tile(opj_tcd_t *tcd);
 
 
+/**
+ * Releases the state of a tile decoded incrementally.
+ */
+static void opj_tcd_free_incremental_tile(opj_tcd_t *p_tcd, opj_tcd_incr_tile_t * p_incr);
+
 static OPJ_BOOL opj_tcd_t2_decode ( opj_tcd_t *p_tcd,
                                     OPJ_BYTE * p_src_data,
-                                    OPJ_UINT32 * p_data_read,
-                                    OPJ_UINT32 p_max_src_size,
+                                    OPJ_SIZE_T * p_data_read,
+                                    OPJ_SIZE_T p_max_src_size,
                                     opj_codestream_index_t *p_cstr_index,
                                     opj_event_mgr_t *p_manager);
 
-static OPJ_BOOL opj_tcd_t1_decode (opj_tcd_t *p_tcd);
+/**
+ * Gets the Tier-1 handle of the tcd, creating it on first use.
+ */
+static opj_t1_t * opj_tcd_get_t1 (opj_tcd_t *p_tcd);
+
+static OPJ_BOOL opj_tcd_t1_decode (opj_tcd_t *p_tcd, opj_profile_stats_t * p_stats);
 
 static OPJ_BOOL opj_tcd_dwt_decode (opj_tcd_t *p_tcd);
 
 static OPJ_BOOL opj_tcd_mct_decode (opj_tcd_t *p_tcd, opj_event_mgr_t *p_manager);
 
+static OPJ_BOOL opj_tcd_mct_decode_data (opj_tcd_t *p_tcd, OPJ_INT32 ** p_data, OPJ_SIZE_T p_samples);
+
 static OPJ_BOOL opj_tcd_dc_level_shift_decode (opj_tcd_t *p_tcd);
 
+static void opj_tcd_dc_level_shift_decode_data (OPJ_INT32 * p_data, OPJ_UINT32 p_width, OPJ_UINT32 p_height, OPJ_UINT32 p_stride, opj_tccp_t * p_tccp, opj_image_comp_t * p_img_comp);
+
 
 static OPJ_BOOL opj_tcd_dc_level_shift_encode ( opj_tcd_t *p_tcd );
 
@@ -164,7 +199,12 @@ static OPJ_BOOL opj_tcd_mct_encode ( opj_tcd_t *p_tcd );
 
 static OPJ_BOOL opj_tcd_dwt_encode ( opj_tcd_t *p_tcd );
 
-static OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd );
+static OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd, opj_profile_stats_t * p_stats );
+
+/**
+ * Adds the code-blocks of the current tile, their passes and the size of their data to the statistics.
+ */
+static void opj_tcd_profile_code_blocks ( opj_tcd_t *p_tcd, opj_profile_stats_t * p_stats );
 
 static OPJ_BOOL opj_tcd_t2_encode (     opj_tcd_t *p_tcd,
                                                                     OPJ_BYTE * p_dest_data,
@@ -177,6 +217,11 @@ static OPJ_BOOL opj_tcd_rate_allocate_encode(   opj_tcd_t *p_tcd,
                                                                                         OPJ_UINT32 p_max_dest_size,
                                                                                         opj_codestream_info_t *p_cstr_info );
 
+/**
+ * Counts the packets of the tile initialized in the tcd, all layers included.
+ */
+static OPJ_BOOL opj_tcd_get_nb_packets(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no, OPJ_UINT32 *p_nb_packets, opj_event_mgr_t *p_manager);
+
 /* ----------------------------------------------------------------------- */
 
 /**
@@ -459,8 +504,8 @@ OPJ_BOOL opj_tcd_rateallocate(  opj_tcd_t *tcd,
                                                 } /* passno */
 
                                                 /* fixed_quality */
-                                                tcd_tile->numpix += ((cblk->x1 - cblk->x0) * (cblk->y1 - cblk->y0));
-                                                tilec->numpix += ((cblk->x1 - cblk->x0) * (cblk->y1 - cblk->y0));
+                                                tcd_tile->numpix += (OPJ_UINT64)((cblk->x1 - cblk->x0) * (cblk->y1 - cblk->y0));
+                                                tilec->numpix += (OPJ_UINT64)((cblk->x1 - cblk->x0) * (cblk->y1 - cblk->y0));
                                         } /* cbklno */
                                 } /* precno */
                         } /* bandno */
@@ -474,7 +519,7 @@ OPJ_BOOL opj_tcd_rateallocate(  opj_tcd_t *tcd,
         /* index file */
         if(cstr_info) {
                 opj_tile_info_t *tile_info = &cstr_info->tile[tcd->tcd_tileno];
-                tile_info->numpix = tcd_tile->numpix;
+                tile_info->numpix = (int)tcd_tile->numpix;
                 tile_info->distotile = tcd_tile->distotile;
                 tile_info->thresh = (OPJ_FLOAT64 *) opj_malloc(tcd_tcp->numlayers * sizeof(OPJ_FLOAT64));
                 if (!tile_info->thresh) {
@@ -613,7 +658,14 @@ Destroy a previously created TCD handle
 */
 void opj_tcd_destroy(opj_tcd_t *tcd) {
         if (tcd) {
+                opj_tcd_free_incremental_tiles(tcd);
                 opj_tcd_free_tile(tcd);
+                opj_tcd_slab_free_all(tcd);
+
+                if (tcd->m_t1) {
+                        opj_t1_destroy(tcd->m_t1);
+                        tcd->m_t1 = 00;
+                }
 
                 if (tcd->tcd_image) {
                         opj_free(tcd->tcd_image);
@@ -689,6 +741,8 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 	OPJ_UINT32 l_nb_code_blocks_size;
 	/* size of data for a tile */
 	OPJ_UINT32 l_data_size;
+	/* number of samples of a tile component */
+	OPJ_UINT64 l_nb_samples;
 	
 	l_cp = p_tcd->cp;
 	l_tcp = &(l_cp->tcps[p_tile_no]);
@@ -710,6 +764,9 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 	l_tile->y0 = (OPJ_INT32)opj_uint_max(l_ty0, l_image->y0);
 	l_tile->y1 = (OPJ_INT32)opj_uint_min(opj_uint_adds(l_ty0, l_cp->tdy), l_image->y1);
 
+	/* the packets of the tile are listed again by tier-2 */
+	l_tile->order_valid = 0;
+
 	/* testcase 1888.pdf.asan.35.988 */
 	if (l_tccp->numresolutions == 0) {
 		opj_event_msg(manager, EVT_ERROR, "tiles require at least one resolution\n");
@@ -721,6 +778,7 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 	for (compno = 0; compno < l_tile->numcomps; ++compno) {
 		/*fprintf(stderr, "compno = %d/%d\n", compno, l_tile->numcomps);*/
 		l_image_comp->resno_decoded = 0;
+		l_tilec->skipped = p_tcd->m_is_decoder && ! opj_tcd_is_decoded_comp(p_tcd, l_tcp, compno);
 		/* border of each l_tile component (global) */
 		l_tilec->x0 = opj_int_ceildiv(l_tile->x0, (OPJ_INT32)l_image_comp->dx);
 		l_tilec->y0 = opj_int_ceildiv(l_tile->y0, (OPJ_INT32)l_image_comp->dy);
@@ -728,19 +786,12 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 		l_tilec->y1 = opj_int_ceildiv(l_tile->y1, (OPJ_INT32)l_image_comp->dy);
 		/*fprintf(stderr, "\tTile compo border = %d,%d,%d,%d\n", l_tilec->x0, l_tilec->y0,l_tilec->x1,l_tilec->y1);*/
 		
-		/* compute l_data_size with overflow check */
-		l_data_size = (OPJ_UINT32)(l_tilec->x1 - l_tilec->x0);
-		if ((((OPJ_UINT32)-1) / l_data_size) < (OPJ_UINT32)(l_tilec->y1 - l_tilec->y0)) {
-			opj_event_msg(manager, EVT_ERROR, "Not enough memory for tile data\n");
-			return OPJ_FALSE;
-		}
-		l_data_size = l_data_size * (OPJ_UINT32)(l_tilec->y1 - l_tilec->y0);
-		
-		if ((((OPJ_UINT32)-1) / (OPJ_UINT32)sizeof(OPJ_UINT32)) < l_data_size) {
+		/* the samples of a tile component are indexed with sizes, only their size in bytes is limited */
+		l_nb_samples = (OPJ_UINT64)(OPJ_UINT32)(l_tilec->x1 - l_tilec->x0) * (OPJ_UINT32)(l_tilec->y1 - l_tilec->y0);
+		if (l_nb_samples > (OPJ_SIZE_T)-1 / sizeof(OPJ_UINT32)) {
 			opj_event_msg(manager, EVT_ERROR, "Not enough memory for tile data\n");
 			return OPJ_FALSE;
 		}
-		l_data_size = l_data_size * (OPJ_UINT32)sizeof(OPJ_UINT32);
 		l_tilec->numresolutions = l_tccp->numresolutions;
 		if (l_tccp->numresolutions < l_cp->m_specific_param.m_dec.m_reduce) {
 			l_tilec->minimum_num_resolutions = 1;
@@ -749,8 +800,8 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 			l_tilec->minimum_num_resolutions = l_tccp->numresolutions - l_cp->m_specific_param.m_dec.m_reduce;
 		}
 		
-		l_tilec->data_size_needed = l_data_size;
-		if (p_tcd->m_is_decoder && !opj_alloc_tile_component_data(l_tilec)) {
+		l_tilec->data_size_needed = (OPJ_SIZE_T)l_nb_samples * sizeof(OPJ_UINT32);
+		if (p_tcd->m_is_decoder && !p_tcd->m_strip_decode && !l_tilec->skipped && !opj_alloc_tile_component_data(l_tilec)) {
 			opj_event_msg(manager, EVT_ERROR, "Not enough memory for tile data\n");
 			return OPJ_FALSE;
 		}
@@ -996,7 +1047,7 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 						if (isEncoder) {
 							opj_tcd_cblk_enc_t* l_code_block = l_current_precinct->cblks.enc + cblkno;
 							
-							if (! opj_tcd_code_block_enc_allocate(l_code_block)) {
+							if (! opj_tcd_code_block_enc_allocate(p_tcd, l_code_block)) {
 								return OPJ_FALSE;
 							}
 							/* code-block size (global) */
@@ -1005,13 +1056,13 @@ static INLINE OPJ_BOOL opj_tcd_init_tile(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no,
 							l_code_block->x1 = opj_int_min(cblkxend, l_current_precinct->x1);
 							l_code_block->y1 = opj_int_min(cblkyend, l_current_precinct->y1);
 							
-							if (! opj_tcd_code_block_enc_allocate_data(l_code_block)) {
+							if (! opj_tcd_code_block_enc_allocate_data(p_tcd, l_code_block)) {
 								return OPJ_FALSE;
 							}
 						} else {
 							opj_tcd_cblk_dec_t* l_code_block = l_current_precinct->cblks.dec + cblkno;
 							
-							if (! opj_tcd_code_block_dec_allocate(l_code_block)) {
+							if (! opj_tcd_code_block_dec_allocate(p_tcd, l_code_block)) {
 								return OPJ_FALSE;
 							}
 							/* code-block size (global) */
@@ -1041,28 +1092,91 @@ OPJ_BOOL opj_tcd_init_encode_tile (opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no, opj_e
 	return opj_tcd_init_tile(p_tcd, p_tile_no, OPJ_TRUE, 1.0F, sizeof(opj_tcd_cblk_enc_t), p_manager);
 }
 
+static OPJ_BOOL opj_tcd_is_decoded_comp (opj_tcd_t *p_tcd, opj_tcp_t * p_tcp, OPJ_UINT32 p_compno)
+{
+        const OPJ_BOOL * l_used = p_tcd->m_used_comps;
+
+        if (! l_used || l_used[p_compno]) {
+                return OPJ_TRUE;
+        }
+
+        /* a custom MCT mixes all the components, the reversible and irreversible ones the first three */
+        if (p_tcp->mct == 2) {
+                return OPJ_TRUE;
+        }
+        if (p_tcp->mct == 1 && p_tcd->image->numcomps >= 3 && p_compno < 3) {
+                return l_used[0] || l_used[1] || l_used[2];
+        }
+
+        return OPJ_FALSE;
+}
+
 OPJ_BOOL opj_tcd_init_decode_tile (opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no, opj_event_mgr_t* p_manager)
 {
 	return opj_tcd_init_tile(p_tcd, p_tile_no, OPJ_FALSE, 0.5F, sizeof(opj_tcd_cblk_dec_t), p_manager);
 }
 
+/**
+ * Carves a buffer out of the slabs of the tcd. The buffer lives as long as the tcd.
+ */
+static void * opj_tcd_slab_alloc (opj_tcd_t *p_tcd, OPJ_SIZE_T p_size)
+{
+	opj_tcd_slab_t * l_slab = p_tcd->m_slabs;
+	OPJ_BYTE * l_ptr;
+
+	/* keep the buffers 16-byte aligned */
+	p_size = (p_size + 15U) & ~(OPJ_SIZE_T)15U;
+
+	if ((! l_slab) || (l_slab->size - l_slab->used < p_size)) {
+		OPJ_SIZE_T l_slab_size = (p_size > OPJ_TCD_SLAB_SIZE) ? p_size : OPJ_TCD_SLAB_SIZE;
+
+		l_slab = (opj_tcd_slab_t *) opj_malloc(OPJ_TCD_SLAB_HEADER_SIZE + l_slab_size);
+		if (! l_slab) {
+			return 00;
+		}
+		l_slab->size = l_slab_size;
+		l_slab->used = 0;
+		l_slab->next = p_tcd->m_slabs;
+		p_tcd->m_slabs = l_slab;
+	}
+
+	l_ptr = (OPJ_BYTE *) l_slab + OPJ_TCD_SLAB_HEADER_SIZE + l_slab->used;
+	l_slab->used += p_size;
+
+	return l_ptr;
+}
+
+static void opj_tcd_slab_free_all (opj_tcd_t *p_tcd)
+{
+	opj_tcd_slab_t * l_slab = p_tcd->m_slabs;
+
+	while (l_slab) {
+		opj_tcd_slab_t * l_next = l_slab->next;
+		opj_free(l_slab);
+		l_slab = l_next;
+	}
+	p_tcd->m_slabs = 00;
+}
+
 /**
  * Allocates memory for an encoding code block (but not data memory).
  */
-static OPJ_BOOL opj_tcd_code_block_enc_allocate (opj_tcd_cblk_enc_t * p_code_block)
+static OPJ_BOOL opj_tcd_code_block_enc_allocate (opj_tcd_t *p_tcd, opj_tcd_cblk_enc_t * p_code_block)
 {
 	if (! p_code_block->layers) {
 		/* no memset since data */
-		p_code_block->layers = (opj_tcd_layer_t*) opj_calloc(100, sizeof(opj_tcd_layer_t));
+		p_code_block->layers = (opj_tcd_layer_t*) opj_tcd_slab_alloc(p_tcd, 100 * sizeof(opj_tcd_layer_t));
 		if (! p_code_block->layers) {
 			return OPJ_FALSE;
 		}
+		memset(p_code_block->layers, 0, 100 * sizeof(opj_tcd_layer_t));
 	}
 	if (! p_code_block->passes) {
-		p_code_block->passes = (opj_tcd_pass_t*) opj_calloc(100, sizeof(opj_tcd_pass_t));
+		p_code_block->passes = (opj_tcd_pass_t*) opj_tcd_slab_alloc(p_tcd, 100 * sizeof(opj_tcd_pass_t));
 		if (! p_code_block->passes) {
 			return OPJ_FALSE;
 		}
+		memset(p_code_block->passes, 0, 100 * sizeof(opj_tcd_pass_t));
 	}
 	return OPJ_TRUE;
 }
@@ -1070,17 +1184,25 @@ static OPJ_BOOL opj_tcd_code_block_enc_allocate (opj_tcd_cblk_enc_t * p_code_blo
 /**
  * Allocates data memory for an encoding code block.
  */
-static OPJ_BOOL opj_tcd_code_block_enc_allocate_data (opj_tcd_cblk_enc_t * p_code_block)
+static OPJ_BOOL opj_tcd_code_block_enc_allocate_data (opj_tcd_t *p_tcd, opj_tcd_cblk_enc_t * p_code_block)
 {
 	OPJ_UINT32 l_data_size;
 	
 	l_data_size = (OPJ_UINT32)((p_code_block->x1 - p_code_block->x0) * (p_code_block->y1 - p_code_block->y0) * (OPJ_INT32)sizeof(OPJ_UINT32));
 	
 	if (l_data_size > p_code_block->data_size) {
-		if (p_code_block->data) {
-			opj_free(p_code_block->data - 1); /* again, why -1 */
+		if (! p_code_block->data) {
+			p_code_block->data = (OPJ_BYTE*) opj_tcd_slab_alloc(p_tcd, l_data_size+1);
+			p_code_block->m_data_in_slab = 1;
+		}
+		else {
+			/* a code-block outgrowing its buffer gets one of its own, freed when it grows again */
+			if (! p_code_block->m_data_in_slab) {
+				opj_free(p_code_block->data - 1);
+			}
+			p_code_block->data = (OPJ_BYTE*) opj_malloc(l_data_size+1);
+			p_code_block->m_data_in_slab = 0;
 		}
-		p_code_block->data = (OPJ_BYTE*) opj_malloc(l_data_size+1);
 		if(! p_code_block->data) {
 			p_code_block->data_size = 0U;
 			return OPJ_FALSE;
@@ -1096,21 +1218,24 @@ static OPJ_BOOL opj_tcd_code_block_enc_allocate_data (opj_tcd_cblk_enc_t * p_cod
 /**
  * Allocates memory for a decoding code block.
  */
-static OPJ_BOOL opj_tcd_code_block_dec_allocate (opj_tcd_cblk_dec_t * p_code_block)
+static OPJ_BOOL opj_tcd_code_block_dec_allocate (opj_tcd_t *p_tcd, opj_tcd_cblk_dec_t * p_code_block)
 {
         if (! p_code_block->data) {
 
-                p_code_block->data = (OPJ_BYTE*) opj_malloc(OPJ_J2K_DEFAULT_CBLK_DATA_SIZE);
+                p_code_block->data = (OPJ_BYTE*) opj_tcd_slab_alloc(p_tcd, OPJ_J2K_DEFAULT_CBLK_DATA_SIZE);
                 if (! p_code_block->data) {
                         return OPJ_FALSE;
                 }
                 p_code_block->data_max_size = OPJ_J2K_DEFAULT_CBLK_DATA_SIZE;
+                p_code_block->m_data_in_slab = 1;
                 /*fprintf(stderr, "Allocate 8192 elements of code_block->data\n");*/
 
-                p_code_block->segs = (opj_tcd_seg_t *) opj_calloc(OPJ_J2K_DEFAULT_NB_SEGS,sizeof(opj_tcd_seg_t));
+                p_code_block->segs = (opj_tcd_seg_t *) opj_tcd_slab_alloc(p_tcd, OPJ_J2K_DEFAULT_NB_SEGS * sizeof(opj_tcd_seg_t));
                 if (! p_code_block->segs) {
                         return OPJ_FALSE;
                 }
+                memset(p_code_block->segs, 0, OPJ_J2K_DEFAULT_NB_SEGS * sizeof(opj_tcd_seg_t));
+                p_code_block->m_segs_in_slab = 1;
                 /*fprintf(stderr, "Allocate %d elements of code_block->data\n", OPJ_J2K_DEFAULT_NB_SEGS * sizeof(opj_tcd_seg_t));*/
 
                 p_code_block->m_current_max_segs = OPJ_J2K_DEFAULT_NB_SEGS;
@@ -1121,21 +1246,25 @@ static OPJ_BOOL opj_tcd_code_block_dec_allocate (opj_tcd_cblk_dec_t * p_code_blo
 					OPJ_UINT32 l_data_max_size = p_code_block->data_max_size;
 					opj_tcd_seg_t * l_segs = p_code_block->segs;
 					OPJ_UINT32 l_current_max_segs = p_code_block->m_current_max_segs;
+					OPJ_UINT32 l_data_in_slab = p_code_block->m_data_in_slab;
+					OPJ_UINT32 l_segs_in_slab = p_code_block->m_segs_in_slab;
 
 					memset(p_code_block, 0, sizeof(opj_tcd_cblk_dec_t));
 					p_code_block->data = l_data;
 					p_code_block->data_max_size = l_data_max_size;
 					p_code_block->segs = l_segs;
 					p_code_block->m_current_max_segs = l_current_max_segs;
+					p_code_block->m_data_in_slab = (l_data_in_slab != 0);
+					p_code_block->m_segs_in_slab = (l_segs_in_slab != 0);
 				}
 
         return OPJ_TRUE;
 }
 
-OPJ_UINT32 opj_tcd_get_decoded_tile_size ( opj_tcd_t *p_tcd )
+OPJ_SIZE_T opj_tcd_get_decoded_tile_size ( opj_tcd_t *p_tcd )
 {
         OPJ_UINT32 i;
-        OPJ_UINT32 l_data_size = 0;
+        OPJ_SIZE_T l_data_size = 0;
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_tilecomp_t * l_tile_comp = 00;
         opj_tcd_resolution_t * l_res = 00;
@@ -1145,6 +1274,12 @@ OPJ_UINT32 opj_tcd_get_decoded_tile_size ( opj_tcd_t *p_tcd )
         l_img_comp = p_tcd->image->comps;
 
         for (i=0;i<p_tcd->image->numcomps;++i) {
+                if (p_tcd->m_used_comps && ! p_tcd->m_used_comps[i]) {
+                        ++l_img_comp;
+                        ++l_tile_comp;
+                        continue;
+                }
+
                 l_size_comp = l_img_comp->prec >> 3; /*(/ 8)*/
                 l_remaining = l_img_comp->prec & 7;  /* (%8) */
 
@@ -1157,7 +1292,7 @@ OPJ_UINT32 opj_tcd_get_decoded_tile_size ( opj_tcd_t *p_tcd )
                 }
 
                 l_res = l_tile_comp->resolutions + l_tile_comp->minimum_num_resolutions - 1;
-                l_data_size += l_size_comp * (OPJ_UINT32)((l_res->x1 - l_res->x0) * (l_res->y1 - l_res->y0));
+                l_data_size = opj_size_adds(l_data_size, opj_size_muls(l_size_comp, (OPJ_SIZE_T)(OPJ_UINT32)(l_res->x1 - l_res->x0) * (OPJ_UINT32)(l_res->y1 - l_res->y0)));
                 ++l_img_comp;
                 ++l_tile_comp;
         }
@@ -1172,6 +1307,8 @@ OPJ_BOOL opj_tcd_encode_tile(   opj_tcd_t *p_tcd,
                                                         OPJ_UINT32 p_max_length,
                                                         opj_codestream_info_t *p_cstr_info)
 {
+        opj_profile_stats_t * l_stats = opj_profile_get_tile(p_tcd->m_profile, p_tile_no);
+        OPJ_FLOAT64 l_start;
 
         if (p_tcd->cur_tp_num == 0) {
 
@@ -1203,37 +1340,40 @@ OPJ_BOOL opj_tcd_encode_tile(   opj_tcd_t *p_tcd,
                 }
                 /* << INDEX */
 
-                /* FIXME _ProfStart(PGROUP_DC_SHIFT); */
                 /*---------------TILE-------------------*/
+                l_start = opj_profile_start(l_stats);
                 if (! opj_tcd_dc_level_shift_encode(p_tcd)) {
                         return OPJ_FALSE;
                 }
-                /* FIXME _ProfStop(PGROUP_DC_SHIFT); */
+                opj_profile_stop(l_stats, OPJ_PROFILE_DC_SHIFT, l_start);
 
-                /* FIXME _ProfStart(PGROUP_MCT); */
+                l_start = opj_profile_start(l_stats);
                 if (! opj_tcd_mct_encode(p_tcd)) {
                         return OPJ_FALSE;
                 }
-                /* FIXME _ProfStop(PGROUP_MCT); */
+                opj_profile_stop(l_stats, OPJ_PROFILE_MCT, l_start);
 
-                /* FIXME _ProfStart(PGROUP_DWT); */
+                l_start = opj_profile_start(l_stats);
                 if (! opj_tcd_dwt_encode(p_tcd)) {
                         return OPJ_FALSE;
                 }
-                /* FIXME  _ProfStop(PGROUP_DWT); */
+                opj_profile_stop(l_stats, OPJ_PROFILE_DWT, l_start);
 
-                /* FIXME  _ProfStart(PGROUP_T1); */
-                if (! opj_tcd_t1_encode(p_tcd)) {
+                l_start = opj_profile_start(l_stats);
+                if (! opj_tcd_t1_encode(p_tcd, l_stats)) {
                         return OPJ_FALSE;
                 }
-                /* FIXME _ProfStop(PGROUP_T1); */
+                opj_profile_stop(l_stats, OPJ_PROFILE_T1, l_start);
 
-                /* FIXME _ProfStart(PGROUP_RATE); */
+                l_start = opj_profile_start(l_stats);
                 if (! opj_tcd_rate_allocate_encode(p_tcd,p_dest,p_max_length,p_cstr_info)) {
                         return OPJ_FALSE;
                 }
-                /* FIXME _ProfStop(PGROUP_RATE); */
+                opj_profile_stop(l_stats, OPJ_PROFILE_RATE, l_start);
 
+                if (l_stats) {
+                        opj_tcd_profile_code_blocks(p_tcd, l_stats);
+                }
         }
         /*--------------TIER2------------------*/
 
@@ -1241,12 +1381,11 @@ OPJ_BOOL opj_tcd_encode_tile(   opj_tcd_t *p_tcd,
         if (p_cstr_info) {
                 p_cstr_info->index_write = 1;
         }
-        /* FIXME _ProfStart(PGROUP_T2); */
-
+        l_start = opj_profile_start(l_stats);
         if (! opj_tcd_t2_encode(p_tcd,p_dest,p_data_written,p_max_length,p_cstr_info)) {
                 return OPJ_FALSE;
         }
-        /* FIXME _ProfStop(PGROUP_T2); */
+        opj_profile_stop(l_stats, OPJ_PROFILE_T2, l_start);
 
         /*---------------CLEAN-------------------*/
 
@@ -1255,13 +1394,16 @@ OPJ_BOOL opj_tcd_encode_tile(   opj_tcd_t *p_tcd,
 
 OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *p_tcd,
                                 OPJ_BYTE *p_src,
-                                OPJ_UINT32 p_max_length,
+                                OPJ_SIZE_T p_max_length,
                                 OPJ_UINT32 p_tile_no,
                                 opj_codestream_index_t *p_cstr_index,
                                 opj_event_mgr_t *p_manager
                                 )
 {
-        OPJ_UINT32 l_data_read;
+        OPJ_SIZE_T l_data_read;
+        opj_profile_stats_t * l_stats = opj_profile_get_tile(p_tcd->m_profile, p_tile_no);
+        OPJ_FLOAT64 l_start;
+
         p_tcd->tcd_tileno = p_tile_no;
         p_tcd->tcp = &(p_tcd->cp->tcps[p_tile_no]);
 
@@ -1289,62 +1431,876 @@ OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *p_tcd,
 #endif
 
         /*--------------TIER2------------------*/
-        /* FIXME _ProfStart(PGROUP_T2); */
+        l_start = opj_profile_start(l_stats);
         l_data_read = 0;
         if (! opj_tcd_t2_decode(p_tcd, p_src, &l_data_read, p_max_length, p_cstr_index, p_manager))
         {
                 return OPJ_FALSE;
         }
-        /* FIXME _ProfStop(PGROUP_T2); */
+        opj_profile_stop(l_stats, OPJ_PROFILE_T2, l_start);
+
+        if (l_stats) {
+                opj_tcd_profile_code_blocks(p_tcd, l_stats);
+        }
 
         /*------------------TIER1-----------------*/
 
-        /* FIXME _ProfStart(PGROUP_T1); */
+        l_start = opj_profile_start(l_stats);
         if
-                (! opj_tcd_t1_decode(p_tcd))
+                (! opj_tcd_t1_decode(p_tcd, l_stats))
         {
                 return OPJ_FALSE;
         }
-        /* FIXME _ProfStop(PGROUP_T1); */
+        opj_profile_stop(l_stats, OPJ_PROFILE_T1, l_start);
 
         /*----------------DWT---------------------*/
 
-        /* FIXME _ProfStart(PGROUP_DWT); */
+        l_start = opj_profile_start(l_stats);
         if
                 (! opj_tcd_dwt_decode(p_tcd))
         {
                 return OPJ_FALSE;
         }
-        /* FIXME _ProfStop(PGROUP_DWT); */
+        opj_profile_stop(l_stats, OPJ_PROFILE_DWT, l_start);
 
         /*----------------MCT-------------------*/
-        /* FIXME _ProfStart(PGROUP_MCT); */
+        l_start = opj_profile_start(l_stats);
         if
                 (! opj_tcd_mct_decode(p_tcd, p_manager))
         {
                 return OPJ_FALSE;
         }
-        /* FIXME _ProfStop(PGROUP_MCT); */
+        opj_profile_stop(l_stats, OPJ_PROFILE_MCT, l_start);
 
-        /* FIXME _ProfStart(PGROUP_DC_SHIFT); */
+        l_start = opj_profile_start(l_stats);
         if
                 (! opj_tcd_dc_level_shift_decode(p_tcd))
         {
                 return OPJ_FALSE;
         }
-        /* FIXME _ProfStop(PGROUP_DC_SHIFT); */
+        opj_profile_stop(l_stats, OPJ_PROFILE_DC_SHIFT, l_start);
 
 
         /*---------------TILE-------------------*/
         return OPJ_TRUE;
 }
 
+/**
+ * Decoded rows of a band, kept by the strip decoder as long as the next strips need them.
+ */
+typedef struct opj_tcd_band_rows
+{
+        /** band of the rows */
+        opj_tcd_band_t * band;
+        /** code-blocks of the band, sorted by their first row */
+        opj_tcd_cblk_dec_t ** cblks;
+        /** number of code-blocks of the band */
+        OPJ_UINT32 nb_cblks;
+        /** first code-block which may still be needed */
+        OPJ_UINT32 first_cblk;
+        /** rows y0 to y1 - 1 of the band (in band coordinates), with a stride of the band width */
+        OPJ_INT32 * data;
+        OPJ_INT32 y0;
+        OPJ_INT32 y1;
+        /** number of rows data can hold, the ones of the largest window so far */
+        OPJ_UINT32 nb_rows_max;
+} opj_tcd_band_rows_t;
+
+/**
+ * State of the strip decoder for a tile component, given to opj_dwt_decode_rows.
+ */
+typedef struct opj_tcd_strip_comp
+{
+        /** tile component decoded */
+        opj_tcd_tilecomp_t * tilec;
+        /** coding parameters of the tile component */
+        opj_tccp_t * tccp;
+        /** Tier-1 handle of the tcd */
+        opj_t1_t * t1;
+        /** rows of the band bandno of the resolution resno, at index resno * 3 + bandno */
+        opj_tcd_band_rows_t * bands;
+        /** number of resolutions decoded */
+        OPJ_UINT32 numres;
+        /** decoded rows of the current strip */
+        OPJ_INT32 * strip;
+        /** rows of the current strip, relative to the top of the resolution decoded */
+        OPJ_UINT32 row0;
+        OPJ_UINT32 row1;
+        /** statistics of the tile (may be NULL) */
+        opj_profile_stats_t * stats;
+        /** time spent decoding code-blocks, so that it is not counted twice */
+        OPJ_FLOAT64 t1_time;
+} opj_tcd_strip_comp_t;
+
+static int opj_tcd_compare_cblks(const void * p_cblk1, const void * p_cblk2)
+{
+        const opj_tcd_cblk_dec_t * l_cblk1 = *(const opj_tcd_cblk_dec_t * const *) p_cblk1;
+        const opj_tcd_cblk_dec_t * l_cblk2 = *(const opj_tcd_cblk_dec_t * const *) p_cblk2;
+
+        if (l_cblk1->y0 != l_cblk2->y0) {
+                return (l_cblk1->y0 < l_cblk2->y0) ? -1 : 1;
+        }
+        if (l_cblk1->x0 != l_cblk2->x0) {
+                return (l_cblk1->x0 < l_cblk2->x0) ? -1 : 1;
+        }
+        return 0;
+}
+
+/**
+ * Gives some rows of a band to opj_dwt_decode_rows, decoding the code-blocks covering them
+ * which have not been decoded yet. The rows of the code-blocks above the rows wanted are released:
+ * the rows kept slide to the top of the buffer of the band, which only grows for a larger window.
+ */
+static const OPJ_INT32 * opj_tcd_get_band_rows(void * p_user_data,
+                                               OPJ_UINT32 p_resno,
+                                               OPJ_UINT32 p_bandno,
+                                               OPJ_UINT32 p_y0,
+                                               OPJ_UINT32 p_y1)
+{
+        opj_tcd_strip_comp_t * l_comp = (opj_tcd_strip_comp_t *) p_user_data;
+        opj_tcd_band_rows_t * l_rows = &(l_comp->bands[p_resno * 3 + p_bandno]);
+        opj_tcd_band_t * l_band = l_rows->band;
+        OPJ_UINT32 l_width = (OPJ_UINT32)(l_band->x1 - l_band->x0);
+        OPJ_INT32 l_y0 = l_band->y0 + (OPJ_INT32)p_y0;
+        OPJ_INT32 l_y1 = l_band->y0 + (OPJ_INT32)p_y1;
+        OPJ_INT32 l_new_y0 = l_y0;
+        OPJ_INT32 l_new_y1 = l_y1;
+        OPJ_INT32 l_copy_y0, l_copy_y1;
+        OPJ_UINT32 l_nb_rows;
+        OPJ_INT32 * l_data;
+        OPJ_BOOL l_grown;
+        OPJ_UINT32 i;
+        OPJ_FLOAT64 l_start;
+
+        if (l_rows->data && l_y0 >= l_rows->y0 && l_y1 <= l_rows->y1) {
+                return l_rows->data + (OPJ_SIZE_T)(l_y0 - l_rows->y0) * l_width;
+        }
+
+        if (l_y0 < l_rows->y0) {
+                l_rows->first_cblk = 0;
+        }
+        while (l_rows->first_cblk < l_rows->nb_cblks && l_rows->cblks[l_rows->first_cblk]->y1 <= l_y0) {
+                ++l_rows->first_cblk;
+        }
+
+        /* the rows kept are made of whole code-blocks */
+        do {
+                l_grown = OPJ_FALSE;
+                for (i = l_rows->first_cblk; i < l_rows->nb_cblks && l_rows->cblks[i]->y0 < l_new_y1; ++i) {
+                        opj_tcd_cblk_dec_t * l_cblk = l_rows->cblks[i];
+
+                        if (l_cblk->y1 <= l_new_y0) {
+                                continue;
+                        }
+                        if (l_cblk->y0 < l_new_y0) {
+                                l_new_y0 = l_cblk->y0;
+                                l_rows->first_cblk = 0;
+                                l_grown = OPJ_TRUE;
+                        }
+                        if (l_cblk->y1 > l_new_y1) {
+                                l_new_y1 = l_cblk->y1;
+                                l_grown = OPJ_TRUE;
+                        }
+                }
+        } while (l_grown);
+
+        /* rows already decoded, kept */
+        if (l_rows->data && opj_int_max(l_new_y0, l_rows->y0) < opj_int_min(l_new_y1, l_rows->y1)) {
+                l_copy_y0 = opj_int_max(l_new_y0, l_rows->y0);
+                l_copy_y1 = opj_int_min(l_new_y1, l_rows->y1);
+        }
+        else {
+                l_copy_y0 = l_copy_y1 = l_new_y0;
+        }
+
+        l_nb_rows = (OPJ_UINT32)(l_new_y1 - l_new_y0);
+        if (l_nb_rows > l_rows->nb_rows_max || ! l_rows->data) {
+                l_data = (OPJ_INT32 *) opj_malloc(opj_uint_max(l_width * l_nb_rows, 1) * sizeof(OPJ_INT32));
+                if (! l_data) {
+                        return 00;
+                }
+                if (l_copy_y1 > l_copy_y0) {
+                        memcpy(l_data + (OPJ_SIZE_T)(l_copy_y0 - l_new_y0) * l_width,
+                               l_rows->data + (OPJ_SIZE_T)(l_copy_y0 - l_rows->y0) * l_width,
+                               (OPJ_SIZE_T)l_width * (OPJ_UINT32)(l_copy_y1 - l_copy_y0) * sizeof(OPJ_INT32));
+                }
+                opj_free(l_rows->data);
+                l_rows->data = l_data;
+                l_rows->nb_rows_max = l_nb_rows;
+        }
+        else {
+                l_data = l_rows->data;
+                if (l_copy_y1 > l_copy_y0 && l_new_y0 != l_rows->y0) {
+                        memmove(l_data + (OPJ_SIZE_T)(l_copy_y0 - l_new_y0) * l_width,
+                                l_data + (OPJ_SIZE_T)(l_copy_y0 - l_rows->y0) * l_width,
+                                (OPJ_SIZE_T)l_width * (OPJ_UINT32)(l_copy_y1 - l_copy_y0) * sizeof(OPJ_INT32));
+                }
+        }
+
+        /* the other rows are decoded */
+        memset(l_data, 0, (OPJ_SIZE_T)l_width * (OPJ_UINT32)(l_copy_y0 - l_new_y0) * sizeof(OPJ_INT32));
+        memset(l_data + (OPJ_SIZE_T)(l_copy_y1 - l_new_y0) * l_width, 0,
+               (OPJ_SIZE_T)l_width * (OPJ_UINT32)(l_new_y1 - l_copy_y1) * sizeof(OPJ_INT32));
+
+        l_start = opj_profile_start(l_comp->stats);
+        for (i = l_rows->first_cblk; i < l_rows->nb_cblks && l_rows->cblks[i]->y0 < l_new_y1; ++i) {
+                opj_tcd_cblk_dec_t * l_cblk = l_rows->cblks[i];
+
+                if (l_cblk->y1 <= l_new_y0) {
+                        continue;
+                }
+                if (l_cblk->y0 >= l_copy_y0 && l_cblk->y1 <= l_copy_y1) {
+                        /* already decoded */
+                        continue;
+                }
+                if (! opj_t1_decode_cblk_into(l_comp->t1, l_cblk, l_band, l_comp->tccp,
+                                              l_data + (OPJ_SIZE_T)(l_cblk->y0 - l_new_y0) * l_width + (OPJ_UINT32)(l_cblk->x0 - l_band->x0),
+                                              l_width)) {
+                        /* the buffer holds no valid rows anymore */
+                        l_rows->y0 = l_rows->y1 = l_new_y0;
+                        return 00;
+                }
+        }
+        if (l_comp->stats) {
+                OPJ_FLOAT64 l_elapsed = opj_profile_start(l_comp->stats) - l_start;
+                l_comp->stats->times[OPJ_PROFILE_T1] += l_elapsed;
+                l_comp->t1_time += l_elapsed;
+        }
+
+        l_rows->y0 = l_new_y0;
+        l_rows->y1 = l_new_y1;
+
+        return l_data + (OPJ_SIZE_T)(l_y0 - l_new_y0) * l_width;
+}
+
+/**
+ * Prepares the strip decoder of a tile component : lists the code-blocks of each band and
+ * allocates the rows of a strip.
+ */
+static OPJ_BOOL opj_tcd_init_strip_comp(opj_tcd_t *p_tcd,
+                                        opj_tcd_strip_comp_t * p_comp,
+                                        OPJ_UINT32 p_compno,
+                                        OPJ_UINT32 p_strip_height)
+{
+        opj_tcd_tilecomp_t * l_tilec = &(p_tcd->tcd_image->tiles->comps[p_compno]);
+        opj_image_comp_t * l_img_comp = &(p_tcd->image->comps[p_compno]);
+        opj_tcd_resolution_t * l_res;
+        OPJ_UINT32 resno, bandno, precno, cblkno;
+        OPJ_UINT64 l_rows_div;
+        OPJ_UINT64 l_nb_rows;
+
+        p_comp->tilec = l_tilec;
+        p_comp->tccp = &(p_tcd->tcp->tccps[p_compno]);
+        p_comp->t1 = opj_tcd_get_t1(p_tcd);
+        p_comp->numres = l_img_comp->resno_decoded + 1;
+        if (! p_comp->t1 || p_comp->numres > l_tilec->numresolutions) {
+                return OPJ_FALSE;
+        }
+
+        p_comp->bands = (opj_tcd_band_rows_t *) opj_calloc(p_comp->numres * 3, sizeof(opj_tcd_band_rows_t));
+        if (! p_comp->bands) {
+                return OPJ_FALSE;
+        }
+
+        for (resno = 0; resno < p_comp->numres; ++resno) {
+                l_res = &(l_tilec->resolutions[resno]);
+
+                for (bandno = 0; bandno < l_res->numbands; ++bandno) {
+                        opj_tcd_band_rows_t * l_rows = &(p_comp->bands[resno * 3 + bandno]);
+                        opj_tcd_band_t * l_band = &(l_res->bands[bandno]);
+
+                        l_rows->band = l_band;
+                        for (precno = 0; precno < l_res->pw * l_res->ph; ++precno) {
+                                l_rows->nb_cblks += l_band->precincts[precno].cw * l_band->precincts[precno].ch;
+                        }
+                        if (! l_rows->nb_cblks) {
+                                continue;
+                        }
+
+                        l_rows->cblks = (opj_tcd_cblk_dec_t **) opj_malloc(l_rows->nb_cblks * sizeof(opj_tcd_cblk_dec_t *));
+                        if (! l_rows->cblks) {
+                                return OPJ_FALSE;
+                        }
+                        l_rows->nb_cblks = 0;
+                        for (precno = 0; precno < l_res->pw * l_res->ph; ++precno) {
+                                opj_tcd_precinct_t * l_precinct = &(l_band->precincts[precno]);
+
+                                for (cblkno = 0; cblkno < l_precinct->cw * l_precinct->ch; ++cblkno) {
+                                        l_rows->cblks[l_rows->nb_cblks++] = &(l_precinct->cblks.dec[cblkno]);
+                                }
+                        }
+                        qsort(l_rows->cblks, l_rows->nb_cblks, sizeof(opj_tcd_cblk_dec_t *), opj_tcd_compare_cblks);
+                }
+        }
+
+        /* a strip covers at most ceil(strip_height / (dy * 2^level)) rows of the resolution decoded */
+        l_res = &(l_tilec->resolutions[l_img_comp->resno_decoded]);
+        l_rows_div = (OPJ_UINT64)l_img_comp->dy << (l_tilec->numresolutions - 1 - l_img_comp->resno_decoded);
+        l_nb_rows = ((OPJ_UINT64)p_strip_height + l_rows_div - 1) / l_rows_div;
+        if (l_nb_rows > (OPJ_UINT64)(l_res->y1 - l_res->y0)) {
+                l_nb_rows = (OPJ_UINT64)(l_res->y1 - l_res->y0);
+        }
+        l_nb_rows *= (OPJ_UINT32)(l_res->x1 - l_res->x0);
+        if (l_nb_rows > (OPJ_UINT64)((OPJ_SIZE_T)-1 / sizeof(OPJ_INT32))) {
+                return OPJ_FALSE;
+        }
+        p_comp->strip = (OPJ_INT32 *) opj_malloc((l_nb_rows ? (OPJ_SIZE_T)l_nb_rows : 1) * sizeof(OPJ_INT32));
+        if (! p_comp->strip) {
+                return OPJ_FALSE;
+        }
+
+        return OPJ_TRUE;
+}
+
+static void opj_tcd_free_strip_comps(opj_tcd_strip_comp_t * p_comps, OPJ_UINT32 p_nb_comps)
+{
+        OPJ_UINT32 compno, i;
+
+        if (! p_comps) {
+                return;
+        }
+
+        for (compno = 0; compno < p_nb_comps; ++compno) {
+                opj_tcd_strip_comp_t * l_comp = &(p_comps[compno]);
+
+                if (l_comp->bands) {
+                        for (i = 0; i < l_comp->numres * 3; ++i) {
+                                opj_free(l_comp->bands[i].cblks);
+                                opj_free(l_comp->bands[i].data);
+                        }
+                        opj_free(l_comp->bands);
+                }
+                opj_free(l_comp->strip);
+        }
+        opj_free(p_comps);
+}
+
+/**
+ * Decodes the strips of the tile, see opj_tcd_decode_tile_strips.
+ */
+static OPJ_BOOL opj_tcd_decode_strips(opj_tcd_t *p_tcd,
+                                      opj_tcd_strip_comp_t * p_comps,
+                                      OPJ_INT32 ** p_strips,
+                                      OPJ_UINT32 p_strip_height,
+                                      opj_decoded_strip_fn p_strip_fn,
+                                      void * p_user_data,
+                                      opj_event_mgr_t *p_manager)
+{
+        opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
+        opj_tcp_t * l_tcp = p_tcd->tcp;
+        opj_profile_stats_t * l_stats = p_comps->stats;
+        OPJ_UINT32 l_y0, l_y1, compno;
+        OPJ_FLOAT64 l_start;
+
+        for (l_y0 = (OPJ_UINT32)l_tile->y0; l_y0 < (OPJ_UINT32)l_tile->y1; l_y0 = l_y1) {
+                l_y1 = opj_uint_min(opj_uint_adds(l_y0, p_strip_height), (OPJ_UINT32)l_tile->y1);
+
+                /*----------------DWT---------------------*/
+                for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                        opj_tcd_strip_comp_t * l_comp = &(p_comps[compno]);
+                        opj_image_comp_t * l_img_comp = &(p_tcd->image->comps[compno]);
+                        opj_tcd_resolution_t * l_res;
+                        OPJ_UINT64 l_rows_div;
+
+                        if (l_tile->comps[compno].skipped) {
+                                continue;
+                        }
+
+                        l_res = &(l_comp->tilec->resolutions[l_comp->numres - 1]);
+                        l_rows_div = (OPJ_UINT64)l_img_comp->dy << (l_comp->tilec->numresolutions - l_comp->numres);
+                        l_comp->row0 = (OPJ_UINT32)(((OPJ_UINT64)l_y0 + l_rows_div - 1) / l_rows_div) - (OPJ_UINT32)l_res->y0;
+                        l_comp->row1 = (OPJ_UINT32)(((OPJ_UINT64)l_y1 + l_rows_div - 1) / l_rows_div) - (OPJ_UINT32)l_res->y0;
+
+                        if (l_comp->row1 == l_comp->row0 || l_res->x1 == l_res->x0) {
+                                continue;
+                        }
+
+                        l_comp->t1_time = 0;
+                        l_start = opj_profile_start(l_stats);
+                        if (! opj_dwt_decode_rows(l_comp->tilec, l_comp->numres, l_comp->tccp->qmfbid != 1,
+                                                  l_comp->row0, l_comp->row1, l_comp->strip,
+                                                  opj_tcd_get_band_rows, l_comp)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Failed to decode the rows %d to %d of component %d\n", l_comp->row0, l_comp->row1 - 1, compno);
+                                return OPJ_FALSE;
+                        }
+                        opj_profile_stop(l_stats, OPJ_PROFILE_DWT, l_start + l_comp->t1_time);
+                }
+
+                /*----------------MCT-------------------*/
+                if (l_tcp->mct && ! l_tile->comps[0].skipped) {
+                        OPJ_UINT32 l_rw = (OPJ_UINT32)(p_comps[0].tilec->resolutions[p_comps[0].numres - 1].x1 - p_comps[0].tilec->resolutions[p_comps[0].numres - 1].x0);
+
+                        if (l_tile->numcomps < 3) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Number of components (%d) is inconsistent with a MCT. Skip the MCT step.\n",l_tile->numcomps);
+                        }
+                        else {
+                                for (compno = 1; compno < ((l_tcp->mct == 2) ? l_tile->numcomps : 3); ++compno) {
+                                        opj_tcd_resolution_t * l_res = &(p_comps[compno].tilec->resolutions[p_comps[compno].numres - 1]);
+
+                                        if ((OPJ_UINT32)(l_res->x1 - l_res->x0) != l_rw ||
+                                            p_comps[compno].row1 - p_comps[compno].row0 != p_comps[0].row1 - p_comps[0].row0) {
+                                                opj_event_msg(p_manager, EVT_ERROR, "Tiles don't all have the same dimension. Skip the MCT step.\n");
+                                                return OPJ_FALSE;
+                                        }
+                                }
+
+                                l_start = opj_profile_start(l_stats);
+                                if (! opj_tcd_mct_decode_data(p_tcd, p_strips, (OPJ_SIZE_T)l_rw * (p_comps[0].row1 - p_comps[0].row0))) {
+                                        return OPJ_FALSE;
+                                }
+                                opj_profile_stop(l_stats, OPJ_PROFILE_MCT, l_start);
+                        }
+                }
+
+                for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                        opj_tcd_strip_comp_t * l_comp = &(p_comps[compno]);
+                        opj_tcd_resolution_t * l_res;
+                        OPJ_UINT32 l_rw;
+
+                        /* the components only decoded for the MCT are not output */
+                        if (l_comp->row1 == l_comp->row0 ||
+                            (p_tcd->m_used_comps && ! p_tcd->m_used_comps[compno])) {
+                                continue;
+                        }
+
+                        l_res = &(l_comp->tilec->resolutions[l_comp->numres - 1]);
+                        l_rw = (OPJ_UINT32)(l_res->x1 - l_res->x0);
+
+                        l_start = opj_profile_start(l_stats);
+                        opj_tcd_dc_level_shift_decode_data(l_comp->strip, l_rw, l_comp->row1 - l_comp->row0, 0,
+                                                           l_comp->tccp, &(p_tcd->image->comps[compno]));
+                        opj_profile_stop(l_stats, OPJ_PROFILE_DC_SHIFT, l_start);
+
+                        if (! p_strip_fn(compno, l_comp->row0, l_comp->row1 - l_comp->row0, l_rw, l_comp->strip, p_user_data)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "The strip of the rows %d to %d of component %d has been refused\n", l_comp->row0, l_comp->row1 - 1, compno);
+                                return OPJ_FALSE;
+                        }
+                }
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_tcd_decode_tile_strips(   opj_tcd_t *p_tcd,
+                                       OPJ_BYTE *p_src,
+                                       OPJ_SIZE_T p_max_length,
+                                       OPJ_UINT32 p_tile_no,
+                                       OPJ_UINT32 p_strip_height,
+                                       opj_decoded_strip_fn p_strip_fn,
+                                       void * p_user_data,
+                                       opj_codestream_index_t *p_cstr_index,
+                                       opj_event_mgr_t *p_manager
+                                       )
+{
+        OPJ_SIZE_T l_data_read;
+        opj_profile_stats_t * l_stats = opj_profile_get_tile(p_tcd->m_profile, p_tile_no);
+        OPJ_FLOAT64 l_start;
+        opj_tcd_tile_t * l_tile;
+        opj_tcd_strip_comp_t * l_comps;
+        OPJ_INT32 ** l_strips;
+        opj_t1_t * l_t1;
+        OPJ_UINT64 l_nb_symbols;
+        OPJ_UINT32 compno;
+        OPJ_BOOL l_result;
+
+        p_tcd->tcd_tileno = p_tile_no;
+        p_tcd->tcp = &(p_tcd->cp->tcps[p_tile_no]);
+        l_tile = p_tcd->tcd_image->tiles;
+
+        /*--------------TIER2------------------*/
+        l_start = opj_profile_start(l_stats);
+        l_data_read = 0;
+        if (! opj_tcd_t2_decode(p_tcd, p_src, &l_data_read, p_max_length, p_cstr_index, p_manager))
+        {
+                return OPJ_FALSE;
+        }
+        opj_profile_stop(l_stats, OPJ_PROFILE_T2, l_start);
+
+        if (l_stats) {
+                opj_tcd_profile_code_blocks(p_tcd, l_stats);
+        }
+
+        l_t1 = opj_tcd_get_t1(p_tcd);
+        l_comps = (opj_tcd_strip_comp_t *) opj_calloc(l_tile->numcomps, sizeof(opj_tcd_strip_comp_t));
+        l_strips = (OPJ_INT32 **) opj_calloc(l_tile->numcomps, sizeof(OPJ_INT32 *));
+        if (! l_t1 || ! l_comps || ! l_strips) {
+                opj_free(l_comps);
+                opj_free(l_strips);
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the tile by strips\n");
+                return OPJ_FALSE;
+        }
+        for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                l_comps[compno].stats = l_stats;
+                if (l_tile->comps[compno].skipped) {
+                        continue;
+                }
+                if (! opj_tcd_init_strip_comp(p_tcd, &(l_comps[compno]), compno, p_strip_height)) {
+                        opj_tcd_free_strip_comps(l_comps, l_tile->numcomps);
+                        opj_free(l_strips);
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the tile by strips\n");
+                        return OPJ_FALSE;
+                }
+                l_strips[compno] = l_comps[compno].strip;
+        }
+
+        /*------------TIER1, DWT, MCT----------------*/
+        l_nb_symbols = opj_mqc_get_nb_symbols(l_t1->mqc);
+        l_result = opj_tcd_decode_strips(p_tcd, l_comps, l_strips, p_strip_height, p_strip_fn, p_user_data, p_manager);
+        if (l_stats) {
+                l_stats->nb_mq_symbols += opj_mqc_get_nb_symbols(l_t1->mqc) - l_nb_symbols;
+        }
+
+        opj_tcd_free_strip_comps(l_comps, l_tile->numcomps);
+        opj_free(l_strips);
+        return l_result;
+}
+
+OPJ_BOOL opj_tcd_feed_tile(     opj_tcd_t *p_tcd,
+                                OPJ_UINT32 p_tile_no,
+                                const OPJ_BYTE *p_src,
+                                OPJ_UINT32 p_len,
+                                OPJ_BOOL p_last,
+                                opj_event_mgr_t *p_manager)
+{
+        opj_tcd_incr_tile_t * l_incr;
+
+        if (! p_tcd->m_incr_tiles) {
+                p_tcd->m_incr_tiles = (opj_tcd_incr_tile_t *) opj_calloc(p_tcd->cp->tw * p_tcd->cp->th, sizeof(opj_tcd_incr_tile_t));
+                if (! p_tcd->m_incr_tiles) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode the tiles incrementally\n");
+                        return OPJ_FALSE;
+                }
+                p_tcd->m_nb_incr_tiles = p_tcd->cp->tw * p_tcd->cp->th;
+        }
+        l_incr = p_tcd->m_incr_tiles + p_tile_no;
+
+        /* all the packets have been read already */
+        if (l_incr->done) {
+                return OPJ_TRUE;
+        }
+
+        if (p_len > l_incr->data_max_size - l_incr->data_size) {
+                OPJ_SIZE_T l_max_size = opj_size_adds(l_incr->data_size, p_len);
+
+                if (l_max_size < 2 * l_incr->data_max_size && l_incr->data_max_size <= (OPJ_SIZE_T)-1 / 2) {
+                        l_max_size = 2 * l_incr->data_max_size;
+                }
+                OPJ_BYTE * l_new_data = (OPJ_BYTE *) opj_realloc(l_incr->data, l_max_size);
+                if (! l_new_data) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to keep the data of tile %d\n", p_tile_no + 1);
+                        return OPJ_FALSE;
+                }
+                l_incr->data = l_new_data;
+                l_incr->data_max_size = l_max_size;
+        }
+        if (p_len) {
+                memcpy(l_incr->data + l_incr->data_size, p_src, p_len);
+                l_incr->data_size += p_len;
+                l_incr->fed = 1;
+        }
+        if (p_last) {
+                l_incr->final = 1;
+                l_incr->fed = 1;
+        }
+
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_tcd_decode_tile_incremental(       opj_tcd_t *p_tcd,
+                                                OPJ_UINT32 p_tile_no,
+                                                OPJ_BOOL * p_modified,
+                                                opj_event_mgr_t *p_manager)
+{
+        opj_tcd_incr_tile_t * l_incr = p_tcd->m_incr_tiles + p_tile_no;
+        opj_tcd_tile_t * l_tile;
+        opj_tcd_tilecomp_t * l_tilec;
+        opj_tccp_t * l_tccp;
+        opj_t1_t * l_t1;
+        OPJ_UINT32 compno;
+        OPJ_UINT32 l_nb_decoded = 0;
+
+        *p_modified = OPJ_FALSE;
+
+        p_tcd->tcd_tileno = p_tile_no;
+        p_tcd->tcp = &(p_tcd->cp->tcps[p_tile_no]);
+        p_tcd->m_saved_tile = p_tcd->tcd_image->tiles;
+
+        if (! l_incr->tile) {
+                l_tile = (opj_tcd_tile_t *) opj_calloc(1, sizeof(opj_tcd_tile_t));
+                if (l_tile) {
+                        l_tile->comps = (opj_tcd_tilecomp_t *) opj_calloc(p_tcd->image->numcomps, sizeof(opj_tcd_tilecomp_t));
+                        if (! l_tile->comps) {
+                                opj_free(l_tile);
+                                l_tile = 00;
+                        }
+                }
+                if (! l_tile) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile %d\n", p_tile_no + 1);
+                        return OPJ_FALSE;
+                }
+                l_tile->numcomps = p_tcd->image->numcomps;
+                l_incr->tile = l_tile;
+                p_tcd->tcd_image->tiles = l_tile;
+
+                if (! opj_tcd_init_decode_tile(p_tcd, p_tile_no, p_manager)) {
+                        return OPJ_FALSE;
+                }
+
+                /* the coefficients start at zero, those of each code-block are replaced when it is decoded again */
+                for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                        l_tilec = l_tile->comps + compno;
+                        if (l_tilec->skipped) {
+                                continue;
+                        }
+                        l_tilec->m_coeffs = (OPJ_INT32 *) opj_calloc(1, l_tilec->data_size_needed);
+                        if (! l_tilec->m_coeffs) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to decode tile %d\n", p_tile_no + 1);
+                                return OPJ_FALSE;
+                        }
+                }
+        }
+        l_tile = l_incr->tile;
+        p_tcd->tcd_image->tiles = l_tile;
+        l_incr->fed = 0;
+
+        /*--------------TIER2------------------*/
+        if (! l_incr->done) {
+                OPJ_SIZE_T l_data_read = 0;
+                opj_t2_t * l_t2 = opj_t2_create(p_tcd->image, p_tcd->cp);
+                OPJ_BOOL l_result;
+
+                if (l_t2 == 00) {
+                        return OPJ_FALSE;
+                }
+                l_result = opj_t2_decode_packets_incremental(l_t2, p_tile_no, l_tile, l_incr, &l_data_read, p_manager);
+                opj_t2_destroy(l_t2);
+                if (! l_result) {
+                        return OPJ_FALSE;
+                }
+
+                /* the code-blocks keep a copy of the data of the packets read */
+                memmove(l_incr->data, l_incr->data + l_data_read, l_incr->data_size - l_data_read);
+                l_incr->data_size -= l_data_read;
+        }
+
+        /*------------------TIER1-----------------*/
+        l_t1 = opj_tcd_get_t1(p_tcd);
+        if (l_t1 == 00) {
+                return OPJ_FALSE;
+        }
+        l_tilec = l_tile->comps;
+        l_tccp = p_tcd->tcp->tccps;
+        for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                if (! l_tilec->skipped && ! opj_t1_decode_modified_cblks(l_t1, l_tilec, l_tccp, l_tilec->m_coeffs, &l_nb_decoded)) {
+                        return OPJ_FALSE;
+                }
+                ++l_tilec;
+                ++l_tccp;
+        }
+
+        if (! l_nb_decoded) {
+                return OPJ_TRUE;
+        }
+
+        /*----------------DWT, MCT, DC SHIFT---------------------*/
+        /* the transforms work in place: start again from the coefficients, at the full resolution
+           requested even if some of its packets are still missing */
+        l_tilec = l_tile->comps;
+        for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                if (! l_tilec->skipped) {
+                        memcpy(l_tilec->data, l_tilec->m_coeffs, l_tilec->data_size_needed);
+                }
+                p_tcd->image->comps[compno].resno_decoded = l_tilec->minimum_num_resolutions - 1;
+                ++l_tilec;
+        }
+
+        if (! opj_tcd_dwt_decode(p_tcd) ||
+            ! opj_tcd_mct_decode(p_tcd, p_manager) ||
+            ! opj_tcd_dc_level_shift_decode(p_tcd)) {
+                return OPJ_FALSE;
+        }
+
+        *p_modified = OPJ_TRUE;
+        return OPJ_TRUE;
+}
+
+void opj_tcd_end_tile_incremental(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no)
+{
+        opj_tcd_incr_tile_t * l_incr = p_tcd->m_incr_tiles + p_tile_no;
+
+        p_tcd->tcd_image->tiles = p_tcd->m_saved_tile;
+        p_tcd->m_saved_tile = 00;
+
+        if (l_incr->done) {
+                opj_tcd_free_incremental_tile(p_tcd, l_incr);
+                /* keep it done, for the data which may still arrive */
+                l_incr->done = 1;
+        }
+}
+
+void opj_tcd_free_incremental_tiles(opj_tcd_t *p_tcd)
+{
+        OPJ_UINT32 tileno;
+
+        if (! p_tcd->m_incr_tiles) {
+                return;
+        }
+
+        for (tileno = 0; tileno < p_tcd->m_nb_incr_tiles; ++tileno) {
+                opj_tcd_free_incremental_tile(p_tcd, p_tcd->m_incr_tiles + tileno);
+        }
+        opj_free(p_tcd->m_incr_tiles);
+        p_tcd->m_incr_tiles = 00;
+        p_tcd->m_nb_incr_tiles = 0;
+}
+
+static OPJ_BOOL opj_tcd_get_nb_packets(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no, OPJ_UINT32 *p_nb_packets, opj_event_mgr_t *p_manager)
+{
+        opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
+        OPJ_UINT32 compno, resno;
+        OPJ_UINT32 l_nb_layers = p_tcd->cp->tcps[p_tile_no].numlayers;
+        OPJ_UINT32 l_nb_packets = 0;
+
+        for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                opj_tcd_tilecomp_t * l_tilec = &l_tile->comps[compno];
+
+                for (resno = 0; resno < l_tilec->numresolutions; ++resno) {
+                        OPJ_UINT32 l_nb_precincts = l_tilec->resolutions[resno].pw * l_tilec->resolutions[resno].ph;
+
+                        if (l_nb_precincts && (l_nb_layers > (OPJ_UINT32)-1 / l_nb_precincts || l_nb_precincts * l_nb_layers > (OPJ_UINT32)-1 - l_nb_packets)) {
+                                opj_event_msg(p_manager, EVT_ERROR, "Too many packets in tile %d\n", p_tile_no);
+                                return OPJ_FALSE;
+                        }
+                        l_nb_packets += l_nb_precincts * l_nb_layers;
+                }
+        }
+        *p_nb_packets = l_nb_packets;
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_tcd_record_packet_lengths(opj_tcd_t *p_tcd, OPJ_UINT32 p_tile_no, opj_event_mgr_t *p_manager)
+{
+        opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
+        OPJ_UINT32 l_nb_packets;
+
+        if (! opj_tcd_get_nb_packets(p_tcd, p_tile_no, &l_nb_packets, p_manager)) {
+                return OPJ_FALSE;
+        }
+
+        /* with tile-parts, the packet iterator goes through as many precincts in each resolution as in the largest one */
+        if (p_tcd->cp->m_specific_param.m_enc.m_tp_on) {
+                OPJ_UINT64 l_max_packets;
+                OPJ_UINT32 l_max_prec = 0, l_nb_res = 0;
+                OPJ_UINT32 compno, resno;
+
+                for (compno = 0; compno < l_tile->numcomps; ++compno) {
+                        opj_tcd_tilecomp_t * l_tilec = &l_tile->comps[compno];
+
+                        for (resno = 0; resno < l_tilec->numresolutions; ++resno) {
+                                l_max_prec = opj_uint_max(l_max_prec, l_tilec->resolutions[resno].pw * l_tilec->resolutions[resno].ph);
+                        }
+                        l_nb_res += l_tilec->numresolutions;
+                }
+                l_max_packets = (OPJ_UINT64)l_max_prec * l_nb_res * p_tcd->cp->tcps[p_tile_no].numlayers;
+                if (l_max_packets > (OPJ_UINT32)-1) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Too many packets in tile %d\n", p_tile_no);
+                        return OPJ_FALSE;
+                }
+                l_nb_packets = opj_uint_max(l_nb_packets, (OPJ_UINT32)l_max_packets);
+        }
+
+        if (l_nb_packets > l_tile->nb_packets || ! l_tile->packet_lengths) {
+                OPJ_UINT32 * l_new_lengths = (OPJ_UINT32 *) opj_realloc(l_tile->packet_lengths, opj_uint_max(l_nb_packets, 1) * sizeof(OPJ_UINT32));
+                if (! l_new_lengths) {
+                        opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to record the packet lengths of tile %d\n", p_tile_no);
+                        return OPJ_FALSE;
+                }
+                l_tile->packet_lengths = l_new_lengths;
+        }
+        l_tile->nb_packets = l_nb_packets;
+        return OPJ_TRUE;
+}
+
+OPJ_BOOL opj_tcd_locate_packets( opj_tcd_t *p_tcd,
+                                 OPJ_UINT32 p_tile_no,
+                                 OPJ_BYTE *p_src,
+                                 OPJ_UINT32 p_len,
+                                 opj_t2_packet_t **p_packets,
+                                 OPJ_UINT32 *p_nb_packets,
+                                 opj_event_mgr_t *p_manager)
+{
+        opj_tcd_tile_t * l_tile;
+        opj_t2_t * l_t2;
+        OPJ_UINT32 l_max_packets = 0;
+        OPJ_UINT32 l_strip_decode = p_tcd->m_strip_decode;
+        OPJ_BOOL l_result;
+
+        *p_packets = 00;
+        *p_nb_packets = 0;
+
+        /* the code-blocks are not decoded: no buffer for the samples */
+        p_tcd->m_strip_decode = 1;
+        l_result = opj_tcd_init_decode_tile(p_tcd, p_tile_no, p_manager);
+        p_tcd->m_strip_decode = (l_strip_decode != 0);
+        if (! l_result) {
+                return OPJ_FALSE;
+        }
+        p_tcd->tcd_tileno = p_tile_no;
+        p_tcd->tcp = &(p_tcd->cp->tcps[p_tile_no]);
+
+        l_tile = p_tcd->tcd_image->tiles;
+        if (! opj_tcd_get_nb_packets(p_tcd, p_tile_no, &l_max_packets, p_manager)) {
+                return OPJ_FALSE;
+        }
+        if (! l_max_packets) {
+                return OPJ_TRUE;
+        }
+
+        *p_packets = (opj_t2_packet_t *) opj_malloc(l_max_packets * sizeof(opj_t2_packet_t));
+        if (! *p_packets) {
+                opj_event_msg(p_manager, EVT_ERROR, "Not enough memory to locate the packets of tile %d\n", p_tile_no);
+                return OPJ_FALSE;
+        }
+
+        l_t2 = opj_t2_create(p_tcd->image, p_tcd->cp);
+        if (l_t2 == 00) {
+                opj_free(*p_packets);
+                *p_packets = 00;
+                return OPJ_FALSE;
+        }
+
+        l_result = opj_t2_locate_packets(l_t2, p_tile_no, l_tile, p_src, p_len, *p_packets, l_max_packets, p_nb_packets, p_manager);
+        opj_t2_destroy(l_t2);
+
+        if (! l_result) {
+                opj_free(*p_packets);
+                *p_packets = 00;
+                *p_nb_packets = 0;
+        }
+        return l_result;
+}
+
+static void opj_tcd_free_incremental_tile(opj_tcd_t *p_tcd, opj_tcd_incr_tile_t * p_incr)
+{
+        if (p_incr->tile) {
+                opj_tcd_tile_t * l_saved_tile = p_tcd->tcd_image->tiles;
+
+                p_tcd->tcd_image->tiles = p_incr->tile;
+                opj_tcd_free_tile(p_tcd);
+                p_tcd->tcd_image->tiles = l_saved_tile;
+        }
+        opj_free(p_incr->data);
+        opj_free(p_incr->saved);
+        memset(p_incr, 0, sizeof(opj_tcd_incr_tile_t));
+}
+
 OPJ_BOOL opj_tcd_update_tile_data ( opj_tcd_t *p_tcd,
                                     OPJ_BYTE * p_dest,
-                                    OPJ_UINT32 p_dest_length
+                                    OPJ_SIZE_T p_dest_length
                                     )
 {
-        OPJ_UINT32 i,j,k,l_data_size = 0;
+        OPJ_UINT32 i,j,k;
+        OPJ_SIZE_T l_data_size;
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_tilecomp_t * l_tilec = 00;
         opj_tcd_resolution_t * l_res;
@@ -1360,6 +2316,12 @@ OPJ_BOOL opj_tcd_update_tile_data ( opj_tcd_t *p_tcd,
         l_img_comp = p_tcd->image->comps;
 
         for (i=0;i<p_tcd->image->numcomps;++i) {
+                if (p_tcd->m_used_comps && ! p_tcd->m_used_comps[i]) {
+                        ++l_img_comp;
+                        ++l_tilec;
+                        continue;
+                }
+
                 l_size_comp = l_img_comp->prec >> 3; /*(/ 8)*/
                 l_remaining = l_img_comp->prec & 7;  /* (%8) */
                 l_res = l_tilec->resolutions + l_img_comp->resno_decoded;
@@ -1520,6 +2482,9 @@ static void opj_tcd_free_tile(opj_tcd_t *p_tcd)
                         l_tile_comp->resolutions = 00;
                 }
 
+                opj_free(l_tile_comp->m_coeffs);
+                l_tile_comp->m_coeffs = 00;
+
                 if (l_tile_comp->ownsData && l_tile_comp->data) {
                         opj_free(l_tile_comp->data);
                         l_tile_comp->data = 00;
@@ -1532,6 +2497,10 @@ static void opj_tcd_free_tile(opj_tcd_t *p_tcd)
 
         opj_free(l_tile->comps);
         l_tile->comps = 00;
+        opj_free(l_tile->packet_lengths);
+        l_tile->packet_lengths = 00;
+        opj_free(l_tile->order);
+        l_tile->order = 00;
         opj_free(p_tcd->tcd_image->tiles);
         p_tcd->tcd_image->tiles = 00;
 }
@@ -1539,8 +2508,8 @@ static void opj_tcd_free_tile(opj_tcd_t *p_tcd)
 
 static OPJ_BOOL opj_tcd_t2_decode (opj_tcd_t *p_tcd,
                             OPJ_BYTE * p_src_data,
-                            OPJ_UINT32 * p_data_read,
-                            OPJ_UINT32 p_max_src_size,
+                            OPJ_SIZE_T * p_data_read,
+                            OPJ_SIZE_T p_max_src_size,
                             opj_codestream_index_t *p_cstr_index,
                             opj_event_mgr_t *p_manager
                             )
@@ -1571,31 +2540,42 @@ static OPJ_BOOL opj_tcd_t2_decode (opj_tcd_t *p_tcd,
         return OPJ_TRUE;
 }
 
-static OPJ_BOOL opj_tcd_t1_decode ( opj_tcd_t *p_tcd )
+static opj_t1_t * opj_tcd_get_t1 ( opj_tcd_t *p_tcd )
+{
+        if (! p_tcd->m_t1) {
+                p_tcd->m_t1 = opj_t1_create(p_tcd->m_is_decoder ? OPJ_FALSE : OPJ_TRUE);
+        }
+        return p_tcd->m_t1;
+}
+
+static OPJ_BOOL opj_tcd_t1_decode ( opj_tcd_t *p_tcd, opj_profile_stats_t * p_stats )
 {
         OPJ_UINT32 compno;
+        OPJ_UINT64 l_nb_symbols;
         opj_t1_t * l_t1;
         opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
         opj_tcd_tilecomp_t* l_tile_comp = l_tile->comps;
         opj_tccp_t * l_tccp = p_tcd->tcp->tccps;
 
 
-        l_t1 = opj_t1_create(OPJ_FALSE);
+        l_t1 = opj_tcd_get_t1(p_tcd);
         if (l_t1 == 00) {
                 return OPJ_FALSE;
         }
+        l_nb_symbols = opj_mqc_get_nb_symbols(l_t1->mqc);
 
         for (compno = 0; compno < l_tile->numcomps; ++compno) {
                 /* The +3 is headroom required by the vectorized DWT */
-                if (OPJ_FALSE == opj_t1_decode_cblks(l_t1, l_tile_comp, l_tccp)) {
-                        opj_t1_destroy(l_t1);
+                if (! l_tile_comp->skipped && OPJ_FALSE == opj_t1_decode_cblks(l_t1, l_tile_comp, l_tccp)) {
                         return OPJ_FALSE;
                 }
                 ++l_tile_comp;
                 ++l_tccp;
         }
 
-        opj_t1_destroy(l_t1);
+        if (p_stats) {
+                p_stats->nb_mq_symbols += opj_mqc_get_nb_symbols(l_t1->mqc) - l_nb_symbols;
+        }
 
         return OPJ_TRUE;
 }
@@ -1623,7 +2603,10 @@ static OPJ_BOOL opj_tcd_dwt_decode ( opj_tcd_t *p_tcd )
                 if(numres2decode > 0){
                 */
 
-                if (l_tccp->qmfbid == 1) {
+                if (l_tile_comp->skipped) {
+                        /* nothing to transform */
+                }
+                else if (l_tccp->qmfbid == 1) {
                         if (! opj_dwt_decode(l_tile_comp, l_img_comp->resno_decoded+1)) {
                                 return OPJ_FALSE;
                         }
@@ -1646,72 +2629,80 @@ static OPJ_BOOL opj_tcd_mct_decode ( opj_tcd_t *p_tcd, opj_event_mgr_t *p_manage
         opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
         opj_tcp_t * l_tcp = p_tcd->tcp;
         opj_tcd_tilecomp_t * l_tile_comp = l_tile->comps;
-        OPJ_UINT32 l_samples,i;
+        OPJ_SIZE_T l_samples;
+        OPJ_UINT32 i;
+        OPJ_INT32 ** l_data;
+        OPJ_BOOL l_result;
 
-        if (! l_tcp->mct) {
+        /* the components of the transform are all decoded or all skipped */
+        if (! l_tcp->mct || l_tile_comp->skipped) {
                 return OPJ_TRUE;
         }
 
-        l_samples = (OPJ_UINT32)((l_tile_comp->x1 - l_tile_comp->x0) * (l_tile_comp->y1 - l_tile_comp->y0));
+        l_samples = (OPJ_SIZE_T)(OPJ_UINT32)(l_tile_comp->x1 - l_tile_comp->x0) * (OPJ_UINT32)(l_tile_comp->y1 - l_tile_comp->y0);
 
         if (l_tile->numcomps >= 3 ){
                 /* testcase 1336.pdf.asan.47.376 */
-                if ((l_tile->comps[0].x1 - l_tile->comps[0].x0) * (l_tile->comps[0].y1 - l_tile->comps[0].y0) < (OPJ_INT32)l_samples ||
-                    (l_tile->comps[1].x1 - l_tile->comps[1].x0) * (l_tile->comps[1].y1 - l_tile->comps[1].y0) < (OPJ_INT32)l_samples ||
-                    (l_tile->comps[2].x1 - l_tile->comps[2].x0) * (l_tile->comps[2].y1 - l_tile->comps[2].y0) < (OPJ_INT32)l_samples) {
+                if ((OPJ_SIZE_T)(OPJ_UINT32)(l_tile->comps[0].x1 - l_tile->comps[0].x0) * (OPJ_UINT32)(l_tile->comps[0].y1 - l_tile->comps[0].y0) < l_samples ||
+                    (OPJ_SIZE_T)(OPJ_UINT32)(l_tile->comps[1].x1 - l_tile->comps[1].x0) * (OPJ_UINT32)(l_tile->comps[1].y1 - l_tile->comps[1].y0) < l_samples ||
+                    (OPJ_SIZE_T)(OPJ_UINT32)(l_tile->comps[2].x1 - l_tile->comps[2].x0) * (OPJ_UINT32)(l_tile->comps[2].y1 - l_tile->comps[2].y0) < l_samples) {
                         opj_event_msg(p_manager, EVT_ERROR, "Tiles don't all have the same dimension. Skip the MCT step.\n");
                         return OPJ_FALSE;
                 }
-                else if (l_tcp->mct == 2) {
-                        OPJ_BYTE ** l_data;
 
-                        if (! l_tcp->m_mct_decoding_matrix) {
-                                return OPJ_TRUE;
-                        }
+                l_data = (OPJ_INT32 **) opj_malloc(l_tile->numcomps*sizeof(OPJ_INT32*));
+                if (! l_data) {
+                        return OPJ_FALSE;
+                }
 
-                        l_data = (OPJ_BYTE **) opj_malloc(l_tile->numcomps*sizeof(OPJ_BYTE*));
-                        if (! l_data) {
-                                return OPJ_FALSE;
-                        }
+                for (i=0;i<l_tile->numcomps;++i) {
+                        l_data[i] = l_tile_comp->data;
+                        ++l_tile_comp;
+                }
 
-                        for (i=0;i<l_tile->numcomps;++i) {
-                                l_data[i] = (OPJ_BYTE*) l_tile_comp->data;
-                                ++l_tile_comp;
-                        }
+                l_result = opj_tcd_mct_decode_data(p_tcd, l_data, l_samples);
+                opj_free(l_data);
+                return l_result;
+        }
+        else {
+                opj_event_msg(p_manager, EVT_ERROR, "Number of components (%d) is inconsistent with a MCT. Skip the MCT step.\n",l_tile->numcomps);
+        }
 
-                        if (! opj_mct_decode_custom(/* MCT data */
-                                                                        (OPJ_BYTE*) l_tcp->m_mct_decoding_matrix,
-                                                                        /* size of components */
-                                                                        l_samples,
-                                                                        /* components */
-                                                                        l_data,
-                                                                        /* nb of components (i.e. size of pData) */
-                                                                        l_tile->numcomps,
-                                                                        /* tells if the data is signed */
-                                                                        p_tcd->image->comps->sgnd)) {
-                                opj_free(l_data);
-                                return OPJ_FALSE;
-                        }
+        return OPJ_TRUE;
+}
 
-                        opj_free(l_data);
-                }
-                else {
-                        if (l_tcp->tccps->qmfbid == 1) {
-                                opj_mct_decode(     l_tile->comps[0].data,
-                                                        l_tile->comps[1].data,
-                                                        l_tile->comps[2].data,
-                                                        l_samples);
-                        }
-                        else {
-                            opj_mct_decode_real((OPJ_FLOAT32*)l_tile->comps[0].data,
-                                                (OPJ_FLOAT32*)l_tile->comps[1].data,
-                                                (OPJ_FLOAT32*)l_tile->comps[2].data,
-                                                l_samples);
-                        }
+static OPJ_BOOL opj_tcd_mct_decode_data ( opj_tcd_t *p_tcd, OPJ_INT32 ** p_data, OPJ_SIZE_T p_samples )
+{
+        opj_tcp_t * l_tcp = p_tcd->tcp;
+
+        if (l_tcp->mct == 2) {
+                if (! l_tcp->m_mct_decoding_matrix) {
+                        return OPJ_TRUE;
                 }
+
+                return opj_mct_decode_custom(/* MCT data */
+                                             (OPJ_BYTE*) l_tcp->m_mct_decoding_matrix,
+                                             /* size of components */
+                                             p_samples,
+                                             /* components */
+                                             (OPJ_BYTE**) p_data,
+                                             /* nb of components (i.e. size of pData) */
+                                             p_tcd->tcd_image->tiles->numcomps,
+                                             /* tells if the data is signed */
+                                             p_tcd->image->comps->sgnd);
+        }
+
+        if (l_tcp->tccps->qmfbid == 1) {
+                opj_mct_decode(     p_data[0],
+                                    p_data[1],
+                                    p_data[2],
+                                    p_samples);
         }
         else {
-                opj_event_msg(p_manager, EVT_ERROR, "Number of components (%d) is inconsistent with a MCT. Skip the MCT step.\n",l_tile->numcomps);
+                opj_mct_decode_real((OPJ_FLOAT32*)p_data[0],
+                                    (OPJ_FLOAT32*)p_data[1],
+                                    (OPJ_FLOAT32*)p_data[2],
+                                    p_samples);
         }
 
         return OPJ_TRUE;
@@ -1726,9 +2717,7 @@ static OPJ_BOOL opj_tcd_dc_level_shift_decode ( opj_tcd_t *p_tcd )
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_resolution_t* l_res = 00;
         opj_tcd_tile_t * l_tile;
-        OPJ_UINT32 l_width,l_height,i,j;
-        OPJ_INT32 * l_current_ptr;
-        OPJ_INT32 l_min, l_max;
+        OPJ_UINT32 l_width,l_height;
         OPJ_UINT32 l_stride;
 
         l_tile = p_tcd->tcd_image->tiles;
@@ -1737,6 +2726,13 @@ static OPJ_BOOL opj_tcd_dc_level_shift_decode ( opj_tcd_t *p_tcd )
         l_img_comp = p_tcd->image->comps;
 
         for (compno = 0; compno < l_tile->numcomps; compno++) {
+                if (l_tile_comp->skipped) {
+                        ++l_img_comp;
+                        ++l_tccp;
+                        ++l_tile_comp;
+                        continue;
+                }
+
                 l_res = l_tile_comp->resolutions + l_img_comp->resno_decoded;
                 l_width = (OPJ_UINT32)(l_res->x1 - l_res->x0);
                 l_height = (OPJ_UINT32)(l_res->y1 - l_res->y0);
@@ -1744,36 +2740,7 @@ static OPJ_BOOL opj_tcd_dc_level_shift_decode ( opj_tcd_t *p_tcd )
 
                 assert(l_height == 0 || l_width + l_stride <= l_tile_comp->data_size / l_height); /*MUPDF*/
 
-                if (l_img_comp->sgnd) {
-                        l_min = -(1 << (l_img_comp->prec - 1));
-                        l_max = (1 << (l_img_comp->prec - 1)) - 1;
-                }
-                else {
-            l_min = 0;
-                        l_max = (1 << l_img_comp->prec) - 1;
-                }
-
-                l_current_ptr = l_tile_comp->data;
-
-                if (l_tccp->qmfbid == 1) {
-                        for (j=0;j<l_height;++j) {
-                                for (i = 0; i < l_width; ++i) {
-                                        *l_current_ptr = opj_int_clamp(*l_current_ptr + l_tccp->m_dc_level_shift, l_min, l_max);
-                                        ++l_current_ptr;
-                                }
-                                l_current_ptr += l_stride;
-                        }
-                }
-                else {
-                        for (j=0;j<l_height;++j) {
-                                for (i = 0; i < l_width; ++i) {
-                                        OPJ_FLOAT32 l_value = *((OPJ_FLOAT32 *) l_current_ptr);
-                                        *l_current_ptr = opj_int_clamp((OPJ_INT32)opj_lrintf(l_value) + l_tccp->m_dc_level_shift, l_min, l_max); ;
-                                        ++l_current_ptr;
-                                }
-                                l_current_ptr += l_stride;
-                        }
-                }
+                opj_tcd_dc_level_shift_decode_data(l_tile_comp->data, l_width, l_height, l_stride, l_tccp, l_img_comp);
 
                 ++l_img_comp;
                 ++l_tccp;
@@ -1783,6 +2750,47 @@ static OPJ_BOOL opj_tcd_dc_level_shift_decode ( opj_tcd_t *p_tcd )
         return OPJ_TRUE;
 }
 
+static void opj_tcd_dc_level_shift_decode_data ( OPJ_INT32 * p_data,
+                                                 OPJ_UINT32 p_width,
+                                                 OPJ_UINT32 p_height,
+                                                 OPJ_UINT32 p_stride,
+                                                 opj_tccp_t * p_tccp,
+                                                 opj_image_comp_t * p_img_comp )
+{
+        OPJ_UINT32 i,j;
+        OPJ_INT32 * l_current_ptr = p_data;
+        OPJ_INT32 l_min, l_max;
+
+        if (p_img_comp->sgnd) {
+                l_min = -(1 << (p_img_comp->prec - 1));
+                l_max = (1 << (p_img_comp->prec - 1)) - 1;
+        }
+        else {
+                l_min = 0;
+                l_max = (1 << p_img_comp->prec) - 1;
+        }
+
+        if (p_tccp->qmfbid == 1) {
+                for (j=0;j<p_height;++j) {
+                        for (i = 0; i < p_width; ++i) {
+                                *l_current_ptr = opj_int_clamp(*l_current_ptr + p_tccp->m_dc_level_shift, l_min, l_max);
+                                ++l_current_ptr;
+                        }
+                        l_current_ptr += p_stride;
+                }
+        }
+        else {
+                for (j=0;j<p_height;++j) {
+                        for (i = 0; i < p_width; ++i) {
+                                OPJ_FLOAT32 l_value = *((OPJ_FLOAT32 *) l_current_ptr);
+                                *l_current_ptr = opj_int_clamp((OPJ_INT32)opj_lrintf(l_value) + p_tccp->m_dc_level_shift, l_min, l_max);
+                                ++l_current_ptr;
+                        }
+                        l_current_ptr += p_stride;
+                }
+        }
+}
+
 
 
 /**
@@ -1806,12 +2814,16 @@ static void opj_tcd_code_block_dec_deallocate (opj_tcd_precinct_t * p_precinct)
                 for (cblkno = 0; cblkno < l_nb_code_blocks; ++cblkno) {
 
                         if (l_code_block->data) {
-                                opj_free(l_code_block->data);
+                                if (! l_code_block->m_data_in_slab) {
+                                        opj_free(l_code_block->data);
+                                }
                                 l_code_block->data = 00;
                         }
 
                         if (l_code_block->segs) {
-                                opj_free(l_code_block->segs );
+                                if (! l_code_block->m_segs_in_slab) {
+                                        opj_free(l_code_block->segs );
+                                }
                                 l_code_block->segs = 00;
                         }
 
@@ -1834,21 +2846,14 @@ static void opj_tcd_code_block_enc_deallocate (opj_tcd_precinct_t * p_precinct)
         if (l_code_block) {
                 l_nb_code_blocks = p_precinct->block_size / sizeof(opj_tcd_cblk_enc_t);
                 
+                /* layers and passes live in the slabs of the tcd, as the data of most code-blocks */
                 for     (cblkno = 0; cblkno < l_nb_code_blocks; ++cblkno)  {
-                        if (l_code_block->data) {
+                        if (l_code_block->data && ! l_code_block->m_data_in_slab) {
                                 opj_free(l_code_block->data - 1);
-                                l_code_block->data = 00;
-                        }
-
-                        if (l_code_block->layers) {
-                                opj_free(l_code_block->layers );
-                                l_code_block->layers = 00;
-                        }
-
-                        if (l_code_block->passes) {
-                                opj_free(l_code_block->passes );
-                                l_code_block->passes = 00;
                         }
+                        l_code_block->data = 00;
+                        l_code_block->layers = 00;
+                        l_code_block->passes = 00;
                         ++l_code_block;
                 }
 
@@ -1858,9 +2863,10 @@ static void opj_tcd_code_block_enc_deallocate (opj_tcd_precinct_t * p_precinct)
         }
 }
 
-OPJ_UINT32 opj_tcd_get_encoded_tile_size ( opj_tcd_t *p_tcd )
+OPJ_SIZE_T opj_tcd_get_encoded_tile_size ( opj_tcd_t *p_tcd )
 {
-        OPJ_UINT32 i,l_data_size = 0;
+        OPJ_UINT32 i;
+        OPJ_SIZE_T l_data_size = 0;
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_tilecomp_t * l_tilec = 00;
         OPJ_UINT32 l_size_comp, l_remaining;
@@ -1879,7 +2885,7 @@ OPJ_UINT32 opj_tcd_get_encoded_tile_size ( opj_tcd_t *p_tcd )
                         l_size_comp = 4;
                 }
 
-                l_data_size += l_size_comp * (OPJ_UINT32)((l_tilec->x1 - l_tilec->x0) * (l_tilec->y1 - l_tilec->y0));
+                l_data_size = opj_size_adds(l_data_size, opj_size_muls(l_size_comp, (OPJ_SIZE_T)(OPJ_UINT32)(l_tilec->x1 - l_tilec->x0) * (OPJ_UINT32)(l_tilec->y1 - l_tilec->y0)));
                 ++l_img_comp;
                 ++l_tilec;
         }
@@ -1894,7 +2900,7 @@ static OPJ_BOOL opj_tcd_dc_level_shift_encode ( opj_tcd_t *p_tcd )
         opj_tccp_t * l_tccp = 00;
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_tile_t * l_tile;
-        OPJ_UINT32 l_nb_elem,i;
+        OPJ_SIZE_T l_nb_elem,i;
         OPJ_INT32 * l_current_ptr;
 
         l_tile = p_tcd->tcd_image->tiles;
@@ -1904,7 +2910,7 @@ static OPJ_BOOL opj_tcd_dc_level_shift_encode ( opj_tcd_t *p_tcd )
 
         for (compno = 0; compno < l_tile->numcomps; compno++) {
                 l_current_ptr = l_tile_comp->data;
-                l_nb_elem = (OPJ_UINT32)((l_tile_comp->x1 - l_tile_comp->x0) * (l_tile_comp->y1 - l_tile_comp->y0));
+                l_nb_elem = (OPJ_SIZE_T)(OPJ_UINT32)(l_tile_comp->x1 - l_tile_comp->x0) * (OPJ_UINT32)(l_tile_comp->y1 - l_tile_comp->y0);
 
                 if (l_tccp->qmfbid == 1) {
                         for     (i = 0; i < l_nb_elem; ++i) {
@@ -1931,7 +2937,7 @@ static OPJ_BOOL opj_tcd_mct_encode ( opj_tcd_t *p_tcd )
 {
         opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
         opj_tcd_tilecomp_t * l_tile_comp = p_tcd->tcd_image->tiles->comps;
-        OPJ_UINT32 samples = (OPJ_UINT32)((l_tile_comp->x1 - l_tile_comp->x0) * (l_tile_comp->y1 - l_tile_comp->y0));
+        OPJ_SIZE_T samples = (OPJ_SIZE_T)(OPJ_UINT32)(l_tile_comp->x1 - l_tile_comp->x0) * (OPJ_UINT32)(l_tile_comp->y1 - l_tile_comp->y0);
         OPJ_UINT32 i;
         OPJ_BYTE ** l_data = 00;
         opj_tcp_t * l_tcp = p_tcd->tcp;
@@ -2008,17 +3014,19 @@ static OPJ_BOOL opj_tcd_dwt_encode ( opj_tcd_t *p_tcd )
         return OPJ_TRUE;
 }
 
-static OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd )
+static OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd, opj_profile_stats_t * p_stats )
 {
+        OPJ_UINT64 l_nb_symbols;
         opj_t1_t * l_t1;
         const OPJ_FLOAT64 * l_mct_norms;
         OPJ_UINT32 l_mct_numcomps = 0U;
         opj_tcp_t * l_tcp = p_tcd->tcp;
 
-        l_t1 = opj_t1_create(OPJ_TRUE);
+        l_t1 = opj_tcd_get_t1(p_tcd);
         if (l_t1 == 00) {
                 return OPJ_FALSE;
         }
+        l_nb_symbols = opj_mqc_get_nb_symbols(l_t1->mqc);
 
         if (l_tcp->mct == 1) {
                 l_mct_numcomps = 3U;
@@ -2036,15 +3044,62 @@ static OPJ_BOOL opj_tcd_t1_encode ( opj_tcd_t *p_tcd )
         }
 
         if (! opj_t1_encode_cblks(l_t1, p_tcd->tcd_image->tiles , l_tcp, l_mct_norms, l_mct_numcomps)) {
-        opj_t1_destroy(l_t1);
                 return OPJ_FALSE;
         }
 
-        opj_t1_destroy(l_t1);
+        if (p_stats) {
+                p_stats->nb_mq_symbols += opj_mqc_get_nb_symbols(l_t1->mqc) - l_nb_symbols;
+        }
 
         return OPJ_TRUE;
 }
 
+static void opj_tcd_profile_code_blocks ( opj_tcd_t *p_tcd, opj_profile_stats_t * p_stats )
+{
+        OPJ_UINT32 compno, resno, bandno, precno, cblkno, i;
+        opj_tcd_tile_t * l_tile = p_tcd->tcd_image->tiles;
+        opj_tcd_tilecomp_t * l_tilec = l_tile->comps;
+
+        for (compno = 0; compno < l_tile->numcomps; ++compno, ++l_tilec) {
+                OPJ_UINT32 l_numres = p_tcd->m_is_decoder ? l_tilec->minimum_num_resolutions : l_tilec->numresolutions;
+
+                for (resno = 0; resno < l_numres; ++resno) {
+                        opj_tcd_resolution_t * l_res = l_tilec->resolutions + resno;
+
+                        for (bandno = 0; bandno < l_res->numbands; ++bandno) {
+                                opj_tcd_band_t * l_band = l_res->bands + bandno;
+                                opj_tcd_precinct_t * l_prc = l_band->precincts;
+
+                                for (precno = 0; precno < l_res->pw * l_res->ph; ++precno, ++l_prc) {
+                                        OPJ_UINT32 l_nb_cblks = l_prc->cw * l_prc->ch;
+
+                                        for (cblkno = 0; cblkno < l_nb_cblks; ++cblkno) {
+                                                if (p_tcd->m_is_decoder) {
+                                                        opj_tcd_cblk_dec_t * l_cblk = l_prc->cblks.dec + cblkno;
+                                                        if (l_cblk->real_num_segs == 0) {
+                                                                continue;
+                                                        }
+                                                        ++p_stats->nb_code_blocks;
+                                                        for (i = 0; i < l_cblk->real_num_segs; ++i) {
+                                                                p_stats->nb_passes += l_cblk->segs[i].real_num_passes;
+                                                                p_stats->nb_bytes_copied += l_cblk->segs[i].len;
+                                                        }
+                                                }
+                                                else {
+                                                        opj_tcd_cblk_enc_t * l_cblk = l_prc->cblks.enc + cblkno;
+                                                        ++p_stats->nb_code_blocks;
+                                                        p_stats->nb_passes += l_cblk->totalpasses;
+                                                        for (i = 0; i < p_tcd->tcp->numlayers; ++i) {
+                                                                p_stats->nb_bytes_copied += l_cblk->layers[i].len;
+                                                        }
+                                                }
+                                        }
+                                }
+                        }
+                }
+        }
+}
+
 static OPJ_BOOL opj_tcd_t2_encode (opj_tcd_t *p_tcd,
                                                 OPJ_BYTE * p_dest_data,
                                                 OPJ_UINT32 * p_data_written,
@@ -2113,13 +3168,15 @@ static OPJ_BOOL opj_tcd_rate_allocate_encode(  opj_tcd_t *p_tcd,
 
 OPJ_BOOL opj_tcd_copy_tile_data (       opj_tcd_t *p_tcd,
                                                                     OPJ_BYTE * p_src,
-                                                                    OPJ_UINT32 p_src_length )
+                                                                    OPJ_SIZE_T p_src_length )
 {
-        OPJ_UINT32 i,j,l_data_size = 0;
+        OPJ_UINT32 i;
+        OPJ_SIZE_T j;
+        OPJ_SIZE_T l_data_size;
         opj_image_comp_t * l_img_comp = 00;
         opj_tcd_tilecomp_t * l_tilec = 00;
         OPJ_UINT32 l_size_comp, l_remaining;
-        OPJ_UINT32 l_nb_elem;
+        OPJ_SIZE_T l_nb_elem;
 
         l_data_size = opj_tcd_get_encoded_tile_size(p_tcd);
         if (l_data_size != p_src_length) {
@@ -2131,7 +3188,7 @@ OPJ_BOOL opj_tcd_copy_tile_data (       opj_tcd_t *p_tcd,
         for (i=0;i<p_tcd->image->numcomps;++i) {
                 l_size_comp = l_img_comp->prec >> 3; /*(/ 8)*/
                 l_remaining = l_img_comp->prec & 7;  /* (%8) */
-                l_nb_elem = (OPJ_UINT32)((l_tilec->x1 - l_tilec->x0) * (l_tilec->y1 - l_tilec->y0));
+                l_nb_elem = (OPJ_SIZE_T)(OPJ_UINT32)(l_tilec->x1 - l_tilec->x0) * (OPJ_UINT32)(l_tilec->y1 - l_tilec->y0);
 
                 if (l_remaining) {
                         ++l_size_comp;
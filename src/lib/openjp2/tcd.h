@@ -97,6 +97,7 @@ typedef struct opj_tcd_cblk_enc {
 	OPJ_UINT32 numpasses;         /* number of pass already done for the code-blocks */
 	OPJ_UINT32 numpassesinlayers; /* number of passes in the layer */
 	OPJ_UINT32 totalpasses;	      /* total number of passes */
+	OPJ_UINT32 m_data_in_slab : 1; /* data is carved from a tcd slab and must not be freed */
 } opj_tcd_cblk_enc_t;
 
 
@@ -112,6 +113,9 @@ typedef struct opj_tcd_cblk_dec {
 	OPJ_UINT32 numsegs;				/* number of segments */
 	OPJ_UINT32 real_num_segs;
 	OPJ_UINT32 m_current_max_segs;
+	OPJ_UINT32 m_data_in_slab : 1;	/* data is carved from a tcd slab and must not be reallocated or freed */
+	OPJ_UINT32 m_segs_in_slab : 1;	/* segs is carved from a tcd slab and must not be reallocated or freed */
+	OPJ_UINT32 m_modified : 1;		/* new passes were read since the code-block was last decoded by opj_tcd_decode_tile_incremental */
 } opj_tcd_cblk_dec_t;
 
 /**
@@ -164,9 +168,11 @@ typedef struct opj_tcd_tilecomp
 	OPJ_UINT32 resolutions_size;        /* size of data for resolutions (in bytes) */
 	OPJ_INT32 *data;                    /* data of the component */
 	OPJ_BOOL  ownsData;                 /* if true, then need to free after usage, otherwise do not free */
-	OPJ_UINT32 data_size_needed;        /* we may either need to allocate this amount of data, or re-use image data and ignore this value */
-	OPJ_UINT32 data_size;               /* size of the data of the component */
-	OPJ_INT32 numpix;                   /* add fixed_quality */
+	OPJ_SIZE_T data_size_needed;        /* we may either need to allocate this amount of data, or re-use image data and ignore this value */
+	OPJ_SIZE_T data_size;               /* size of the data of the component */
+	OPJ_UINT64 numpix;                  /* add fixed_quality */
+	OPJ_BOOL  skipped;                  /* if true, the component is not decoded (see opj_tcd_t::m_used_comps) */
+	OPJ_INT32 *m_coeffs;                /* coefficients decoded so far when the tile is decoded incrementally, 00 otherwise */
 } opj_tcd_tilecomp_t;
 
 
@@ -177,10 +183,16 @@ typedef struct opj_tcd_tile {
 	OPJ_INT32 x0, y0, x1, y1;		/* dimension of the tile : left upper corner (x0, y0) right low corner (x1,y1) */
 	OPJ_UINT32 numcomps;			/* number of components in tile */
 	opj_tcd_tilecomp_t *comps;	/* Components information */
-	OPJ_INT32 numpix;				/* add fixed_quality */
+	OPJ_UINT64 numpix;				/* add fixed_quality */
 	OPJ_FLOAT64 distotile;			/* add fixed_quality */
 	OPJ_FLOAT64 distolayer[100];	/* add fixed_quality */
 	OPJ_UINT32 packno;              /* packet number */
+	OPJ_UINT32 *packet_lengths;     /* length of each packet written, by packet number, 00 if not recorded */
+	OPJ_UINT32 nb_packets;          /* largest number of packets of the tile, recorded in packet_lengths */
+	opj_pi_packet_t *order;         /* packets of the tile in the order tier-2 goes through them, kept from one tile to the next one */
+	OPJ_UINT32 order_size;          /* number of packets in order */
+	OPJ_UINT32 order_max_size;      /* number of packets order can hold */
+	OPJ_BOOL order_valid;           /* order lists the packets of the current tile, reset by the initialisation of the tile */
 } opj_tcd_tile_t;
 
 /**
@@ -193,9 +205,67 @@ typedef struct opj_tcd_image
 opj_tcd_image_t;
 
 
+/**
+Parameters of the codestream a tile decoder was created for. A decoder reset
+keeps the tile decoder for a codestream with the same ones.
+*/
+typedef struct opj_tcd_layout
+{
+	/** image area */
+	OPJ_UINT32 x0, y0, x1, y1;
+	/** tile grid */
+	OPJ_UINT32 tx0, ty0, tdx, tdy;
+	/** number of components */
+	OPJ_UINT32 numcomps;
+	/** default coding style */
+	OPJ_UINT32 csty;
+	/** largest number of resolutions and code-block size exponents of the components */
+	OPJ_UINT32 numresolutions, cblkw, cblkh;
+} opj_tcd_layout_t;
+
+/**
+State of a tile decoded incrementally, as the data of its tile-parts is received.
+The tile keeps its code-blocks, tag trees and list of packets from one feeding to the next one.
+*/
+typedef struct opj_tcd_incr_tile
+{
+	/** tile decoded, 00 until its first decoding */
+	opj_tcd_tile_t *tile;
+	/** next packet to read in the list of packets of the tile */
+	OPJ_UINT32 packetno;
+	/** data of the tile received and not yet read by tier-2 */
+	OPJ_BYTE *data;
+	OPJ_SIZE_T data_size;
+	OPJ_SIZE_T data_max_size;
+	/** state of the code-blocks and tag trees of a precinct, saved before reading one of its packets */
+	OPJ_BYTE *saved;
+	OPJ_UINT32 saved_max_size;
+	/** data was received since the last decoding */
+	OPJ_UINT32 fed : 1;
+	/** all the data of the tile has been received */
+	OPJ_UINT32 final : 1;
+	/** all the packets of the tile have been read */
+	OPJ_UINT32 done : 1;
+} opj_tcd_incr_tile_t;
+
 /**
 Tile coder/decoder
 */
+/**
+Slab of memory the code-block buffers are carved from. The slabs of a tcd
+are only released with the tcd, so that the code-block buffers keep their
+capacity from one tile to the next one.
+*/
+typedef struct opj_tcd_slab
+{
+	/** next slab of the list */
+	struct opj_tcd_slab *next;
+	/** usable size of the slab, in bytes */
+	OPJ_SIZE_T size;
+	/** number of bytes already handed out */
+	OPJ_SIZE_T used;
+} opj_tcd_slab_t;
+
 typedef struct opj_tcd
 {
 	/** Position of the tilepart flag in Progression order*/
@@ -220,8 +290,30 @@ typedef struct opj_tcd
 	OPJ_UINT32 tcd_tileno;
 	/** tell if the tcd is a decoder. */
 	OPJ_UINT32 m_is_decoder : 1;
+	/** tell if the tile is decoded strip after strip, without the data of the whole tile. */
+	OPJ_UINT32 m_strip_decode : 1;
+	/** slabs holding the code-block buffers */
+	opj_tcd_slab_t *m_slabs;
+	/** Tier-1 handle kept from one tile to the next one */
+	struct opj_t1 *m_t1;
+	/** profile of the codec, NULL when the profiling is disabled */
+	opj_profile_t *m_profile;
+	/** components to output when decoding, NULL for all of them. The components a MCT needs to
+	    rebuild them are decoded too, the others are skipped. */
+	const OPJ_BOOL *m_used_comps;
+	/** state of each tile decoded by opj_tcd_decode_tile_incremental, 00 if none */
+	opj_tcd_incr_tile_t *m_incr_tiles;
+	/** number of tiles in m_incr_tiles */
+	OPJ_UINT32 m_nb_incr_tiles;
+	/** tile of tcd_image while an incremental tile takes its place, see opj_tcd_end_tile_incremental */
+	opj_tcd_tile_t *m_saved_tile;
+	/** parameters of the codestream the decoder was created for */
+	opj_tcd_layout_t m_layout;
 } opj_tcd_t;
 
+/** position of a packet, see opj_t2_locate_packets */
+struct opj_t2_packet;
+
 /** @name Exported functions */
 /*@{*/
 /* ----------------------------------------------------------------------- */
@@ -284,9 +376,10 @@ OPJ_BOOL opj_tcd_rateallocate(	opj_tcd_t *tcd,
 								opj_codestream_info_t *cstr_info);
 
 /**
- * Gets the maximum tile size that will be taken by the tile once decoded.
+ * Gets the maximum tile size that will be taken by the tile once decoded,
+ * (OPJ_SIZE_T)-1 if it does not fit in memory.
  */
-OPJ_UINT32 opj_tcd_get_decoded_tile_size (opj_tcd_t *p_tcd );
+OPJ_SIZE_T opj_tcd_get_decoded_tile_size (opj_tcd_t *p_tcd );
 
 /**
  * Encodes a tile from the raw image into the given buffer.
@@ -317,23 +410,120 @@ Decode a tile from a buffer into a raw image
 */
 OPJ_BOOL opj_tcd_decode_tile(   opj_tcd_t *tcd,
 							    OPJ_BYTE *src,
-							    OPJ_UINT32 len,
+							    OPJ_SIZE_T len,
 							    OPJ_UINT32 tileno,
 							    opj_codestream_index_t *cstr_info,
 							    opj_event_mgr_t *manager);
 
+/**
+Decode a tile from a buffer strip after strip, giving the rows of each strip to a user function.
+Only the code-blocks the rows of a strip depend on are decoded, and the tile components
+do not hold any data, see opj_dwt_decode_rows.
+@param tcd TCD handle
+@param src Source buffer
+@param len Length of source buffer
+@param tileno Number that identifies one of the tiles to be decoded
+@param strip_height Number of rows of the reference grid of each strip
+@param strip_fn Function receiving the rows of each component of each strip
+@param user_data User data given to strip_fn
+@param cstr_info  FIXME DOC
+@param manager the event manager.
+*/
+OPJ_BOOL opj_tcd_decode_tile_strips(   opj_tcd_t *tcd,
+                                       OPJ_BYTE *src,
+                                       OPJ_SIZE_T len,
+                                       OPJ_UINT32 tileno,
+                                       OPJ_UINT32 strip_height,
+                                       opj_decoded_strip_fn strip_fn,
+                                       void * user_data,
+                                       opj_codestream_index_t *cstr_info,
+                                       opj_event_mgr_t *manager);
+
+
+/**
+Append data received for a tile decoded incrementally.
+@param tcd TCD handle
+@param tileno Number that identifies the tile
+@param src Data of a tile-part of the tile, may be 00 if len is 0
+@param len Length of src
+@param last true if src ends the last tile-part of the tile
+@param manager the event manager.
+*/
+OPJ_BOOL opj_tcd_feed_tile(     opj_tcd_t *tcd,
+                                OPJ_UINT32 tileno,
+                                const OPJ_BYTE *src,
+                                OPJ_UINT32 len,
+                                OPJ_BOOL last,
+                                opj_event_mgr_t *manager);
+
+/**
+Decode the packets of a tile received since its last decoding, then rebuild its samples if some
+code-blocks received new passes. Only these code-blocks are decoded again, the coefficients of the
+others are kept in opj_tcd_tilecomp_t::m_coeffs. The tile takes the place of the tile of the tcd
+until opj_tcd_end_tile_incremental is called, so that opj_tcd_update_tile_data can copy its samples.
+@param tcd TCD handle
+@param tileno Number that identifies the tile
+@param modified set to true if the samples of the tile changed
+@param manager the event manager.
+*/
+OPJ_BOOL opj_tcd_decode_tile_incremental(       opj_tcd_t *tcd,
+                                                OPJ_UINT32 tileno,
+                                                OPJ_BOOL * modified,
+                                                opj_event_mgr_t *manager);
+
+/**
+Give back its place to the tile of the tcd after opj_tcd_decode_tile_incremental, releasing the
+state of the incremental tile once all its packets have been read.
+@param tcd TCD handle
+@param tileno Number that identifies the tile
+*/
+void opj_tcd_end_tile_incremental(opj_tcd_t *tcd, OPJ_UINT32 tileno);
+
+/**
+Release the state of all the tiles decoded incrementally.
+@param tcd TCD handle
+*/
+void opj_tcd_free_incremental_tiles(opj_tcd_t *tcd);
+
+/**
+Record in packet_lengths the length of each packet written by the next encodings of a tile.
+nb_packets becomes the largest number of packets the encoder can write in the tile.
+@param tcd TCD handle
+@param tileno Number that identifies the tile, already initialized by opj_tcd_init_encode_tile
+@param manager the event manager.
+*/
+OPJ_BOOL opj_tcd_record_packet_lengths(opj_tcd_t *tcd, OPJ_UINT32 tileno, opj_event_mgr_t *manager);
+
+/**
+Find the packets of a tile from their headers, without decoding its code-blocks.
+@param tcd TCD handle
+@param tileno Number that identifies the tile
+@param src Data of the tile, the data of its tile-parts put end to end
+@param len Length of src
+@param packets set to the position of each packet in src, in the order of the codestream. To free with opj_free.
+@param nb_packets set to the number of packets found
+@param manager the event manager.
+*/
+OPJ_BOOL opj_tcd_locate_packets( opj_tcd_t *tcd,
+                                 OPJ_UINT32 tileno,
+                                 OPJ_BYTE *src,
+                                 OPJ_UINT32 len,
+                                 struct opj_t2_packet **packets,
+                                 OPJ_UINT32 *nb_packets,
+                                 opj_event_mgr_t *manager);
 
 /**
  * Copies tile data from the system onto the given memory block.
  */
 OPJ_BOOL opj_tcd_update_tile_data (	opj_tcd_t *p_tcd,
 								    OPJ_BYTE * p_dest,
-								    OPJ_UINT32 p_dest_length );
+								    OPJ_SIZE_T p_dest_length );
 
 /**
- *
+ * Gets the size of the samples of the tile given to the encoder,
+ * (OPJ_SIZE_T)-1 if it does not fit in memory.
  */
-OPJ_UINT32 opj_tcd_get_encoded_tile_size ( opj_tcd_t *p_tcd );
+OPJ_SIZE_T opj_tcd_get_encoded_tile_size ( opj_tcd_t *p_tcd );
 
 /**
  * Initialize the tile coder and may reuse some meory.
@@ -352,7 +542,7 @@ OPJ_BOOL opj_tcd_init_encode_tile (	opj_tcd_t *p_tcd,
  */
 OPJ_BOOL opj_tcd_copy_tile_data (opj_tcd_t *p_tcd,
                                  OPJ_BYTE * p_src,
-                                 OPJ_UINT32 p_src_length );
+                                 OPJ_SIZE_T p_src_length );
 
 /**
  * Allocates tile component data
@@ -0,0 +1,731 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Microbenchmarks of the coding kernels of the library: MQ decoder, tier-1
+ * code-block decoder, inverse wavelet transforms, inverse component
+ * transforms and tag-tree decoder are timed in isolation on deterministic
+ * inputs. The results are given per unit of work (symbol, sample, leaf) and,
+ * with -b, compared to a baseline file so that a slower kernel is reported
+ * as a failure.
+ *
+ * The SIMD paths of the kernels are selected when the library is compiled,
+ * each build of this program reports the variant it was compiled with.
+ */
+
+#include "opj_includes.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PERF_HAVE_CYCLES
+static OPJ_UINT64 perf_cycles(void) { return (OPJ_UINT64)__rdtsc(); }
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PERF_HAVE_CYCLES
+static OPJ_UINT64 perf_cycles(void) { return (OPJ_UINT64)__builtin_ia32_rdtsc(); }
+#else
+static OPJ_UINT64 perf_cycles(void) { return 0; }
+#endif
+
+/** Variant of the SIMD kernels compiled in */
+#if defined(__SSE4_1__)
+#define PERF_VARIANT_MCT_REAL	"sse4.1"
+#elif defined(__SSE__)
+#define PERF_VARIANT_MCT_REAL	"sse"
+#else
+#define PERF_VARIANT_MCT_REAL	"scalar"
+#endif
+#if defined(__SSE2__)
+#define PERF_VARIANT_MCT		"sse2"
+#else
+#define PERF_VARIANT_MCT		"scalar"
+#endif
+#if defined(__SSE__)
+#define PERF_VARIANT_DWT_REAL	"sse"
+#else
+#define PERF_VARIANT_DWT_REAL	"scalar"
+#endif
+
+#define PERF_MAX_KERNELS	16
+
+/** Measure of a kernel */
+typedef struct perf_result {
+	const char * name;
+	const char * variant;
+	const char * unit;
+	/** best time and cycles per unit over the repetitions */
+	OPJ_FLOAT64 ns;
+	OPJ_FLOAT64 cycles;
+} perf_result_t;
+
+/** State of a kernel benchmark */
+typedef struct perf_kernel {
+	const char * name;
+	const char * variant;
+	const char * unit;
+	/** prepares the input, returns the number of units processed by a run */
+	OPJ_UINT64 (*setup)(void * p_data);
+	/** processes the input once */
+	OPJ_BOOL (*run)(void * p_data);
+	void (*cleanup)(void * p_data);
+} perf_kernel_t;
+
+static OPJ_UINT32 perf_seed;
+
+static OPJ_UINT32 perf_rand(void)
+{
+	perf_seed = perf_seed * 1664525U + 1013904223U;
+	return perf_seed >> 8;
+}
+
+/* -------------------------------------------------------------------------- */
+/* MQ decoder                                                                 */
+
+#define PERF_MQC_SYMBOLS	(1U << 21)
+
+typedef struct perf_mqc {
+	opj_mqc_t * mqc;
+	OPJ_BYTE * buffer;
+	OPJ_UINT32 len;
+	OPJ_BYTE * ctx;
+} perf_mqc_t;
+
+static perf_mqc_t perf_mqc_data;
+
+static OPJ_UINT64 perf_mqc_setup(void * p_data)
+{
+	perf_mqc_t * l_data = (perf_mqc_t *) p_data;
+	OPJ_UINT32 i;
+
+	l_data->mqc = opj_mqc_create();
+	l_data->buffer = (OPJ_BYTE *) opj_calloc(PERF_MQC_SYMBOLS / 2 + 16, 1);
+	l_data->ctx = (OPJ_BYTE *) opj_malloc(PERF_MQC_SYMBOLS);
+	if (! l_data->mqc || ! l_data->buffer || ! l_data->ctx) {
+		return 0;
+	}
+
+	/* symbols of varying skew in each context, like the tier-1 coder produces */
+	opj_mqc_resetstates(l_data->mqc);
+	opj_mqc_init_enc(l_data->mqc, l_data->buffer + 1);
+	for (i = 0; i < PERF_MQC_SYMBOLS; ++i) {
+		OPJ_UINT32 l_ctx = perf_rand() % MQC_NUMCTXS;
+		OPJ_UINT32 l_bias = 4 + l_ctx * 12;
+		l_data->ctx[i] = (OPJ_BYTE)l_ctx;
+		opj_mqc_setcurctx(l_data->mqc, l_ctx);
+		opj_mqc_encode(l_data->mqc, (perf_rand() & 0xff) < l_bias ? 1U : 0U);
+	}
+	opj_mqc_flush(l_data->mqc);
+	l_data->len = opj_mqc_numbytes(l_data->mqc);
+
+	return PERF_MQC_SYMBOLS;
+}
+
+static OPJ_BOOL perf_mqc_run(void * p_data)
+{
+	perf_mqc_t * l_data = (perf_mqc_t *) p_data;
+	opj_mqc_t * l_mqc = l_data->mqc;
+	OPJ_INT32 l_sum = 0;
+	OPJ_UINT32 i;
+
+	opj_mqc_resetstates(l_mqc);
+	if (! opj_mqc_init_dec(l_mqc, l_data->buffer + 1, l_data->len)) {
+		return OPJ_FALSE;
+	}
+	for (i = 0; i < PERF_MQC_SYMBOLS; ++i) {
+		opj_mqc_setcurctx(l_mqc, l_data->ctx[i]);
+		l_sum += opj_mqc_decode(l_mqc);
+	}
+	return l_sum > 0;
+}
+
+static void perf_mqc_cleanup(void * p_data)
+{
+	perf_mqc_t * l_data = (perf_mqc_t *) p_data;
+
+	opj_mqc_destroy(l_data->mqc);
+	opj_free(l_data->buffer);
+	opj_free(l_data->ctx);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Tier-1 decoder                                                             */
+
+#define PERF_T1_SIZE		256
+#define PERF_T1_CBLK		64
+#define PERF_T1_NB_CBLKS	((PERF_T1_SIZE / PERF_T1_CBLK) * (PERF_T1_SIZE / PERF_T1_CBLK))
+
+typedef struct perf_t1 {
+	opj_t1_t * t1;
+	opj_tcd_tilecomp_t tilec;
+	opj_tcd_resolution_t res;
+	opj_tcd_precinct_t prc;
+	opj_tccp_t tccp;
+	opj_tcd_cblk_dec_t cblks[PERF_T1_NB_CBLKS];
+	opj_tcd_seg_t segs[PERF_T1_NB_CBLKS];
+} perf_t1_t;
+
+static perf_t1_t perf_t1_data;
+
+/**
+ * Encodes code-blocks of synthetic wavelet coefficients with the tier-1
+ * encoder, and sets them up the way tier-2 hands them over to the decoder.
+ */
+static OPJ_UINT64 perf_t1_setup(void * p_data)
+{
+	perf_t1_t * l_data = (perf_t1_t *) p_data;
+	opj_tcd_cblk_enc_t l_enc[PERF_T1_NB_CBLKS];
+	opj_tcd_pass_t l_passes[PERF_T1_NB_CBLKS][100];
+	opj_tcd_tile_t l_tile;
+	opj_tcp_t l_tcp;
+	opj_t1_t * l_t1_enc;
+	OPJ_UINT32 i, l_nb_cblks_w = PERF_T1_SIZE / PERF_T1_CBLK;
+	OPJ_BOOL l_success;
+
+	memset(l_data, 0, sizeof(perf_t1_t));
+	memset(l_enc, 0, sizeof(l_enc));
+	memset(&l_tile, 0, sizeof(l_tile));
+	memset(&l_tcp, 0, sizeof(l_tcp));
+
+	l_data->tilec.x1 = l_data->tilec.y1 = PERF_T1_SIZE;
+	l_data->tilec.numresolutions = l_data->tilec.minimum_num_resolutions = 1;
+	l_data->tilec.resolutions = &l_data->res;
+	l_data->tilec.data = (OPJ_INT32 *) opj_malloc(PERF_T1_SIZE * PERF_T1_SIZE * sizeof(OPJ_INT32));
+	l_data->res.x1 = l_data->res.y1 = PERF_T1_SIZE;
+	l_data->res.pw = l_data->res.ph = 1;
+	l_data->res.numbands = 1;
+	l_data->res.bands[0].x1 = l_data->res.bands[0].y1 = PERF_T1_SIZE;
+	l_data->res.bands[0].stepsize = 1.0f;
+	l_data->res.bands[0].precincts = &l_data->prc;
+	l_data->prc.x1 = l_data->prc.y1 = PERF_T1_SIZE;
+	l_data->prc.cw = l_data->prc.ch = l_nb_cblks_w;
+	l_data->tccp.qmfbid = 1;
+	l_data->t1 = opj_t1_create(OPJ_FALSE);
+	l_t1_enc = opj_t1_create(OPJ_TRUE);
+	if (! l_data->tilec.data || ! l_data->t1 || ! l_t1_enc) {
+		opj_t1_destroy(l_t1_enc);
+		return 0;
+	}
+
+	/* coefficients mostly small, some large, random signs */
+	for (i = 0; i < PERF_T1_SIZE * PERF_T1_SIZE; ++i) {
+		OPJ_UINT32 l_r = perf_rand() & 0xfff;
+		OPJ_INT32 l_mag = (OPJ_INT32)(((OPJ_UINT64)l_r * l_r * l_r) >> 30);
+		l_data->tilec.data[i] = (perf_rand() & 1) ? -l_mag : l_mag;
+	}
+
+	l_data->prc.cblks.enc = l_enc;
+	for (i = 0; i < PERF_T1_NB_CBLKS; ++i) {
+		l_enc[i].x0 = (OPJ_INT32)((i % l_nb_cblks_w) * PERF_T1_CBLK);
+		l_enc[i].y0 = (OPJ_INT32)((i / l_nb_cblks_w) * PERF_T1_CBLK);
+		l_enc[i].x1 = l_enc[i].x0 + PERF_T1_CBLK;
+		l_enc[i].y1 = l_enc[i].y0 + PERF_T1_CBLK;
+		l_enc[i].passes = l_passes[i];
+		l_enc[i].data = (OPJ_BYTE *) opj_calloc(PERF_T1_CBLK * PERF_T1_CBLK * sizeof(OPJ_INT32) + 1, 1);
+		if (! l_enc[i].data) {
+			break;
+		}
+		l_enc[i].data += 1;
+	}
+	l_tile.x1 = l_tile.y1 = PERF_T1_SIZE;
+	l_tile.numcomps = 1;
+	l_tile.comps = &l_data->tilec;
+	l_tcp.tccps = &l_data->tccp;
+
+	l_success = (i == PERF_T1_NB_CBLKS) && opj_t1_encode_cblks(l_t1_enc, &l_tile, &l_tcp, 00, 0);
+	opj_t1_destroy(l_t1_enc);
+
+	/* one segment with all the passes of the code-block */
+	for (i = 0; i < PERF_T1_NB_CBLKS; ++i) {
+		opj_tcd_cblk_dec_t * l_cblk = &l_data->cblks[i];
+		OPJ_UINT32 l_len = 0;
+
+		if (! l_enc[i].data) {
+			break;
+		}
+		if (l_success) {
+			if (l_enc[i].totalpasses) {
+				l_len = l_enc[i].passes[l_enc[i].totalpasses - 1].rate;
+			}
+			l_cblk->data = (OPJ_BYTE *) opj_calloc(l_len + 2, 1);
+			if (l_cblk->data) {
+				memcpy(l_cblk->data, l_enc[i].data, l_len);
+			}
+			else {
+				l_success = OPJ_FALSE;
+			}
+			l_cblk->x0 = l_enc[i].x0;
+			l_cblk->y0 = l_enc[i].y0;
+			l_cblk->x1 = l_enc[i].x1;
+			l_cblk->y1 = l_enc[i].y1;
+			l_cblk->numbps = l_enc[i].numbps;
+			l_cblk->data_current_size = l_len;
+			l_cblk->numsegs = l_cblk->real_num_segs = 1;
+			l_cblk->segs = &l_data->segs[i];
+			l_data->segs[i].data = &l_cblk->data;
+			l_data->segs[i].len = l_len;
+			l_data->segs[i].numpasses = l_data->segs[i].real_num_passes = l_enc[i].totalpasses;
+		}
+		opj_free(l_enc[i].data - 1);
+	}
+	l_data->prc.cblks.dec = l_data->cblks;
+
+	return l_success ? PERF_T1_SIZE * PERF_T1_SIZE : 0;
+}
+
+static OPJ_BOOL perf_t1_run(void * p_data)
+{
+	perf_t1_t * l_data = (perf_t1_t *) p_data;
+
+	return opj_t1_decode_cblks(l_data->t1, &l_data->tilec, &l_data->tccp);
+}
+
+static void perf_t1_cleanup(void * p_data)
+{
+	perf_t1_t * l_data = (perf_t1_t *) p_data;
+	OPJ_UINT32 i;
+
+	for (i = 0; i < PERF_T1_NB_CBLKS; ++i) {
+		opj_free(l_data->cblks[i].data);
+	}
+	opj_free(l_data->tilec.data);
+	opj_t1_destroy(l_data->t1);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Inverse wavelet transforms                                                 */
+
+#define PERF_DWT_SIZE		1024
+#define PERF_DWT_NUMRES		6
+
+typedef struct perf_dwt {
+	opj_tcd_tilecomp_t tilec;
+	opj_tcd_resolution_t res[PERF_DWT_NUMRES];
+} perf_dwt_t;
+
+static perf_dwt_t perf_dwt_data;
+
+static OPJ_UINT64 perf_dwt_setup(void * p_data)
+{
+	perf_dwt_t * l_data = (perf_dwt_t *) p_data;
+	OPJ_UINT32 i;
+
+	memset(l_data, 0, sizeof(perf_dwt_t));
+	l_data->tilec.x1 = l_data->tilec.y1 = PERF_DWT_SIZE;
+	l_data->tilec.numresolutions = l_data->tilec.minimum_num_resolutions = PERF_DWT_NUMRES;
+	l_data->tilec.resolutions = l_data->res;
+	for (i = 0; i < PERF_DWT_NUMRES; ++i) {
+		OPJ_UINT32 l_level = PERF_DWT_NUMRES - 1 - i;
+		l_data->res[i].x1 = l_data->res[i].y1 = (OPJ_INT32)((PERF_DWT_SIZE + (1U << l_level) - 1) >> l_level);
+	}
+	l_data->tilec.data = (OPJ_INT32 *) opj_aligned_malloc(PERF_DWT_SIZE * PERF_DWT_SIZE * sizeof(OPJ_INT32));
+	if (! l_data->tilec.data) {
+		return 0;
+	}
+	return PERF_DWT_SIZE * PERF_DWT_SIZE;
+}
+
+/* the transform is run on small coefficients, refreshed before each run */
+static OPJ_BOOL perf_dwt_run(void * p_data)
+{
+	perf_dwt_t * l_data = (perf_dwt_t *) p_data;
+	return opj_dwt_decode(&l_data->tilec, PERF_DWT_NUMRES);
+}
+
+static OPJ_BOOL perf_dwt_real_run(void * p_data)
+{
+	perf_dwt_t * l_data = (perf_dwt_t *) p_data;
+	return opj_dwt_decode_real(&l_data->tilec, PERF_DWT_NUMRES);
+}
+
+static void perf_dwt_refresh(perf_dwt_t * p_data, OPJ_BOOL p_real)
+{
+	OPJ_UINT32 i;
+
+	perf_seed = 1;
+	for (i = 0; i < PERF_DWT_SIZE * PERF_DWT_SIZE; ++i) {
+		OPJ_INT32 l_value = (OPJ_INT32)(perf_rand() & 0xff) - 128;
+		if (p_real) {
+			((OPJ_FLOAT32 *) p_data->tilec.data)[i] = (OPJ_FLOAT32) l_value;
+		}
+		else {
+			p_data->tilec.data[i] = l_value;
+		}
+	}
+}
+
+static void perf_dwt_cleanup(void * p_data)
+{
+	perf_dwt_t * l_data = (perf_dwt_t *) p_data;
+	opj_aligned_free(l_data->tilec.data);
+}
+
+/* -------------------------------------------------------------------------- */
+/* Inverse component transforms                                               */
+
+#define PERF_MCT_SAMPLES	(1U << 20)
+
+typedef struct perf_mct {
+	OPJ_INT32 * c[3];
+} perf_mct_t;
+
+static perf_mct_t perf_mct_data;
+
+static OPJ_UINT64 perf_mct_setup(void * p_data)
+{
+	perf_mct_t * l_data = (perf_mct_t *) p_data;
+	OPJ_UINT32 i;
+
+	for (i = 0; i < 3; ++i) {
+		l_data->c[i] = (OPJ_INT32 *) opj_aligned_malloc(PERF_MCT_SAMPLES * sizeof(OPJ_INT32));
+		if (! l_data->c[i]) {
+			return 0;
+		}
+		memset(l_data->c[i], 0, PERF_MCT_SAMPLES * sizeof(OPJ_INT32));
+	}
+	return PERF_MCT_SAMPLES;
+}
+
+static OPJ_BOOL perf_mct_run(void * p_data)
+{
+	perf_mct_t * l_data = (perf_mct_t *) p_data;
+	opj_mct_decode(l_data->c[0], l_data->c[1], l_data->c[2], PERF_MCT_SAMPLES);
+	return OPJ_TRUE;
+}
+
+static OPJ_BOOL perf_mct_real_run(void * p_data)
+{
+	perf_mct_t * l_data = (perf_mct_t *) p_data;
+	opj_mct_decode_real((OPJ_FLOAT32 *) l_data->c[0], (OPJ_FLOAT32 *) l_data->c[1],
+	                    (OPJ_FLOAT32 *) l_data->c[2], PERF_MCT_SAMPLES);
+	return OPJ_TRUE;
+}
+
+static void perf_mct_cleanup(void * p_data)
+{
+	perf_mct_t * l_data = (perf_mct_t *) p_data;
+	OPJ_UINT32 i;
+
+	for (i = 0; i < 3; ++i) {
+		opj_aligned_free(l_data->c[i]);
+		l_data->c[i] = 00;
+	}
+}
+
+/* -------------------------------------------------------------------------- */
+/* Tag-tree decoder                                                           */
+
+#define PERF_TGT_LEAFS		64
+#define PERF_TGT_LEVELS		16
+#define PERF_TGT_BUFFER		(1U << 20)
+
+typedef struct perf_tgt {
+	opj_tgt_tree_t * tree;
+	opj_bio_t * bio;
+	OPJ_BYTE * buffer;
+	OPJ_UINT32 len;
+} perf_tgt_t;
+
+static perf_tgt_t perf_tgt_data;
+
+/**
+ * Encodes the tag-tree threshold after threshold, like the inclusion tree of
+ * a precinct coded over many layers.
+ */
+static OPJ_UINT64 perf_tgt_setup(void * p_data)
+{
+	perf_tgt_t * l_data = (perf_tgt_t *) p_data;
+	opj_event_mgr_t l_manager;
+	OPJ_UINT32 l_leaf;
+	OPJ_INT32 l_threshold;
+
+	opj_set_default_event_handler(&l_manager);
+	l_data->tree = opj_tgt_create(PERF_TGT_LEAFS, PERF_TGT_LEAFS, &l_manager);
+	l_data->bio = opj_bio_create();
+	l_data->buffer = (OPJ_BYTE *) opj_malloc(PERF_TGT_BUFFER);
+	if (! l_data->tree || ! l_data->bio || ! l_data->buffer) {
+		return 0;
+	}
+
+	opj_tgt_reset(l_data->tree);
+	for (l_leaf = 0; l_leaf < PERF_TGT_LEAFS * PERF_TGT_LEAFS; ++l_leaf) {
+		opj_tgt_setvalue(l_data->tree, l_leaf, (OPJ_INT32)(perf_rand() % PERF_TGT_LEVELS));
+	}
+	opj_bio_init_enc(l_data->bio, l_data->buffer, PERF_TGT_BUFFER);
+	for (l_threshold = 1; l_threshold <= PERF_TGT_LEVELS; ++l_threshold) {
+		for (l_leaf = 0; l_leaf < PERF_TGT_LEAFS * PERF_TGT_LEAFS; ++l_leaf) {
+			opj_tgt_encode(l_data->bio, l_data->tree, l_leaf, l_threshold);
+		}
+	}
+	if (! opj_bio_flush(l_data->bio)) {
+		return 0;
+	}
+	l_data->len = (OPJ_UINT32)opj_bio_numbytes(l_data->bio);
+
+	return PERF_TGT_LEAFS * PERF_TGT_LEAFS * PERF_TGT_LEVELS;
+}
+
+static OPJ_BOOL perf_tgt_run(void * p_data)
+{
+	perf_tgt_t * l_data = (perf_tgt_t *) p_data;
+	OPJ_UINT32 l_leaf, l_sum = 0;
+	OPJ_INT32 l_threshold;
+
+	opj_tgt_reset(l_data->tree);
+	opj_bio_init_dec(l_data->bio, l_data->buffer, l_data->len);
+	for (l_threshold = 1; l_threshold <= PERF_TGT_LEVELS; ++l_threshold) {
+		for (l_leaf = 0; l_leaf < PERF_TGT_LEAFS * PERF_TGT_LEAFS; ++l_leaf) {
+			l_sum += opj_tgt_decode(l_data->bio, l_data->tree, l_leaf, l_threshold);
+		}
+	}
+	return l_sum != 0;
+}
+
+static void perf_tgt_cleanup(void * p_data)
+{
+	perf_tgt_t * l_data = (perf_tgt_t *) p_data;
+
+	opj_tgt_destroy(l_data->tree);
+	opj_bio_destroy(l_data->bio);
+	opj_free(l_data->buffer);
+}
+
+/* -------------------------------------------------------------------------- */
+
+static const perf_kernel_t perf_kernels[] = {
+	{ "mqc_decode",      "scalar",              "symbol", perf_mqc_setup, perf_mqc_run,      perf_mqc_cleanup },
+	{ "t1_decode_cblks", "scalar",              "sample", perf_t1_setup,  perf_t1_run,       perf_t1_cleanup },
+	{ "dwt_decode",      "scalar",              "sample", perf_dwt_setup, perf_dwt_run,      perf_dwt_cleanup },
+	{ "dwt_decode_real", PERF_VARIANT_DWT_REAL, "sample", perf_dwt_setup, perf_dwt_real_run, perf_dwt_cleanup },
+	{ "mct_decode",      PERF_VARIANT_MCT,      "pixel",  perf_mct_setup, perf_mct_run,      perf_mct_cleanup },
+	{ "mct_decode_real", PERF_VARIANT_MCT_REAL, "pixel",  perf_mct_setup, perf_mct_real_run, perf_mct_cleanup },
+	{ "tgt_decode",      "scalar",              "leaf",   perf_tgt_setup, perf_tgt_run,      perf_tgt_cleanup }
+};
+
+static void * perf_kernel_data(OPJ_UINT32 p_index)
+{
+	switch (p_index) {
+	case 0: return &perf_mqc_data;
+	case 1: return &perf_t1_data;
+	case 2:
+	case 3: return &perf_dwt_data;
+	case 4:
+	case 5: return &perf_mct_data;
+	default: return &perf_tgt_data;
+	}
+}
+
+static OPJ_BOOL perf_measure(OPJ_UINT32 p_index, OPJ_UINT32 p_repeat, perf_result_t * p_result)
+{
+	const perf_kernel_t * l_kernel = &perf_kernels[p_index];
+	void * l_data = perf_kernel_data(p_index);
+	OPJ_UINT64 l_units;
+	OPJ_UINT32 i;
+	OPJ_BOOL l_success = OPJ_TRUE;
+
+	perf_seed = 0x2545F491U;
+	l_units = l_kernel->setup(l_data);
+	if (! l_units) {
+		l_kernel->cleanup(l_data);
+		return OPJ_FALSE;
+	}
+
+	p_result->name = l_kernel->name;
+	p_result->variant = l_kernel->variant;
+	p_result->unit = l_kernel->unit;
+	p_result->ns = p_result->cycles = 0;
+
+	/* one untimed run to warm the caches up, then keep the best run */
+	for (i = 0; i <= p_repeat && l_success; ++i) {
+		OPJ_FLOAT64 l_time;
+		OPJ_UINT64 l_cycles;
+
+		if (l_kernel->run == perf_dwt_run || l_kernel->run == perf_dwt_real_run) {
+			perf_dwt_refresh((perf_dwt_t *) l_data, l_kernel->run == perf_dwt_real_run);
+		}
+
+		l_time = opj_clock();
+		l_cycles = perf_cycles();
+		l_success = l_kernel->run(l_data);
+		l_cycles = perf_cycles() - l_cycles;
+		l_time = opj_clock() - l_time;
+
+		if (i > 0) {
+			OPJ_FLOAT64 l_ns = l_time * 1e9 / (OPJ_FLOAT64)l_units;
+			OPJ_FLOAT64 l_cpu = (OPJ_FLOAT64)l_cycles / (OPJ_FLOAT64)l_units;
+			if (i == 1 || l_ns < p_result->ns) {
+				p_result->ns = l_ns;
+			}
+			if (i == 1 || l_cpu < p_result->cycles) {
+				p_result->cycles = l_cpu;
+			}
+		}
+	}
+
+	l_kernel->cleanup(l_data);
+	return l_success;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Looks up a kernel in the baseline file. Lines are "<kernel> <variant>
+ * <cycles per unit>", '#' starts a comment.
+ */
+static OPJ_FLOAT64 perf_baseline(FILE * p_file, const char * p_name, const char * p_variant)
+{
+	char l_line[256], l_name[64], l_variant[64];
+	double l_value;
+
+	rewind(p_file);
+	while (fgets(l_line, sizeof(l_line), p_file)) {
+		if (l_line[0] == '#') {
+			continue;
+		}
+		if (sscanf(l_line, "%63s %63s %lf", l_name, l_variant, &l_value) == 3
+			&& strcmp(l_name, p_name) == 0 && strcmp(l_variant, p_variant) == 0) {
+			return l_value;
+		}
+	}
+	return 0;
+}
+
+static void perf_help_display(void)
+{
+	fprintf(stdout, "Usage: perf_kernels [-b <baseline>] [-t <tolerance>] [-w <file>] [-r <runs>] [-q]\n"
+	                "  -b <baseline>   compare the cycles per unit of each kernel to the baseline file\n"
+	                "  -t <tolerance>  relative slowdown tolerated before failing (default 0.5)\n"
+	                "  -w <file>       write the results as a new baseline file\n"
+	                "  -r <runs>       number of timed runs of each kernel, the best is kept (default 5)\n"
+	                "  -q              quick run (one timed run, no comparison)\n");
+}
+
+int main(int argc, char **argv)
+{
+	perf_result_t l_results[PERF_MAX_KERNELS];
+	const char * l_baseline_name = 00;
+	const char * l_output_name = 00;
+	FILE * l_baseline = 00;
+	OPJ_FLOAT64 l_tolerance = 0.5;
+	OPJ_UINT32 l_repeat = 5;
+	OPJ_UINT32 l_nb_kernels = (OPJ_UINT32)(sizeof(perf_kernels) / sizeof(perf_kernels[0]));
+	OPJ_UINT32 i;
+	int l_failures = 0;
+	int l_arg;
+
+	memset(l_results, 0, sizeof(l_results));
+	for (l_arg = 1; l_arg < argc; ++l_arg) {
+		if (strcmp(argv[l_arg], "-b") == 0 && l_arg + 1 < argc) {
+			l_baseline_name = argv[++l_arg];
+		}
+		else if (strcmp(argv[l_arg], "-t") == 0 && l_arg + 1 < argc) {
+			l_tolerance = atof(argv[++l_arg]);
+		}
+		else if (strcmp(argv[l_arg], "-w") == 0 && l_arg + 1 < argc) {
+			l_output_name = argv[++l_arg];
+		}
+		else if (strcmp(argv[l_arg], "-r") == 0 && l_arg + 1 < argc) {
+			l_repeat = (OPJ_UINT32)atoi(argv[++l_arg]);
+		}
+		else if (strcmp(argv[l_arg], "-q") == 0) {
+			l_repeat = 1;
+			l_baseline_name = 00;
+		}
+		else {
+			perf_help_display();
+			return 1;
+		}
+	}
+	if (l_repeat == 0) {
+		l_repeat = 1;
+	}
+
+	if (l_baseline_name) {
+#ifdef PERF_HAVE_CYCLES
+		l_baseline = fopen(l_baseline_name, "r");
+		if (! l_baseline) {
+			fprintf(stderr, "Unable to open the baseline file %s\n", l_baseline_name);
+			return 1;
+		}
+#else
+		fprintf(stdout, "No cycle counter on this platform: the baseline is not checked\n");
+#endif
+	}
+
+	fprintf(stdout, "%-16s %-8s %-7s %12s %12s %12s %8s\n",
+	        "kernel", "variant", "unit", "ns/unit", "cycles/unit", "baseline", "ratio");
+
+	for (i = 0; i < l_nb_kernels; ++i) {
+		perf_result_t * l_result = &l_results[i];
+		OPJ_FLOAT64 l_reference = 0;
+
+		if (! perf_measure(i, l_repeat, l_result)) {
+			fprintf(stdout, "%-16s failed\n", perf_kernels[i].name);
+			++l_failures;
+			continue;
+		}
+
+		if (l_baseline) {
+			l_reference = perf_baseline(l_baseline, l_result->name, l_result->variant);
+		}
+		fprintf(stdout, "%-16s %-8s %-7s %12.3f %12.3f", l_result->name, l_result->variant,
+		        l_result->unit, l_result->ns, l_result->cycles);
+		if (l_reference > 0) {
+			OPJ_FLOAT64 l_ratio = l_result->cycles / l_reference;
+			fprintf(stdout, " %12.3f %8.2f%s\n", l_reference, l_ratio,
+			        l_ratio > 1.0 + l_tolerance ? "  SLOWER" : "");
+			if (l_ratio > 1.0 + l_tolerance) {
+				++l_failures;
+			}
+		}
+		else {
+			fprintf(stdout, " %12s %8s\n", "-", "-");
+		}
+	}
+
+	if (l_baseline) {
+		fclose(l_baseline);
+	}
+
+	if (l_output_name) {
+		FILE * l_output = fopen(l_output_name, "w");
+		if (! l_output) {
+			fprintf(stderr, "Unable to open %s for writing\n", l_output_name);
+			return 1;
+		}
+		fprintf(l_output, "# kernel variant cycles_per_unit\n");
+		for (i = 0; i < l_nb_kernels; ++i) {
+			if (l_results[i].name) {
+				fprintf(l_output, "%s %s %.3f\n", l_results[i].name, l_results[i].variant, l_results[i].cycles);
+			}
+		}
+		fclose(l_output);
+	}
+
+	return l_failures ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef TEST_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_AREAS 6
+
+/* decoding of an area by a clone, in a thread of its own when pthreads are available */
+typedef struct clone_job
+{
+	opj_codec_t * codec;
+	opj_stream_t * stream;
+	opj_image_t * image;
+	const OPJ_INT32 * area;
+	OPJ_BOOL success;
+	/* memory usage of the clone once its area is decoded */
+	OPJ_SIZE_T current;
+	OPJ_SIZE_T peak;
+#ifdef TEST_HAVE_PTHREAD
+	pthread_t thread;
+	OPJ_BOOL joinable;
+#endif
+} clone_job_t;
+
+static void * decode_clone(void * p_job)
+{
+	clone_job_t * l_job = (clone_job_t *) p_job;
+
+	l_job->success = opj_set_decode_area(l_job->codec, l_job->image, l_job->area[0], l_job->area[1], l_job->area[2], l_job->area[3]) &&
+		opj_decode(l_job->codec, l_job->stream, l_job->image) &&
+		opj_end_decompress(l_job->codec, l_job->stream) &&
+		opj_get_memory_usage(l_job->codec, &(l_job->current), &(l_job->peak));
+	return 00;
+}
+
+/* decodes the area of p_job again with a new clone, alone: the memory accounting of the clones decoding
+   at the same time must not have mixed */
+static OPJ_UINT32 check_memory_usage(opj_codec_t * p_codec, const char * input_file, const clone_job_t * p_job)
+{
+	clone_job_t l_job;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	memset(&l_job, 0, sizeof(l_job));
+	l_job.area = p_job->area;
+	l_job.codec = opj_codec_clone(p_codec, &(l_job.image));
+	l_job.stream = opj_stream_create_default_file_stream(input_file, OPJ_TRUE);
+	if (l_job.codec && l_job.stream) {
+		decode_clone(&l_job);
+	}
+	if (! l_job.success) {
+		fprintf(stderr, "ERROR -> test_codec_clone: failed to decode an area of %s with a clone alone!\n", input_file);
+		l_nb_errors = 1;
+	}
+	else if (l_job.current != p_job->current || l_job.peak != p_job->peak) {
+		fprintf(stderr, "ERROR -> test_codec_clone: clone using %lu bytes (peak %lu) instead of %lu bytes (peak %lu) alone\n",
+			(unsigned long)p_job->current, (unsigned long)p_job->peak, (unsigned long)l_job.current, (unsigned long)l_job.peak);
+		l_nb_errors = 1;
+	}
+
+	opj_stream_destroy(l_job.stream);
+	opj_destroy_codec(l_job.codec);
+	opj_image_destroy(l_job.image);
+	return l_nb_errors;
+}
+
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	opj_stream_t * l_stream;
+	OPJ_INT32 l_areas [NUM_AREAS][4];
+	clone_job_t l_jobs [NUM_AREAS];
+	OPJ_UINT32 l_nb_jobs = 0;
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_SIZE_T l_current, l_current_after;
+	OPJ_UINT32 i;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 reduce;
+	char output_file[64];
+
+	/* should be test_codec_clone 3 1000 700 1 256 256 0 tcc1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		reduce = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		reduce = 0;
+		strcpy(output_file, "test_codec_clone.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.numresolution = 5;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* overlapping areas, then the whole image */
+	for (i=0;i<NUM_AREAS-1;++i) {
+		OPJ_UINT32 l_ref_area = (i % 3);
+
+		l_areas[i][0] = (OPJ_INT32)(image_width * l_ref_area / 5);
+		l_areas[i][1] = (OPJ_INT32)(image_height * l_ref_area / 6);
+		l_areas[i][2] = (OPJ_INT32)(image_width * (l_ref_area + 2) / 5);
+		l_areas[i][3] = (OPJ_INT32)(image_height * (l_ref_area + 3) / 6);
+	}
+	memset(l_areas[NUM_AREAS-1], 0, sizeof(l_areas[NUM_AREAS-1]));
+
+	/* the header is read once, each area is decoded by a clone with its own stream */
+	l_codec = create_decoder(output_file, reduce, &l_stream, &l_image);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_codec_clone: failed to read the header of %s!\n", output_file);
+		return 1;
+	}
+	opj_stream_destroy(l_stream);
+
+	memset(l_jobs, 0, sizeof(l_jobs));
+	for (i=0;i<NUM_AREAS;++i) {
+		clone_job_t * l_job = &(l_jobs[l_nb_jobs]);
+
+		l_job->codec = opj_codec_clone(l_codec, &(l_job->image));
+		if (! l_job->codec) {
+			fprintf(stderr, "ERROR -> test_codec_clone: failed to clone the decompressor\n");
+			++l_nb_errors;
+			break;
+		}
+		l_job->stream = opj_stream_create_default_file_stream(output_file, OPJ_TRUE);
+		if (! l_job->stream) {
+			opj_destroy_codec(l_job->codec);
+			opj_image_destroy(l_job->image);
+			++l_nb_errors;
+			break;
+		}
+		l_job->area = l_areas[i];
+		++l_nb_jobs;
+	}
+
+	/* the clones decode their areas at the same time, with their own memory accounting */
+	opj_get_memory_usage(l_codec, &l_current, 00);
+#ifdef TEST_HAVE_PTHREAD
+	for (i=0;i<l_nb_jobs;++i) {
+		l_jobs[i].joinable = (pthread_create(&(l_jobs[i].thread), 00, decode_clone, &(l_jobs[i])) == 0);
+		if (! l_jobs[i].joinable) {
+			decode_clone(&(l_jobs[i]));
+		}
+	}
+	for (i=0;i<l_nb_jobs;++i) {
+		if (l_jobs[i].joinable) {
+			pthread_join(l_jobs[i].thread, 00);
+		}
+	}
+#else
+	for (i=0;i<l_nb_jobs;++i) {
+		decode_clone(&(l_jobs[i]));
+	}
+#endif
+
+	opj_get_memory_usage(l_codec, &l_current_after, 00);
+	if (l_current_after != l_current) {
+		fprintf(stderr, "ERROR -> test_codec_clone: the decompressor went from %lu to %lu bytes while its clones decoded\n",
+			(unsigned long)l_current, (unsigned long)l_current_after);
+		++l_nb_errors;
+	}
+
+	for (i=0;i<l_nb_jobs;++i) {
+		clone_job_t * l_job = &(l_jobs[i]);
+
+		opj_stream_destroy(l_job->stream);
+		opj_destroy_codec(l_job->codec);
+
+		if (! l_job->success) {
+			fprintf(stderr, "ERROR -> test_codec_clone: failed to decode the area %d of %s with a clone!\n", i, output_file);
+			++l_nb_errors;
+		}
+		else if (! l_nb_errors) {
+			l_ref = decode_area(output_file, reduce, l_job->area);
+			if (! l_ref) {
+				fprintf(stderr, "ERROR -> test_codec_clone: failed to decode the area %d of %s!\n", i, output_file);
+				++l_nb_errors;
+			}
+			else {
+				l_nb_errors += compare_images(l_job->image, l_ref);
+				opj_image_destroy(l_ref);
+				l_nb_errors += check_memory_usage(l_codec, output_file, l_job);
+			}
+		}
+		opj_image_destroy(l_job->image);
+	}
+
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_codec_clone: %d samples differ from the ones decoded without clone\n", l_nb_errors);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,376 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* -------------------------------------------------------------------------- */
+
+void error_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stdout, "[ERROR] %s", msg);
+}
+
+void warning_callback(const char *msg, void *client_data) {
+	(void)client_data;
+	fprintf(stdout, "[WARNING] %s", msg);
+}
+
+/* -------------------------------------------------------------------------- */
+
+OPJ_UINT32 ceildiv(OPJ_UINT32 a, OPJ_UINT32 b)
+{
+	return (a + b - 1) / b;
+}
+
+OPJ_INT32 sample_value(OPJ_UINT32 compno, OPJ_UINT32 x, OPJ_UINT32 y)
+{
+	return (OPJ_INT32)((x * 7 + y * 3 + compno * 50 + ((x * y) >> 5)) & 0xff);
+}
+
+void set_component_params(opj_image_cmptparm_t * p_params, OPJ_UINT32 num_comps,
+                          OPJ_UINT32 image_x0, OPJ_UINT32 image_y0,
+                          OPJ_UINT32 image_width, OPJ_UINT32 image_height,
+                          OPJ_UINT32 subsampling)
+{
+	OPJ_UINT32 i;
+
+	for (i=0;i<num_comps;++i) {
+		memset(&p_params[i], 0, sizeof(opj_image_cmptparm_t));
+		p_params[i].dx = (i == 0) ? 1 : subsampling;
+		p_params[i].dy = (i == 0) ? 1 : subsampling;
+		p_params[i].x0 = ceildiv(image_x0, p_params[i].dx);
+		p_params[i].y0 = ceildiv(image_y0, p_params[i].dy);
+		p_params[i].w = ceildiv(image_x0 + image_width, p_params[i].dx) - p_params[i].x0;
+		p_params[i].h = ceildiv(image_y0 + image_height, p_params[i].dy) - p_params[i].y0;
+		p_params[i].prec = 8;
+		p_params[i].sgnd = 0;
+	}
+}
+
+opj_image_t * create_image(OPJ_UINT32 num_comps,
+                           OPJ_UINT32 image_x0, OPJ_UINT32 image_y0,
+                           OPJ_UINT32 image_width, OPJ_UINT32 image_height,
+                           OPJ_UINT32 subsampling)
+{
+	opj_image_t * l_image;
+	opj_image_cmptparm_t l_params [NUM_COMPS_MAX];
+	OPJ_UINT32 y, x, compno;
+
+	if (num_comps > NUM_COMPS_MAX || subsampling == 0) {
+		return 00;
+	}
+	set_component_params(l_params, num_comps, image_x0, image_y0, image_width, image_height, subsampling);
+
+	l_image = opj_image_create(num_comps,l_params,(num_comps >= 3) ? OPJ_CLRSPC_SRGB : OPJ_CLRSPC_GRAY);
+	if (! l_image) {
+		return 00;
+	}
+	l_image->x0 = image_x0;
+	l_image->y0 = image_y0;
+	l_image->x1 = image_x0 + image_width;
+	l_image->y1 = image_y0 + image_height;
+
+	for (compno=0;compno<num_comps;++compno) {
+		opj_image_comp_t * l_comp = &(l_image->comps[compno]);
+
+		for (y=0;y<l_comp->h;++y) {
+			for (x=0;x<l_comp->w;++x) {
+				l_comp->data[y * l_comp->w + x] = sample_value(compno,x,y);
+			}
+		}
+	}
+	return l_image;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static OPJ_BOOL is_jp2_file(const char * p_file)
+{
+	size_t len = strlen(p_file);
+
+	return len >= 4 && strcmp(p_file + len - 4, ".jp2") == 0;
+}
+
+opj_codec_t * create_compressor(const char * output_file)
+{
+	opj_codec_t * l_codec;
+
+	l_codec = opj_create_compress(is_jp2_file(output_file) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K);
+	if (! l_codec) {
+		return 00;
+	}
+	opj_set_warning_handler(l_codec, warning_callback,00);
+	opj_set_error_handler(l_codec, error_callback,00);
+	return l_codec;
+}
+
+opj_codec_t * create_decompressor(const char * input_file, OPJ_UINT32 reduce, OPJ_UINT32 p_layers)
+{
+	opj_dparameters_t l_param;
+
+	opj_set_default_decoder_parameters(&l_param);
+	l_param.cp_reduce = reduce;
+	l_param.cp_layer = p_layers;
+	return setup_decompressor(input_file, &l_param);
+}
+
+opj_codec_t * setup_decompressor(const char * input_file, opj_dparameters_t * p_param)
+{
+	opj_codec_t * l_codec;
+
+	l_codec = opj_create_decompress(is_jp2_file(input_file) ? OPJ_CODEC_JP2 : OPJ_CODEC_J2K);
+	if (! l_codec) {
+		return 00;
+	}
+	opj_set_warning_handler(l_codec, warning_callback,00);
+	opj_set_error_handler(l_codec, error_callback,00);
+
+	if (! opj_setup_decoder(l_codec, p_param)) {
+		opj_destroy_codec(l_codec);
+		return 00;
+	}
+	return l_codec;
+}
+
+OPJ_BOOL encode_image(const char * output_file, opj_cparameters_t * p_param, opj_image_t * p_image)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	OPJ_BOOL l_success;
+
+	l_codec = create_compressor(output_file);
+	if (! l_codec) {
+		return OPJ_FALSE;
+	}
+	l_stream = opj_stream_create_default_file_stream(output_file, OPJ_FALSE);
+	if (! l_stream) {
+		fprintf(stderr, "ERROR -> failed to create the stream from the output file %s !\n",output_file );
+		opj_destroy_codec(l_codec);
+		return OPJ_FALSE;
+	}
+
+	l_success = opj_setup_encoder(l_codec,p_param,p_image) &&
+		opj_start_compress(l_codec,p_image,l_stream) &&
+		opj_encode(l_codec,l_stream) &&
+		opj_end_compress(l_codec,l_stream);
+	if (! l_success) {
+		fprintf(stderr, "ERROR -> failed to encode %s!\n", output_file);
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_success;
+}
+
+/* -------------------------------------------------------------------------- */
+
+opj_codec_t * create_decoder(const char * input_file, OPJ_UINT32 reduce, opj_stream_t ** p_stream, opj_image_t ** p_image)
+{
+	opj_codec_t * l_codec;
+
+	l_codec = create_decompressor(input_file, reduce, 0);
+	if (! l_codec) {
+		return 00;
+	}
+	*p_stream = opj_stream_create_default_file_stream(input_file, OPJ_TRUE);
+	if (! *p_stream) {
+		opj_destroy_codec(l_codec);
+		return 00;
+	}
+	if (! opj_read_header(*p_stream, l_codec, p_image)) {
+		opj_stream_destroy(*p_stream);
+		opj_destroy_codec(l_codec);
+		return 00;
+	}
+	return l_codec;
+}
+
+opj_image_t * decode_image(const char * input_file, OPJ_UINT32 reduce, OPJ_UINT32 p_layers)
+{
+	opj_dparameters_t l_param;
+
+	opj_set_default_decoder_parameters(&l_param);
+	l_param.cp_reduce = reduce;
+	l_param.cp_layer = p_layers;
+	return decode_image_with_parameters(input_file, &l_param);
+}
+
+opj_image_t * decode_image_with_parameters(const char * input_file, opj_dparameters_t * p_param)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+
+	l_codec = setup_decompressor(input_file, p_param);
+	if (! l_codec) {
+		return 00;
+	}
+	l_stream = opj_stream_create_default_file_stream(input_file, OPJ_TRUE);
+	if (! l_stream) {
+		opj_destroy_codec(l_codec);
+		return 00;
+	}
+	if (! opj_read_header(l_stream, l_codec, &l_image) ||
+		! opj_decode(l_codec, l_stream, l_image) ||
+		! opj_end_decompress(l_codec, l_stream)) {
+		opj_image_destroy(l_image);
+		l_image = 00;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_image;
+}
+
+opj_image_t * decode_area(const char * input_file, OPJ_UINT32 reduce, const OPJ_INT32 * p_area)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+
+	l_codec = create_decoder(input_file, reduce, &l_stream, &l_image);
+	if (! l_codec) {
+		return 00;
+	}
+	if (! opj_set_decode_area(l_codec, l_image, p_area[0], p_area[1], p_area[2], p_area[3]) ||
+		! opj_decode(l_codec, l_stream, l_image) ||
+		! opj_end_decompress(l_codec, l_stream)) {
+		opj_image_destroy(l_image);
+		l_image = 00;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_image;
+}
+
+/* -------------------------------------------------------------------------- */
+
+OPJ_UINT32 compare_components(const opj_image_comp_t * p_comp, const opj_image_comp_t * p_ref)
+{
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 i;
+
+	if (p_comp->w != p_ref->w || p_comp->h != p_ref->h || ! p_comp->data) {
+		return 1;
+	}
+	for (i=0;i<p_ref->w * p_ref->h;++i) {
+		if (p_comp->data[i] != p_ref->data[i]) {
+			++l_nb_errors;
+		}
+	}
+	return l_nb_errors;
+}
+
+OPJ_UINT32 compare_images(const opj_image_t * p_image, const opj_image_t * p_ref)
+{
+	OPJ_UINT32 compno;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	if (p_image->numcomps != p_ref->numcomps) {
+		return 1;
+	}
+	for (compno=0;compno<p_ref->numcomps;++compno) {
+		l_nb_errors += compare_components(&(p_image->comps[compno]), &(p_ref->comps[compno]));
+	}
+	return l_nb_errors;
+}
+
+/* -------------------------------------------------------------------------- */
+
+OPJ_UINT32 read_value(const OPJ_BYTE * p_data, OPJ_UINT32 p_nb_bytes)
+{
+	OPJ_UINT32 l_value = 0;
+	OPJ_UINT32 i;
+
+	for (i=0;i<p_nb_bytes;++i) {
+		l_value = (l_value << 8) | p_data[i];
+	}
+	return l_value;
+}
+
+OPJ_UINT32 checksum(OPJ_UINT32 p_hash, const OPJ_BYTE * p_data, OPJ_SIZE_T p_size)
+{
+	OPJ_SIZE_T i;
+
+	for (i = 0; i < p_size; ++i) {
+		p_hash = (p_hash ^ p_data[i]) * 16777619U;
+	}
+	return p_hash;
+}
+
+OPJ_UINT32 image_checksum(const opj_image_t * p_image)
+{
+	OPJ_UINT32 l_hash = 2166136261U;
+	OPJ_UINT32 compno;
+	OPJ_SIZE_T i;
+
+	for (compno = 0; compno < p_image->numcomps; ++compno) {
+		const opj_image_comp_t * l_comp = &p_image->comps[compno];
+		OPJ_SIZE_T l_nb_samples = (OPJ_SIZE_T)l_comp->w * l_comp->h;
+
+		for (i = 0; i < l_nb_samples; ++i) {
+			OPJ_BYTE l_bytes[4];
+			OPJ_UINT32 l_value = (OPJ_UINT32)l_comp->data[i];
+
+			l_bytes[0] = (OPJ_BYTE)(l_value >> 24);
+			l_bytes[1] = (OPJ_BYTE)(l_value >> 16);
+			l_bytes[2] = (OPJ_BYTE)(l_value >> 8);
+			l_bytes[3] = (OPJ_BYTE)l_value;
+			l_hash = checksum(l_hash, l_bytes, 4);
+		}
+	}
+	return l_hash;
+}
+
+OPJ_BYTE * read_file(const char * input_file, OPJ_UINT32 * p_size)
+{
+	FILE * l_file;
+	OPJ_BYTE * l_data = 00;
+	long l_size;
+
+	l_file = fopen(input_file, "rb");
+	if (! l_file) {
+		return 00;
+	}
+	if (fseek(l_file, 0, SEEK_END) == 0 && (l_size = ftell(l_file)) > 0 && fseek(l_file, 0, SEEK_SET) == 0) {
+		l_data = (OPJ_BYTE *) malloc((size_t)l_size);
+		if (l_data && fread(l_data, 1, (size_t)l_size, l_file) != (size_t)l_size) {
+			free(l_data);
+			l_data = 00;
+		}
+		*p_size = (OPJ_UINT32)l_size;
+	}
+	fclose(l_file);
+	return l_data;
+}
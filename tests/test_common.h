@@ -0,0 +1,108 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+/* fixture shared by the tests of the library: images filled with known samples, encoded to a file then decoded back */
+
+#include "openjpeg.h"
+
+#define NUM_COMPS_MAX 4
+
+/**
+sample error debug callback expecting no client object
+*/
+void error_callback(const char *msg, void *client_data);
+/**
+sample warning debug callback expecting no client object
+*/
+void warning_callback(const char *msg, void *client_data);
+
+OPJ_UINT32 ceildiv(OPJ_UINT32 a, OPJ_UINT32 b);
+
+/* value of the sample (x,y) of a component, in component coordinates */
+OPJ_INT32 sample_value(OPJ_UINT32 compno, OPJ_UINT32 x, OPJ_UINT32 y);
+
+/* parameters of num_comps 8-bit components covering the image area (x0,y0)-(x0+width,y0+height), all the components but the first one subsampled by subsampling */
+void set_component_params(opj_image_cmptparm_t * p_params, OPJ_UINT32 num_comps,
+                          OPJ_UINT32 image_x0, OPJ_UINT32 image_y0,
+                          OPJ_UINT32 image_width, OPJ_UINT32 image_height,
+                          OPJ_UINT32 subsampling);
+
+/* creates the image of set_component_params, filled with sample_value */
+opj_image_t * create_image(OPJ_UINT32 num_comps,
+                           OPJ_UINT32 image_x0, OPJ_UINT32 image_y0,
+                           OPJ_UINT32 image_width, OPJ_UINT32 image_height,
+                           OPJ_UINT32 subsampling);
+
+/* compressor of the format given by the extension of the file, reporting to the callbacks above */
+opj_codec_t * create_compressor(const char * output_file);
+
+/* decompressor of the format given by the extension of the file, set up without its reduce finest resolutions and with its p_layers first quality layers (all if 0) */
+opj_codec_t * create_decompressor(const char * input_file, OPJ_UINT32 reduce, OPJ_UINT32 p_layers);
+
+/* decompressor of the format given by the extension of the file, set up with p_param */
+opj_codec_t * setup_decompressor(const char * input_file, opj_dparameters_t * p_param);
+
+/* encodes p_image with p_param into output_file, the encoder takes the samples of the image, which is left to destroy */
+OPJ_BOOL encode_image(const char * output_file, opj_cparameters_t * p_param, opj_image_t * p_image);
+
+/* opens input_file and reads its header, without its reduce finest resolutions, returns 00 on failure */
+opj_codec_t * create_decoder(const char * input_file, OPJ_UINT32 reduce, opj_stream_t ** p_stream, opj_image_t ** p_image);
+
+/* decodes the whole image with opj_decode, with the decompressor above */
+opj_image_t * decode_image(const char * input_file, OPJ_UINT32 reduce, OPJ_UINT32 p_layers);
+
+/* decodes the whole image with opj_decode, with a decompressor set up with p_param */
+opj_image_t * decode_image_with_parameters(const char * input_file, opj_dparameters_t * p_param);
+
+/* decodes the area {x0,y0,x1,y1} with a new decompressor, the whole image if the area is empty */
+opj_image_t * decode_area(const char * input_file, OPJ_UINT32 reduce, const OPJ_INT32 * p_area);
+
+/* number of samples of p_ref which differ from the ones of p_comp, 1 if their sizes differ */
+OPJ_UINT32 compare_components(const opj_image_comp_t * p_comp, const opj_image_comp_t * p_ref);
+
+/* number of samples of p_ref which differ from the ones of p_image */
+OPJ_UINT32 compare_images(const opj_image_t * p_image, const opj_image_t * p_ref);
+
+/* big endian value of the p_nb_bytes bytes at p_data */
+OPJ_UINT32 read_value(const OPJ_BYTE * p_data, OPJ_UINT32 p_nb_bytes);
+
+/* FNV-1a hash of the p_size bytes at p_data, continuing p_hash (2166136261 for a new hash) */
+OPJ_UINT32 checksum(OPJ_UINT32 p_hash, const OPJ_BYTE * p_data, OPJ_SIZE_T p_size);
+
+/* hash of the samples of all the components of p_image, in big endian */
+OPJ_UINT32 image_checksum(const opj_image_t * p_image);
+
+/* reads the whole file in memory, to be released with free */
+OPJ_BYTE * read_file(const char * input_file, OPJ_UINT32 * p_size);
+
+#endif /* TEST_COMMON_H */
@@ -0,0 +1,180 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_RESOLUTIONS 5
+
+/* decodes the whole image within p_max_time seconds */
+static opj_image_t * decode_within_budget(const char * input_file, OPJ_UINT32 reduce, OPJ_FLOAT64 p_max_time, opj_decode_report_t * p_report)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+
+	l_codec = create_decoder(input_file, reduce, &l_stream, &l_image);
+	if (! l_codec) {
+		return 00;
+	}
+	if (! opj_decode_within_budget(l_codec, l_stream, l_image, p_max_time, p_report) ||
+		! opj_end_decompress(l_codec, l_stream)) {
+		opj_image_destroy(l_image);
+		l_image = 00;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_image;
+}
+
+/* decodes within a budget and compares the result with the decoding at the resolution factor reported */
+static OPJ_UINT32 check_budget(const char * input_file, OPJ_UINT32 reduce, OPJ_FLOAT64 p_max_time, OPJ_UINT32 p_expected_reduce)
+{
+	opj_decode_report_t l_report;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	OPJ_UINT32 l_nb_errors;
+	OPJ_UINT32 i;
+
+	l_image = decode_within_budget(input_file, reduce, p_max_time, &l_report);
+	if (! l_image) {
+		fprintf(stderr, "ERROR -> test_decode_budget: failed to decode %s within %f s!\n", input_file, p_max_time);
+		return 1;
+	}
+	if (l_report.reduce != p_expected_reduce ||
+		l_report.nb_steps != NUM_RESOLUTIONS - l_report.reduce ||
+		l_report.complete != (l_report.reduce == reduce) ||
+		l_report.layers != 1) {
+		fprintf(stderr, "ERROR -> test_decode_budget: unexpected report for %f s: reduce %d, %d steps, %d layers\n",
+			p_max_time, l_report.reduce, l_report.nb_steps, l_report.layers);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	l_ref = decode_image(input_file, l_report.reduce, 0);
+	if (! l_ref) {
+		fprintf(stderr, "ERROR -> test_decode_budget: failed to decode %s!\n", input_file);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	l_nb_errors = compare_images(l_image, l_ref);
+	for (i=0;i<l_image->numcomps && ! l_nb_errors;++i) {
+		if (l_image->comps[i].factor != l_report.reduce) {
+			++l_nb_errors;
+		}
+	}
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_decode_budget: %d samples differ from the ones of the decoding at the resolution factor %d\n", l_nb_errors, l_report.reduce);
+	}
+	opj_image_destroy(l_ref);
+	opj_image_destroy(l_image);
+	return l_nb_errors;
+}
+
+/* encodes a tiled image, then decodes it without time and with plenty of time */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 reduce;
+	char output_file[64];
+
+	/* should be test_decode_budget 3 1000 700 0 256 256 0 tdb1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		reduce = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		reduce = 0;
+		strcpy(output_file, "test_decode_budget.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 || reduce >= NUM_RESOLUTIONS )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.numresolution = NUM_RESOLUTIONS;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* without time, only the coarsest resolution is decoded */
+	if (check_budget(output_file, reduce, 0, NUM_RESOLUTIONS - 1)) {
+		return 1;
+	}
+	/* with plenty of time, the image is decoded at the requested resolution */
+	if (check_budget(output_file, reduce, 1000, reduce)) {
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_LAYERS 3
+
+/* the bytes of the file received so far */
+typedef struct received_data
+{
+	OPJ_BYTE * data;
+	OPJ_SIZE_T size;
+	OPJ_SIZE_T pos;
+} received_data_t;
+
+static OPJ_SIZE_T received_read(void * p_buffer, OPJ_SIZE_T p_nb_bytes, void * p_user_data)
+{
+	received_data_t * l_received = (received_data_t *) p_user_data;
+
+	if (l_received->pos >= l_received->size) {
+		return (OPJ_SIZE_T)-1;
+	}
+	if (p_nb_bytes > l_received->size - l_received->pos) {
+		p_nb_bytes = l_received->size - l_received->pos;
+	}
+	memcpy(p_buffer, l_received->data + l_received->pos, p_nb_bytes);
+	l_received->pos += p_nb_bytes;
+	return p_nb_bytes;
+}
+
+static OPJ_OFF_T received_skip(OPJ_OFF_T p_nb_bytes, void * p_user_data)
+{
+	received_data_t * l_received = (received_data_t *) p_user_data;
+
+	if (p_nb_bytes < 0 || (OPJ_SIZE_T)p_nb_bytes > l_received->size - l_received->pos) {
+		return -1;
+	}
+	l_received->pos += (OPJ_SIZE_T)p_nb_bytes;
+	return p_nb_bytes;
+}
+
+static OPJ_BOOL received_seek(OPJ_OFF_T p_pos, void * p_user_data)
+{
+	received_data_t * l_received = (received_data_t *) p_user_data;
+
+	if (p_pos < 0 || (OPJ_SIZE_T)p_pos > l_received->size) {
+		return OPJ_FALSE;
+	}
+	l_received->pos = (OPJ_SIZE_T)p_pos;
+	return OPJ_TRUE;
+}
+
+/* stream of the bytes received so far */
+static opj_stream_t * create_received_stream(received_data_t * p_received)
+{
+	opj_stream_t * l_stream = opj_stream_default_create(OPJ_TRUE);
+
+	if (! l_stream) {
+		return 00;
+	}
+	p_received->pos = 0;
+	opj_stream_set_user_data(l_stream, p_received, 00);
+	opj_stream_set_user_data_length(l_stream, p_received->size);
+	opj_stream_set_read_function(l_stream, received_read);
+	opj_stream_set_skip_function(l_stream, received_skip);
+	opj_stream_set_seek_function(l_stream, received_seek);
+	return l_stream;
+}
+
+/* decodes the file as its bytes arrive, p_chunk_size bytes at a time, and compares the result with opj_decode */
+static OPJ_UINT32 check_incremental(const char * input_file, OPJ_UINT32 p_chunk_size)
+{
+	received_data_t l_received;
+	OPJ_SIZE_T l_file_size;
+	opj_codec_t * l_codec = 00;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	opj_image_t * l_ref;
+	OPJ_BOOL l_complete = OPJ_FALSE;
+	OPJ_UINT32 l_nb_calls = 0;
+	OPJ_UINT32 l_nb_errors;
+	OPJ_UINT32 l_size = 0;
+
+	l_received.data = read_file(input_file, &l_size);
+	if (! l_received.data) {
+		return 1;
+	}
+	l_file_size = l_size;
+
+	l_received.size = 0;
+	while (! l_complete) {
+		if (l_received.size == l_file_size) {
+			fprintf(stderr, "ERROR -> test_decode_incremental: %s is not complete once all its bytes are received!\n", input_file);
+			break;
+		}
+		l_received.size += p_chunk_size;
+		if (l_received.size > l_file_size) {
+			l_received.size = l_file_size;
+		}
+
+		l_stream = create_received_stream(&l_received);
+		if (! l_stream) {
+			break;
+		}
+
+		/* the main header may need several chunks: until it is complete, reading it fails silently */
+		if (! l_image) {
+			l_codec = create_decompressor(input_file, 0, 0);
+			if (l_codec) {
+				opj_set_error_handler(l_codec, 00, 00);
+				if (! opj_read_header(l_stream, l_codec, &l_image)) {
+					opj_destroy_codec(l_codec);
+					l_codec = 00;
+					l_image = 00;
+				}
+			}
+			if (! l_codec) {
+				opj_stream_destroy(l_stream);
+				continue;
+			}
+			opj_set_error_handler(l_codec, error_callback, 00);
+		}
+
+		if (! opj_decode_incremental(l_codec, l_stream, l_image, &l_complete)) {
+			fprintf(stderr, "ERROR -> test_decode_incremental: failed to decode the %lu first bytes of %s!\n", (unsigned long)l_received.size, input_file);
+			opj_stream_destroy(l_stream);
+			break;
+		}
+		++l_nb_calls;
+		opj_stream_destroy(l_stream);
+	}
+	opj_destroy_codec(l_codec);
+	free(l_received.data);
+
+	if (! l_complete || l_nb_calls < 2) {
+		fprintf(stderr, "ERROR -> test_decode_incremental: %s decoded in %d calls\n", input_file, l_nb_calls);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	l_ref = decode_image(input_file, 0, 0);
+	if (! l_ref) {
+		fprintf(stderr, "ERROR -> test_decode_incremental: failed to decode %s!\n", input_file);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	l_nb_errors = compare_images(l_image, l_ref);
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_decode_incremental: %d samples differ from the ones of opj_decode\n", l_nb_errors);
+	}
+	opj_image_destroy(l_ref);
+	opj_image_destroy(l_image);
+	return l_nb_errors;
+}
+
+/* encodes a tiled image with several quality layers, then decodes it as its bytes arrive */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 chunk_size;
+	char output_file[64];
+
+	/* should be test_decode_incremental 3 1000 700 0 256 256 4096 tdi1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		chunk_size = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		chunk_size = 4096;
+		strcpy(output_file, "test_decode_incremental.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 || chunk_size == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = NUM_LAYERS;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 40;
+	l_param.tcp_rates[1] = 10;
+	l_param.tcp_rates[2] = irreversible ? 4 : 0;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	/* the resolutions arrive one after the other, with the layers of each one */
+	l_param.prog_order = OPJ_RLCP;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	if (check_incremental(output_file, chunk_size)) {
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,207 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define MAX_TILE_PARTS 256
+
+/* moves the tile-parts of the codestream so that the n-th tile-parts of all the tiles follow each other:
+   the first tile-parts of the other tiles are read before the last one of the first tile. Returns 0 on failure */
+static int interleave_tile_parts(OPJ_BYTE * p_data, OPJ_UINT32 p_size)
+{
+	OPJ_UINT32 l_offsets[MAX_TILE_PARTS];
+	OPJ_UINT32 l_lengths[MAX_TILE_PARTS];
+	OPJ_UINT32 l_parts[MAX_TILE_PARTS];
+	OPJ_UINT32 l_nb_tile_parts = 0;
+	OPJ_UINT32 l_first, l_pos, l_part, l_max_part = 0;
+	OPJ_BYTE * l_interleaved;
+	OPJ_UINT32 i;
+
+	/* the markers of the main header do not hold 0xFF90 */
+	for (l_first = 0; l_first + 1 < p_size; ++l_first) {
+		if (p_data[l_first] == 0xFF && p_data[l_first + 1] == 0x90) {
+			break;
+		}
+	}
+	for (l_pos = l_first; l_pos + 12 <= p_size && read_value(p_data + l_pos, 2) == 0xFF90; ) {
+		if (l_nb_tile_parts == MAX_TILE_PARTS) {
+			return 0;
+		}
+		l_offsets[l_nb_tile_parts] = l_pos;
+		l_lengths[l_nb_tile_parts] = read_value(p_data + l_pos + 6, 4);
+		l_parts[l_nb_tile_parts] = read_value(p_data + l_pos + 10, 1);
+		l_max_part = l_parts[l_nb_tile_parts] > l_max_part ? l_parts[l_nb_tile_parts] : l_max_part;
+		if (l_lengths[l_nb_tile_parts] < 14 || l_lengths[l_nb_tile_parts] > p_size - l_pos) {
+			return 0;
+		}
+		l_pos += l_lengths[l_nb_tile_parts++];
+	}
+	if (l_max_part == 0) {
+		return 0;
+	}
+
+	l_interleaved = (OPJ_BYTE *) malloc(l_pos - l_first);
+	if (! l_interleaved) {
+		return 0;
+	}
+	l_pos = 0;
+	for (l_part = 0; l_part <= l_max_part; ++l_part) {
+		for (i = 0; i < l_nb_tile_parts; ++i) {
+			if (l_parts[i] == l_part) {
+				memcpy(l_interleaved + l_pos, p_data + l_offsets[i], l_lengths[i]);
+				l_pos += l_lengths[i];
+			}
+		}
+	}
+	memcpy(p_data + l_first, l_interleaved, l_pos);
+	free(l_interleaved);
+	return 1;
+}
+
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	opj_image_t * l_ref;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 l_tile_index, l_nb_comps;
+	OPJ_SIZE_T l_data_size;
+	OPJ_INT32 l_tile_x0, l_tile_y0, l_tile_x1, l_tile_y1;
+	OPJ_BOOL l_go_on = OPJ_TRUE;
+	FILE * l_file;
+	OPJ_UINT32 i;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 tile_size;
+	char output_file[64];
+
+	/* should be test_decode_retry 3 640 480 256 trt1.j2k */
+	if( argc == 6 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		tile_size = (OPJ_UINT32)atoi( argv[4] );
+		strcpy(output_file, argv[5] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 640;
+		image_height = 480;
+		tile_size = 256;
+		strcpy(output_file, "test_decode_retry.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || tile_size == 0 )
+	{
+		return 1;
+	}
+
+	/* a tile-part per resolution, with the lengths of its packets */
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_size;
+	l_param.cp_tdy = (int)tile_size;
+	l_param.tp_on = 1;
+	l_param.tp_flag = 'R';
+	l_param.plt_on = OPJ_TRUE;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image || ! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+	l_image = 00;
+
+	l_ref = decode_image(output_file, 0, 0);
+	l_data = read_file(output_file, &l_size);
+	if (! l_ref || ! l_data) {
+		fprintf(stderr, "ERROR -> test_decode_retry: failed to decode %s!\n", output_file);
+		return 1;
+	}
+	if (! interleave_tile_parts(l_data, l_size)) {
+		fprintf(stderr, "ERROR -> test_decode_retry: failed to interleave the tile-parts of %s!\n", output_file);
+		return 1;
+	}
+	l_file = fopen(output_file, "wb");
+	if (! l_file || fwrite(l_data, 1, l_size, l_file) != l_size) {
+		fprintf(stderr, "ERROR -> test_decode_retry: failed to write %s!\n", output_file);
+		return 1;
+	}
+	fclose(l_file);
+	free(l_data);
+
+	/* reading the header of the first tile reads the first tile-parts of the next tiles too: the
+	   decoding is given up before the tile is decoded */
+	l_codec = create_decoder(output_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 1;
+	}
+	if (! opj_read_tile_header(l_codec, l_stream, &l_tile_index, &l_data_size, &l_tile_x0, &l_tile_y0,
+	                           &l_tile_x1, &l_tile_y1, &l_nb_comps, &l_go_on) || ! l_go_on) {
+		fprintf(stderr, "ERROR -> test_decode_retry: failed to read the header of the first tile of %s!\n", output_file);
+		l_nb_errors = 1;
+	}
+
+	/* the whole image, twice: the tile-parts read above are read again */
+	for (i = 0; i < 2 && ! l_nb_errors; ++i) {
+		if (! opj_decode(l_codec, l_stream, l_image)) {
+			fprintf(stderr, "ERROR -> test_decode_retry: failed to decode %s!\n", output_file);
+			l_nb_errors = 1;
+			break;
+		}
+		l_nb_errors = compare_images(l_image, l_ref);
+		if (l_nb_errors) {
+			fprintf(stderr, "ERROR -> test_decode_retry: %d samples of %s differ after %d decodings\n", l_nb_errors, output_file, i + 1);
+		}
+	}
+
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	opj_image_destroy(l_ref);
+	return l_nb_errors ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* decodes the components of p_comps_mask, all of them if 0 */
+static opj_image_t * decode_components(const char * input_file, OPJ_UINT32 reduce, OPJ_UINT32 p_comps_mask)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	OPJ_UINT32 l_indices [NUM_COMPS_MAX];
+	OPJ_UINT32 l_nb_indices = 0;
+	OPJ_UINT32 compno;
+
+	l_codec = create_decoder(input_file, reduce, &l_stream, &l_image);
+	if (! l_codec) {
+		return 00;
+	}
+	for (compno=0;compno<l_image->numcomps;++compno) {
+		if (p_comps_mask & (1U << compno)) {
+			l_indices[l_nb_indices++] = compno;
+		}
+	}
+	if (! opj_set_decoded_components(l_codec, l_nb_indices, l_indices) ||
+		! opj_decode(l_codec, l_stream, l_image) ||
+		! opj_end_decompress(l_codec, l_stream)) {
+		opj_image_destroy(l_image);
+		l_image = 00;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_image;
+}
+
+/* number of samples of the selected components of p_ref which differ from the ones of p_image */
+static OPJ_UINT32 compare_selected_components(const opj_image_t * p_image, const opj_image_t * p_ref, OPJ_UINT32 p_comps_mask)
+{
+	OPJ_UINT32 compno;
+	OPJ_UINT32 l_nb_comps = 0;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	for (compno=0;compno<p_ref->numcomps;++compno) {
+		if (! (p_comps_mask & (1U << compno))) {
+			continue;
+		}
+		if (l_nb_comps >= p_image->numcomps) {
+			return 1;
+		}
+		l_nb_errors += compare_components(&(p_image->comps[l_nb_comps++]), &(p_ref->comps[compno]));
+	}
+	if (l_nb_comps != p_image->numcomps) {
+		return 1;
+	}
+	return l_nb_errors;
+}
+
+/* encodes a tiled image, then decodes some of its components and compares them with the ones of the whole image */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	opj_stream_t * l_stream;
+	OPJ_UINT32 l_indices [2];
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 compno;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 reduce;
+	OPJ_UINT32 comps_mask;
+	char output_file[64];
+
+	/* should be test_decoded_components 4 1000 700 0 256 256 0 10 tdc1.j2k */
+	if( argc == 10 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		reduce = (OPJ_UINT32)atoi( argv[7] );
+		comps_mask = (OPJ_UINT32)atoi( argv[8] );
+		strcpy(output_file, argv[9] );
+	}
+	else
+	{
+		num_comps = 4;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		reduce = 0;
+		comps_mask = 10;
+		strcpy(output_file, "test_decoded_components.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 ||
+		comps_mask == 0 || comps_mask >= (1U << num_comps) )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.numresolution = 5;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* an index out of range or given twice is refused */
+	l_codec = create_decoder(output_file, reduce, &l_stream, &l_image);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_decoded_components: failed to read the header of %s!\n", output_file);
+		return 1;
+	}
+	l_indices[0] = num_comps;
+	if (opj_set_decoded_components(l_codec, 1, l_indices)) {
+		++l_nb_errors;
+	}
+	l_indices[0] = 0;
+	l_indices[1] = 0;
+	if (opj_set_decoded_components(l_codec, 2, l_indices)) {
+		++l_nb_errors;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_decoded_components: invalid component indices have been accepted\n");
+		return 1;
+	}
+
+	l_ref = decode_components(output_file, reduce, 0);
+	if (! l_ref) {
+		fprintf(stderr, "ERROR -> test_decoded_components: failed to decode %s!\n", output_file);
+		return 1;
+	}
+
+	/* the selected components, then each component alone */
+	l_image = decode_components(output_file, reduce, comps_mask);
+	if (! l_image) {
+		fprintf(stderr, "ERROR -> test_decoded_components: failed to decode the components %d of %s!\n", comps_mask, output_file);
+		++l_nb_errors;
+	}
+	else {
+		l_nb_errors += compare_selected_components(l_image, l_ref, comps_mask);
+		opj_image_destroy(l_image);
+	}
+	for (compno=0;compno<num_comps && ! l_nb_errors;++compno) {
+		l_image = decode_components(output_file, reduce, 1U << compno);
+		if (! l_image) {
+			fprintf(stderr, "ERROR -> test_decoded_components: failed to decode the component %d of %s!\n", compno, output_file);
+			++l_nb_errors;
+		}
+		else {
+			l_nb_errors += compare_selected_components(l_image, l_ref, 1U << compno);
+			opj_image_destroy(l_image);
+		}
+	}
+
+	opj_image_destroy(l_ref);
+
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_decoded_components: %d samples differ from the ones of the whole image\n", l_nb_errors);
+		return 1;
+	}
+
+	return 0;
+}
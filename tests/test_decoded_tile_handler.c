@@ -0,0 +1,216 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* decoded image the tiles are compared with */
+typedef struct tile_check
+{
+	opj_image_t * image;
+	OPJ_UINT32 nb_tiles;
+	OPJ_UINT32 nb_errors;
+} tile_check_t;
+
+static OPJ_BOOL check_tile(OPJ_UINT32 p_tile_index,
+                           OPJ_UINT32 p_tile_x0, OPJ_UINT32 p_tile_y0,
+                           OPJ_UINT32 p_tile_x1, OPJ_UINT32 p_tile_y1,
+                           OPJ_UINT32 p_nb_comps,
+                           const opj_decoded_tile_comp_t * p_comps,
+                           void * p_user_data)
+{
+	tile_check_t * l_check = (tile_check_t *) p_user_data;
+	OPJ_UINT32 compno, x, y;
+
+	(void)p_tile_index;
+	if (p_nb_comps != l_check->image->numcomps || p_tile_x0 >= p_tile_x1 || p_tile_y0 >= p_tile_y1) {
+		fprintf(stderr, "ERROR -> test_decoded_tile_handler: unexpected tile %d\n", p_tile_index);
+		return OPJ_FALSE;
+	}
+	++l_check->nb_tiles;
+
+	for (compno=0;compno<p_nb_comps;++compno) {
+		const opj_decoded_tile_comp_t * l_tile_comp = &(p_comps[compno]);
+		opj_image_comp_t * l_comp = &(l_check->image->comps[compno]);
+		OPJ_UINT32 l_comp_x0 = (l_comp->x0 + (1u << l_comp->factor) - 1) >> l_comp->factor;
+		OPJ_UINT32 l_comp_y0 = (l_comp->y0 + (1u << l_comp->factor) - 1) >> l_comp->factor;
+
+		if (l_tile_comp->x0 < l_comp_x0 || l_tile_comp->x0 + l_tile_comp->w > l_comp_x0 + l_comp->w ||
+			l_tile_comp->y0 < l_comp_y0 || l_tile_comp->y0 + l_tile_comp->h > l_comp_y0 + l_comp->h) {
+			fprintf(stderr, "ERROR -> test_decoded_tile_handler: component %d of tile %d out of the image\n", compno, p_tile_index);
+			return OPJ_FALSE;
+		}
+
+		for (y=0;y<l_tile_comp->h;++y) {
+			for (x=0;x<l_tile_comp->w;++x) {
+				OPJ_INT32 l_expected = l_comp->data[(l_tile_comp->y0 - l_comp_y0 + y) * l_comp->w + (l_tile_comp->x0 - l_comp_x0 + x)];
+
+				if (l_tile_comp->data[y * l_tile_comp->stride + x] != l_expected) {
+					++l_check->nb_errors;
+				}
+			}
+		}
+	}
+	return OPJ_TRUE;
+}
+
+/* encodes a tiled image, then decodes it through the decoded tile function only and compares the tiles with the whole image decoded */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_image_t * l_image;
+	opj_image_t * l_decoded;
+	opj_image_t * l_header = 00;
+	opj_stream_t * l_stream;
+	tile_check_t l_check;
+	OPJ_UINT32 compno;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 subsampling;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 reduce;
+	char output_file[64];
+
+	/* should be test_decoded_tile_handler 3 1000 700 2 1 256 256 0 tdt1.j2k */
+	if( argc == 10 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		subsampling = (OPJ_UINT32)atoi( argv[4] );
+		irreversible = (OPJ_UINT32)atoi( argv[5] );
+		tile_width = (OPJ_UINT32)atoi( argv[6] );
+		tile_height = (OPJ_UINT32)atoi( argv[7] );
+		reduce = (OPJ_UINT32)atoi( argv[8] );
+		strcpy(output_file, argv[9] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		subsampling = 1;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		reduce = 0;
+		strcpy(output_file, "test_decoded_tile.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 || subsampling == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.numresolution = 5;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3 && subsampling == 1) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+
+	/* the first component is full size, the others are subsampled */
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, subsampling);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* decode the whole image */
+	l_decoded = decode_image(output_file, reduce, 0);
+	if (! l_decoded) {
+		fprintf(stderr, "ERROR -> test_decoded_tile_handler: failed to decode %s!\n", output_file);
+		return 1;
+	}
+
+	/* decode it again, only through the decoded tile function */
+	l_codec = create_decoder(output_file, reduce, &l_stream, &l_header);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_decoded_tile_handler: failed to read the header of %s!\n", output_file);
+		opj_image_destroy(l_decoded);
+		return 1;
+	}
+
+	memset(&l_check, 0, sizeof(tile_check_t));
+	l_check.image = l_decoded;
+
+	if (! opj_set_decoded_tile_handler(l_codec, check_tile, &l_check, OPJ_TRUE) ||
+		! opj_decode(l_codec, l_stream, l_header) ||
+		! opj_end_decompress(l_codec, l_stream)) {
+		fprintf(stderr, "ERROR -> test_decoded_tile_handler: failed to decode %s through the decoded tile function!\n", output_file);
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_header);
+		opj_image_destroy(l_decoded);
+		return 1;
+	}
+
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+
+	/* the image is not built */
+	for (compno=0;compno<num_comps;++compno) {
+		if (l_header->comps[compno].data) {
+			fprintf(stderr, "ERROR -> test_decoded_tile_handler: component %d has been built\n", compno);
+			++l_check.nb_errors;
+		}
+	}
+	opj_image_destroy(l_header);
+
+	if (l_check.nb_tiles != ceildiv(image_width, tile_width) * ceildiv(image_height, tile_height)) {
+		fprintf(stderr, "ERROR -> test_decoded_tile_handler: %d tiles decoded instead of %d\n", l_check.nb_tiles, ceildiv(image_width, tile_width) * ceildiv(image_height, tile_height));
+		++l_check.nb_errors;
+	}
+	opj_image_destroy(l_decoded);
+
+	if (l_check.nb_errors) {
+		fprintf(stderr, "ERROR -> test_decoded_tile_handler: %d samples differ from the ones of the whole image\n", l_check.nb_errors);
+		return 1;
+	}
+
+	return 0;
+}
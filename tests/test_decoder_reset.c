@@ -0,0 +1,158 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NB_IMAGES 4
+
+/* parameters of each image of the sequence: the first, third and fourth ones share their layout */
+typedef struct test_image_param
+{
+	OPJ_UINT32 num_comps, x0, y0, width, height, tile_size, cblk_size, numresolution;
+	float rate;
+} test_image_param_t;
+
+static const test_image_param_t test_images[NB_IMAGES] = {
+	{ 3,  0,  0, 640, 480, 256, 64, 6,  0.0f },
+	{ 1,  3,  5, 517, 333,   0, 32, 4,  0.0f },
+	{ 3,  0,  0, 640, 480, 256, 64, 6,  0.0f },
+	{ 3,  0,  0, 640, 480, 256, 64, 6, 20.0f }
+};
+
+static OPJ_BOOL encode_test_image(const char * output_file, const test_image_param_t * p_param)
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	OPJ_BOOL l_result;
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = p_param->rate;
+	l_param.numresolution = (int)p_param->numresolution;
+	l_param.cblockw_init = (int)p_param->cblk_size;
+	l_param.cblockh_init = (int)p_param->cblk_size;
+	if (p_param->tile_size) {
+		l_param.tile_size_on = OPJ_TRUE;
+		l_param.cp_tdx = (int)p_param->tile_size;
+		l_param.cp_tdy = (int)p_param->tile_size;
+	}
+
+	l_image = create_image(p_param->num_comps, p_param->x0, p_param->y0, p_param->width, p_param->height, 1);
+	if (! l_image) {
+		return OPJ_FALSE;
+	}
+	l_result = encode_image(output_file, &l_param, l_image);
+	opj_image_destroy(l_image);
+	return l_result;
+}
+
+/* decodes the files one after the other with a single decompressor, reset between two of them, and compares each image with the one of a fresh decompressor */
+int main (int argc, char *argv[])
+{
+	char l_files[NB_IMAGES][64];
+	const char * l_extension;
+	opj_codec_t * l_codec = 00;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	OPJ_UINT32 i;
+	OPJ_BOOL l_decoded;
+	int l_result = 0;
+
+	/* should be test_decoder_reset jp2 */
+	if( argc == 2 )
+	{
+		l_extension = argv[1];
+	}
+	else
+	{
+		l_extension = "j2k";
+	}
+	if( strlen(l_extension) > 8 )
+	{
+		return 1;
+	}
+
+	for (i=0;i<NB_IMAGES;++i) {
+		sprintf(l_files[i], "test_decoder_reset_%d.%s", i, l_extension);
+		if (! encode_test_image(l_files[i], &test_images[i])) {
+			return 1;
+		}
+	}
+
+	for (i=0;i<NB_IMAGES && l_result == 0;++i) {
+		l_image = 00;
+		if (i == 0) {
+			l_codec = create_decoder(l_files[i], 0, &l_stream, &l_image);
+			if (! l_codec) {
+				return 1;
+			}
+		}
+		else {
+			l_stream = opj_stream_create_default_file_stream(l_files[i], OPJ_TRUE);
+			if (! l_stream) {
+				l_result = 1;
+				break;
+			}
+			if (! opj_decoder_reset(l_codec, l_stream, &l_image)) {
+				fprintf(stderr, "ERROR -> test_decoder_reset: failed to reset the decoder for %s\n", l_files[i]);
+				opj_stream_destroy(l_stream);
+				l_result = 1;
+				break;
+			}
+		}
+
+		l_decoded = opj_decode(l_codec, l_stream, l_image) && opj_end_decompress(l_codec, l_stream);
+		opj_stream_destroy(l_stream);
+
+		l_ref = decode_image(l_files[i], 0, 0);
+		if (! l_decoded || ! l_ref) {
+			fprintf(stderr, "ERROR -> test_decoder_reset: failed to decode %s\n", l_files[i]);
+			l_result = 1;
+		}
+		else if (compare_images(l_image, l_ref)) {
+			fprintf(stderr, "ERROR -> test_decoder_reset: %s differs from the decode of a fresh decompressor\n", l_files[i]);
+			l_result = 1;
+		}
+
+		opj_image_destroy(l_ref);
+		opj_image_destroy(l_image);
+	}
+
+	opj_destroy_codec(l_codec);
+	return l_result;
+}
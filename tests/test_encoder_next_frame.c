@@ -0,0 +1,223 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NB_FRAMES 4
+
+static OPJ_UINT32 num_comps;
+static OPJ_UINT32 image_width;
+static OPJ_UINT32 image_height;
+static OPJ_UINT32 tile_size;
+static float rate;
+
+static void set_parameters(opj_cparameters_t * p_param)
+{
+	opj_set_default_encoder_parameters(p_param);
+	p_param->tcp_numlayers = 2;
+	p_param->cp_disto_alloc = 1;
+	p_param->tcp_rates[0] = rate * 2;
+	p_param->tcp_rates[1] = rate;
+	p_param->tcp_mct = (num_comps >= 3) ? 1 : 0;
+	if (tile_size) {
+		p_param->tile_size_on = OPJ_TRUE;
+		p_param->cp_tdx = (int)tile_size;
+		p_param->cp_tdy = (int)tile_size;
+	}
+}
+
+/* image of the frame: the known samples, noise, then a smooth ramp, so that the code-blocks, their
+   buffers and the truncation points of the rate allocation change much from one frame to the next */
+static opj_image_t * create_frame(OPJ_UINT32 p_frameno)
+{
+	opj_image_t * l_image;
+	OPJ_UINT32 compno, i;
+	OPJ_UINT32 l_seed = 12345U + p_frameno;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 00;
+	}
+	for (compno=0;compno<num_comps;++compno) {
+		opj_image_comp_t * l_comp = &(l_image->comps[compno]);
+
+		for (i=0;i<l_comp->w * l_comp->h;++i) {
+			switch (p_frameno % 3) {
+			case 1:
+				l_seed = l_seed * 1103515245U + 12345U;
+				l_comp->data[i] = (OPJ_INT32)((l_seed >> 16) & 0xff);
+				break;
+			case 2:
+				l_comp->data[i] = (OPJ_INT32)(((i % l_comp->w) + (i / l_comp->w) + compno * 16) / 8 & 0xff);
+				break;
+			default:
+				l_comp->data[i] = (l_comp->data[i] + (OPJ_INT32)(p_frameno * 37)) & 0xff;
+				break;
+			}
+		}
+	}
+	return l_image;
+}
+
+/* compresses the frames with one compressor, the first one started with opj_start_compress or opj_encoder_next_frame */
+static OPJ_BOOL encode_frames(const char * p_extension, OPJ_BOOL p_start_compress)
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec = 00;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image;
+	char l_file[64];
+	OPJ_UINT32 i;
+	OPJ_BOOL l_success = OPJ_TRUE;
+
+	for (i=0;i<NB_FRAMES && l_success;++i) {
+		sprintf(l_file, "test_encoder_next_frame_%d.%s", i, p_extension);
+		l_image = create_frame(i);
+		if (! l_image) {
+			l_success = OPJ_FALSE;
+			break;
+		}
+		if (i == 0) {
+			set_parameters(&l_param);
+			l_codec = create_compressor(l_file);
+			if (! l_codec || ! opj_setup_encoder(l_codec, &l_param, l_image)) {
+				opj_image_destroy(l_image);
+				l_success = OPJ_FALSE;
+				break;
+			}
+		}
+		l_stream = opj_stream_create_default_file_stream(l_file, OPJ_FALSE);
+		if (! l_stream) {
+			opj_image_destroy(l_image);
+			l_success = OPJ_FALSE;
+			break;
+		}
+
+		if (i == 0 && p_start_compress) {
+			l_success = opj_start_compress(l_codec, l_image, l_stream);
+		}
+		else {
+			l_success = opj_encoder_next_frame(l_codec, l_image, l_stream);
+		}
+		l_success = l_success && opj_encode(l_codec, l_stream) && opj_end_compress(l_codec, l_stream);
+		if (! l_success) {
+			fprintf(stderr, "ERROR -> test_encoder_next_frame: failed to encode frame %d\n", i);
+		}
+
+		opj_stream_destroy(l_stream);
+		opj_image_destroy(l_image);
+	}
+
+	opj_destroy_codec(l_codec);
+	return l_success;
+}
+
+/* checks that each frame is the codestream of a compressor set up for it alone */
+static int check_frames(const char * p_extension)
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	char l_file[64], l_ref_file[64];
+	OPJ_BYTE * l_data;
+	OPJ_BYTE * l_ref_data;
+	OPJ_UINT32 l_size = 0, l_ref_size = 0;
+	OPJ_UINT32 i;
+	int l_result = 0;
+
+	for (i=0;i<NB_FRAMES && l_result == 0;++i) {
+		sprintf(l_file, "test_encoder_next_frame_%d.%s", i, p_extension);
+		sprintf(l_ref_file, "test_encoder_next_frame_ref_%d.%s", i, p_extension);
+
+		l_image = create_frame(i);
+		if (! l_image) {
+			return 1;
+		}
+		set_parameters(&l_param);
+		if (! encode_image(l_ref_file, &l_param, l_image)) {
+			opj_image_destroy(l_image);
+			return 1;
+		}
+		opj_image_destroy(l_image);
+
+		l_data = read_file(l_file, &l_size);
+		l_ref_data = read_file(l_ref_file, &l_ref_size);
+		if (! l_data || ! l_ref_data || l_size != l_ref_size || memcmp(l_data, l_ref_data, l_size) != 0) {
+			fprintf(stderr, "ERROR -> test_encoder_next_frame: %s differs from %s\n", l_file, l_ref_file);
+			l_result = 1;
+		}
+		free(l_data);
+		free(l_ref_data);
+	}
+	return l_result;
+}
+
+int main (int argc, char *argv[])
+{
+	const char * l_extension;
+
+	/* should be test_encoder_next_frame 3 640 480 256 20 jp2 */
+	if( argc == 7 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		tile_size = (OPJ_UINT32)atoi( argv[4] );
+		rate = (float)atof( argv[5] );
+		l_extension = argv[6];
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 640;
+		image_height = 480;
+		tile_size = 256;
+		rate = 20.0f;
+		l_extension = "j2k";
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || strlen(l_extension) > 8 )
+	{
+		return 1;
+	}
+
+	/* frames of a sequence started with opj_encoder_next_frame, then with opj_start_compress */
+	if (! encode_frames(l_extension, OPJ_FALSE) || check_frames(l_extension)) {
+		return 1;
+	}
+	if (! encode_frames(l_extension, OPJ_TRUE) || check_frames(l_extension)) {
+		return 1;
+	}
+	return 0;
+}
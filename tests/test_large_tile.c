@@ -0,0 +1,190 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* memory given to the decoder, far below the size of the tile */
+#define MEMORY_LIMIT (64 * 1024 * 1024)
+
+static OPJ_UINT32 nb_memory_errors = 0;
+
+/* records the failures to allocate the data of the tile */
+static void memory_error_callback(const char *msg, void *client_data)
+{
+	(void)client_data;
+	if (strstr(msg, "Not enough memory for tile data")) {
+		++nb_memory_errors;
+	}
+	fprintf(stdout, "[ERROR] %s", msg);
+}
+
+static void write_value(OPJ_BYTE * p_data, OPJ_UINT32 p_value)
+{
+	p_data[0] = (OPJ_BYTE)(p_value >> 24);
+	p_data[1] = (OPJ_BYTE)(p_value >> 16);
+	p_data[2] = (OPJ_BYTE)(p_value >> 8);
+	p_data[3] = (OPJ_BYTE)p_value;
+}
+
+/* makes the image and its single tile p_tile_size x p_tile_size in the SIZ marker. Returns 0 on failure */
+static int enlarge_tile(OPJ_BYTE * p_data, OPJ_UINT32 p_size, OPJ_UINT32 p_tile_size)
+{
+	OPJ_UINT32 l_pos;
+
+	for (l_pos = 0; l_pos + 42 <= p_size; ++l_pos) {
+		if (p_data[l_pos] == 0xFF && p_data[l_pos + 1] == 0x51) {
+			write_value(p_data + l_pos + 6, p_tile_size);	/* Xsiz */
+			write_value(p_data + l_pos + 10, p_tile_size);	/* Ysiz */
+			write_value(p_data + l_pos + 22, p_tile_size);	/* XTsiz */
+			write_value(p_data + l_pos + 26, p_tile_size);	/* YTsiz */
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 l_tile_index, l_nb_comps;
+	OPJ_SIZE_T l_data_size = 0;
+	OPJ_INT32 l_tile_x0, l_tile_y0, l_tile_x1, l_tile_y1;
+	OPJ_BOOL l_go_on = OPJ_TRUE;
+	FILE * l_file;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 tile_size;
+	char output_file[64];
+
+	/* should be test_large_tile 4 65536 tlt1.j2k */
+	if( argc == 4 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		tile_size = (OPJ_UINT32)atoi( argv[2] );
+		strcpy(output_file, argv[3] );
+	}
+	else
+	{
+		num_comps = 4;
+		tile_size = 65536;
+		strcpy(output_file, "test_large_tile.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || tile_size == 0 )
+	{
+		return 1;
+	}
+
+	/* a small image of a single tile, whose size is then changed in the SIZ marker: the
+	   tile data of the code-stream is not read, the decoder fails before */
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 0;
+	l_image = create_image(num_comps, 0, 0, 64, 64, 1);
+	if (! l_image || ! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+	l_image = 00;
+
+	l_data = read_file(output_file, &l_size);
+	if (! l_data || ! enlarge_tile(l_data, l_size, tile_size)) {
+		fprintf(stderr, "ERROR -> test_large_tile: failed to change the tile size of %s!\n", output_file);
+		return 1;
+	}
+	l_file = fopen(output_file, "wb");
+	if (! l_file || fwrite(l_data, 1, l_size, l_file) != l_size) {
+		fprintf(stderr, "ERROR -> test_large_tile: failed to write %s!\n", output_file);
+		return 1;
+	}
+	fclose(l_file);
+	free(l_data);
+
+	/* the samples of the tile do not fit in 32 bits: the whole tile is allocated and the
+	   allocation fails, instead of being truncated to a size which fits */
+	l_codec = create_decoder(output_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 1;
+	}
+	if (l_image->x1 != tile_size || l_image->y1 != tile_size) {
+		fprintf(stderr, "ERROR -> test_large_tile: the image of %s is %dx%d\n", output_file, l_image->x1, l_image->y1);
+		l_nb_errors = 1;
+	}
+	opj_set_error_handler(l_codec, memory_error_callback, 00);
+	opj_set_memory_limit(l_codec, MEMORY_LIMIT);
+	if (opj_read_tile_header(l_codec, l_stream, &l_tile_index, &l_data_size, &l_tile_x0, &l_tile_y0,
+	                         &l_tile_x1, &l_tile_y1, &l_nb_comps, &l_go_on)) {
+		fprintf(stderr, "ERROR -> test_large_tile: the header of the tile of %s was read within %d bytes\n", output_file, MEMORY_LIMIT);
+		l_nb_errors = 1;
+	}
+	else if (nb_memory_errors != 1) {
+		fprintf(stderr, "ERROR -> test_large_tile: the tile data of %s was not rejected\n", output_file);
+		l_nb_errors = 1;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	l_image = 00;
+
+	/* same for the whole image */
+	nb_memory_errors = 0;
+	l_codec = create_decoder(output_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 1;
+	}
+	opj_set_error_handler(l_codec, memory_error_callback, 00);
+	opj_set_memory_limit(l_codec, MEMORY_LIMIT);
+	if (opj_decode(l_codec, l_stream, l_image)) {
+		fprintf(stderr, "ERROR -> test_large_tile: %s was decoded within %d bytes\n", output_file, MEMORY_LIMIT);
+		l_nb_errors = 1;
+	}
+	else if (nb_memory_errors != 1) {
+		fprintf(stderr, "ERROR -> test_large_tile: the tile data of %s was not rejected\n", output_file);
+		l_nb_errors = 1;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+
+	return l_nb_errors ? 1 : 0;
+}
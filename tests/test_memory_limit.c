@@ -0,0 +1,219 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* bytes of the decoded samples of the image */
+static OPJ_SIZE_T image_size(const opj_image_t * p_image)
+{
+	OPJ_SIZE_T l_size = 0;
+	OPJ_UINT32 compno;
+
+	for (compno=0;compno<p_image->numcomps;++compno) {
+		l_size += (OPJ_SIZE_T)p_image->comps[compno].w * p_image->comps[compno].h * sizeof(OPJ_INT32);
+	}
+	return l_size;
+}
+
+/* decodes the whole image and checks that the peak memory of the codec includes the decoded samples */
+static int check_peak(const char * input_file)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	opj_codestream_info_v2_t * l_info;
+	int l_result = 1;
+
+	l_codec = create_decoder(input_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 1;
+	}
+	if (opj_decode(l_codec, l_stream, l_image) && opj_end_decompress(l_codec, l_stream)) {
+		l_info = opj_get_cstr_info(l_codec);
+		if (l_info) {
+			if (l_info->mem_peak < image_size(l_image)) {
+				fprintf(stderr, "ERROR -> test_memory_limit: peak of %lu bytes below the %lu bytes of the samples\n",
+					(unsigned long)l_info->mem_peak, (unsigned long)image_size(l_image));
+			}
+			else {
+				l_result = 0;
+			}
+			opj_destroy_cstr_info(&l_info);
+		}
+	}
+	else {
+		fprintf(stderr, "ERROR -> test_memory_limit: failed to decode %s without limit\n", input_file);
+	}
+
+	opj_image_destroy(l_image);
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_result;
+}
+
+/* peak memory of a decoding of the whole image, within a time budget large enough for all the resolutions if p_budget */
+static OPJ_SIZE_T decode_peak(const char * input_file, OPJ_BOOL p_budget, OPJ_SIZE_T * p_image_size)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	OPJ_SIZE_T l_peak = 0;
+	OPJ_BOOL l_success;
+
+	l_codec = create_decoder(input_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 0;
+	}
+	l_success = p_budget ? opj_decode_within_budget(l_codec, l_stream, l_image, 1000.0, 00) :
+		opj_decode(l_codec, l_stream, l_image);
+	if (l_success && opj_end_decompress(l_codec, l_stream)) {
+		opj_get_memory_usage(l_codec, 00, &l_peak);
+		*p_image_size = image_size(l_image);
+	}
+
+	opj_image_destroy(l_image);
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_peak;
+}
+
+/* decodes the image one resolution after the other: the samples of each resolution are freed once the next
+   one is decoded, only the previous resolution (a quarter of the samples) may add to the peak of opj_decode */
+static int check_budget_peak(const char * input_file)
+{
+	OPJ_SIZE_T l_image_size = 0;
+	OPJ_SIZE_T l_peak = decode_peak(input_file, OPJ_FALSE, &l_image_size);
+	OPJ_SIZE_T l_budget_peak = decode_peak(input_file, OPJ_TRUE, &l_image_size);
+
+	if (! l_peak || ! l_budget_peak) {
+		fprintf(stderr, "ERROR -> test_memory_limit: failed to decode %s\n", input_file);
+		return 1;
+	}
+	if (l_budget_peak > l_peak + l_image_size / 4 + l_image_size / 32) {
+		fprintf(stderr, "ERROR -> test_memory_limit: peak of %lu bytes resolution after resolution against %lu bytes at once\n",
+			(unsigned long)l_budget_peak, (unsigned long)l_peak);
+		return 1;
+	}
+	return 0;
+}
+
+/* decodes the image with a limit below the size of its samples, which must fail */
+static int check_limit(const char * input_file)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	OPJ_SIZE_T l_limit, l_current;
+	int l_result = 0;
+
+	l_codec = create_decoder(input_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 1;
+	}
+	l_limit = image_size(l_image) - 1;
+	opj_set_memory_limit(l_codec, l_limit);
+
+	if (opj_decode(l_codec, l_stream, l_image)) {
+		fprintf(stderr, "ERROR -> test_memory_limit: decoded %s within %lu bytes\n", input_file, (unsigned long)l_limit);
+		l_result = 1;
+	}
+	opj_get_memory_usage(l_codec, &l_current, 00);
+	if (l_current > l_limit) {
+		fprintf(stderr, "ERROR -> test_memory_limit: %lu bytes allocated above the limit\n", (unsigned long)l_current);
+		l_result = 1;
+	}
+
+	opj_image_destroy(l_image);
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	return l_result;
+}
+
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	char output_file[64];
+
+	/* should be test_memory_limit 3 1000 700 tml1.j2k */
+	if( argc == 5 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		strcpy(output_file, argv[4] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		strcpy(output_file, "test_memory_limit.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 0;
+	l_param.numresolution = 3;
+	/* small tiles keep the working memory of the codec well below the size of the samples */
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = 128;
+	l_param.cp_tdy = 128;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	if (check_peak(output_file) || check_limit(output_file) || check_budget_peak(output_file)) {
+		return 1;
+	}
+	return 0;
+}
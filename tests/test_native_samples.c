@@ -0,0 +1,212 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* value of the sample (x,y) of a component of precision prec, spread over the whole range of the component */
+static OPJ_INT32 native_value(OPJ_UINT32 compno, OPJ_UINT32 x, OPJ_UINT32 y, OPJ_UINT32 prec, OPJ_UINT32 sgnd)
+{
+	OPJ_INT32 l_value = sample_value(compno, x, y) << (prec - 8);
+
+	return sgnd ? l_value - (1 << (prec - 1)) : l_value;
+}
+
+/* value of the i-th sample of a component stored at its native width */
+static OPJ_INT32 get_native_sample(const opj_image_comp_t * p_comp, OPJ_UINT32 i)
+{
+	if (p_comp->native_size == 1) {
+		return p_comp->sgnd ? ((const OPJ_INT8 *) p_comp->native_data)[i] : ((const OPJ_UINT8 *) p_comp->native_data)[i];
+	}
+	return p_comp->sgnd ? ((const OPJ_INT16 *) p_comp->native_data)[i] : ((const OPJ_UINT16 *) p_comp->native_data)[i];
+}
+
+/* creates the image to encode, with its samples stored at their native width */
+static opj_image_t * create_native_image(OPJ_UINT32 num_comps, OPJ_UINT32 image_width, OPJ_UINT32 image_height, OPJ_UINT32 prec, OPJ_UINT32 sgnd)
+{
+	opj_image_t * l_image;
+	opj_image_cmptparm_t l_params [NUM_COMPS_MAX];
+	OPJ_UINT32 i, y, x, compno;
+
+	set_component_params(l_params, num_comps, 0, 0, image_width, image_height, 1);
+	for (i=0;i<num_comps;++i) {
+		l_params[i].prec = prec;
+		l_params[i].bpp = prec;
+		l_params[i].sgnd = sgnd;
+	}
+	l_image = opj_image_create_native(num_comps,l_params,(num_comps >= 3) ? OPJ_CLRSPC_SRGB : OPJ_CLRSPC_GRAY);
+	if (! l_image) {
+		return 00;
+	}
+	l_image->x0 = 0;
+	l_image->y0 = 0;
+	l_image->x1 = image_width;
+	l_image->y1 = image_height;
+
+	for (compno=0;compno<num_comps;++compno) {
+		opj_image_comp_t * l_comp = &(l_image->comps[compno]);
+
+		for (y=0;y<l_comp->h;++y) {
+			for (x=0;x<l_comp->w;++x) {
+				OPJ_INT32 l_value = native_value(compno,x,y,prec,sgnd);
+				OPJ_UINT32 l_index = y * l_comp->w + x;
+
+				if (l_comp->native_size == 1) {
+					((OPJ_UINT8 *) l_comp->native_data)[l_index] = (OPJ_UINT8) l_value;
+				}
+				else {
+					((OPJ_UINT16 *) l_comp->native_data)[l_index] = (OPJ_UINT16) l_value;
+				}
+			}
+		}
+	}
+	return l_image;
+}
+
+/* number of samples stored at their native width in p_image which differ from the OPJ_INT32 ones of p_ref, or from the encoded ones if p_lossless */
+static OPJ_UINT32 check_native_image(const opj_image_t * p_image, const opj_image_t * p_ref, OPJ_UINT32 prec, OPJ_BOOL p_lossless)
+{
+	OPJ_UINT32 compno, y, x;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	if (p_image->numcomps != p_ref->numcomps) {
+		return 1;
+	}
+	for (compno=0;compno<p_ref->numcomps;++compno) {
+		const opj_image_comp_t * l_comp = &(p_image->comps[compno]);
+		const opj_image_comp_t * l_ref = &(p_ref->comps[compno]);
+
+		if (l_comp->native_size != ((prec <= 8) ? 1U : 2U) || ! l_comp->native_data || l_comp->data ||
+			l_ref->native_size != 0 || ! l_ref->data ||
+			l_comp->w != l_ref->w || l_comp->h != l_ref->h) {
+			fprintf(stderr, "ERROR -> test_native_samples: unexpected storage of the component %d\n", compno);
+			++l_nb_errors;
+			continue;
+		}
+		for (y=0;y<l_ref->h;++y) {
+			for (x=0;x<l_ref->w;++x) {
+				OPJ_UINT32 l_index = y * l_ref->w + x;
+				OPJ_INT32 l_value = get_native_sample(l_comp, l_index);
+
+				if (l_value != l_ref->data[l_index] ||
+					(p_lossless && l_value != native_value(compno, x, y, prec, l_ref->sgnd))) {
+					++l_nb_errors;
+				}
+			}
+		}
+	}
+	return l_nb_errors;
+}
+
+/* encodes an image given at its native width, then decodes it at its native width and as OPJ_INT32 samples and compares both */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_dparameters_t l_dparam;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	OPJ_UINT32 l_nb_errors;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 prec;
+	OPJ_UINT32 sgnd;
+	OPJ_UINT32 irreversible;
+	char output_file[64];
+
+	/* should be test_native_samples 3 1000 700 16 0 0 tns1.j2k */
+	if( argc == 8 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		prec = (OPJ_UINT32)atoi( argv[4] );
+		sgnd = (OPJ_UINT32)atoi( argv[5] );
+		irreversible = (OPJ_UINT32)atoi( argv[6] );
+		strcpy(output_file, argv[7] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		prec = 8;
+		sgnd = 0;
+		irreversible = 0;
+		strcpy(output_file, "test_native_samples.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || prec < 8 || prec > 16 || sgnd > 1 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+
+	l_image = create_native_image(num_comps, image_width, image_height, prec, sgnd);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	opj_set_default_decoder_parameters(&l_dparam);
+	l_dparam.flags |= OPJ_DPARAMETERS_NATIVE_SAMPLES_FLAG;
+	l_image = decode_image_with_parameters(output_file, &l_dparam);
+	l_ref = decode_image(output_file, 0, 0);
+	if (! l_image || ! l_ref) {
+		fprintf(stderr, "ERROR -> test_native_samples: failed to decode %s!\n", output_file);
+		opj_image_destroy(l_image);
+		opj_image_destroy(l_ref);
+		return 1;
+	}
+	l_nb_errors = check_native_image(l_image, l_ref, prec, ! irreversible);
+	opj_image_destroy(l_ref);
+	opj_image_destroy(l_image);
+
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_native_samples: %d samples differ from the OPJ_INT32 ones\n", l_nb_errors);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_CASES 4
+#define NUM_LAYERS 20
+
+/* parameters of each case: many layers and precincts, whose packets the PLT markers locate */
+static void set_parameters(OPJ_UINT32 p_case, opj_cparameters_t * p_param)
+{
+	OPJ_UINT32 i;
+
+	opj_set_default_encoder_parameters(p_param);
+	/* compression ratios 30, 15, 10, 7.5... down to 1.5 */
+	p_param->tcp_numlayers = NUM_LAYERS;
+	for (i = 0; i < NUM_LAYERS; ++i) {
+		p_param->tcp_rates[i] = 30.0f / (float)(i + 1);
+	}
+	p_param->cp_disto_alloc = 1;
+	p_param->tile_size_on = OPJ_TRUE;
+	p_param->cp_tdx = 128;
+	p_param->cp_tdy = 96;
+	p_param->cblockw_init = 16;
+	p_param->cblockh_init = 16;
+	p_param->csty |= 0x01;
+	p_param->res_spec = 1;
+	p_param->prcw_init[0] = 32;
+	p_param->prch_init[0] = 32;
+	p_param->plt_on = OPJ_TRUE;
+
+	switch (p_case) {
+	case 1:
+		/* SOP and EPH markers, counted in the lengths of the packets: a precinct per resolution, the
+		   markers of so many packets would not fit in the tile */
+		p_param->prog_order = OPJ_RPCL;
+		p_param->csty = 0x02 | 0x04;
+		p_param->res_spec = 0;
+		break;
+	case 2:
+		/* the packets of a tile spread over several tile-parts */
+		p_param->prog_order = OPJ_RLCP;
+		p_param->tp_on = 1;
+		p_param->tp_flag = 'R';
+		break;
+	case 3:
+		p_param->prog_order = OPJ_CPRL;
+		p_param->irreversible = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+/* positions of the PLT markers of the tile-part headers of the codestream, returns their number */
+static OPJ_UINT32 find_plt_markers(const OPJ_BYTE * p_data, OPJ_UINT32 p_size, OPJ_UINT32 * p_positions, OPJ_UINT32 p_max_markers)
+{
+	OPJ_UINT32 l_nb_markers = 0;
+	OPJ_UINT32 l_pos = 2;
+	OPJ_UINT32 l_marker, l_length;
+
+	while (l_pos + 4 <= p_size && (l_marker = read_value(p_data + l_pos, 2)) != 0xffd9) {
+		l_length = read_value(p_data + l_pos + 2, 2);
+		if (l_marker == 0xff90) {
+			/* the markers of the tile-part header, up to its SOD marker */
+			OPJ_UINT32 l_psot = read_value(p_data + l_pos + 6, 4);
+			OPJ_UINT32 l_header = l_pos + 2 + l_length;
+
+			while (l_header + 4 <= p_size && (l_marker = read_value(p_data + l_header, 2)) != 0xff93) {
+				if (l_marker == 0xff58 && l_nb_markers < p_max_markers) {
+					p_positions[l_nb_markers++] = l_header;
+				}
+				l_header += 2 + read_value(p_data + l_header + 2, 2);
+			}
+			if (l_psot == 0 || l_psot > p_size - l_pos) {
+				break;
+			}
+			l_pos += l_psot;
+		}
+		else {
+			l_pos += 2 + l_length;
+		}
+	}
+	return l_nb_markers;
+}
+
+/* copies the codestream of input_file into output_file, with its PLT markers out of order if p_ignore_plt, or
+   with the lengths of two packets of its first PLT marker changed, keeping their sum */
+static OPJ_BOOL alter_plt_markers(const char * input_file, const char * output_file, OPJ_BOOL p_ignore_plt)
+{
+	OPJ_UINT32 l_positions[256];
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_nb_markers, i;
+	OPJ_BOOL l_done = OPJ_FALSE;
+	FILE * l_file;
+
+	l_data = read_file(input_file, &l_size);
+	if (! l_data) {
+		return OPJ_FALSE;
+	}
+	l_nb_markers = find_plt_markers(l_data, l_size, l_positions, 256);
+
+	if (p_ignore_plt) {
+		/* the decoder expects Zplt 0 at the start of each tile-part header */
+		for (i = 0; i < l_nb_markers; ++i) {
+			if (l_data[l_positions[i] + 4] == 0) {
+				l_data[l_positions[i] + 4] = 1;
+				l_done = OPJ_TRUE;
+			}
+		}
+	}
+	else if (l_nb_markers) {
+		/* the last byte of a length holds its 7 least significant bits: a packet one byte longer, then
+		   a packet one byte shorter, but not empty */
+		OPJ_UINT32 l_end = l_positions[0] + 2 + read_value(l_data + l_positions[0] + 2, 2);
+		OPJ_UINT32 l_first = l_positions[0] + 5;
+		OPJ_UINT32 l_second;
+
+		while (l_first < l_end && (l_data[l_first] & 0x80)) {
+			++l_first;
+		}
+		for (; ! l_done && l_first < l_end; l_first = l_second) {
+			l_second = l_first + 1;
+			while (l_second < l_end && (l_data[l_second] & 0x80)) {
+				++l_second;
+			}
+			if (l_second < l_end && l_data[l_first] < 0x7f && l_data[l_second] > 0x01) {
+				++l_data[l_first];
+				--l_data[l_second];
+				l_done = OPJ_TRUE;
+			}
+		}
+	}
+
+	l_file = fopen(output_file, "wb");
+	if (! l_file || fwrite(l_data, 1, l_size, l_file) != l_size) {
+		l_done = OPJ_FALSE;
+	}
+	if (l_file) {
+		fclose(l_file);
+	}
+	free(l_data);
+	return l_done;
+}
+
+/* encodes the image with the parameters of p_case, then compares its decodings with those of the same codestream whose PLT markers are ignored */
+static OPJ_UINT32 check_case(OPJ_UINT32 p_case, const char * output_file)
+{
+	static const OPJ_INT32 l_area[4] = { 100, 70, 230, 170 };
+	char l_ref_file[256];
+	const char * l_ext;
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	OPJ_UINT32 l_reduce, l_layers;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	/* the same codestream with its PLT markers ignored, in output_file followed by _ref before its extension */
+	l_ext = strrchr(output_file, '.');
+	if (! l_ext || strlen(output_file) + 5 > sizeof(l_ref_file)) {
+		return 1;
+	}
+	sprintf(l_ref_file, "%.*s_ref%s", (int)(l_ext - output_file), output_file, l_ext);
+
+	set_parameters(p_case, &l_param);
+	l_image = create_image(3, 0, 0, 256, 192, 1);
+	if (! l_image || ! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+	if (! alter_plt_markers(output_file, l_ref_file, OPJ_TRUE)) {
+		fprintf(stderr, "ERROR -> test_packet_lengths: case %d: no PLT marker in %s\n", p_case, output_file);
+		return 1;
+	}
+
+	/* all the layers, then some of them, at full and reduced resolution */
+	for (l_reduce = 0; l_reduce <= 1; ++l_reduce) {
+		for (l_layers = 0; l_layers < NUM_LAYERS; l_layers += NUM_LAYERS / 4) {
+			l_image = decode_image(output_file, l_reduce, l_layers);
+			l_ref = decode_image(l_ref_file, l_reduce, l_layers);
+			if (! l_image || ! l_ref || compare_images(l_image, l_ref)) {
+				fprintf(stderr, "ERROR -> test_packet_lengths: case %d: %s decoded with reduce %d and %d layers differs from %s\n",
+				        p_case, output_file, l_reduce, l_layers, l_ref_file);
+				++l_nb_errors;
+			}
+			opj_image_destroy(l_image);
+			opj_image_destroy(l_ref);
+		}
+	}
+
+	l_image = decode_area(output_file, 0, l_area);
+	l_ref = decode_area(l_ref_file, 0, l_area);
+	if (! l_image || ! l_ref || compare_images(l_image, l_ref)) {
+		fprintf(stderr, "ERROR -> test_packet_lengths: case %d: area of %s differs from %s\n", p_case, output_file, l_ref_file);
+		++l_nb_errors;
+	}
+	opj_image_destroy(l_image);
+	opj_image_destroy(l_ref);
+
+	/* packets whose lengths do not match the PLT markers are reported, not read beyond their length */
+	if (! alter_plt_markers(output_file, l_ref_file, OPJ_FALSE)) {
+		fprintf(stderr, "ERROR -> test_packet_lengths: case %d: no packet length to alter in %s\n", p_case, output_file);
+		return l_nb_errors + 1;
+	}
+	l_image = decode_image(l_ref_file, 0, 0);
+	if (l_image) {
+		fprintf(stderr, "ERROR -> test_packet_lengths: case %d: %s decoded with wrong packet lengths\n", p_case, l_ref_file);
+		opj_image_destroy(l_image);
+		++l_nb_errors;
+	}
+
+	return l_nb_errors;
+}
+
+/* decodes images whose packets are located by the PLT markers, then checks that they are the same as without the markers */
+int main (int argc, char *argv[])
+{
+	OPJ_UINT32 l_case;
+	OPJ_UINT32 l_nb_errors = 0;
+	char output_file[64];
+
+	/* should be test_packet_lengths 1 tpl1.j2k, to check a single case */
+	if( argc == 3 )
+	{
+		l_case = (OPJ_UINT32)atoi( argv[1] );
+		if( l_case >= NUM_CASES || strlen( argv[2] ) >= sizeof(output_file) )
+		{
+			return 1;
+		}
+		strcpy(output_file, argv[2] );
+		return check_case(l_case, output_file) ? 1 : 0;
+	}
+
+	for (l_case = 0; l_case < NUM_CASES; ++l_case) {
+		sprintf(output_file, "test_packet_lengths%d.j2k", l_case);
+		l_nb_errors += check_case(l_case, output_file);
+	}
+	return l_nb_errors ? 1 : 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_LAYERS 3
+
+/* checks the byte ranges of the packet map against the SOP marker which starts each packet, returns the number of errors */
+static OPJ_UINT32 check_packet_map(const opj_packet_map_t * p_packet_map, const OPJ_BYTE * p_data, OPJ_UINT32 p_size)
+{
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 i;
+
+	if (! p_packet_map->nb_packets) {
+		fprintf(stderr, "ERROR -> test_packet_map: no packet found\n");
+		return 1;
+	}
+	for (i=0;i<p_packet_map->nb_packets;++i) {
+		const opj_packet_range_t * l_range = &p_packet_map->packets[i];
+		const opj_packet_range_t * l_previous = i ? &p_packet_map->packets[i - 1] : 00;
+		OPJ_UINT32 l_end;
+		OPJ_UINT32 l_next;
+
+		if (l_range->start_pos < 0 || l_range->length < 6 || (OPJ_UINT64)l_range->start_pos + l_range->length + 2 > p_size) {
+			fprintf(stderr, "ERROR -> test_packet_map: packet %d out of the file\n", i);
+			return l_nb_errors + 1;
+		}
+		/* each packet starts with a SOP marker giving its index in the tile */
+		if (read_value(p_data + l_range->start_pos, 2) != 0xff91) {
+			fprintf(stderr, "ERROR -> test_packet_map: packet %d does not start with a SOP marker\n", i);
+			++l_nb_errors;
+			continue;
+		}
+		if (l_previous && l_previous->tileno == l_range->tileno &&
+			read_value(p_data + l_range->start_pos + 4, 2) != ((read_value(p_data + l_previous->start_pos + 4, 2) + 1) & 0xffff)) {
+			fprintf(stderr, "ERROR -> test_packet_map: packet %d does not follow packet %d in tile %d\n", i, i - 1, l_range->tileno);
+			++l_nb_errors;
+		}
+		if (l_previous && l_previous->tileno > l_range->tileno) {
+			fprintf(stderr, "ERROR -> test_packet_map: packet %d is not sorted by tile\n", i);
+			++l_nb_errors;
+		}
+		/* and ends before another packet, tile-part or the end of the codestream */
+		l_end = (OPJ_UINT32)l_range->start_pos + l_range->length;
+		l_next = read_value(p_data + l_end, 2);
+		if (l_next != 0xff91 && l_next != 0xff90 && l_next != 0xffd9) {
+			fprintf(stderr, "ERROR -> test_packet_map: packet %d does not end before a marker\n", i);
+			++l_nb_errors;
+		}
+	}
+	return l_nb_errors;
+}
+
+/* encodes a tiled image with SOP markers, then maps its packets and checks them against the markers */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image;
+	opj_packet_map_t * l_packet_map = 00;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_nb_errors;
+	OPJ_BOOL l_success;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_PROG_ORDER prog_order;
+	char output_file[64];
+
+	/* should be test_packet_map 3 1000 700 256 256 2 tpm1.j2k */
+	if( argc == 8 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		tile_width = (OPJ_UINT32)atoi( argv[4] );
+		tile_height = (OPJ_UINT32)atoi( argv[5] );
+		prog_order = (OPJ_PROG_ORDER)atoi( argv[6] );
+		strcpy(output_file, argv[7] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		tile_width = 256;
+		tile_height = 256;
+		prog_order = OPJ_RPCL;
+		strcpy(output_file, "test_packet_map.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 || prog_order < OPJ_LRCP || prog_order > OPJ_CPRL )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = NUM_LAYERS;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 40;
+	l_param.tcp_rates[1] = 10;
+	l_param.tcp_rates[2] = 0;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	l_param.prog_order = prog_order;
+	l_param.csty |= 0x02;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	l_codec = create_decoder(output_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_packet_map: failed to read the header of %s!\n", output_file);
+		return 1;
+	}
+	l_success = opj_get_packet_map(l_codec, l_stream, &l_packet_map);
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	if (! l_success) {
+		fprintf(stderr, "ERROR -> test_packet_map: failed to map the packets of %s!\n", output_file);
+		return 1;
+	}
+
+	l_data = read_file(output_file, &l_size);
+	if (! l_data) {
+		fprintf(stderr, "ERROR -> test_packet_map: failed to read %s!\n", output_file);
+		opj_destroy_packet_map(&l_packet_map);
+		return 1;
+	}
+	l_nb_errors = check_packet_map(l_packet_map, l_data, l_size);
+	free(l_data);
+	opj_destroy_packet_map(&l_packet_map);
+	return l_nb_errors ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_CASES 6
+#define NUM_LAYERS 3
+
+/* codestreams and decoded images of each case, as written and decoded before the packets of a tile were listed once */
+static const OPJ_UINT32 expected[NUM_CASES][4] = {
+	/* codestream size, codestream checksum, checksum of the first layer, checksum of all the layers */
+	{  40270, 0x93701249, 0x5f2616c2, 0xfb8fe071 },
+	{  42925, 0x8c2c84a7, 0xcbc495b9, 0xfb8fe071 },
+	{ 109077, 0x04fb3837, 0x61a10ce4, 0xfb8fe071 },
+	{  41295, 0x61663fc0, 0xe130e6fd, 0xfb8fe071 },
+	{  42295, 0x444a7558, 0xd745d2a7, 0xfb8fe071 },
+	{   7346, 0x9edcbc6b, 0xd52176cb, 0xd52176cb }
+};
+
+static void set_poc(opj_poc_t * p_poc, OPJ_UINT32 p_tile, OPJ_UINT32 p_resno0, OPJ_UINT32 p_compno0,
+                    OPJ_UINT32 p_layno1, OPJ_UINT32 p_resno1, OPJ_UINT32 p_compno1, OPJ_PROG_ORDER p_prg)
+{
+	p_poc->tile = p_tile;
+	p_poc->resno0 = p_resno0;
+	p_poc->compno0 = p_compno0;
+	p_poc->layno1 = p_layno1;
+	p_poc->resno1 = p_resno1;
+	p_poc->compno1 = p_compno1;
+	p_poc->prg1 = p_prg;
+}
+
+/* parameters of each case: progression order changes, tile-parts and a maximum size of the components (as in cinema profiles) */
+static void set_parameters(OPJ_UINT32 p_case, opj_cparameters_t * p_param)
+{
+	OPJ_UINT32 i;
+
+	opj_set_default_encoder_parameters(p_param);
+	p_param->tcp_numlayers = NUM_LAYERS;
+	p_param->cp_disto_alloc = 1;
+	p_param->tcp_rates[0] = 40;
+	p_param->tcp_rates[1] = 10;
+	p_param->tcp_rates[2] = 0;
+	p_param->numresolution = 4;
+	p_param->tile_size_on = OPJ_TRUE;
+	p_param->cp_tdx = 128;
+	p_param->cp_tdy = 96;
+	p_param->cblockw_init = 32;
+	p_param->cblockh_init = 32;
+	/* several precincts in each resolution */
+	p_param->csty |= 0x01;
+	p_param->res_spec = 4;
+	for (i = 0; i < 4; ++i) {
+		p_param->prcw_init[i] = 64;
+		p_param->prch_init[i] = 32;
+	}
+
+	switch (p_case) {
+	case 0:
+		/* progression order changes, in a single tile */
+		p_param->tile_size_on = OPJ_FALSE;
+		p_param->prog_order = OPJ_LRCP;
+		set_poc(&p_param->POC[0], 1, 0, 0, NUM_LAYERS, 2, 3, OPJ_RLCP);
+		set_poc(&p_param->POC[1], 1, 2, 0, NUM_LAYERS, 4, 1, OPJ_PCRL);
+		set_poc(&p_param->POC[2], 1, 2, 1, NUM_LAYERS, 4, 3, OPJ_CPRL);
+		p_param->numpocs = 3;
+		break;
+	case 1:
+		/* a tile-part per resolution */
+		p_param->prog_order = OPJ_RPCL;
+		p_param->tp_on = 1;
+		p_param->tp_flag = 'R';
+		break;
+	case 2:
+		/* a tile-part per component, with progression order changes in a single tile */
+		p_param->tile_size_on = OPJ_FALSE;
+		p_param->prog_order = OPJ_CPRL;
+		p_param->tp_on = 1;
+		p_param->tp_flag = 'C';
+		set_poc(&p_param->POC[0], 1, 0, 0, NUM_LAYERS, 2, 3, OPJ_CPRL);
+		set_poc(&p_param->POC[1], 1, 2, 0, NUM_LAYERS, 4, 3, OPJ_PCRL);
+		p_param->numpocs = 2;
+		break;
+	case 3:
+		/* a tile-part per layer, a precinct per resolution */
+		p_param->prog_order = OPJ_LRCP;
+		p_param->csty = 0;
+		p_param->tp_on = 1;
+		p_param->tp_flag = 'L';
+		break;
+	case 4:
+		/* a maximum size of the components, smaller than the first layers would take */
+		p_param->prog_order = OPJ_PCRL;
+		p_param->max_comp_size = 1500;
+		break;
+	default:
+		/* as in cinema profiles: a single layer, a tile-part per component and a maximum size of the components */
+		p_param->prog_order = OPJ_CPRL;
+		p_param->tcp_numlayers = 1;
+		p_param->tcp_rates[0] = 10;
+		p_param->tp_on = 1;
+		p_param->tp_flag = 'C';
+		p_param->max_comp_size = 1000;
+		break;
+	}
+}
+
+/* encodes the image with the parameters of p_case, then compares the codestream and its decoding with the expected ones */
+static OPJ_UINT32 check_case(OPJ_UINT32 p_case, const char * output_file)
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_values[4];
+	OPJ_UINT32 l_layers;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	set_parameters(p_case, &l_param);
+	l_image = create_image(3, 5, 3, 300, 200, 2);
+	if (! l_image || ! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	l_data = read_file(output_file, &l_size);
+	if (! l_data) {
+		return 1;
+	}
+	l_values[0] = l_size;
+	l_values[1] = checksum(2166136261U, l_data, l_size);
+	free(l_data);
+
+	for (l_layers = 1; l_layers <= 2; ++l_layers) {
+		/* the first layer, then all of them */
+		l_image = decode_image(output_file, 0, l_layers == 1 ? 1 : 0);
+		if (! l_image) {
+			return 1;
+		}
+		l_values[l_layers + 1] = image_checksum(l_image);
+		opj_image_destroy(l_image);
+	}
+
+	if (l_values[0] != expected[p_case][0] || l_values[1] != expected[p_case][1]) {
+		fprintf(stderr, "ERROR -> test_packet_order: case %d: %s is %d bytes of checksum 0x%08x instead of %d bytes of checksum 0x%08x\n",
+		        p_case, output_file, l_values[0], l_values[1], expected[p_case][0], expected[p_case][1]);
+		++l_nb_errors;
+	}
+	if (l_values[2] != expected[p_case][2] || l_values[3] != expected[p_case][3]) {
+		fprintf(stderr, "ERROR -> test_packet_order: case %d: the decoded images of %s have the checksums 0x%08x and 0x%08x instead of 0x%08x and 0x%08x\n",
+		        p_case, output_file, l_values[2], l_values[3], expected[p_case][2], expected[p_case][3]);
+		++l_nb_errors;
+	}
+	return l_nb_errors;
+}
+
+/* encodes an image with progression order changes, tile-parts and a maximum size of the components, then checks that the
+   packets of the codestreams and of their decoding follow the same order as before */
+int main (int argc, char *argv[])
+{
+	OPJ_UINT32 l_case;
+	OPJ_UINT32 l_nb_errors = 0;
+	char output_file[64];
+
+	/* should be test_packet_order 5 tpo1.j2k, to check a single case */
+	if( argc == 3 )
+	{
+		l_case = (OPJ_UINT32)atoi( argv[1] );
+		if( l_case >= NUM_CASES )
+		{
+			return 1;
+		}
+		strcpy(output_file, argv[2] );
+		return check_case(l_case, output_file) ? 1 : 0;
+	}
+
+	for (l_case = 0; l_case < NUM_CASES; ++l_case) {
+		sprintf(output_file, "test_packet_order%d.j2k", l_case);
+		l_nb_errors += check_case(l_case, output_file);
+	}
+	return l_nb_errors ? 1 : 0;
+}
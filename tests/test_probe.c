@@ -0,0 +1,237 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define IMAGE_X0 3
+#define IMAGE_Y0 5
+
+/* probes a file, returns OPJ_FALSE if the file cannot be opened or probed */
+static OPJ_BOOL probe_file(const char * input_file, opj_probe_info_t * p_info)
+{
+	opj_stream_t * l_stream;
+	OPJ_BOOL l_success;
+
+	l_stream = opj_stream_create_default_file_stream(input_file, OPJ_TRUE);
+	if (! l_stream) {
+		return OPJ_FALSE;
+	}
+	l_success = opj_probe(l_stream, p_info);
+	opj_stream_destroy(l_stream);
+	return l_success;
+}
+
+/* copies the first p_size bytes of input_file into output_file */
+static OPJ_BOOL truncate_file(const char * input_file, const char * output_file, size_t p_size)
+{
+	char l_data [256];
+	FILE * l_input;
+	FILE * l_output;
+	OPJ_BOOL l_success;
+
+	if (p_size > sizeof(l_data)) {
+		return OPJ_FALSE;
+	}
+	l_input = fopen(input_file, "rb");
+	if (! l_input) {
+		return OPJ_FALSE;
+	}
+	l_success = fread(l_data, 1, p_size, l_input) == p_size;
+	fclose(l_input);
+	l_output = l_success ? fopen(output_file, "wb") : 00;
+	if (! l_output) {
+		return OPJ_FALSE;
+	}
+	l_success = fwrite(l_data, 1, p_size, l_output) == p_size;
+	fclose(l_output);
+	return l_success;
+}
+
+/* compares the probe of a file to what a decompressor reads from its main header, returns the number of errors */
+static OPJ_UINT32 check_probe(const char * input_file, const opj_probe_info_t * p_info)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image = 00;
+	opj_codestream_info_v2_t * l_cstr_info;
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 i;
+	OPJ_BOOL l_mixed = OPJ_FALSE;
+	size_t len = strlen( input_file );
+
+	if( strcmp( input_file + len - 4, ".jp2" ) == 0 )
+	{
+		if (p_info->format != OPJ_CODEC_JP2 || p_info->color_space != ((p_info->numcomps >= 3) ? OPJ_CLRSPC_SRGB : OPJ_CLRSPC_GRAY)) {
+			fprintf(stderr, "ERROR -> test_probe: wrong format or colour space for %s\n", input_file);
+			++l_nb_errors;
+		}
+	}
+	else
+	{
+		if (p_info->format != OPJ_CODEC_J2K || p_info->color_space != OPJ_CLRSPC_UNSPECIFIED) {
+			fprintf(stderr, "ERROR -> test_probe: wrong format or colour space for %s\n", input_file);
+			++l_nb_errors;
+		}
+	}
+
+	l_codec = create_decoder(input_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_probe: failed to read the header of %s!\n", input_file);
+		return l_nb_errors + 1;
+	}
+	l_cstr_info = opj_get_cstr_info(l_codec);
+
+	for (i=1;i<l_image->numcomps;++i) {
+		if (l_image->comps[i].prec != l_image->comps[0].prec || l_image->comps[i].sgnd != l_image->comps[0].sgnd ||
+			l_image->comps[i].dx != l_image->comps[0].dx || l_image->comps[i].dy != l_image->comps[0].dy) {
+			l_mixed = OPJ_TRUE;
+		}
+	}
+	if (p_info->x0 != l_image->x0 || p_info->y0 != l_image->y0 ||
+		p_info->width != l_image->x1 - l_image->x0 || p_info->height != l_image->y1 - l_image->y0) {
+		fprintf(stderr, "ERROR -> test_probe: wrong image area\n");
+		++l_nb_errors;
+	}
+	if (p_info->numcomps != l_image->numcomps || p_info->prec != l_image->comps[0].prec || p_info->sgnd != l_image->comps[0].sgnd ||
+		p_info->dx != l_image->comps[0].dx || p_info->dy != l_image->comps[0].dy || p_info->mixed_comps != (OPJ_UINT32)l_mixed) {
+		fprintf(stderr, "ERROR -> test_probe: wrong components\n");
+		++l_nb_errors;
+	}
+	if (! l_cstr_info || p_info->tx0 != l_cstr_info->tx0 || p_info->ty0 != l_cstr_info->ty0 ||
+		p_info->tdx != l_cstr_info->tdx || p_info->tdy != l_cstr_info->tdy ||
+		p_info->tw != l_cstr_info->tw || p_info->th != l_cstr_info->th) {
+		fprintf(stderr, "ERROR -> test_probe: wrong tiles\n");
+		++l_nb_errors;
+	}
+	if (l_cstr_info && (p_info->numlayers != l_cstr_info->m_default_tile_info.numlayers ||
+		p_info->prog_order != l_cstr_info->m_default_tile_info.prg ||
+		p_info->numresolutions != l_cstr_info->m_default_tile_info.tccp_info[0].numresolutions ||
+		p_info->irreversible != (l_cstr_info->m_default_tile_info.tccp_info[0].qmfbid == 0))) {
+		fprintf(stderr, "ERROR -> test_probe: wrong coding style\n");
+		++l_nb_errors;
+	}
+
+	opj_destroy_cstr_info(&l_cstr_info);
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	return l_nb_errors;
+}
+
+/* encodes an image, probes it and compares the probe to the main header read by a decompressor */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_probe_info_t l_info;
+	opj_image_t * l_image;
+	OPJ_UINT32 l_nb_errors;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 num_resolutions;
+	OPJ_UINT32 irreversible;
+	char output_file[64];
+	char truncated_file[72];
+
+	/* should be test_probe 3 1000 700 256 256 5 1 tpr1.jp2 */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		tile_width = (OPJ_UINT32)atoi( argv[4] );
+		tile_height = (OPJ_UINT32)atoi( argv[5] );
+		num_resolutions = (OPJ_UINT32)atoi( argv[6] );
+		irreversible = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		tile_width = 256;
+		tile_height = 256;
+		num_resolutions = 6;
+		irreversible = 0;
+		strcpy(output_file, "test_probe.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 || num_resolutions == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 2;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 20;
+	l_param.tcp_rates[1] = 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	l_param.numresolution = (int)num_resolutions;
+	l_param.irreversible = (int)irreversible;
+	l_param.prog_order = OPJ_RLCP;
+
+	/* the image does not start at the origin and its components other than the first one are subsampled */
+	l_image = create_image(num_comps, IMAGE_X0, IMAGE_Y0, image_width, image_height, 2);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	if (! probe_file(output_file, &l_info)) {
+		fprintf(stderr, "ERROR -> test_probe: failed to probe %s!\n", output_file);
+		return 1;
+	}
+	l_nb_errors = check_probe(output_file, &l_info);
+
+	/* the start of the file, which ends before the COD marker segment, cannot be probed */
+	strcpy(truncated_file, output_file);
+	strcat(truncated_file, ".cut");
+	if (! truncate_file(output_file, truncated_file, 50) || probe_file(truncated_file, &l_info)) {
+		fprintf(stderr, "ERROR -> test_probe: probed a truncated %s\n", output_file);
+		++l_nb_errors;
+	}
+	return l_nb_errors ? 1 : 0;
+}
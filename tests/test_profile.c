@@ -0,0 +1,173 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* checks the stages and counters of a profile of a codec which coded p_nb_tiles tiles */
+static int check_profile(const opj_profile_t * p_profile, OPJ_UINT32 p_nb_tiles, OPJ_BOOL p_is_decoder)
+{
+	OPJ_UINT64 l_nb_code_blocks = 0;
+	OPJ_UINT32 i;
+
+	if (! p_profile) {
+		fprintf(stderr, "ERROR -> test_profile: no profile\n");
+		return 1;
+	}
+	if (p_profile->nb_tiles != p_nb_tiles) {
+		fprintf(stderr, "ERROR -> test_profile: %d tiles profiled instead of %d\n", p_profile->nb_tiles, p_nb_tiles);
+		return 1;
+	}
+
+	for (i=0;i<p_nb_tiles;++i) {
+		const opj_profile_stats_t * l_tile = &(p_profile->tiles[i]);
+
+		if (l_tile->nb_code_blocks == 0 || l_tile->nb_passes == 0 || l_tile->nb_bytes_copied == 0 ||
+			(p_is_decoder && l_tile->nb_bytes_read == 0)) {
+			fprintf(stderr, "ERROR -> test_profile: empty counters for tile %d\n", i);
+			return 1;
+		}
+		/* the MQ symbols are only counted by a library built with OPJ_PROFILE_MQ_SYMBOLS */
+		if (l_tile->nb_mq_symbols != 0 && l_tile->nb_mq_symbols < l_tile->nb_passes) {
+			fprintf(stderr, "ERROR -> test_profile: fewer MQ symbols than passes for tile %d\n", i);
+			return 1;
+		}
+		l_nb_code_blocks += l_tile->nb_code_blocks;
+	}
+
+	if (p_profile->total.nb_code_blocks != l_nb_code_blocks) {
+		fprintf(stderr, "ERROR -> test_profile: the total is not the sum of the tiles\n");
+		return 1;
+	}
+	if (p_profile->total.times[OPJ_PROFILE_T1] <= 0.0 || p_profile->total.times[OPJ_PROFILE_T2] <= 0.0 ||
+		p_profile->total.times[OPJ_PROFILE_DWT] <= 0.0) {
+		fprintf(stderr, "ERROR -> test_profile: stage not timed\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_stream_t * l_stream;
+	opj_image_t * l_image;
+	OPJ_UINT32 l_nb_tiles;
+	OPJ_BOOL l_success;
+	int l_result;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 tile_size;
+	char output_file[64];
+
+	/* should be test_profile 3 640 480 256 tpf1.j2k */
+	if( argc == 6 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		tile_size = (OPJ_UINT32)atoi( argv[4] );
+		strcpy(output_file, argv[5] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 640;
+		image_height = 480;
+		tile_size = 256;
+		strcpy(output_file, "test_profile.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || tile_size == 0 )
+	{
+		return 1;
+	}
+	l_nb_tiles = ceildiv(image_width, tile_size) * ceildiv(image_height, tile_size);
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 10;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_size;
+	l_param.cp_tdy = (int)tile_size;
+
+	/* encoder */
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	l_codec = create_compressor(output_file);
+	l_stream = opj_stream_create_default_file_stream(output_file, OPJ_FALSE);
+	if (! l_image || ! l_codec || ! l_stream) {
+		return 1;
+	}
+	l_success = opj_set_profiling(l_codec, OPJ_TRUE) &&
+		opj_setup_encoder(l_codec, &l_param, l_image) &&
+		opj_start_compress(l_codec, l_image, l_stream) &&
+		opj_encode(l_codec, l_stream) &&
+		opj_end_compress(l_codec, l_stream);
+	l_result = l_success ? check_profile(opj_get_profile(l_codec), l_nb_tiles, OPJ_FALSE) : 1;
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	if (l_result) {
+		fprintf(stderr, "ERROR -> test_profile: wrong profile of the compressor\n");
+		return 1;
+	}
+
+	/* decoder, profiling enabled once the header is read */
+	l_image = 00;
+	l_codec = create_decoder(output_file, 0, &l_stream, &l_image);
+	if (! l_codec) {
+		return 1;
+	}
+	l_success = opj_set_profiling(l_codec, OPJ_TRUE) &&
+		opj_decode(l_codec, l_stream, l_image) &&
+		opj_end_decompress(l_codec, l_stream);
+	l_result = l_success ? check_profile(opj_get_profile(l_codec), l_nb_tiles, OPJ_TRUE) : 1;
+
+	/* disabling the profiling releases it */
+	if (! opj_set_profiling(l_codec, OPJ_FALSE) || opj_get_profile(l_codec) != 00) {
+		l_result = 1;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+	if (l_result) {
+		fprintf(stderr, "ERROR -> test_profile: wrong profile of the decompressor\n");
+		return 1;
+	}
+	return 0;
+}
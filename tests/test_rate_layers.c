@@ -0,0 +1,162 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_CASES 6
+#define NUM_LAYERS_MAX 6
+
+/* layers of each case, and the codestream written for it before the packets were encoded by the jobs of their precincts */
+static const struct {
+	OPJ_UINT32 numlayers;
+	float rates[NUM_LAYERS_MAX];
+	OPJ_UINT32 size;
+	OPJ_UINT32 checksum;
+} cases[NUM_CASES] = {
+	{ 1, { 20 },                     18000, 0x35f115a3 },
+	{ 3, { 40, 10, 2 },             147530, 0x87148203 },
+	{ 6, { 80, 40, 20, 10, 5, 2 },  151957, 0x9fbd6fd4 },
+	{ 4, { 30, 15, 8, 0 },          207133, 0x3292f989 },
+	{ 3, { 50, 20, 5 },              71894, 0x71c56c16 },
+	{ 2, { 30, 40 },                 80279, 0xe73c71d2 }
+};
+
+/* parameters of each case: the rate allocation runs for every layer but a lossless last one */
+static void set_parameters(OPJ_UINT32 p_case, opj_cparameters_t * p_param)
+{
+	OPJ_UINT32 i;
+
+	opj_set_default_encoder_parameters(p_param);
+	p_param->tcp_numlayers = (int)cases[p_case].numlayers;
+	for (i = 0; i < cases[p_case].numlayers; ++i) {
+		p_param->tcp_rates[i] = cases[p_case].rates[i];
+	}
+	p_param->cp_disto_alloc = 1;
+	p_param->tile_size_on = OPJ_TRUE;
+	p_param->cp_tdx = 200;
+	p_param->cp_tdy = 150;
+
+	switch (p_case) {
+	case 2:
+		/* SOP and EPH markers, counted in the rate */
+		p_param->prog_order = OPJ_RPCL;
+		p_param->csty |= 0x02 | 0x04;
+		break;
+	case 3:
+		/* many precincts and code-blocks */
+		p_param->prog_order = OPJ_PCRL;
+		p_param->cblockw_init = 16;
+		p_param->cblockh_init = 16;
+		p_param->csty |= 0x01;
+		p_param->res_spec = 1;
+		p_param->prcw_init[0] = 32;
+		p_param->prch_init[0] = 32;
+		break;
+	case 4:
+		p_param->prog_order = OPJ_CPRL;
+		p_param->irreversible = 1;
+		break;
+	case 5:
+		/* layers of a given quality instead of a given rate */
+		p_param->cp_disto_alloc = 0;
+		p_param->cp_fixed_quality = 1;
+		for (i = 0; i < cases[p_case].numlayers; ++i) {
+			p_param->tcp_distoratio[i] = cases[p_case].rates[i];
+			p_param->tcp_rates[i] = 0;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* encodes the image with the parameters of p_case, then compares the codestream with the expected one */
+static OPJ_UINT32 check_case(OPJ_UINT32 p_case, const char * output_file)
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_checksum;
+
+	set_parameters(p_case, &l_param);
+	l_image = create_image(3, 0, 0, 400, 300, 1);
+	if (! l_image || ! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	l_data = read_file(output_file, &l_size);
+	if (! l_data) {
+		return 1;
+	}
+	l_checksum = checksum(2166136261U, l_data, l_size);
+	free(l_data);
+
+	if (l_size != cases[p_case].size || l_checksum != cases[p_case].checksum) {
+		fprintf(stderr, "ERROR -> test_rate_layers: case %d: %s is %d bytes of checksum 0x%08x instead of %d bytes of checksum 0x%08x\n",
+		        p_case, output_file, l_size, l_checksum, cases[p_case].size, cases[p_case].checksum);
+		return 1;
+	}
+	return 0;
+}
+
+/* encodes an image with several layers at several rates, then checks that the codestreams are the same as before */
+int main (int argc, char *argv[])
+{
+	OPJ_UINT32 l_case;
+	OPJ_UINT32 l_nb_errors = 0;
+	char output_file[64];
+
+	/* should be test_rate_layers 3 trl1.j2k, to check a single case */
+	if( argc == 3 )
+	{
+		l_case = (OPJ_UINT32)atoi( argv[1] );
+		if( l_case >= NUM_CASES )
+		{
+			return 1;
+		}
+		strcpy(output_file, argv[2] );
+		return check_case(l_case, output_file) ? 1 : 0;
+	}
+
+	for (l_case = 0; l_case < NUM_CASES; ++l_case) {
+		sprintf(output_file, "test_rate_layers%d.j2k", l_case);
+		l_nb_errors += check_case(l_case, output_file);
+	}
+	return l_nb_errors ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* decoded image the strips are compared with */
+typedef struct strip_check
+{
+	opj_image_t * image;
+	OPJ_UINT32 next_row[NUM_COMPS_MAX];
+	OPJ_UINT32 nb_errors;
+} strip_check_t;
+
+static OPJ_BOOL check_strip(OPJ_UINT32 p_compno, OPJ_UINT32 p_row, OPJ_UINT32 p_nb_rows, OPJ_UINT32 p_width, const OPJ_INT32 * p_data, void * p_user_data)
+{
+	strip_check_t * l_check = (strip_check_t *) p_user_data;
+	opj_image_comp_t * l_comp = &(l_check->image->comps[p_compno]);
+	OPJ_UINT32 x, y;
+
+	/* the strips of a component follow each other, with the width of the component */
+	if (p_width != l_comp->w || p_row != l_check->next_row[p_compno] || p_row + p_nb_rows > l_comp->h) {
+		fprintf(stderr, "ERROR -> test_strip_decoder: unexpected strip of component %d (rows %d to %d, width %d)\n", p_compno, p_row, p_row + p_nb_rows - 1, p_width);
+		return OPJ_FALSE;
+	}
+	l_check->next_row[p_compno] += p_nb_rows;
+
+	for (y=0;y<p_nb_rows;++y) {
+		for (x=0;x<p_width;++x) {
+			if (p_data[y * p_width + x] != l_comp->data[(p_row + y) * l_comp->w + x]) {
+				++l_check->nb_errors;
+			}
+		}
+	}
+	return OPJ_TRUE;
+}
+
+/* encodes a single-tile image, then decodes it strip after strip and compares the strips with the whole image decoded */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_image_t * l_image;
+	opj_image_t * l_decoded;
+	opj_image_t * l_header = 00;
+	opj_stream_t * l_stream;
+	strip_check_t l_check;
+	OPJ_UINT32 compno;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 subsampling;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 strip_height;
+	OPJ_UINT32 reduce;
+	char output_file[64];
+
+	/* should be test_strip_decoder 3 1000 700 2 1 40 0 tsd1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		subsampling = (OPJ_UINT32)atoi( argv[4] );
+		irreversible = (OPJ_UINT32)atoi( argv[5] );
+		strip_height = (OPJ_UINT32)atoi( argv[6] );
+		reduce = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		subsampling = 1;
+		irreversible = 0;
+		strip_height = 40;
+		reduce = 0;
+		strcpy(output_file, "test_strip.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || strip_height == 0 || subsampling == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.numresolution = 5;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3 && subsampling == 1) ? 1 : 0;
+
+	/* the first component is full size, the others are subsampled */
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, subsampling);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* decode the whole image */
+	l_decoded = decode_image(output_file, reduce, 0);
+	if (! l_decoded) {
+		fprintf(stderr, "ERROR -> test_strip_decoder: failed to decode %s!\n", output_file);
+		return 1;
+	}
+
+	/* decode it again strip after strip */
+	l_codec = create_decoder(output_file, reduce, &l_stream, &l_header);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_strip_decoder: failed to read the header of %s!\n", output_file);
+		opj_image_destroy(l_decoded);
+		return 1;
+	}
+
+	memset(&l_check, 0, sizeof(strip_check_t));
+	l_check.image = l_decoded;
+
+	if (! opj_decode_strips(l_codec, l_stream, l_header, strip_height, check_strip, &l_check) ||
+		! opj_end_decompress(l_codec, l_stream)) {
+		fprintf(stderr, "ERROR -> test_strip_decoder: failed to decode %s by strips!\n", output_file);
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_header);
+		opj_image_destroy(l_decoded);
+		return 1;
+	}
+
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_header);
+
+	for (compno=0;compno<num_comps;++compno) {
+		if (l_check.next_row[compno] != l_decoded->comps[compno].h) {
+			fprintf(stderr, "ERROR -> test_strip_decoder: %d rows of component %d decoded instead of %d\n", l_check.next_row[compno], compno, l_decoded->comps[compno].h);
+			++l_check.nb_errors;
+		}
+	}
+	opj_image_destroy(l_decoded);
+
+	if (l_check.nb_errors) {
+		fprintf(stderr, "ERROR -> test_strip_decoder: %d samples differ from the ones of the whole image\n", l_check.nb_errors);
+		return 1;
+	}
+
+	return 0;
+}
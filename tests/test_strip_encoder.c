@@ -0,0 +1,215 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* encodes the image strip after strip, then decodes it and checks every sample */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_image_t * l_image;
+	opj_image_t * l_decoded = 00;
+	opj_image_cmptparm_t l_params [NUM_COMPS_MAX];
+	opj_stream_t * l_stream;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 y, x, compno;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 strip_height;
+	OPJ_UINT32 subsampling;
+	char output_file[64];
+
+	/* should be test_strip_encoder 3 1000 700 256 256 40 2 tse1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		tile_width = (OPJ_UINT32)atoi( argv[4] );
+		tile_height = (OPJ_UINT32)atoi( argv[5] );
+		strip_height = (OPJ_UINT32)atoi( argv[6] );
+		subsampling = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		tile_width = 256;
+		tile_height = 256;
+		strip_height = 40;
+		subsampling = 2;
+		strcpy(output_file, "test_strip.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || strip_height == 0 || subsampling == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	l_param.numresolution = 5;
+	l_param.irreversible = 0;
+
+	/* the first component is full size, the others are subsampled */
+	set_component_params(l_params, num_comps, 0, 0, image_width, image_height, subsampling);
+
+	l_codec = create_compressor(output_file);
+	if (!l_codec) {
+		return 1;
+	}
+
+	/* no sample is given with the image: they are sent strip after strip */
+	l_image = opj_image_tile_create(num_comps,l_params,OPJ_CLRSPC_UNKNOWN);
+	if (! l_image) {
+		opj_destroy_codec(l_codec);
+		return 1;
+	}
+	l_image->x0 = 0;
+	l_image->y0 = 0;
+	l_image->x1 = image_width;
+	l_image->y1 = image_height;
+
+	if (! opj_setup_encoder(l_codec,&l_param,l_image)) {
+		fprintf(stderr, "ERROR -> test_strip_encoder: failed to setup the codec!\n");
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	l_stream = opj_stream_create_default_file_stream(output_file, OPJ_FALSE);
+	if (! l_stream) {
+		fprintf(stderr, "ERROR -> test_strip_encoder: failed to create the stream from the output file %s !\n",output_file );
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	if (! opj_start_compress(l_codec,l_image,l_stream)) {
+		fprintf(stderr, "ERROR -> test_strip_encoder: failed to start compress!\n");
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	l_data = (OPJ_BYTE*) malloc(image_width * strip_height * num_comps);
+	if (! l_data) {
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	for (y=0;y<image_height;y+=strip_height) {
+		OPJ_UINT32 l_nb_rows = (image_height - y < strip_height) ? image_height - y : strip_height;
+		OPJ_BYTE * l_ptr = l_data;
+
+		for (compno=0;compno<num_comps;++compno) {
+			OPJ_UINT32 l_dx = l_params[compno].dx;
+			OPJ_UINT32 l_dy = l_params[compno].dy;
+			OPJ_UINT32 l_row;
+
+			for (l_row=ceildiv(y,l_dy);l_row<ceildiv(y+l_nb_rows,l_dy);++l_row) {
+				for (x=0;x<ceildiv(image_width,l_dx);++x) {
+					*(l_ptr++) = (OPJ_BYTE)sample_value(compno,x,l_row);
+				}
+			}
+		}
+
+		if (! opj_write_strip(l_codec,l_data,(OPJ_UINT32)(l_ptr - l_data),l_nb_rows,l_stream)) {
+			fprintf(stderr, "ERROR -> test_strip_encoder: failed to write the strip at row %d!\n",y);
+			free(l_data);
+			opj_stream_destroy(l_stream);
+			opj_destroy_codec(l_codec);
+			opj_image_destroy(l_image);
+			return 1;
+		}
+	}
+	free(l_data);
+
+	if (! opj_end_compress(l_codec,l_stream)) {
+		fprintf(stderr, "ERROR -> test_strip_encoder: failed to end compress!\n");
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+
+	/* decode the whole codestream back and compare it with the samples sent */
+	l_decoded = decode_image(output_file, 0, 0);
+	if (! l_decoded) {
+		fprintf(stderr, "ERROR -> test_strip_encoder: failed to decode %s!\n", output_file);
+		return 1;
+	}
+
+	for (compno=0;compno<num_comps;++compno) {
+		opj_image_comp_t * l_comp = &(l_decoded->comps[compno]);
+
+		for (y=0;y<l_comp->h;++y) {
+			for (x=0;x<l_comp->w;++x) {
+				if (l_comp->data[y * l_comp->w + x] != sample_value(compno,x,y)) {
+					++l_nb_errors;
+				}
+			}
+		}
+	}
+
+	opj_image_destroy(l_decoded);
+
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_strip_encoder: %d samples differ from the ones sent\n", l_nb_errors);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_AREAS 6
+
+/* encodes a tiled image, then decodes several areas with the same decompressor and a tile cache, and compares them with the areas decoded by new decompressors */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_codec_t * l_codec;
+	opj_image_t * l_image;
+	opj_image_t * l_ref;
+	opj_stream_t * l_stream;
+	OPJ_INT32 l_areas [NUM_AREAS][4];
+	OPJ_UINT32 l_nb_errors = 0;
+	OPJ_UINT32 i;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 reduce;
+	OPJ_UINT32 cache_size;
+	char output_file[64];
+
+	/* should be test_tile_cache 3 1000 700 1 256 256 0 4000000 ttc1.j2k */
+	if( argc == 10 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		reduce = (OPJ_UINT32)atoi( argv[7] );
+		cache_size = (OPJ_UINT32)atoi( argv[8] );
+		strcpy(output_file, argv[9] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		reduce = 0;
+		cache_size = 16000000;
+		strcpy(output_file, "test_tile_cache.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = irreversible ? 20 : 0;
+	l_param.numresolution = 5;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* overlapping areas, then the same ones again, then the whole image */
+	for (i=0;i<NUM_AREAS-1;++i) {
+		OPJ_UINT32 l_ref_area = (i % 3);
+
+		l_areas[i][0] = (OPJ_INT32)(image_width * l_ref_area / 5);
+		l_areas[i][1] = (OPJ_INT32)(image_height * l_ref_area / 6);
+		l_areas[i][2] = (OPJ_INT32)(image_width * (l_ref_area + 2) / 5);
+		l_areas[i][3] = (OPJ_INT32)(image_height * (l_ref_area + 3) / 6);
+	}
+	memset(l_areas[NUM_AREAS-1], 0, sizeof(l_areas[NUM_AREAS-1]));
+
+	l_codec = create_decoder(output_file, reduce, &l_stream, &l_image);
+	if (! l_codec) {
+		fprintf(stderr, "ERROR -> test_tile_cache: failed to read the header of %s!\n", output_file);
+		return 1;
+	}
+	if (! opj_set_tile_cache(l_codec, cache_size)) {
+		fprintf(stderr, "ERROR -> test_tile_cache: failed to set the tile cache\n");
+		opj_stream_destroy(l_stream);
+		opj_destroy_codec(l_codec);
+		opj_image_destroy(l_image);
+		return 1;
+	}
+
+	for (i=0;i<NUM_AREAS;++i) {
+		if (! opj_set_decode_area(l_codec, l_image, l_areas[i][0], l_areas[i][1], l_areas[i][2], l_areas[i][3]) ||
+			! opj_decode(l_codec, l_stream, l_image)) {
+			fprintf(stderr, "ERROR -> test_tile_cache: failed to decode the area %d of %s!\n", i, output_file);
+			++l_nb_errors;
+			break;
+		}
+
+		l_ref = decode_area(output_file, reduce, l_areas[i]);
+		if (! l_ref) {
+			fprintf(stderr, "ERROR -> test_tile_cache: failed to decode the area %d of %s without cache!\n", i, output_file);
+			++l_nb_errors;
+			break;
+		}
+		l_nb_errors += compare_images(l_image, l_ref);
+		opj_image_destroy(l_ref);
+	}
+
+	if (! l_nb_errors && ! opj_end_decompress(l_codec, l_stream)) {
+		++l_nb_errors;
+	}
+	opj_stream_destroy(l_stream);
+	opj_destroy_codec(l_codec);
+	opj_image_destroy(l_image);
+
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_tile_cache: %d samples differ from the ones decoded without cache\n", l_nb_errors);
+		return 1;
+	}
+
+	return 0;
+}
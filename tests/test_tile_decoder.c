@@ -166,8 +166,8 @@ int main (int argc, char *argv[])
         opj_codec_t * l_codec;
         opj_image_t * l_image;
         opj_stream_t * l_stream;
-        OPJ_UINT32 l_data_size;
-        OPJ_UINT32 l_max_data_size = 1000;
+        OPJ_SIZE_T l_data_size;
+        OPJ_SIZE_T l_max_data_size = 1000;
         OPJ_UINT32 l_tile_index;
         OPJ_BYTE * l_data = (OPJ_BYTE *) malloc(1000);
         OPJ_BOOL l_go_on = OPJ_TRUE;
@@ -0,0 +1,246 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* checks the lengths given by the TLM and PLT markers of the codestream against the tile-parts it contains, returns the number of errors */
+static OPJ_UINT32 check_markers(const OPJ_BYTE * p_data, OPJ_UINT32 p_size)
+{
+	OPJ_UINT32 * l_tlm_lengths;
+	OPJ_UINT32 l_nb_tlm = 0, l_nb_tile_parts = 0, l_nb_errors = 0;
+	OPJ_UINT32 l_pos, l_marker, l_length;
+
+	/* the codestream of a jp2 file starts after its header boxes */
+	for (l_pos=0;l_pos+4<=p_size;++l_pos) {
+		if (read_value(p_data + l_pos, 4) == 0xff4fff51) {
+			break;
+		}
+	}
+	if (l_pos + 4 > p_size) {
+		fprintf(stderr, "ERROR -> test_tile_lengths: no codestream found\n");
+		return 1;
+	}
+	l_pos += 2;
+
+	/* each tile-part takes at least the 14 bytes of its SOT and SOD markers */
+	l_tlm_lengths = (OPJ_UINT32 *) malloc((p_size / 14 + 1) * sizeof(OPJ_UINT32));
+	if (! l_tlm_lengths) {
+		return 1;
+	}
+
+	/* main header */
+	while (l_pos + 4 <= p_size && (l_marker = read_value(p_data + l_pos, 2)) != 0xff90) {
+		l_length = read_value(p_data + l_pos + 2, 2);
+		if (l_length < 2 || l_pos + 2 + l_length > p_size) {
+			++l_nb_errors;
+			break;
+		}
+		if (l_marker == 0xff55) {
+			OPJ_UINT32 l_stlm = p_data[l_pos + 5];
+			OPJ_UINT32 l_st = (l_stlm >> 4) & 0x3;
+			OPJ_UINT32 l_sp = (l_stlm >> 6) & 0x1;
+			OPJ_UINT32 l_entry_size = l_st + (l_sp ? 4 : 2);
+			OPJ_UINT32 l_entry;
+
+			for (l_entry=l_pos+6;l_entry+l_entry_size<=l_pos+2+l_length;l_entry+=l_entry_size) {
+				l_tlm_lengths[l_nb_tlm++] = read_value(p_data + l_entry + l_st, l_entry_size - l_st);
+			}
+		}
+		l_pos += 2 + l_length;
+	}
+
+	/* tile-parts */
+	while (l_nb_errors == 0 && l_pos + 12 <= p_size && read_value(p_data + l_pos, 2) == 0xff90) {
+		OPJ_UINT32 l_psot = read_value(p_data + l_pos + 6, 4);
+		OPJ_UINT32 l_header = l_pos + 2 + read_value(p_data + l_pos + 2, 2);
+		OPJ_UINT32 l_plt_sum = 0, l_packet = 0;
+		OPJ_BOOL l_has_plt = OPJ_FALSE;
+
+		if (l_psot < 14 || l_pos + l_psot > p_size) {
+			fprintf(stderr, "ERROR -> test_tile_lengths: wrong length of tile-part %d\n", l_nb_tile_parts);
+			++l_nb_errors;
+			break;
+		}
+		if (l_nb_tile_parts >= l_nb_tlm || l_tlm_lengths[l_nb_tile_parts] != l_psot) {
+			fprintf(stderr, "ERROR -> test_tile_lengths: the TLM markers do not give the length of tile-part %d\n", l_nb_tile_parts);
+			++l_nb_errors;
+		}
+		while (l_header + 4 <= l_pos + l_psot && (l_marker = read_value(p_data + l_header, 2)) != 0xff93) {
+			l_length = read_value(p_data + l_header + 2, 2);
+			if (l_marker == 0xff58) {
+				OPJ_UINT32 i;
+
+				l_has_plt = OPJ_TRUE;
+				for (i=l_header+5;i<l_header+2+l_length;++i) {
+					l_packet = (l_packet << 7) | (p_data[i] & 0x7f);
+					if (! (p_data[i] & 0x80)) {
+						l_plt_sum += l_packet;
+						l_packet = 0;
+					}
+				}
+			}
+			l_header += 2 + l_length;
+		}
+		if (! l_has_plt || l_plt_sum != l_pos + l_psot - (l_header + 2)) {
+			fprintf(stderr, "ERROR -> test_tile_lengths: the PLT markers do not give the lengths of the packets of tile-part %d\n", l_nb_tile_parts);
+			++l_nb_errors;
+		}
+		++l_nb_tile_parts;
+		l_pos += l_psot;
+	}
+
+	if (l_nb_errors == 0 && (l_nb_tile_parts == 0 || l_nb_tile_parts != l_nb_tlm)) {
+		fprintf(stderr, "ERROR -> test_tile_lengths: %d tile-parts for %d TLM entries\n", l_nb_tile_parts, l_nb_tlm);
+		++l_nb_errors;
+	}
+	free(l_tlm_lengths);
+	return l_nb_errors;
+}
+
+/* encodes a tiled image with and without the TLM and PLT markers, checks the lengths they give then compares the decodings of both codestreams */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	opj_image_t * l_decoded;
+	opj_image_t * l_ref;
+	OPJ_BYTE * l_data;
+	OPJ_UINT32 l_size = 0;
+	OPJ_UINT32 l_nb_errors;
+	OPJ_UINT32 l_reduce;
+	OPJ_UINT32 i;
+	size_t len;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	char tp_flag;
+	char output_file[64];
+	char ref_file[80];
+
+	/* should be test_tile_lengths 3 1000 700 0 256 256 R ttl1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		tp_flag = argv[7][0];
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		tp_flag = 'R';
+		strcpy(output_file, "test_tile_lengths.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 )
+	{
+		return 1;
+	}
+
+	/* a single layer with all the passes, so that both codestreams decode into the same samples */
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 0;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	if (tp_flag == 'R' || tp_flag == 'L' || tp_flag == 'C') {
+		l_param.tp_on = 1;
+		l_param.tp_flag = tp_flag;
+	}
+
+	len = strlen( output_file ) - 4;
+	sprintf(ref_file, "%.*s_ref%s", (int)len, output_file, output_file + len);
+
+	for (i=0;i<2;++i) {
+		l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+		if (! l_image) {
+			return 1;
+		}
+		l_param.tlm_on = (i == 0);
+		l_param.plt_on = (i == 0);
+		if (! encode_image(i == 0 ? output_file : ref_file, &l_param, l_image)) {
+			opj_image_destroy(l_image);
+			return 1;
+		}
+		opj_image_destroy(l_image);
+	}
+
+	l_data = read_file(output_file, &l_size);
+	if (! l_data) {
+		fprintf(stderr, "ERROR -> test_tile_lengths: failed to read %s!\n", output_file);
+		return 1;
+	}
+	l_nb_errors = check_markers(l_data, l_size);
+	free(l_data);
+	if (l_nb_errors) {
+		return 1;
+	}
+
+	/* at a reduced resolution, the packets not decoded are jumped over with the lengths of the PLT markers */
+	for (l_reduce = 0; l_reduce < 3 && ! l_nb_errors; ++l_reduce) {
+		l_decoded = decode_image(output_file, l_reduce, 0);
+		l_ref = decode_image(ref_file, l_reduce, 0);
+		if (! l_decoded || ! l_ref) {
+			fprintf(stderr, "ERROR -> test_tile_lengths: failed to decode %s or %s!\n", output_file, ref_file);
+			opj_image_destroy(l_decoded);
+			opj_image_destroy(l_ref);
+			return 1;
+		}
+		l_nb_errors = compare_images(l_decoded, l_ref);
+		if (l_nb_errors) {
+			fprintf(stderr, "ERROR -> test_tile_lengths: %d samples of %s differ from the ones of %s, reduced %d times\n", l_nb_errors, output_file, ref_file, l_reduce);
+		}
+		opj_image_destroy(l_ref);
+		opj_image_destroy(l_decoded);
+	}
+	return l_nb_errors ? 1 : 0;
+}
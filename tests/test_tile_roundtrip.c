@@ -0,0 +1,144 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+/* number of samples of the decoded image which differ from the encoded ones */
+static OPJ_UINT32 check_samples(const opj_image_t * p_image)
+{
+	OPJ_UINT32 compno, y, x;
+	OPJ_UINT32 l_nb_errors = 0;
+
+	for (compno=0;compno<p_image->numcomps;++compno) {
+		const opj_image_comp_t * l_comp = &(p_image->comps[compno]);
+
+		for (y=0;y<l_comp->h;++y) {
+			for (x=0;x<l_comp->w;++x) {
+				if (l_comp->data[y * l_comp->w + x] != sample_value(compno,x,y)) {
+					++l_nb_errors;
+				}
+			}
+		}
+	}
+	return l_nb_errors;
+}
+
+/* encodes without loss a tiled image which does not start at the origin of the tile grid, so that the code-blocks of the first tiles are smaller than the ones of the next tiles, then decodes it and checks every sample */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_image_t * l_image;
+	OPJ_UINT32 l_nb_errors;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_x0;
+	OPJ_UINT32 image_y0;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 cblk_size;
+	char output_file[64];
+
+	/* should be test_tile_roundtrip 3 37 21 1000 700 256 256 16 ttt1.j2k */
+	if( argc == 10 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_x0 = (OPJ_UINT32)atoi( argv[2] );
+		image_y0 = (OPJ_UINT32)atoi( argv[3] );
+		image_width = (OPJ_UINT32)atoi( argv[4] );
+		image_height = (OPJ_UINT32)atoi( argv[5] );
+		tile_width = (OPJ_UINT32)atoi( argv[6] );
+		tile_height = (OPJ_UINT32)atoi( argv[7] );
+		cblk_size = (OPJ_UINT32)atoi( argv[8] );
+		strcpy(output_file, argv[9] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_x0 = 37;
+		image_y0 = 21;
+		image_width = 1000;
+		image_height = 700;
+		tile_width = 256;
+		tile_height = 256;
+		cblk_size = 64;
+		strcpy(output_file, "test_tile_roundtrip.j2k" );
+	}
+	if( num_comps == 0 || num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 ||
+		image_x0 >= tile_width || image_y0 >= tile_height || cblk_size < 4 || cblk_size > 64 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = 1;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 0;
+	l_param.numresolution = 3;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tx0 = 0;
+	l_param.cp_ty0 = 0;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	l_param.cblockw_init = (int)cblk_size;
+	l_param.cblockh_init = (int)cblk_size;
+
+	l_image = create_image(num_comps, image_x0, image_y0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	l_image = decode_image(output_file, 0, 0);
+	if (! l_image) {
+		fprintf(stderr, "ERROR -> test_tile_roundtrip: failed to decode %s!\n", output_file);
+		return 1;
+	}
+	l_nb_errors = check_samples(l_image);
+	opj_image_destroy(l_image);
+
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_tile_roundtrip: %d samples differ from the ones encoded\n", l_nb_errors);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "opj_config.h"
+#include "openjpeg.h"
+#include "test_common.h"
+
+#define NUM_LAYERS 3
+#define KEPT_LAYERS 2
+
+/* transcodes input_file into output_file, then compares its decoding with the one of input_file at the same resolution and quality */
+static OPJ_UINT32 check_transcode(const char * input_file, const char * output_file, const opj_transcode_parameters_t * p_parameters)
+{
+	opj_codec_t * l_codec;
+	opj_stream_t * l_input;
+	opj_stream_t * l_output;
+	opj_image_t * l_image = 00;
+	opj_image_t * l_ref;
+	OPJ_BOOL l_success;
+	OPJ_UINT32 l_nb_errors;
+
+	l_codec = create_decompressor(input_file, 0, 0);
+	if (! l_codec) {
+		return 1;
+	}
+	l_input = opj_stream_create_default_file_stream(input_file, OPJ_TRUE);
+	l_output = opj_stream_create_default_file_stream(output_file, OPJ_FALSE);
+	l_success = l_input && l_output &&
+		opj_read_header(l_input, l_codec, &l_image) &&
+		opj_transcode(l_codec, l_input, l_output, p_parameters);
+	opj_stream_destroy(l_output);
+	opj_stream_destroy(l_input);
+	opj_image_destroy(l_image);
+	opj_destroy_codec(l_codec);
+	if (! l_success) {
+		fprintf(stderr, "ERROR -> test_transcode: failed to transcode %s into %s!\n", input_file, output_file);
+		return 1;
+	}
+
+	l_image = decode_image(output_file, 0, 0);
+	l_ref = decode_image(input_file, p_parameters->reduce, p_parameters->max_layers);
+	if (! l_image || ! l_ref) {
+		fprintf(stderr, "ERROR -> test_transcode: failed to decode %s or %s!\n", input_file, output_file);
+		opj_image_destroy(l_image);
+		opj_image_destroy(l_ref);
+		return 1;
+	}
+	l_nb_errors = compare_images(l_image, l_ref);
+	if (l_nb_errors) {
+		fprintf(stderr, "ERROR -> test_transcode: %d samples of %s differ from the ones of %s\n", l_nb_errors, output_file, input_file);
+	}
+	opj_image_destroy(l_ref);
+	opj_image_destroy(l_image);
+	return l_nb_errors;
+}
+
+/* encodes a tiled image with several quality layers, then transcodes it with other progression orders, fewer layers and fewer resolutions */
+int main (int argc, char *argv[])
+{
+	opj_cparameters_t l_param;
+	opj_transcode_parameters_t l_transcode;
+	opj_image_t * l_image;
+	size_t len;
+
+	OPJ_UINT32 num_comps;
+	OPJ_UINT32 image_width;
+	OPJ_UINT32 image_height;
+	OPJ_UINT32 irreversible;
+	OPJ_UINT32 tile_width;
+	OPJ_UINT32 tile_height;
+	OPJ_UINT32 reduce;
+	char output_file[64];
+	char transcoded_file[80];
+
+	/* should be test_transcode 3 1000 700 0 256 256 2 ttr1.j2k */
+	if( argc == 9 )
+	{
+		num_comps = (OPJ_UINT32)atoi( argv[1] );
+		image_width = (OPJ_UINT32)atoi( argv[2] );
+		image_height = (OPJ_UINT32)atoi( argv[3] );
+		irreversible = (OPJ_UINT32)atoi( argv[4] );
+		tile_width = (OPJ_UINT32)atoi( argv[5] );
+		tile_height = (OPJ_UINT32)atoi( argv[6] );
+		reduce = (OPJ_UINT32)atoi( argv[7] );
+		strcpy(output_file, argv[8] );
+	}
+	else
+	{
+		num_comps = 3;
+		image_width = 1000;
+		image_height = 700;
+		irreversible = 0;
+		tile_width = 256;
+		tile_height = 256;
+		reduce = 2;
+		strcpy(output_file, "test_transcode.j2k" );
+	}
+	if( num_comps > NUM_COMPS_MAX || tile_width == 0 || tile_height == 0 || reduce > 4 )
+	{
+		return 1;
+	}
+
+	opj_set_default_encoder_parameters(&l_param);
+	l_param.tcp_numlayers = NUM_LAYERS;
+	l_param.cp_disto_alloc = 1;
+	l_param.tcp_rates[0] = 40;
+	l_param.tcp_rates[1] = 10;
+	l_param.tcp_rates[2] = irreversible ? 4 : 0;
+	l_param.irreversible = (int)irreversible;
+	l_param.tcp_mct = (num_comps >= 3) ? 1 : 0;
+	l_param.tile_size_on = OPJ_TRUE;
+	l_param.cp_tdx = (int)tile_width;
+	l_param.cp_tdy = (int)tile_height;
+	l_param.prog_order = OPJ_LRCP;
+	l_param.csty |= 0x02 | 0x04;
+
+	l_image = create_image(num_comps, 0, 0, image_width, image_height, 1);
+	if (! l_image) {
+		return 1;
+	}
+	if (! encode_image(output_file, &l_param, l_image)) {
+		opj_image_destroy(l_image);
+		return 1;
+	}
+	opj_image_destroy(l_image);
+
+	/* the transcoded codestreams are always raw codestreams */
+	len = strlen( output_file ) - 4;
+
+	/* same content, one tile-part per resolution */
+	opj_set_default_transcode_parameters(&l_transcode);
+	l_transcode.prog_order = OPJ_RPCL;
+	l_transcode.tp_flag = 'R';
+	sprintf(transcoded_file, "%.*s_rpcl.j2k", (int)len, output_file);
+	if (check_transcode(output_file, transcoded_file, &l_transcode)) {
+		return 1;
+	}
+
+	/* fewer layers and fewer resolutions */
+	opj_set_default_transcode_parameters(&l_transcode);
+	l_transcode.prog_order = OPJ_PCRL;
+	l_transcode.max_layers = KEPT_LAYERS;
+	l_transcode.reduce = reduce;
+	sprintf(transcoded_file, "%.*s_reduced.j2k", (int)len, output_file);
+	if (check_transcode(output_file, transcoded_file, &l_transcode)) {
+		return 1;
+	}
+
+	return 0;
+}
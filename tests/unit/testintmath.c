@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2012, Mathieu Malaterre
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "opj_includes.h"
+
+#define SIZE_MAX_VALUE ((OPJ_SIZE_T)-1)
+
+static int nb_errors = 0;
+
+static void check_size(const char * p_name, OPJ_SIZE_T p_value, OPJ_SIZE_T p_expected)
+{
+  if (p_value != p_expected) {
+    fprintf(stderr, "ERROR -> testintmath: %s returned %lu instead of %lu\n", p_name, (unsigned long)p_value, (unsigned long)p_expected);
+    ++nb_errors;
+  }
+}
+
+int main(void)
+{
+  /* sums and products which fit */
+  check_size("opj_size_adds", opj_size_adds(0, 0), 0);
+  check_size("opj_size_adds", opj_size_adds(SIZE_MAX_VALUE / 2, SIZE_MAX_VALUE / 2), SIZE_MAX_VALUE - 1);
+  check_size("opj_size_adds", opj_size_adds(SIZE_MAX_VALUE - 1, 1), SIZE_MAX_VALUE);
+  check_size("opj_size_muls", opj_size_muls(0, SIZE_MAX_VALUE), 0);
+  check_size("opj_size_muls", opj_size_muls(SIZE_MAX_VALUE, 0), 0);
+  check_size("opj_size_muls", opj_size_muls(SIZE_MAX_VALUE, 1), SIZE_MAX_VALUE);
+  check_size("opj_size_muls", opj_size_muls(65536, 65535), (OPJ_SIZE_T)65536 * 65535);
+  check_size("opj_size_muls", opj_size_muls(SIZE_MAX_VALUE / 4, 4), SIZE_MAX_VALUE / 4 * 4);
+
+  /* sums and products which do not fit saturate */
+  check_size("opj_size_adds", opj_size_adds(SIZE_MAX_VALUE, 1), SIZE_MAX_VALUE);
+  check_size("opj_size_adds", opj_size_adds(1, SIZE_MAX_VALUE), SIZE_MAX_VALUE);
+  check_size("opj_size_adds", opj_size_adds(SIZE_MAX_VALUE / 2 + 1, SIZE_MAX_VALUE / 2 + 1), SIZE_MAX_VALUE);
+  check_size("opj_size_muls", opj_size_muls(SIZE_MAX_VALUE / 4 + 1, 4), SIZE_MAX_VALUE);
+  check_size("opj_size_muls", opj_size_muls(4, SIZE_MAX_VALUE / 4 + 1), SIZE_MAX_VALUE);
+  check_size("opj_size_muls", opj_size_muls(SIZE_MAX_VALUE, SIZE_MAX_VALUE), SIZE_MAX_VALUE);
+
+  /* a saturated size stays saturated */
+  check_size("opj_size_adds", opj_size_adds(opj_size_muls(SIZE_MAX_VALUE, 2), 1), SIZE_MAX_VALUE);
+  check_size("opj_size_muls", opj_size_muls(opj_size_adds(SIZE_MAX_VALUE, 1), 2), SIZE_MAX_VALUE);
+
+  check_size("opj_size_min", opj_size_min(SIZE_MAX_VALUE, 3), 3);
+  check_size("opj_size_max", opj_size_max(3, SIZE_MAX_VALUE), SIZE_MAX_VALUE);
+
+  return nb_errors ? 1 : 0;
+}